@@ -36,17 +36,25 @@ OBJECTDIR=${CND_BUILDDIR}/${CND_CONF}/${CND_PLATFORM}
 # Object Files
 OBJECTFILES= \
 	${OBJECTDIR}/src/base64.o \
+	${OBJECTDIR}/src/cache.o \
 	${OBJECTDIR}/src/client.o \
+	${OBJECTDIR}/src/codec.o \
+	${OBJECTDIR}/src/delta.o \
 	${OBJECTDIR}/src/file.o \
+	${OBJECTDIR}/src/flight.o \
 	${OBJECTDIR}/src/gz.o \
 	${OBJECTDIR}/src/list.o \
 	${OBJECTDIR}/src/logger.o \
 	${OBJECTDIR}/src/message.o \
 	${OBJECTDIR}/src/mutex.o \
+	${OBJECTDIR}/src/pool.o \
 	${OBJECTDIR}/src/process.o \
 	${OBJECTDIR}/src/py.o \
 	${OBJECTDIR}/src/server.o \
+	${OBJECTDIR}/src/session.o \
+	${OBJECTDIR}/src/sha256.o \
 	${OBJECTDIR}/src/socket.o \
+	${OBJECTDIR}/src/store.o \
 	${OBJECTDIR}/src/string.o \
 	${OBJECTDIR}/src/thread.o \
 	${OBJECTDIR}/src/time.o
@@ -74,23 +82,43 @@ LDLIBSOPTIONS=
 
 ${CND_DISTDIR}/${CND_CONF}/${CND_PLATFORM}/quickftpy.${CND_DLIB_EXT}: ${OBJECTFILES}
 	${MKDIR} -p ${CND_DISTDIR}/${CND_CONF}/${CND_PLATFORM}
-	${LINK.c} -o ${CND_DISTDIR}/${CND_CONF}/${CND_PLATFORM}/quickftpy.${CND_DLIB_EXT} ${OBJECTFILES} ${LDLIBSOPTIONS} -lpthread -lz -lm -lpython2.7 -shared -fPIC
+	${LINK.c} -o ${CND_DISTDIR}/${CND_CONF}/${CND_PLATFORM}/quickftpy.${CND_DLIB_EXT} ${OBJECTFILES} ${LDLIBSOPTIONS} -lpthread -lz -lzstd -llz4 -lm -lpython2.7 -shared -fPIC
 
 ${OBJECTDIR}/src/base64.o: src/base64.c 
 	${MKDIR} -p ${OBJECTDIR}/src
 	${RM} "$@.d"
 	$(COMPILE.c) -g -fPIC  -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/base64.o src/base64.c
 
+${OBJECTDIR}/src/cache.o: src/cache.c 
+	${MKDIR} -p ${OBJECTDIR}/src
+	${RM} "$@.d"
+	$(COMPILE.c) -g -fPIC  -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/cache.o src/cache.c
+
 ${OBJECTDIR}/src/client.o: src/client.c 
 	${MKDIR} -p ${OBJECTDIR}/src
 	${RM} "$@.d"
 	$(COMPILE.c) -g -fPIC  -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/client.o src/client.c
 
+${OBJECTDIR}/src/codec.o: src/codec.c 
+	${MKDIR} -p ${OBJECTDIR}/src
+	${RM} "$@.d"
+	$(COMPILE.c) -g -fPIC  -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/codec.o src/codec.c
+
+${OBJECTDIR}/src/delta.o: src/delta.c 
+	${MKDIR} -p ${OBJECTDIR}/src
+	${RM} "$@.d"
+	$(COMPILE.c) -g -fPIC  -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/delta.o src/delta.c
+
 ${OBJECTDIR}/src/file.o: src/file.c 
 	${MKDIR} -p ${OBJECTDIR}/src
 	${RM} "$@.d"
 	$(COMPILE.c) -g -fPIC  -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/file.o src/file.c
 
+${OBJECTDIR}/src/flight.o: src/flight.c 
+	${MKDIR} -p ${OBJECTDIR}/src
+	${RM} "$@.d"
+	$(COMPILE.c) -g -fPIC  -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/flight.o src/flight.c
+
 ${OBJECTDIR}/src/gz.o: src/gz.c 
 	${MKDIR} -p ${OBJECTDIR}/src
 	${RM} "$@.d"
@@ -116,6 +144,11 @@ ${OBJECTDIR}/src/mutex.o: src/mutex.c
 	${RM} "$@.d"
 	$(COMPILE.c) -g -fPIC  -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/mutex.o src/mutex.c
 
+${OBJECTDIR}/src/pool.o: src/pool.c 
+	${MKDIR} -p ${OBJECTDIR}/src
+	${RM} "$@.d"
+	$(COMPILE.c) -g -fPIC  -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/pool.o src/pool.c
+
 ${OBJECTDIR}/src/process.o: src/process.c 
 	${MKDIR} -p ${OBJECTDIR}/src
 	${RM} "$@.d"
@@ -131,11 +164,26 @@ ${OBJECTDIR}/src/server.o: src/server.c
 	${RM} "$@.d"
 	$(COMPILE.c) -g -fPIC  -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/server.o src/server.c
 
+${OBJECTDIR}/src/session.o: src/session.c 
+	${MKDIR} -p ${OBJECTDIR}/src
+	${RM} "$@.d"
+	$(COMPILE.c) -g -fPIC  -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/session.o src/session.c
+
+${OBJECTDIR}/src/sha256.o: src/sha256.c 
+	${MKDIR} -p ${OBJECTDIR}/src
+	${RM} "$@.d"
+	$(COMPILE.c) -g -fPIC  -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/sha256.o src/sha256.c
+
 ${OBJECTDIR}/src/socket.o: src/socket.c 
 	${MKDIR} -p ${OBJECTDIR}/src
 	${RM} "$@.d"
 	$(COMPILE.c) -g -fPIC  -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/socket.o src/socket.c
 
+${OBJECTDIR}/src/store.o: src/store.c 
+	${MKDIR} -p ${OBJECTDIR}/src
+	${RM} "$@.d"
+	$(COMPILE.c) -g -fPIC  -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/store.o src/store.c
+
 ${OBJECTDIR}/src/string.o: src/string.c 
 	${MKDIR} -p ${OBJECTDIR}/src
 	${RM} "$@.d"
@@ -16,15 +16,295 @@
 #include <stdlib.h>
 #include <string.h>
 
+// Vector kernels are built for x86 with GCC compatible compilers,
+// which one is used is decided at run time
+#if !defined(BASE64_NO_SIMD) && defined(__GNUC__) && ( defined(__x86_64__) || defined(__i386__) )
+#define BASE64_SIMD
+#include <immintrin.h>
+#endif
+
 #define base64_blocks(l) (((l) + 2) / 3 * 4 + 1)
 #define base64_octets(l)  ((l) / 4  * 3 + 1)
 
+// Size of the buffers used to encode or decode files
+#define BASE64_FILE_BUFFER_SIZE 12288
+
+// Characters decoded one at a time before trying a vector kernel again
+#define BASE64_SCALAR_RUN       16
+
 // Translation table as described in RFC1113
 static const char cb64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
 
 // Translation table for decoding
 static const char cd64[] = "|$$$}rstuvwxyz{$$$$$$$>?@ABCDEFGHIJKLMNOPQRSTUVW$$$$$$XYZ[\\]^_`abcdefghijklmnopq";
 
+/**
+ * Vector kernel for encoding, encodes whole blocks from the start of the input
+ *
+ * @param in                     input bytes
+ * @param in_len                 input length
+ * @param out                    output characters
+ *
+ * @return                       number of input bytes encoded, a multiple of 3
+ */
+typedef int (*BASE64_ENCODE_KERNEL_T)(const unsigned char *in, int in_len, char *out);
+
+/**
+ * Vector kernel for decoding, decodes from the start of the input
+ * up to the first block that holds any non-alphabet character
+ *
+ * @param in                     input characters
+ * @param in_len                 input length
+ * @param out                    output bytes
+ *
+ * @return                       number of input characters decoded, a multiple of 4
+ */
+typedef int (*BASE64_DECODE_KERNEL_T)(const char *in, int in_len, unsigned char *out);
+
+static int base64_encode_kernel_init(const unsigned char *in, int in_len, char *out);
+static int base64_decode_kernel_init(const char *in, int in_len, unsigned char *out);
+
+// Used when the CPU supports none of the instruction sets
+static int base64_encode_kernel_none(const unsigned char *in, int in_len, char *out) {
+  return 0;
+}
+
+static int base64_decode_kernel_none(const char *in, int in_len, unsigned char *out) {
+  return 0;
+}
+
+// Kernels for the running CPU, chosen on first use
+static BASE64_ENCODE_KERNEL_T base64_encode_kernel = base64_encode_kernel_init;
+static BASE64_DECODE_KERNEL_T base64_decode_kernel = base64_decode_kernel_init;
+
+#ifdef BASE64_SIMD
+
+/**
+ * Translates 16 6-bit values into their base64 characters
+ */
+__attribute__((target("ssse3")))
+static inline __m128i base64_encode_lookup_ssse3(__m128i indices) {
+
+  // 0..25 -> 13, 26..51 -> 0, 52..61 -> 1..10, 62 -> 11, 63 -> 12
+  __m128i result = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+  __m128i less = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+
+  result = _mm_or_si128(result, _mm_and_si128(less, _mm_set1_epi8(13)));
+
+  // Offset from each value to its character
+  result = _mm_shuffle_epi8(_mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                          '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+                                          '/' - 63, 'A', 0, 0), result);
+
+  return _mm_add_epi8(result, indices);
+}
+
+/**
+ * Splits 12 bytes, at the start of the register, into 16 6-bit values
+ */
+__attribute__((target("ssse3")))
+static inline __m128i base64_encode_split_ssse3(__m128i in) {
+
+  __m128i t0, t1, t2, t3;
+
+  in = _mm_shuffle_epi8(in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+
+  t0 = _mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00));
+  t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+  t2 = _mm_and_si128(in, _mm_set1_epi32(0x003f03f0));
+  t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+
+  return _mm_or_si128(t1, t3);
+}
+
+__attribute__((target("ssse3")))
+static int base64_encode_ssse3(const unsigned char *in, int in_len, char *out) {
+
+  int i = 0;
+
+  // Each load reads 16 bytes and encodes the first 12
+  for (; i + 16 <= in_len; i += 12, out += 16) {
+
+    __m128i block = _mm_loadu_si128((const __m128i *)&in[i]);
+    _mm_storeu_si128((__m128i *)out, base64_encode_lookup_ssse3(base64_encode_split_ssse3(block)));
+  }
+
+  return i;
+}
+
+__attribute__((target("avx2")))
+static int base64_encode_avx2(const unsigned char *in, int in_len, char *out) {
+
+  const __m256i split = _mm256_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10,
+                                         1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+  const __m256i offsets = _mm256_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                           '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+                                           '/' - 63, 'A', 0, 0,
+                                           'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                           '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+                                           '/' - 63, 'A', 0, 0);
+  __m256i block, t0, t1, t2, t3, result;
+  int i = 0;
+
+  // Each lane encodes 12 bytes, the second lane is loaded from 12 bytes ahead
+  for (; i + 28 <= in_len; i += 24, out += 32) {
+
+    block = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)&in[i])),
+                                    _mm_loadu_si128((const __m128i *)&in[i + 12]), 1);
+    block = _mm256_shuffle_epi8(block, split);
+
+    t0 = _mm256_and_si256(block, _mm256_set1_epi32(0x0fc0fc00));
+    t1 = _mm256_mulhi_epu16(t0, _mm256_set1_epi32(0x04000040));
+    t2 = _mm256_and_si256(block, _mm256_set1_epi32(0x003f03f0));
+    t3 = _mm256_mullo_epi16(t2, _mm256_set1_epi32(0x01000010));
+    block = _mm256_or_si256(t1, t3);
+
+    result = _mm256_subs_epu8(block, _mm256_set1_epi8(51));
+    result = _mm256_or_si256(result, _mm256_and_si256(_mm256_cmpgt_epi8(_mm256_set1_epi8(26), block), _mm256_set1_epi8(13)));
+    result = _mm256_add_epi8(_mm256_shuffle_epi8(offsets, result), block);
+
+    _mm256_storeu_si256((__m256i *)out, result);
+  }
+
+  // Leaves the rest to the narrower kernel
+  return i + base64_encode_ssse3(&in[i], in_len - i, out);
+}
+
+__attribute__((target("ssse3")))
+static int base64_decode_ssse3(const char *in, int in_len, unsigned char *out) {
+
+  const __m128i lut_lo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                       0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+  const __m128i lut_hi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                       0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+  const __m128i lut_roll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+  const __m128i mask_2f = _mm_set1_epi8(0x2f);
+
+  __m128i str, hi_nibbles, lo_nibbles, roll;
+  unsigned char decoded[16];
+  int i = 0;
+
+  for (; i + 16 <= in_len; i += 16, out += 12) {
+
+    str = _mm_loadu_si128((const __m128i *)&in[i]);
+
+    // Stops at padding, line breaks or any other character out of the alphabet
+    hi_nibbles = _mm_and_si128(_mm_srli_epi32(str, 4), mask_2f);
+    lo_nibbles = _mm_and_si128(str, mask_2f);
+
+    if (_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_and_si128(_mm_shuffle_epi8(lut_lo, lo_nibbles),
+                                                       _mm_shuffle_epi8(lut_hi, hi_nibbles)),
+                                         _mm_setzero_si128())) != 0) {
+      break;
+    }
+
+    // Translates the characters into 6-bit values and packs them
+    roll = _mm_shuffle_epi8(lut_roll, _mm_add_epi8(_mm_cmpeq_epi8(str, mask_2f), hi_nibbles));
+    str = _mm_add_epi8(str, roll);
+
+    str = _mm_maddubs_epi16(str, _mm_set1_epi32(0x01400140));
+    str = _mm_madd_epi16(str, _mm_set1_epi32(0x00011000));
+    str = _mm_shuffle_epi8(str, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+
+    _mm_storeu_si128((__m128i *)decoded, str);
+    memcpy(out, decoded, 12);
+  }
+
+  return i;
+}
+
+__attribute__((target("avx2")))
+static int base64_decode_avx2(const char *in, int in_len, unsigned char *out) {
+
+  const __m256i lut_lo = _mm256_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                          0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A,
+                                          0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                          0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+  const __m256i lut_hi = _mm256_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                          0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+                                          0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                          0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+  const __m256i lut_roll = _mm256_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+                                            0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+  const __m256i mask_2f = _mm256_set1_epi8(0x2f);
+
+  __m256i str, hi_nibbles, lo_nibbles, roll;
+  unsigned char decoded[32];
+  int i = 0;
+
+  for (; i + 32 <= in_len; i += 32, out += 24) {
+
+    str = _mm256_loadu_si256((const __m256i *)&in[i]);
+
+    // Stops at padding, line breaks or any other character out of the alphabet
+    hi_nibbles = _mm256_and_si256(_mm256_srli_epi32(str, 4), mask_2f);
+    lo_nibbles = _mm256_and_si256(str, mask_2f);
+
+    if (!_mm256_testz_si256(_mm256_shuffle_epi8(lut_lo, lo_nibbles), _mm256_shuffle_epi8(lut_hi, hi_nibbles))) {
+      break;
+    }
+
+    // Translates the characters into 6-bit values and packs them
+    roll = _mm256_shuffle_epi8(lut_roll, _mm256_add_epi8(_mm256_cmpeq_epi8(str, mask_2f), hi_nibbles));
+    str = _mm256_add_epi8(str, roll);
+
+    str = _mm256_maddubs_epi16(str, _mm256_set1_epi32(0x01400140));
+    str = _mm256_madd_epi16(str, _mm256_set1_epi32(0x00011000));
+    str = _mm256_shuffle_epi8(str, _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+                                                    2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+    str = _mm256_permutevar8x32_epi32(str, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, -1, -1));
+
+    _mm256_storeu_si256((__m256i *)decoded, str);
+    memcpy(out, decoded, 24);
+  }
+
+  // Leaves the rest to the narrower kernel
+  return i + base64_decode_ssse3(&in[i], in_len - i, out);
+}
+
+#endif // BASE64_SIMD
+
+/**
+ * Chooses the kernels for the instruction sets the CPU supports,
+ * falling back to the plain translation tables when there are none
+ */
+static void base64_dispatch() {
+
+  BASE64_ENCODE_KERNEL_T encode_kernel = base64_encode_kernel_none;
+  BASE64_DECODE_KERNEL_T decode_kernel = base64_decode_kernel_none;
+
+#ifdef BASE64_SIMD
+  __builtin_cpu_init();
+
+  if (__builtin_cpu_supports("avx2")) {
+
+    encode_kernel = base64_encode_avx2;
+    decode_kernel = base64_decode_avx2;
+  }
+  else if (__builtin_cpu_supports("ssse3")) {
+
+    encode_kernel = base64_encode_ssse3;
+    decode_kernel = base64_decode_ssse3;
+  }
+#endif
+
+  // Any thread racing here chooses the same ones
+  base64_encode_kernel = encode_kernel;
+  base64_decode_kernel = decode_kernel;
+}
+
+static int base64_encode_kernel_init(const unsigned char *in, int in_len, char *out) {
+
+  base64_dispatch();
+  return base64_encode_kernel(in, in_len, out);
+}
+
+static int base64_decode_kernel_init(const char *in, int in_len, unsigned char *out) {
+
+  base64_dispatch();
+  return base64_decode_kernel(in, in_len, out);
+}
+
 /**
  * Encodes three 8-bit binary characters as four 6-bit characters
  *
@@ -132,46 +412,16 @@ char* base64_buffer(int size, int operation_type) {
 unsigned char* base64_encode(unsigned char* data, int data_size) {
 
   unsigned char* encoded = NULL;
-  unsigned char in[3];
-  unsigned char out[4];
-  int d, i, len, blocksout = 0;
-
-  *in = (unsigned char)0;
-  *out = (unsigned char)0;
+  BASE64_STREAM_T stream;
+  int written;
 
   encoded = (unsigned char*)calloc(base64_blocks(data_size), sizeof(char));
   if (encoded == NULL) return NULL;
 
-  for (d = 0; d < data_size; d += 3) {
+  base64_encode_stream_init(&stream);
 
-    len = 0;
-
-    for (i = 0; i < 3; i++) {
-
-      in[i] = data[d + i];
-
-      if (d < data_size) {
-        len++;
-      }
-      else {
-        in[i] = (unsigned char)0;
-      }
-
-    }
-
-    if (len > 0) {
-
-      base64_encode_block(in, out, len);
-
-      for (i = 0; i < 4; i++) {
-        encoded[(blocksout * 4) + i] = (int)(out[i]);
-      }
-
-      blocksout++;
-
-    }
-
-  }
+  written = base64_encode_stream(&stream, data, data_size, (char*)encoded);
+  base64_encode_stream_end(&stream, (char*)&encoded[written]);
 
   return encoded;
 
@@ -185,58 +435,31 @@ unsigned char* base64_encode(unsigned char* data, int data_size) {
  *
  * @return                       decoded output string,
  *                               must call free() after usage.
+ *                               NULL if the size is 0 or memory
+ *                               could not be allocated.
  *
  */
 char* base64_decode(char * string_encoded, int string_encoded_size) {
 
   char* string;
-  unsigned char input_block[4];
-  unsigned char output_block[3];
-
-  unsigned char v;
-  int i;
-  int size;
-
-  string = base64_buffer(string_encoded_size, 'd');
-  if (string != NULL) {
-
-    char * s = string_encoded;
-    char * d = string;
+  BASE64_STREAM_T stream;
+  int len;
+  int written;
 
-    while (*s != '\0') {
-
-      for (size = 0, i = 0; (i < 4) && (*s != '\0'); i++) {
-
-        v = 0;
+  if (!string_encoded_size) {
+    return NULL;
+  }
 
-        while ((*s != '\0') && (v == 0)) {
-          v = (unsigned char)*s++;
-          v = (unsigned char)((v < 43 || v > 122) ? 0 : cd64[v - 43]);
-          if (v) {
-            v = (unsigned char)((v == '$') ? 0 : (v - 61));
-          }
-        }
+  // Decodes up to the end of the string
+  len = (int)strlen(string_encoded);
 
-        if (*s != '\0' || v != 0) {
-          size++;
-          if (v) {
-            input_block[i] = (unsigned char)(v - 1);
-          }
-        }
-        else {
-          input_block[i] = 0;
-        }
+  string = (char*)calloc(BASE64_DECODE_STREAM_SIZE(len) + 1, sizeof(char));
+  if (string != NULL) {
 
-      }
+    base64_decode_stream_init(&stream);
 
-      if (size) {
-        base64_decode_block(input_block, output_block);
-        for (i = 0; i < size - 1; i++) {
-          *d++ = output_block[i];
-        }
-      }
-
-    }
+    written = base64_decode_stream(&stream, string_encoded, len, (unsigned char*)string);
+    base64_decode_stream_end(&stream, (unsigned char*)&string[written]);
 
   }
 
@@ -254,51 +477,48 @@ char* base64_decode(char * string_encoded, int string_encoded_size) {
  */
 void base64_encode_file(FILE *in_file_handler, FILE *out_file_handler, int line_size) {
 
-  unsigned char input_block[3];
-  unsigned char output_block[4];
-  int i;
+  unsigned char input[BASE64_FILE_BUFFER_SIZE];
+  char output[BASE64_ENCODE_STREAM_SIZE(BASE64_FILE_BUFFER_SIZE) + 4];
+  BASE64_STREAM_T stream;
+  int line_chars = ((line_size / 4 > 0) ? line_size / 4 : 1) * 4;
+  int column = 0;
   int size;
-  int blocksout = 0;
-
-  while (!feof(in_file_handler)) {
-
-    size = 0;
+  int written;
+  int part;
+  int i;
 
-    for (i = 0; i < 3; i++) {
+  base64_encode_stream_init(&stream);
 
-      input_block[i] = (unsigned char)getc(in_file_handler);
+  do {
 
-      if (!feof(in_file_handler)) {
-        size++;
-      }
-      else {
-        input_block[i] = 0;
-      }
+    size = (int)fread(input, 1, BASE64_FILE_BUFFER_SIZE, in_file_handler);
 
+    written = base64_encode_stream(&stream, input, size, output);
+    if (size < BASE64_FILE_BUFFER_SIZE) {
+      written += base64_encode_stream_end(&stream, &output[written]);
     }
 
-    if (size) {
+    // Breaks the encoded characters in lines
+    for (i = 0; i < written; i += part) {
 
-      base64_encode_block(input_block, output_block, size);
+      part = (written - i < line_chars - column) ? written - i : line_chars - column;
 
-      for (i = 0; i < 4; i++) {
-        putc(output_block[i], out_file_handler);
-      }
+      fwrite(&output[i], 1, part, out_file_handler);
+      column += part;
 
-      blocksout++;
+      if (column == line_chars) {
 
-    }
-
-    if (blocksout >= (line_size / 4) || feof(in_file_handler)) {
-
-      if (blocksout) {
-        fprintf(out_file_handler, "\r\n");
+        fwrite("\r\n", 1, 2, out_file_handler);
+        column = 0;
       }
 
-      blocksout = 0;
-
     }
 
+  } while (size == BASE64_FILE_BUFFER_SIZE);
+
+  // Ends the last line
+  if (column > 0) {
+    fwrite("\r\n", 1, 2, out_file_handler);
   }
 
 }
@@ -312,50 +532,26 @@ void base64_encode_file(FILE *in_file_handler, FILE *out_file_handler, int line_
  */
 void base64_decode_file(FILE *in_file_handler, FILE *out_file_handler) {
 
-  unsigned char input_block[4];
-  unsigned char output_block[3];
-  unsigned char v;
-  int i;
+  char input[BASE64_FILE_BUFFER_SIZE];
+  unsigned char output[BASE64_DECODE_STREAM_SIZE(BASE64_FILE_BUFFER_SIZE)];
+  BASE64_STREAM_T stream;
   int size;
+  int written;
 
-  while (!feof(in_file_handler)) {
+  base64_decode_stream_init(&stream);
 
-    for (size = 0, i = 0; i < 4 && !feof(in_file_handler); i++) {
+  do {
 
-      v = 0;
-
-      while (!feof(in_file_handler) && v == 0) {
-        v = (unsigned char)getc(in_file_handler);
-        v = (unsigned char)((v < 43 || v > 122) ? 0 : cd64[v - 43]);
-        if (v) {
-          v = (unsigned char)((v == '$') ? 0 : v - 61);
-        }
-      }
-
-      if (!feof(in_file_handler)) {
-        size++;
-        if (v) {
-          input_block[i] = (unsigned char)(v - 1);
-        }
-      }
-      else {
-        input_block[i] = 0;
-      }
+    size = (int)fread(input, 1, BASE64_FILE_BUFFER_SIZE, in_file_handler);
 
+    written = base64_decode_stream(&stream, input, size, output);
+    if (size < BASE64_FILE_BUFFER_SIZE) {
+      written += base64_decode_stream_end(&stream, &output[written]);
     }
 
-    if (size) {
-
-      base64_decode_block(input_block, output_block);
+    fwrite(output, 1, written, out_file_handler);
 
-
-      for (i = 0; i < size - 1; i++) {
-        putc(output_block[i], out_file_handler);
-      }
-
-    }
-
-  }
+  } while (size == BASE64_FILE_BUFFER_SIZE);
 
 }
 
@@ -441,3 +637,197 @@ int base64_process_file(int operation_type, char *input_path, char *output_path,
   return(bSuccess);
 
 }
+
+/**
+ * Initializes the state of an incremental decode
+ *
+ * @param stream                 decode state
+ *
+ */
+void base64_decode_stream_init(BASE64_STREAM_T *stream) {
+
+  memset(stream, 0x00, sizeof(BASE64_STREAM_T));
+
+}
+
+/**
+ * Decodes a fragment of a base64-encoded stream. Discards padding and newline
+ * characters, an incomplete trailing block is kept for the next call.
+ *
+ * @param stream                 decode state
+ * @param in                     encoded input fragment
+ * @param in_len                 input fragment length
+ * @param out                    output buffer, at least BASE64_DECODE_STREAM_SIZE(in_len) bytes
+ *
+ * @return                       number of decoded bytes written to out
+ *
+ */
+int base64_decode_stream(BASE64_STREAM_T *stream, const char *in, int in_len, unsigned char *out) {
+
+  unsigned char v;
+  int i = 0;
+  int run;
+  int decoded;
+  int written = 0;
+
+  while (i < in_len) {
+
+    // Decodes whole blocks with the vector kernel while they are clean
+    if (stream->count == 0) {
+
+      decoded = base64_decode_kernel(&in[i], in_len - i, &out[written]);
+      i += decoded;
+      written += decoded / 4 * 3;
+    }
+
+    // Then goes on one character at a time for a while, skipping
+    // padding, line breaks and any other character out of the alphabet
+    for (run = 0; run < BASE64_SCALAR_RUN && i < in_len; run++, i++) {
+
+      v = (unsigned char)in[i];
+      v = (unsigned char)((v < 43 || v > 122) ? 0 : cd64[v - 43]);
+      if (v == 0 || v == '$') {
+        continue;
+      }
+
+      stream->block[stream->count++] = (unsigned char)(v - 62);
+
+      if (stream->count == 4) {
+
+        base64_decode_block(stream->block, &out[written]);
+        written += 3;
+        stream->count = 0;
+      }
+
+    }
+
+  }
+
+  return written;
+
+}
+
+/**
+ * Finalizes an incremental decode, flushing the incomplete trailing block
+ *
+ * @param stream                 decode state
+ * @param out                    output buffer, at least 3 bytes
+ *
+ * @return                       number of decoded bytes written to out
+ *
+ */
+int base64_decode_stream_end(BASE64_STREAM_T *stream, unsigned char *out) {
+
+  unsigned char output_block[3];
+  int written = 0;
+  int i;
+
+  // A single leftover character carries no complete byte
+  if (stream->count > 1) {
+
+    for (i = stream->count; i < 4; i++) {
+      stream->block[i] = 0;
+    }
+
+    base64_decode_block(stream->block, output_block);
+
+    written = stream->count - 1;
+    memcpy(out, output_block, written);
+  }
+
+  stream->count = 0;
+
+  return written;
+
+}
+
+/**
+ * Initializes the state of an incremental encode
+ *
+ * @param stream                 encode state
+ *
+ */
+void base64_encode_stream_init(BASE64_STREAM_T *stream) {
+
+  memset(stream, 0x00, sizeof(BASE64_STREAM_T));
+
+}
+
+/**
+ * Encodes a fragment of a binary stream without line breaks, an
+ * incomplete trailing block is kept for the next call.
+ *
+ * @param stream                 encode state
+ * @param in                     input fragment
+ * @param in_len                 input fragment length
+ * @param out                    output buffer, at least BASE64_ENCODE_STREAM_SIZE(in_len) bytes
+ *
+ * @return                       number of encoded characters written to out
+ *
+ */
+int base64_encode_stream(BASE64_STREAM_T *stream, const unsigned char *in, int in_len, char *out) {
+
+  int i = 0;
+  int encoded;
+  int written = 0;
+
+  // Completes the block left over by the previous call
+  while (stream->count > 0 && stream->count < 3 && i < in_len) {
+    stream->block[stream->count++] = in[i++];
+  }
+
+  if (stream->count == 3) {
+
+    base64_encode_block(stream->block, (unsigned char *)out, 3);
+    written += 4;
+    stream->count = 0;
+  }
+
+  // Encodes most of the input with the vector kernel
+  encoded = base64_encode_kernel(&in[i], in_len - i, &out[written]);
+  i += encoded;
+  written += encoded / 3 * 4;
+
+  for (; i + 3 <= in_len; i += 3) {
+
+    base64_encode_block((unsigned char *)&in[i], (unsigned char *)&out[written], 3);
+    written += 4;
+  }
+
+  while (i < in_len) {
+    stream->block[stream->count++] = in[i++];
+  }
+
+  return written;
+
+}
+
+/**
+ * Finalizes an incremental encode, writing the padded trailing block
+ *
+ * @param stream                 encode state
+ * @param out                    output buffer, at least 4 bytes
+ *
+ * @return                       number of encoded characters written to out
+ *
+ */
+int base64_encode_stream_end(BASE64_STREAM_T *stream, char *out) {
+
+  int written = 0;
+  int i;
+
+  if (stream->count > 0) {
+
+    for (i = stream->count; i < 3; i++) {
+      stream->block[i] = 0;
+    }
+
+    base64_encode_block(stream->block, (unsigned char *)out, stream->count);
+    written = 4;
+  }
+
+  stream->count = 0;
+
+  return written;
+
+}
@@ -30,6 +30,30 @@ extern "C" {
 #define BASE64_ENCODE_SIZE(s)           base64_encode_size(s)              
 #define BASE64_DECODE_SIZE(s)           base64_decode_size(s)
 #define BASE64_ENCODE_FILE(o, i, p, s)  base64_process_file(o, i, p, s)
+#define BASE64_DECODE_STREAM_INIT(st)   base64_decode_stream_init(st)
+#define BASE64_DECODE_STREAM(st, i, l, o) base64_decode_stream(st, i, l, o)
+#define BASE64_DECODE_STREAM_END(st, o) base64_decode_stream_end(st, o)
+#define BASE64_ENCODE_STREAM_INIT(st)   base64_encode_stream_init(st)
+#define BASE64_ENCODE_STREAM(st, i, l, o) base64_encode_stream(st, i, l, o)
+#define BASE64_ENCODE_STREAM_END(st, o) base64_encode_stream_end(st, o)
+
+// Worst case output of a stream decode for 'l' input characters
+#define BASE64_DECODE_STREAM_SIZE(l)    ( ( (l) / 4 + 1 ) * 3 )
+
+// Length of the unwrapped encoding of 'l' bytes, also the worst
+// case output of a stream encode for 'l' input bytes
+#define BASE64_ENCODE_STREAM_SIZE(l)    ( ( (l) + 2 ) / 3 * 4 )
+
+/**
+ * State of an incremental encode or decode, holds the
+ * bytes or characters of an incomplete block between calls
+ */
+typedef struct _base64_stream_t {
+
+  unsigned char block[4];
+  int count;
+
+} BASE64_STREAM_T;
 
 /**
  * Encodes three 8-bit binary characters as four 6-bit characters
@@ -101,6 +125,8 @@ unsigned char* base64_encode(unsigned char* data, int data_size);
  *
  * @return                       decoded output string,
  *                               must call free() after usage.
+ *                               NULL if the size is 0 or memory
+ *                               could not be allocated.
  *
  */
 char* base64_decode(char * string_encoded, int string_encoded_size);
@@ -137,6 +163,72 @@ void base64_decode_file(FILE *in_file_handler, FILE *out_file_handler);
  */
 int base64_process_file(int operation_type, char *input_path, char *output_path, int line_size);
 
+/**
+ * Initializes the state of an incremental decode
+ *
+ * @param stream                 decode state
+ *
+ */
+void base64_decode_stream_init(BASE64_STREAM_T *stream);
+
+/**
+ * Decodes a fragment of a base64-encoded stream. Discards padding and newline
+ * characters, an incomplete trailing block is kept for the next call.
+ *
+ * @param stream                 decode state
+ * @param in                     encoded input fragment
+ * @param in_len                 input fragment length
+ * @param out                    output buffer, at least BASE64_DECODE_STREAM_SIZE(in_len) bytes
+ *
+ * @return                       number of decoded bytes written to out
+ *
+ */
+int base64_decode_stream(BASE64_STREAM_T *stream, const char *in, int in_len, unsigned char *out);
+
+/**
+ * Finalizes an incremental decode, flushing the incomplete trailing block
+ *
+ * @param stream                 decode state
+ * @param out                    output buffer, at least 3 bytes
+ *
+ * @return                       number of decoded bytes written to out
+ *
+ */
+int base64_decode_stream_end(BASE64_STREAM_T *stream, unsigned char *out);
+
+/**
+ * Initializes the state of an incremental encode
+ *
+ * @param stream                 encode state
+ *
+ */
+void base64_encode_stream_init(BASE64_STREAM_T *stream);
+
+/**
+ * Encodes a fragment of a binary stream without line breaks, an
+ * incomplete trailing block is kept for the next call.
+ *
+ * @param stream                 encode state
+ * @param in                     input fragment
+ * @param in_len                 input fragment length
+ * @param out                    output buffer, at least BASE64_ENCODE_STREAM_SIZE(in_len) bytes
+ *
+ * @return                       number of encoded characters written to out
+ *
+ */
+int base64_encode_stream(BASE64_STREAM_T *stream, const unsigned char *in, int in_len, char *out);
+
+/**
+ * Finalizes an incremental encode, writing the padded trailing block
+ *
+ * @param stream                 encode state
+ * @param out                    output buffer, at least 4 bytes
+ *
+ * @return                       number of encoded characters written to out
+ *
+ */
+int base64_encode_stream_end(BASE64_STREAM_T *stream, char *out);
+
 #ifdef __cplusplus
 }
 #endif
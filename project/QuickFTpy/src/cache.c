@@ -0,0 +1,850 @@
+/*
+ * cache.c
+ *
+ * $Id: $
+ * $HeadURL: $
+ * $LastChangedRevision: $
+ * $LastChangedDate: $
+ * $LastChangedBy: $
+ *
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE 1
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <pthread.h>
+
+#include "cache.h"
+#include "macros.h"
+#include "logger.h"
+
+// Prefix of the files of the disk tier
+#define CACHE_FILE_PREFIX     "qftcache."
+
+// Entries of a tier, from the most to the least recently used
+typedef struct _cache_tier_t {
+
+  CACHE_ENTRY_T * head;
+  CACHE_ENTRY_T * tail;
+
+  unsigned long long bytes;
+  unsigned long long capacity;
+  int entries;
+
+} CACHE_TIER_T;
+
+static pthread_mutex_t cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+static CACHE_ENTRY_T * cache_buckets[CACHE_BUCKETS];
+static CACHE_TIER_T cache_tiers[2];
+static char cache_directory[1024];
+static CACHE_STATS_T counters;
+
+/**
+ * Hashes the path of a file
+ *
+ * @param path            path
+ *
+ * @return                hash
+ */
+static unsigned long cache_hash( const char * path ) {
+
+  unsigned long hash = 2166136261UL;
+
+  for ( ; *path != '\0'; path++ ) {
+    hash = ( hash ^ (unsigned char)*path ) * 16777619UL;
+  }
+
+  return hash;
+}
+
+/**
+ * Gets the largest entry a tier takes, the cache mutex being held
+ *
+ * @param tier            CACHE_TIER_MEMORY or CACHE_TIER_DISK
+ *
+ * @return                length of the entry, 0 if the tier is disabled
+ */
+static unsigned long long cache_entry_maximum( int tier ) {
+
+  unsigned long long maximum = cache_tiers[tier].capacity / CACHE_ENTRY_SHARE;
+
+  if ( tier == CACHE_TIER_MEMORY && maximum > CACHE_MEMORY_ENTRY_LIMIT ) {
+    maximum = CACHE_MEMORY_ENTRY_LIMIT;
+  }
+  if ( tier == CACHE_TIER_DISK && cache_directory[0] == '\0' ) {
+    maximum = 0;
+  }
+
+  return maximum;
+}
+
+/**
+ * Evaluates if an entry holds the content of the version of a file
+ *
+ * @param entry           entry
+ * @param info            status of the file
+ *
+ * @return                TRUE or FALSE
+ */
+static int cache_same_version( const CACHE_ENTRY_T * entry, const struct stat * info ) {
+
+  return ( entry->dev == info->st_dev && entry->ino == info->st_ino && entry->size == (long long)info->st_size &&
+           entry->mtime_sec == (long long)info->st_mtim.tv_sec && entry->mtime_nsec == info->st_mtim.tv_nsec );
+}
+
+/**
+ * Frees an entry no longer referenced, and its file
+ *
+ * @param entry           entry
+ */
+static void cache_free( CACHE_ENTRY_T * entry ) {
+
+  if ( entry->disk_path != NULL ) {
+
+    unlink(entry->disk_path);
+    free(entry->disk_path);
+  }
+
+  free(entry->data);
+  free(entry->path);
+  free(entry);
+}
+
+/**
+ * Takes an entry out of the cache, the cache mutex being held. The entry
+ * is appended to a list of entries to release once the mutex is released.
+ *
+ * @param entry           entry
+ * @param victims         list of entries, linked by their lru_next
+ */
+static void cache_detach( CACHE_ENTRY_T * entry, CACHE_ENTRY_T ** victims ) {
+
+  CACHE_TIER_T * tier = &cache_tiers[entry->tier];
+  CACHE_ENTRY_T ** link = &cache_buckets[entry->hash % CACHE_BUCKETS];
+
+  while ( *link != entry ) {
+    link = &(*link)->bucket_next;
+  }
+  *link = entry->bucket_next;
+
+  if ( entry->lru_prev != NULL ) {
+    entry->lru_prev->lru_next = entry->lru_next;
+  }
+  else {
+    tier->head = entry->lru_next;
+  }
+  if ( entry->lru_next != NULL ) {
+    entry->lru_next->lru_prev = entry->lru_prev;
+  }
+  else {
+    tier->tail = entry->lru_prev;
+  }
+
+  tier->bytes -= entry->len;
+  tier->entries--;
+
+  entry->bucket_next = NULL;
+  entry->lru_prev = NULL;
+  entry->lru_next = *victims;
+  *victims = entry;
+}
+
+/**
+ * Makes an entry the most recently used of its tier, the cache mutex being held
+ *
+ * @param entry           entry, already in its tier or not linked at all
+ * @param linked          TRUE if the entry is in its tier
+ */
+static void cache_touch( CACHE_ENTRY_T * entry, int linked ) {
+
+  CACHE_TIER_T * tier = &cache_tiers[entry->tier];
+
+  if ( linked ) {
+
+    if ( tier->head == entry ) {
+      return;
+    }
+
+    entry->lru_prev->lru_next = entry->lru_next;
+    if ( entry->lru_next != NULL ) {
+      entry->lru_next->lru_prev = entry->lru_prev;
+    }
+    else {
+      tier->tail = entry->lru_prev;
+    }
+  }
+
+  entry->lru_prev = NULL;
+  entry->lru_next = tier->head;
+  if ( tier->head != NULL ) {
+    tier->head->lru_prev = entry;
+  }
+  tier->head = entry;
+  if ( tier->tail == NULL ) {
+    tier->tail = entry;
+  }
+}
+
+static void cache_insert( CACHE_ENTRY_T * entry );
+
+/**
+ * Moves the content of an entry evicted from memory to a file of the disk tier
+ *
+ * @param victim          entry evicted from the memory tier
+ */
+static void cache_demote( CACHE_ENTRY_T * victim ) {
+
+  CACHE_ENTRY_T * entry;
+  char disk_path[2048];
+  unsigned long long written = 0;
+  ssize_t bwritten;
+  int fd;
+
+  pthread_mutex_lock(&cache_mutex);
+  if ( victim->len > cache_entry_maximum(CACHE_TIER_DISK) ) {
+
+    pthread_mutex_unlock(&cache_mutex);
+    return;
+  }
+  sprintf(disk_path, "%s/" CACHE_FILE_PREFIX "XXXXXX", cache_directory);
+  pthread_mutex_unlock(&cache_mutex);
+
+  fd = mkstemp(disk_path);
+  if ( fd == -1 ) {
+    return;
+  }
+
+  while ( written < victim->len ) {
+
+    bwritten = write(fd, &victim->data[written], (size_t)( victim->len - written ));
+    if ( bwritten <= 0 ) {
+      break;
+    }
+    written += bwritten;
+  }
+
+  if ( close(fd) != 0 || written != victim->len ) {
+
+    unlink(disk_path);
+    return;
+  }
+
+  entry = (CACHE_ENTRY_T *)malloc(sizeof(CACHE_ENTRY_T));
+  memcpy(entry, victim, sizeof(CACHE_ENTRY_T));
+  entry->path = strdup(victim->path);
+  entry->tier = CACHE_TIER_DISK;
+  entry->data = NULL;
+  entry->disk_path = strdup(disk_path);
+  entry->refs = 1;
+
+  cache_insert(entry);
+}
+
+/**
+ * Releases the entries taken out of the cache, optionally moving
+ * the ones evicted from memory to the disk tier
+ *
+ * @param victims         list of entries, linked by their lru_next
+ * @param demote          TRUE to move them to the disk tier
+ */
+static void cache_release_victims( CACHE_ENTRY_T * victims, int demote ) {
+
+  CACHE_ENTRY_T * next;
+
+  for ( ; victims != NULL; victims = next ) {
+
+    next = victims->lru_next;
+    victims->lru_next = NULL;
+
+    if ( demote && victims->tier == CACHE_TIER_MEMORY ) {
+      cache_demote(victims);
+    }
+
+    cache_release(victims);
+  }
+}
+
+/**
+ * Adds an entry to the cache, replacing the entries of other versions of
+ * the file and the same content, and evicting the least recently used
+ * entries of its tier while it holds more than its capacity
+ *
+ * @param entry           entry with a single reference, that the cache takes
+ */
+static void cache_insert( CACHE_ENTRY_T * entry ) {
+
+  CACHE_ENTRY_T * replaced = NULL;
+  CACHE_ENTRY_T * evicted = NULL;
+  CACHE_ENTRY_T * current;
+  CACHE_ENTRY_T * next;
+  CACHE_TIER_T * tier = &cache_tiers[entry->tier];
+  struct stat info;
+
+  info.st_dev = entry->dev;
+  info.st_ino = entry->ino;
+  info.st_size = (off_t)entry->size;
+  info.st_mtim.tv_sec = (time_t)entry->mtime_sec;
+  info.st_mtim.tv_nsec = entry->mtime_nsec;
+
+  entry->hash = cache_hash(entry->path);
+
+  pthread_mutex_lock(&cache_mutex);
+
+  // The cache may have been configured again meanwhile
+  if ( entry->len > cache_entry_maximum(entry->tier) ) {
+
+    pthread_mutex_unlock(&cache_mutex);
+    cache_free(entry);
+    return;
+  }
+
+  for ( current = cache_buckets[entry->hash % CACHE_BUCKETS]; current != NULL; current = next ) {
+
+    next = current->bucket_next;
+
+    if ( current->hash != entry->hash || strcmp(current->path, entry->path) != 0 ) {
+      continue;
+    }
+
+    if ( ! cache_same_version(current, &info) ) {
+
+      cache_detach(current, &replaced);
+      counters.invalidations++;
+    }
+    else if ( current->format == entry->format && current->codec == entry->codec ) {
+      cache_detach(current, &replaced);
+    }
+  }
+
+  entry->bucket_next = cache_buckets[entry->hash % CACHE_BUCKETS];
+  cache_buckets[entry->hash % CACHE_BUCKETS] = entry;
+  cache_touch(entry, FALSE);
+
+  tier->bytes += entry->len;
+  tier->entries++;
+  counters.insertions++;
+
+  while ( tier->bytes > tier->capacity && tier->tail != entry ) {
+
+    cache_detach(tier->tail, &evicted);
+    counters.evictions++;
+  }
+
+  pthread_mutex_unlock(&cache_mutex);
+
+  cache_release_victims(replaced, FALSE);
+  cache_release_victims(evicted, TRUE);
+}
+
+/**
+ * Removes the files of the disk tier left in a directory
+ *
+ * @param directory       directory of the disk tier
+ */
+static void cache_clean_directory( const char * directory ) {
+
+  char path[2048];
+  struct dirent * item;
+  DIR * dir;
+
+  dir = opendir(directory);
+  if ( dir == NULL ) {
+    return;
+  }
+
+  while ( ( item = readdir(dir) ) != NULL ) {
+
+    if ( strncmp(item->d_name, CACHE_FILE_PREFIX, strlen(CACHE_FILE_PREFIX)) == 0 ) {
+
+      snprintf(path, sizeof(path), "%s/%s", directory, item->d_name);
+      unlink(path);
+    }
+  }
+
+  closedir(dir);
+}
+
+/**
+ * Sets the capacity of the cache of the content sent for the files the
+ * clients receive, dropping what it holds
+ *
+ * @param memory_capacity bytes kept in memory, 0 to disable the cache
+ * @param directory       directory of the disk tier, created if needed,
+ *                        or NULL for none
+ * @param disk_capacity   bytes kept in the disk tier
+ *
+ * @return                TRUE or FALSE
+ */
+int cache_configure( unsigned long long memory_capacity, const char * directory, unsigned long long disk_capacity ) {
+
+  CACHE_ENTRY_T * victims = NULL;
+  char l_msg[2048];
+  int i;
+
+  if ( directory != NULL && directory[0] == '\0' ) {
+    directory = NULL;
+  }
+
+  if ( directory != NULL ) {
+
+    if ( strlen(directory) >= sizeof(cache_directory) ) {
+
+      LOGGER(__FUNCTION__, "ERROR: The path of the cache directory is too long.");
+      return FALSE;
+    }
+
+    if ( mkdir(directory, S_IRWXU) == -1 && errno != EEXIST ) {
+
+      sprintf(l_msg, "ERROR: Cache directory %s could not be created, code [%d].", directory, errno);
+      LOGGER(__FUNCTION__, l_msg);
+      return FALSE;
+    }
+
+    // Files of the directory in use belong to the entries still referenced
+    if ( strcmp(directory, cache_directory) != 0 ) {
+      cache_clean_directory(directory);
+    }
+  }
+
+  pthread_mutex_lock(&cache_mutex);
+
+  for ( i = 0; i < CACHE_BUCKETS; i++ ) {
+
+    while ( cache_buckets[i] != NULL ) {
+      cache_detach(cache_buckets[i], &victims);
+    }
+  }
+
+  cache_tiers[CACHE_TIER_MEMORY].capacity = memory_capacity;
+  cache_tiers[CACHE_TIER_DISK].capacity = ( memory_capacity > 0 && directory != NULL ) ? disk_capacity : 0;
+
+  strcpy(cache_directory, ( directory != NULL ) ? directory : "");
+
+  pthread_mutex_unlock(&cache_mutex);
+
+  cache_release_victims(victims, FALSE);
+
+  return TRUE;
+}
+
+/**
+ * Evaluates if the cache is enabled
+ *
+ * @return                TRUE or FALSE
+ */
+int cache_enabled() {
+
+  return ( cache_tiers[CACHE_TIER_MEMORY].capacity > 0 );
+}
+
+/**
+ * Looks for the content sent for the current version of a file
+ *
+ * @param path            path of the file
+ * @param info            status of the open file
+ * @param format          format of the content
+ * @param codec           codec of the content
+ *
+ * @return                the entry, which must be given back with
+ *                        cache_release(), or NULL if there is none
+ */
+CACHE_ENTRY_T * cache_lookup( const char * path, const struct stat * info, int format, int codec ) {
+
+  CACHE_ENTRY_T * stale = NULL;
+  CACHE_ENTRY_T * found = NULL;
+  CACHE_ENTRY_T * current;
+  CACHE_ENTRY_T * next;
+  unsigned long hash;
+
+  if ( ! cache_enabled() ) {
+    return NULL;
+  }
+
+  hash = cache_hash(path);
+
+  pthread_mutex_lock(&cache_mutex);
+
+  for ( current = cache_buckets[hash % CACHE_BUCKETS]; current != NULL; current = next ) {
+
+    next = current->bucket_next;
+
+    if ( current->hash != hash || strcmp(current->path, path) != 0 ) {
+      continue;
+    }
+
+    // The file changed since the entry was made
+    if ( ! cache_same_version(current, info) ) {
+
+      cache_detach(current, &stale);
+      counters.invalidations++;
+    }
+    else if ( current->format == format && current->codec == codec ) {
+      found = current;
+    }
+  }
+
+  if ( found != NULL ) {
+
+    cache_touch(found, TRUE);
+    found->refs++;
+
+    if ( found->tier == CACHE_TIER_MEMORY ) {
+      counters.hits++;
+    }
+    else {
+      counters.disk_hits++;
+    }
+  }
+  else {
+    counters.misses++;
+  }
+
+  pthread_mutex_unlock(&cache_mutex);
+
+  cache_release_victims(stale, FALSE);
+
+  return found;
+}
+
+/**
+ * Gives back an entry found with cache_lookup()
+ *
+ * @param entry           entry
+ */
+void cache_release( CACHE_ENTRY_T * entry ) {
+
+  int last;
+
+  pthread_mutex_lock(&cache_mutex);
+  last = ( --entry->refs == 0 );
+  pthread_mutex_unlock(&cache_mutex);
+
+  if ( last ) {
+    cache_free(entry);
+  }
+}
+
+/**
+ * Drops the entries of a file that was replaced or deleted
+ *
+ * @param path            path of the file
+ */
+void cache_invalidate( const char * path ) {
+
+  CACHE_ENTRY_T * victims = NULL;
+  CACHE_ENTRY_T * current;
+  CACHE_ENTRY_T * next;
+  unsigned long hash;
+
+  if ( ! cache_enabled() ) {
+    return;
+  }
+
+  hash = cache_hash(path);
+
+  pthread_mutex_lock(&cache_mutex);
+
+  for ( current = cache_buckets[hash % CACHE_BUCKETS]; current != NULL; current = next ) {
+
+    next = current->bucket_next;
+
+    if ( current->hash == hash && strcmp(current->path, path) == 0 ) {
+
+      cache_detach(current, &victims);
+      counters.invalidations++;
+    }
+  }
+
+  pthread_mutex_unlock(&cache_mutex);
+
+  cache_release_victims(victims, FALSE);
+}
+
+/**
+ * Gives up the capture of the content sent for a file
+ *
+ * @param fill            state of the capture
+ */
+static void cache_fill_abort( CACHE_FILL_T * fill ) {
+
+  free(fill->data);
+  fill->data = NULL;
+
+  if ( fill->fd != -1 ) {
+
+    close(fill->fd);
+    unlink(fill->temp_path);
+    fill->fd = -1;
+  }
+
+  fill->active = FALSE;
+}
+
+/**
+ * Begins capturing the content sent for a file, even if the cache is
+ * disabled, as the capture may be shared by concurrent requests
+ *
+ * @param fill            state of the capture
+ */
+void cache_fill_begin( CACHE_FILL_T * fill ) {
+
+  memset(fill, 0x00, offsetof(CACHE_FILL_T, temp_path));
+  fill->fd = -1;
+
+  pthread_mutex_lock(&cache_mutex);
+
+  fill->memory_maximum = cache_entry_maximum(CACHE_TIER_MEMORY);
+  fill->disk_maximum = cache_entry_maximum(CACHE_TIER_DISK);
+  strcpy(fill->temp_path, cache_directory);
+
+  pthread_mutex_unlock(&cache_mutex);
+
+  fill->memory_limit = ( fill->memory_maximum > CACHE_SHARED_MEMORY ) ? fill->memory_maximum : CACHE_SHARED_MEMORY;
+  fill->active = TRUE;
+}
+
+/**
+ * Captures part of the content sent for a file
+ *
+ * @param fill            state of the capture
+ * @param data            data sent
+ * @param len             data length
+ */
+void cache_fill_write( CACHE_FILL_T * fill, const char * data, unsigned long len ) {
+
+  char * grown;
+  unsigned long long size;
+  unsigned long written = 0;
+  ssize_t bwritten;
+
+  if ( ! fill->active ) {
+    return;
+  }
+
+  // Content that the cache would not take is only kept while it is shared
+  if ( ! fill->shared && fill->len + len > fill->memory_maximum && fill->len + len > fill->disk_maximum &&
+       ( fill->fd != -1 || fill->len + len > fill->memory_limit ) ) {
+
+    cache_fill_abort(fill);
+    return;
+  }
+
+  // Content that outgrows memory moves to a file
+  if ( fill->fd == -1 && fill->len + len > fill->memory_limit ) {
+
+    if ( fill->temp_path[0] == '\0' ) {
+      strcpy(fill->temp_path, P_tmpdir);
+    }
+    strcat(fill->temp_path, "/" CACHE_FILE_PREFIX "XXXXXX");
+
+    fill->fd = mkstemp(fill->temp_path);
+    if ( fill->fd == -1 ) {
+
+      cache_fill_abort(fill);
+      return;
+    }
+
+    if ( fill->len > 0 && write(fill->fd, fill->data, (size_t)fill->len) != (ssize_t)fill->len ) {
+
+      cache_fill_abort(fill);
+      return;
+    }
+
+    free(fill->data);
+    fill->data = NULL;
+  }
+
+  if ( fill->fd == -1 ) {
+
+    if ( fill->len + len > fill->size ) {
+
+      size = ( fill->size > 0 ) ? fill->size : 65536;
+      while ( size < fill->len + len ) {
+        size *= 2;
+      }
+
+      grown = (char *)realloc(fill->data, (size_t)size);
+      if ( grown == NULL ) {
+
+        cache_fill_abort(fill);
+        return;
+      }
+
+      fill->data = grown;
+      fill->size = size;
+    }
+
+    memcpy(&fill->data[fill->len], data, len);
+    fill->len += len;
+    return;
+  }
+
+  while ( written < len ) {
+
+    bwritten = write(fill->fd, &data[written], len - written);
+    if ( bwritten <= 0 ) {
+
+      cache_fill_abort(fill);
+      return;
+    }
+    written += bwritten;
+  }
+
+  fill->len += len;
+}
+
+/**
+ * Reads part of the content captured so far
+ *
+ * @param fill            state of the capture
+ * @param offset          offset of the part in the content
+ * @param buffer          buffer for the part
+ * @param len             length of the part, within what was captured
+ *
+ * @return                TRUE or FALSE
+ */
+int cache_fill_read( CACHE_FILL_T * fill, unsigned long long offset, char * buffer, unsigned long len ) {
+
+  unsigned long bread = 0;
+  ssize_t part;
+
+  if ( ! fill->active || offset + len > fill->len ) {
+    return FALSE;
+  }
+
+  if ( fill->fd == -1 ) {
+
+    memcpy(buffer, &fill->data[offset], len);
+    return TRUE;
+  }
+
+  while ( bread < len ) {
+
+    part = pread(fill->fd, &buffer[bread], len - bread, (off_t)( offset + bread ));
+    if ( part <= 0 ) {
+      return FALSE;
+    }
+    bread += part;
+  }
+
+  return TRUE;
+}
+
+/**
+ * Ends the capture of the content sent for a file, adding it to the cache
+ * if the whole content was captured and the file did not change meanwhile
+ *
+ * @param fill            state of the capture
+ * @param path            path of the file
+ * @param info            status of the file before its content was sent
+ * @param format          format of the content
+ * @param codec           codec of the content
+ * @param mode            compression mode of the content
+ * @param success         TRUE if the whole content was captured and the
+ *                        file is still the version described by info
+ */
+void cache_fill_end( CACHE_FILL_T * fill, const char * path, const struct stat * info, int format, int codec, int mode, int success ) {
+
+  CACHE_ENTRY_T * entry;
+
+  if ( ! fill->active ) {
+    return;
+  }
+
+  if ( ! success ) {
+
+    cache_fill_abort(fill);
+    return;
+  }
+
+  entry = (CACHE_ENTRY_T *)malloc(sizeof(CACHE_ENTRY_T));
+  memset(entry, 0x00, sizeof(CACHE_ENTRY_T));
+
+  entry->path = strdup(path);
+  entry->dev = info->st_dev;
+  entry->ino = info->st_ino;
+  entry->size = (long long)info->st_size;
+  entry->mtime_sec = (long long)info->st_mtim.tv_sec;
+  entry->mtime_nsec = info->st_mtim.tv_nsec;
+  entry->format = format;
+  entry->codec = codec;
+  entry->mode = mode;
+  entry->len = fill->len;
+  entry->refs = 1;
+
+  if ( fill->fd != -1 ) {
+
+    if ( close(fill->fd) != 0 ) {
+
+      fill->fd = -1;
+      unlink(fill->temp_path);
+      cache_free(entry);
+      cache_fill_abort(fill);
+      return;
+    }
+
+    entry->tier = CACHE_TIER_DISK;
+    entry->disk_path = strdup(fill->temp_path);
+  }
+  else {
+
+    entry->tier = CACHE_TIER_MEMORY;
+    entry->data = fill->data;
+  }
+
+  fill->data = NULL;
+  fill->fd = -1;
+  fill->active = FALSE;
+
+  // Content kept in memory only because it was shared may still suit the disk tier
+  if ( entry->tier == CACHE_TIER_MEMORY && entry->len > fill->memory_maximum ) {
+
+    cache_demote(entry);
+    cache_free(entry);
+    return;
+  }
+
+  cache_insert(entry);
+}
+
+/**
+ * Evaluates if an open file is still the version its status was taken of
+ *
+ * @param fd              descriptor of the file
+ * @param info            status of the file
+ *
+ * @return                TRUE or FALSE
+ */
+int cache_file_unchanged( int fd, const struct stat * info ) {
+
+  struct stat now;
+
+  return ( fstat(fd, &now) == 0 && now.st_ino == info->st_ino && now.st_size == info->st_size &&
+           now.st_mtim.tv_sec == info->st_mtim.tv_sec && now.st_mtim.tv_nsec == info->st_mtim.tv_nsec );
+}
+
+/**
+ * Gets the counters of the cache
+ *
+ * @param stats           structure that receives the counters
+ */
+void cache_get_stats( CACHE_STATS_T * stats ) {
+
+  pthread_mutex_lock(&cache_mutex);
+
+  memcpy(stats, &counters, sizeof(CACHE_STATS_T));
+  stats->memory_bytes = cache_tiers[CACHE_TIER_MEMORY].bytes;
+  stats->disk_bytes = cache_tiers[CACHE_TIER_DISK].bytes;
+  stats->entries = cache_tiers[CACHE_TIER_MEMORY].entries + cache_tiers[CACHE_TIER_DISK].entries;
+
+  pthread_mutex_unlock(&cache_mutex);
+}
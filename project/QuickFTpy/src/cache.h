@@ -0,0 +1,231 @@
+/*
+ * cache.h
+ *
+ * $Id: $
+ * $HeadURL: $
+ * $LastChangedRevision: $
+ * $LastChangedDate: $
+ * $LastChangedBy: $
+ *
+ */
+
+#ifndef _CACHE_H
+#define _CACHE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+// Number of buckets of the table of entries, hashed by path
+#define CACHE_BUCKETS             1024
+
+// Share of the capacity of a tier a single entry may take
+#define CACHE_ENTRY_SHARE         8
+
+// Largest entry of the memory tier, as it is sent in a single call
+#define CACHE_MEMORY_ENTRY_LIMIT  ( 1024 * 1024 * 1024 )
+
+// Content a capture keeps in memory whatever the capacity of the memory
+// tier, so that concurrent requests for the same file may share it
+#define CACHE_SHARED_MEMORY       ( 16 * 1024 * 1024 )
+
+// Tiers an entry may be kept in
+#define CACHE_TIER_MEMORY         0
+#define CACHE_TIER_DISK           1
+
+/**
+ * Content of a message sent for a file, exactly as it follows the
+ * parameters of the response, compressed, encoded and split in frames
+ * as the format of the request asks for. It identifies the version of
+ * the file by its inode, size and modification time, so that a file
+ * that changed is never answered with the content of a previous version.
+ */
+typedef struct _cache_entry_t {
+
+  char * path;
+  dev_t dev;
+  ino_t ino;
+  long long size;
+  long long mtime_sec;
+  long mtime_nsec;
+  int format;
+  int codec;
+  int mode;               // compression mode the content was packed with
+
+  int tier;
+  char * data;            // content of the memory tier
+  char * disk_path;       // file with the content of the disk tier
+  unsigned long long len;
+
+  // Lookups being served, plus one while the entry is in the cache,
+  // the entry is freed once the last of them is released
+  int refs;
+
+  unsigned long hash;
+  struct _cache_entry_t * bucket_next;
+  struct _cache_entry_t * lru_prev;
+  struct _cache_entry_t * lru_next;
+
+} CACHE_ENTRY_T;
+
+/**
+ * Content being captured as it is sent, kept in memory until it grows
+ * beyond what the memory tier takes and then written to a file of the
+ * disk tier, or given up if neither takes it. A shared capture is never
+ * given up for its length, as requests are reading it, and is written to
+ * a file of the temporary directory when there is no disk tier.
+ */
+typedef struct _cache_fill_t {
+
+  int active;
+  int shared;
+  char * data;
+  unsigned long long len;
+  unsigned long long size;
+  int fd;
+  char temp_path[2048];   // directory of the disk tier until the file is created
+
+  // Largest entries of each tier when the capture began,
+  // and content kept in memory before it is written to a file
+  unsigned long long memory_maximum;
+  unsigned long long disk_maximum;
+  unsigned long long memory_limit;
+
+} CACHE_FILL_T;
+
+// Counters of the cache
+typedef struct _cache_stats_t {
+
+  unsigned long long hits;
+  unsigned long long disk_hits;
+  unsigned long long misses;
+  unsigned long long insertions;
+  unsigned long long evictions;
+  unsigned long long invalidations;
+
+  unsigned long long memory_bytes;
+  unsigned long long disk_bytes;
+  int entries;
+
+} CACHE_STATS_T;
+
+/**
+ * Sets the capacity of the cache of the content sent for the files the
+ * clients receive, dropping what it holds. Entries evicted from the memory
+ * tier are moved to the disk tier if there is one, which also takes the
+ * entries too large for memory.
+ *
+ * @param memory_capacity bytes kept in memory, 0 to disable the cache
+ * @param directory       directory of the disk tier, created if needed,
+ *                        or NULL for none. The files the cache left in it
+ *                        are removed.
+ * @param disk_capacity   bytes kept in the disk tier
+ *
+ * @return                TRUE or FALSE
+ */
+int cache_configure( unsigned long long memory_capacity, const char * directory, unsigned long long disk_capacity );
+
+/**
+ * Evaluates if the cache is enabled
+ *
+ * @return                TRUE or FALSE
+ */
+int cache_enabled();
+
+/**
+ * Looks for the content sent for the current version of a file
+ *
+ * @param path            path of the file
+ * @param info            status of the open file
+ * @param format          CONTENT_ENCODED, CONTENT_ENCODED_CHUNKED
+ *                        or CONTENT_BINARY_CHUNKED
+ * @param codec           codec of the content
+ *
+ * @return                the entry, which must be given back with
+ *                        cache_release(), or NULL if there is none
+ */
+CACHE_ENTRY_T * cache_lookup( const char * path, const struct stat * info, int format, int codec );
+
+/**
+ * Gives back an entry found with cache_lookup()
+ *
+ * @param entry           entry
+ */
+void cache_release( CACHE_ENTRY_T * entry );
+
+/**
+ * Drops the entries of a file that was replaced or deleted
+ *
+ * @param path            path of the file
+ */
+void cache_invalidate( const char * path );
+
+/**
+ * Begins capturing the content sent for a file, even if the cache is
+ * disabled, as the capture may be shared by concurrent requests
+ *
+ * @param fill            state of the capture
+ */
+void cache_fill_begin( CACHE_FILL_T * fill );
+
+/**
+ * Captures part of the content sent for a file
+ *
+ * @param fill            state of the capture
+ * @param data            data sent
+ * @param len             data length
+ */
+void cache_fill_write( CACHE_FILL_T * fill, const char * data, unsigned long len );
+
+/**
+ * Reads part of the content captured so far
+ *
+ * @param fill            state of the capture
+ * @param offset          offset of the part in the content
+ * @param buffer          buffer for the part
+ * @param len             length of the part, within what was captured
+ *
+ * @return                TRUE or FALSE
+ */
+int cache_fill_read( CACHE_FILL_T * fill, unsigned long long offset, char * buffer, unsigned long len );
+
+/**
+ * Ends the capture of the content sent for a file, adding it to the cache
+ * if the whole content was captured and the file did not change meanwhile
+ *
+ * @param fill            state of the capture
+ * @param path            path of the file
+ * @param info            status of the file before its content was sent
+ * @param format          format of the content
+ * @param codec           codec of the content
+ * @param mode            compression mode of the content
+ * @param success         TRUE if the whole content was captured and the
+ *                        file is still the version described by info
+ */
+void cache_fill_end( CACHE_FILL_T * fill, const char * path, const struct stat * info, int format, int codec, int mode, int success );
+
+/**
+ * Evaluates if an open file is still the version its status was taken of
+ *
+ * @param fd              descriptor of the file
+ * @param info            status of the file
+ *
+ * @return                TRUE or FALSE
+ */
+int cache_file_unchanged( int fd, const struct stat * info );
+
+/**
+ * Gets the counters of the cache
+ *
+ * @param stats           structure that receives the counters
+ */
+void cache_get_stats( CACHE_STATS_T * stats );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // _CACHE_H
@@ -10,6 +10,8 @@
  */
 
 #include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <python2.7/Python.h>
 
 #include "message.h"
@@ -23,6 +25,20 @@
 #include "file.h"
 #include "time.h"
 #include "gz.h"
+#include "delta.h"
+#include "sha256.h"
+
+/**
+ * Sets the timeouts of the client operations
+ *
+ * @param timeout                                 timeout for parts of the messages, can be 0 for default
+ * @param timeout_ack                             timeout for ack messages, can be 0 for default
+ */
+void client_timeouts( long timeout, long timeout_ack ) {
+
+  gl_timeout = ( timeout != 0 ) ? timeout : DEFAULT_TIMEOUT;
+  client_timeout_ack = ( timeout_ack != 0 ) ? timeout_ack : DEFAULT_TIMEOUT_ACK;
+}
 
 /**
  * Initializes a QuickFT client
@@ -39,16 +55,7 @@ quickft_client_t * client_initialize( char * addr, int port, long timeout, long
 
   LOGGER(__FUNCTION__, "Initializes QUICKFT client.");
 
-  gl_timeout = DEFAULT_TIMEOUT;
-  client_timeout_ack = DEFAULT_TIMEOUT_ACK;
-
-  if (timeout != 0) {
-    gl_timeout = timeout;
-  }
-  
-  if (timeout_ack != 0) {
-    client_timeout_ack = timeout_ack;
-  }
+  client_timeouts(timeout, timeout_ack);
 
   // Initializes the library's sockets functionalities
   if ( ! SOCKET_INIT() ) {
@@ -87,6 +94,7 @@ int client_finalize ( quickft_client_t ** client ) {
     
     // Frees allocated memory
     free(*client);
+    *client = NULL;
 
     // Finalizes library's sockets functionalities
     SOCKET_DEINIT();
@@ -98,50 +106,38 @@ int client_finalize ( quickft_client_t ** client ) {
 }
 
 /**
- * Completes a 'File Receive' operation and returns the result
+ * Completes a 'File Send' operation and returns the result
  *
  * @param incoming_message        received response message
- * @param incoming_message_len    response message length
- * @param local_filename          local name of the file being received
+ * @param incoming_message_len    received response message length
  *
  * @return                        TRUE o FALSE
  */
-int client_get_file_receive_response_result(char * incoming_message, int incoming_message_len, char * local_filename) {
+int client_get_file_send_response_result(char * incoming_message, int incoming_message_len) {
 
   const int NOT_FOUND = -1;
 
   char l_msg[_BUFFER_SIZE_S];
-  char destination_dir[2048];
 
   int result = RESULT_UNDEFINED;
-
-  int search_length_res;
-  int search_content_res;
   int search_result_res;
 
-  char * content  = NULL;
-  int length = 0;
+  char * response;
 
-  char * response = NULL;
-  
   // Moves response to a safe buffer for searching
   response = (char*)malloc(sizeof(char) * incoming_message_len + 1);
   memcpy(response, incoming_message, incoming_message_len);
   response[incoming_message_len] = '\0';
 
   // Parses parameters
-  search_length_res = string_search(response, PARAM_LENGTH, HEADER_LEN);
-  search_content_res = string_search(response, PARAM_CONTENT, HEADER_LEN);
   search_result_res = string_search(response, PARAM_RESULT, HEADER_LEN);
 
-  // Finds mandatory 'result' parameter
   if (search_result_res == NOT_FOUND ) {
-
-    snprintf(l_msg, _BUFFER_SIZE_S, "ERROR: invalid response parameters: [%s]", response);
+    snprintf(l_msg, _BUFFER_SIZE_S, "ERROR: invalid response parameters [%s]", response);
     LOGGER(__FUNCTION__, l_msg);
     
     result = RESULT_INVALID_RESPONSE;
-    goto END_FILE_RECEIVE_RESULT;
+    
   }
   else {
 
@@ -155,129 +151,22 @@ int client_get_file_receive_response_result(char * incoming_message, int incomin
 
     free(result_string);
 
-    if (result != RESULT_SUCCESS) {
-
-      goto END_FILE_RECEIVE_RESULT;
-    }
-  }
-
-  if (search_length_res == NOT_FOUND || search_content_res == NOT_FOUND) {
-    snprintf(l_msg, _BUFFER_SIZE_S, "ERROR: invalid response parameters: [%s]", response);
-    LOGGER(__FUNCTION__, l_msg);
-    
-    result = RESULT_INVALID_RESPONSE;
-    goto END_FILE_RECEIVE_RESULT;
-  }
-
-  length = atoi( &( response[ ( search_length_res + strlen(PARAM_LENGTH) ) ] ) );
-
-  if (length == 0) {
-    
-    snprintf(l_msg, _BUFFER_SIZE_S, "ERROR: invalid response parameters: [%s]", response);
-    LOGGER(__FUNCTION__, l_msg);
-
-    result = RESULT_INVALID_RESPONSE;
-    goto END_FILE_RECEIVE_RESULT;
-  }
-
-  content = (char*)malloc(sizeof(char) * (incoming_message_len - search_content_res));
-  memcpy(content, &( response[ ( search_content_res + strlen(PARAM_CONTENT) ) ] ), length );
-
-  // Prepares directory
-  file_get_base_path(local_filename, destination_dir);
-  if (destination_dir != NULL)
-  {
-    // @HACK: checks if destination directory is not root
-    if (strcmp(destination_dir, ROOT_DIR) != 0 ) {
-
-      if ( ! file_directory_exists(destination_dir)) {
-
-        if ( ! file_mkdir_parent(destination_dir) ) {
-
-          sprintf(l_msg, "ERROR: destination directory could not be created %s", destination_dir);
-          LOGGER(__FUNCTION__, l_msg);
-
-          result = RESULT_COULD_NOT_CREATE_DESTINATION_DIRECTORY;
-          goto END_FILE_RECEIVE_RESULT;
-
-        }
-      }
-    }
-  }
-  else {
-      
-    sprintf(l_msg, "ERROR: destination directory %s is invalid.", local_filename);
-    LOGGER(__FUNCTION__, l_msg);
-
-    result = RESULT_INVALID_DESTINATION_DIRECTORY;
-    goto END_FILE_RECEIVE_RESULT;
-  }
-
-  //
-  // Downloads response to a base64 file,then decodes and decompresses the file
-  //
-  {
-
-    char gzip_filename[256];
-    char b64_filename[256];
-    FILE * f = NULL;
-
-    sprintf(gzip_filename, "%s.gz", local_filename );
-    sprintf(b64_filename, "%s.b64", local_filename );
-
-    f = fopen(b64_filename, "w");
-    if (f != NULL) {
-      fwrite( content, sizeof(char), length, f );
-      fclose(f);
-
-      if ( base64_process_file('d', b64_filename, gzip_filename, incoming_message_len) == TRUE ) {
-  
-        if ( gz_unpack_file(gzip_filename, local_filename) == TRUE )
-        {      
-          remove(b64_filename);
-          remove(gzip_filename);
-        }
-        else {
-          snprintf(l_msg, _BUFFER_SIZE_S, "Error processing file (%s)", gzip_filename);
-          LOGGER(__FUNCTION__, l_msg);
-
-          result = RESULT_FILE_DECOMPRESS_ERROR;
-        }
-  
-      }
-      else {
-        snprintf(l_msg, _BUFFER_SIZE_S, "Error processing file (%s)", b64_filename);
-        LOGGER(__FUNCTION__, l_msg);
-
-        result = RESULT_FILE_DECODE_ERROR;
-      }
-
-    }
-    
   }
 
-END_FILE_RECEIVE_RESULT:
-
-  // Cleanup
-  if (response != NULL) {
-    free(response);
-  }
-  if (content != NULL) {
-    free(content);
-  }
+  free(response);
 
   return result;
 }
 
 /**
- * Completes a 'File Send' operation and returns the result
+ * Completes a 'File Delete' operation and returns the result
  *
- * @param incoming_message        received response message
- * @param incoming_message_len    received response message length
+ * @param incoming_message        mensaje de response recibido
+ * @param incoming_message_len    longitud del mensaje de response
  *
  * @return                        TRUE o FALSE
  */
-int client_get_file_send_response_result(char * incoming_message, int incoming_message_len) {
+int client_get_file_delete_response_result(char * incoming_message, int incoming_message_len) {
 
   const int NOT_FOUND = -1;
 
@@ -297,7 +186,7 @@ int client_get_file_send_response_result(char * incoming_message, int incoming_m
   search_result_res = string_search(response, PARAM_RESULT, HEADER_LEN);
 
   if (search_result_res == NOT_FOUND ) {
-    snprintf(l_msg, _BUFFER_SIZE_S, "ERROR: invalid response parameters [%s]", response);
+    snprintf(l_msg, _BUFFER_SIZE_S, "ERROR: invalid response parameters: [%s]", response);
     LOGGER(__FUNCTION__, l_msg);
     
     result = RESULT_INVALID_RESPONSE;
@@ -323,56 +212,77 @@ int client_get_file_send_response_result(char * incoming_message, int incoming_m
 }
 
 /**
- * Completes a 'File Delete' operation and returns the result
+ * Receives part of a response, waiting for data until the operation times out
  *
- * @param incoming_message        mensaje de response recibido
- * @param incoming_message_len    longitud del mensaje de response
+ * @param client                  client's data structure
+ * @param buffer                  buffer for the received data
+ * @param len                     maximum number of bytes to receive
+ * @param timeout                 time to wait for data
  *
- * @return                        TRUE o FALSE
+ * @return                        number of bytes received, or -1 if the
+ *                                connection failed or timed out
  */
-int client_get_file_delete_response_result(char * incoming_message, int incoming_message_len) {
+static int client_recv( quickft_client_t * client, char * buffer, int len, unsigned long timeout ) {
 
-  const int NOT_FOUND = -1;
+  int brecv;
+  unsigned long exec_timeout = GetTickCount() + timeout;
 
-  char l_msg[_BUFFER_SIZE_S];
+  while (1) {
 
-  int result = RESULT_UNDEFINED;
-  int search_result_res;
+    // Evaluates if timeout has been reached to cancel the operation
+    if (GetTickCount() > exec_timeout) {
 
-  char * response;
+      LOGGER(__FUNCTION__, "ERROR: Message transfer operation timed out.");
+      return -1;
+    }
 
-  // Moves response to a safe buffer for searching
-  response = (char*)malloc(sizeof(char) * incoming_message_len + 1);
-  memcpy(response, incoming_message, incoming_message_len);
-  response[incoming_message_len] = '\0';
+    if ( SOCKET_SELECT(S_TIMEOUT, client->connection, S_READ) == S_READ ) {
 
-  // Parses parameters
-  search_result_res = string_search(response, PARAM_RESULT, HEADER_LEN);
+      brecv = len;
+
+      // Attempts to receive message
+      if ( ! SOCKET_RECV(client->connection, &buffer, &brecv) ) {
+
+        LOGGER(__FUNCTION__, "ERROR: A connection error occurred while attempting to receive the message." );
+        client->disconnected = TRUE;
+        return -1;
+      }
+
+      if ( brecv > 0 ) {
+        return brecv;
+      }
+    }
 
-  if (search_result_res == NOT_FOUND ) {
-    snprintf(l_msg, _BUFFER_SIZE_S, "ERROR: invalid response parameters: [%s]", response);
-    LOGGER(__FUNCTION__, l_msg);
-    
-    result = RESULT_INVALID_RESPONSE;
-    
   }
-  else {
 
-    char * result_string; 
+}
 
-    result_string = (char*)malloc(sizeof(char) * (RESULT_VALUE_LEN + 1));
-    memcpy(result_string, &( response[ ( search_result_res + strlen(PARAM_RESULT) ) ] ), RESULT_VALUE_LEN );
-    result_string[RESULT_VALUE_LEN] = '\0';
+/**
+ * Receives an exact number of bytes of a response
+ *
+ * @param client                  client's data structure
+ * @param buffer                  buffer for the received data
+ * @param len                     number of bytes to receive
+ * @param timeout                 time to wait for each part of the data
+ *
+ * @return                        TRUE or FALSE
+ */
+static int client_recv_all( quickft_client_t * client, char * buffer, int len, unsigned long timeout ) {
 
-    result = message_result_string_to_code(result_string);
+  int total = 0;
+  int brecv;
 
-    free(result_string);
+  while ( total < len ) {
 
-  }
+    brecv = client_recv(client, &buffer[total], len - total, timeout);
+    if ( brecv < 0 ) {
+      return FALSE;
+    }
 
-  free(response);
+    total += brecv;
+  }
 
-  return result;
+  return TRUE;
 }
 
 /**
@@ -384,63 +294,185 @@ int client_get_file_delete_response_result(char * incoming_message, int incoming
  */
 int client_get_ack( quickft_client_t * client ) {
 
-  int brecv = 0;
-  int selectval = 0;
-  
-  char * recbuf = NULL;
-  unsigned long exec_timeout = 0;  
-  int result = RESULT_CONNECTION_ERROR;
-  
-  brecv = strlen(MESSAGE_ACK);
+  char ack[HEADER_LEN];
 
-  // Allocates initial space for message
-  recbuf = malloc(sizeof(char) * brecv);
+  // Receives exactly the ACK so that nothing that follows it is lost
+  if ( ! client_recv_all(client, ack, strlen(MESSAGE_ACK), client_timeout_ack) ) {
+    return RESULT_CONNECTION_ERROR;
+  }
 
-  // Updates time of next timeout
-  exec_timeout = GetTickCount() + client_timeout_ack;
+  if (memcmp(ack, MESSAGE_ACK, strlen(MESSAGE_ACK)) != 0) {
 
-  while (1) {
+    LOGGER(__FUNCTION__, "ERROR: The message is not a valid acknowledgment." );
+    return RESULT_INVALID_RESPONSE;
+  }
 
-    // Evaluates if timeout has been reached to cancel the operation
-    if (GetTickCount() > exec_timeout) {
+  return RESULT_SUCCESS;
+}
 
-      result = RESULT_CONNECTION_ERROR;
-      break;
-    }
+/**
+ * Receives a V2 message without content, either an ACK or a
+ * response, and gets the result it carries
+ *
+ * @param client                  client's data structure
+ * @param types                   binary addition of the expected message codes
+ * @param timeout                 time to wait for each part of the message
+ * @param message_type            returns the message code
+ * @param flags                   returns the flags of the message
+ * @param size                    returns the size parameter, if any,
+ *                                can be NULL
+ * @param codec                   returns the codec of the content that
+ *                                follows, gzip if not given, can be NULL
+ *
+ * @return                        RESULT_SUCCESS for an ACK, the result of a
+ *                                response, RESULT_VERSION_NOT_SUPPORTED for
+ *                                a V1 message, RESULT_CONNECTION_ERROR or
+ *                                RESULT_INVALID_RESPONSE
+ */
+static int client_get_message_v2( quickft_client_t * client, unsigned long types, unsigned long timeout, int * message_type, int * flags, long long * size, int * codec ) {
 
-    selectval = SOCKET_SELECT(S_TIMEOUT, client->connection, S_READ);          
-    if ( selectval == S_READ ) {
+  char l_msg[_BUFFER_SIZE_S];
+  char header[HEADER_LEN];
+  char params[REQUEST_PREFIX_MAX];
+  char result_string[RESULT_VALUE_LEN + 1];
 
-      // Attempts to receive message
-      if ( ! SOCKET_RECV(client->connection, &recbuf, &brecv) ) {
-    
-        // Produces error on fail
-        LOGGER(__FUNCTION__, "ERROR: A connection error occurred while attempting to receive the message." );
-        break;        
-      }
+  unsigned long params_len = 0;
+  const char * value;
+  int result;
 
-      if ( brecv > 0) {
+  if ( ! client_recv_all(client, header, HEADER_LEN, timeout) ) {
+    return RESULT_CONNECTION_ERROR;
+  }
 
-        unsigned int received = brecv;
-        if ( received == strlen(MESSAGE_ACK) ) {
+  // A server that answers with V1 messages does not support V2
+  if ( HEADER_VERSION( header ) == 1 ) {
+    return RESULT_VERSION_NOT_SUPPORTED;
+  }
 
-          if (memcmp(recbuf, MESSAGE_ACK, strlen(MESSAGE_ACK)) == 0) {
+  *message_type = IS_VALID_HEADER_V2( header, &params_len, flags, types );
+  if ( *message_type == 0x00 || params_len > REQUEST_PREFIX_MAX ) {
 
-            result = RESULT_SUCCESS;
-            break;
-          }
+    LOGGER(__FUNCTION__, "ERROR: The message does not have a valid header." );
+    return RESULT_INVALID_RESPONSE;
+  }
 
-        }
+  // Every message tells whether the server keeps the connection open and
+  // accepts pipelines, along with the request it answers within a pipeline
+  client->keep_alive = ( ( *flags & V2_FLAG_KEEP_ALIVE ) != 0 );
+  client->pipelining = ( ( *flags & V2_FLAG_PIPELINED ) != 0 );
+  client->request_id = message_v2_get_request_id(header);
 
-      }
+  if ( params_len > 0 && ! client_recv_all(client, params, params_len, gl_timeout) ) {
+    return RESULT_CONNECTION_ERROR;
+  }
+
+  if ( codec != NULL ) {
+    *codec = message_v2_get_codec(params, params_len);
+  }
+
+  if ( ! message_v2_get_offset(params, params_len, &client->offset) ) {
+    client->offset = -1;
+  }
+
+  client->block_size = message_v2_get_block(params, params_len);
+
+  // An ACK only carries the codec and the offset of the content the client sends
+  if ( *message_type == ACK_B ) {
+    return RESULT_SUCCESS;
+  }
+
+  // Finds mandatory 'result' parameter
+  if ( message_v2_get_param(params, params_len, TAG_RESULT, &value) != 4 ) {
+
+    LOGGER(__FUNCTION__, "ERROR: invalid response parameters.");
+    return RESULT_INVALID_RESPONSE;
+  }
+
+  result = (int)GET_UINT32(value);
+
+  // Nothing follows a response without content
+  client->complete = ( ( *flags & ( V2_FLAG_CHUNKED | V2_FLAG_RAW ) ) == 0 );
+
+  if ( size != NULL ) {
+    message_v2_get_size(params, params_len, size);
+  }
+
+  if ( message_v2_get_mode(params, params_len) >= 0 ) {
+
+    snprintf(l_msg, _BUFFER_SIZE_S, "Content is packed with the %s codec and the %s compression mode.",
+             codec_name(message_v2_get_codec(params, params_len)), gz_mode_name(message_v2_get_mode(params, params_len)));
+    LOGGER(__FUNCTION__, l_msg);
+  }
+
+  snprintf(l_msg, _BUFFER_SIZE_S, "Gets response from server... [%s]", message_result_code_to_string(result, result_string));
+  LOGGER(__FUNCTION__, l_msg);
+
+  return result;
+}
 
+/**
+ * Function for processing the answer to a V2 request the server either
+ * acknowledges or answers at once with its response
+ *
+ * @param client                  client's data structure
+ * @param type                    message code of the request
+ * @param codec                   returns the codec for the content the
+ *                                client sends, can be NULL
+ * @param message_type            returns ACK_B or the message code of the request
+ *
+ * @return                        RESULT_SUCCESS for an ACK, the result of the
+ *                                response, RESULT_VERSION_NOT_SUPPORTED if the
+ *                                server answered with V1 or dropped a new connection,
+ *                                RESULT_CONNECTION_ERROR or RESULT_INVALID_RESPONSE
+ */
+static int client_get_answer_v2( quickft_client_t * client, int type, int * codec, int * message_type ) {
+
+  int flags = 0;
+  int result;
+
+  *message_type = 0;
+
+  result = client_get_message_v2(client, ( type + ACK_B ), client_timeout_ack, message_type, &flags, NULL, codec);
+
+  // Servers that predate V2 may also just close the connection on its header,
+  // while one kept open after a previous request was closed for being idle
+  if ( result == RESULT_CONNECTION_ERROR && client->disconnected ) {
+
+    if ( client->requests > 0 ) {
+
+      client->stale = TRUE;
+      return RESULT_CONNECTION_ERROR;
     }
 
+    return RESULT_VERSION_NOT_SUPPORTED;
   }
-  
-  // Cleanup
-  if (recbuf != NULL) {
-    free(recbuf);
+
+  return result;
+}
+
+/**
+ * Function for processing the acknowledgment of a V2 request, which the
+ * server may replace with its response when it refuses the request
+ *
+ * @param client                  client's data structure
+ * @param type                    message code of the request
+ * @param codec                   returns the codec for the content the
+ *                                client sends, can be NULL
+ *
+ * @return                        RESULT_SUCCESS, the result of the refusal,
+ *                                RESULT_VERSION_NOT_SUPPORTED if the server
+ *                                answered with V1 or dropped a new connection,
+ *                                RESULT_CONNECTION_ERROR or RESULT_INVALID_RESPONSE
+ */
+static int client_get_ack_v2( quickft_client_t * client, int type, int * codec ) {
+
+  int message_type = 0;
+  int result;
+
+  result = client_get_answer_v2(client, type, codec, &message_type);
+
+  if ( result == RESULT_SUCCESS && message_type != ACK_B ) {
+    return RESULT_INVALID_RESPONSE;
   }
 
   return result;
@@ -616,578 +648,3593 @@ END_GET_RESPONSE:
 
 
 /**
- * Finds, compresses and encodes a file and generates content for a send file
- * operation message
+ * Prepares the directory of a file to receive
  *
- * @param local_filename        local name of the file being sent
- * @param content               pointer by reference to a non-allocated buffer to
- *                              store the content. Must be free()'d after usage. May return NULL.
- * @param content_len           reference to a variable to store the content length
+ * @param local_filename          local name of the file being received
  *
- * @return                      result type of operation
+ * @return                        result code
  */
-int client_generate_content_from_file(char * local_filename, char ** content, unsigned long * content_len) {
+static int client_prepare_destination( char * local_filename ) {
 
   char l_msg[_BUFFER_SIZE_S];
+  char destination_dir[2048];
 
-  int result = RESULT_UNDEFINED;
+  // Prepares directory
+  file_get_base_path(local_filename, destination_dir);
+  if (destination_dir != NULL)
+  {
+    // @HACK: checks if destination directory is not root
+    if (strcmp(destination_dir, ROOT_DIR) != 0 ) {
+
+      if ( ! file_directory_exists(destination_dir)) {
 
-  *content = NULL;
-  *content_len = 0;
+        if ( ! file_mkdir_parent(destination_dir) ) {
 
-  if ( ! file_exists(local_filename) ) 
-  {
-    LOGGER(__FUNCTION__, "No files were found in the directory for the specified mask.");
-    result = RESULT_FILE_NOT_FOUND;
+          snprintf(l_msg, _BUFFER_SIZE_S, "ERROR: destination directory could not be created %s", destination_dir);
+          LOGGER(__FUNCTION__, l_msg);
+
+          return RESULT_COULD_NOT_CREATE_DESTINATION_DIRECTORY;
+        }
+      }
+    }
   }
   else {
+      
+    snprintf(l_msg, _BUFFER_SIZE_S, "ERROR: destination directory %s is invalid.", local_filename);
+    LOGGER(__FUNCTION__, l_msg);
+
+    return RESULT_INVALID_DESTINATION_DIRECTORY;
+  }
+
+  return RESULT_SUCCESS;
+}
 
-    long long filesize = file_size(local_filename);
-    if (filesize > 0) 
-    {
-      char gzip_output[256];
-      char b64_output[256];
+/**
+ * Receives the content of a 'File Receive' response into an open file,
+ * unpacking it as it arrives, the file then replacing the local file once
+ * complete. The partial file of a resumable transfer is kept when the
+ * connection is lost, any other file is removed on failure.
+ *
+ * @param client                  client's data structure
+ * @param local_filename          local name of the file being received
+ * @param temp_filename           name of the file the content goes into
+ * @param fd                      descriptor of that file, closed on return
+ * @param resumable               TRUE for the partial file of a resumable transfer
+ * @param format                  CONTENT_ENCODED, CONTENT_ENCODED_CHUNKED,
+ *                                CONTENT_BINARY_CHUNKED or CONTENT_RAW
+ * @param codec                   codec of the content, CODEC_GZIP for V1
+ * @param received                content received along with the parameters
+ * @param received_len            length of the content already received
+ * @param pending_len             length of the content still to be received,
+ *                                0 when it is chunked
+ *
+ * @return                        result code
+ */
+static int client_receive_into( quickft_client_t * client, char * local_filename, char * temp_filename, int fd, int resumable, int format, int codec, const char * received, int received_len, long pending_len ) {
 
-      sprintf(gzip_output, "%s.gz", local_filename );
-      sprintf(b64_output, "%s.b64", local_filename );
+  char l_msg[_BUFFER_SIZE_S];
 
-      if ( gz_pack_file(local_filename, gzip_output) == TRUE )
-      {
-        LOGGER(__FUNCTION__, "Content to send succesfully packed.");
-        filesize = file_size(gzip_output);
+  char buffer[INGEST_CHUNK_SIZE];
+  char frame_len[SIZE_LEN + 1];
 
-        snprintf(l_msg, _BUFFER_SIZE_S, "Preparing to encode %lld bytes.", filesize);
-        LOGGER(__FUNCTION__, l_msg);
+  int result = RESULT_SUCCESS;
+  int brecv = 0;
+  int temp_created = TRUE;
 
-        if ( base64_process_file('e', gzip_output, b64_output, filesize) == TRUE )
-        {
-          unsigned long bytes_read;
-          char * buffer = NULL;
-          FILE * f = NULL;
+  PROCESS_INGEST_T ingest;
 
-          LOGGER(__FUNCTION__, "Content to send succesfully encoded.");
+  memset(&ingest, 0x00, sizeof(PROCESS_INGEST_T));
 
-          filesize = file_size(b64_output);          
-          buffer = (char*)malloc(sizeof(char) * filesize);
+  // The uncompressed content is moved straight into the file
+  if ( format == CONTENT_RAW ) {
 
-          f = fopen(b64_output, "r");
-          if (f != NULL)
-          {
-            bytes_read = fread(buffer, 1, filesize, f);
-              
-            snprintf(l_msg, _BUFFER_SIZE_S, "%lu bytes read from file %s to process and send.", bytes_read, b64_output);
-            LOGGER(__FUNCTION__, l_msg);
+    result = process_incoming_file_raw(client->connection, fd, pending_len);
+    if ( result != RESULT_SUCCESS ) {
 
-            fclose(f);
+      snprintf(l_msg, _BUFFER_SIZE_S, "Error receiving file (%s)", local_filename);
+      LOGGER(__FUNCTION__, l_msg);
+      goto END_RECEIVE_FILE;
+    }
 
-            // Copy results to the output params
-            *content = buffer;
-            *content_len = strlen(buffer);
+    goto END_RECEIVE_FILE_REPLACE;
+  }
 
-            result = RESULT_SUCCESS;
-              
-            // Deletes any temporary files generated
-            remove(gzip_output);
-            remove(b64_output);
+  if ( ! process_ingest_init(&ingest, fd, ( format != CONTENT_BINARY_CHUNKED ), codec) ) {
 
-          }
-          else {
-            snprintf(l_msg, _BUFFER_SIZE_S, "Error opening file (%s)", b64_output);
-            LOGGER(__FUNCTION__, l_msg);
+    result = RESULT_FILE_DECOMPRESS_ERROR;
+    goto END_RECEIVE_FILE;
+  }
 
-            result = RESULT_FILE_READ_ERROR;
-          }
-  
-        }
-        else {
-          snprintf(l_msg, _BUFFER_SIZE_S, "Error encoding file (%s)", gzip_output);
-          LOGGER(__FUNCTION__, l_msg);
+  // Content already received with the parameters
+  brecv = received_len;
+  if ( brecv > 0 ) {
+    memcpy(buffer, received, brecv);
+  }
 
-          result = RESULT_FILE_ENCODE_ERROR;
-        }
+  while ( TRUE ) {
+
+    if ( ! process_ingest(&ingest, buffer, brecv) ) {
+
+      snprintf(l_msg, _BUFFER_SIZE_S, "Error processing file (%s)", local_filename);
+      LOGGER(__FUNCTION__, l_msg);
+
+      result = RESULT_FILE_DECOMPRESS_ERROR;
+      goto END_RECEIVE_FILE;
+    }
+
+    // Gets the length of the next frame
+    if ( format == CONTENT_ENCODED_CHUNKED && pending_len == 0 ) {
 
+      if ( ! client_recv_all(client, frame_len, SIZE_LEN, gl_timeout) ) {
+
+        result = RESULT_CONNECTION_ERROR;
+        goto END_RECEIVE_FILE;
       }
-      else {
-        snprintf(l_msg, _BUFFER_SIZE_S, "Error packing file (%s)", local_filename);
-        LOGGER(__FUNCTION__, l_msg);
 
-        result = RESULT_FILE_COMPRESS_ERROR;
+      frame_len[SIZE_LEN] = '\0';
+      pending_len = strtol(frame_len, NULL, 16);
+    }
+    else if ( format == CONTENT_BINARY_CHUNKED && pending_len == 0 ) {
+
+      if ( ! client_recv_all(client, frame_len, V2_FRAME_LEN_SIZE, gl_timeout) ) {
+
+        result = RESULT_CONNECTION_ERROR;
+        goto END_RECEIVE_FILE;
       }
 
-    } else {
+      pending_len = GET_UINT32(frame_len);
+    }
 
-      snprintf(l_msg, _BUFFER_SIZE_S, "Content of the file is null (%s)", local_filename);
-      LOGGER(__FUNCTION__, l_msg);
+    if ( pending_len == 0 ) {
+      break;
+    }
+
+    brecv = client_recv(client, buffer, ( pending_len > INGEST_CHUNK_SIZE ) ? INGEST_CHUNK_SIZE : (int)pending_len, gl_timeout);
+    if ( brecv < 0 ) {
+
+      result = RESULT_CONNECTION_ERROR;
+      goto END_RECEIVE_FILE;
     }
 
+    pending_len -= brecv;
+  }
+
+  if ( ! process_ingest_end(&ingest) ) {
+
+    snprintf(l_msg, _BUFFER_SIZE_S, "Error processing file (%s)", local_filename);
+    LOGGER(__FUNCTION__, l_msg);
+
+    result = RESULT_FILE_DECOMPRESS_ERROR;
+    goto END_RECEIVE_FILE;
+  }
+
+END_RECEIVE_FILE_REPLACE:
+
+  if ( close(fd) != 0 ) {
+
+    fd = -1;
+    result = RESULT_FILE_WRITE_ERROR;
+    goto END_RECEIVE_FILE;
+  }
+  fd = -1;
+
+  if ( ! file_replace(temp_filename, local_filename, FALSE) ) {
+
+    result = RESULT_FILE_WRITE_ERROR;
+    goto END_RECEIVE_FILE;
+  }
+  temp_created = FALSE;
+
+END_RECEIVE_FILE:
+
+  // Cleanup
+  process_ingest_end(&ingest);
+
+  if (fd != -1) {
+
+    // What reached the partial file is kept for the next attempt
+    if (temp_created == TRUE && resumable == TRUE && result == RESULT_CONNECTION_ERROR) {
+      fdatasync(fd);
+    }
+    close(fd);
+  }
+  if (temp_created == TRUE && ! ( resumable == TRUE && result == RESULT_CONNECTION_ERROR )) {
+    remove(temp_filename);
   }
 
   return result;
 }
 
 /**
- * Performs a 'File Receive' operation for the client
+ * Receives the content of a 'File Receive' response, unpacking it into a
+ * temporary file as it arrives, which replaces the local file once complete
  *
+ * @param client                  client's data structure
+ * @param local_filename          local name of the file being received
+ * @param format                  CONTENT_ENCODED, CONTENT_ENCODED_CHUNKED,
+ *                                CONTENT_BINARY_CHUNKED or CONTENT_RAW
+ * @param codec                   codec of the content, CODEC_GZIP for V1
+ * @param received                content received along with the parameters
+ * @param received_len            length of the content already received
+ * @param pending_len             length of the content still to be received,
+ *                                0 when it is chunked
+ *
+ * @return                        result code
  */
-PyObject * client_file_receive( PyObject * self, PyObject * args ) {
+static int client_receive_file( quickft_client_t * client, char * local_filename, int format, int codec, const char * received, int received_len, long pending_len ) {
 
-  char l_msg[_BUFFER_SIZE_S];
+  char temp_filename[2048];
+  int result;
+  int fd;
 
-  char * request  = NULL;
-  char * response = NULL;
+  result = client_prepare_destination(local_filename);
+  if ( result != RESULT_SUCCESS ) {
+    return result;
+  }
 
-  unsigned long request_len;
-  unsigned long response_len; 
+  //
+  // Decodes and unpacks the content as it arrives into a temporary
+  // file, which replaces the local file once it is complete
+  //
+  fd = file_create_temp(local_filename, temp_filename, ( format == CONTENT_RAW ) ? pending_len : 0);
+  if ( fd == -1 ) {
+    return RESULT_FILE_WRITE_ERROR;
+  }
+
+  return client_receive_into(client, local_filename, temp_filename, fd, FALSE, format, codec, received, received_len, pending_len);
+}
+
+/**
+ * Receives the response to a 'File Receive' operation and completes it,
+ * decoding and unpacking the content into the local file as it arrives
+ *
+ * @param client                  client's data structure
+ * @param local_filename          local name of the file being received
+ *
+ * @return                        result code
+ */
+int client_get_file_receive_response_result(quickft_client_t * client, char * local_filename) {
+
+  const int NOT_FOUND = -1;
+
+  char l_msg[_BUFFER_SIZE_S];
+
+  char header[HEADER_LEN];
+  char response[REQUEST_PREFIX_MAX + 1];
 
-  int message_type = 0;
   int result = RESULT_UNDEFINED;
+  int message_type;
 
-  quickft_client_t * client;
+  int search_result_res = NOT_FOUND;
+  int search_chunked_res = NOT_FOUND;
+  int search_content_res = NOT_FOUND;
 
-  // Function parameters
-  char * remote_filename;
-  char * local_filename;
-  char * addr;
-  char * port; 
-  int timeout; 
-  int timeout_ack;
-  PyObject * py_log_writer;
-  
-  // Parses arguments
-  if (!PyArg_ParseTuple(args, "ssssiiO",&remote_filename, 
-                                        &local_filename, 
-                                        &addr, 
-                                        &port,
-                                        &timeout,
-                                        &timeout_ack,
-                                        &py_log_writer)) {
-    return Py_BuildValue("i", FALSE);
+  int response_len = 0;
+  int brecv = 0;
+  int chunked = FALSE;
+
+  long var_part_size = 0;
+  long pending_len = 0;
+
+  // Attempts to obtain an ACK
+  result = client_get_ack(client);
+  if (result != RESULT_SUCCESS) {
+    return result;
   }
-  
-  // Makes sure fourth argument is a function
-  if (!PyCallable_Check(py_log_writer)) {
-    PyErr_SetString(PyExc_TypeError, "Argument is not a function.");  
+
+  // Receives and validates the header
+  if ( ! client_recv_all(client, header, HEADER_LEN, gl_timeout) ) {
+    return RESULT_CONNECTION_ERROR;
   }
-  
-  // Stores the log writer function
-  gl_py_log_writer = py_log_writer;
-  
-  // Initializes the log
-  LOGGER_INIT;
-  
-  LOGGER(__FUNCTION__, "Begins a File Receive operation.");
 
-  if (addr == NULL) {
-    LOGGER(__FUNCTION__, "Server Addr can not be null");
-    return Py_BuildValue("i", result);
+  message_type = IS_VALID_HEADER( header, &var_part_size, ( FILE_SND_B + FILE_RCV_B + FILE_DEL_B ) );
+  if ( message_type != FILE_RCV_B || var_part_size == 0 ) {
+
+    sprintf(l_msg, "Message type [%02d] is invalid for expected response.", message_type);
+    LOGGER(__FUNCTION__, l_msg);
+
+    return RESULT_INVALID_RESPONSE;
   }
-  
-  // Initializes a client
-  if (port == NULL) {
-    client = client_initialize( addr, DEFAULT_PORT, timeout, timeout_ack );
+
+  //
+  // Receives the parameters that precede the content, together
+  // with the first fragment of the content
+  //
+  pending_len = var_part_size;
+
+  while ( search_content_res == NOT_FOUND && pending_len > 0 && response_len < REQUEST_PREFIX_MAX ) {
+
+    brecv = REQUEST_PREFIX_MAX - response_len;
+    if ( brecv > pending_len ) {
+      brecv = pending_len;
+    }
+
+    brecv = client_recv(client, &response[response_len], brecv, gl_timeout);
+    if ( brecv < 0 ) {
+      return RESULT_CONNECTION_ERROR;
+    }
+
+    pending_len -= brecv;
+    response_len += brecv;
+    response[response_len] = '\0';
+
+    search_content_res = string_search(response, PARAM_CONTENT, 0);
+  }
+
+  // Logs response parameters
+  LOGGER(__FUNCTION__, "Gets response from server...");
+  snprintf(l_msg, _BUFFER_SIZE_S, "%.*s%.*s", HEADER_LEN, header, ( search_content_res == NOT_FOUND ) ? response_len : search_content_res, response);
+  LOGGER(__FUNCTION__, l_msg);
+
+  // Finds mandatory 'result' parameter
+  search_result_res = string_search(response, PARAM_RESULT, 0);
+  if ( search_result_res == NOT_FOUND || search_result_res + strlen(PARAM_RESULT) + RESULT_VALUE_LEN > (size_t)response_len ) {
+
+    LOGGER(__FUNCTION__, "ERROR: invalid response parameters.");
+    return RESULT_INVALID_RESPONSE;
   }
   else {
-    client = client_initialize( addr, atoi(port), timeout, timeout_ack );
+
+    char result_string[RESULT_VALUE_LEN + 1];
+
+    memcpy(result_string, &( response[ ( search_result_res + strlen(PARAM_RESULT) ) ] ), RESULT_VALUE_LEN );
+    result_string[RESULT_VALUE_LEN] = '\0';
+
+    result = message_result_string_to_code(result_string);
+    if (result != RESULT_SUCCESS) {
+      return result;
+    }
   }
 
-  if (client == NULL) {
+  if ( search_content_res == NOT_FOUND ) {
 
-    LOGGER(__FUNCTION__, "Error on client initialization.");
-    return Py_BuildValue("i", result);
+    LOGGER(__FUNCTION__, "ERROR: invalid response parameters.");
+    return RESULT_INVALID_RESPONSE;
   }
 
-  // Generates request message
-  request = message_file_receive_request(strlen(remote_filename), remote_filename, &request_len);
+  // A chunked content follows the parameters as frames
+  search_chunked_res = string_search(response, PARAM_CHUNKED, 0);
+  chunked = ( search_chunked_res != NOT_FOUND && search_chunked_res < search_content_res );
 
-  // Sends the request
-  if ( process_outgoing_message(client->connection, request, request_len) == TRUE ) {
+  if ( chunked && pending_len > 0 ) {
 
-    message_type = client_get_response(client, &response, &response_len);
-    if ( message_type == FILE_RCV_B ) {
-      
-      if (response != NULL && response_len != 0) {
+    LOGGER(__FUNCTION__, "ERROR: invalid response parameters.");
+    return RESULT_INVALID_RESPONSE;
+  }
 
-        // Logs response
-        LOGGER(__FUNCTION__, "Gets response from server...");
-        if ( response_len >= _BUFFER_SIZE_S ) {
-          snprintf(l_msg, _BUFFER_SIZE_S, "%s", response);
-          l_msg[_BUFFER_SIZE_S - 1] = '\0';
-        }
-        else {
-          snprintf(l_msg, response_len, "%s", response);
-          l_msg[response_len] = '\0';
-        }
-        
-        LOGGER(__FUNCTION__, l_msg);
+  // Content already received with the parameters
+  brecv = response_len - ( search_content_res + strlen(PARAM_CONTENT) );
 
-        // Completes the operation and gets the result
-        result = client_get_file_receive_response_result(response, response_len, local_filename);
-      }
-      else {
+  return client_receive_file(client, local_filename, ( chunked ) ? CONTENT_ENCODED_CHUNKED : CONTENT_ENCODED, CODEC_GZIP,
+                             &response[search_content_res + strlen(PARAM_CONTENT)], brecv, pending_len);
+}
 
-        sprintf(l_msg, "Could not get a valid response from the QUICKFT server at %s:%s", addr, port);
-        LOGGER(__FUNCTION__, l_msg);
-        result = RESULT_CONNECTION_ERROR;
-      }
-      
-    }
-    else {
+/**
+ * Opens a file to be sent
+ *
+ * @param local_filename        local name of the file being sent
+ * @param fd                    returns the descriptor of the open file, or -1
+ * @param file_len              returns the file size
+ *
+ * @return                      result type of operation
+ */
+int client_open_content(char * local_filename, int * fd, long long * file_len) {
 
-      // If the response message type is not correct
-      if (message_type > 0) {
-        sprintf(l_msg, "Message type [%02d] is invalid for expected response.", message_type);
-        LOGGER(__FUNCTION__, l_msg);
+  char l_msg[_BUFFER_SIZE_S];
+
+  *fd = -1;
+  *file_len = 0;
+
+  if ( ! file_exists(local_filename) ) 
+  {
+    LOGGER(__FUNCTION__, "No files were found in the directory for the specified mask.");
+    return RESULT_FILE_NOT_FOUND;
+  }
+
+  *file_len = file_size(local_filename);
+  if (*file_len <= 0) {
+
+    snprintf(l_msg, _BUFFER_SIZE_S, "Content of the file is null (%s)", local_filename);
+    LOGGER(__FUNCTION__, l_msg);
+    return RESULT_UNDEFINED;
+  }
+
+  *fd = open(local_filename, O_RDONLY);
+  if (*fd == -1) {
+
+    snprintf(l_msg, _BUFFER_SIZE_S, "Error opening file (%s)", local_filename);
+    LOGGER(__FUNCTION__, l_msg);
+    return RESULT_FILE_READ_ERROR;
+  }
+
+  return RESULT_SUCCESS;
+}
+
+/**
+ * Connects a client to the server
+ *
+ * @param addr                                    server addr
+ * @param port                                    server port, can be NULL for default
+ * @param timeout                                 timeout for parts of the messages, can be 0 for default
+ * @param timeout_ack                             timeout for ack messages, can be 0 for default
+ * @return                                        pointer of type quickft_client_t or NULL
+ */
+quickft_client_t * client_connect( char * addr, char * port, long timeout, long timeout_ack ) {
+
+  if (port == NULL) {
+    return client_initialize( addr, DEFAULT_PORT, timeout, timeout_ack );
+  }
+
+  return client_initialize( addr, atoi(port), timeout, timeout_ack );
+}
+
+/**
+ * Opens the connection of a client again, closing the previous one
+ *
+ * @param client                  client's data structure
+ * @param addr                    server addr
+ * @param port                    server port, can be NULL for default
+ *
+ * @return                        TRUE or FALSE
+ */
+int client_reconnect( quickft_client_t * client, char * addr, char * port ) {
+
+  SOCKET_CLOSE( &client->connection );
+
+  client->connection = SOCKET_NEW_CLNT(addr, ( port == NULL ) ? DEFAULT_PORT : atoi(port));
+  client->disconnected = FALSE;
+  client->requests = 0;
+  client->keep_alive = FALSE;
+  client->complete = FALSE;
+  client->stale = FALSE;
+
+  return ( client->connection != NULL );
+}
+
+/**
+ * Prepares the client of a connection handle or a session for an
+ * operation, connecting it again if its connection was closed
+ *
+ * @param client                  client's data structure
+ * @param addr                    server addr
+ * @param port                    server port, can be NULL for default
+ *
+ * @return                        TRUE or FALSE
+ */
+int client_resume( quickft_client_t * client, char * addr, char * port ) {
+
+  if ( client->connection == NULL ) {
+
+    LOGGER(__FUNCTION__, "Connection was closed, connects again.");
+    return client_reconnect(client, addr, port);
+  }
+
+  client->disconnected = FALSE;
+  client->keep_alive = FALSE;
+  client->complete = FALSE;
+  client->stale = FALSE;
+
+  return TRUE;
+}
+
+/**
+ * Gets the client for an operation, the one of the connection handle
+ * given, connected again if its connection was closed, or a new one
+ *
+ * @param py_connection           connection handle, can be NULL or None
+ * @param addr                    server addr
+ * @param port                    server port, can be NULL for default
+ * @param timeout                 timeout for parts of the messages, can be 0 for default
+ * @param timeout_ack             timeout for ack messages, can be 0 for default
+ *
+ * @return                        pointer of type quickft_client_t or NULL
+ */
+static quickft_client_t * client_open( PyObject * py_connection, char * addr, char * port, long timeout, long timeout_ack ) {
+
+  quickft_client_t * client;
+
+  if ( py_connection == NULL || py_connection == Py_None ) {
+    return client_connect( addr, port, timeout, timeout_ack );
+  }
+
+  if ( ! PyCapsule_IsValid(py_connection, CLIENT_CONNECTION_NAME) ) {
+
+    LOGGER(__FUNCTION__, "Argument is not a connection handle.");
+    return NULL;
+  }
+
+  client = (quickft_client_t *)PyCapsule_GetPointer(py_connection, CLIENT_CONNECTION_NAME);
+
+  client_timeouts(timeout, timeout_ack);
+
+  return ( client_resume(client, addr, port) ) ? client : NULL;
+}
+
+/**
+ * Ends the operation of the client of a connection handle or a session.
+ * The connection is kept open when the server agreed to it and the exchange
+ * ended cleanly, otherwise it is closed and opened again by the next operation
+ *
+ * @param client                  client's data structure
+ *
+ * @return                        TRUE if the connection was kept open
+ */
+int client_release( quickft_client_t * client ) {
+
+  if ( client->keep_alive && client->complete && ! client->disconnected ) {
+
+    client->requests++;
+    return TRUE;
+  }
+
+  SOCKET_CLOSE( &client->connection );
+  return FALSE;
+}
+
+/**
+ * Ends the operation of a client, finalizing it unless it is
+ * the one of a connection handle
+ *
+ * @param client                  pointer by reference to the client
+ */
+static void client_close( quickft_client_t ** client ) {
+
+  if ( *client == NULL ) {
+    return;
+  }
+
+  if ( ! (*client)->persistent ) {
+
+    client_finalize(client);
+    return;
+  }
+
+  client_release(*client);
+
+  *client = NULL;
+}
+
+/**
+ * Evaluates if a server was found to only support V1 of the protocol, the
+ * last one that did is remembered so that it is not asked for V2 again
+ *
+ * @param addr                  server addr
+ * @param port                  server port, can be NULL for default
+ * @param remember              TRUE to remember the server as a V1 one
+ *
+ * @return                      TRUE if the server only supports V1
+ */
+static int client_v1_server( char * addr, char * port, int remember ) {
+
+  static char v1_server[_BUFFER_SIZE_XS];
+  char server[_BUFFER_SIZE_XS];
+
+  snprintf(server, _BUFFER_SIZE_XS, "%s:%s", addr, ( port == NULL ) ? DEFAULT_PORT_STR : port);
+
+  if (remember) {
+
+    LOGGER(__FUNCTION__, "Server does not support V2 of the protocol, falls back to V1.");
+    strcpy(v1_server, server);
+  }
+
+  return ( strcmp(v1_server, server) == 0 );
+}
+
+/**
+ * Gets the codec asked for by its name, gzip when none is
+ * given or the one named is unknown or not built in
+ *
+ * @param name                  codec name, can be NULL
+ *
+ * @return                      codec
+ */
+int client_codec( char * name ) {
+
+  char l_msg[_BUFFER_SIZE_S];
+  int codec;
+
+  if ( name == NULL ) {
+    return CODEC_GZIP;
+  }
+
+  codec = codec_by_name(name);
+  if ( codec < 0 || ! codec_available(codec) ) {
+
+    snprintf(l_msg, _BUFFER_SIZE_S, "Codec %s is not available, gzip is used instead.", name);
+    LOGGER(__FUNCTION__, l_msg);
+    return CODEC_GZIP;
+  }
+
+  return codec;
+}
+
+/**
+ * Gets the flags of a V2 request that ask for the connection to be kept
+ *
+ * @param client                  client's data structure
+ *
+ * @return                        V2_FLAG_KEEP_ALIVE for a connection handle
+ *                                or along a pipeline, otherwise 0
+ */
+static int client_keep_alive_flag( quickft_client_t * client ) {
+
+  return ( client->persistent || client->batch ) ? V2_FLAG_KEEP_ALIVE : 0;
+}
+
+/**
+ * Sends a V2 request. Failing to send it through a connection kept
+ * open after a previous request means that the server closed it
+ *
+ * @param client                  client's data structure
+ * @param request                 request message
+ * @param request_len             request message length
+ *
+ * @return                        TRUE or FALSE
+ */
+static int client_send_request( quickft_client_t * client, char * request, unsigned long request_len ) {
+
+  if ( process_outgoing_message(client->connection, request, request_len) == TRUE ) {
+    return TRUE;
+  }
+
+  client->stale = ( client->requests > 0 );
+  return FALSE;
+}
+
+/**
+ * Performs a 'File Receive' operation with V1 of the protocol
+ *
+ * @param client                  client's data structure
+ * @param remote_filename         name of the file in the server
+ * @param local_filename          local name of the file being received
+ * @param chunked                 TRUE to ask for a chunked response
+ *
+ * @return                        result code
+ */
+static int client_file_receive_v1( quickft_client_t * client, char * remote_filename, char * local_filename, int chunked ) {
+
+  char * request = NULL;
+  unsigned long request_len;
+  int result;
+
+  // Generates request message
+  request = message_file_receive_request(strlen(remote_filename), remote_filename, chunked, &request_len);
+
+  // Sends the request
+  if ( process_outgoing_message(client->connection, request, request_len) == TRUE ) {
+
+    // Receives the response and the file content as it arrives
+    result = client_get_file_receive_response_result(client, local_filename);
+  }
+  else {
+    LOGGER(__FUNCTION__, "An error occurred while trying to send the request.");
+    result = RESULT_CONNECTION_ERROR;
+  }
+
+  free(request);
+
+  return result;
+}
+
+/**
+ * Receives the content that follows a successful V2 'File Receive'
+ * response, as frames compressed with the codec it gives or as it is
+ *
+ * @param client                  client's data structure
+ * @param local_filename          local name of the file being received
+ * @param part_filename           name of the partial file of a resumable
+ *                                transfer, or NULL
+ * @param part_fd                 descriptor of the partial file, closed on
+ *                                return, or -1
+ * @param flags                   flags of the response
+ * @param size                    size parameter of the response, -1 if not given
+ * @param codec                   codec of the response
+ *
+ * @return                        result code
+ */
+static int client_receive_content_v2( quickft_client_t * client, char * local_filename, char * part_filename, int part_fd, int flags, long long size, int codec ) {
+
+  int format;
+  int result;
+
+  if ( flags & V2_FLAG_RAW && size >= 0 ) {
+    format = CONTENT_RAW;
+  }
+  else if ( flags & V2_FLAG_CHUNKED && codec_available(codec) ) {
+    format = CONTENT_BINARY_CHUNKED;
+    size = 0;
+  }
+  else {
+    format = -1;
+  }
+
+  if ( format == -1 ) {
+
+    if ( part_fd != -1 ) {
+      close(part_fd);
+    }
+    result = RESULT_INVALID_RESPONSE;
+  }
+  else if ( part_fd != -1 ) {
+    result = client_receive_into(client, local_filename, part_filename, part_fd, TRUE, format, ( format == CONTENT_RAW ) ? CODEC_GZIP : codec, NULL, 0, size);
+  }
+  else {
+    result = client_receive_file(client, local_filename, format, ( format == CONTENT_RAW ) ? CODEC_GZIP : codec, NULL, 0, size);
+  }
+
+  client->complete = ( result == RESULT_SUCCESS );
+
+  return result;
+}
+
+/**
+ * Performs a 'File Receive' operation with V2 of the protocol
+ *
+ * @param client                  client's data structure
+ * @param remote_filename         name of the file in the server
+ * @param local_filename          local name of the file being received
+ * @param raw                     TRUE to ask for the file uncompressed
+ * @param codec                   codec asked for the content, the server
+ *                                may answer with gzip instead
+ * @param transfer_id             ID of a resumable transfer, or NULL
+ *
+ * @return                        result code, RESULT_VERSION_NOT_SUPPORTED
+ *                                if the server only supports V1
+ */
+static int client_file_receive_v2( quickft_client_t * client, char * remote_filename, char * local_filename, int raw, int codec, char * transfer_id ) {
+
+  char l_msg[_BUFFER_SIZE_S];
+  char part_filename[2048];
+
+  char * request = NULL;
+  unsigned long request_len;
+  long long size = -1;
+  long long offset = -1;
+  unsigned long long hash = 0;
+  int message_type = 0;
+  int flags = 0;
+  int part_fd = -1;
+  int result;
+
+  // A resumable transfer receives the file into its partial file,
+  // asking for it from the length the partial file already has
+  if ( transfer_id != NULL ) {
+
+    result = client_prepare_destination(local_filename);
+    if ( result != RESULT_SUCCESS ) {
+      return result;
+    }
+
+    part_fd = file_open_part(local_filename, transfer_id, part_filename, -1, &offset);
+    if ( part_fd == -1 ) {
+      return RESULT_FILE_WRITE_ERROR;
+    }
+
+    // The server checks the content already received is still
+    // the beginning of the file before sending the rest
+    if ( ! file_content_hash(part_fd, offset, &hash) ) {
+
+      close(part_fd);
+      return RESULT_FILE_READ_ERROR;
+    }
+  }
+
+  request = message_v2_file_receive_request(remote_filename, ( ( raw ) ? V2_FLAG_RAW : 0 ) | client_keep_alive_flag(client), codec, offset, hash, &request_len);
+  if ( request == NULL ) {
+
+    if ( part_fd != -1 ) {
+      close(part_fd);
+    }
+    return RESULT_INVALID_REQUEST;
+  }
+
+  if ( client_send_request(client, request, request_len) == TRUE ) {
+
+    result = client_get_ack_v2(client, FILE_RCV_B, NULL);
+    if ( result == RESULT_SUCCESS ) {
+
+      // The content follows a successful response as frames
+      // compressed with the codec it gives, or as it is
+      result = client_get_message_v2(client, FILE_RCV_B, gl_timeout, &message_type, &flags, &size, &codec);
+      if ( result == RESULT_SUCCESS && part_fd != -1 ) {
+
+        // The server sends the file from its beginning when it is
+        // no longer as long as the partial file or has changed
+        if ( client->offset != offset ) {
+
+          offset = 0;
+          if ( ftruncate(part_fd, 0) != 0 || lseek(part_fd, 0, SEEK_SET) != 0 ) {
+            result = RESULT_FILE_WRITE_ERROR;
+          }
+        }
+
+        snprintf(l_msg, _BUFFER_SIZE_S, "Resumable transfer %s continues at offset %lld.", transfer_id, offset);
+        LOGGER(__FUNCTION__, l_msg);
+      }
+      if ( result == RESULT_SUCCESS ) {
+
+        result = client_receive_content_v2(client, local_filename, part_filename, part_fd, flags, size, codec);
+        part_fd = -1;
+      }
+    }
+  }
+  else {
+    LOGGER(__FUNCTION__, "An error occurred while trying to send the request.");
+    result = RESULT_CONNECTION_ERROR;
+  }
+
+  // The partial file is kept as long as the transfer can be resumed
+  if ( part_fd != -1 ) {
+
+    close(part_fd);
+    if ( result != RESULT_CONNECTION_ERROR ) {
+      remove(part_filename);
+    }
+  }
+
+  free(request);
+
+  return result;
+}
+
+/**
+ * Performs a 'File Receive' operation on a client, with V2 of the protocol
+ * unless the server only supports V1
+ *
+ * @param client                  client's data structure
+ * @param addr                    server addr
+ * @param port                    server port, can be NULL for default
+ * @param remote_filename         name of the file in the server
+ * @param local_filename          local name of the file being received
+ * @param chunked                 TRUE to ask a V1 server for a chunked response
+ * @param raw                     TRUE to ask for the file uncompressed
+ * @param codec                   codec asked for the content
+ * @param transfer_id             ID of a resumable transfer, or NULL
+ *
+ * @return                        result code
+ */
+int client_receive( quickft_client_t * client, char * addr, char * port, char * remote_filename, char * local_filename, int chunked, int raw, int codec, char * transfer_id ) {
+
+  char l_msg[_BUFFER_SIZE_S];
+  int result;
+
+  // Negotiates V2 of the protocol, connecting
+  // again for V1 if the server does not support it
+  result = RESULT_VERSION_NOT_SUPPORTED;
+
+  if ( ! client_v1_server(addr, port, FALSE) ) {
+
+    result = client_file_receive_v2(client, remote_filename, local_filename, raw, codec, transfer_id);
+
+    // A connection kept open that the server closed meanwhile is opened again
+    if ( client->stale && client_reconnect(client, addr, port) ) {
+      result = client_file_receive_v2(client, remote_filename, local_filename, raw, codec, transfer_id);
+    }
+
+    if ( result == RESULT_VERSION_NOT_SUPPORTED ) {
+
+      client_v1_server(addr, port, TRUE);
+      client_reconnect(client, addr, port);
+    }
+  }
+
+  if ( result == RESULT_VERSION_NOT_SUPPORTED ) {
+    
+    if (raw) {
+      LOGGER(__FUNCTION__, "Uncompressed transfers require V2 of the protocol, the file is received packed.");
+    }
+    if (codec != CODEC_GZIP) {
+      LOGGER(__FUNCTION__, "Codecs other than gzip require V2 of the protocol, the file is received with gzip.");
+    }
+    if (transfer_id != NULL) {
+      LOGGER(__FUNCTION__, "Resumable transfers require V2 of the protocol, the whole file is received.");
+    }
+
+    result = ( client->connection != NULL ) ? client_file_receive_v1(client, remote_filename, local_filename, chunked) : RESULT_CONNECTION_ERROR;
+  }
+
+  if ( result != RESULT_SUCCESS ) {
+
+    sprintf(l_msg, "File Receive operation failed with result [%d]", result);
+    LOGGER(__FUNCTION__, l_msg);
+  }
+
+  return result;
+}
+
+/**
+ * Performs a 'File Receive' operation for a byte range of a file with V2
+ * of the protocol, the range replacing the local file
+ *
+ * @param client                  client's data structure
+ * @param remote_filename         name of the file in the server
+ * @param local_filename          local name of the range being received
+ * @param offset                  offset the range starts at, counted from
+ *                                the end of the file when negative
+ * @param length                  length of the range, or -1 up to the end
+ * @param raw                     TRUE to ask for the range uncompressed
+ * @param codec                   codec asked for the content, the server
+ *                                may answer with gzip instead
+ *
+ * @return                        result code, RESULT_VERSION_NOT_SUPPORTED
+ *                                if the server only supports V1
+ */
+static int client_file_range_v2( quickft_client_t * client, char * remote_filename, char * local_filename, long long offset, long long length, int raw, int codec ) {
+
+  char l_msg[_BUFFER_SIZE_S];
+
+  char * request = NULL;
+  unsigned long request_len;
+  long long size = -1;
+  int message_type = 0;
+  int flags = 0;
+  int result;
+
+  request = message_v2_file_range_request(remote_filename, ( ( raw ) ? V2_FLAG_RAW : 0 ) | client_keep_alive_flag(client), codec, offset, length, &request_len);
+  if ( request == NULL ) {
+    return RESULT_INVALID_REQUEST;
+  }
+
+  if ( client_send_request(client, request, request_len) == TRUE ) {
+
+    result = client_get_ack_v2(client, FILE_RCV_B, NULL);
+    if ( result == RESULT_SUCCESS ) {
+
+      // The content of the range follows a successful response as frames
+      // compressed with the codec it gives, or as it is
+      result = client_get_message_v2(client, FILE_RCV_B, gl_timeout, &message_type, &flags, &size, &codec);
+      if ( result == RESULT_SUCCESS ) {
+
+        snprintf(l_msg, _BUFFER_SIZE_S, "Range of file %s is received from offset %lld.", remote_filename, client->offset);
+        LOGGER(__FUNCTION__, l_msg);
+
+        result = client_receive_content_v2(client, local_filename, NULL, -1, flags, size, codec);
+      }
+    }
+  }
+  else {
+    result = RESULT_CONNECTION_ERROR;
+  }
+
+  free(request);
+
+  return result;
+}
+
+/**
+ * Performs a 'File Receive' operation for a byte range of a file on a
+ * client, which requires V2 of the protocol
+ *
+ * @param client                  client's data structure
+ * @param addr                    server addr
+ * @param port                    server port, can be NULL for default
+ * @param remote_filename         name of the file in the server
+ * @param local_filename          local name of the range being received
+ * @param offset                  offset the range starts at, counted from
+ *                                the end of the file when negative
+ * @param length                  length of the range, or -1 up to the end
+ * @param raw                     TRUE to ask for the range uncompressed
+ * @param codec                   codec asked for the content
+ *
+ * @return                        result code
+ */
+int client_receive_range( quickft_client_t * client, char * addr, char * port, char * remote_filename, char * local_filename, long long offset, long long length, int raw, int codec ) {
+
+  char l_msg[_BUFFER_SIZE_S];
+  int result = RESULT_VERSION_NOT_SUPPORTED;
+
+  if ( ! client_v1_server(addr, port, FALSE) ) {
+
+    result = client_file_range_v2(client, remote_filename, local_filename, offset, length, raw, codec);
+
+    // A connection kept open that the server closed meanwhile is opened again
+    if ( client->stale && client_reconnect(client, addr, port) ) {
+      result = client_file_range_v2(client, remote_filename, local_filename, offset, length, raw, codec);
+    }
+
+    if ( result == RESULT_VERSION_NOT_SUPPORTED ) {
+
+      client_v1_server(addr, port, TRUE);
+      client_reconnect(client, addr, port);
+    }
+  }
+
+  if ( result == RESULT_VERSION_NOT_SUPPORTED ) {
+    LOGGER(__FUNCTION__, "Byte ranges require V2 of the protocol.");
+  }
+
+  if ( result != RESULT_SUCCESS ) {
+
+    sprintf(l_msg, "File Receive operation failed with result [%d]", result);
+    LOGGER(__FUNCTION__, l_msg);
+  }
+
+  return result;
+}
+
+/**
+ * Performs a 'File Receive' operation for the client
+ *
+ */
+PyObject * client_file_receive( PyObject * self, PyObject * args ) {
+
+  int result = RESULT_UNDEFINED;
+
+  quickft_client_t * client;
+
+  // Function parameters
+  char * remote_filename;
+  char * local_filename;
+  char * addr;
+  char * port; 
+  int timeout; 
+  int timeout_ack;
+  PyObject * py_log_writer;
+  int chunked = FALSE;
+  int raw = FALSE;
+  char * requested_codec = NULL;
+  PyObject * py_connection = NULL;
+  char * transfer_id = NULL;
+  int codec;
+  
+  // Parses arguments, a chunked response is optional
+  // as servers that predate it do not support it, and
+  // an uncompressed one, a codec other than gzip or
+  // resuming the transfer are only available with V2.
+  // The operation is performed on the connection handle
+  // if one is given
+  if (!PyArg_ParseTuple(args, "ssssiiO|iizOz",&remote_filename, 
+                                             &local_filename, 
+                                             &addr, 
+                                             &port,
+                                             &timeout,
+                                             &timeout_ack,
+                                             &py_log_writer,
+                                             &chunked,
+                                             &raw,
+                                             &requested_codec,
+                                             &py_connection,
+                                             &transfer_id)) {
+    return Py_BuildValue("i", FALSE);
+  }
+  
+  // Makes sure fourth argument is a function
+  if (!PyCallable_Check(py_log_writer)) {
+    PyErr_SetString(PyExc_TypeError, "Argument is not a function.");  
+  }
+  
+  // Stores the log writer function
+  gl_py_log_writer = py_log_writer;
+  
+  // Initializes the log
+  LOGGER_INIT;
+  
+  LOGGER(__FUNCTION__, "Begins a File Receive operation.");
+
+  codec = client_codec(requested_codec);
+
+  if (addr == NULL) {
+    LOGGER(__FUNCTION__, "Server Addr can not be null");
+    LOGGER_DEINIT;
+    return Py_BuildValue("i", result);
+  }
+  
+  // Initializes a client
+  client = client_open( py_connection, addr, port, timeout, timeout_ack );
+  if (client == NULL) {
+
+    LOGGER(__FUNCTION__, "Error on client initialization.");
+    LOGGER_DEINIT;
+    return Py_BuildValue("i", result);
+  }
+
+  result = client_receive(client, addr, port, remote_filename, local_filename, chunked, raw, codec, transfer_id);
+
+  // Finalizes the client data structure, or keeps the connection of the handle
+  client_close(&client);
+
+  LOGGER(__FUNCTION__, "Finalizes File Receive operation.");
+
+  // Finalizes the log
+  LOGGER_DEINIT;
+  
+  return Py_BuildValue("i", result);
+
+}
+
+/**
+ * Performs a 'File Receive' operation for a byte range of a file for the client
+ *
+ */
+PyObject * client_file_receive_range( PyObject * self, PyObject * args ) {
+
+  int result = RESULT_UNDEFINED;
+
+  quickft_client_t * client;
+
+  // Function parameters
+  char * remote_filename;
+  char * local_filename;
+  char * addr;
+  char * port; 
+  int timeout; 
+  int timeout_ack;
+  PyObject * py_log_writer;
+  PY_LONG_LONG offset;
+  PY_LONG_LONG length;
+  int raw = FALSE;
+  char * requested_codec = NULL;
+  PyObject * py_connection = NULL;
+
+  // Parses arguments, the range is given by its offset and length,
+  // receiving it uncompressed or with a codec other than gzip is
+  // optional. The operation is performed on the connection handle
+  // if one is given
+  if (!PyArg_ParseTuple(args, "ssssiiOLL|izO",&remote_filename, 
+                                             &local_filename, 
+                                             &addr, 
+                                             &port,
+                                             &timeout,
+                                             &timeout_ack,
+                                             &py_log_writer,
+                                             &offset,
+                                             &length,
+                                             &raw,
+                                             &requested_codec,
+                                             &py_connection)) {
+    return Py_BuildValue("i", FALSE);
+  }
+  
+  // Makes sure seventh argument is a function
+  if (!PyCallable_Check(py_log_writer)) {
+    PyErr_SetString(PyExc_TypeError, "Argument is not a function.");  
+  }
+  
+  // Stores the log writer function
+  gl_py_log_writer = py_log_writer;
+  
+  // Initializes the log
+  LOGGER_INIT;
+  
+  LOGGER(__FUNCTION__, "Begins a File Receive operation for a byte range.");
+
+  if (addr == NULL) {
+    LOGGER(__FUNCTION__, "Server Addr can not be null");
+    LOGGER_DEINIT;
+    return Py_BuildValue("i", result);
+  }
+  
+  // Initializes a client
+  client = client_open( py_connection, addr, port, timeout, timeout_ack );
+  if (client == NULL) {
+
+    LOGGER(__FUNCTION__, "Error on client initialization.");
+    LOGGER_DEINIT;
+    return Py_BuildValue("i", result);
+  }
+
+  result = client_receive_range(client, addr, port, remote_filename, local_filename, (long long)offset, (long long)length, raw, client_codec(requested_codec));
+
+  // Finalizes the client data structure, or keeps the connection of the handle
+  client_close(&client);
+
+  LOGGER(__FUNCTION__, "Finalizes File Receive operation.");
+
+  // Finalizes the log
+  LOGGER_DEINIT;
+  
+  return Py_BuildValue("i", result);
+
+}
+
+/**
+ * Performs a 'File Send' operation with V1 of the protocol
+ *
+ * @param client                  client's data structure
+ * @param remote_filename         filepath in destination
+ * @param local_filename          local name of the file being sent
+ * @param fd                      descriptor of the file being sent
+ * @param file_len                file size
+ *
+ * @return                        result code
+ */
+static int client_file_send_v1( quickft_client_t * client, char * remote_filename, char * local_filename, int fd, long long file_len ) {
+
+  char l_msg[_BUFFER_SIZE_S];
+
+  char * request  = NULL;
+  char * response = NULL;
+
+  unsigned long request_len;
+  unsigned long response_len;
+  unsigned long long sent_len;
+
+  int message_type = 0;
+  int result = RESULT_UNDEFINED;
+  int mode;
+
+  mode = gz_choose_mode(fd, local_filename);
+
+  snprintf(l_msg, _BUFFER_SIZE_S, "File is packed with the %s compression mode.", gz_mode_name(mode));
+  LOGGER(__FUNCTION__, l_msg);
+
+  // Generates request message without the content, which is chunked
+  // so that it is sent as it is deflated without measuring it first
+  request = message_file_send_request_prefix(remote_filename, 0, file_len, TRUE, &request_len);
+  if ( request == NULL ) {
+
+    snprintf(l_msg, _BUFFER_SIZE_S, "Request could not be generated for file (%s)", local_filename);
+    LOGGER(__FUNCTION__, l_msg);
+    return RESULT_FILE_READ_ERROR;
+  }
+
+  // Sends the message, deflating and encoding the file as it is read
+  if ( process_outgoing_data(client->connection, request, request_len) == TRUE &&
+       ( result = process_outgoing_file(client->connection, fd, CONTENT_ENCODED_CHUNKED, CODEC_GZIP, mode, &sent_len) ) == RESULT_SUCCESS ) {
+
+    message_type = client_get_response(client, &response, &response_len);
+    if ( message_type == FILE_SND_B ) {
+    
+      if (response != NULL  && response_len != 0) {
+
+        // Logs response
+        LOGGER(__FUNCTION__, "Gets response from server...");
+        if ( response_len >= _BUFFER_SIZE_S ) {
+          snprintf(l_msg, _BUFFER_SIZE_S, "%s", response);
+          l_msg[_BUFFER_SIZE_S - 1] = '\0';
+        }
+        else {
+          snprintf(l_msg, response_len, "%s", response);
+          l_msg[response_len] = '\0';
+        }
+      
+        LOGGER(__FUNCTION__, l_msg);
+
+        // Completes the operation and gets the result
+        result = client_get_file_send_response_result(response, response_len);
+      }
+      else {
+
+        LOGGER(__FUNCTION__, "Could not get a valid response from the QUICKFT server");
+        result = RESULT_CONNECTION_ERROR;
+      }
+    
+    }
+    else {
+
+      // If the response message type is not correct
+      if (message_type > 0) {
+        sprintf(l_msg, "Message type [%02d] is invalid for expected response.", message_type);
+        LOGGER(__FUNCTION__, l_msg);
+
+        result = RESULT_INVALID_RESPONSE;
+      }
+      // If an error occurred
+      else {
+        sprintf(l_msg, "An error ocurred when trying to read response [%d]", message_type);
+        LOGGER(__FUNCTION__, l_msg);
+
+        result = message_type;
+      }
+
+    }
+
+  }
+  else {
+    LOGGER(__FUNCTION__, "An error occurred while trying to send the request.");
+    if ( result == RESULT_SUCCESS ) {
+      result = RESULT_CONNECTION_ERROR;
+    }
+  }
+
+  // Frees allocated memory
+  free(request);
+  if (response != NULL) {
+    free(response);
+  }
+
+  return result;
+}
+
+/**
+ * Performs a 'File Send' operation with V2 of the protocol, the
+ * content is only sent once the server acknowledged the request
+ *
+ * @param client                  client's data structure
+ * @param remote_filename         filepath in destination
+ * @param local_filename          local name of the file being sent
+ * @param fd                      descriptor of the file being sent
+ * @param file_len                file size
+ * @param raw                     TRUE to send the file uncompressed
+ * @param codec                   codec asked for the content, the server
+ *                                may answer with gzip instead
+ * @param transfer_id             ID of a resumable transfer, or NULL
+ * @param hash                    hash of the content of a resumable transfer
+ * @param digest                  SHA-256 digest of the content, or NULL, the
+ *                                server answering at once when its content
+ *                                store already holds it
+ *
+ * @return                        result code, RESULT_VERSION_NOT_SUPPORTED
+ *                                if the server only supports V1
+ */
+static int client_file_send_v2( quickft_client_t * client, char * remote_filename, char * local_filename, int fd, long long file_len, int raw, int codec, char * transfer_id, unsigned long long hash, const unsigned char * digest ) {
+
+  char l_msg[_BUFFER_SIZE_S];
+
+  char * request = NULL;
+  unsigned long request_len;
+  unsigned long long sent_len;
+  long long offset = 0;
+  int answer_type = ACK_B;
+  int message_type = 0;
+  int flags = 0;
+  int mode = GZ_MODE_STORE;
+  int result;
+
+  // Files that would not shrink are sent as they are
+  if ( ! raw ) {
+
+    mode = gz_choose_mode(fd, local_filename);
+    raw = ( mode == GZ_MODE_STORE );
+  }
+
+  snprintf(l_msg, _BUFFER_SIZE_S, "File is packed with the %s compression mode.", gz_mode_name(mode));
+  LOGGER(__FUNCTION__, l_msg);
+
+  request = message_v2_file_send_request(remote_filename, file_len, ( ( raw ) ? V2_FLAG_RAW : V2_FLAG_CHUNKED ) | client_keep_alive_flag(client),
+                                         ( raw ) ? CODEC_GZIP : codec, ( raw ) ? -1 : mode, transfer_id, hash, digest, &request_len);
+  if ( request == NULL ) {
+    return RESULT_INVALID_REQUEST;
+  }
+
+  if ( client_send_request(client, request, request_len) == TRUE ) {
+
+    // The ACK gives the codec the server accepted for the frames, and for
+    // a resumable transfer the offset the server needs the file from. When
+    // the server already has the content its response comes instead
+    if ( digest != NULL ) {
+
+      result = client_get_answer_v2(client, FILE_SND_B, &codec, &answer_type);
+      if ( result == RESULT_SUCCESS && answer_type == FILE_SND_B ) {
+
+        LOGGER(__FUNCTION__, "The server already had the content, the file was made from its store.");
+
+        free(request);
+        return RESULT_SUCCESS;
+      }
+    }
+    else {
+      result = client_get_ack_v2(client, FILE_SND_B, &codec);
+    }
+    if ( result == RESULT_SUCCESS && ! raw && ! codec_available(codec) ) {
+      result = RESULT_INVALID_RESPONSE;
+    }
+    if ( result == RESULT_SUCCESS && transfer_id != NULL ) {
+
+      offset = client->offset;
+      if ( offset < 0 || offset > file_len ) {
+        result = RESULT_INVALID_RESPONSE;
+      }
+      else {
+
+        snprintf(l_msg, _BUFFER_SIZE_S, "Resumable transfer %s continues at offset %lld of %lld bytes.", transfer_id, offset, file_len);
+        LOGGER(__FUNCTION__, l_msg);
+      }
+    }
+    if ( result == RESULT_SUCCESS && lseek(fd, offset, SEEK_SET) != offset ) {
+      result = RESULT_FILE_READ_ERROR;
+    }
+    if ( result == RESULT_SUCCESS ) {
+
+      if ( ! raw ) {
+
+        snprintf(l_msg, _BUFFER_SIZE_S, "File is packed with the %s codec.", codec_name(codec));
+        LOGGER(__FUNCTION__, l_msg);
+      }
+
+      // Sends the content, as it is or packed as frames, and waits for the result
+      if ( raw ) {
+        result = process_outgoing_file_raw(client->connection, fd, file_len - offset);
+      }
+      else {
+        result = process_outgoing_file(client->connection, fd, CONTENT_BINARY_CHUNKED, codec, mode, &sent_len);
+      }
+      if ( result == RESULT_SUCCESS ) {
+        result = client_get_message_v2(client, FILE_SND_B, gl_timeout, &message_type, &flags, NULL, NULL);
+      }
+    }
+  }
+  else {
+    LOGGER(__FUNCTION__, "An error occurred while trying to send the request.");
+    result = RESULT_CONNECTION_ERROR;
+  }
+
+  free(request);
+
+  return result;
+}
+
+/**
+ * Performs a 'File Send' operation on a client, with V2 of the protocol
+ * unless the server only supports V1
+ *
+ * @param client                  client's data structure
+ * @param addr                    server addr
+ * @param port                    server port, can be NULL for default
+ * @param remote_filename         filepath in destination
+ * @param local_filename          local name of the file being sent
+ * @param raw                     TRUE to send the file uncompressed
+ * @param codec                   codec asked for the content
+ * @param transfer_id             ID of a resumable transfer, or NULL
+ * @param dedup                   TRUE to send the digest of the content first,
+ *                                so that nothing else is sent if the content
+ *                                store of the server already holds it
+ *
+ * @return                        result code
+ */
+int client_send( quickft_client_t * client, char * addr, char * port, char * remote_filename, char * local_filename, int raw, int codec, char * transfer_id, int dedup ) {
+
+  char l_msg[_BUFFER_SIZE_S];
+
+  unsigned char digest[SHA256_DIGEST_LEN];
+  int fd = -1;
+  long long file_len = 0;
+  unsigned long long hash = 0;
+
+  int result;
+
+  // Opens the file to send, the partial file of a resumable
+  // transfer in the server is also named after its content
+  result = client_open_content(local_filename, &fd, &file_len);
+  if ( result == RESULT_SUCCESS && transfer_id != NULL && ! file_content_hash(fd, -1, &hash) ) {
+    result = RESULT_FILE_READ_ERROR;
+  }
+  if ( result == RESULT_SUCCESS && dedup && ! sha256_file(fd, digest) ) {
+    result = RESULT_FILE_READ_ERROR;
+  }
+  if ( result == RESULT_SUCCESS ) {
+
+    // Negotiates V2 of the protocol, connecting
+    // again for V1 if the server does not support it
+    result = RESULT_VERSION_NOT_SUPPORTED;
+
+    if ( ! client_v1_server(addr, port, FALSE) ) {
+
+      result = client_file_send_v2(client, remote_filename, local_filename, fd, file_len, raw, codec, transfer_id, hash, ( dedup ) ? digest : NULL);
+
+      // A connection kept open that the server closed meanwhile is opened again
+      if ( client->stale && client_reconnect(client, addr, port) ) {
+        result = client_file_send_v2(client, remote_filename, local_filename, fd, file_len, raw, codec, transfer_id, hash, ( dedup ) ? digest : NULL);
+      }
+
+      if ( result == RESULT_VERSION_NOT_SUPPORTED ) {
+
+        client_v1_server(addr, port, TRUE);
+        client_reconnect(client, addr, port);
+      }
+    }
+
+    if ( result == RESULT_VERSION_NOT_SUPPORTED ) {
+
+      if (raw) {
+        LOGGER(__FUNCTION__, "Uncompressed transfers require V2 of the protocol, the file is sent packed.");
+      }
+      if (codec != CODEC_GZIP) {
+        LOGGER(__FUNCTION__, "Codecs other than gzip require V2 of the protocol, the file is sent with gzip.");
+      }
+      if (transfer_id != NULL) {
+        LOGGER(__FUNCTION__, "Resumable transfers require V2 of the protocol, the whole file is sent.");
+      }
+      if (dedup) {
+        LOGGER(__FUNCTION__, "Deduplicated transfers require V2 of the protocol, the whole file is sent.");
+      }
+
+      result = ( client->connection != NULL ) ? client_file_send_v1(client, remote_filename, local_filename, fd, file_len) : RESULT_CONNECTION_ERROR;
+    }
+
+    if ( result != RESULT_SUCCESS ) {
+
+      sprintf(l_msg, "File Send operation failed with result [%d]", result);
+      LOGGER(__FUNCTION__, l_msg);
+    }
+
+  }
+  else {
+    snprintf(l_msg, _BUFFER_SIZE_S, "An error occurred while trying to generate content from file [%s]", local_filename);
+    LOGGER(__FUNCTION__, l_msg);
+  }
+
+  // Frees allocated memory
+  if (fd != -1) {
+    close(fd);
+  }
+
+  return result;
+}
+
+/**
+ * Performs a 'File Send' operation for the client
+ *
+ */
+PyObject * client_file_send( PyObject * self, PyObject * args ) {
+
+  int result = RESULT_UNDEFINED;
+
+  quickft_client_t * client;
+
+  // Function parameters
+  char * remote_filename;
+  char * local_filename;
+  char * addr;
+  char * port; 
+  int timeout; 
+  int timeout_ack;
+  PyObject * py_log_writer;
+  int raw = FALSE;
+  char * requested_codec = NULL;
+  PyObject * py_connection = NULL;
+  char * transfer_id = NULL;
+  int dedup = FALSE;
+  int codec;
+  
+  // Parses arguments, sending the file uncompressed, with a codec
+  // other than gzip, as a resumable transfer or only its digest when
+  // the server already has its content is optional and only available
+  // with V2. The operation is performed on the connection handle if one is given
+  if (!PyArg_ParseTuple(args, "ssssiiO|izOzi",&remote_filename, 
+                                            &local_filename, 
+                                            &addr, 
+                                            &port,
+                                            &timeout,
+                                            &timeout_ack,
+                                            &py_log_writer,
+                                            &raw,
+                                            &requested_codec,
+                                            &py_connection,
+                                            &transfer_id,
+                                            &dedup)) {
+    return Py_BuildValue("i", FALSE);
+  }
+  
+  // Makes sure fourth argument is a function
+  if (!PyCallable_Check(py_log_writer)) {
+    PyErr_SetString(PyExc_TypeError, "Argument is not a function.");  
+  }
+  
+  // Stores the log writer function
+  gl_py_log_writer = py_log_writer;
+  
+  // Initializes the log
+  LOGGER_INIT;
+  
+  LOGGER(__FUNCTION__, "Begins a File Send operation.");
+
+  codec = client_codec(requested_codec);
+
+  if (addr == NULL) {
+    LOGGER(__FUNCTION__, "Server Addr can not be null");
+    LOGGER_DEINIT;
+    return Py_BuildValue("i", result);
+  }
+  
+  // Initializes a client
+  client = client_open( py_connection, addr, port, timeout, timeout_ack );
+  if (client == NULL) {
+
+    LOGGER(__FUNCTION__, "Error on client initialization.");
+    LOGGER_DEINIT;
+    return Py_BuildValue("i", result);
+  }
+
+  result = client_send(client, addr, port, remote_filename, local_filename, raw, codec, transfer_id, dedup);
+
+  // Finalizes the client data structure, or keeps the connection of the handle
+  client_close(&client);
+
+  LOGGER(__FUNCTION__, "Finalizes File Send operation.");
+
+  // Finalizes the log
+  LOGGER_DEINIT;
+  
+  return Py_BuildValue("i", result);
+
+}
+
+/**
+ * Prepares a client for the next request of an operation made of several,
+ * sent over the same connection when the server kept it open
+ *
+ * @param client                  client's data structure
+ * @param addr                    server addr
+ * @param port                    server port, can be NULL for default
+ *
+ * @return                        TRUE or FALSE
+ */
+static int client_continue( quickft_client_t * client, char * addr, char * port ) {
+
+  if ( client->keep_alive && client->complete && ! client->disconnected ) {
+
+    client->requests++;
+    client->complete = FALSE;
+    return TRUE;
+  }
+
+  return client_reconnect(client, addr, port);
+}
+
+/**
+ * Receives the signature of a file with V2 of the protocol, the server
+ * being asked to keep the connection open for the delta that follows
+ *
+ * @param client                  client's data structure
+ * @param remote_filename         name of the file in the server
+ * @param signature               returns the signature, must be free()d after usage
+ * @param signature_len           returns the length of the signature
+ * @param block_size              returns the block size of the signature
+ *
+ * @return                        result code, RESULT_VERSION_NOT_SUPPORTED
+ *                                if the server only supports V1
+ */
+static int client_file_signature_v2( quickft_client_t * client, char * remote_filename, unsigned char ** signature, unsigned long * signature_len, long * block_size ) {
+
+  char * request = NULL;
+  unsigned long request_len;
+  long long size = -1;
+  int message_type = 0;
+  int flags = 0;
+  int result;
+
+  *signature = NULL;
+
+  request = message_v2_file_signature_request(remote_filename, V2_FLAG_KEEP_ALIVE, 0, &request_len);
+  if ( request == NULL ) {
+    return RESULT_INVALID_REQUEST;
+  }
+
+  if ( client_send_request(client, request, request_len) == TRUE ) {
+
+    result = client_get_ack_v2(client, FILE_RCV_B, NULL);
+    if ( result == RESULT_SUCCESS ) {
+
+      // The signature follows a successful response as it is
+      result = client_get_message_v2(client, FILE_RCV_B, gl_timeout, &message_type, &flags, &size, NULL);
+    }
+    if ( result == RESULT_SUCCESS &&
+         ( ! ( flags & V2_FLAG_RAW ) || size < 0 || size > CLIENT_SIGNATURE_MAXIMUM_LEN || size % DELTA_SIGNATURE_ENTRY_LEN != 0 ||
+           client->block_size < DELTA_BLOCK_MINIMUM_SIZE || client->block_size > DELTA_BLOCK_MAXIMUM_SIZE ) ) {
+
+      LOGGER(__FUNCTION__, "ERROR: The signature is not valid.");
+      result = RESULT_INVALID_RESPONSE;
+    }
+    if ( result == RESULT_SUCCESS ) {
+
+      *signature = (unsigned char *)malloc((size_t)size + 1);
+      *signature_len = (unsigned long)size;
+      *block_size = client->block_size;
+
+      if ( ! client_recv_all(client, (char *)*signature, (int)size, gl_timeout) ) {
+        result = RESULT_CONNECTION_ERROR;
+      }
+      client->complete = ( result == RESULT_SUCCESS );
+    }
+  }
+  else {
+    result = RESULT_CONNECTION_ERROR;
+  }
+
+  if ( result != RESULT_SUCCESS && *signature != NULL ) {
+
+    free(*signature);
+    *signature = NULL;
+  }
+
+  free(request);
+
+  return result;
+}
+
+/**
+ * Sends the delta of a file with V2 of the protocol, packed as frames
+ *
+ * @param client                  client's data structure
+ * @param remote_filename         filepath in destination
+ * @param local_filename          local name of the file being sent
+ * @param delta_fd                descriptor of the file with the delta
+ * @param file_len                size of the file being sent
+ * @param block_size              block size of the signature the delta refers to
+ * @param digest                  SHA-256 digest of the file being sent
+ * @param codec                   codec asked for the content
+ *
+ * @return                        result code
+ */
+static int client_file_delta_v2( quickft_client_t * client, char * remote_filename, char * local_filename, int delta_fd, long long file_len, long block_size, const unsigned char * digest, int codec ) {
+
+  char * request = NULL;
+  unsigned long request_len;
+  unsigned long long sent_len;
+  int message_type = 0;
+  int flags = 0;
+  int mode;
+  int result;
+
+  // The data inserted comes from the file being sent, so the
+  // compression mode that suits it also suits the delta
+  mode = gz_choose_mode(delta_fd, local_filename);
+
+  request = message_v2_file_delta_request(remote_filename, file_len, client_keep_alive_flag(client), codec, mode, block_size, digest, &request_len);
+  if ( request == NULL ) {
+    return RESULT_INVALID_REQUEST;
+  }
+
+  if ( client_send_request(client, request, request_len) == TRUE ) {
+
+    result = client_get_ack_v2(client, FILE_SND_B, &codec);
+    if ( result == RESULT_SUCCESS && ! codec_available(codec) ) {
+      result = RESULT_INVALID_RESPONSE;
+    }
+    if ( result == RESULT_SUCCESS && lseek(delta_fd, 0, SEEK_SET) != 0 ) {
+      result = RESULT_FILE_READ_ERROR;
+    }
+    if ( result == RESULT_SUCCESS ) {
+
+      result = process_outgoing_file(client->connection, delta_fd, CONTENT_BINARY_CHUNKED, codec, mode, &sent_len);
+      if ( result == RESULT_SUCCESS ) {
+        result = client_get_message_v2(client, FILE_SND_B, gl_timeout, &message_type, &flags, NULL, NULL);
+      }
+    }
+  }
+  else {
+    result = RESULT_CONNECTION_ERROR;
+  }
+
+  free(request);
+
+  return result;
+}
+
+/**
+ * Performs a 'File Send' operation on a client that only sends a delta
+ * against the file the server already has, which requires V2 of the
+ * protocol, the file being sent whole when the server does not have it,
+ * when most of it changed or when the delta could not be applied
+ *
+ * @param client                  client's data structure
+ * @param addr                    server addr
+ * @param port                    server port, can be NULL for default
+ * @param remote_filename         filepath in destination
+ * @param local_filename          local name of the file being sent
+ * @param codec                   codec asked for the content
+ *
+ * @return                        result code
+ */
+int client_send_delta( quickft_client_t * client, char * addr, char * port, char * remote_filename, char * local_filename, int codec ) {
+
+  char l_msg[_BUFFER_SIZE_S];
+
+  unsigned char * signature = NULL;
+  unsigned long signature_len = 0;
+  unsigned char digest[SHA256_DIGEST_LEN];
+  long long file_len = 0;
+  long long literal_len = 0;
+  long block_size = 0;
+  FILE * delta = NULL;
+  int fd = -1;
+  int result;
+
+  if ( client_v1_server(addr, port, FALSE) ) {
+
+    LOGGER(__FUNCTION__, "Deltas require V2 of the protocol, the whole file is sent.");
+    return client_send(client, addr, port, remote_filename, local_filename, FALSE, codec, NULL, FALSE);
+  }
+
+  result = client_open_content(local_filename, &fd, &file_len);
+  if ( result == RESULT_SUCCESS && ! sha256_file(fd, digest) ) {
+    result = RESULT_FILE_READ_ERROR;
+  }
+  if ( result != RESULT_SUCCESS ) {
+
+    snprintf(l_msg, _BUFFER_SIZE_S, "An error occurred while trying to generate content from file [%s]", local_filename);
+    LOGGER(__FUNCTION__, l_msg);
+
+    if ( fd != -1 ) {
+      close(fd);
+    }
+    return result;
+  }
+
+  result = client_file_signature_v2(client, remote_filename, &signature, &signature_len, &block_size);
+
+  // A connection kept open that the server closed meanwhile is opened again
+  if ( client->stale && client_reconnect(client, addr, port) ) {
+    result = client_file_signature_v2(client, remote_filename, &signature, &signature_len, &block_size);
+  }
+
+  if ( result == RESULT_VERSION_NOT_SUPPORTED ) {
+
+    client_v1_server(addr, port, TRUE);
+    client_reconnect(client, addr, port);
+    goto END_CLIENT_SEND_DELTA;
+  }
+  if ( result != RESULT_SUCCESS ) {
+
+    LOGGER(__FUNCTION__, "No signature of the file in the server, the whole file is sent.");
+    goto END_CLIENT_SEND_DELTA;
+  }
+
+  // Finds the blocks of the file in the server within the file being sent
+  delta = tmpfile();
+  if ( delta == NULL || ! delta_generate(fd, file_len, signature, signature_len, block_size, delta, &literal_len) ) {
+
+    LOGGER(__FUNCTION__, "ERROR: The delta could not be generated, the whole file is sent.");
+    result = RESULT_FILE_READ_ERROR;
+    goto END_CLIENT_SEND_DELTA;
+  }
+
+  snprintf(l_msg, _BUFFER_SIZE_S, "Delta against %lu blocks of %ld bytes inserts %lld of %lld bytes.",
+           signature_len / DELTA_SIGNATURE_ENTRY_LEN, block_size, literal_len, file_len);
+  LOGGER(__FUNCTION__, l_msg);
+
+  if ( literal_len * 100 > file_len * CLIENT_DELTA_LITERAL_PERCENT ) {
+
+    LOGGER(__FUNCTION__, "Most of the file changed, the whole file is sent.");
+    result = RESULT_UNDEFINED;
+    goto END_CLIENT_SEND_DELTA;
+  }
+
+  result = ( client_continue(client, addr, port) ) ? RESULT_SUCCESS : RESULT_CONNECTION_ERROR;
+  if ( result == RESULT_SUCCESS ) {
+    result = client_file_delta_v2(client, remote_filename, local_filename, fileno(delta), file_len, block_size, digest, codec);
+  }
+
+  if ( result != RESULT_SUCCESS ) {
+
+    snprintf(l_msg, _BUFFER_SIZE_S, "Delta could not be applied, result [%d], the whole file is sent.", result);
+    LOGGER(__FUNCTION__, l_msg);
+  }
+
+END_CLIENT_SEND_DELTA:
+
+  close(fd);
+
+  if ( delta != NULL ) {
+    fclose(delta);
+  }
+  if ( signature != NULL ) {
+    free(signature);
+  }
+
+  // Any failure other than a lost connection falls back to the whole file
+  if ( result != RESULT_SUCCESS && result != RESULT_CONNECTION_ERROR ) {
+
+    if ( client_continue(client, addr, port) ) {
+      result = client_send(client, addr, port, remote_filename, local_filename, FALSE, codec, NULL, FALSE);
+    }
+    else {
+      result = RESULT_CONNECTION_ERROR;
+    }
+  }
+
+  return result;
+}
+
+/**
+ * Performs a 'File Send' operation of a delta for the client
+ *
+ */
+PyObject * client_file_send_delta( PyObject * self, PyObject * args ) {
+
+  int result = RESULT_UNDEFINED;
+
+  quickft_client_t * client;
+
+  // Function parameters
+  char * remote_filename;
+  char * local_filename;
+  char * addr;
+  char * port; 
+  int timeout; 
+  int timeout_ack;
+  PyObject * py_log_writer;
+  char * requested_codec = NULL;
+  PyObject * py_connection = NULL;
+  
+  // Parses arguments, a codec other than gzip is optional and
+  // the operation is performed on the connection handle if one is given
+  if (!PyArg_ParseTuple(args, "ssssiiO|zO",&remote_filename, 
+                                          &local_filename, 
+                                          &addr, 
+                                          &port,
+                                          &timeout,
+                                          &timeout_ack,
+                                          &py_log_writer,
+                                          &requested_codec,
+                                          &py_connection)) {
+    return Py_BuildValue("i", FALSE);
+  }
+  
+  // Makes sure seventh argument is a function
+  if (!PyCallable_Check(py_log_writer)) {
+    PyErr_SetString(PyExc_TypeError, "Argument is not a function.");  
+  }
+  
+  // Stores the log writer function
+  gl_py_log_writer = py_log_writer;
+  
+  // Initializes the log
+  LOGGER_INIT;
+  
+  LOGGER(__FUNCTION__, "Begins a delta File Send operation.");
+
+  if (addr == NULL) {
+    LOGGER(__FUNCTION__, "Server Addr can not be null");
+    LOGGER_DEINIT;
+    return Py_BuildValue("i", result);
+  }
+  
+  // Initializes a client
+  client = client_open( py_connection, addr, port, timeout, timeout_ack );
+  if (client == NULL) {
+
+    LOGGER(__FUNCTION__, "Error on client initialization.");
+    LOGGER_DEINIT;
+    return Py_BuildValue("i", result);
+  }
+
+  result = client_send_delta(client, addr, port, remote_filename, local_filename, client_codec(requested_codec));
+
+  // Finalizes the client data structure, or keeps the connection of the handle
+  client_close(&client);
+
+  LOGGER(__FUNCTION__, "Finalizes delta File Send operation.");
+
+  // Finalizes the log
+  LOGGER_DEINIT;
+  
+  return Py_BuildValue("i", result);
+
+}
+
+/**
+ * Sends a range of a striped transfer with V2 of the protocol, the
+ * content is only sent once the server acknowledged the request
+ *
+ * @param client                  client's data structure
+ * @param stripes                 striped transfer
+ * @param fd                      descriptor of the file being sent
+ * @param index                   index of the range
+ *
+ * @return                        result code
+ */
+static int client_stripe_send_v2( quickft_client_t * client, CLIENT_STRIPES_T * stripes, int fd, int index ) {
+
+  char * request = NULL;
+  unsigned long request_len;
+  unsigned long long sent_len;
+  long long offset = stripes->stripe_size * index;
+  long long length = stripes->stripe_size;
+  int codec = stripes->codec;
+  int message_type = 0;
+  int flags = 0;
+  int result;
+
+  if ( length > stripes->file_len - offset ) {
+    length = stripes->file_len - offset;
+  }
+
+  request = message_v2_file_stripe_request(stripes->remote_filename, stripes->file_len,
+                                           ( ( stripes->raw ) ? V2_FLAG_RAW : V2_FLAG_CHUNKED ) | client_keep_alive_flag(client),
+                                           ( stripes->raw ) ? CODEC_GZIP : codec, ( stripes->raw ) ? -1 : stripes->mode,
+                                           stripes->stripe, offset, length, &request_len);
+  if ( request == NULL ) {
+    return RESULT_INVALID_REQUEST;
+  }
+
+  if ( client_send_request(client, request, request_len) == TRUE ) {
+
+    // The ACK gives the codec the server accepted for the frames
+    result = client_get_ack_v2(client, FILE_SND_B, &codec);
+    if ( result == RESULT_SUCCESS && ! stripes->raw && ! codec_available(codec) ) {
+      result = RESULT_INVALID_RESPONSE;
+    }
+    if ( result == RESULT_SUCCESS && lseek(fd, offset, SEEK_SET) != offset ) {
+      result = RESULT_FILE_READ_ERROR;
+    }
+    if ( result == RESULT_SUCCESS ) {
+
+      // Sends the range, as it is or packed as frames, and waits for the result
+      if ( stripes->raw ) {
+        result = process_outgoing_file_raw(client->connection, fd, length);
+      }
+      else {
+        result = process_outgoing_file_range(client->connection, fd, length, CONTENT_BINARY_CHUNKED, codec, stripes->mode, &sent_len);
+      }
+      if ( result == RESULT_SUCCESS ) {
+        result = client_get_message_v2(client, FILE_SND_B, gl_timeout, &message_type, &flags, NULL, NULL);
+      }
+    }
+  }
+  else {
+    result = RESULT_CONNECTION_ERROR;
+  }
+
+  free(request);
+
+  return result;
+}
+
+/**
+ * Thread function that sends ranges of a striped transfer over its own
+ * connection, kept open between them, until none is left or one failed
+ *
+ * @param arg                     striped transfer
+ */
+static void * client_stripe_sender( void * arg ) {
+
+  CLIENT_STRIPES_T * stripes = (CLIENT_STRIPES_T *)arg;
+  quickft_client_t * client;
+  char l_msg[_BUFFER_SIZE_S];
+  int result = RESULT_SUCCESS;
+  int index;
+  int fd;
+
+  client = client_connect(stripes->addr, stripes->port, gl_timeout, client_timeout_ack);
+  fd = open(stripes->local_filename, O_RDONLY);
+
+  if ( client == NULL ) {
+    result = RESULT_CONNECTION_ERROR;
+  }
+  else if ( fd == -1 ) {
+    result = RESULT_FILE_READ_ERROR;
+  }
+  else {
+    client->batch = TRUE;
+  }
+
+  while ( result == RESULT_SUCCESS ) {
+
+    pthread_mutex_lock(&stripes->mutex);
+    index = ( stripes->result == RESULT_SUCCESS ) ? stripes->next++ : stripes->count;
+    pthread_mutex_unlock(&stripes->mutex);
+
+    if ( index >= stripes->count ) {
+      break;
+    }
+
+    if ( ! client_resume(client, stripes->addr, stripes->port) ) {
+
+      result = RESULT_CONNECTION_ERROR;
+      break;
+    }
+
+    result = client_stripe_send_v2(client, stripes, fd, index);
+
+    // A connection kept open that the server closed meanwhile is opened again
+    if ( client->stale && client_reconnect(client, stripes->addr, stripes->port) ) {
+      result = client_stripe_send_v2(client, stripes, fd, index);
+    }
+
+    client->complete = ( result == RESULT_SUCCESS );
+    client_release(client);
+
+    if ( result != RESULT_SUCCESS ) {
+
+      snprintf(l_msg, _BUFFER_SIZE_S, "ERROR: Range %d of striped transfer %s failed with result [%d]", index, stripes->stripe, result);
+      LOGGER(__FUNCTION__, l_msg);
+    }
+  }
+
+  if ( result != RESULT_SUCCESS ) {
+
+    pthread_mutex_lock(&stripes->mutex);
+    if ( stripes->result == RESULT_SUCCESS ) {
+      stripes->result = result;
+    }
+    pthread_mutex_unlock(&stripes->mutex);
+  }
+
+  if ( fd != -1 ) {
+    close(fd);
+  }
+  if ( client != NULL ) {
+    client_finalize(&client);
+  }
+
+  return NULL;
+}
+
+/**
+ * Commits a striped transfer with V2 of the protocol once
+ * all its ranges were sent, so that the file replaces the target
+ *
+ * @param client                  client's data structure
+ * @param stripes                 striped transfer
+ *
+ * @return                        result code
+ */
+static int client_stripe_commit_v2( quickft_client_t * client, CLIENT_STRIPES_T * stripes ) {
+
+  char * request = NULL;
+  unsigned long request_len;
+  int message_type = 0;
+  int flags = 0;
+  int result;
+
+  request = message_v2_file_stripe_commit_request(stripes->remote_filename, stripes->file_len, client_keep_alive_flag(client), stripes->stripe, &request_len);
+  if ( request == NULL ) {
+    return RESULT_INVALID_REQUEST;
+  }
+
+  // No content follows the request, so the server answers it right away
+  if ( client_send_request(client, request, request_len) == TRUE ) {
+    result = client_get_message_v2(client, FILE_SND_B, client_timeout_ack, &message_type, &flags, NULL, NULL);
+  }
+  else {
+    result = RESULT_CONNECTION_ERROR;
+  }
+
+  client->complete = ( result == RESULT_SUCCESS );
+
+  free(request);
+
+  return result;
+}
+
+/**
+ * Performs a 'File Send' operation on a client splitting the file into
+ * ranges sent over several connections at once, which requires V2 of the
+ * protocol, the file being sent whole on the client otherwise
+ *
+ * @param client                  client's data structure
+ * @param addr                    server addr
+ * @param port                    server port, can be NULL for default
+ * @param remote_filename         filepath in destination
+ * @param local_filename          local name of the file being sent
+ * @param raw                     TRUE to send the file uncompressed
+ * @param codec                   codec asked for the content
+ * @param stripes                 number of connections
+ * @param stripe_size             length of the ranges, or 0 to split the
+ *                                file evenly between the connections
+ *
+ * @return                        result code
+ */
+int client_send_striped( quickft_client_t * client, char * addr, char * port, char * remote_filename, char * local_filename, int raw, int codec, int stripes, long long stripe_size ) {
+
+  char l_msg[_BUFFER_SIZE_S];
+  char stripe[TRANSFER_ID_MAXIMUM_LEN + 1];
+  unsigned long long hash;
+
+  CLIENT_STRIPES_T transfer;
+  thread_t senders[CLIENT_STRIPES_MAX];
+  thread_t * sender;
+  int started = 0;
+  int fd = -1;
+  long long file_len = 0;
+  int result;
+
+  result = client_open_content(local_filename, &fd, &file_len);
+  if ( result != RESULT_SUCCESS ) {
+    return result;
+  }
+
+  // The ranges are as long as asked for, or split the file evenly,
+  // and are never so short that a connection is not worth opening
+  if ( stripes > CLIENT_STRIPES_MAX ) {
+    stripes = CLIENT_STRIPES_MAX;
+  }
+  if ( stripe_size <= 0 && stripes > 0 ) {
+    stripe_size = ( file_len + stripes - 1 ) / stripes;
+  }
+  if ( stripe_size < CLIENT_STRIPE_MINIMUM_SIZE ) {
+    stripe_size = CLIENT_STRIPE_MINIMUM_SIZE;
+  }
+
+  memset(&transfer, 0x00, sizeof(CLIENT_STRIPES_T));
+  transfer.count = (int)( ( file_len + stripe_size - 1 ) / stripe_size );
+
+  if ( stripes > transfer.count ) {
+    stripes = transfer.count;
+  }
+
+  // A file that makes a single range, or a server that only supports V1,
+  // gets the file whole over the connection of the client
+  if ( stripes <= 1 || client_v1_server(addr, port, FALSE) ) {
+
+    close(fd);
+    return client_send(client, addr, port, remote_filename, local_filename, raw, codec, NULL, FALSE);
+  }
+
+  // Files that would not shrink are sent as they are
+  transfer.mode = ( raw ) ? GZ_MODE_STORE : gz_choose_mode(fd, local_filename);
+
+  // The transfer is named after the content, so that sending the file
+  // again after a failure reuses what the server kept of it
+  if ( ! file_content_hash(fd, -1, &hash) ) {
+
+    sprintf(l_msg, "ERROR: Unable to hash file %s.", local_filename);
+    LOGGER(__FUNCTION__, l_msg);
+
+    close(fd);
+    return RESULT_FILE_READ_ERROR;
+  }
+  close(fd);
+
+  sprintf(stripe, "%llx-%llx", (unsigned long long)file_len, hash);
+
+  transfer.addr = addr;
+  transfer.port = port;
+  transfer.remote_filename = remote_filename;
+  transfer.local_filename = local_filename;
+  transfer.stripe = stripe;
+  transfer.file_len = file_len;
+  transfer.stripe_size = stripe_size;
+  transfer.raw = ( transfer.mode == GZ_MODE_STORE );
+  transfer.codec = codec;
+  transfer.result = RESULT_SUCCESS;
+
+  snprintf(l_msg, _BUFFER_SIZE_S, "Striped transfer %s sends %d ranges of %lld bytes over %d connections, packed with the %s compression mode.",
+           stripe, transfer.count, stripe_size, stripes, gz_mode_name(transfer.mode));
+  LOGGER(__FUNCTION__, l_msg);
+
+  pthread_mutex_init(&transfer.mutex, NULL);
+
+  for ( started = 0; started < stripes; started++ ) {
+
+    sender = &senders[started];
+    if ( THREAD_CREATE(&sender, &client_stripe_sender, (void *)&transfer) != 0 ) {
+
+      LOGGER(__FUNCTION__, "ERROR: A thread that sends ranges could not be started.");
+      break;
+    }
+  }
+
+  // The ranges left are sent by the threads that did start
+  if ( started == 0 ) {
+    transfer.result = RESULT_UNDEFINED;
+  }
+
+  while ( started > 0 ) {
+
+    sender = &senders[--started];
+    THREAD_JOIN(sender, FALSE);
+  }
+
+  pthread_mutex_destroy(&transfer.mutex);
+
+  // The file replaces the target once all the ranges were sent
+  result = transfer.result;
+  if ( result == RESULT_SUCCESS ) {
+
+    result = client_stripe_commit_v2(client, &transfer);
+
+    // A connection kept open that the server closed meanwhile is opened again
+    if ( client->stale && client_reconnect(client, addr, port) ) {
+      result = client_stripe_commit_v2(client, &transfer);
+    }
+  }
+
+  if ( result != RESULT_SUCCESS ) {
+
+    sprintf(l_msg, "Striped File Send operation failed with result [%d]", result);
+    LOGGER(__FUNCTION__, l_msg);
+  }
+
+  return result;
+}
+
+/**
+ * Performs a striped 'File Send' operation for the client
+ *
+ */
+PyObject * client_file_send_striped( PyObject * self, PyObject * args ) {
+
+  int result = RESULT_UNDEFINED;
+
+  quickft_client_t * client;
+
+  // Function parameters
+  char * remote_filename;
+  char * local_filename;
+  char * addr;
+  char * port; 
+  int timeout; 
+  int timeout_ack;
+  PyObject * py_log_writer;
+  int stripes;
+  PY_LONG_LONG stripe_size = 0;
+  int raw = FALSE;
+  char * requested_codec = NULL;
+  PyObject * py_connection = NULL;
+  
+  // Parses arguments, the number of connections is required while the
+  // length of the ranges, sending the file uncompressed or with a codec
+  // other than gzip are optional. The commit is performed on the
+  // connection handle if one is given
+  if (!PyArg_ParseTuple(args, "ssssiiOi|LizO",&remote_filename, 
+                                             &local_filename, 
+                                             &addr, 
+                                             &port,
+                                             &timeout,
+                                             &timeout_ack,
+                                             &py_log_writer,
+                                             &stripes,
+                                             &stripe_size,
+                                             &raw,
+                                             &requested_codec,
+                                             &py_connection)) {
+    return Py_BuildValue("i", FALSE);
+  }
+  
+  // Makes sure seventh argument is a function
+  if (!PyCallable_Check(py_log_writer)) {
+    PyErr_SetString(PyExc_TypeError, "Argument is not a function.");  
+  }
+  
+  // Stores the log writer function
+  gl_py_log_writer = py_log_writer;
+  
+  // Initializes the log, the ranges are sent by other threads that log too
+  PyEval_InitThreads();
+  LOGGER_INIT;
+  
+  LOGGER(__FUNCTION__, "Begins a striped File Send operation.");
+
+  if (addr == NULL) {
+    LOGGER(__FUNCTION__, "Server Addr can not be null");
+    LOGGER_DEINIT;
+    return Py_BuildValue("i", result);
+  }
+  
+  // Initializes a client
+  client = client_open( py_connection, addr, port, timeout, timeout_ack );
+  if (client == NULL) {
+
+    LOGGER(__FUNCTION__, "Error on client initialization.");
+    LOGGER_DEINIT;
+    return Py_BuildValue("i", result);
+  }
+
+  Py_BEGIN_ALLOW_THREADS
+
+  result = client_send_striped(client, addr, port, remote_filename, local_filename, raw, client_codec(requested_codec), stripes, (long long)stripe_size);
+
+  // Finalizes the client data structure, or keeps the connection of the handle
+  client_close(&client);
+
+  Py_END_ALLOW_THREADS
+
+  LOGGER(__FUNCTION__, "Finalizes striped File Send operation.");
+
+  // Finalizes the log
+  LOGGER_DEINIT;
+  
+  return Py_BuildValue("i", result);
+
+}
+
+/**
+ * Performs a 'File Delete' operation with V1 of the protocol
+ *
+ * @param client                  client's data structure
+ * @param remote_filename         name of the file in the server
+ *
+ * @return                        result code
+ */
+static int client_file_delete_v1( quickft_client_t * client, char * remote_filename ) {
+
+  char l_msg[_BUFFER_SIZE_S];
+
+  char * request  = NULL;
+  char * response = NULL;
+
+  unsigned long request_len;
+  unsigned long response_len; 
+
+  int message_type = 0;
+  int result = RESULT_UNDEFINED;
+
+  // Generates request message
+  request = message_file_delete_request(strlen(remote_filename), remote_filename, &request_len);
+
+  // Sends the message
+  if ( process_outgoing_message(client->connection, request, request_len) == TRUE ) {
+
+    message_type = client_get_response(client, &response, &response_len);
+    if ( message_type == FILE_DEL_B ) {
+      
+      if (response != NULL && response_len != 0) {
+
+        // Logs response
+        LOGGER(__FUNCTION__, "Gets response from server...");
+        if ( response_len >= _BUFFER_SIZE_S ) {
+          snprintf(l_msg, _BUFFER_SIZE_S, "%s", response);
+          l_msg[_BUFFER_SIZE_S - 1] = '\0';
+        }
+        else {
+          snprintf(l_msg, response_len, "%s", response);
+          l_msg[response_len] = '\0';
+        }
+        
+        LOGGER(__FUNCTION__, l_msg);
+
+        // Completes the operation and gets the result
+        result = client_get_file_delete_response_result(response, response_len);
+      }
+      else {
+
+        LOGGER(__FUNCTION__, "Could not get a valid response from the QUICKFT server");
+        result = RESULT_CONNECTION_ERROR;
+      }
+      
+    }
+    else {
+
+      // If the response message type is not correct
+      if (message_type > 0) {
+        sprintf(l_msg, " Message type [%02d] is invalid for expected response.", message_type);
+        LOGGER(__FUNCTION__, l_msg);
+
+        result = RESULT_INVALID_RESPONSE;
+      }
+      // If an error occurred
+      else {
+        sprintf(l_msg, "An error ocurred when trying to read response [%d]", message_type);
+        LOGGER(__FUNCTION__, l_msg);
+
+        result = message_type;
+      }
+
+    }
+
+  }
+  else {
+    LOGGER(__FUNCTION__, "An error occurred while trying to send the request.");
+    result = RESULT_CONNECTION_ERROR;
+  }
+
+  // Frees allocated memory
+  free(request);
+  if (response != NULL) {
+    free(response);
+  }
+
+  return result;
+}
+
+/**
+ * Performs a 'File Delete' operation with V2 of the protocol
+ *
+ * @param client                  client's data structure
+ * @param remote_filename         name of the file in the server
+ *
+ * @return                        result code, RESULT_VERSION_NOT_SUPPORTED
+ *                                if the server only supports V1
+ */
+static int client_file_delete_v2( quickft_client_t * client, char * remote_filename ) {
+
+  char * request = NULL;
+  unsigned long request_len;
+  int message_type = 0;
+  int flags = 0;
+  int result;
+
+  request = message_v2_file_delete_request(remote_filename, client_keep_alive_flag(client), &request_len);
+  if ( request == NULL ) {
+    return RESULT_INVALID_REQUEST;
+  }
+
+  if ( client_send_request(client, request, request_len) == TRUE ) {
+
+    result = client_get_ack_v2(client, FILE_DEL_B, NULL);
+    if ( result == RESULT_SUCCESS ) {
+      result = client_get_message_v2(client, FILE_DEL_B, gl_timeout, &message_type, &flags, NULL, NULL);
+    }
+  }
+  else {
+    LOGGER(__FUNCTION__, "An error occurred while trying to send the request.");
+    result = RESULT_CONNECTION_ERROR;
+  }
+
+  free(request);
+
+  return result;
+}
+
+/**
+ * Performs a 'File Delete' operation on a client, with V2 of the protocol
+ * unless the server only supports V1
+ *
+ * @param client                  client's data structure
+ * @param addr                    server addr
+ * @param port                    server port, can be NULL for default
+ * @param remote_filename         name of the file in the server
+ *
+ * @return                        result code
+ */
+int client_delete( quickft_client_t * client, char * addr, char * port, char * remote_filename ) {
+
+  char l_msg[_BUFFER_SIZE_S];
+  int result;
+
+  // Negotiates V2 of the protocol, connecting
+  // again for V1 if the server does not support it
+  result = RESULT_VERSION_NOT_SUPPORTED;
+
+  if ( ! client_v1_server(addr, port, FALSE) ) {
+
+    result = client_file_delete_v2(client, remote_filename);
+
+    // A connection kept open that the server closed meanwhile is opened again
+    if ( client->stale && client_reconnect(client, addr, port) ) {
+      result = client_file_delete_v2(client, remote_filename);
+    }
+
+    if ( result == RESULT_VERSION_NOT_SUPPORTED ) {
+
+      client_v1_server(addr, port, TRUE);
+      client_reconnect(client, addr, port);
+    }
+  }
+
+  if ( result == RESULT_VERSION_NOT_SUPPORTED ) {
+
+    result = ( client->connection != NULL ) ? client_file_delete_v1(client, remote_filename) : RESULT_CONNECTION_ERROR;
+  }
+
+  if ( result != RESULT_SUCCESS ) {
+
+    sprintf(l_msg, "File Delete operation failed with result [%d]", result);
+    LOGGER(__FUNCTION__, l_msg);
+  }
+
+  return result;
+}
+
+/**
+ * Performs a 'File Delete' operation for the client on the server
+ *
+ */
+PyObject * client_file_delete( PyObject * self, PyObject * args ) {
+
+  int result = RESULT_UNDEFINED;
+
+  quickft_client_t * client;
+
+  // Function parameters
+  char * remote_filename;
+  char * addr;
+  char * port; 
+  int timeout; 
+  int timeout_ack;
+  PyObject * py_log_writer;
+  PyObject * py_connection = NULL;
+  
+  // Parses arguments, the operation is performed
+  // on the connection handle if one is given
+  if (!PyArg_ParseTuple(args, "sssiiO|O",&remote_filename,  
+                                         &addr, 
+                                         &port,
+                                         &timeout,
+                                         &timeout_ack,
+                                         &py_log_writer,
+                                         &py_connection)) {
+    return Py_BuildValue("i", FALSE);
+  }
+  
+  // Makes sure fourth argument is a function
+  if (!PyCallable_Check(py_log_writer)) {
+    PyErr_SetString(PyExc_TypeError, "Argument is not a function.");  
+  }
+  
+  // Stores the log writer function
+  gl_py_log_writer = py_log_writer;
+  
+  // Initializes the log
+  LOGGER_INIT;
+  
+  LOGGER(__FUNCTION__, "Begins a File Delete operation.");
+
+  if (addr == NULL) {
+    LOGGER(__FUNCTION__, "Server Addr can not be null");
+    LOGGER_DEINIT;
+    return Py_BuildValue("i", result);
+  }
+  
+  // Initializes a client
+  client = client_open( py_connection, addr, port, timeout, timeout_ack );
+  if (client == NULL) {
+
+    LOGGER(__FUNCTION__, "Error on client initialization.");
+    LOGGER_DEINIT;
+    return Py_BuildValue("i", result);
+  }
+
+  result = client_delete(client, addr, port, remote_filename);
+
+  // Finalizes the client data structure, or keeps the connection of the handle
+  client_close(&client);
+
+  LOGGER(__FUNCTION__, "Finalizes File Delete operation.");
+  
+  // Finalizes the log
+  LOGGER_DEINIT;
+  
+  return Py_BuildValue("i", result);
+
+}
+
+/**
+ * Performs an operation of a pipeline on its own, waiting for its result
+ *
+ * @param client                  client's data structure
+ * @param addr                    server addr
+ * @param port                    server port, can be NULL for default
+ * @param op                      operation
+ *
+ * @return                        result code
+ */
+static int client_pipeline_lockstep( quickft_client_t * client, char * addr, char * port, CLIENT_OP_T * op ) {
+
+  switch ( op->type ) {
+
+    case FILE_SND_B:
+      return client_send(client, addr, port, op->remote_filename, op->local_filename, op->raw, op->codec, NULL, FALSE);
+
+    case FILE_RCV_B:
+      return client_receive(client, addr, port, op->remote_filename, op->local_filename, FALSE, op->raw, op->codec, NULL);
+
+    default:
+      return client_delete(client, addr, port, op->remote_filename);
+  }
+}
+
+/**
+ * Opens the file of a File Send operation of a pipeline and chooses how it is
+ * sent, packing it in memory when it is small enough to be compressed ahead
+ *
+ * @param op                      operation
+ */
+static void client_pipeline_prepare( CLIENT_OP_T * op ) {
+
+  op->mode = GZ_MODE_STORE;
+
+  op->prepared = client_open_content(op->local_filename, &op->fd, &op->file_len);
+  if ( op->prepared != RESULT_SUCCESS ) {
+    return;
+  }
+
+  // Files that would not shrink are sent as they are
+  if ( ! op->raw ) {
+    op->mode = gz_choose_mode(op->fd, op->local_filename);
+  }
+
+  if ( op->mode != GZ_MODE_STORE && op->file_len <= CLIENT_PACK_MAX ) {
+    op->prepared = process_pack_file(op->fd, op->codec, op->mode, &op->packed, &op->packed_len);
+  }
+}
+
+/**
+ * Releases the file of a File Send operation of a pipeline
+ *
+ * @param pipeline                pipeline's data structure
+ * @param op                      operation
+ */
+static void client_pipeline_release( CLIENT_PIPELINE_T * pipeline, CLIENT_OP_T * op ) {
+
+  if ( op->fd != -1 ) {
+
+    close(op->fd);
+    op->fd = -1;
+  }
+
+  if ( op->packed != NULL ) {
+
+    pthread_mutex_lock(&pipeline->mutex);
+    pipeline->packed_len -= op->packed_len;
+    pthread_cond_broadcast(&pipeline->progress);
+    pthread_mutex_unlock(&pipeline->mutex);
+
+    free(op->packed);
+    op->packed = NULL;
+  }
+}
+
+/**
+ * Prepares the File Send operations of a pipeline ahead of the requests
+ * being sent, so that a file is compressed while the one before it is sent
+ *
+ * @param pipeline_arg            pipeline's data structure
+ */
+static void * client_pipeline_packer( void * pipeline_arg ) {
+
+  CLIENT_PIPELINE_T * pipeline = (CLIENT_PIPELINE_T *)pipeline_arg;
+  int index;
+  int stop;
+
+  for ( index = 0; index < pipeline->count; index++ ) {
+
+    // Keeps a bounded number of files and packed bytes ahead
+    pthread_mutex_lock(&pipeline->mutex);
+    while ( ! pipeline->stop && ( index - pipeline->next >= CLIENT_PACK_AHEAD || pipeline->packed_len >= CLIENT_PACK_AHEAD_LEN ) ) {
+      pthread_cond_wait(&pipeline->progress, &pipeline->mutex);
+    }
+    stop = pipeline->stop;
+    pthread_mutex_unlock(&pipeline->mutex);
+
+    if ( stop ) {
+      break;
+    }
+
+    if ( pipeline->ops[index].type == FILE_SND_B ) {
+      client_pipeline_prepare(&pipeline->ops[index]);
+    }
+
+    pthread_mutex_lock(&pipeline->mutex);
+    pipeline->packed_len += pipeline->ops[index].packed_len;
+    pipeline->ready = index + 1;
+    pthread_cond_broadcast(&pipeline->progress);
+    pthread_mutex_unlock(&pipeline->mutex);
+  }
+
+  return NULL;
+}
+
+/**
+ * Sends a request of a pipeline, followed by the content of a File Send one
+ *
+ * @param pipeline                pipeline's data structure
+ * @param index                   index of the operation, its response carries index + 1
+ * @param result                  returns the result of the operation if it
+ *                                could not be sent
+ *
+ * @return                        TRUE if the request was sent, otherwise FALSE
+ */
+static int client_pipeline_request( CLIENT_PIPELINE_T * pipeline, int index, int * result ) {
+
+  CLIENT_OP_T * op = &pipeline->ops[index];
+
+  char * request = NULL;
+  unsigned long request_len;
+  unsigned long long sent_len;
+  int flags = V2_FLAG_PIPELINED | client_keep_alive_flag(pipeline->client);
+  int raw = op->raw;
+  int sent = FALSE;
+
+  if ( op->type == FILE_SND_B ) {
+
+    *result = op->prepared;
+    if ( *result != RESULT_SUCCESS ) {
+      return FALSE;
+    }
+
+    raw = ( op->mode == GZ_MODE_STORE );
+
+    request = message_v2_file_send_request(op->remote_filename, op->file_len, flags | ( ( raw ) ? V2_FLAG_RAW : V2_FLAG_CHUNKED ),
+                                           ( raw ) ? CODEC_GZIP : op->codec, ( raw ) ? -1 : op->mode, NULL, 0, NULL, &request_len);
+  }
+  else if ( op->type == FILE_RCV_B ) {
+    request = message_v2_file_receive_request(op->remote_filename, flags | ( ( raw ) ? V2_FLAG_RAW : 0 ), op->codec, -1, 0, &request_len);
+  }
+  else {
+    request = message_v2_file_delete_request(op->remote_filename, flags, &request_len);
+  }
+
+  if ( request == NULL ) {
+
+    *result = RESULT_INVALID_REQUEST;
+    return FALSE;
+  }
+
+  message_v2_set_request_id(request, index + 1);
+
+  // The response may arrive before the request is fully sent
+  pthread_mutex_lock(&pipeline->mutex);
+  pipeline->state[index] = CLIENT_OP_SENDING;
+  pthread_mutex_unlock(&pipeline->mutex);
+
+  // The content of a File Send request follows it, the server does not acknowledge it
+  *result = RESULT_CONNECTION_ERROR;
+
+  if ( process_outgoing_message(pipeline->writer, request, request_len) == TRUE ) {
+
+    if ( op->type != FILE_SND_B ) {
+      sent = TRUE;
+    }
+    else if ( op->packed != NULL ) {
+      sent = process_outgoing_data(pipeline->writer, op->packed, (int)op->packed_len);
+    }
+    else if ( raw ) {
+      sent = ( process_outgoing_file_raw(pipeline->writer, op->fd, op->file_len) == RESULT_SUCCESS );
+    }
+    else {
+      sent = ( process_outgoing_file(pipeline->writer, op->fd, CONTENT_BINARY_CHUNKED, op->codec, op->mode, &sent_len) == RESULT_SUCCESS );
+    }
+  }
+
+  free(request);
+
+  return sent;
+}
+
+/**
+ * Sends the requests of a pipeline one after the other without waiting for
+ * their responses, stopping at the first one that could not be sent
+ *
+ * @param pipeline_arg            pipeline's data structure
+ */
+static void * client_pipeline_sender( void * pipeline_arg ) {
+
+  CLIENT_PIPELINE_T * pipeline = (CLIENT_PIPELINE_T *)pipeline_arg;
+  int index;
+  int sent;
+  int stop;
+  int result = RESULT_UNDEFINED;
+
+  for ( index = 0; index < pipeline->count; index++ ) {
+
+    // Waits until the operation is prepared
+    pthread_mutex_lock(&pipeline->mutex);
+    while ( ! pipeline->stop && pipeline->ready <= index ) {
+      pthread_cond_wait(&pipeline->progress, &pipeline->mutex);
+    }
+    stop = pipeline->stop;
+    pthread_mutex_unlock(&pipeline->mutex);
+
+    if ( stop ) {
+      break;
+    }
+
+    pipeline->ops[index].started = time_microseconds();
+
+    sent = client_pipeline_request(pipeline, index, &result);
+
+    client_pipeline_release(pipeline, &pipeline->ops[index]);
+
+    pthread_mutex_lock(&pipeline->mutex);
+
+    // A response received meanwhile already completed the operation
+    if ( pipeline->state[index] == CLIENT_OP_DONE ) {
+      sent = TRUE;
+    }
+    else if ( sent ) {
+      pipeline->state[index] = CLIENT_OP_SENT;
+    }
+    else {
+
+      pipeline->ops[index].result = result;
+      pipeline->state[index] = CLIENT_OP_DONE;
+    }
+
+    if ( sent ) {
+      pipeline->sent++;
+    }
+    pipeline->next = index + 1;
+    pthread_cond_broadcast(&pipeline->progress);
+
+    pthread_mutex_unlock(&pipeline->mutex);
+
+    // A request sent in part leaves the connection unusable
+    if ( ! sent && result == RESULT_CONNECTION_ERROR ) {
+      break;
+    }
+  }
+
+  pthread_mutex_lock(&pipeline->mutex);
+  pipeline->sender_done = TRUE;
+  pthread_cond_broadcast(&pipeline->progress);
+  pthread_mutex_unlock(&pipeline->mutex);
+
+  return NULL;
+}
+
+/**
+ * Performs operations as a pipeline on a connection to a server that
+ * accepts them: a thread sends the requests, while another one compresses
+ * the files to send ahead of them, and this one receives the responses,
+ * in the order the server completes them
+ *
+ * @param client                  client's data structure, connected
+ * @param ops                     operations
+ * @param count                   number of operations
+ *
+ * @return                        number of operations completed from the first
+ *                                one, those that follow were not sent
+ */
+static int client_pipeline_run( quickft_client_t * client, CLIENT_OP_T * ops, int count ) {
+
+  char l_msg[_BUFFER_SIZE_S];
+
+  CLIENT_PIPELINE_T pipeline;
+  thread_t sender;
+  thread_t * sender_thread = &sender;
+  thread_t packer;
+  thread_t * packer_thread = &packer;
+  int packing = FALSE;
+
+  long long size;
+  int message_type;
+  int flags;
+  int codec;
+  int result;
+  int received = 0;
+  int completed = 0;
+  int due;
+  int broken = FALSE;
+  int index;
+
+  memset(&pipeline, 0x00, sizeof(CLIENT_PIPELINE_T));
+  pipeline.client = client;
+  pipeline.ops = ops;
+  pipeline.count = count;
+  pipeline.ready = count;
+  pipeline.state = (int *)calloc(count, sizeof(int));
+  pipeline.writer = SOCKET_SHARE(client->connection);
+
+  if ( pipeline.state == NULL || pipeline.writer == NULL ) {
+
+    free(pipeline.state);
+    SOCKET_UNSHARE(&pipeline.writer);
+    return 0;
+  }
+
+  // Files to send are compressed ahead by their own thread
+  for ( index = 0; index < count; index++ ) {
+
+    ops[index].fd = -1;
+    ops[index].packed = NULL;
+    ops[index].packed_len = 0;
+
+    if ( ops[index].type == FILE_SND_B ) {
+      pipeline.ready = 0;
+    }
+  }
+
+  pthread_mutex_init(&pipeline.mutex, NULL);
+  pthread_cond_init(&pipeline.progress, NULL);
+
+  if ( pipeline.ready < count ) {
+
+    packing = ( THREAD_CREATE(&packer_thread, &client_pipeline_packer, (void *)&pipeline) == 0 );
+    if ( ! packing ) {
+
+      LOGGER(__FUNCTION__, "ERROR: The thread that packs the files could not be started.");
+      goto END_CLIENT_PIPELINE_RUN;
+    }
+  }
+
+  if ( THREAD_CREATE(&sender_thread, &client_pipeline_sender, (void *)&pipeline) != 0 ) {
+
+    LOGGER(__FUNCTION__, "ERROR: The thread that sends the requests could not be started.");
+    goto END_CLIENT_PIPELINE_RUN;
+  }
+
+  while ( TRUE ) {
+
+    // Waits until a response is due
+    pthread_mutex_lock(&pipeline.mutex);
+    while ( ! pipeline.sender_done && received == pipeline.sent ) {
+      pthread_cond_wait(&pipeline.progress, &pipeline.mutex);
+    }
+    due = ( received < pipeline.sent );
+    pthread_mutex_unlock(&pipeline.mutex);
+
+    if ( ! due ) {
+      break;
+    }
+
+    size = -1;
+    result = client_get_message_v2(client, FILE_SND_B + FILE_RCV_B + FILE_DEL_B, client_timeout_ack, &message_type, &flags, &size, &codec);
+    if ( result == RESULT_CONNECTION_ERROR || result == RESULT_INVALID_RESPONSE || result == RESULT_VERSION_NOT_SUPPORTED ) {
+
+      broken = TRUE;
+      break;
+    }
+
+    // Matches the response with its request
+    index = (int)client->request_id - 1;
+
+    pthread_mutex_lock(&pipeline.mutex);
+    if ( index < 0 || index >= count || ops[index].type != message_type ||
+         ( pipeline.state[index] != CLIENT_OP_SENDING && pipeline.state[index] != CLIENT_OP_SENT ) ) {
+      index = -1;
+    }
+    pthread_mutex_unlock(&pipeline.mutex);
+
+    if ( index < 0 ) {
+
+      snprintf(l_msg, _BUFFER_SIZE_S, "ERROR: Response to unknown request %lu.", client->request_id);
+      LOGGER(__FUNCTION__, l_msg);
+
+      broken = TRUE;
+      break;
+    }
+
+    if ( result == RESULT_SUCCESS && message_type == FILE_RCV_B ) {
+
+      result = client_receive_content_v2(client, ops[index].local_filename, NULL, -1, flags, size, codec);
+      broken = ( result != RESULT_SUCCESS );
+    }
+
+    pthread_mutex_lock(&pipeline.mutex);
+    ops[index].result = result;
+    ops[index].elapsed = time_microseconds() - ops[index].started;
+    pipeline.state[index] = CLIENT_OP_DONE;
+    pthread_mutex_unlock(&pipeline.mutex);
+
+    received++;
+
+    if ( broken ) {
+      break;
+    }
+  }
+
+  // Stops the requests still being sent once the connection failed
+  pthread_mutex_lock(&pipeline.mutex);
+  pipeline.stop = TRUE;
+  pthread_cond_broadcast(&pipeline.progress);
+  pthread_mutex_unlock(&pipeline.mutex);
+
+  if ( broken ) {
+    SOCKET_SHUTDOWN(&pipeline.writer);
+  }
+
+  THREAD_JOIN(sender_thread, FALSE);
+
+  // Requests sent and left unanswered failed along with the connection,
+  // those that were not sent are performed again afterwards
+  for ( completed = 0; completed < count; completed++ ) {
+
+    if ( pipeline.state[completed] == CLIENT_OP_PENDING ) {
+      break;
+    }
+    if ( pipeline.state[completed] != CLIENT_OP_DONE ) {
+      ops[completed].result = RESULT_CONNECTION_ERROR;
+    }
+  }
+
+  // The connection is kept if the last response agreed to it
+  client->complete = ( ! broken && received > 0 );
+  client->disconnected = ( client->disconnected || broken );
+
+END_CLIENT_PIPELINE_RUN:
+
+  pthread_mutex_lock(&pipeline.mutex);
+  pipeline.stop = TRUE;
+  pthread_cond_broadcast(&pipeline.progress);
+  pthread_mutex_unlock(&pipeline.mutex);
+
+  if ( packing ) {
+    THREAD_JOIN(packer_thread, FALSE);
+  }
+
+  // Releases the files prepared and not sent
+  for ( index = 0; index < count; index++ ) {
+    client_pipeline_release(&pipeline, &ops[index]);
+  }
+
+  pthread_cond_destroy(&pipeline.progress);
+  pthread_mutex_destroy(&pipeline.mutex);
+  SOCKET_UNSHARE(&pipeline.writer);
+  free(pipeline.state);
+
+  return completed;
+}
+
+/**
+ * Performs operations on a client as a pipeline, when the server accepts
+ * them, otherwise one after the other. Each operation gets its own result
+ * and the time it took
+ *
+ * @param client                  client's data structure
+ * @param addr                    server addr
+ * @param port                    server port, can be NULL for default
+ * @param ops                     operations, that receive their results
+ * @param count                   number of operations
+ */
+void client_pipeline( quickft_client_t * client, char * addr, char * port, CLIENT_OP_T * ops, int count ) {
+
+  int index = 0;
+  int completed;
+
+  // The connection is kept open along the pipeline
+  client->batch = TRUE;
+
+  while ( index < count ) {
+
+    // Every operation but the first one continues on the connection kept, or a new one
+    if ( index > 0 ) {
+
+      client_release(client);
+      if ( ! client_resume(client, addr, port) ) {
+
+        for ( ; index < count; index++ ) {
+          ops[index].result = RESULT_CONNECTION_ERROR;
+        }
+        break;
+      }
+    }
+
+    // Whether the server accepts pipelines is known once it answered a request
+    completed = 0;
+    if ( client->pipelining && ! client_v1_server(addr, port, FALSE) ) {
+      completed = client_pipeline_run(client, &ops[index], count - index);
+    }
+
+    if ( completed == 0 ) {
+
+      ops[index].started = time_microseconds();
+      ops[index].result = client_pipeline_lockstep(client, addr, port, &ops[index]);
+      ops[index].elapsed = time_microseconds() - ops[index].started;
+      completed = 1;
+    }
+
+    index += completed;
+  }
+
+  client->batch = FALSE;
+}
+
+/**
+ * Gets the operations of a pipeline from a sequence of tuples
+ * ('send', remote, local[, raw, codec]), ('recv', remote, local[, raw, codec])
+ * or ('del', remote). The names they point to belong to the sequence
+ *
+ * @param py_ops                  sequence of operations
+ * @param count                   returns the number of operations
+ *
+ * @return                        operations, must be free()'d after usage,
+ *                                or NULL with a python exception set
+ */
+CLIENT_OP_T * client_pipeline_ops( PyObject * py_ops, int * count ) {
+
+  CLIENT_OP_T * ops;
+  PyObject * py_op;
+  char * type;
+  char * requested_codec;
+  int index;
+
+  *count = (int)PySequence_Fast_GET_SIZE(py_ops);
+
+  ops = (CLIENT_OP_T *)calloc(( *count > 0 ) ? *count : 1, sizeof(CLIENT_OP_T));
+  if ( ops == NULL ) {
+
+    PyErr_NoMemory();
+    return NULL;
+  }
+
+  for ( index = 0; index < *count; index++ ) {
+
+    py_op = PySequence_Fast_GET_ITEM(py_ops, index);
+    requested_codec = NULL;
+
+    if ( ! PyTuple_Check(py_op) || ! PyArg_ParseTuple(py_op, "ss|siz", &type,
+                                                                     &ops[index].remote_filename,
+                                                                     &ops[index].local_filename,
+                                                                     &ops[index].raw,
+                                                                     &requested_codec) ) {
+      if ( ! PyErr_Occurred() ) {
+        PyErr_SetString(PyExc_TypeError, "Operations must be tuples.");
+      }
+      free(ops);
+      return NULL;
+    }
+
+    if ( strcmp(type, "send") == 0 ) {
+      ops[index].type = FILE_SND_B;
+    }
+    else if ( strcmp(type, "recv") == 0 ) {
+      ops[index].type = FILE_RCV_B;
+    }
+    else if ( strcmp(type, "del") == 0 ) {
+      ops[index].type = FILE_DEL_B;
+    }
+    else {
+
+      PyErr_Format(PyExc_ValueError, "Unknown operation '%s'.", type);
+      free(ops);
+      return NULL;
+    }
+
+    if ( ops[index].type != FILE_DEL_B && ops[index].local_filename == NULL ) {
+
+      PyErr_SetString(PyExc_ValueError, "Operation needs a local file.");
+      free(ops);
+      return NULL;
+    }
+
+    ops[index].codec = client_codec(requested_codec);
+    ops[index].result = RESULT_UNDEFINED;
+  }
+
+  return ops;
+}
+
+/**
+ * Gets the operations of a batch of File Send or File Receive operations from
+ * a sequence of (source, destination) tuples, that is (local, remote) to send
+ * files and (remote, local) to receive them. The names they point to belong
+ * to the sequence
+ *
+ * @param py_files                sequence of files
+ * @param type                    FILE_SND_B or FILE_RCV_B
+ * @param raw                     TRUE to transfer the files uncompressed
+ * @param codec                   codec asked for the content
+ * @param count                   returns the number of operations
+ *
+ * @return                        operations, must be free()'d after usage,
+ *                                or NULL with a python exception set
+ */
+CLIENT_OP_T * client_batch_ops( PyObject * py_files, int type, int raw, int codec, int * count ) {
+
+  CLIENT_OP_T * ops;
+  PyObject * py_file;
+  char * source;
+  char * destination;
+  int index;
+
+  *count = (int)PySequence_Fast_GET_SIZE(py_files);
+
+  ops = (CLIENT_OP_T *)calloc(( *count > 0 ) ? *count : 1, sizeof(CLIENT_OP_T));
+  if ( ops == NULL ) {
+
+    PyErr_NoMemory();
+    return NULL;
+  }
+
+  for ( index = 0; index < *count; index++ ) {
+
+    py_file = PySequence_Fast_GET_ITEM(py_files, index);
+
+    if ( ! PyTuple_Check(py_file) || ! PyArg_ParseTuple(py_file, "ss", &source, &destination) ) {
+
+      if ( ! PyErr_Occurred() ) {
+        PyErr_SetString(PyExc_TypeError, "Files must be (source, destination) tuples.");
+      }
+      free(ops);
+      return NULL;
+    }
+
+    ops[index].type = type;
+    ops[index].local_filename = ( type == FILE_SND_B ) ? source : destination;
+    ops[index].remote_filename = ( type == FILE_SND_B ) ? destination : source;
+    ops[index].raw = raw;
+    ops[index].codec = codec;
+    ops[index].result = RESULT_UNDEFINED;
+  }
+
+  return ops;
+}
+
+/**
+ * Gets the list of results of the operations of a pipeline
+ *
+ * @param ops                     operations
+ * @param count                   number of operations
+ *
+ * @return                        python list
+ */
+PyObject * client_pipeline_results( CLIENT_OP_T * ops, int count ) {
+
+  PyObject * py_results;
+  int index;
+
+  py_results = PyList_New(count);
+  if ( py_results == NULL ) {
+    return NULL;
+  }
+
+  for ( index = 0; index < count; index++ ) {
+    PyList_SET_ITEM(py_results, index, PyInt_FromLong(ops[index].result));
+  }
+
+  return py_results;
+}
+
+/**
+ * Gets the list of results of a batch, a (result, seconds) tuple for each file
+ *
+ * @param ops                     operations
+ * @param count                   number of operations
+ *
+ * @return                        python list
+ */
+PyObject * client_batch_results( CLIENT_OP_T * ops, int count ) {
+
+  PyObject * py_results;
+  int index;
+
+  py_results = PyList_New(count);
+  if ( py_results == NULL ) {
+    return NULL;
+  }
+
+  for ( index = 0; index < count; index++ ) {
+    PyList_SET_ITEM(py_results, index, Py_BuildValue("(id)", ops[index].result, ops[index].elapsed / 1000000.0));
+  }
+
+  return py_results;
+}
+
+/**
+ * Performs the operations of a pipeline for the python functions, on the
+ * connection handle if one is given, with the GIL released
+ *
+ * @param ops                     operations
+ * @param count                   number of operations
+ * @param addr                    server addr
+ * @param port                    server port, can be NULL for default
+ * @param timeout                 timeout for parts of the messages, can be 0 for default
+ * @param timeout_ack             timeout for ack messages, can be 0 for default
+ * @param py_log_writer           log writer function
+ * @param py_connection           connection handle, can be NULL or None
+ */
+static void client_pipeline_perform( CLIENT_OP_T * ops, int count, char * addr, char * port, int timeout, int timeout_ack, PyObject * py_log_writer, PyObject * py_connection ) {
+
+  quickft_client_t * client;
+  int index;
+
+  // Makes sure the log writer is a function
+  if (!PyCallable_Check(py_log_writer)) {
+    PyErr_SetString(PyExc_TypeError, "Argument is not a function.");
+  }
+
+  // Stores the log writer function
+  gl_py_log_writer = py_log_writer;
 
-        result = RESULT_INVALID_RESPONSE;
-      }
-      // If an error occurred
-      else {
-        sprintf(l_msg, "An error ocurred when trying to read response [%d]", message_type);
-        LOGGER(__FUNCTION__, l_msg);
+  // Initializes the log, the requests are sent by another thread that logs too
+  PyEval_InitThreads();
+  LOGGER_INIT;
 
-        result = message_type;
-      }
+  LOGGER(__FUNCTION__, "Begins a pipeline of operations.");
 
-    }
+  client = client_open( py_connection, addr, port, timeout, timeout_ack );
+  if (client == NULL) {
 
+    LOGGER(__FUNCTION__, "Error on client initialization.");
+    for ( index = 0; index < count; index++ ) {
+      ops[index].result = RESULT_CONNECTION_ERROR;
+    }
   }
   else {
-    LOGGER(__FUNCTION__, "An error occurred while trying to send the request.");
-    result = RESULT_CONNECTION_ERROR;
-  }
 
-  // Finalizes the client data structure
-  client_finalize(&client);
+    Py_BEGIN_ALLOW_THREADS
 
-  // Frees allocated memory 
-  if (request != NULL) {
-    free(request);
-  }
-  if (response != NULL) {
-    free(response);
+    client_pipeline(client, addr, port, ops, count);
+
+    // Finalizes the client data structure, or keeps the connection of the handle
+    client_close(&client);
+
+    Py_END_ALLOW_THREADS
   }
 
-  LOGGER(__FUNCTION__, "Finalizes File Receive operation.");
+  LOGGER(__FUNCTION__, "Finalizes the pipeline of operations.");
 
   // Finalizes the log
   LOGGER_DEINIT;
-  
-  return Py_BuildValue("i", result);
-
 }
 
 /**
- * Performs a 'File Send' operation for the client
+ * Performs operations for the client as a pipeline, getting their results
  *
  */
-PyObject * client_file_send( PyObject * self, PyObject * args ) {
-
-  char l_msg[_BUFFER_SIZE_S];
-
-  char * request  = NULL;
-  char * response = NULL;
-
-  char * content  = NULL;
-
-  unsigned long request_len;
-  unsigned long response_len;
-  unsigned long content_len;
-
-  int message_type = 0;
-  int result = RESULT_UNDEFINED;
+PyObject * client_file_pipeline( PyObject * self, PyObject * args ) {
 
-  quickft_client_t * client;
+  CLIENT_OP_T * ops;
+  PyObject * py_ops;
+  PyObject * py_results;
+  int count;
 
   // Function parameters
-  char * remote_filename;
-  char * local_filename;
+  PyObject * py_sequence;
   char * addr;
-  char * port; 
-  int timeout; 
+  char * port;
+  int timeout;
   int timeout_ack;
   PyObject * py_log_writer;
-  
-  // Parses arguments
-  if (!PyArg_ParseTuple(args, "ssssiiO",&remote_filename, 
-                                        &local_filename, 
-                                        &addr, 
-                                        &port,
-                                        &timeout,
-                                        &timeout_ack,
-                                        &py_log_writer)) {
-    return Py_BuildValue("i", FALSE);
-  }
-  
-  // Makes sure fourth argument is a function
-  if (!PyCallable_Check(py_log_writer)) {
-    PyErr_SetString(PyExc_TypeError, "Argument is not a function.");  
+  PyObject * py_connection = NULL;
+
+  // Parses arguments, the operations are performed
+  // on the connection handle if one is given
+  if (!PyArg_ParseTuple(args, "OssiiO|O",&py_sequence,
+                                         &addr,
+                                         &port,
+                                         &timeout,
+                                         &timeout_ack,
+                                         &py_log_writer,
+                                         &py_connection)) {
+    return NULL;
   }
-  
-  // Stores the log writer function
-  gl_py_log_writer = py_log_writer;
-  
-  // Initializes the log
-  LOGGER_INIT;
-  
-  LOGGER(__FUNCTION__, "Begins a File Send operation.");
 
-  if (addr == NULL) {
-    LOGGER(__FUNCTION__, "Server Addr can not be null");
-    return Py_BuildValue("i", result);
-  }
-  
-  // Initializes a client
-  if (port == NULL) {
-    client = client_initialize( addr, DEFAULT_PORT, timeout, timeout_ack );
-  }
-  else {
-    client = client_initialize( addr, atoi(port), timeout, timeout_ack );
+  py_ops = PySequence_Fast(py_sequence, "Operations must be a sequence.");
+  if ( py_ops == NULL ) {
+    return NULL;
   }
 
-  if (client == NULL) {
+  ops = client_pipeline_ops(py_ops, &count);
+  if ( ops == NULL ) {
 
-    LOGGER(__FUNCTION__, "Error on client initialization.");
-    return Py_BuildValue("i", result);
+    Py_DECREF(py_ops);
+    return NULL;
   }
 
-  // Generates content for request
-  result = client_generate_content_from_file(local_filename, &content, &content_len);  
-  if ( result == RESULT_SUCCESS ) {
+  client_pipeline_perform(ops, count, addr, port, timeout, timeout_ack, py_log_writer, py_connection);
 
-    // Generates request message
-    request = message_file_send_request(remote_filename, content_len, content, &request_len);
+  py_results = client_pipeline_results(ops, count);
 
-    // Sends the message
-    if ( process_outgoing_message(client->connection, request, request_len) == TRUE) {
+  free(ops);
+  Py_DECREF(py_ops);
 
-      message_type = client_get_response(client, &response, &response_len);
-      if ( message_type == FILE_SND_B ) {
-      
-        if (response != NULL  && response_len != 0) {
+  return py_results;
+}
 
-          // Logs response
-          LOGGER(__FUNCTION__, "Gets response from server...");
-          if ( response_len >= _BUFFER_SIZE_S ) {
-            snprintf(l_msg, _BUFFER_SIZE_S, "%s", response);
-            l_msg[_BUFFER_SIZE_S - 1] = '\0';
-          }
-          else {
-            snprintf(l_msg, response_len, "%s", response);
-            l_msg[response_len] = '\0';
-          }
-        
-          LOGGER(__FUNCTION__, l_msg);
+/**
+ * Performs a batch of File Send or File Receive operations for the client,
+ * getting the result of each file and the time it took
+ *
+ * @param args                    python arguments
+ * @param type                    FILE_SND_B or FILE_RCV_B
+ *
+ * @return                        python list
+ */
+static PyObject * client_file_batch( PyObject * args, int type ) {
 
-          // Completes the operation and gets the result
-          result = client_get_file_send_response_result(response, response_len);
-        }
-        else {
+  CLIENT_OP_T * ops;
+  PyObject * py_files;
+  PyObject * py_results;
+  int count;
 
-          sprintf(l_msg, "Could not get a valid response from the QUICKFT server at %s:%s", addr, port);
-          LOGGER(__FUNCTION__, l_msg);
-          result = RESULT_CONNECTION_ERROR;
-        }
-      
-      }
-      else {
+  // Function parameters
+  PyObject * py_sequence;
+  char * addr;
+  char * port;
+  int timeout;
+  int timeout_ack;
+  PyObject * py_log_writer;
+  int raw = FALSE;
+  char * requested_codec = NULL;
+  PyObject * py_connection = NULL;
+
+  // Parses arguments, transferring the files uncompressed or with a codec
+  // other than gzip is optional. The operations are performed on the
+  // connection handle if one is given
+  if (!PyArg_ParseTuple(args, "OssiiO|izO",&py_sequence,
+                                           &addr,
+                                           &port,
+                                           &timeout,
+                                           &timeout_ack,
+                                           &py_log_writer,
+                                           &raw,
+                                           &requested_codec,
+                                           &py_connection)) {
+    return NULL;
+  }
 
-        // If the response message type is not correct
-        if (message_type > 0) {
-          sprintf(l_msg, "Message type [%02d] is invalid for expected response.", message_type);
-          LOGGER(__FUNCTION__, l_msg);
+  py_files = PySequence_Fast(py_sequence, "Files must be a sequence.");
+  if ( py_files == NULL ) {
+    return NULL;
+  }
 
-          result = RESULT_INVALID_RESPONSE;
-        }
-        // If an error occurred
-        else {
-          sprintf(l_msg, "An error ocurred when trying to read response [%d]", message_type);
-          LOGGER(__FUNCTION__, l_msg);
+  ops = client_batch_ops(py_files, type, raw, client_codec(requested_codec), &count);
+  if ( ops == NULL ) {
 
-          result = message_type;
-        }
+    Py_DECREF(py_files);
+    return NULL;
+  }
 
-      }
+  client_pipeline_perform(ops, count, addr, port, timeout, timeout_ack, py_log_writer, py_connection);
 
-    }
-    else {
-      LOGGER(__FUNCTION__, "An error occurred while trying to send the request.");
-      result = RESULT_CONNECTION_ERROR;
-    }
+  py_results = client_batch_results(ops, count);
 
-  }
-  else {
-    snprintf(l_msg, _BUFFER_SIZE_S, "An error occurred while trying to generate content from file [%s]", local_filename);
-    LOGGER(__FUNCTION__, l_msg);
-  }
+  free(ops);
+  Py_DECREF(py_files);
 
-  // Finalizes the client data structure
-  client_finalize(&client);
+  return py_results;
+}
 
-  // Frees allocated memory
-  if (request != NULL) {
-    free(request);
-  }
-  if (response != NULL) {
-    free(response);
-  }
-  if (content != NULL) {
-    free(content);
-  }
+/**
+ * Performs a batch of 'File Send' operations for the client
+ *
+ */
+PyObject * client_file_send_many( PyObject * self, PyObject * args ) {
 
-  LOGGER(__FUNCTION__, "Finalizes File Send operation.");
+  return client_file_batch(args, FILE_SND_B);
+}
 
-  // Finalizes the log
-  LOGGER_DEINIT;
-  
-  return Py_BuildValue("i", result);
+/**
+ * Performs a batch of 'File Receive' operations for the client
+ *
+ */
+PyObject * client_file_receive_many( PyObject * self, PyObject * args ) {
 
+  return client_file_batch(args, FILE_RCV_B);
 }
 
 /**
- * Performs a 'File Delete' operation for the client on the server
+ * Destroys the client of a connection handle once it is no longer referenced
  *
+ * @param py_connection           connection handle
  */
-PyObject * client_file_delete( PyObject * self, PyObject * args ) {
-
-  char l_msg[_BUFFER_SIZE_S];
+static void client_connection_destroy( PyObject * py_connection ) {
 
-  char * request  = NULL;
-  char * response = NULL;
+  quickft_client_t * client = (quickft_client_t *)PyCapsule_GetPointer(py_connection, CLIENT_CONNECTION_NAME);
 
-  unsigned long request_len;
-  unsigned long response_len; 
+  client_finalize(&client);
+}
 
-  int message_type = 0;
-  int result = RESULT_UNDEFINED;
+/**
+ * Opens a connection handle to a server, on which operations
+ * are performed one after the other
+ *
+ */
+PyObject * client_connection_open( PyObject * self, PyObject * args ) {
 
   quickft_client_t * client;
 
   // Function parameters
-  char * remote_filename;
   char * addr;
-  char * port; 
-  int timeout; 
+  char * port;
+  int timeout;
   int timeout_ack;
   PyObject * py_log_writer;
-  
+
   // Parses arguments
-  if (!PyArg_ParseTuple(args, "sssiiO",&remote_filename,  
-                                       &addr, 
-                                       &port,
-                                       &timeout,
-                                       &timeout_ack,
-                                       &py_log_writer)) {
-    return Py_BuildValue("i", FALSE);
+  if (!PyArg_ParseTuple(args, "ssiiO",&addr,
+                                      &port,
+                                      &timeout,
+                                      &timeout_ack,
+                                      &py_log_writer)) {
+    Py_RETURN_NONE;
   }
-  
-  // Makes sure fourth argument is a function
+
+  // Makes sure fifth argument is a function
   if (!PyCallable_Check(py_log_writer)) {
-    PyErr_SetString(PyExc_TypeError, "Argument is not a function.");  
+    PyErr_SetString(PyExc_TypeError, "Argument is not a function.");
   }
-  
+
   // Stores the log writer function
   gl_py_log_writer = py_log_writer;
-  
+
   // Initializes the log
   LOGGER_INIT;
-  
-  LOGGER(__FUNCTION__, "Begins a File Delete operation.");
-
-  if (addr == NULL) {
-    LOGGER(__FUNCTION__, "Server Addr can not be null");
-    return Py_BuildValue("i", result);
-  }
-  
-  // Initializes a client
-  if (port == NULL) {
-    client = client_initialize( addr, DEFAULT_PORT, timeout, timeout_ack );
-  }
-  else {
-    client = client_initialize( addr, atoi(port), timeout, timeout_ack );
-  }
 
+  // Connects now so that an unreachable server is reported
+  // right away, the operations connect again when needed
+  client = client_connect( addr, port, timeout, timeout_ack );
   if (client == NULL) {
 
     LOGGER(__FUNCTION__, "Error on client initialization.");
-    return Py_BuildValue("i", result);
+    LOGGER_DEINIT;
+    Py_RETURN_NONE;
   }
 
-  // Generates request message
-  request = message_file_delete_request(strlen(remote_filename), remote_filename, &request_len);
-
-  // Sends the message
-  if ( process_outgoing_message(client->connection, request, request_len) == TRUE ) {
-
-    message_type = client_get_response(client, &response, &response_len);
-    if ( message_type == FILE_DEL_B ) {
-      
-      if (response != NULL && response_len != 0) {
-
-        // Logs response
-        LOGGER(__FUNCTION__, "Gets response from server...");
-        if ( response_len >= _BUFFER_SIZE_S ) {
-          snprintf(l_msg, _BUFFER_SIZE_S, "%s", response);
-          l_msg[_BUFFER_SIZE_S - 1] = '\0';
-        }
-        else {
-          snprintf(l_msg, response_len, "%s", response);
-          l_msg[response_len] = '\0';
-        }
-        
-        LOGGER(__FUNCTION__, l_msg);
-
-        // Completes the operation and gets the result
-        result = client_get_file_delete_response_result(response, response_len);
-      }
-      else {
+  client->persistent = TRUE;
 
-        sprintf(l_msg, "Could not get a valid response from the QUICKFT server at %s:%s", addr, port);
-        LOGGER(__FUNCTION__, l_msg);
-        result = RESULT_CONNECTION_ERROR;
-      }
-      
-    }
-    else {
+  LOGGER(__FUNCTION__, "Connection handle opened.");
 
-      // If the response message type is not correct
-      if (message_type > 0) {
-        sprintf(l_msg, " Message type [%02d] is invalid for expected response.", message_type);
-        LOGGER(__FUNCTION__, l_msg);
+  // Finalizes the log
+  LOGGER_DEINIT;
 
-        result = RESULT_INVALID_RESPONSE;
-      }
-      // If an error occurred
-      else {
-        sprintf(l_msg, "An error ocurred when trying to read response [%d]", message_type);
-        LOGGER(__FUNCTION__, l_msg);
+  return PyCapsule_New(client, CLIENT_CONNECTION_NAME, &client_connection_destroy);
+}
 
-        result = message_type;
-      }
+/**
+ * Closes the connection of a connection handle
+ *
+ */
+PyObject * client_connection_close( PyObject * self, PyObject * args ) {
 
-    }
+  quickft_client_t * client;
+  PyObject * py_connection;
 
+  if (!PyArg_ParseTuple(args, "O", &py_connection) || ! PyCapsule_IsValid(py_connection, CLIENT_CONNECTION_NAME)) {
+    return Py_BuildValue("i", FALSE);
   }
-  else {
-    LOGGER(__FUNCTION__, "An error occurred while trying to send the request.");
-    result = RESULT_CONNECTION_ERROR;
-  }
-
-  // Finalizes the client data structure
-  client_finalize(&client);
 
-  // Frees allocated memory
-  if (request != NULL) {
-    free(request);
-  }
-  if (response != NULL) {
-    free(response);
-  }
+  // The handle stays valid, its next operation connects again
+  client = (quickft_client_t *)PyCapsule_GetPointer(py_connection, CLIENT_CONNECTION_NAME);
 
-  LOGGER(__FUNCTION__, "Finalizes File Delete operation.");
-  
-  // Finalizes the log
-  LOGGER_DEINIT;
-  
-  return Py_BuildValue("i", result);
+  SOCKET_SHUTDOWN( &client->connection );
+  SOCKET_CLOSE( &client->connection );
+  client->requests = 0;
 
+  return Py_BuildValue("i", TRUE);
 }
@@ -16,37 +16,468 @@
 extern "C" {
 #endif
 
+#include <pthread.h>
+
 #include "socket.h"
 
 // Timeout for ACK Messages
 unsigned long client_timeout_ack;
 
+// Name of the capsules that hold connection handles
+#define CLIENT_CONNECTION_NAME  "quickftpy.connection"
+
 // Data structure definition for client nodes
 typedef struct _quickft_client_t {
 
   // Connection data structure
   SOCKET_T * connection;
+
+  // Set when the server drops the connection while a response is awaited
+  int disconnected;
+
+  // Set for the client of a connection handle, kept open across
+  // operations, along with the number of requests it completed
+  int persistent;
+  int requests;
+
+  // Set when the server keeps the connection open after the current
+  // request and once the last message of the exchange was received
+  int keep_alive;
+  int complete;
+
+  // Set when the server had already closed a connection kept open,
+  // as it does with idle ones, before the request sent through it
+  int stale;
+
+  // Set while the operations of a pipeline are performed, so that the
+  // connection is kept open between them
+  int batch;
+
+  // Set once the server tells it accepts pipelines, along with the
+  // request ID of the last message received within a pipeline
+  int pipelining;
+  unsigned long request_id;
+
+  // Offset the content of a resumable transfer starts at,
+  // as given by the last message received, -1 if not given
+  long long offset;
+
+  // Block size of a signature, as given by
+  // the last message received, -1 if not given
+  long block_size;
   
 } quickft_client_t;
 
+// Files to send up to this size are compressed in memory ahead of being sent,
+// by at most CLIENT_PACK_AHEAD files and CLIENT_PACK_AHEAD_LEN bytes
+#define CLIENT_PACK_MAX         (4 * 1024 * 1024)
+#define CLIENT_PACK_AHEAD       16
+#define CLIENT_PACK_AHEAD_LEN   (16 * 1024 * 1024)
+
+// States of the operations of a pipeline
+#define CLIENT_OP_PENDING   0
+#define CLIENT_OP_SENDING   1
+#define CLIENT_OP_SENT      2
+#define CLIENT_OP_DONE      3
+
+// Operation of a pipeline
+typedef struct _client_op_t {
+
+  int type;                             // FILE_SND_B, FILE_RCV_B or FILE_DEL_B
+  char * remote_filename;
+  char * local_filename;
+  int raw;
+  int codec;
+  int result;
+
+  // Moment the operation began and the microseconds it took
+  unsigned long long started;
+  unsigned long long elapsed;
+
+  // File of a File Send operation opened ahead of its request, with the
+  // result of preparing it and its content when it was packed in memory
+  int prepared;
+  int fd;
+  long long file_len;
+  int mode;
+  char * packed;
+  unsigned long packed_len;
+
+} CLIENT_OP_T;
+
+// Pipeline being performed, whose requests are sent by its own thread through
+// a socket structure that shares the connection, and whose files to send are
+// prepared by another one
+typedef struct _client_pipeline_t {
+
+  quickft_client_t * client;
+  SOCKET_T * writer;
+
+  CLIENT_OP_T * ops;
+  int * state;
+  int count;
+
+  // Requests sent, and set once no more are sent
+  int sent;
+  int sender_done;
+
+  // Operations prepared, the next one to send and the packed bytes held
+  int ready;
+  int next;
+  unsigned long packed_len;
+
+  // Set to stop sending and preparing operations
+  int stop;
+
+  pthread_mutex_t mutex;
+  pthread_cond_t progress;
+
+} CLIENT_PIPELINE_T;
+
+// Defines the smallest range of a striped transfer, and the
+// most connections the ranges are sent over at once
+#define CLIENT_STRIPE_MINIMUM_SIZE  (1024 * 1024)
+#define CLIENT_STRIPES_MAX          64
+
+// Striped transfer being performed, whose ranges are sent over several
+// connections at once by their own threads, each of them taking the next
+// range left to send
+typedef struct _client_stripes_t {
+
+  char * addr;
+  char * port;
+  char * remote_filename;
+  char * local_filename;
+  char * stripe;
+
+  long long file_len;
+  long long stripe_size;
+  int count;
+  int raw;
+  int codec;
+  int mode;
+
+  // Next range to send, and the result of the first range that failed
+  int next;
+  int result;
+
+  pthread_mutex_t mutex;
+
+} CLIENT_STRIPES_T;
+
+// Defines the share of a file, in percent, that a delta may insert before
+// the whole file is sent instead, and the longest signature received
+#define CLIENT_DELTA_LITERAL_PERCENT  90
+#define CLIENT_SIGNATURE_MAXIMUM_LEN  (64 * 1024 * 1024)
+
+/**
+ * Sets the timeouts of the client operations
+ *
+ * @param timeout                 timeout for parts of the messages, can be 0 for default
+ * @param timeout_ack             timeout for ack messages, can be 0 for default
+ */
+void client_timeouts( long timeout, long timeout_ack );
+
+/**
+ * Connects a client to the server
+ *
+ * @param addr                    server addr
+ * @param port                    server port, can be NULL for default
+ * @param timeout                 timeout for parts of the messages, can be 0 for default
+ * @param timeout_ack             timeout for ack messages, can be 0 for default
+ * @return                        pointer of type quickft_client_t or NULL
+ */
+quickft_client_t * client_connect( char * addr, char * port, long timeout, long timeout_ack );
+
+/**
+ * Opens the connection of a client again, closing the previous one
+ *
+ * @param client                  client's data structure
+ * @param addr                    server addr
+ * @param port                    server port, can be NULL for default
+ *
+ * @return                        TRUE or FALSE
+ */
+int client_reconnect( quickft_client_t * client, char * addr, char * port );
+
+/**
+ * Prepares the client of a connection handle or a session for an
+ * operation, connecting it again if its connection was closed
+ *
+ * @param client                  client's data structure
+ * @param addr                    server addr
+ * @param port                    server port, can be NULL for default
+ *
+ * @return                        TRUE or FALSE
+ */
+int client_resume( quickft_client_t * client, char * addr, char * port );
+
+/**
+ * Ends the operation of the client of a connection handle or a session.
+ * The connection is kept open when the server agreed to it and the exchange
+ * ended cleanly, otherwise it is closed and opened again by the next operation
+ *
+ * @param client                  client's data structure
+ *
+ * @return                        TRUE if the connection was kept open
+ */
+int client_release( quickft_client_t * client );
+
+/**
+ * Closes the client and free()s memory
+ *
+ * @param client                  client's data structure
+ * @return                        TRUE or FALSE
+ */
+int client_finalize( quickft_client_t ** client );
+
+/**
+ * Gets the codec asked for by its name, gzip when none is
+ * given or the one named is unknown or not built in
+ *
+ * @param name                    codec name, can be NULL
+ *
+ * @return                        codec
+ */
+int client_codec( char * name );
+
+/**
+ * Performs a 'File Receive' operation on a client, with V2 of the protocol
+ * unless the server only supports V1
+ *
+ * @param client                  client's data structure
+ * @param addr                    server addr
+ * @param port                    server port, can be NULL for default
+ * @param remote_filename         name of the file in the server
+ * @param local_filename          local name of the file being received
+ * @param chunked                 TRUE to ask a V1 server for a chunked response
+ * @param raw                     TRUE to ask for the file uncompressed
+ * @param codec                   codec asked for the content
+ * @param transfer_id             ID of a resumable transfer, or NULL
+ *
+ * @return                        result code
+ */
+int client_receive( quickft_client_t * client, char * addr, char * port, char * remote_filename, char * local_filename, int chunked, int raw, int codec, char * transfer_id );
+
+/**
+ * Performs a 'File Receive' operation for a byte range of a file on a
+ * client, which requires V2 of the protocol
+ *
+ * @param client                  client's data structure
+ * @param addr                    server addr
+ * @param port                    server port, can be NULL for default
+ * @param remote_filename         name of the file in the server
+ * @param local_filename          local name of the range being received
+ * @param offset                  offset the range starts at, counted from
+ *                                the end of the file when negative
+ * @param length                  length of the range, or -1 up to the end
+ * @param raw                     TRUE to ask for the range uncompressed
+ * @param codec                   codec asked for the content
+ *
+ * @return                        result code
+ */
+int client_receive_range( quickft_client_t * client, char * addr, char * port, char * remote_filename, char * local_filename, long long offset, long long length, int raw, int codec );
+
+/**
+ * Performs a 'File Send' operation on a client, with V2 of the protocol
+ * unless the server only supports V1
+ *
+ * @param client                  client's data structure
+ * @param addr                    server addr
+ * @param port                    server port, can be NULL for default
+ * @param remote_filename         filepath in destination
+ * @param local_filename          local name of the file being sent
+ * @param raw                     TRUE to send the file uncompressed
+ * @param codec                   codec asked for the content
+ * @param transfer_id             ID of a resumable transfer, or NULL
+ * @param dedup                   TRUE to send the digest of the content first,
+ *                                so that nothing else is sent if the content
+ *                                store of the server already holds it
+ *
+ * @return                        result code
+ */
+int client_send( quickft_client_t * client, char * addr, char * port, char * remote_filename, char * local_filename, int raw, int codec, char * transfer_id, int dedup );
+
+/**
+ * Performs a 'File Send' operation on a client that only sends a delta
+ * against the file the server already has, which requires V2 of the
+ * protocol, the file being sent whole when the server does not have it,
+ * when most of it changed or when the delta could not be applied
+ *
+ * @param client                  client's data structure
+ * @param addr                    server addr
+ * @param port                    server port, can be NULL for default
+ * @param remote_filename         filepath in destination
+ * @param local_filename          local name of the file being sent
+ * @param codec                   codec asked for the content
+ *
+ * @return                        result code
+ */
+int client_send_delta( quickft_client_t * client, char * addr, char * port, char * remote_filename, char * local_filename, int codec );
+
+/**
+ * Performs a 'File Send' operation on a client splitting the file into
+ * ranges sent over several connections at once, which requires V2 of the
+ * protocol, the file being sent whole on the client otherwise
+ *
+ * @param client                  client's data structure
+ * @param addr                    server addr
+ * @param port                    server port, can be NULL for default
+ * @param remote_filename         filepath in destination
+ * @param local_filename          local name of the file being sent
+ * @param raw                     TRUE to send the file uncompressed
+ * @param codec                   codec asked for the content
+ * @param stripes                 number of connections
+ * @param stripe_size             length of the ranges, or 0 to split the
+ *                                file evenly between the connections
+ *
+ * @return                        result code
+ */
+int client_send_striped( quickft_client_t * client, char * addr, char * port, char * remote_filename, char * local_filename, int raw, int codec, int stripes, long long stripe_size );
+
+/**
+ * Performs a 'File Delete' operation on a client, with V2 of the protocol
+ * unless the server only supports V1
+ *
+ * @param client                  client's data structure
+ * @param addr                    server addr
+ * @param port                    server port, can be NULL for default
+ * @param remote_filename         name of the file in the server
+ *
+ * @return                        result code
+ */
+int client_delete( quickft_client_t * client, char * addr, char * port, char * remote_filename );
+
+/**
+ * Performs operations on a client as a pipeline, when the server accepts
+ * them, otherwise one after the other. Each operation gets its own result
+ * and the time it took
+ *
+ * @param client                  client's data structure
+ * @param addr                    server addr
+ * @param port                    server port, can be NULL for default
+ * @param ops                     operations, that receive their results
+ * @param count                   number of operations
+ */
+void client_pipeline( quickft_client_t * client, char * addr, char * port, CLIENT_OP_T * ops, int count );
+
+/**
+ * Gets the operations of a pipeline from a sequence of tuples
+ * ('send', remote, local[, raw, codec]), ('recv', remote, local[, raw, codec])
+ * or ('del', remote). The names they point to belong to the sequence
+ *
+ * @param py_ops                  sequence of operations
+ * @param count                   returns the number of operations
+ *
+ * @return                        operations, must be free()'d after usage,
+ *                                or NULL with a python exception set
+ */
+CLIENT_OP_T * client_pipeline_ops( PyObject * py_ops, int * count );
+
+/**
+ * Gets the operations of a batch of File Send or File Receive operations from
+ * a sequence of (source, destination) tuples, that is (local, remote) to send
+ * files and (remote, local) to receive them. The names they point to belong
+ * to the sequence
+ *
+ * @param py_files                sequence of files
+ * @param type                    FILE_SND_B or FILE_RCV_B
+ * @param raw                     TRUE to transfer the files uncompressed
+ * @param codec                   codec asked for the content
+ * @param count                   returns the number of operations
+ *
+ * @return                        operations, must be free()'d after usage,
+ *                                or NULL with a python exception set
+ */
+CLIENT_OP_T * client_batch_ops( PyObject * py_files, int type, int raw, int codec, int * count );
+
+/**
+ * Gets the list of results of the operations of a pipeline
+ *
+ * @param ops                     operations
+ * @param count                   number of operations
+ *
+ * @return                        python list
+ */
+PyObject * client_pipeline_results( CLIENT_OP_T * ops, int count );
+
+/**
+ * Gets the list of results of a batch, a (result, seconds) tuple for each file
+ *
+ * @param ops                     operations
+ * @param count                   number of operations
+ *
+ * @return                        python list
+ */
+PyObject * client_batch_results( CLIENT_OP_T * ops, int count );
+
 /**
  * Performs a 'File Receive' operation for the client
  *
  */
 PyObject * client_file_receive( PyObject * self, PyObject * args );
 
+/**
+ * Performs a 'File Receive' operation for a byte range of a file for the client
+ *
+ */
+PyObject * client_file_receive_range( PyObject * self, PyObject * args );
+
 /**
  * Performs a 'File Send' operation for the client
  *
  */
 PyObject * client_file_send( PyObject * self, PyObject * args );
 
+/**
+ * Performs a 'File Send' operation of a delta for the client
+ *
+ */
+PyObject * client_file_send_delta( PyObject * self, PyObject * args );
+
+/**
+ * Performs a striped 'File Send' operation for the client
+ *
+ */
+PyObject * client_file_send_striped( PyObject * self, PyObject * args );
+
 /**
  * Performs a 'File Delete' operation for the client on the server
  *
  */
 PyObject * client_file_delete( PyObject * self, PyObject * args );
 
+/**
+ * Performs operations for the client as a pipeline, getting their results
+ *
+ */
+PyObject * client_file_pipeline( PyObject * self, PyObject * args );
+
+/**
+ * Performs a batch of 'File Send' operations for the client
+ *
+ */
+PyObject * client_file_send_many( PyObject * self, PyObject * args );
+
+/**
+ * Performs a batch of 'File Receive' operations for the client
+ *
+ */
+PyObject * client_file_receive_many( PyObject * self, PyObject * args );
+
+/**
+ * Opens a connection handle to a server, on which operations
+ * are performed one after the other
+ *
+ */
+PyObject * client_connection_open( PyObject * self, PyObject * args );
+
+/**
+ * Closes the connection of a connection handle
+ *
+ */
+PyObject * client_connection_close( PyObject * self, PyObject * args );
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,687 @@
+/**
+ * codec.c
+ *
+ * $Id: $
+ * $Source: $
+ * $Revision: $
+ * $Date: $
+ * $Author: $
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "codec.h"
+#include "macros.h"
+#include "logger.h"
+
+#ifdef CODEC_ZSTD_ENABLED
+#include <zstd.h>
+#endif
+#ifdef CODEC_LZ4_ENABLED
+#include <lz4frame.h>
+#endif
+
+// Levels of zstd and lz4 for the compression modes store, fast, default and best,
+// lz4 accelerates with negative levels and uses its HC variant from level 3.
+// The best zstd level stays moderate, as its highest ones are tens of times
+// slower than deflate, and can still be set for every file by codec_configure
+static const int codec_mode_levels[CODEC_COUNT][4] = {
+  { 0, 0, 0, 0 },         // gzip, levels of gz_mode_level
+  { 1, 1, 3, 9 },         // zstd
+  { 0, -4, 0, 9 }         // lz4
+};
+
+static const char * codec_names[CODEC_COUNT] = { "gzip", "zstd", "lz4" };
+
+// Codec settings
+static CODEC_SETTINGS_T codec_settings[CODEC_COUNT];
+
+// Codecs the server accepts
+static int codec_allowed = CODEC_ALL;
+
+/**
+ * Configures a codec, to be called before any transfer
+ *
+ * @param codec           CODEC_GZIP, CODEC_ZSTD or CODEC_LZ4
+ * @param level           level used for every file, 0 to derive it
+ *                        from the compression mode of each one
+ * @param long_range      TRUE to enable the zstd long range mode
+ *
+ * @return                TRUE or FALSE if the codec is not available
+ */
+int codec_configure(int codec, int level, int long_range) {
+
+  if ( ! codec_available(codec) ) {
+    return FALSE;
+  }
+
+  codec_settings[codec].level = level;
+  codec_settings[codec].long_range = ( codec == CODEC_ZSTD && long_range );
+
+  return TRUE;
+
+}
+
+/**
+ * Sets the codecs the server accepts and uses, gzip is always
+ * accepted as it is the one of V1 and the fallback of V2
+ *
+ * @param codecs          comma separated codec names, or NULL for all of them
+ *
+ * @return                TRUE, or FALSE if a name is unknown
+ */
+int codec_allow(const char* codecs) {
+
+  char list[_BUFFER_SIZE_XS];
+  char * name;
+  char * next;
+  int allowed = ( 1 << CODEC_GZIP );
+  int codec;
+
+  if ( codecs == NULL ) {
+
+    codec_allowed = CODEC_ALL;
+    return TRUE;
+  }
+
+  snprintf(list, _BUFFER_SIZE_XS, "%s", codecs);
+
+  for ( name = strtok_r(list, ", ", &next); name != NULL; name = strtok_r(NULL, ", ", &next) ) {
+
+    codec = codec_by_name(name);
+    if ( codec < 0 ) {
+      return FALSE;
+    }
+
+    allowed |= ( 1 << codec );
+  }
+
+  codec_allowed = allowed;
+  return TRUE;
+
+}
+
+/**
+ * Chooses the codec for a request, the one asked for
+ * if the server accepts it, otherwise gzip
+ *
+ * @param codec           codec asked for by the client
+ *
+ * @return                codec to use
+ */
+int codec_negotiate(int codec) {
+
+  if ( codec_available(codec) && ( codec_allowed & ( 1 << codec ) ) ) {
+    return codec;
+  }
+
+  return CODEC_GZIP;
+
+}
+
+/**
+ * Evaluates if a codec is built in
+ *
+ * @param codec           codec
+ *
+ * @return                TRUE or FALSE
+ */
+int codec_available(int codec) {
+
+  switch (codec) {
+    case CODEC_GZIP:
+      return TRUE;
+#ifdef CODEC_ZSTD_ENABLED
+    case CODEC_ZSTD:
+      return TRUE;
+#endif
+#ifdef CODEC_LZ4_ENABLED
+    case CODEC_LZ4:
+      return TRUE;
+#endif
+    default:
+      return FALSE;
+  }
+
+}
+
+/**
+ * Gets a codec by its name
+ *
+ * @param name            gzip, zstd or lz4
+ *
+ * @return                codec, or -1 if the name is unknown
+ */
+int codec_by_name(const char* name) {
+
+  int codec;
+
+  for ( codec = 0; codec < CODEC_COUNT; codec++ ) {
+    if ( strcasecmp(name, codec_names[codec]) == 0 ) {
+      return codec;
+    }
+  }
+
+  return -1;
+
+}
+
+/**
+ * Gets the name of a codec
+ *
+ * @param codec           codec
+ *
+ * @return                codec name
+ */
+const char* codec_name(int codec) {
+
+  if ( codec < 0 || codec >= CODEC_COUNT ) {
+    return "unknown";
+  }
+
+  return codec_names[codec];
+
+}
+
+/**
+ * Gets the level a codec compresses a file with
+ *
+ * @param codec           codec
+ * @param mode            compression mode, GZ_MODE_*
+ *
+ * @return                level
+ */
+int codec_level(int codec, int mode) {
+
+  if ( codec < 0 || codec >= CODEC_COUNT ) {
+    return 0;
+  }
+
+  if ( codec_settings[codec].level != 0 ) {
+    return codec_settings[codec].level;
+  }
+
+  if ( codec == CODEC_GZIP ) {
+    return gz_mode_level(mode);
+  }
+
+  if ( mode < GZ_MODE_STORE || mode > GZ_MODE_BEST ) {
+    mode = GZ_MODE_DEFAULT;
+  }
+
+  return codec_mode_levels[codec][mode];
+
+}
+
+/**
+ * Initializes an incremental compression
+ *
+ * @param stream          codec state
+ * @param codec           codec
+ * @param mode            compression mode, GZ_MODE_*
+ *
+ * @return                TRUE or FALSE
+ */
+int codec_compress_init(CODEC_STREAM_T* stream, int codec, int mode) {
+
+  char buffer[_BUFFER_SIZE_S];
+
+  memset(stream, 0x00, sizeof(CODEC_STREAM_T));
+  stream->codec = codec;
+  stream->compress = TRUE;
+
+  if ( ! codec_available(codec) ) {
+
+    sprintf(buffer, "ERROR: codec %d is not available", codec);
+    LOGGER(__FUNCTION__, buffer);
+    return FALSE;
+  }
+
+  switch (codec) {
+
+#ifdef CODEC_ZSTD_ENABLED
+    case CODEC_ZSTD: {
+
+      ZSTD_CCtx * context = ZSTD_createCCtx();
+
+      if ( context == NULL ||
+           ZSTD_isError(ZSTD_CCtx_setParameter(context, ZSTD_c_compressionLevel, codec_level(codec, mode))) ||
+           ( codec_settings[codec].long_range &&
+             ( ZSTD_isError(ZSTD_CCtx_setParameter(context, ZSTD_c_enableLongDistanceMatching, 1)) ||
+               ZSTD_isError(ZSTD_CCtx_setParameter(context, ZSTD_c_windowLog, CODEC_ZSTD_LONG_WINDOW_LOG)) ) ) ) {
+
+        LOGGER(__FUNCTION__, "ERROR: in ZSTD_createCCtx");
+        ZSTD_freeCCtx(context);
+        return FALSE;
+      }
+
+      stream->context = context;
+      stream->buffer_size = CODEC_BUFFER_SIZE;
+      break;
+    }
+#endif
+
+#ifdef CODEC_LZ4_ENABLED
+    case CODEC_LZ4: {
+
+      LZ4F_cctx * context = NULL;
+      LZ4F_preferences_t preferences;
+
+      memset(&preferences, 0x00, sizeof(LZ4F_preferences_t));
+      preferences.compressionLevel = codec_level(codec, mode);
+      preferences.frameInfo.blockSizeID = LZ4F_max64KB;
+      preferences.frameInfo.contentChecksumFlag = LZ4F_contentChecksumEnabled;
+
+      if ( LZ4F_isError(LZ4F_createCompressionContext(&context, LZ4F_VERSION)) ) {
+
+        LOGGER(__FUNCTION__, "ERROR: in LZ4F_createCompressionContext");
+        return FALSE;
+      }
+
+      stream->context = context;
+      stream->buffer_size = LZ4F_compressBound(CODEC_BUFFER_SIZE, &preferences);
+      stream->buffer = (unsigned char*)malloc(stream->buffer_size);
+      stream->initialized = TRUE;
+
+      if ( stream->buffer == NULL ) {
+
+        LOGGER(__FUNCTION__, "ERROR: not enough memory for the lz4 buffer");
+        codec_end(stream);
+        return FALSE;
+      }
+
+      // The frame header is written by the first compression
+      stream->pending = LZ4F_compressBegin(context, stream->buffer, stream->buffer_size, &preferences);
+      if ( LZ4F_isError(stream->pending) ) {
+
+        LOGGER(__FUNCTION__, "ERROR: in LZ4F_compressBegin");
+        codec_end(stream);
+        return FALSE;
+      }
+      return TRUE;
+    }
+#endif
+
+    default:
+      if ( ! gz_deflate_stream_init(&stream->gz_stream, codec_level(codec, mode)) ) {
+        return FALSE;
+      }
+      break;
+  }
+
+  stream->initialized = TRUE;
+
+  if ( stream->buffer_size > 0 ) {
+
+    stream->buffer = (unsigned char*)malloc(stream->buffer_size);
+    if ( stream->buffer == NULL ) {
+
+      LOGGER(__FUNCTION__, "ERROR: not enough memory for the codec buffer");
+      codec_end(stream);
+      return FALSE;
+    }
+  }
+
+  return TRUE;
+
+}
+
+/**
+ * Compresses a fragment of data, passing the
+ * compressed output to the writer as it is produced
+ *
+ * @param stream          codec state
+ * @param in              data fragment
+ * @param in_len          fragment length
+ * @param finish          TRUE for the last fragment, completes the compressed data
+ * @param writer          function that receives the output
+ * @param writer_arg      argument for the writer
+ *
+ * @return                TRUE or FALSE
+ */
+int codec_compress(CODEC_STREAM_T* stream, const unsigned char* in, size_t in_len, int finish, CODEC_WRITER_T writer, void* writer_arg) {
+
+  char buffer[_BUFFER_SIZE_S];
+
+  switch (stream->codec) {
+
+#ifdef CODEC_ZSTD_ENABLED
+    case CODEC_ZSTD: {
+
+      ZSTD_inBuffer input = { in, in_len, 0 };
+      ZSTD_outBuffer output;
+      size_t remaining;
+
+      do {
+
+        output.dst = stream->buffer;
+        output.size = stream->buffer_size;
+        output.pos = 0;
+
+        remaining = ZSTD_compressStream2((ZSTD_CCtx*)stream->context, &output, &input, ( finish ) ? ZSTD_e_end : ZSTD_e_continue);
+        if ( ZSTD_isError(remaining) ) {
+
+          sprintf(buffer, "ERROR: zstd compression failed (%s)", ZSTD_getErrorName(remaining));
+          LOGGER(__FUNCTION__, buffer);
+          return FALSE;
+        }
+
+        if ( output.pos > 0 && ! writer(writer_arg, stream->buffer, output.pos) ) {
+          return FALSE;
+        }
+
+      } while ( ( finish ) ? remaining > 0 : input.pos < input.size );
+
+      stream->finished = finish;
+      return TRUE;
+    }
+#endif
+
+#ifdef CODEC_LZ4_ENABLED
+    case CODEC_LZ4: {
+
+      size_t part;
+      size_t res;
+
+      if ( stream->pending > 0 ) {
+
+        if ( ! writer(writer_arg, stream->buffer, stream->pending) ) {
+          return FALSE;
+        }
+        stream->pending = 0;
+      }
+
+      // The buffer holds the output of at most CODEC_BUFFER_SIZE bytes
+      while ( in_len > 0 || finish ) {
+
+        part = ( in_len > CODEC_BUFFER_SIZE ) ? CODEC_BUFFER_SIZE : in_len;
+
+        if ( part > 0 ) {
+          res = LZ4F_compressUpdate((LZ4F_cctx*)stream->context, stream->buffer, stream->buffer_size, in, part, NULL);
+        }
+        else {
+          res = LZ4F_compressEnd((LZ4F_cctx*)stream->context, stream->buffer, stream->buffer_size, NULL);
+        }
+
+        if ( LZ4F_isError(res) ) {
+
+          sprintf(buffer, "ERROR: lz4 compression failed (%s)", LZ4F_getErrorName(res));
+          LOGGER(__FUNCTION__, buffer);
+          return FALSE;
+        }
+
+        if ( res > 0 && ! writer(writer_arg, stream->buffer, res) ) {
+          return FALSE;
+        }
+
+        if ( part == 0 ) {
+
+          stream->finished = TRUE;
+          break;
+        }
+
+        in += part;
+        in_len -= part;
+      }
+
+      return TRUE;
+    }
+#endif
+
+    default:
+      return gz_deflate_stream(&stream->gz_stream, in, in_len, finish, writer, writer_arg);
+  }
+
+}
+
+/**
+ * Initializes an incremental decompression
+ *
+ * @param stream          codec state
+ * @param codec           codec
+ *
+ * @return                TRUE or FALSE
+ */
+int codec_decompress_init(CODEC_STREAM_T* stream, int codec) {
+
+  char buffer[_BUFFER_SIZE_S];
+
+  memset(stream, 0x00, sizeof(CODEC_STREAM_T));
+  stream->codec = codec;
+  stream->compress = FALSE;
+
+  if ( ! codec_available(codec) ) {
+
+    sprintf(buffer, "ERROR: codec %d is not available", codec);
+    LOGGER(__FUNCTION__, buffer);
+    return FALSE;
+  }
+
+  switch (codec) {
+
+#ifdef CODEC_ZSTD_ENABLED
+    case CODEC_ZSTD: {
+
+      ZSTD_DCtx * context = ZSTD_createDCtx();
+
+      // Accepts the window of the long range mode, whatever the library default
+      if ( context == NULL ||
+           ZSTD_isError(ZSTD_DCtx_setParameter(context, ZSTD_d_windowLogMax, CODEC_ZSTD_LONG_WINDOW_LOG)) ) {
+
+        LOGGER(__FUNCTION__, "ERROR: in ZSTD_createDCtx");
+        ZSTD_freeDCtx(context);
+        return FALSE;
+      }
+
+      stream->context = context;
+      break;
+    }
+#endif
+
+#ifdef CODEC_LZ4_ENABLED
+    case CODEC_LZ4: {
+
+      LZ4F_dctx * context = NULL;
+
+      if ( LZ4F_isError(LZ4F_createDecompressionContext(&context, LZ4F_VERSION)) ) {
+
+        LOGGER(__FUNCTION__, "ERROR: in LZ4F_createDecompressionContext");
+        return FALSE;
+      }
+
+      stream->context = context;
+      break;
+    }
+#endif
+
+    default:
+      if ( ! gz_inflate_stream_init(&stream->gz_stream) ) {
+        return FALSE;
+      }
+      stream->initialized = TRUE;
+      return TRUE;
+  }
+
+  stream->buffer_size = CODEC_BUFFER_SIZE;
+  stream->buffer = (unsigned char*)malloc(stream->buffer_size);
+  stream->initialized = TRUE;
+
+  if ( stream->buffer == NULL ) {
+
+    LOGGER(__FUNCTION__, "ERROR: not enough memory for the codec buffer");
+    codec_end(stream);
+    return FALSE;
+  }
+
+  return TRUE;
+
+}
+
+/**
+ * Decompresses a fragment of compressed data, passing
+ * the output to the writer as it is produced
+ *
+ * @param stream          codec state
+ * @param in              compressed fragment
+ * @param in_len          fragment length
+ * @param writer          function that receives the output
+ * @param writer_arg      argument for the writer
+ *
+ * @return                TRUE or FALSE
+ */
+int codec_decompress(CODEC_STREAM_T* stream, const unsigned char* in, size_t in_len, CODEC_WRITER_T writer, void* writer_arg) {
+
+  char buffer[_BUFFER_SIZE_S];
+
+  switch (stream->codec) {
+
+#ifdef CODEC_ZSTD_ENABLED
+    case CODEC_ZSTD: {
+
+      ZSTD_inBuffer input = { in, in_len, 0 };
+      ZSTD_outBuffer output;
+      size_t consumed;
+      size_t res;
+
+      if ( in_len == 0 ) {
+        return TRUE;
+      }
+
+      // Frames following a complete one are decompressed as well
+      do {
+
+        consumed = input.pos;
+        output.dst = stream->buffer;
+        output.size = stream->buffer_size;
+        output.pos = 0;
+
+        res = ZSTD_decompressStream((ZSTD_DCtx*)stream->context, &output, &input);
+        if ( ZSTD_isError(res) ) {
+
+          sprintf(buffer, "ERROR: zstd decompression failed (%s)", ZSTD_getErrorName(res));
+          LOGGER(__FUNCTION__, buffer);
+          return FALSE;
+        }
+
+        if ( output.pos > 0 && ! writer(writer_arg, stream->buffer, output.pos) ) {
+          return FALSE;
+        }
+
+        // A call that only checked for more output says nothing of the frame
+        if ( input.pos > consumed || output.pos > 0 ) {
+          stream->finished = ( res == 0 );
+        }
+
+      } while ( input.pos < input.size || output.pos == output.size );
+
+      return TRUE;
+    }
+#endif
+
+#ifdef CODEC_LZ4_ENABLED
+    case CODEC_LZ4: {
+
+      size_t in_part;
+      size_t out_len;
+      size_t res;
+
+      if ( in_len == 0 ) {
+        return TRUE;
+      }
+
+      do {
+
+        in_part = in_len;
+        out_len = stream->buffer_size;
+
+        res = LZ4F_decompress((LZ4F_dctx*)stream->context, stream->buffer, &out_len, in, &in_part, NULL);
+        if ( LZ4F_isError(res) ) {
+
+          sprintf(buffer, "ERROR: lz4 decompression failed (%s)", LZ4F_getErrorName(res));
+          LOGGER(__FUNCTION__, buffer);
+          return FALSE;
+        }
+
+        if ( out_len > 0 && ! writer(writer_arg, stream->buffer, out_len) ) {
+          return FALSE;
+        }
+
+        if ( in_part > 0 || out_len > 0 ) {
+          stream->finished = ( res == 0 );
+        }
+
+        in += in_part;
+        in_len -= in_part;
+
+      } while ( in_len > 0 || out_len == stream->buffer_size );
+
+      return TRUE;
+    }
+#endif
+
+    default:
+      return gz_inflate_stream(&stream->gz_stream, in, in_len, writer, writer_arg);
+  }
+
+}
+
+/**
+ * Finalizes an incremental compression or decompression
+ * and releases its resources, can be called more than once
+ *
+ * @param stream          codec state
+ *
+ * @return                TRUE if the compressed data was complete, otherwise FALSE
+ */
+int codec_end(CODEC_STREAM_T* stream) {
+
+  int complete = stream->finished;
+
+  if ( ! stream->initialized ) {
+    return FALSE;
+  }
+
+  switch (stream->codec) {
+
+#ifdef CODEC_ZSTD_ENABLED
+    case CODEC_ZSTD:
+      if ( stream->compress ) {
+        ZSTD_freeCCtx((ZSTD_CCtx*)stream->context);
+      }
+      else {
+        ZSTD_freeDCtx((ZSTD_DCtx*)stream->context);
+      }
+      break;
+#endif
+
+#ifdef CODEC_LZ4_ENABLED
+    case CODEC_LZ4:
+      if ( stream->compress ) {
+        LZ4F_freeCompressionContext((LZ4F_cctx*)stream->context);
+      }
+      else {
+        LZ4F_freeDecompressionContext((LZ4F_dctx*)stream->context);
+      }
+      break;
+#endif
+
+    default:
+      complete = ( stream->compress ) ? gz_deflate_stream_end(&stream->gz_stream) : gz_inflate_stream_end(&stream->gz_stream);
+      break;
+  }
+
+  if ( stream->buffer != NULL ) {
+    free(stream->buffer);
+  }
+
+  stream->context = NULL;
+  stream->buffer = NULL;
+  stream->initialized = FALSE;
+
+  return complete;
+
+}
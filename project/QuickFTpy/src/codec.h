@@ -0,0 +1,211 @@
+/**
+ * codec.h
+ *
+ * $Id: $
+ * $Source: $
+ * $Revision: $
+ * $Date: $
+ * $Author: $
+ *
+ */
+
+#ifndef _CODEC_H
+#define _CODEC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdio.h>
+
+#include "gz.h"
+
+// zstd and lz4 are built in unless disabled, gzip always is
+#if !defined(CODEC_NO_ZSTD)
+#  define CODEC_ZSTD_ENABLED
+#endif
+#if !defined(CODEC_NO_LZ4)
+#  define CODEC_LZ4_ENABLED
+#endif
+
+// Codecs, identifiers are part of the V2 protocol
+#define CODEC_GZIP                0
+#define CODEC_ZSTD                1
+#define CODEC_LZ4                 2
+#define CODEC_COUNT               3
+
+// Set of every codec, as a mask of ( 1 << codec )
+#define CODEC_ALL                 ( ( 1 << CODEC_COUNT ) - 1 )
+
+// Window of the zstd long range mode, 128 MB, the largest
+// a decompressor accepts without being told beforehand
+#define CODEC_ZSTD_LONG_WINDOW_LOG  27
+
+// Size of the buffers for the output of zstd and the input of lz4
+#define CODEC_BUFFER_SIZE         65536
+
+// Receives the output of a codec stream, returns TRUE or FALSE
+typedef int (*CODEC_WRITER_T)(void * arg, const unsigned char * data, size_t len);
+
+/**
+ * Settings of a codec
+ */
+typedef struct _codec_settings_t {
+
+  int level;                // level of every file, 0 to derive it from the mode
+  int long_range;           // TRUE for the zstd long range mode
+
+} CODEC_SETTINGS_T;
+
+/**
+ * State of an incremental compression or decompression
+ */
+typedef struct _codec_stream_t {
+
+  int codec;
+  int compress;
+  int initialized;
+  int finished;
+
+  GZ_STREAM_T gz_stream;    // gzip state
+  void * context;           // zstd or lz4 context
+  unsigned char * buffer;   // output of zstd and lz4
+  size_t buffer_size;
+  size_t pending;           // output in the buffer not yet written, the lz4 frame header
+
+} CODEC_STREAM_T;
+
+/**
+ * Configures a codec, to be called before any transfer
+ *
+ * @param codec           CODEC_GZIP, CODEC_ZSTD or CODEC_LZ4
+ * @param level           level used for every file, 0 to derive it
+ *                        from the compression mode of each one
+ * @param long_range      TRUE to enable the zstd long range mode
+ *
+ * @return                TRUE or FALSE if the codec is not available
+ */
+int codec_configure(int codec, int level, int long_range);
+
+/**
+ * Sets the codecs the server accepts and uses, gzip is always
+ * accepted as it is the one of V1 and the fallback of V2
+ *
+ * @param codecs          comma separated codec names, or NULL for all of them
+ *
+ * @return                TRUE, or FALSE if a name is unknown
+ */
+int codec_allow(const char* codecs);
+
+/**
+ * Chooses the codec for a request, the one asked for
+ * if the server accepts it, otherwise gzip
+ *
+ * @param codec           codec asked for by the client
+ *
+ * @return                codec to use
+ */
+int codec_negotiate(int codec);
+
+/**
+ * Evaluates if a codec is built in
+ *
+ * @param codec           codec
+ *
+ * @return                TRUE or FALSE
+ */
+int codec_available(int codec);
+
+/**
+ * Gets a codec by its name
+ *
+ * @param name            gzip, zstd or lz4
+ *
+ * @return                codec, or -1 if the name is unknown
+ */
+int codec_by_name(const char* name);
+
+/**
+ * Gets the level a codec compresses a file with
+ *
+ * @param codec           codec
+ * @param mode            compression mode, GZ_MODE_*
+ *
+ * @return                level
+ */
+int codec_level(int codec, int mode);
+
+/**
+ * Gets the name of a codec
+ *
+ * @param codec           codec
+ *
+ * @return                codec name
+ */
+const char* codec_name(int codec);
+
+/**
+ * Initializes an incremental compression
+ *
+ * @param stream          codec state
+ * @param codec           codec
+ * @param mode            compression mode, GZ_MODE_*
+ *
+ * @return                TRUE or FALSE
+ */
+int codec_compress_init(CODEC_STREAM_T* stream, int codec, int mode);
+
+/**
+ * Compresses a fragment of data, passing the
+ * compressed output to the writer as it is produced
+ *
+ * @param stream          codec state
+ * @param in              data fragment
+ * @param in_len          fragment length
+ * @param finish          TRUE for the last fragment, completes the compressed data
+ * @param writer          function that receives the output
+ * @param writer_arg      argument for the writer
+ *
+ * @return                TRUE or FALSE
+ */
+int codec_compress(CODEC_STREAM_T* stream, const unsigned char* in, size_t in_len, int finish, CODEC_WRITER_T writer, void* writer_arg);
+
+/**
+ * Initializes an incremental decompression
+ *
+ * @param stream          codec state
+ * @param codec           codec
+ *
+ * @return                TRUE or FALSE
+ */
+int codec_decompress_init(CODEC_STREAM_T* stream, int codec);
+
+/**
+ * Decompresses a fragment of compressed data, passing
+ * the output to the writer as it is produced
+ *
+ * @param stream          codec state
+ * @param in              compressed fragment
+ * @param in_len          fragment length
+ * @param writer          function that receives the output
+ * @param writer_arg      argument for the writer
+ *
+ * @return                TRUE or FALSE
+ */
+int codec_decompress(CODEC_STREAM_T* stream, const unsigned char* in, size_t in_len, CODEC_WRITER_T writer, void* writer_arg);
+
+/**
+ * Finalizes an incremental compression or decompression
+ * and releases its resources, can be called more than once
+ *
+ * @param stream          codec state
+ *
+ * @return                TRUE if the compressed data was complete, otherwise FALSE
+ */
+int codec_end(CODEC_STREAM_T* stream);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // _CODEC_H
@@ -0,0 +1,606 @@
+/*
+ * delta.c
+ *
+ * $Id: $
+ * $HeadURL: $
+ * $LastChangedRevision: $
+ * $LastChangedDate: $
+ * $LastChangedBy: $
+ *
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE 1
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "delta.h"
+#include "message.h"
+#include "macros.h"
+#include "logger.h"
+
+// Size of the buffer for the blocks copied from the current file
+#define DELTA_COPY_BUFFER_SIZE    262144
+
+/**
+ * Computes the weak checksum of a block, the one of rsync, made of the sum
+ * of its bytes and the sum of those sums, both modulo 2^16
+ *
+ * @param data            block
+ * @param len             block length
+ * @param a               returns the sum of the bytes
+ * @param b               returns the sum of the sums
+ *
+ * @return                checksum
+ */
+static unsigned long delta_weak( const unsigned char * data, long len, unsigned long * a, unsigned long * b ) {
+
+  unsigned long s1 = 0;
+  unsigned long s2 = 0;
+  long i;
+
+  for ( i = 0; i < len; i++ ) {
+
+    s1 += data[i];
+    s2 += s1;
+  }
+
+  *a = s1 & 0xFFFF;
+  *b = s2 & 0xFFFF;
+
+  return *a | ( *b << 16 );
+}
+
+/**
+ * Computes the strong hash of a block, 64 bits FNV-1a
+ *
+ * @param data            block
+ * @param len             block length
+ *
+ * @return                hash
+ */
+static unsigned long long delta_strong( const unsigned char * data, long len ) {
+
+  unsigned long long hash = 0xCBF29CE484222325ULL;
+  long i;
+
+  for ( i = 0; i < len; i++ ) {
+
+    hash ^= data[i];
+    hash *= 0x100000001B3ULL;
+  }
+
+  return hash;
+}
+
+/**
+ * Gets the strong hash of the entry of a block in a signature
+ *
+ * @param entry           entry of the block
+ *
+ * @return                hash
+ */
+static unsigned long long delta_entry_strong( const unsigned char * entry ) {
+
+  return ( (unsigned long long)GET_UINT32((const char *)&entry[4]) << 32 ) | GET_UINT32((const char *)&entry[8]);
+}
+
+/**
+ * Slot of a weak checksum in the table of the blocks of a signature
+ *
+ * @param weak            weak checksum
+ * @param mask            size of the table minus one
+ *
+ * @return                slot
+ */
+static unsigned long delta_slot( unsigned long weak, unsigned long mask ) {
+
+  return ( ( weak ^ ( weak >> 16 ) ) * 0x9E3779B1UL >> 7 ) & mask;
+}
+
+/**
+ * Chooses the block size of the signature of a file, growing with
+ * the square root of its size within the bounds of the block size
+ *
+ * @param file_len        size of the file
+ *
+ * @return                block size
+ */
+long delta_block_size( long long file_len ) {
+
+  long block_size = DELTA_BLOCK_MINIMUM_SIZE;
+
+  // Multiples of 1 KB keep the reads of the blocks aligned
+  while ( block_size < DELTA_BLOCK_MAXIMUM_SIZE && (long long)block_size * block_size < file_len ) {
+    block_size += 1024;
+  }
+
+  return block_size;
+}
+
+/**
+ * Computes the signature of a file, made of an entry for each
+ * of its whole blocks, the last partial one being left out
+ *
+ * @param fd              descriptor of the file
+ * @param file_len        size of the file
+ * @param block_size      block size
+ * @param signature       returns the signature, must be free()d after usage
+ * @param signature_len   returns the length of the signature
+ *
+ * @return                TRUE or FALSE
+ */
+int delta_signature( int fd, long long file_len, long block_size, unsigned char ** signature, unsigned long * signature_len ) {
+
+  unsigned char * block;
+  unsigned char * entry;
+  unsigned long long strong;
+  unsigned long count;
+  unsigned long a;
+  unsigned long b;
+  unsigned long i;
+  ssize_t bread;
+  long done;
+
+  *signature = NULL;
+  *signature_len = 0;
+
+  if ( block_size < DELTA_BLOCK_MINIMUM_SIZE || block_size > DELTA_BLOCK_MAXIMUM_SIZE ) {
+    return FALSE;
+  }
+
+  count = (unsigned long)( file_len / block_size );
+
+  block = (unsigned char *)malloc(block_size);
+  *signature = (unsigned char *)malloc(count * DELTA_SIGNATURE_ENTRY_LEN + 1);
+  if ( block == NULL || *signature == NULL ) {
+
+    free(block);
+    free(*signature);
+    *signature = NULL;
+    return FALSE;
+  }
+
+  for ( i = 0; i < count; i++ ) {
+
+    for ( done = 0; done < block_size; done += bread ) {
+
+      bread = pread(fd, &block[done], block_size - done, (off_t)i * block_size + done);
+      if ( bread <= 0 ) {
+
+        free(block);
+        free(*signature);
+        *signature = NULL;
+        return FALSE;
+      }
+    }
+
+    entry = &(*signature)[i * DELTA_SIGNATURE_ENTRY_LEN];
+    strong = delta_strong(block, block_size);
+
+    PUT_UINT32((char *)entry, delta_weak(block, block_size, &a, &b));
+    PUT_UINT32((char *)&entry[4], (unsigned long)( strong >> 32 ));
+    PUT_UINT32((char *)&entry[8], (unsigned long)( strong & 0xFFFFFFFFULL ));
+  }
+
+  free(block);
+
+  *signature_len = count * DELTA_SIGNATURE_ENTRY_LEN;
+
+  return TRUE;
+}
+
+/**
+ * Writes a delta instruction with its arguments
+ *
+ * @param delta           stream the delta is written to
+ * @param op              instruction code
+ * @param arg1            first argument
+ * @param arg2            second argument, or -1 if it has a single one
+ *
+ * @return                TRUE or FALSE
+ */
+static int delta_put_op( FILE * delta, int op, unsigned long arg1, long arg2 ) {
+
+  char instruction[9];
+  size_t len = 5;
+
+  instruction[0] = (char)op;
+  PUT_UINT32(&instruction[1], arg1);
+
+  if ( arg2 >= 0 ) {
+
+    PUT_UINT32(&instruction[5], (unsigned long)arg2);
+    len = 9;
+  }
+
+  return ( fwrite(instruction, 1, len, delta) == len );
+}
+
+/**
+ * Writes a run of copied blocks, if any, followed by the data
+ * inserted before the next block copied or the end of the file
+ *
+ * @param delta           stream the delta is written to
+ * @param run_first       first block of the run, reset
+ * @param run_count       number of blocks of the run, reset
+ * @param data            data inserted
+ * @param len             length of the data
+ *
+ * @return                TRUE or FALSE
+ */
+static int delta_put_pending( FILE * delta, long * run_first, long * run_count, const unsigned char * data, long long len ) {
+
+  long chunk;
+
+  if ( *run_count > 0 && ! delta_put_op(delta, DELTA_OP_COPY, (unsigned long)*run_first, *run_count) ) {
+    return FALSE;
+  }
+  *run_count = 0;
+
+  while ( len > 0 ) {
+
+    chunk = ( len > DELTA_LITERAL_MAXIMUM_LEN ) ? DELTA_LITERAL_MAXIMUM_LEN : (long)len;
+
+    if ( ! delta_put_op(delta, DELTA_OP_LITERAL, (unsigned long)chunk, -1) ||
+         fwrite(data, 1, chunk, delta) != (size_t)chunk ) {
+      return FALSE;
+    }
+
+    data += chunk;
+    len -= chunk;
+  }
+
+  return TRUE;
+}
+
+/**
+ * Writes the delta that rebuilds a file from the one a signature was
+ * computed for, copying the blocks they share and inserting the rest
+ *
+ * The blocks of the signature are found at any offset of the new file by
+ * rolling the weak checksum one byte at a time, a block being matched once
+ * its strong hash is also the same. The block that follows the last one
+ * matched is tried first, so that unchanged parts become a single run.
+ *
+ * @param fd              descriptor of the new file
+ * @param file_len        size of the new file
+ * @param signature       signature of the current file
+ * @param signature_len   length of the signature
+ * @param block_size      block size of the signature
+ * @param delta           stream the delta is written to
+ * @param literal_len     returns the length of the data inserted
+ *
+ * @return                TRUE or FALSE
+ */
+int delta_generate( int fd, long long file_len, const unsigned char * signature, unsigned long signature_len, long block_size, FILE * delta, long long * literal_len ) {
+
+  const unsigned char * data = NULL;
+  const unsigned char * entry;
+  long * heads = NULL;
+  long * chain = NULL;
+
+  unsigned long count = signature_len / DELTA_SIGNATURE_ENTRY_LEN;
+  unsigned long mask = 1023;
+  unsigned long weak = 0;
+  unsigned long a = 0;
+  unsigned long b = 0;
+  unsigned long long strong = 0;
+  long long pos = 0;
+  long long literal_start = 0;
+  long run_first = 0;
+  long run_count = 0;
+  long expected = -1;
+  long match;
+  long i;
+  int has_strong;
+  int result = FALSE;
+
+  *literal_len = 0;
+
+  if ( block_size < DELTA_BLOCK_MINIMUM_SIZE || block_size > DELTA_BLOCK_MAXIMUM_SIZE ) {
+    return FALSE;
+  }
+
+  if ( file_len > 0 ) {
+
+    data = (const unsigned char *)mmap(NULL, (size_t)file_len, PROT_READ, MAP_PRIVATE, fd, 0);
+    if ( data == (const unsigned char *)MAP_FAILED ) {
+
+      LOGGER(__FUNCTION__, "ERROR: File could not be mapped.");
+      return FALSE;
+    }
+    madvise((void *)data, (size_t)file_len, MADV_SEQUENTIAL);
+  }
+
+  // Chains the blocks by the slot of their weak checksum,
+  // the table having at least twice as many slots as blocks
+  while ( mask < count * 2 ) {
+    mask = ( mask << 1 ) | 1;
+  }
+
+  heads = (long *)malloc(( mask + 1 ) * sizeof(long));
+  chain = (long *)malloc(( count + 1 ) * sizeof(long));
+  if ( heads == NULL || chain == NULL ) {
+    goto END_DELTA_GENERATE;
+  }
+
+  memset(heads, 0xFF, ( mask + 1 ) * sizeof(long));
+
+  for ( i = (long)count - 1; i >= 0; i-- ) {
+
+    entry = &signature[i * DELTA_SIGNATURE_ENTRY_LEN];
+    chain[i] = heads[delta_slot(GET_UINT32((const char *)entry), mask)];
+    heads[delta_slot(GET_UINT32((const char *)entry), mask)] = i;
+  }
+
+  if ( count > 0 && file_len >= block_size ) {
+    weak = delta_weak(data, block_size, &a, &b);
+  }
+
+  while ( count > 0 && pos + block_size <= file_len ) {
+
+    match = -1;
+    has_strong = FALSE;
+
+    if ( expected >= 0 && expected < (long)count &&
+         GET_UINT32((const char *)&signature[expected * DELTA_SIGNATURE_ENTRY_LEN]) == weak ) {
+
+      strong = delta_strong(&data[pos], block_size);
+      has_strong = TRUE;
+
+      if ( delta_entry_strong(&signature[expected * DELTA_SIGNATURE_ENTRY_LEN]) == strong ) {
+        match = expected;
+      }
+    }
+
+    for ( i = heads[delta_slot(weak, mask)]; match == -1 && i != -1; i = chain[i] ) {
+
+      entry = &signature[i * DELTA_SIGNATURE_ENTRY_LEN];
+      if ( GET_UINT32((const char *)entry) != weak ) {
+        continue;
+      }
+
+      if ( ! has_strong ) {
+
+        strong = delta_strong(&data[pos], block_size);
+        has_strong = TRUE;
+      }
+      if ( delta_entry_strong(entry) == strong ) {
+        match = i;
+      }
+    }
+
+    if ( match >= 0 ) {
+
+      // Whatever was not matched before the block is inserted
+      if ( pos > literal_start ) {
+
+        if ( ! delta_put_pending(delta, &run_first, &run_count, &data[literal_start], pos - literal_start) ) {
+          goto END_DELTA_GENERATE;
+        }
+        *literal_len += pos - literal_start;
+      }
+
+      if ( run_count > 0 && match == run_first + run_count ) {
+        run_count++;
+      }
+      else {
+
+        if ( ! delta_put_pending(delta, &run_first, &run_count, NULL, 0) ) {
+          goto END_DELTA_GENERATE;
+        }
+        run_first = match;
+        run_count = 1;
+      }
+
+      pos += block_size;
+      literal_start = pos;
+      expected = match + 1;
+
+      if ( pos + block_size <= file_len ) {
+        weak = delta_weak(&data[pos], block_size, &a, &b);
+      }
+      continue;
+    }
+
+    // Rolls the checksum over to the next byte
+    if ( pos + block_size < file_len ) {
+
+      a = ( a - data[pos] + data[pos + block_size] ) & 0xFFFF;
+      b = ( b - (unsigned long)block_size * data[pos] + a ) & 0xFFFF;
+      weak = a | ( b << 16 );
+    }
+    pos++;
+
+    // Data that matches nothing is inserted as it goes
+    if ( pos - literal_start >= DELTA_LITERAL_MAXIMUM_LEN ) {
+
+      if ( ! delta_put_pending(delta, &run_first, &run_count, &data[literal_start], pos - literal_start) ) {
+        goto END_DELTA_GENERATE;
+      }
+      *literal_len += pos - literal_start;
+      literal_start = pos;
+    }
+  }
+
+  // The rest of the file is inserted
+  if ( ! delta_put_pending(delta, &run_first, &run_count, ( data != NULL ) ? &data[literal_start] : NULL, file_len - literal_start) ||
+       fputc(DELTA_OP_END, delta) == EOF || fflush(delta) != 0 ) {
+    goto END_DELTA_GENERATE;
+  }
+  *literal_len += file_len - literal_start;
+
+  result = TRUE;
+
+END_DELTA_GENERATE:
+
+  if ( data != NULL ) {
+    munmap((void *)data, (size_t)file_len);
+  }
+  free(heads);
+  free(chain);
+
+  return result;
+}
+
+/**
+ * Writes data to a file
+ *
+ * @param fd              descriptor of the file
+ * @param data            data
+ * @param len             data length
+ *
+ * @return                TRUE or FALSE
+ */
+static int delta_write( int fd, const unsigned char * data, size_t len ) {
+
+  ssize_t bwritten;
+
+  while ( len > 0 ) {
+
+    bwritten = write(fd, data, len);
+    if ( bwritten <= 0 ) {
+      return FALSE;
+    }
+
+    data += bwritten;
+    len -= bwritten;
+  }
+
+  return TRUE;
+}
+
+/**
+ * Rebuilds a file from the current one and a delta against it
+ *
+ * @param basis_fd        descriptor of the current file
+ * @param basis_len       size of the current file
+ * @param delta           stream the delta is read from
+ * @param block_size      block size of the signature the delta refers to
+ * @param out_fd          descriptor of the file rebuilt
+ * @param out_len         returns the size of the file rebuilt
+ *
+ * @return                TRUE, or FALSE if the delta is invalid or
+ *                        either file could not be read or written
+ */
+int delta_apply( int basis_fd, long long basis_len, FILE * delta, long block_size, int out_fd, long long * out_len ) {
+
+  unsigned char * buffer;
+  char args[8];
+  long long blocks;
+  long long offset;
+  long long len;
+  size_t chunk;
+  ssize_t bread;
+  int op;
+  int result = FALSE;
+
+  *out_len = 0;
+
+  if ( block_size < DELTA_BLOCK_MINIMUM_SIZE || block_size > DELTA_BLOCK_MAXIMUM_SIZE ) {
+    return FALSE;
+  }
+
+  blocks = basis_len / block_size;
+
+  buffer = (unsigned char *)malloc(DELTA_COPY_BUFFER_SIZE);
+  if ( buffer == NULL ) {
+    return FALSE;
+  }
+
+  while ( ( op = fgetc(delta) ) != EOF ) {
+
+    if ( op == DELTA_OP_END ) {
+
+      result = TRUE;
+      break;
+    }
+
+    //
+    // Copies a run of blocks of the current file
+    //
+    if ( op == DELTA_OP_COPY ) {
+
+      if ( fread(args, 1, 8, delta) != 8 ) {
+        break;
+      }
+
+      offset = (long long)GET_UINT32(args);
+      len = (long long)GET_UINT32(&args[4]);
+
+      if ( len <= 0 || offset + len > blocks ) {
+
+        LOGGER(__FUNCTION__, "ERROR: Delta refers to blocks beyond the current file.");
+        break;
+      }
+
+      offset *= block_size;
+      len *= block_size;
+
+      while ( len > 0 ) {
+
+        chunk = ( len > DELTA_COPY_BUFFER_SIZE ) ? DELTA_COPY_BUFFER_SIZE : (size_t)len;
+
+        bread = pread(basis_fd, buffer, chunk, (off_t)offset);
+        if ( bread <= 0 || ! delta_write(out_fd, buffer, (size_t)bread) ) {
+          break;
+        }
+
+        offset += bread;
+        len -= bread;
+        *out_len += bread;
+      }
+
+      if ( len > 0 ) {
+        break;
+      }
+      continue;
+    }
+
+    //
+    // Inserts the data that follows the instruction
+    //
+    if ( op == DELTA_OP_LITERAL ) {
+
+      if ( fread(args, 1, 4, delta) != 4 ) {
+        break;
+      }
+
+      len = (long long)GET_UINT32(args);
+      if ( len > DELTA_LITERAL_MAXIMUM_LEN ) {
+        break;
+      }
+
+      while ( len > 0 ) {
+
+        chunk = ( len > DELTA_COPY_BUFFER_SIZE ) ? DELTA_COPY_BUFFER_SIZE : (size_t)len;
+
+        if ( fread(buffer, 1, chunk, delta) != chunk || ! delta_write(out_fd, buffer, chunk) ) {
+          break;
+        }
+
+        len -= chunk;
+        *out_len += chunk;
+      }
+
+      if ( len > 0 ) {
+        break;
+      }
+      continue;
+    }
+
+    LOGGER(__FUNCTION__, "ERROR: Delta has an unknown instruction.");
+    break;
+  }
+
+  free(buffer);
+
+  return result;
+}
@@ -0,0 +1,97 @@
+/*
+ * delta.h
+ *
+ * $Id: $
+ * $HeadURL: $
+ * $LastChangedRevision: $
+ * $LastChangedDate: $
+ * $LastChangedBy: $
+ *
+ */
+
+#ifndef _DELTA_H
+#define _DELTA_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdio.h>
+
+// Bounds of the block size of a signature
+#define DELTA_BLOCK_MINIMUM_SIZE    2048
+#define DELTA_BLOCK_MAXIMUM_SIZE    65536
+
+// Length of the entry of a block in a signature, its weak
+// rolling checksum in 4 bytes and its strong hash in 8 bytes
+#define DELTA_SIGNATURE_ENTRY_LEN   12
+
+// Instructions of a delta, each made of its code followed by its arguments
+// in 4 bytes big endian, the data of a literal following its length
+#define DELTA_OP_COPY               'C'   // first block, number of blocks
+#define DELTA_OP_LITERAL            'L'   // length of the data
+#define DELTA_OP_END                'E'
+
+// Largest data of a single literal instruction
+#define DELTA_LITERAL_MAXIMUM_LEN   ( 1024 * 1024 )
+
+/**
+ * Chooses the block size of the signature of a file, growing with
+ * the square root of its size within the bounds of the block size
+ *
+ * @param file_len        size of the file
+ *
+ * @return                block size
+ */
+long delta_block_size( long long file_len );
+
+/**
+ * Computes the signature of a file, made of an entry for each
+ * of its whole blocks, the last partial one being left out
+ *
+ * @param fd              descriptor of the file
+ * @param file_len        size of the file
+ * @param block_size      block size
+ * @param signature       returns the signature, must be free()d after usage
+ * @param signature_len   returns the length of the signature
+ *
+ * @return                TRUE or FALSE
+ */
+int delta_signature( int fd, long long file_len, long block_size, unsigned char ** signature, unsigned long * signature_len );
+
+/**
+ * Writes the delta that rebuilds a file from the one a signature was
+ * computed for, copying the blocks they share and inserting the rest
+ *
+ * @param fd              descriptor of the new file
+ * @param file_len        size of the new file
+ * @param signature       signature of the current file
+ * @param signature_len   length of the signature
+ * @param block_size      block size of the signature
+ * @param delta           stream the delta is written to
+ * @param literal_len     returns the length of the data inserted
+ *
+ * @return                TRUE or FALSE
+ */
+int delta_generate( int fd, long long file_len, const unsigned char * signature, unsigned long signature_len, long block_size, FILE * delta, long long * literal_len );
+
+/**
+ * Rebuilds a file from the current one and a delta against it
+ *
+ * @param basis_fd        descriptor of the current file
+ * @param basis_len       size of the current file
+ * @param delta           stream the delta is read from
+ * @param block_size      block size of the signature the delta refers to
+ * @param out_fd          descriptor of the file rebuilt
+ * @param out_len         returns the size of the file rebuilt
+ *
+ * @return                TRUE, or FALSE if the delta is invalid or
+ *                        either file could not be read or written
+ */
+int delta_apply( int basis_fd, long long basis_len, FILE * delta, long block_size, int out_fd, long long * out_len );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // _DELTA_H
@@ -9,7 +9,12 @@
  *
  */
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE 1
+#endif
+
 #include <stdio.h>
+#include <stdlib.h>
 #include <errno.h>
 #include <sys/stat.h>
 #include <string.h>
@@ -17,6 +22,8 @@
 #include <fcntl.h>
 #include <unistd.h>
 #include <sys/sendfile.h>
+#include <sys/file.h>
+#include <zlib.h>
 
 #include "file.h"
 #include "macros.h"
@@ -389,3 +396,391 @@ char * file_get_base_path(char *filepath, char *directory) {
   return directory;
 
 }
+
+/**
+ * Creates a uniquely named temporary file next to a file,
+ * reserving disk space for its expected size
+ *
+ * @param filepath        path of the file the temporary one will replace
+ * @param temp_path       buffer for the temporary file path
+ * @param size            expected size in bytes, or 0 if unknown
+ *
+ * @return                descriptor of the open file, or -1 on error
+ */
+int file_create_temp( char* filepath, char* temp_path, long long size ) {
+
+  char err_message[1024];
+  int fd;
+
+  sprintf(temp_path, "%s.XXXXXX", filepath);
+
+  fd = mkstemp(temp_path);
+  if ( fd == -1 ) {
+
+    sprintf(err_message, "Temporary file could not be created, code [%d]", errno);
+    LOGGER(__FUNCTION__, err_message);
+    return -1;
+  }
+
+  // mkstemp creates the file readable only by its owner
+  fchmod(fd, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+
+  // Reserving the space up front avoids fragmentation,
+  // failing to do so is not an error
+  if ( size > 0 ) {
+    posix_fallocate(fd, 0, size);
+  }
+
+  return fd;
+
+}
+
+/**
+ * Evaluates if the key of a transfer can be part of a file name
+ *
+ * @param key             key of the transfer
+ *
+ * @return                TRUE if it is only made of letters,
+ *                        digits, '-' and '_', otherwise FALSE
+ */
+static int file_valid_key( char* key ) {
+
+  size_t i;
+
+  for ( i = 0; key[i] != '\0'; i++ ) {
+
+    if ( ! ( ( key[i] >= 'a' && key[i] <= 'z' ) || ( key[i] >= 'A' && key[i] <= 'Z' ) ||
+             ( key[i] >= '0' && key[i] <= '9' ) || key[i] == '-' || key[i] == '_' ) ) {
+      return FALSE;
+    }
+  }
+
+  return ( i > 0 );
+}
+
+/**
+ * Opens the partial file of a resumable transfer next to a file,
+ * creating it if needed, and locks it for the caller. The content
+ * already in it is kept unless it is longer than the expected size.
+ *
+ * @param filepath        path of the file the partial one will replace
+ * @param key             key of the transfer, made of letters,
+ *                        digits, '-' and '_' only
+ * @param part_path       buffer for the partial file path
+ * @param size            expected size in bytes, or -1 if unknown
+ * @param offset          returns the length of the content kept, the
+ *                        file being positioned at its end
+ *
+ * @return                descriptor of the open file, or -1 on error
+ *                        or if another transfer is using it
+ */
+int file_open_part( char* filepath, char* key, char* part_path, long long size, long long* offset ) {
+
+  char err_message[1024];
+  struct stat info;
+  int fd;
+
+  *offset = 0;
+
+  if ( ! file_valid_key(key) ) {
+
+    LOGGER(__FUNCTION__, "ERROR: Invalid transfer key.");
+    return -1;
+  }
+
+  sprintf(part_path, "%s.%s.part", filepath, key);
+
+  fd = open(part_path, O_RDWR | O_CREAT, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+  if ( fd == -1 ) {
+
+    sprintf(err_message, "Partial file could not be opened, code [%d]", errno);
+    LOGGER(__FUNCTION__, err_message);
+    return -1;
+  }
+
+  if ( flock(fd, LOCK_EX | LOCK_NB) != 0 ) {
+
+    sprintf(err_message, "ERROR: Partial file %s is in use by another transfer.", part_path);
+    LOGGER(__FUNCTION__, err_message);
+
+    close(fd);
+    return -1;
+  }
+
+  if ( fstat(fd, &info) == 0 && ( size < 0 || (long long)info.st_size <= size ) ) {
+    *offset = (long long)info.st_size;
+  }
+
+  if ( ftruncate(fd, *offset) != 0 || lseek(fd, *offset, SEEK_SET) != *offset ) {
+
+    sprintf(err_message, "Partial file could not be prepared, code [%d]", errno);
+    LOGGER(__FUNCTION__, err_message);
+
+    close(fd);
+    return -1;
+  }
+
+  // Reserves the space of the rest of the file without changing its
+  // size, which tells the length of the content kept, failing to do
+  // so is not an error
+  if ( size > *offset ) {
+    fallocate(fd, FALLOC_FL_KEEP_SIZE, *offset, size - *offset);
+  }
+
+  return fd;
+
+}
+
+/**
+ * Opens the file a striped transfer writes its ranges into, next to the
+ * file it will replace. Every range of the transfer opens it on its own,
+ * the first one creating it with the size of the whole file.
+ *
+ * @param filepath        path of the file the striped one will replace
+ * @param key             key of the transfer, made of letters,
+ *                        digits, '-' and '_' only
+ * @param stripe_path     buffer for the striped file path
+ * @param size            size of the whole file, or -1 to only open
+ *                        the file if it exists
+ *
+ * @return                descriptor of the open file, or -1 on error
+ */
+int file_open_stripe( char* filepath, char* key, char* stripe_path, long long size ) {
+
+  char err_message[1024];
+  struct stat info;
+  int fd;
+
+  if ( ! file_valid_key(key) ) {
+
+    LOGGER(__FUNCTION__, "ERROR: Invalid transfer key.");
+    return -1;
+  }
+
+  sprintf(stripe_path, "%s.%s.stripe", filepath, key);
+
+  fd = open(stripe_path, ( size >= 0 ) ? ( O_RDWR | O_CREAT ) : O_RDWR, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+  if ( fd == -1 ) {
+
+    sprintf(err_message, "Striped file could not be opened, code [%d]", errno);
+    LOGGER(__FUNCTION__, err_message);
+    return -1;
+  }
+
+  // The whole file is allocated up front, so that the ranges only
+  // fill it in, which is done again by each of them to no effect
+  if ( size > 0 && fstat(fd, &info) == 0 && (long long)info.st_size < size &&
+       posix_fallocate(fd, 0, size) != 0 && ftruncate(fd, size) != 0 ) {
+
+    sprintf(err_message, "Striped file could not be allocated, code [%d]", errno);
+    LOGGER(__FUNCTION__, err_message);
+
+    close(fd);
+    return -1;
+  }
+
+  return fd;
+
+}
+
+/**
+ * Records a range written into the file of a striped transfer, in the
+ * file of its ranges next to it, so that the commit can tell whether
+ * the ranges cover the whole file
+ *
+ * @param stripe_path     path of the striped file
+ * @param offset          offset of the range
+ * @param length          length of the range
+ *
+ * @return                TRUE or FALSE
+ */
+int file_stripe_written( char* stripe_path, long long offset, long long length ) {
+
+  char ranges_path[2048];
+  long long range[2];
+  int fd;
+  int written;
+
+  sprintf(ranges_path, "%s" FILE_STRIPE_RANGES_SUFFIX, stripe_path);
+
+  // Every range appends its record at once, whichever connection it came on
+  fd = open(ranges_path, O_WRONLY | O_CREAT | O_APPEND, S_IRUSR | S_IWUSR);
+  if ( fd == -1 ) {
+    return FALSE;
+  }
+
+  range[0] = offset;
+  range[1] = length;
+
+  written = ( write(fd, range, sizeof(range)) == (ssize_t)sizeof(range) );
+
+  if ( close(fd) != 0 ) {
+    written = FALSE;
+  }
+
+  return written;
+
+}
+
+static int file_stripe_range_compare( const void* a, const void* b ) {
+
+  long long offset_a = ((const long long*)a)[0];
+  long long offset_b = ((const long long*)b)[0];
+
+  return ( offset_a > offset_b ) - ( offset_a < offset_b );
+}
+
+/**
+ * Tells whether the ranges written into the file of a striped
+ * transfer cover the whole file, without gaps
+ *
+ * @param stripe_path     path of the striped file
+ * @param size            size of the whole file
+ *
+ * @return                TRUE or FALSE
+ */
+int file_stripe_covered( char* stripe_path, long long size ) {
+
+  char ranges_path[2048];
+  struct stat info;
+  long long * ranges = NULL;
+  long long reached = 0;
+  size_t count;
+  size_t i;
+  int fd;
+
+  sprintf(ranges_path, "%s" FILE_STRIPE_RANGES_SUFFIX, stripe_path);
+
+  fd = open(ranges_path, O_RDONLY);
+  if ( fd == -1 ) {
+    return ( size == 0 );
+  }
+
+  if ( fstat(fd, &info) == 0 && info.st_size > 0 ) {
+
+    count = (size_t)info.st_size / ( 2 * sizeof(long long) );
+    ranges = (long long*)malloc(count * 2 * sizeof(long long));
+
+    if ( ranges != NULL && read(fd, ranges, count * 2 * sizeof(long long)) == (ssize_t)( count * 2 * sizeof(long long) ) ) {
+
+      qsort(ranges, count, 2 * sizeof(long long), &file_stripe_range_compare);
+
+      // Ranges may overlap, as those of a failed attempt are recorded too
+      for ( i = 0; i < count && ranges[2 * i] <= reached; i++ ) {
+
+        if ( ranges[2 * i] + ranges[2 * i + 1] > reached ) {
+          reached = ranges[2 * i] + ranges[2 * i + 1];
+        }
+      }
+    }
+
+    free(ranges);
+  }
+
+  close(fd);
+
+  return ( reached >= size );
+
+}
+
+/**
+ * Removes the record of the ranges of a striped transfer
+ *
+ * @param stripe_path     path of the striped file
+ */
+void file_stripe_end( char* stripe_path ) {
+
+  char ranges_path[2048];
+
+  sprintf(ranges_path, "%s" FILE_STRIPE_RANGES_SUFFIX, stripe_path);
+  unlink(ranges_path);
+
+}
+
+/**
+ * Computes a hash of the content of a file, which identifies
+ * it between the attempts of a resumable transfer
+ *
+ * @param fd              file descriptor, its position is not changed
+ * @param len             number of leading bytes hashed, or -1 for
+ *                        the whole file
+ * @param hash            returns the hash
+ *
+ * @return                TRUE or FALSE
+ */
+int file_content_hash( int fd, long long len, unsigned long long* hash ) {
+
+  unsigned char * buffer;
+  uLong crc = crc32(0L, Z_NULL, 0);
+  uLong adler = adler32(0L, Z_NULL, 0);
+  size_t chunk = FILE_HASH_BUFFER_SIZE;
+  off_t offset = 0;
+  ssize_t bread = 0;
+
+  buffer = (unsigned char*)malloc(FILE_HASH_BUFFER_SIZE);
+  if ( buffer == NULL ) {
+    return FALSE;
+  }
+
+  while ( len < 0 || offset < len ) {
+
+    if ( len >= 0 && len - offset < (long long)chunk ) {
+      chunk = (size_t)( len - offset );
+    }
+
+    bread = pread(fd, buffer, chunk, offset);
+    if ( bread <= 0 ) {
+      break;
+    }
+
+    crc = crc32(crc, buffer, (uInt)bread);
+    adler = adler32(adler, buffer, (uInt)bread);
+    offset += bread;
+  }
+
+  free(buffer);
+
+  *hash = ( (unsigned long long)( crc & 0xFFFFFFFFUL ) << 32 ) | ( adler & 0xFFFFFFFFUL );
+
+  return ( len < 0 ) ? ( bread == 0 ) : ( offset == len );
+
+}
+
+/**
+ * Replaces a file with a temporary one, optionally
+ * keeping the previous content as <filepath>.bkp
+ *
+ * @param temp_path       path of the temporary file
+ * @param filepath        path of the file to replace
+ * @param backup          TRUE to keep a backup of an existing file
+ *
+ * @return                TRUE or FALSE
+ */
+int file_replace( char* temp_path, char* filepath, int backup ) {
+
+  char backup_path[2048];
+  char err_message[1024];
+
+  if ( backup == TRUE && file_exists(filepath) == TRUE ) {
+
+    sprintf(backup_path, "%s.bkp", filepath);
+    unlink(backup_path);
+
+    // Links the current content when possible instead of copying it
+    if ( link(filepath, backup_path) == -1 && ! file_copy(filepath, backup_path, TRUE) ) {
+
+      sprintf(err_message, "ERROR: Could not make backup copy of file (%s).", filepath);
+      LOGGER(__FUNCTION__, err_message);
+    }
+  }
+
+  if ( rename(temp_path, filepath) == -1 ) {
+
+    sprintf(err_message, "File operation failed with code [%d]", errno);
+    LOGGER(__FUNCTION__, err_message);
+    return FALSE;
+  }
+
+  return TRUE;
+
+}
@@ -18,6 +18,13 @@ extern "C" {
 
 #include <stdlib.h>
 
+// Suffix of the file that records the ranges written into a striped file
+#define FILE_STRIPE_RANGES_SUFFIX ".ranges"
+
+// Size of the buffer a file is hashed through, allocated on the heap as
+// hashes run on the workers of the pool, whose stacks are small
+#define FILE_HASH_BUFFER_SIZE     ( 256 * 1024 )
+
 /**
  * Checks and returns TRUE if file exists
  *
@@ -122,6 +129,109 @@ int file_directory_delete( char* dir_path );
  */
 char * file_get_base_path(char *filepath, char *directory);
 
+/**
+ * Creates a uniquely named temporary file next to a file,
+ * reserving disk space for its expected size
+ *
+ * @param filepath        path of the file the temporary one will replace
+ * @param temp_path       buffer for the temporary file path
+ * @param size            expected size in bytes, or 0 if unknown
+ *
+ * @return                descriptor of the open file, or -1 on error
+ */
+int file_create_temp( char* filepath, char* temp_path, long long size );
+
+/**
+ * Opens the partial file of a resumable transfer next to a file,
+ * creating it if needed, and locks it for the caller. The content
+ * already in it is kept unless it is longer than the expected size.
+ *
+ * @param filepath        path of the file the partial one will replace
+ * @param key             key of the transfer, made of letters,
+ *                        digits, '-' and '_' only
+ * @param part_path       buffer for the partial file path
+ * @param size            expected size in bytes, or -1 if unknown
+ * @param offset          returns the length of the content kept, the
+ *                        file being positioned at its end
+ *
+ * @return                descriptor of the open file, or -1 on error
+ *                        or if another transfer is using it
+ */
+int file_open_part( char* filepath, char* key, char* part_path, long long size, long long* offset );
+
+/**
+ * Opens the file a striped transfer writes its ranges into, next to the
+ * file it will replace. Every range of the transfer opens it on its own,
+ * the first one creating it with the size of the whole file, which does
+ * not tell the ranges written, recorded with file_stripe_written.
+ *
+ * @param filepath        path of the file the striped one will replace
+ * @param key             key of the transfer, made of letters,
+ *                        digits, '-' and '_' only
+ * @param stripe_path     buffer for the striped file path
+ * @param size            size of the whole file, or -1 to only open
+ *                        the file if it exists
+ *
+ * @return                descriptor of the open file, or -1 on error
+ */
+int file_open_stripe( char* filepath, char* key, char* stripe_path, long long size );
+
+/**
+ * Records a range written into the file of a striped transfer, in the
+ * file of its ranges next to it, so that the commit can tell whether
+ * the ranges cover the whole file
+ *
+ * @param stripe_path     path of the striped file
+ * @param offset          offset of the range
+ * @param length          length of the range
+ *
+ * @return                TRUE or FALSE
+ */
+int file_stripe_written( char* stripe_path, long long offset, long long length );
+
+/**
+ * Tells whether the ranges written into the file of a striped
+ * transfer cover the whole file, without gaps
+ *
+ * @param stripe_path     path of the striped file
+ * @param size            size of the whole file
+ *
+ * @return                TRUE or FALSE
+ */
+int file_stripe_covered( char* stripe_path, long long size );
+
+/**
+ * Removes the record of the ranges of a striped transfer
+ *
+ * @param stripe_path     path of the striped file
+ */
+void file_stripe_end( char* stripe_path );
+
+/**
+ * Computes a hash of the content of a file, which identifies
+ * it between the attempts of a resumable transfer
+ *
+ * @param fd              file descriptor, its position is not changed
+ * @param len             number of leading bytes hashed, or -1 for
+ *                        the whole file
+ * @param hash            returns the hash
+ *
+ * @return                TRUE or FALSE
+ */
+int file_content_hash( int fd, long long len, unsigned long long* hash );
+
+/**
+ * Replaces a file with a temporary one, optionally
+ * keeping the previous content as <filepath>.bkp
+ *
+ * @param temp_path       path of the temporary file
+ * @param filepath        path of the file to replace
+ * @param backup          TRUE to keep a backup of an existing file
+ *
+ * @return                TRUE or FALSE
+ */
+int file_replace( char* temp_path, char* filepath, int backup );
+
 #ifdef __cplusplus
 }
 #endif
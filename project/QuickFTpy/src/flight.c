@@ -0,0 +1,386 @@
+/*
+ * flight.c
+ *
+ * $Id: $
+ * $HeadURL: $
+ * $LastChangedRevision: $
+ * $LastChangedDate: $
+ * $LastChangedBy: $
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#include "flight.h"
+#include "macros.h"
+
+// Flights whose leader did not end yet, as few as the workers
+static pthread_mutex_t flight_mutex = PTHREAD_MUTEX_INITIALIZER;
+static FLIGHT_T * flights = NULL;
+static FLIGHT_STATS_T counters;
+
+/**
+ * Evaluates if a flight produces the content of a version of a file
+ *
+ * @param flight          flight
+ * @param path            path of the file
+ * @param info            status of the file
+ * @param format          format of the content
+ * @param codec           codec of the content
+ *
+ * @return                TRUE or FALSE
+ */
+static int flight_matches( FLIGHT_T * flight, const char * path, const struct stat * info, int format, int codec ) {
+
+  return ( flight->format == format && flight->codec == codec &&
+           flight->info.st_dev == info->st_dev && flight->info.st_ino == info->st_ino &&
+           flight->info.st_size == info->st_size && flight->info.st_mtim.tv_sec == info->st_mtim.tv_sec &&
+           flight->info.st_mtim.tv_nsec == info->st_mtim.tv_nsec && strcmp(flight->path, path) == 0 );
+}
+
+/**
+ * Waits for the leader of a flight to make progress, the flight mutex being held
+ *
+ * @param flight          flight
+ * @param timeout         milliseconds to wait
+ *
+ * @return                TRUE, or FALSE if the time ran out
+ */
+static int flight_wait_progress( FLIGHT_T * flight, unsigned long timeout ) {
+
+  struct timespec deadline;
+
+  clock_gettime(CLOCK_MONOTONIC, &deadline);
+  deadline.tv_sec += timeout / 1000;
+  deadline.tv_nsec += ( timeout % 1000 ) * 1000000L;
+  if ( deadline.tv_nsec >= 1000000000L ) {
+
+    deadline.tv_sec++;
+    deadline.tv_nsec -= 1000000000L;
+  }
+
+  return ( pthread_cond_timedwait(&flight->progress, &flight->mutex, &deadline) != ETIMEDOUT );
+}
+
+/**
+ * Releases a reference to a flight, the last one giving
+ * its content to the cache and freeing it
+ *
+ * @param flight          flight
+ */
+static void flight_release( FLIGHT_T * flight ) {
+
+  int last;
+
+  pthread_mutex_lock(&flight->mutex);
+  last = ( --flight->refs == 0 );
+  pthread_mutex_unlock(&flight->mutex);
+
+  if ( ! last ) {
+    return;
+  }
+
+  if ( flight->begun ) {
+    cache_fill_end(&flight->fill, flight->path, &flight->info, flight->format, flight->codec, flight->mode, flight->complete && flight->unchanged);
+  }
+
+  pthread_cond_destroy(&flight->progress);
+  pthread_mutex_destroy(&flight->mutex);
+  free(flight->path);
+  free(flight);
+}
+
+/**
+ * Joins the request in flight for the content of a file, or starts one
+ *
+ * @param path            path of the file
+ * @param info            status of the open file
+ * @param format          CONTENT_ENCODED, CONTENT_ENCODED_CHUNKED
+ *                        or CONTENT_BINARY_CHUNKED
+ * @param codec           codec of the content
+ * @param leader          returns TRUE if the request leads the flight
+ *
+ * @return                the flight, or NULL if the one in flight can no
+ *                        longer be joined, the request then goes alone
+ */
+FLIGHT_T * flight_join( const char * path, const struct stat * info, int format, int codec, int * leader ) {
+
+  FLIGHT_T * flight;
+  pthread_condattr_t attr;
+
+  *leader = FALSE;
+
+  pthread_mutex_lock(&flight_mutex);
+
+  for ( flight = flights; flight != NULL; flight = flight->next ) {
+
+    if ( flight_matches(flight, path, info, format, codec) ) {
+      break;
+    }
+  }
+
+  if ( flight != NULL ) {
+
+    pthread_mutex_lock(&flight->mutex);
+
+    // The leader gave up a capture that nobody shared
+    if ( flight->begun && ! flight->fill.active ) {
+
+      pthread_mutex_unlock(&flight->mutex);
+      pthread_mutex_unlock(&flight_mutex);
+      return NULL;
+    }
+
+    flight->refs++;
+    flight->followers++;
+    flight->fill.shared = TRUE;
+
+    pthread_mutex_unlock(&flight->mutex);
+
+    counters.followers++;
+    pthread_mutex_unlock(&flight_mutex);
+    return flight;
+  }
+
+  flight = (FLIGHT_T *)malloc(sizeof(FLIGHT_T));
+  memset(flight, 0x00, sizeof(FLIGHT_T));
+
+  flight->path = strdup(path);
+  memcpy(&flight->info, info, sizeof(struct stat));
+  flight->format = format;
+  flight->codec = codec;
+  flight->refs = 1;
+
+  pthread_mutex_init(&flight->mutex, NULL);
+  pthread_condattr_init(&attr);
+  pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+  pthread_cond_init(&flight->progress, &attr);
+  pthread_condattr_destroy(&attr);
+
+  flight->next = flights;
+  flights = flight;
+
+  counters.leaders++;
+  pthread_mutex_unlock(&flight_mutex);
+
+  *leader = TRUE;
+  return flight;
+}
+
+/**
+ * Begins producing the content, leader only
+ *
+ * @param flight          flight
+ * @param mode            compression mode of the content
+ * @param content_len     length of the content, for V1 unchunked responses
+ */
+void flight_begin( FLIGHT_T * flight, int mode, unsigned long long content_len ) {
+
+  pthread_mutex_lock(&flight->mutex);
+
+  cache_fill_begin(&flight->fill);
+  flight->fill.shared = ( flight->followers > 0 );
+
+  flight->mode = mode;
+  flight->content_len = content_len;
+  flight->begun = TRUE;
+
+  pthread_cond_broadcast(&flight->progress);
+  pthread_mutex_unlock(&flight->mutex);
+}
+
+/**
+ * Captures part of the content produced, leader only
+ *
+ * @param flight          flight
+ * @param data            data
+ * @param len             data length
+ */
+void flight_write( FLIGHT_T * flight, const char * data, unsigned long len ) {
+
+  pthread_mutex_lock(&flight->mutex);
+
+  cache_fill_write(&flight->fill, data, len);
+
+  if ( flight->followers > 0 ) {
+    pthread_cond_broadcast(&flight->progress);
+  }
+
+  pthread_mutex_unlock(&flight->mutex);
+}
+
+/**
+ * Tells that the whole content was produced, leader only
+ *
+ * @param flight          flight
+ */
+void flight_complete( FLIGHT_T * flight ) {
+
+  pthread_mutex_lock(&flight->mutex);
+  flight->complete = flight->fill.active;
+  pthread_mutex_unlock(&flight->mutex);
+}
+
+/**
+ * Evaluates if requests are following the flight, leader only
+ *
+ * @param flight          flight
+ *
+ * @return                TRUE or FALSE
+ */
+int flight_shared( FLIGHT_T * flight ) {
+
+  int shared;
+
+  pthread_mutex_lock(&flight->mutex);
+  shared = ( flight->followers > 0 && flight->fill.active );
+  pthread_mutex_unlock(&flight->mutex);
+
+  return shared;
+}
+
+/**
+ * Ends the flight for the leader, the content being given to the cache
+ * once the followers sent it, if it is complete and the file did not
+ * change meanwhile
+ *
+ * @param flight          flight
+ * @param fd              descriptor of the file
+ */
+void flight_end( FLIGHT_T * flight, int fd ) {
+
+  FLIGHT_T ** link;
+
+  // Requests that come from now on look for the content in the cache
+  pthread_mutex_lock(&flight_mutex);
+
+  for ( link = &flights; *link != NULL; link = &(*link)->next ) {
+
+    if ( *link == flight ) {
+
+      *link = flight->next;
+      break;
+    }
+  }
+
+  pthread_mutex_unlock(&flight_mutex);
+
+  pthread_mutex_lock(&flight->mutex);
+
+  flight->unchanged = flight->complete && cache_file_unchanged(fd, &flight->info);
+  flight->done = TRUE;
+
+  pthread_cond_broadcast(&flight->progress);
+  pthread_mutex_unlock(&flight->mutex);
+
+  flight_release(flight);
+}
+
+/**
+ * Waits for the leader to begin producing the content, follower only
+ *
+ * @param flight          flight
+ * @param timeout         milliseconds to wait
+ * @param mode            returns the compression mode of the content
+ * @param content_len     returns the length of the content
+ *
+ * @return                TRUE, or FALSE if the leader will not produce it,
+ *                        the follower then goes alone and must leave
+ */
+int flight_wait( FLIGHT_T * flight, unsigned long timeout, int * mode, unsigned long long * content_len ) {
+
+  int begun;
+
+  pthread_mutex_lock(&flight->mutex);
+
+  while ( ! flight->begun && ! flight->done ) {
+
+    if ( ! flight_wait_progress(flight, timeout) ) {
+      break;
+    }
+  }
+
+  begun = flight->begun;
+  *mode = flight->mode;
+  *content_len = flight->content_len;
+
+  pthread_mutex_unlock(&flight->mutex);
+
+  if ( ! begun ) {
+    ATOMIC_ADD(&counters.fallbacks, 1);
+  }
+
+  return begun;
+}
+
+/**
+ * Reads the content produced after an offset, waiting for more if there
+ * is none yet, follower only
+ *
+ * @param flight          flight
+ * @param offset          offset in the content
+ * @param buffer          buffer for the content
+ * @param size            buffer size
+ * @param timeout         milliseconds to wait for the leader to make progress
+ *
+ * @return                number of bytes read, 0 at the end of the
+ *                        content, or -1 if it could not be produced
+ */
+long flight_read( FLIGHT_T * flight, unsigned long long offset, char * buffer, unsigned long size, unsigned long timeout ) {
+
+  long bread = -1;
+
+  pthread_mutex_lock(&flight->mutex);
+
+  while ( flight->fill.active ) {
+
+    if ( offset < flight->fill.len ) {
+
+      bread = ( flight->fill.len - offset < size ) ? (long)( flight->fill.len - offset ) : (long)size;
+      if ( ! cache_fill_read(&flight->fill, offset, buffer, (unsigned long)bread) ) {
+        bread = -1;
+      }
+      break;
+    }
+
+    if ( flight->done ) {
+
+      bread = ( flight->complete ) ? 0 : -1;
+      break;
+    }
+
+    if ( ! flight_wait_progress(flight, timeout) && offset >= flight->fill.len && ! flight->done ) {
+      break;
+    }
+  }
+
+  pthread_mutex_unlock(&flight->mutex);
+
+  return bread;
+}
+
+/**
+ * Leaves a flight, follower only
+ *
+ * @param flight          flight
+ */
+void flight_leave( FLIGHT_T * flight ) {
+
+  flight_release(flight);
+}
+
+/**
+ * Gets the counters of the shared requests
+ *
+ * @param stats           structure that receives the counters
+ */
+void flight_get_stats( FLIGHT_STATS_T * stats ) {
+
+  pthread_mutex_lock(&flight_mutex);
+  memcpy(stats, &counters, sizeof(FLIGHT_STATS_T));
+  pthread_mutex_unlock(&flight_mutex);
+}
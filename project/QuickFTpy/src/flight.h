@@ -0,0 +1,175 @@
+/*
+ * flight.h
+ *
+ * $Id: $
+ * $HeadURL: $
+ * $LastChangedRevision: $
+ * $LastChangedDate: $
+ * $LastChangedBy: $
+ *
+ */
+
+#ifndef _FLIGHT_H
+#define _FLIGHT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include "cache.h"
+
+/**
+ * Content of a file being produced for a request, shared with the
+ * concurrent requests for the same version of the file, format and codec.
+ * The first request, the leader, compresses the file and captures what it
+ * sends, the others, its followers, send the captured content as it grows.
+ * Followers are paced by the leader, which keeps producing the content
+ * for them if its own connection is lost.
+ */
+typedef struct _flight_t {
+
+  char * path;
+  struct stat info;
+  int format;
+  int codec;
+
+  // Set by the leader once it begins producing the content
+  int begun;
+  int mode;
+  unsigned long long content_len;
+
+  CACHE_FILL_T fill;
+  int complete;           // the whole content was captured
+  int done;               // the leader ended
+  int unchanged;          // the file did not change while it was produced
+
+  // Leader and followers, the last one ends the capture
+  int refs;
+  int followers;
+
+  pthread_mutex_t mutex;
+  pthread_cond_t progress;
+
+  struct _flight_t * next;
+
+} FLIGHT_T;
+
+// Counters of the shared requests
+typedef struct _flight_stats_t {
+
+  unsigned long long leaders;
+  unsigned long long followers;
+  unsigned long long fallbacks;   // followers whose leader did not share the content
+
+} FLIGHT_STATS_T;
+
+/**
+ * Joins the request in flight for the content of a file, or starts one
+ *
+ * @param path            path of the file
+ * @param info            status of the open file
+ * @param format          CONTENT_ENCODED, CONTENT_ENCODED_CHUNKED
+ *                        or CONTENT_BINARY_CHUNKED
+ * @param codec           codec of the content
+ * @param leader          returns TRUE if the request leads the flight
+ *
+ * @return                the flight, or NULL if the one in flight can no
+ *                        longer be joined, the request then goes alone
+ */
+FLIGHT_T * flight_join( const char * path, const struct stat * info, int format, int codec, int * leader );
+
+/**
+ * Begins producing the content, leader only
+ *
+ * @param flight          flight
+ * @param mode            compression mode of the content
+ * @param content_len     length of the content, for V1 unchunked responses
+ */
+void flight_begin( FLIGHT_T * flight, int mode, unsigned long long content_len );
+
+/**
+ * Captures part of the content produced, leader only
+ *
+ * @param flight          flight
+ * @param data            data
+ * @param len             data length
+ */
+void flight_write( FLIGHT_T * flight, const char * data, unsigned long len );
+
+/**
+ * Tells that the whole content was produced, leader only
+ *
+ * @param flight          flight
+ */
+void flight_complete( FLIGHT_T * flight );
+
+/**
+ * Evaluates if requests are following the flight, leader only
+ *
+ * @param flight          flight
+ *
+ * @return                TRUE or FALSE
+ */
+int flight_shared( FLIGHT_T * flight );
+
+/**
+ * Ends the flight for the leader, the content being given to the cache
+ * once the followers sent it, if it is complete and the file did not
+ * change meanwhile
+ *
+ * @param flight          flight
+ * @param fd              descriptor of the file
+ */
+void flight_end( FLIGHT_T * flight, int fd );
+
+/**
+ * Waits for the leader to begin producing the content, follower only
+ *
+ * @param flight          flight
+ * @param timeout         milliseconds to wait
+ * @param mode            returns the compression mode of the content
+ * @param content_len     returns the length of the content
+ *
+ * @return                TRUE, or FALSE if the leader will not produce it,
+ *                        the follower then goes alone and must leave
+ */
+int flight_wait( FLIGHT_T * flight, unsigned long timeout, int * mode, unsigned long long * content_len );
+
+/**
+ * Reads the content produced after an offset, waiting for more if there
+ * is none yet, follower only
+ *
+ * @param flight          flight
+ * @param offset          offset in the content
+ * @param buffer          buffer for the content
+ * @param size            buffer size
+ * @param timeout         milliseconds to wait for the leader to make progress
+ *
+ * @return                number of bytes read, 0 at the end of the
+ *                        content, or -1 if it could not be produced
+ */
+long flight_read( FLIGHT_T * flight, unsigned long long offset, char * buffer, unsigned long size, unsigned long timeout );
+
+/**
+ * Leaves a flight, follower only
+ *
+ * @param flight          flight
+ */
+void flight_leave( FLIGHT_T * flight );
+
+/**
+ * Gets the counters of the shared requests
+ *
+ * @param stats           structure that receives the counters
+ */
+void flight_get_stats( FLIGHT_STATS_T * stats );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // _FLIGHT_H
@@ -13,11 +13,18 @@
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
+#include <unistd.h>
+#include <strings.h>
+#include <errno.h>
+#include <pthread.h>
 #include <sys/types.h>
+#include <sys/stat.h>
 
 #include "gz.h"
 #include "macros.h"
 #include "logger.h"
+#include "mutex.h"
+#include "pool.h"
 
 #include <zlib.h>
 #if defined(MSDOS) || defined(OS2) || defined(WIN32) || defined(__CYGWIN__)
@@ -30,6 +37,342 @@
 
 #define CHUNK 16384
 
+// Blocks being compressed or waiting to be written, per thread,
+// and at most for a single deflate
+#define GZ_PARALLEL_WINDOW        2
+#define GZ_PARALLEL_MAXIMUM_WINDOW 16
+
+/**
+ * Block of a parallel deflate
+ */
+typedef struct _gz_block_t {
+
+  unsigned char in[GZ_PARALLEL_BLOCK_SIZE];
+  unsigned char dict[GZ_PARALLEL_DICT_SIZE];
+  unsigned char * out;
+
+  size_t in_len;
+  size_t dict_len;
+  size_t out_size;
+  size_t out_len;
+
+  uLong crc;
+  int level;
+  int done;
+  int failed;
+
+  // Guards done and failed, its condition wakes the
+  // thread waiting for the block when it is done
+  MUTEX_T * mutex;
+
+} GZ_BLOCK_T;
+
+// Adaptive compression settings, written by gz_adaptive_configure while
+// transfers read them, which take a copy under the mutex
+static pthread_mutex_t gz_adaptive_mutex = PTHREAD_MUTEX_INITIALIZER;
+static GZ_ADAPTIVE_T gz_adaptive = { GZ_MODE_AUTO, GZ_DEFAULT_STORE_RATIO, GZ_DEFAULT_FAST_RATIO,
+                                     GZ_DEFAULT_BEST_RATIO, GZ_DEFAULT_OVERRIDES };
+
+static const char * gz_mode_names[] = { "store", "fast", "default", "best" };
+
+// Pool shared by every parallel deflate, started on first use
+static pthread_mutex_t gz_pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static POOL_T * gz_pool = NULL;
+static int gz_pool_started = FALSE;
+static int gz_pool_threads = 0;
+
+/**
+ * Configures the adaptive compression, also while transfers run, each
+ * file is packed with the settings in effect when its mode is chosen
+ *
+ * @param mode            GZ_MODE_AUTO to choose the mode per file,
+ *                        or the mode to use for every file
+ * @param store_ratio     ratio above which a file is stored, 0 for default
+ * @param fast_ratio      ratio above which a file is deflated fast, 0 for default
+ * @param best_ratio      ratio below which a file is deflated best, 0 for default
+ * @param overrides       comma separated 'ext:mode' pairs, where mode is
+ *                        store, fast, default or best, or NULL for default
+ */
+void gz_adaptive_configure(int mode, double store_ratio, double fast_ratio, double best_ratio, const char* overrides) {
+
+  pthread_mutex_lock(&gz_adaptive_mutex);
+
+  gz_adaptive.mode = ( mode >= GZ_MODE_STORE && mode <= GZ_MODE_BEST ) ? mode : GZ_MODE_AUTO;
+  gz_adaptive.store_ratio = ( store_ratio > 0 ) ? store_ratio : GZ_DEFAULT_STORE_RATIO;
+  gz_adaptive.fast_ratio = ( fast_ratio > 0 ) ? fast_ratio : GZ_DEFAULT_FAST_RATIO;
+  gz_adaptive.best_ratio = ( best_ratio > 0 ) ? best_ratio : GZ_DEFAULT_BEST_RATIO;
+
+  snprintf(gz_adaptive.overrides, GZ_OVERRIDES_MAXIMUM_LEN, "%s", ( overrides != NULL ) ? overrides : GZ_DEFAULT_OVERRIDES);
+
+  pthread_mutex_unlock(&gz_adaptive_mutex);
+
+}
+
+/**
+ * Gets the zlib compression level of a mode
+ *
+ * @param mode            compression mode
+ *
+ * @return                compression level
+ */
+int gz_mode_level(int mode) {
+
+  switch (mode) {
+    case GZ_MODE_STORE:
+      return Z_NO_COMPRESSION;
+    case GZ_MODE_FAST:
+      return Z_BEST_SPEED;
+    case GZ_MODE_BEST:
+      return Z_BEST_COMPRESSION;
+    default:
+      return Z_DEFAULT_COMPRESSION;
+  }
+
+}
+
+/**
+ * Gets the name of a compression mode
+ *
+ * @param mode            compression mode
+ *
+ * @return                mode name
+ */
+const char* gz_mode_name(int mode) {
+
+  if ( mode < GZ_MODE_STORE || mode > GZ_MODE_BEST ) {
+    return "auto";
+  }
+
+  return gz_mode_names[mode];
+
+}
+
+/**
+ * Copies the adaptive compression settings
+ *
+ * @param settings        receives the settings
+ */
+static void gz_adaptive_get(GZ_ADAPTIVE_T* settings) {
+
+  pthread_mutex_lock(&gz_adaptive_mutex);
+  memcpy(settings, &gz_adaptive, sizeof(GZ_ADAPTIVE_T));
+  pthread_mutex_unlock(&gz_adaptive_mutex);
+
+}
+
+/**
+ * Finds the mode given to the extension of a file by the overrides
+ *
+ * @param settings        adaptive compression settings
+ * @param filename        name of the file
+ *
+ * @return                compression mode, or GZ_MODE_AUTO if there is none
+ */
+static int gz_override_mode(const GZ_ADAPTIVE_T* settings, const char* filename) {
+
+  const char * extension;
+  const char * pair;
+  const char * separator;
+  size_t extension_len;
+  int mode;
+
+  extension = strrchr(filename, '.');
+  if ( extension == NULL || strchr(extension, '/') != NULL ) {
+    return GZ_MODE_AUTO;
+  }
+
+  extension++;
+  extension_len = strlen(extension);
+
+  for ( pair = settings->overrides; *pair != '\0'; pair = ( *separator == ',' ) ? separator + 1 : separator ) {
+
+    separator = strchr(pair, ',');
+    if ( separator == NULL ) {
+      separator = pair + strlen(pair);
+    }
+
+    if ( (size_t)( separator - pair ) > extension_len && pair[extension_len] == ':' &&
+         strncasecmp(pair, extension, extension_len) == 0 ) {
+
+      for ( mode = GZ_MODE_STORE; mode <= GZ_MODE_BEST; mode++ ) {
+
+        if ( (size_t)( separator - pair ) == extension_len + 1 + strlen(gz_mode_names[mode]) &&
+             strncasecmp(&pair[extension_len + 1], gz_mode_names[mode], strlen(gz_mode_names[mode])) == 0 ) {
+          return mode;
+        }
+      }
+    }
+  }
+
+  return GZ_MODE_AUTO;
+
+}
+
+/**
+ * Deflates a sample fast and gets how much it shrinks
+ *
+ * @param z               deflate state, reset for the sample
+ * @param sample          data to deflate
+ * @param sample_len      sample length
+ * @param compressed_len  returns the compressed length
+ *
+ * @return                TRUE or FALSE
+ */
+static int gz_sample(z_stream* z, const unsigned char* sample, size_t sample_len, size_t* compressed_len) {
+
+  unsigned char out[CHUNK];
+  int res;
+
+  *compressed_len = 0;
+
+  if ( deflateReset(z) != Z_OK ) {
+    return FALSE;
+  }
+
+  z->next_in = (unsigned char*) sample;
+  z->avail_in = sample_len;
+
+  do {
+
+    z->next_out = out;
+    z->avail_out = CHUNK;
+
+    res = deflate(z, Z_FINISH);
+    if ( res == Z_STREAM_ERROR ) {
+      return FALSE;
+    }
+
+    *compressed_len += CHUNK - z->avail_out;
+
+  } while ( res != Z_STREAM_END );
+
+  return TRUE;
+
+}
+
+/**
+ * Chooses the compression mode for the ratio a sample shrank to
+ *
+ * @param settings        adaptive compression settings
+ * @param ratio           compressed to original length of the sample
+ *
+ * @return                compression mode
+ */
+static int gz_ratio_mode(const GZ_ADAPTIVE_T* settings, double ratio) {
+
+  if ( ratio >= settings->store_ratio ) {
+    return GZ_MODE_STORE;
+  }
+  if ( ratio >= settings->fast_ratio ) {
+    return GZ_MODE_FAST;
+  }
+  if ( ratio <= settings->best_ratio ) {
+    return GZ_MODE_BEST;
+  }
+
+  return GZ_MODE_DEFAULT;
+
+}
+
+/**
+ * Chooses the compression mode of a buffer from a sample of its start
+ *
+ * @param data            data to compress
+ * @param data_len        data length
+ *
+ * @return                compression mode
+ */
+static int gz_choose_mode_buffer(const unsigned char* data, size_t data_len) {
+
+  GZ_ADAPTIVE_T settings;
+  z_stream z;
+  size_t sample_len = ( data_len < GZ_SAMPLE_BLOCK_SIZE * GZ_SAMPLE_BLOCKS ) ? data_len : GZ_SAMPLE_BLOCK_SIZE * GZ_SAMPLE_BLOCKS;
+  size_t compressed_len = 0;
+  int mode = GZ_MODE_DEFAULT;
+
+  gz_adaptive_get(&settings);
+  if ( settings.mode != GZ_MODE_AUTO ) {
+    return settings.mode;
+  }
+
+  if ( sample_len == 0 ) {
+    return GZ_MODE_DEFAULT;
+  }
+
+  memset(&z, 0x00, sizeof(z_stream));
+  if ( deflateInit2(&z, Z_BEST_SPEED, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK ) {
+    return GZ_MODE_DEFAULT;
+  }
+
+  if ( gz_sample(&z, data, sample_len, &compressed_len) ) {
+    mode = gz_ratio_mode(&settings, (double)compressed_len / sample_len);
+  }
+
+  deflateEnd(&z);
+
+  return mode;
+
+}
+
+/**
+ * Chooses the compression mode of a file, by its extension or by
+ * deflating a sample of its leading blocks. The position in the file
+ * is not changed.
+ *
+ * @param fd              descriptor of the file
+ * @param filename        name of the file, or NULL
+ *
+ * @return                GZ_MODE_STORE, GZ_MODE_FAST, GZ_MODE_DEFAULT or GZ_MODE_BEST
+ */
+int gz_choose_mode(int fd, const char* filename) {
+
+  unsigned char sample[GZ_SAMPLE_BLOCK_SIZE];
+  GZ_ADAPTIVE_T settings;
+  z_stream z;
+  size_t sample_len = 0;
+  size_t compressed_len = 0;
+  size_t block_len;
+  ssize_t bread;
+  int mode;
+  int i;
+
+  gz_adaptive_get(&settings);
+  if ( settings.mode != GZ_MODE_AUTO ) {
+    return settings.mode;
+  }
+
+  if ( filename != NULL && ( mode = gz_override_mode(&settings, filename) ) != GZ_MODE_AUTO ) {
+    return mode;
+  }
+
+  memset(&z, 0x00, sizeof(z_stream));
+  if ( deflateInit2(&z, Z_BEST_SPEED, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK ) {
+    return GZ_MODE_DEFAULT;
+  }
+
+  // Each block is deflated on its own, as repetitions
+  // spanning blocks are found by the actual deflate anyway
+  for ( i = 0; i < GZ_SAMPLE_BLOCKS; i++ ) {
+
+    bread = pread(fd, sample, GZ_SAMPLE_BLOCK_SIZE, (off_t)i * GZ_SAMPLE_BLOCK_SIZE);
+    if ( bread <= 0 || ! gz_sample(&z, sample, bread, &block_len) ) {
+      break;
+    }
+
+    sample_len += bread;
+    compressed_len += block_len;
+
+    if ( bread < GZ_SAMPLE_BLOCK_SIZE ) {
+      break;
+    }
+  }
+
+  deflateEnd(&z);
+
+  return ( sample_len > 0 ) ? gz_ratio_mode(&settings, (double)compressed_len / sample_len) : GZ_MODE_DEFAULT;
+
+}
+
 /**
  * gzip library wrapper
  *
@@ -90,6 +433,360 @@ int gz_pack_file_ex(FILE *in, gzFile out) {
 
 }
 
+/**
+ * Deflates a block as raw deflate data ended by a sync flush,
+ * so that the blocks can just be concatenated
+ *
+ * @param arg             block to deflate
+ */
+static void gz_deflate_block( void * arg ) {
+
+  GZ_BLOCK_T * block = (GZ_BLOCK_T *)arg;
+  z_stream z;
+  int failed = TRUE;
+
+  memset(&z, 0x00, sizeof(z_stream));
+
+  block->crc = crc32(crc32(0L, Z_NULL, 0), block->in, block->in_len);
+
+  if ( deflateInit2(&z, block->level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) == Z_OK ) {
+
+    if ( block->dict_len == 0 || deflateSetDictionary(&z, block->dict, block->dict_len) == Z_OK ) {
+
+      z.next_in = block->in;
+      z.avail_in = block->in_len;
+      z.next_out = block->out;
+      z.avail_out = block->out_size;
+
+      // The output buffer is large enough for the whole block
+      if ( deflate(&z, Z_SYNC_FLUSH) == Z_OK && z.avail_in == 0 && z.avail_out > 0 ) {
+
+        block->out_len = block->out_size - z.avail_out;
+        failed = FALSE;
+      }
+    }
+
+    deflateEnd(&z);
+  }
+
+  MUTEX_LOCK(block->mutex);
+  block->failed = failed;
+  block->done = TRUE;
+  MUTEX_COND_BROADCAST(block->mutex);
+  MUTEX_UNLOCK(block->mutex);
+
+}
+
+/**
+ * Sets the number of threads that deflate blocks in parallel,
+ * it only applies before the first parallel deflate starts them
+ *
+ * @param threads         number of threads, 0 for one per core
+ */
+void gz_parallel_configure(int threads) {
+
+  pthread_mutex_lock(&gz_pool_mutex);
+  gz_pool_threads = threads;
+  pthread_mutex_unlock(&gz_pool_mutex);
+
+}
+
+/**
+ * Gets the pool shared by every parallel deflate, started on first use
+ *
+ * @return                pool, or NULL if blocks are not worth deflating
+ *                        in parallel with a single thread
+ */
+static POOL_T * gz_parallel_pool() {
+
+  int threads;
+
+  pthread_mutex_lock(&gz_pool_mutex);
+
+  if ( ! gz_pool_started ) {
+
+    threads = ( gz_pool_threads > 0 ) ? gz_pool_threads : (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if ( threads > POOL_MAX_SIZE ) {
+      threads = POOL_MAX_SIZE;
+    }
+
+    if ( threads > 1 ) {
+
+      gz_pool = POOL_CREATE(threads);
+      if ( gz_pool == NULL ) {
+        LOGGER(__FUNCTION__, "ERROR: cannot start the compressing threads, blocks are deflated in sequence.");
+      }
+    }
+
+    gz_pool_started = TRUE;
+  }
+
+  pthread_mutex_unlock(&gz_pool_mutex);
+
+  return gz_pool;
+
+}
+
+/**
+ * Tells whether data is deflated in parallel by gz_deflate_parallel
+ *
+ * @param len             length of the data to deflate
+ * @param level           compression level
+ *
+ * @return                TRUE or FALSE
+ */
+int gz_parallel_available(unsigned long long len, int level) {
+
+  return ( level != 0 && len >= GZ_PARALLEL_MINIMUM_LEN && gz_parallel_pool() != NULL );
+
+}
+
+/**
+ * Reads a block of input, as much of it as the file holds
+ *
+ * @param fd              file descriptor
+ * @param buffer          block buffer
+ * @param size            bytes to read
+ *
+ * @return                bytes read, or -1 on error
+ */
+static ssize_t gz_read_block(int fd, unsigned char * buffer, size_t size) {
+
+  size_t total = 0;
+  ssize_t bread;
+
+  while ( total < size ) {
+
+    bread = read(fd, &buffer[total], size - total);
+    if ( bread < 0 && errno == EINTR ) {
+      continue;
+    }
+    if ( bread < 0 ) {
+      return -1;
+    }
+    if ( bread == 0 ) {
+      break;
+    }
+
+    total += bread;
+  }
+
+  return (ssize_t)total;
+
+}
+
+/**
+ * Deflates a file from its current position into a single gzip stream,
+ * its blocks deflated in parallel by the shared pool while the ones done
+ * are passed in order to the writer
+ *
+ * @param fd              file descriptor
+ * @param len             number of bytes to deflate, or -1 up to the end of the file
+ * @param level           compression level, or Z_DEFAULT_COMPRESSION
+ * @param writer          function that receives the output
+ * @param writer_arg      argument for the writer
+ *
+ * @return                TRUE or FALSE
+ */
+int gz_deflate_parallel(int fd, long long len, int level, GZ_WRITER_T writer, void* writer_arg) {
+
+  // gzip header without name nor time, and an empty final block
+  static const unsigned char header[10] = { 0x1f, 0x8b, Z_DEFLATED, 0, 0, 0, 0, 0, 0, 0x03 };
+  static const unsigned char last_block[2] = { 0x03, 0x00 };
+
+  POOL_T * pool = gz_parallel_pool();
+  GZ_BLOCK_T * blocks = NULL;
+  GZ_BLOCK_T * block;
+  GZ_BLOCK_T * previous = NULL;
+
+  unsigned char trailer[8];
+  char buffer[1024];
+
+  unsigned long long total_len = 0;
+  uLong crc = crc32(0L, Z_NULL, 0);
+  size_t chunk;
+  ssize_t bread;
+  long next_read = 0;
+  long next_write = 0;
+  int window;
+  int eof = FALSE;
+  int ret = FALSE;
+  int i;
+
+  if ( pool == NULL ) {
+    return FALSE;
+  }
+
+  window = pool->size * GZ_PARALLEL_WINDOW;
+  if ( window > GZ_PARALLEL_MAXIMUM_WINDOW ) {
+    window = GZ_PARALLEL_MAXIMUM_WINDOW;
+  }
+
+  blocks = (GZ_BLOCK_T *)calloc(window, sizeof(GZ_BLOCK_T));
+  if ( blocks == NULL ) {
+    goto GZ_DEFLATE_PARALLEL_END;
+  }
+
+  for ( i = 0; i < window; i++ ) {
+
+    blocks[i].out_size = deflateBound(NULL, GZ_PARALLEL_BLOCK_SIZE) + 16;
+    blocks[i].out = (unsigned char *)malloc(blocks[i].out_size);
+    if ( blocks[i].out == NULL ) {
+      goto GZ_DEFLATE_PARALLEL_END;
+    }
+
+    blocks[i].mutex = (MUTEX_T*)malloc(sizeof(MUTEX_T));
+    if ( blocks[i].mutex == NULL ) {
+      goto GZ_DEFLATE_PARALLEL_END;
+    }
+    memset(blocks[i].mutex, 0, sizeof(MUTEX_T));
+    MUTEX_CREATE(&blocks[i].mutex);
+
+    blocks[i].level = level;
+    blocks[i].done = TRUE;
+  }
+
+  if ( ! writer(writer_arg, header, sizeof(header)) ) {
+    goto GZ_DEFLATE_PARALLEL_END;
+  }
+
+  //
+  // Reads blocks while there is room in the window and passes
+  // the compressed ones in order as soon as they are done
+  //
+  while ( ! eof || next_write < next_read ) {
+
+    if ( ! eof && next_read - next_write < window ) {
+
+      block = &blocks[next_read % window];
+
+      // A range ends as the end of the file would
+      chunk = ( len >= 0 && len < GZ_PARALLEL_BLOCK_SIZE ) ? (size_t)len : GZ_PARALLEL_BLOCK_SIZE;
+
+      bread = ( chunk > 0 ) ? gz_read_block(fd, block->in, chunk) : 0;
+      if ( bread < 0 ) {
+
+        LOGGER(__FUNCTION__, "ERROR: cannot read the file being packed.");
+        goto GZ_DEFLATE_PARALLEL_END;
+      }
+
+      if ( len > 0 ) {
+        len -= bread;
+      }
+
+      if ( bread == 0 ) {
+        eof = TRUE;
+        continue;
+      }
+
+      block->in_len = (size_t)bread;
+
+      // Primes the block with the tail of the previous one
+      block->dict_len = 0;
+      if ( previous != NULL ) {
+
+        block->dict_len = ( previous->in_len < GZ_PARALLEL_DICT_SIZE ) ? previous->in_len : GZ_PARALLEL_DICT_SIZE;
+        memcpy(block->dict, &previous->in[previous->in_len - block->dict_len], block->dict_len);
+      }
+
+      block->done = FALSE;
+      block->failed = FALSE;
+
+      if ( ! POOL_SUBMIT(pool, &gz_deflate_block, block) ) {
+
+        block->done = TRUE;
+        goto GZ_DEFLATE_PARALLEL_END;
+      }
+
+      previous = block;
+      next_read++;
+      continue;
+    }
+
+    // Waits for the oldest block
+    block = &blocks[next_write % window];
+
+    MUTEX_LOCK(block->mutex);
+    while ( ! block->done ) {
+      MUTEX_COND_WAIT(block->mutex);
+    }
+    MUTEX_UNLOCK(block->mutex);
+
+    if ( block->failed ) {
+      LOGGER(__FUNCTION__, "ERROR: a block could not be compressed.");
+      goto GZ_DEFLATE_PARALLEL_END;
+    }
+
+    if ( ! writer(writer_arg, block->out, block->out_len) ) {
+      goto GZ_DEFLATE_PARALLEL_END;
+    }
+
+    crc = crc32_combine(crc, block->crc, block->in_len);
+    total_len += block->in_len;
+    next_write++;
+  }
+
+  // Ends the deflate data and writes the gzip trailer
+  for ( i = 0; i < 4; i++ ) {
+    trailer[i] = (unsigned char)( ( crc >> ( i * 8 ) ) & 0xff );
+    trailer[i + 4] = (unsigned char)( ( total_len >> ( i * 8 ) ) & 0xff );
+  }
+
+  if ( ! writer(writer_arg, last_block, sizeof(last_block)) ||
+       ! writer(writer_arg, trailer, sizeof(trailer)) ) {
+    goto GZ_DEFLATE_PARALLEL_END;
+  }
+
+  ret = TRUE;
+
+GZ_DEFLATE_PARALLEL_END:
+
+  if ( blocks != NULL ) {
+
+    for ( i = 0; i < window; i++ ) {
+
+      // Waits for the blocks still being compressed before releasing them
+      if ( blocks[i].mutex != NULL ) {
+
+        MUTEX_LOCK(blocks[i].mutex);
+        while ( ! blocks[i].done ) {
+          MUTEX_COND_WAIT(blocks[i].mutex);
+        }
+        MUTEX_UNLOCK(blocks[i].mutex);
+
+        MUTEX_DESTROY(&blocks[i].mutex);
+        free(blocks[i].mutex);
+      }
+
+      free(blocks[i].out);
+    }
+    free(blocks);
+  }
+
+  if ( ! ret ) {
+    sprintf(buffer, "ERROR: parallel deflate failed after %llu bytes.", total_len);
+    LOGGER(__FUNCTION__, buffer);
+  }
+
+  return ret;
+
+}
+
+/**
+ * Writer for gz_deflate_parallel that writes to a stream
+ *
+ * @param arg             output stream
+ * @param data            compressed data
+ * @param len             data length
+ *
+ * @return                TRUE or FALSE
+ */
+static int gz_file_writer(void * arg, const unsigned char * data, size_t len) {
+
+  return ( fwrite(data, 1, len, (FILE *)arg) == len );
+
+}
+
 /**
  * Unpacks a gzip file
  *
@@ -137,7 +834,8 @@ GZUNPACK_END:
 }
 
 /**
- * Packs a file to a gzip file
+ * Packs a file to a gzip file with the compression mode chosen for it,
+ * deflating its blocks in parallel when it is large enough
  *
  * @param path            file to be compressed path
  * @param output_path     compressed file path or NULL
@@ -147,9 +845,15 @@ GZUNPACK_END:
 int gz_pack_file(char* path, char* output_path) {
 
   FILE* inFile = NULL;
-  gzFile outFile = NULL;
+  FILE* outFile = NULL;
+  GZ_STREAM_T stream;
+  unsigned char chunk[CHUNK];
   char destination_path[1024];
   char buffer[1024];
+  struct stat info;
+  size_t len;
+  int level;
+  int packed;
   int ret = FALSE;
 
   if ((inFile = fopen (path, "rb")) == NULL) {
@@ -165,18 +869,40 @@ int gz_pack_file(char* path, char* output_path) {
     strcpy(destination_path, output_path);
   }
 
-  if ((outFile = gzopen(destination_path, "wb")) == NULL) {
+  if ((outFile = fopen(destination_path, "wb")) == NULL) {
     sprintf(buffer, "WARNING: cannot open destination gzip file (%s).", path);
     LOGGER(__FUNCTION__, buffer);
     goto GZPACK_END;
   }
 
-  if (gz_pack_file_ex(inFile, outFile) == FALSE) {
+  level = gz_mode_level(gz_choose_mode(fileno(inFile), path));
+
+  // Small files and single cores deflate in sequence
+  if (fstat(fileno(inFile), &info) == 0 && gz_parallel_available((unsigned long long)info.st_size, level)) {
+    packed = gz_deflate_parallel(fileno(inFile), -1, level, &gz_file_writer, outFile);
+  }
+  else {
+
+    packed = gz_deflate_stream_init(&stream, level);
+    while (packed) {
+
+      len = fread(chunk, 1, CHUNK, inFile);
+      packed = ! ferror(inFile) && gz_deflate_stream(&stream, chunk, len, ( len == 0 ), &gz_file_writer, outFile);
+      if (len == 0) {
+        break;
+      }
+    }
+
+    if (! gz_deflate_stream_end(&stream)) {
+      packed = FALSE;
+    }
+  }
+
+  if (packed == FALSE) {
     LOGGER(__FUNCTION__, "ERROR: cannot perform pack operation");
     goto GZPACK_END;
   }
-  
-  inFile = 0;
+
   ret = TRUE;
 
 GZPACK_END:
@@ -184,13 +910,16 @@ GZPACK_END:
   if (inFile) {
 	  fclose( inFile );
   }
+  if (outFile && fclose( outFile ) != 0) {
+    ret = FALSE;
+  }
 
   return ret;
 
 }
 
 /*
- * Packs a string in memory
+ * Packs a string in memory, with the compression mode chosen for its start
  *
  * @param out             Pointer by reference to compressed output
  * @param out_len         Pointer by reference to compressed output length
@@ -218,7 +947,7 @@ int gz_pack_string(unsigned char **out, size_t *out_len, const char *in, size_t
     stream->avail_in = in_len;
 
     // Initializes compression structure (add 16 to MAX_WBITS to enforce gzip format)
-    if ( deflateInit2( stream, Z_BEST_COMPRESSION, Z_DEFLATED, MAX_WBITS + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK ) {
+    if ( deflateInit2( stream, gz_mode_level(gz_choose_mode_buffer((const unsigned char*) in, in_len)), Z_DEFLATED, MAX_WBITS + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK ) {
       sprintf(buffer, "ERROR: in deflateInit2 (%s)", stream->msg?stream->msg:"<no message>");
       LOGGER(__FUNCTION__, buffer);
       goto err;
@@ -371,3 +1100,208 @@ int gz_unpack_string(unsigned char **out, size_t *out_len, const unsigned char *
   return FALSE;
 
 }
+
+/**
+ * Initializes an incremental inflate of gzip or zlib data
+ *
+ * @param stream          inflate state
+ *
+ * @return                TRUE or FALSE
+ */
+int gz_inflate_stream_init(GZ_STREAM_T* stream) {
+
+  memset(stream, 0x00, sizeof(GZ_STREAM_T));
+
+  // Adds 32 to MAX_WBITS to detect gzip or zlib headers
+  if ( inflateInit2(&stream->z, MAX_WBITS + 32) != Z_OK ) {
+    LOGGER(__FUNCTION__, "ERROR: in inflateInit2");
+    return FALSE;
+  }
+
+  stream->initialized = TRUE;
+  return TRUE;
+
+}
+
+/**
+ * Inflates a fragment of compressed data, passing
+ * the output to the writer as it is produced
+ *
+ * @param stream          inflate state
+ * @param in              compressed fragment
+ * @param in_len          fragment length
+ * @param writer          function that receives the output
+ * @param writer_arg      argument for the writer
+ *
+ * @return                TRUE or FALSE
+ */
+int gz_inflate_stream(GZ_STREAM_T* stream, const unsigned char* in, size_t in_len, GZ_WRITER_T writer, void* writer_arg) {
+
+  unsigned char out[CHUNK];
+  char buffer[1024];
+  int res;
+
+  stream->z.next_in = (unsigned char*) in;
+  stream->z.avail_in = in_len;
+
+  while ( stream->z.avail_in > 0 ) {
+
+    // Data following the end of a member starts a new one, as gzread does
+    if ( stream->finished ) {
+
+      if ( inflateReset(&stream->z) != Z_OK ) {
+        return FALSE;
+      }
+      stream->finished = FALSE;
+    }
+
+    do {
+
+      stream->z.next_out = out;
+      stream->z.avail_out = CHUNK;
+
+      res = inflate(&stream->z, Z_NO_FLUSH);
+      if ( res != Z_OK && res != Z_STREAM_END && res != Z_BUF_ERROR ) {
+
+        sprintf(buffer, "ERROR: inflate failed (%s)", stream->z.msg ? stream->z.msg : "<no message>");
+        LOGGER(__FUNCTION__, buffer);
+        return FALSE;
+      }
+
+      if ( CHUNK - stream->z.avail_out > 0 ) {
+        if ( ! writer(writer_arg, out, CHUNK - stream->z.avail_out) ) {
+          return FALSE;
+        }
+      }
+
+      if ( res == Z_STREAM_END ) {
+        stream->finished = TRUE;
+        break;
+      }
+
+    } while ( stream->z.avail_out == 0 );
+
+    if ( res == Z_BUF_ERROR && stream->z.avail_in > 0 ) {
+      return FALSE;
+    }
+
+  }
+
+  return TRUE;
+
+}
+
+/**
+ * Finalizes an incremental inflate and releases its resources
+ *
+ * @param stream          inflate state
+ *
+ * @return                TRUE if the compressed data was complete, otherwise FALSE
+ */
+int gz_inflate_stream_end(GZ_STREAM_T* stream) {
+
+  int complete = stream->finished;
+
+  if ( stream->initialized ) {
+    inflateEnd(&stream->z);
+    stream->initialized = FALSE;
+  }
+
+  return complete;
+
+}
+
+/**
+ * Initializes an incremental deflate producing gzip data
+ *
+ * @param stream          deflate state
+ * @param level           compression level, or Z_DEFAULT_COMPRESSION
+ *
+ * @return                TRUE or FALSE
+ */
+int gz_deflate_stream_init(GZ_STREAM_T* stream, int level) {
+
+  memset(stream, 0x00, sizeof(GZ_STREAM_T));
+
+  // Adds 16 to MAX_WBITS to enforce gzip format
+  if ( deflateInit2(&stream->z, level, Z_DEFLATED, MAX_WBITS + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK ) {
+    LOGGER(__FUNCTION__, "ERROR: in deflateInit2");
+    return FALSE;
+  }
+
+  stream->initialized = TRUE;
+  return TRUE;
+
+}
+
+/**
+ * Deflates a fragment of data, passing the
+ * compressed output to the writer as it is produced
+ *
+ * @param stream          deflate state
+ * @param in              data fragment
+ * @param in_len          fragment length
+ * @param finish          TRUE for the last fragment, completes the gzip data
+ * @param writer          function that receives the output
+ * @param writer_arg      argument for the writer
+ *
+ * @return                TRUE or FALSE
+ */
+int gz_deflate_stream(GZ_STREAM_T* stream, const unsigned char* in, size_t in_len, int finish, GZ_WRITER_T writer, void* writer_arg) {
+
+  unsigned char out[CHUNK];
+  char buffer[1024];
+  int flush = finish ? Z_FINISH : Z_NO_FLUSH;
+  int res;
+
+  stream->z.next_in = (unsigned char*) in;
+  stream->z.avail_in = in_len;
+
+  do {
+
+    stream->z.next_out = out;
+    stream->z.avail_out = CHUNK;
+
+    res = deflate(&stream->z, flush);
+    if ( res == Z_STREAM_ERROR ) {
+
+      sprintf(buffer, "ERROR: deflate failed (%s)", stream->z.msg ? stream->z.msg : "<no message>");
+      LOGGER(__FUNCTION__, buffer);
+      return FALSE;
+    }
+
+    if ( CHUNK - stream->z.avail_out > 0 ) {
+      if ( ! writer(writer_arg, out, CHUNK - stream->z.avail_out) ) {
+        return FALSE;
+      }
+    }
+
+  } while ( stream->z.avail_out == 0 );
+
+  if ( res == Z_STREAM_END ) {
+    stream->finished = TRUE;
+  }
+
+  return TRUE;
+
+}
+
+/**
+ * Finalizes an incremental deflate and releases its resources
+ *
+ * @param stream          deflate state
+ *
+ * @return                TRUE if the compressed data was completed, otherwise FALSE
+ */
+int gz_deflate_stream_end(GZ_STREAM_T* stream) {
+
+  int complete = stream->finished;
+
+  if ( stream->initialized ) {
+    deflateEnd(&stream->z);
+    stream->initialized = FALSE;
+  }
+
+  return complete;
+
+}
@@ -16,8 +16,109 @@
 extern "C" {
 #endif
 
+#include <stdio.h>
 #include <zlib.h>
 
+// Parallel deflate: input is compressed in independent blocks, each one
+// primed with the tail of the previous block as its dictionary
+#define GZ_PARALLEL_BLOCK_SIZE    (128 * 1024)
+#define GZ_PARALLEL_DICT_SIZE     32768
+
+// Smallest data worth deflating in parallel
+#define GZ_PARALLEL_MINIMUM_LEN   ( 4 * GZ_PARALLEL_BLOCK_SIZE )
+
+// Compression modes, chosen per file when adaptive
+#define GZ_MODE_AUTO              -1
+#define GZ_MODE_STORE             0
+#define GZ_MODE_FAST              1
+#define GZ_MODE_DEFAULT           2
+#define GZ_MODE_BEST              3
+
+// Leading blocks of a file deflated to estimate how well it compresses
+#define GZ_SAMPLE_BLOCK_SIZE      32768
+#define GZ_SAMPLE_BLOCKS          4
+
+// Ratios of the sample, compressed to original, that decide the mode
+#define GZ_DEFAULT_STORE_RATIO    0.95
+#define GZ_DEFAULT_FAST_RATIO     0.80
+#define GZ_DEFAULT_BEST_RATIO     0.25
+
+// Extensions whose mode is known beforehand, as 'ext:mode' pairs
+#define GZ_DEFAULT_OVERRIDES      "gz:store,tgz:store,bz2:store,xz:store,zst:store,zip:store,7z:store,rar:store," \
+                                  "jpg:store,jpeg:store,png:store,gif:store,webp:store,mp3:store,mp4:store,mkv:store,mov:store"
+#define GZ_OVERRIDES_MAXIMUM_LEN  1024
+
+/**
+ * Settings of the adaptive compression
+ */
+typedef struct _gz_adaptive_t {
+
+  int mode;                 // GZ_MODE_AUTO, or the mode of every file
+  double store_ratio;       // stores samples compressing worse than this
+  double fast_ratio;        // deflates fast samples compressing worse than this
+  double best_ratio;        // deflates best samples compressing better than this
+  char overrides[GZ_OVERRIDES_MAXIMUM_LEN];
+
+} GZ_ADAPTIVE_T;
+
+// Receives the output of a stream operation, returns TRUE or FALSE
+typedef int (*GZ_WRITER_T)(void * arg, const unsigned char * data, size_t len);
+
+/**
+ * State of an incremental inflate or deflate
+ */
+typedef struct _gz_stream_t {
+
+  z_stream z;
+  int initialized;
+  int finished;
+
+} GZ_STREAM_T;
+
+/**
+ * Configures the adaptive compression, also while transfers run, each
+ * file is packed with the settings in effect when its mode is chosen
+ *
+ * @param mode            GZ_MODE_AUTO to choose the mode per file,
+ *                        or the mode to use for every file
+ * @param store_ratio     ratio above which a file is stored, 0 for default
+ * @param fast_ratio      ratio above which a file is deflated fast, 0 for default
+ * @param best_ratio      ratio below which a file is deflated best, 0 for default
+ * @param overrides       comma separated 'ext:mode' pairs, where mode is
+ *                        store, fast, default or best, or NULL for default
+ */
+void gz_adaptive_configure(int mode, double store_ratio, double fast_ratio, double best_ratio, const char* overrides);
+
+/**
+ * Chooses the compression mode of a file, by its extension or by
+ * deflating a sample of its leading blocks. The position in the file
+ * is not changed.
+ *
+ * @param fd              descriptor of the file
+ * @param filename        name of the file, or NULL
+ *
+ * @return                GZ_MODE_STORE, GZ_MODE_FAST, GZ_MODE_DEFAULT or GZ_MODE_BEST
+ */
+int gz_choose_mode(int fd, const char* filename);
+
+/**
+ * Gets the zlib compression level of a mode
+ *
+ * @param mode            compression mode
+ *
+ * @return                compression level
+ */
+int gz_mode_level(int mode);
+
+/**
+ * Gets the name of a compression mode
+ *
+ * @param mode            compression mode
+ *
+ * @return                mode name
+ */
+const char* gz_mode_name(int mode);
+
 /**
  * gzip library wrapper
  *
@@ -38,6 +139,39 @@ int gz_unpack_file_ex(gzFile in, FILE * out);
  */
 int gz_pack_file_ex(FILE *in, gzFile out);
 
+/**
+ * Sets the number of threads that deflate blocks in parallel,
+ * it only applies before the first parallel deflate starts them
+ *
+ * @param threads         number of threads, 0 for one per core
+ */
+void gz_parallel_configure(int threads);
+
+/**
+ * Tells whether data is deflated in parallel by gz_deflate_parallel
+ *
+ * @param len             length of the data to deflate
+ * @param level           compression level
+ *
+ * @return                TRUE or FALSE
+ */
+int gz_parallel_available(unsigned long long len, int level);
+
+/**
+ * Deflates a file from its current position into a single gzip stream,
+ * its blocks deflated in parallel by the shared pool while the ones done
+ * are passed in order to the writer
+ *
+ * @param fd              file descriptor
+ * @param len             number of bytes to deflate, or -1 up to the end of the file
+ * @param level           compression level, or Z_DEFAULT_COMPRESSION
+ * @param writer          function that receives the output
+ * @param writer_arg      argument for the writer
+ *
+ * @return                TRUE or FALSE
+ */
+int gz_deflate_parallel(int fd, long long len, int level, GZ_WRITER_T writer, void* writer_arg);
+
 /**
  * Unpacks a gzip file
  *
@@ -49,7 +183,8 @@ int gz_pack_file_ex(FILE *in, gzFile out);
 int gz_unpack_file(char* path, char* output_path);
 
 /**
- * Packs a file to a gzip file
+ * Packs a file to a gzip file with the compression mode chosen for it,
+ * deflating its blocks in parallel when it is large enough
  *
  * @param path            file to be compressed path
  * @param output_path     compressed file path or NULL
@@ -59,7 +194,7 @@ int gz_unpack_file(char* path, char* output_path);
 int gz_pack_file(char* path, char* output_path);
 
 /*
- * Packs a string in memory
+ * Packs a string in memory, with the compression mode chosen for its start
  *
  * @param out             Pointer by reference to compressed output
  * @param out_len         Pointer by reference to compressed output length
@@ -82,6 +217,72 @@ int gz_pack_string(unsigned char** out, size_t* out_len, const char* in, size_t
  */
 int gz_unpack_string(unsigned char** out, size_t* out_len, const unsigned char* in, size_t in_len);
 
+/**
+ * Initializes an incremental inflate of gzip or zlib data
+ *
+ * @param stream          inflate state
+ *
+ * @return                TRUE or FALSE
+ */
+int gz_inflate_stream_init(GZ_STREAM_T* stream);
+
+/**
+ * Inflates a fragment of compressed data, passing
+ * the output to the writer as it is produced
+ *
+ * @param stream          inflate state
+ * @param in              compressed fragment
+ * @param in_len          fragment length
+ * @param writer          function that receives the output
+ * @param writer_arg      argument for the writer
+ *
+ * @return                TRUE or FALSE
+ */
+int gz_inflate_stream(GZ_STREAM_T* stream, const unsigned char* in, size_t in_len, GZ_WRITER_T writer, void* writer_arg);
+
+/**
+ * Finalizes an incremental inflate and releases its resources
+ *
+ * @param stream          inflate state
+ *
+ * @return                TRUE if the compressed data was complete, otherwise FALSE
+ */
+int gz_inflate_stream_end(GZ_STREAM_T* stream);
+
+/**
+ * Initializes an incremental deflate producing gzip data
+ *
+ * @param stream          deflate state
+ * @param level           compression level, or Z_DEFAULT_COMPRESSION
+ *
+ * @return                TRUE or FALSE
+ */
+int gz_deflate_stream_init(GZ_STREAM_T* stream, int level);
+
+/**
+ * Deflates a fragment of data, passing the
+ * compressed output to the writer as it is produced
+ *
+ * @param stream          deflate state
+ * @param in              data fragment
+ * @param in_len          fragment length
+ * @param finish          TRUE for the last fragment, completes the gzip data
+ * @param writer          function that receives the output
+ * @param writer_arg      argument for the writer
+ *
+ * @return                TRUE or FALSE
+ */
+int gz_deflate_stream(GZ_STREAM_T* stream, const unsigned char* in, size_t in_len, int finish, GZ_WRITER_T writer, void* writer_arg);
+
+/**
+ * Finalizes an incremental deflate and releases its resources
+ *
+ * @param stream          deflate state
+ *
+ * @return                TRUE if the compressed data was completed, otherwise FALSE
+ */
+int gz_deflate_stream_end(GZ_STREAM_T* stream);
+
 #ifdef __cplusplus
 }
 #endif
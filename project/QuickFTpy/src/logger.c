@@ -10,13 +10,17 @@
  */
 
 #include <stdlib.h>
+#include <pthread.h>
 #include "logger.h"
 #include "macros.h"
 #include "mutex.h"
 
-static PyGILState_STATE gstate;
 MUTEX_T * log_mutex = NULL;
-static logger_initialized = FALSE;
+
+// Number of operations and sessions using the log, the mutex
+// lives from the first initialization to the last finalization
+static int logger_users = 0;
+static pthread_mutex_t logger_users_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 /**
  * Initializes access to log functions
@@ -26,15 +30,19 @@ static logger_initialized = FALSE;
  */
 void logger_init() {
   
-  if (logger_initialized == FALSE) {
+  pthread_mutex_lock(&logger_users_mutex);
+
+  if (logger_users == 0) {
     
     log_mutex = (MUTEX_T*)malloc(sizeof(struct _mutex_t) );
     memset(log_mutex, 0x00, sizeof(struct _mutex_t));
     MUTEX_CREATE(&log_mutex);
-  
-    logger_initialized = TRUE;
     
   }
+
+  logger_users++;
+
+  pthread_mutex_unlock(&logger_users_mutex);
   
 }
 
@@ -46,7 +54,9 @@ void logger_init() {
  */
 void logger_deinit() {
   
-  if (logger_initialized == TRUE) {
+  pthread_mutex_lock(&logger_users_mutex);
+
+  if (logger_users == 1) {
     
     MUTEX_LOCK(log_mutex);
     MUTEX_UNLOCK(log_mutex);
@@ -55,9 +65,13 @@ void logger_deinit() {
     free(log_mutex);
     log_mutex = NULL;
     
-    logger_initialized = FALSE;
-    
   }
+
+  if (logger_users > 0) {
+    logger_users--;
+  }
+
+  pthread_mutex_unlock(&logger_users_mutex);
   
 }
 
@@ -70,10 +84,16 @@ void logger_deinit() {
  */
 void logger_write(const char * function, char * message) {
   
-  if (logger_initialized) {
+  PyGILState_STATE gstate;
+
+  if (logger_users > 0) {
   
-    MUTEX_LOCK(log_mutex);
+    // Takes the GIL first and waits for the log without it, as threads
+    // of the sessions run without the GIL and a thread holding it logs too
     gstate = PyGILState_Ensure();
+    Py_BEGIN_ALLOW_THREADS
+    MUTEX_LOCK(log_mutex);
+    Py_END_ALLOW_THREADS
     
     // Builds the argument list
     PyObject * arglist = Py_BuildValue("(ss)", function, message);
@@ -83,8 +103,8 @@ void logger_write(const char * function, char * message) {
     }
     Py_DECREF(arglist);
 
-    PyGILState_Release(gstate);
     MUTEX_UNLOCK(log_mutex);
+    PyGILState_Release(gstate);
     
   }
   
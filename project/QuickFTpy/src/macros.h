@@ -41,6 +41,16 @@ extern "C" {
 #define	_BUFFER_SIZE_XS 256
 #endif
 
+// Atomic operations
+#define ATOMIC_CAS(p, o, n)   __sync_bool_compare_and_swap(p, o, n)
+#define ATOMIC_ADD(p, v)      __sync_add_and_fetch(p, v)
+#define ATOMIC_SUB(p, v)      __sync_sub_and_fetch(p, v)
+
+// Size of a cache line, for padding data shared between threads
+#ifndef CACHE_LINE_SIZE
+#define CACHE_LINE_SIZE 64
+#endif
+
 // For printing a debug line
 #ifdef _DEBUG
 #define DBG_LINE(s) printf("DBG >> [%s %d] %s\n", __FILE__,__LINE__, s);
@@ -85,12 +85,13 @@ char * _itoa(int num, char* str, int base) {
  *
  * @param len                 filename length
  * @param filename            message content
+ * @param chunked             TRUE to ask for a chunked response
  * @param msg_len             output parameter returns generated message length
  *
  * @return                    generated message, NOT terminated with NULL,
  *                            must be free()d after usage
  */
-char * message_file_receive_request( int len, char * filename, unsigned long * msg_len ) {
+char * message_file_receive_request( int len, char * filename, int chunked, unsigned long * msg_len ) {
 
   char * msg;
   char header[HEADER_LEN];
@@ -118,9 +119,14 @@ char * message_file_receive_request( int len, char * filename, unsigned long * m
   memcpy(&header[++index], FILE_RECEIVE, MSG_TYPE_LEN);
   header[index += MSG_TYPE_LEN] = '=';
 
-  // Builds variable part parameters
-  // Adds filename param
-  sprintf(var_part, "%s=filename:%s", MSG_SEPARATOR, filename);
+  // Builds variable part parameters, a chunked
+  // response must be asked for before the filename
+  if (chunked) {
+    sprintf(var_part, "%s=chunked:1=filename:%s", MSG_SEPARATOR, filename);
+  }
+  else {
+    sprintf(var_part, "%s=filename:%s", MSG_SEPARATOR, filename);
+  }
   
   // Gets var part size in hex.
   _itoa( strlen(var_part), size, 16 );
@@ -223,6 +229,92 @@ char * message_file_receive_response( int result_code, unsigned long len, char *
   return msg;
 }
 
+/**
+ * Generates the header and parameters of a successful File Receive
+ * response, the content is sent separately right after them.
+ *
+ * If the response is not chunked the header accounts for 'len' bytes of
+ * content. Otherwise it only covers the parameters, and the content follows
+ * as frames made of its length in SIZE_LEN hex digits and its data, the
+ * last frame being CHUNK_END.
+ *
+ * @param len                 content length, ignored when chunked
+ * @param chunked             TRUE for a chunked content
+ * @param msg_len             output parameter returns generated message length
+ *
+ * @return                    generated message, NOT terminated with NULL,
+ *                            must be free()d after usage, or NULL if the
+ *                            content does not fit a single message
+ */
+char * message_file_receive_response_prefix( unsigned long long len, int chunked, unsigned long * msg_len ) {
+
+  char * msg;
+  char header[HEADER_LEN];
+  char var_part[VAR_PART_MINIMUM_LEN];
+  char size[SIZE_LEN+1];
+  char size_len[SIZE_LEN+1];
+  char result_string[RESULT_VALUE_LEN+1];
+
+  unsigned long long var_part_size;
+  int index = 0;  
+
+  memset(header, 0x00, HEADER_LEN);
+  memset(var_part, 0x00, VAR_PART_MINIMUM_LEN);
+  memset(size, 0x00, (SIZE_LEN + 1) );
+  *msg_len = 0;
+
+  // Protocol Name
+  memcpy(header, PCOL_NAME, PCOL_NAME_LEN);
+  header[index += PCOL_NAME_LEN] = '=';
+  
+  // Protocol Version
+  memcpy(&header[++index], VERSION, VERSION_LEN);
+  header[index += VERSION_LEN] = '=';
+  
+  // Message Code
+  memcpy(&header[++index], FILE_RECEIVE, MSG_TYPE_LEN);
+  header[index += MSG_TYPE_LEN] = '=';
+
+  // Result
+  sprintf(result_string, "%s", message_result_code_to_string(RESULT_SUCCESS, result_string) );  
+
+  // Builds variable part parameters, the content is not included
+  if (chunked) {
+
+    sprintf(var_part, "%s=result:%s=chunked:1=content:", MSG_SEPARATOR, result_string);
+    var_part_size = strlen(var_part);
+  }
+  else {
+
+    sprintf(var_part, "%s=result:%s=length:%llu=content:", MSG_SEPARATOR, result_string, len);
+    var_part_size = strlen(var_part) + len;
+  }
+
+  if (var_part_size > VAR_PART_MAXIMUM_LEN) {
+    return NULL;
+  }
+
+  // Gets var part size in hex.
+  sprintf( size, "%lx", (unsigned long)var_part_size );
+
+  // Applies padding to var part size
+  string_left_padding( size, SIZE_LEN, '0', size_len);
+
+  // Inserts var part size value in header
+  memcpy(&header[++index], size_len, SIZE_LEN);
+
+  // Allocates memory for the message
+  *msg_len = HEADER_LEN + strlen(var_part);
+  msg = malloc(*msg_len);
+  
+  // Copies header, separator, and parameters of the message
+  memcpy( msg, header, HEADER_LEN );
+  memcpy( &msg[HEADER_LEN], var_part, (*msg_len - HEADER_LEN) );
+
+  // Returns message
+  return msg;
+}
+
 /**
  * Generates a File Send request message
  * 
@@ -290,6 +382,95 @@ char * message_file_send_request( char * path, unsigned long len, char * content
   return msg;
 }
 
+/**
+ * Generates the header and parameters of a File Send request message,
+ * the content is sent separately right after them.
+ *
+ * If the request is not chunked the header accounts for 'len' bytes of
+ * content. Otherwise it only covers the parameters, and the content follows
+ * as the frames of a chunked File Receive response do.
+ * 
+ * @param path                filepath in destination
+ * @param len                 content length, ignored when chunked
+ * @param size                original file size
+ * @param chunked             TRUE for a chunked content
+ * @param msg_len             output parameter returns generated message length
+ *
+ * @return                    generated message, NOT terminated with NULL,
+ *                            must be free()d after usage, or NULL if the
+ *                            content does not fit a single message
+ */
+char * message_file_send_request_prefix( char * path, unsigned long long len, long long size, int chunked, unsigned long * msg_len ) {
+
+  char * msg;
+  char header[HEADER_LEN];
+  char * var_part;
+  char size_hex[SIZE_LEN+1];
+  char size_len[SIZE_LEN+1];
+
+  unsigned long long var_part_size;
+  int index = 0;  
+
+  memset(header, 0x00, HEADER_LEN);
+  var_part = malloc( strlen(path) + VAR_PART_MINIMUM_LEN );
+  memset(var_part, 0x00, VAR_PART_MINIMUM_LEN);
+  memset(size_hex, 0x00, (SIZE_LEN + 1) );
+  *msg_len = 0;
+
+  // Protocol Name
+  memcpy(header, PCOL_NAME, PCOL_NAME_LEN);
+  header[index += PCOL_NAME_LEN] = '=';
+  
+  // Protocol Version
+  memcpy(&header[++index], VERSION, VERSION_LEN);
+  header[index += VERSION_LEN] = '=';
+  
+  // Message Code
+  memcpy(&header[++index], FILE_SEND, MSG_TYPE_LEN);
+  header[index += MSG_TYPE_LEN] = '=';
+
+  // Builds variable part parameters, the content is not included
+  if (chunked) {
+
+    sprintf(var_part, "%s=path:%s=chunked:1=size:%lld=content:", MSG_SEPARATOR, path, size);
+    var_part_size = strlen(var_part);
+  }
+  else {
+
+    sprintf(var_part, "%s=path:%s=length:%llu=size:%lld=content:", MSG_SEPARATOR, path, len, size);
+    var_part_size = strlen(var_part) + len;
+  }
+
+  if (var_part_size > VAR_PART_MAXIMUM_LEN) {
+
+    free(var_part);
+    return NULL;
+  }
+
+  // Gets var part size in hex.
+  sprintf( size_hex, "%lx", (unsigned long)var_part_size );
+
+  // Applies padding to var part size
+  string_left_padding( size_hex, SIZE_LEN, '0', size_len);
+
+  // Inserts var part size value in header
+  memcpy(&header[++index], size_len, SIZE_LEN);
+
+  // Allocates memory for the message
+  *msg_len = HEADER_LEN + strlen(var_part);
+  msg = malloc(*msg_len);
+  
+  // Copies header, separator, and parameters of the message
+  memcpy( msg, header, HEADER_LEN );
+  memcpy( &msg[HEADER_LEN], var_part, (*msg_len - HEADER_LEN) );
+
+  // Frees memory
+  free(var_part);
+
+  // Returns message
+  return msg;
+}
+
 /**
  * Generates a File Send response message
  *
@@ -547,124 +728,1073 @@ int message_is_valid_header ( char * header, long * var_part_size, unsigned long
 }
 
 /**
- * Returns the corresponding string for a given result code
+ * Gets the version of the protocol a header belongs to
  *
- * @param result_code       result code
- * @param buffer            buffer for copying the string
+ * @param header            header to evaluate, HEADER_LEN bytes
  *
- * @return                  result string
+ * @return                  1 or 2, or 0 if the header is not a valid one
  */
-char * message_result_code_to_string(int result_code, char * result_string) {
+int message_header_version ( char * header ) {
 
-  sprintf(result_string, "%s", STR_RESULT_UNDEFINED);
+  if ( memcmp( header, PCOL_NAME, PCOL_NAME_LEN ) != 0 ) {
+    return 0;
+  }
 
-  switch (result_code) {
+  if ( memcmp( &header[PCOL_NAME_LEN+1], VERSION, VERSION_LEN ) == 0 ) {
+    return 1;
+  }
 
-    case RESULT_SUCCESS:
+  if ( memcmp( &header[PCOL_NAME_LEN+1], VERSION_2, VERSION_LEN ) == 0 ) {
+    return 2;
+  }
 
-      sprintf(result_string, "%s", STR_RESULT_SUCCESS);
-      break;
+  return 0;
+}
 
-    case RESULT_INVALID_REQUEST:
+/**
+ * Evaluates if a V2 header is valid, and if it is returns
+ * the length of the parameters and the flags of the message
+ * 
+ * @param header            header to evaluate
+ * @param params_len        returns the length of the parameters
+ *                          if the header is valid, otherwise returns 0.
+ * @param flags             returns the flags of the message
+ * @param type              defines a value or binary addition of values for
+ *                          message codes, ACK_B included
+ *   
+ * @return                  message code if header is valid, otherwise FALSE
+ */
+int message_is_valid_header_v2 ( char * header, unsigned long * params_len, int * flags, unsigned long type ) {
 
-      sprintf(result_string, "%s", STR_RESULT_INVALID_REQUEST);
-      break;
+  int message_type;
 
-    case RESULT_INVALID_RESPONSE:
+  *params_len = 0;
+  *flags = 0;
 
-      sprintf(result_string, "%s", STR_RESULT_INVALID_RESPONSE);
-      break;
+  if ( message_header_version(header) != 2 ) {
+    return FALSE;
+  }
 
-    case RESULT_CONFIG_ERROR:
+  // Only one message code is allowed, and it has to be an expected one
+  message_type = (unsigned char)header[V2_TYPE_OFFSET];
+  if ( ( message_type & ( message_type - 1 ) ) != 0 || ( message_type & type ) == 0 ) {
+    return FALSE;
+  }
 
-      sprintf(result_string, "%s", STR_RESULT_CONFIG_ERROR);
-      break;
+  *params_len = GET_UINT32( &header[V2_PARAMS_LEN_OFFSET] );
+  *flags = (unsigned char)header[V2_FLAGS_OFFSET];
 
-    case RESULT_FILE_ACCESS_ERROR:
-    
-      sprintf(result_string, "%s", STR_RESULT_FILE_ACCESS_ERROR);
-      break;
+  return message_type;
+}
 
-    case RESULT_FILE_NOT_FOUND:
-    
-      sprintf(result_string, "%s", STR_RESULT_FILE_NOT_FOUND);
-      break;
+/**
+ * Generates a V2 header
+ *
+ * @param header            buffer of HEADER_LEN bytes for the header
+ * @param type              binary value of the message code
+ * @param flags             message flags
+ * @param params_len        length of the parameters that follow
+ */
+void message_v2_header ( char * header, int type, int flags, unsigned long params_len ) {
 
-    case RESULT_FILE_WRITE_ERROR:
-    
-      sprintf(result_string, "%s", STR_RESULT_FILE_WRITE_ERROR);
-      break;
+  int index = 0;
 
-    case RESULT_FILE_READ_ERROR:
+  memset(header, 0x00, HEADER_LEN);
 
-      sprintf(result_string, "%s", STR_RESULT_FILE_READ_ERROR);
-      break;
+  // Protocol Name
+  memcpy(header, PCOL_NAME, PCOL_NAME_LEN);
+  header[index += PCOL_NAME_LEN] = '=';
 
-    case RESULT_FILE_COMPRESS_ERROR:
-    
-      sprintf(result_string, "%s", STR_RESULT_FILE_COMPRESS_ERROR);
-      break;
+  // Protocol Version
+  memcpy(&header[++index], VERSION_2, VERSION_LEN);
+  header[index += VERSION_LEN] = '=';
 
-    case RESULT_FILE_DECOMPRESS_ERROR:
-    
-      sprintf(result_string, "%s", STR_RESULT_FILE_DECOMPRESS_ERROR);
-      break;
+  // Message Code, flags and length of the parameters
+  header[V2_TYPE_OFFSET] = (char)type;
+  header[V2_FLAGS_OFFSET] = (char)flags;
+  PUT_UINT32( &header[V2_PARAMS_LEN_OFFSET], params_len );
+}
 
-    case RESULT_FILE_ENCODE_ERROR:
-    
-      sprintf(result_string, "%s", STR_RESULT_FILE_ENCODE_ERROR);
-      break;
+/**
+ * Sets the request ID of a V2 message
+ *
+ * @param header            header of the message
+ * @param request_id        request ID
+ */
+void message_v2_set_request_id ( char * header, unsigned long request_id ) {
 
-    case RESULT_FILE_DECODE_ERROR:
+  PUT_UINT32( &header[V2_REQUEST_ID_OFFSET], request_id );
+}
 
-      sprintf(result_string, "%s", STR_RESULT_FILE_DECODE_ERROR);
-      break;
+/**
+ * Gets the request ID of a V2 message
+ *
+ * @param header            header of the message
+ *
+ * @return                  request ID, 0 outside of a pipeline
+ */
+unsigned long message_v2_get_request_id ( const char * header ) {
 
-    case RESULT_FILE_DELETE_ERROR:
+  return GET_UINT32( &header[V2_REQUEST_ID_OFFSET] );
+}
 
-      sprintf(result_string, "%s", STR_RESULT_FILE_DELETE_ERROR);
-      break;
+/**
+ * Appends a parameter to the ones of a V2 message
+ *
+ * @param params            parameters of the message
+ * @param params_len        length of the parameters, updated
+ * @param tag               tag of the parameter
+ * @param value             value of the parameter
+ * @param len               length of the value
+ */
+static void message_v2_put_param ( char * params, unsigned long * params_len, int tag, const void * value, int len ) {
 
-    case RESULT_INVALID_DESTINATION_DIRECTORY:
-    
-      sprintf(result_string, "%s", STR_RESULT_INVALID_DESTINATION_DIRECTORY);
-      break;
+  params[*params_len] = (char)tag;
+  PUT_UINT16( &params[*params_len + 1], len );
+  memcpy( &params[*params_len + TLV_HEADER_LEN], value, len );
 
-    case RESULT_COULD_NOT_CREATE_DESTINATION_DIRECTORY:
+  *params_len += TLV_HEADER_LEN + len;
+}
 
-      sprintf(result_string, "%s", STR_RESULT_COULD_NOT_CREATE_DESTINATION_DIRECTORY);
+/**
+ * Finds a parameter of a V2 message
+ *
+ * @param params            parameters of the message
+ * @param params_len        length of the parameters
+ * @param tag               tag of the parameter
+ * @param value             returns a pointer to the value within the parameters
+ *
+ * @return                  length of the value, or -1 if the parameter
+ *                          is not found or the parameters are malformed
+ */
+int message_v2_get_param ( const char * params, unsigned long params_len, int tag, const char ** value ) {
+
+  unsigned long index = 0;
+  unsigned long len;
+
+  while ( index + TLV_HEADER_LEN <= params_len ) {
+
+    len = GET_UINT16( &params[index + 1] );
+    if ( index + TLV_HEADER_LEN + len > params_len ) {
       break;
+    }
+
+    if ( (unsigned char)params[index] == tag ) {
+
+      *value = &params[index + TLV_HEADER_LEN];
+      return (int)len;
+    }
 
+    index += TLV_HEADER_LEN + len;
   }
 
-  return result_string;
+  *value = NULL;
+  return -1;
 }
 
 /**
- * Returns the corresponding result code from a result string
+ * Appends an 8 bytes parameter to the ones of a V2 message
  *
- * @param                   result string
- * @return                  result code
+ * @param params            parameters of the message
+ * @param params_len        length of the parameters, updated
+ * @param tag               tag of the parameter
+ * @param number            value
  */
-int message_result_string_to_code(char * result_string) {
+static void message_v2_put_uint64 ( char * params, unsigned long * params_len, int tag, unsigned long long number ) {
 
-  int code = RESULT_UNDEFINED;
+  char value[8];
 
-  if (strcmp(result_string, STR_RESULT_SUCCESS) == 0) {
+  PUT_UINT32( value, (unsigned long)( number >> 32 ) );
+  PUT_UINT32( &value[4], (unsigned long)( number & 0xFFFFFFFFULL ) );
 
-    code = RESULT_SUCCESS;
-  }
-  else if (strcmp(result_string, STR_RESULT_CONNECTION_ERROR) == 0) {
+  message_v2_put_param( params, params_len, tag, value, sizeof(value) );
+}
 
-    code = RESULT_CONNECTION_ERROR;
-  }
-  else if (strcmp(result_string, STR_RESULT_INVALID_REQUEST) == 0) {
+/**
+ * Gets an 8 bytes parameter of a V2 message
+ *
+ * @param params            parameters of the message
+ * @param params_len        length of the parameters
+ * @param tag               tag of the parameter
+ * @param number            returns the value, 0 if not found
+ *
+ * @return                  TRUE, or FALSE if the parameter is not found
+ */
+static int message_v2_get_uint64 ( const char * params, unsigned long params_len, int tag, unsigned long long * number ) {
 
-    code = RESULT_INVALID_REQUEST;
-  }
-  else if (strcmp(result_string, STR_RESULT_INVALID_RESPONSE) == 0) {
+  const char * value;
 
-    code = RESULT_INVALID_RESPONSE;
+  *number = 0;
+
+  if ( message_v2_get_param( params, params_len, tag, &value ) != 8 ) {
+    return FALSE;
+  }
+
+  *number = ( (unsigned long long)GET_UINT32(value) << 32 ) | GET_UINT32(&value[4]);
+
+  return TRUE;
+}
+
+/**
+ * Appends a size parameter to the ones of a V2 message
+ *
+ * @param params            parameters of the message
+ * @param params_len        length of the parameters, updated
+ * @param size              size
+ */
+static void message_v2_put_size ( char * params, unsigned long * params_len, long long size ) {
+
+  message_v2_put_uint64( params, params_len, TAG_SIZE, (unsigned long long)size );
+}
+
+/**
+ * Gets the size parameter of a V2 message
+ *
+ * @param params            parameters of the message
+ * @param params_len        length of the parameters
+ * @param size              returns the size
+ *
+ * @return                  TRUE, or FALSE if the parameter is not found
+ */
+int message_v2_get_size ( const char * params, unsigned long params_len, long long * size ) {
+
+  unsigned long long value;
+  int found;
+
+  found = message_v2_get_uint64( params, params_len, TAG_SIZE, &value );
+  *size = (long long)value;
+
+  return found;
+}
+
+/**
+ * Appends an offset parameter to the ones of a V2 message,
+ * a negative offset is left out
+ *
+ * @param params            parameters of the message
+ * @param params_len        length of the parameters, updated
+ * @param offset            offset
+ */
+static void message_v2_put_offset ( char * params, unsigned long * params_len, long long offset ) {
+
+  if ( offset >= 0 ) {
+    message_v2_put_uint64( params, params_len, TAG_OFFSET, (unsigned long long)offset );
+  }
+}
+
+/**
+ * Gets the offset parameter of a V2 message
+ *
+ * @param params            parameters of the message
+ * @param params_len        length of the parameters
+ * @param offset            returns the offset
+ *
+ * @return                  TRUE, or FALSE if the parameter is not found
+ */
+int message_v2_get_offset ( const char * params, unsigned long params_len, long long * offset ) {
+
+  unsigned long long value;
+  int found;
+
+  found = message_v2_get_uint64( params, params_len, TAG_OFFSET, &value );
+  *offset = (long long)value;
+
+  return found;
+}
+
+/**
+ * Gets the byte range length parameter of a V2 message
+ *
+ * @param params            parameters of the message
+ * @param params_len        length of the parameters
+ * @param length            returns the length
+ *
+ * @return                  TRUE, or FALSE if the parameter is not found
+ */
+int message_v2_get_length ( const char * params, unsigned long params_len, long long * length ) {
+
+  unsigned long long value;
+  int found;
+
+  found = message_v2_get_uint64( params, params_len, TAG_LENGTH, &value );
+  *length = (long long)value;
+
+  return found;
+}
+
+/**
+ * Gets the content hash parameter of a V2 message
+ *
+ * @param params            parameters of the message
+ * @param params_len        length of the parameters
+ * @param hash              returns the hash
+ *
+ * @return                  TRUE, or FALSE if the parameter is not found
+ */
+int message_v2_get_hash ( const char * params, unsigned long params_len, unsigned long long * hash ) {
+
+  return message_v2_get_uint64( params, params_len, TAG_HASH, hash );
+}
+
+/**
+ * Gets the content digest parameter of a V2 message
+ *
+ * @param params            parameters of the message
+ * @param params_len        length of the parameters
+ *
+ * @return                  digest of V2_DIGEST_LEN bytes within the
+ *                          parameters, or NULL if the parameter is not found
+ */
+const unsigned char * message_v2_get_digest ( const char * params, unsigned long params_len ) {
+
+  const char * value;
+
+  if ( message_v2_get_param( params, params_len, TAG_DIGEST, &value ) != V2_DIGEST_LEN ) {
+    return NULL;
+  }
+
+  return (const unsigned char *)value;
+}
+
+/**
+ * Appends a block size parameter to the ones of a V2 message
+ *
+ * @param params            parameters of the message
+ * @param params_len        length of the parameters, updated
+ * @param block_size        block size
+ */
+static void message_v2_put_block ( char * params, unsigned long * params_len, long block_size ) {
+
+  char value[4];
+
+  PUT_UINT32( value, (unsigned long)block_size );
+  message_v2_put_param( params, params_len, TAG_BLOCK, value, sizeof(value) );
+}
+
+/**
+ * Gets the block size parameter of a V2 message
+ *
+ * @param params            parameters of the message
+ * @param params_len        length of the parameters
+ *
+ * @return                  block size, or -1 if the parameter is not found
+ */
+long message_v2_get_block ( const char * params, unsigned long params_len ) {
+
+  const char * value;
+
+  if ( message_v2_get_param( params, params_len, TAG_BLOCK, &value ) != 4 ) {
+    return -1;
+  }
+
+  return (long)( GET_UINT32(value) & 0x7FFFFFFFUL );
+}
+
+/**
+ * Gets the compression mode parameter of a V2 message
+ *
+ * @param params            parameters of the message
+ * @param params_len        length of the parameters
+ *
+ * @return                  compression mode, or -1 if the parameter is not found
+ */
+int message_v2_get_mode ( const char * params, unsigned long params_len ) {
+
+  const char * value;
+
+  if ( message_v2_get_param( params, params_len, TAG_MODE, &value ) != 1 ) {
+    return -1;
+  }
+
+  return (unsigned char)value[0];
+}
+
+/**
+ * Gets the codec parameter of a V2 message
+ *
+ * @param params            parameters of the message
+ * @param params_len        length of the parameters
+ *
+ * @return                  codec, or 0 (gzip) if the parameter is not found
+ */
+int message_v2_get_codec ( const char * params, unsigned long params_len ) {
+
+  const char * value;
+
+  if ( message_v2_get_param( params, params_len, TAG_CODEC, &value ) != 1 ) {
+    return 0;
+  }
+
+  return (unsigned char)value[0];
+}
+
+/**
+ * Appends a codec parameter to the ones of a V2 message, gzip is left out
+ *
+ * @param params            parameters of the message
+ * @param params_len        length of the parameters, updated
+ * @param codec             codec
+ */
+static void message_v2_put_codec ( char * params, unsigned long * params_len, int codec ) {
+
+  char codec_value = (char)codec;
+
+  if ( codec > 0 ) {
+    message_v2_put_param( params, params_len, TAG_CODEC, &codec_value, 1 );
+  }
+}
+
+/**
+ * Generates a V2 message made of a header and the given parameters
+ *
+ * @param type              binary value of the message code
+ * @param flags             message flags
+ * @param params            parameters of the message
+ * @param params_len        length of the parameters
+ * @param msg_len           output parameter returns generated message length
+ *
+ * @return                  generated message, must be free()d after usage
+ */
+static char * message_v2_build ( int type, int flags, const char * params, unsigned long params_len, unsigned long * msg_len ) {
+
+  char * msg;
+
+  *msg_len = HEADER_LEN + params_len;
+  msg = malloc(*msg_len);
+
+  message_v2_header( msg, type, flags, params_len );
+  memcpy( &msg[HEADER_LEN], params, params_len );
+
+  return msg;
+}
+
+/**
+ * Generates a V2 request message with a filename and a codec as its parameters
+ *
+ * @param type              binary value of the message code
+ * @param filename          name of the file
+ * @param flags             message flags
+ * @param codec             codec asked for, or 0 (gzip) to leave it out
+ * @param offset            offset asked for, or -1 to leave it out
+ * @param hash              hash of the content before the offset,
+ *                          left out unless the offset is positive
+ * @param msg_len           output parameter returns generated message length
+ *
+ * @return                  generated message, must be free()d after usage,
+ *                          or NULL if the filename is too long
+ */
+static char * message_v2_filename_request ( int type, char * filename, int flags, int codec, long long offset, unsigned long long hash, unsigned long * msg_len ) {
+
+  char * msg;
+  char * params;
+  unsigned long params_len = 0;
+  size_t len = strlen(filename);
+
+  *msg_len = 0;
+
+  if ( len > TLV_VALUE_MAXIMUM_LEN ) {
+    return NULL;
+  }
+
+  params = malloc( TLV_HEADER_LEN + len + TLV_HEADER_LEN + 1 + ( TLV_HEADER_LEN + 8 ) * 2 );
+  message_v2_put_param( params, &params_len, TAG_FILENAME, filename, len );
+  message_v2_put_codec( params, &params_len, codec );
+  message_v2_put_offset( params, &params_len, offset );
+
+  if ( offset > 0 ) {
+    message_v2_put_uint64( params, &params_len, TAG_HASH, hash );
+  }
+
+  msg = message_v2_build( type, flags, params, params_len, msg_len );
+
+  free(params);
+
+  return msg;
+}
+
+/**
+ * Generates a V2 File Receive request message
+ *
+ * @param filename            name of the file to receive
+ * @param flags               V2_FLAG_RAW to ask for the file uncompressed,
+ *                            V2_FLAG_KEEP_ALIVE to keep the connection open
+ * @param codec               codec asked for the content, or 0 (gzip)
+ * @param offset              offset to receive the file from, or -1
+ *                            to leave it out
+ * @param hash                hash of the content the client already
+ *                            has before the offset
+ * @param msg_len             output parameter returns generated message length
+ *
+ * @return                    generated message, NOT terminated with NULL,
+ *                            must be free()d after usage, or NULL if the
+ *                            filename is too long
+ */
+char * message_v2_file_receive_request( char * filename, int flags, int codec, long long offset, unsigned long long hash, unsigned long * msg_len ) {
+
+  return message_v2_filename_request( FILE_RCV_B, filename, flags, codec, offset, hash, msg_len );
+}
+
+/**
+ * Generates a V2 File Receive request message for a byte range of a file
+ *
+ * @param filename            name of the file to receive
+ * @param flags               V2_FLAG_RAW to ask for the range uncompressed,
+ *                            V2_FLAG_KEEP_ALIVE to keep the connection open
+ * @param codec               codec asked for the content, or 0 (gzip)
+ * @param offset              offset the range starts at, counted from the
+ *                            end of the file when negative
+ * @param length              length of the range, or -1 up to the end
+ * @param msg_len             output parameter returns generated message length
+ *
+ * @return                    generated message, NOT terminated with NULL,
+ *                            must be free()d after usage, or NULL if the
+ *                            filename is too long
+ */
+char * message_v2_file_range_request( char * filename, int flags, int codec, long long offset, long long length, unsigned long * msg_len ) {
+
+  char * msg;
+  char * params;
+  unsigned long params_len = 0;
+  size_t len = strlen(filename);
+
+  *msg_len = 0;
+
+  if ( len > TLV_VALUE_MAXIMUM_LEN ) {
+    return NULL;
+  }
+
+  params = malloc( TLV_HEADER_LEN + len + TLV_HEADER_LEN + 1 + ( TLV_HEADER_LEN + 8 ) * 2 );
+  message_v2_put_param( params, &params_len, TAG_FILENAME, filename, len );
+  message_v2_put_codec( params, &params_len, codec );
+  message_v2_put_uint64( params, &params_len, TAG_OFFSET, (unsigned long long)offset );
+  message_v2_put_uint64( params, &params_len, TAG_LENGTH, (unsigned long long)length );
+
+  msg = message_v2_build( FILE_RCV_B, flags, params, params_len, msg_len );
+
+  free(params);
+
+  return msg;
+}
+
+/**
+ * Generates the response to a V2 File Receive request when the file
+ * is sent uncompressed, the file is sent right after it
+ *
+ * @param size                length of the content that follows
+ * @param offset              offset the content starts at, or -1
+ *                            to leave it out
+ * @param flags               V2_FLAG_KEEP_ALIVE if the connection is kept open
+ * @param msg_len             output parameter returns generated message length
+ *
+ * @return                    generated message, NOT terminated with NULL,
+ *                            must be free()d after usage
+ */
+char * message_v2_file_receive_response_raw( long long size, long long offset, int flags, unsigned long * msg_len ) {
+
+  char params[( TLV_HEADER_LEN + 4 ) + ( TLV_HEADER_LEN + 8 ) * 2];
+  char result_value[4];
+  unsigned long params_len = 0;
+
+  PUT_UINT32( result_value, (unsigned long)RESULT_SUCCESS );
+  message_v2_put_param( params, &params_len, TAG_RESULT, result_value, sizeof(result_value) );
+  message_v2_put_size( params, &params_len, size );
+  message_v2_put_offset( params, &params_len, offset );
+
+  return message_v2_build( FILE_RCV_B, V2_FLAG_RAW | flags, params, params_len, msg_len );
+}
+
+/**
+ * Generates a V2 File Receive request message for the signature of a file
+ *
+ * @param filename            name of the file
+ * @param flags               V2_FLAG_KEEP_ALIVE to keep the connection open
+ * @param block_size          block size asked for, or 0 for the server to choose it
+ * @param msg_len             output parameter returns generated message length
+ *
+ * @return                    generated message, NOT terminated with NULL,
+ *                            must be free()d after usage, or NULL if the
+ *                            filename is too long
+ */
+char * message_v2_file_signature_request( char * filename, int flags, long block_size, unsigned long * msg_len ) {
+
+  char * msg;
+  char * params;
+  unsigned long params_len = 0;
+  size_t len = strlen(filename);
+
+  *msg_len = 0;
+
+  if ( len > TLV_VALUE_MAXIMUM_LEN ) {
+    return NULL;
+  }
+
+  params = malloc( TLV_HEADER_LEN + len + TLV_HEADER_LEN + 4 );
+  message_v2_put_param( params, &params_len, TAG_FILENAME, filename, len );
+  message_v2_put_block( params, &params_len, block_size );
+
+  msg = message_v2_build( FILE_RCV_B, flags, params, params_len, msg_len );
+
+  free(params);
+
+  return msg;
+}
+
+/**
+ * Generates the response to a V2 File Receive request for the signature
+ * of a file, the signature is sent uncompressed right after it
+ *
+ * @param size                length of the signature
+ * @param block_size          block size of the signature
+ * @param flags               V2_FLAG_KEEP_ALIVE if the connection is kept open
+ * @param msg_len             output parameter returns generated message length
+ *
+ * @return                    generated message, NOT terminated with NULL,
+ *                            must be free()d after usage
+ */
+char * message_v2_file_signature_response( long long size, long block_size, int flags, unsigned long * msg_len ) {
+
+  char params[( TLV_HEADER_LEN + 4 ) * 2 + ( TLV_HEADER_LEN + 8 )];
+  char result_value[4];
+  unsigned long params_len = 0;
+
+  PUT_UINT32( result_value, (unsigned long)RESULT_SUCCESS );
+  message_v2_put_param( params, &params_len, TAG_RESULT, result_value, sizeof(result_value) );
+  message_v2_put_size( params, &params_len, size );
+  message_v2_put_block( params, &params_len, block_size );
+
+  return message_v2_build( FILE_RCV_B, V2_FLAG_RAW | flags, params, params_len, msg_len );
+}
+
+/**
+ * Generates the response to a V2 File Receive request when the file
+ * is packed, the content frames are sent right after it
+ *
+ * @param codec               codec of the content
+ * @param mode                compression mode of the content
+ * @param offset              offset the content starts at, or -1
+ *                            to leave it out
+ * @param flags               V2_FLAG_KEEP_ALIVE if the connection is kept open
+ * @param msg_len             output parameter returns generated message length
+ *
+ * @return                    generated message, NOT terminated with NULL,
+ *                            must be free()d after usage
+ */
+char * message_v2_file_receive_response_packed( int codec, int mode, long long offset, int flags, unsigned long * msg_len ) {
+
+  char params[( TLV_HEADER_LEN + 4 ) + ( TLV_HEADER_LEN + 1 ) * 2 + ( TLV_HEADER_LEN + 8 )];
+  char result_value[4];
+  char mode_value = (char)mode;
+  unsigned long params_len = 0;
+
+  PUT_UINT32( result_value, (unsigned long)RESULT_SUCCESS );
+  message_v2_put_param( params, &params_len, TAG_RESULT, result_value, sizeof(result_value) );
+  message_v2_put_param( params, &params_len, TAG_MODE, &mode_value, 1 );
+  message_v2_put_codec( params, &params_len, codec );
+  message_v2_put_offset( params, &params_len, offset );
+
+  return message_v2_build( FILE_RCV_B, V2_FLAG_CHUNKED | flags, params, params_len, msg_len );
+}
+
+/**
+ * Generates a V2 File Send request message, the content is
+ * sent once the server acknowledges the request
+ *
+ * @param path                filepath in destination
+ * @param size                original file size
+ * @param flags               V2_FLAG_CHUNKED to send the content as frames,
+ *                            or V2_FLAG_RAW to send the file uncompressed,
+ *                            V2_FLAG_KEEP_ALIVE to keep the connection open
+ * @param codec               codec asked for the content frames, or 0 (gzip)
+ * @param mode                compression mode of the content frames, or -1
+ * @param transfer            ID of a resumable transfer, or NULL
+ * @param hash                hash of the content of a resumable transfer
+ * @param digest              SHA-256 digest of the content, V2_DIGEST_LEN
+ *                            bytes, or NULL
+ * @param msg_len             output parameter returns generated message length
+ *
+ * @return                    generated message, NOT terminated with NULL,
+ *                            must be free()d after usage, or NULL if the
+ *                            path or the transfer ID is too long
+ */
+char * message_v2_file_send_request( char * path, long long size, int flags, int codec, int mode, char * transfer, unsigned long long hash, const unsigned char * digest, unsigned long * msg_len ) {
+
+  char * msg;
+  char * params;
+  char mode_value = (char)mode;
+  unsigned long params_len = 0;
+  size_t len = strlen(path);
+  size_t transfer_len = ( transfer != NULL ) ? strlen(transfer) : 0;
+
+  *msg_len = 0;
+
+  if ( len > TLV_VALUE_MAXIMUM_LEN || transfer_len > TRANSFER_ID_MAXIMUM_LEN ) {
+    return NULL;
+  }
+
+  params = malloc( TLV_HEADER_LEN + len + TLV_HEADER_LEN + 8 + ( TLV_HEADER_LEN + 1 ) * 2 + TLV_HEADER_LEN + transfer_len + TLV_HEADER_LEN + 8 +
+                   TLV_HEADER_LEN + V2_DIGEST_LEN );
+  message_v2_put_param( params, &params_len, TAG_PATH, path, len );
+  message_v2_put_size( params, &params_len, size );
+
+  if ( mode >= 0 ) {
+    message_v2_put_param( params, &params_len, TAG_MODE, &mode_value, 1 );
+  }
+  message_v2_put_codec( params, &params_len, codec );
+
+  if ( transfer != NULL ) {
+
+    message_v2_put_param( params, &params_len, TAG_TRANSFER, transfer, transfer_len );
+    message_v2_put_uint64( params, &params_len, TAG_HASH, hash );
+  }
+
+  if ( digest != NULL ) {
+    message_v2_put_param( params, &params_len, TAG_DIGEST, digest, V2_DIGEST_LEN );
+  }
+
+  msg = message_v2_build( FILE_SND_B, flags, params, params_len, msg_len );
+
+  free(params);
+
+  return msg;
+}
+
+/**
+ * Generates a V2 File Send request message whose content frames are a delta
+ * against the current file, sent once the server acknowledged the request
+ *
+ * @param path                filepath in destination
+ * @param size                size of the new file
+ * @param flags               V2_FLAG_KEEP_ALIVE to keep the connection open
+ * @param codec               codec asked for the content frames, or 0 (gzip)
+ * @param mode                compression mode of the content frames
+ * @param block_size          block size of the signature the delta refers to
+ * @param digest              SHA-256 digest of the new file, V2_DIGEST_LEN bytes
+ * @param msg_len             output parameter returns generated message length
+ *
+ * @return                    generated message, NOT terminated with NULL,
+ *                            must be free()d after usage, or NULL if the
+ *                            path is too long
+ */
+char * message_v2_file_delta_request( char * path, long long size, int flags, int codec, int mode, long block_size, const unsigned char * digest, unsigned long * msg_len ) {
+
+  char * msg;
+  char * params;
+  char mode_value = (char)mode;
+  unsigned long params_len = 0;
+  size_t len = strlen(path);
+
+  *msg_len = 0;
+
+  if ( len > TLV_VALUE_MAXIMUM_LEN ) {
+    return NULL;
+  }
+
+  params = malloc( TLV_HEADER_LEN + len + TLV_HEADER_LEN + 8 + ( TLV_HEADER_LEN + 1 ) * 2 + TLV_HEADER_LEN + 4 + TLV_HEADER_LEN + V2_DIGEST_LEN );
+  message_v2_put_param( params, &params_len, TAG_PATH, path, len );
+  message_v2_put_size( params, &params_len, size );
+  message_v2_put_param( params, &params_len, TAG_MODE, &mode_value, 1 );
+  message_v2_put_codec( params, &params_len, codec );
+  message_v2_put_block( params, &params_len, block_size );
+  message_v2_put_param( params, &params_len, TAG_DIGEST, digest, V2_DIGEST_LEN );
+
+  msg = message_v2_build( FILE_SND_B, V2_FLAG_CHUNKED | flags, params, params_len, msg_len );
+
+  free(params);
+
+  return msg;
+}
+
+/**
+ * Generates a V2 File Send request message of a striped transfer
+ *
+ * @param path                filepath in destination
+ * @param size                size of the whole file
+ * @param flags               message flags
+ * @param codec               codec asked for the content frames, or 0 (gzip)
+ * @param mode                compression mode of the content frames, or -1
+ * @param stripe              ID of the striped transfer
+ * @param offset              offset of the range
+ * @param length              length of the range, or -1 to commit the transfer
+ * @param msg_len             output parameter returns generated message length
+ *
+ * @return                    generated message, must be free()d after usage,
+ *                            or NULL if the path or the stripe ID is too long
+ */
+static char * message_v2_stripe_request( char * path, long long size, int flags, int codec, int mode, char * stripe, long long offset, long long length, unsigned long * msg_len ) {
+
+  char * msg;
+  char * params;
+  char mode_value = (char)mode;
+  unsigned long params_len = 0;
+  size_t len = strlen(path);
+  size_t stripe_len = strlen(stripe);
+
+  *msg_len = 0;
+
+  if ( len > TLV_VALUE_MAXIMUM_LEN || stripe_len > TRANSFER_ID_MAXIMUM_LEN ) {
+    return NULL;
+  }
+
+  params = malloc( TLV_HEADER_LEN + len + ( TLV_HEADER_LEN + 8 ) * 3 + ( TLV_HEADER_LEN + 1 ) * 2 + TLV_HEADER_LEN + stripe_len );
+  message_v2_put_param( params, &params_len, TAG_PATH, path, len );
+  message_v2_put_size( params, &params_len, size );
+  message_v2_put_param( params, &params_len, TAG_STRIPE, stripe, stripe_len );
+
+  if ( length >= 0 ) {
+
+    message_v2_put_uint64( params, &params_len, TAG_OFFSET, (unsigned long long)offset );
+    message_v2_put_uint64( params, &params_len, TAG_LENGTH, (unsigned long long)length );
+
+    if ( mode >= 0 ) {
+      message_v2_put_param( params, &params_len, TAG_MODE, &mode_value, 1 );
+    }
+    message_v2_put_codec( params, &params_len, codec );
+  }
+
+  msg = message_v2_build( FILE_SND_B, flags, params, params_len, msg_len );
+
+  free(params);
+
+  return msg;
+}
+
+/**
+ * Generates a V2 File Send request message for a byte range of a striped
+ * transfer, the content is sent once the server acknowledged it
+ *
+ * @param path                filepath in destination
+ * @param size                size of the whole file
+ * @param flags               V2_FLAG_CHUNKED for content frames, V2_FLAG_RAW
+ *                            for the range uncompressed, V2_FLAG_KEEP_ALIVE
+ *                            to keep the connection open
+ * @param codec               codec asked for the content frames, or 0 (gzip)
+ * @param mode                compression mode of the content frames, or -1
+ * @param stripe              ID of the striped transfer
+ * @param offset              offset of the range
+ * @param length              length of the range
+ * @param msg_len             output parameter returns generated message length
+ *
+ * @return                    generated message, NOT terminated with NULL,
+ *                            must be free()d after usage, or NULL if the
+ *                            path or the stripe ID is too long
+ */
+char * message_v2_file_stripe_request( char * path, long long size, int flags, int codec, int mode, char * stripe, long long offset, long long length, unsigned long * msg_len ) {
+
+  return message_v2_stripe_request( path, size, flags, codec, mode, stripe, offset, length, msg_len );
+}
+
+/**
+ * Generates a V2 File Send request message that commits a striped
+ * transfer once all its ranges were sent, no content follows it
+ *
+ * @param path                filepath in destination
+ * @param size                size of the whole file
+ * @param flags               V2_FLAG_KEEP_ALIVE to keep the connection open
+ * @param stripe              ID of the striped transfer
+ * @param msg_len             output parameter returns generated message length
+ *
+ * @return                    generated message, NOT terminated with NULL,
+ *                            must be free()d after usage, or NULL if the
+ *                            path or the stripe ID is too long
+ */
+char * message_v2_file_stripe_commit_request( char * path, long long size, int flags, char * stripe, unsigned long * msg_len ) {
+
+  return message_v2_stripe_request( path, size, flags, 0, -1, stripe, 0, -1, msg_len );
+}
+
+/**
+ * Generates a V2 File Delete request message
+ *
+ * @param filename            name of the file to delete
+ * @param flags               V2_FLAG_KEEP_ALIVE to ask for the connection
+ *                            to be kept open after the operation
+ * @param msg_len             output parameter returns generated message length
+ *
+ * @return                    generated message, NOT terminated with NULL,
+ *                            must be free()d after usage, or NULL if the
+ *                            filename is too long
+ */
+char * message_v2_file_delete_request( char * filename, int flags, unsigned long * msg_len ) {
+
+  return message_v2_filename_request( FILE_DEL_B, filename, flags, 0, -1, 0, msg_len );
+}
+
+/**
+ * Generates a V2 ACK message
+ *
+ * @param codec             codec of the content that follows it, or 0 (gzip)
+ * @param offset            offset the content of a resumable transfer
+ *                          starts at, or -1 to leave it out
+ * @param flags             V2_FLAG_KEEP_ALIVE if the connection is kept open
+ * @param msg_len           output parameter returns generated message length
+ *
+ * @return                  generated message, NOT terminated with NULL,
+ *                          must be free()d after usage
+ */
+char * message_v2_ack ( int codec, long long offset, int flags, unsigned long * msg_len ) {
+
+  char params[( TLV_HEADER_LEN + 1 ) + ( TLV_HEADER_LEN + 8 )];
+  unsigned long params_len = 0;
+
+  message_v2_put_codec( params, &params_len, codec );
+  message_v2_put_offset( params, &params_len, offset );
+
+  return message_v2_build( ACK_B, flags, params, params_len, msg_len );
+}
+
+/**
+ * Generates a V2 response message for any of the operations
+ *
+ * @param type                binary value of the message code
+ * @param result_code         operation result code
+ * @param flags               message flags, V2_FLAG_CHUNKED when
+ *                            content frames follow the response
+ * @param msg_len             output parameter returns generated message length
+ *
+ * @return                    generated message, NOT terminated with NULL,
+ *                            must be free()d after usage
+ */
+char * message_v2_response( int type, int result_code, int flags, unsigned long * msg_len ) {
+
+  char params[TLV_HEADER_LEN + 4];
+  char result_value[4];
+  unsigned long params_len = 0;
+
+  PUT_UINT32( result_value, (unsigned long)(unsigned int)result_code );
+  message_v2_put_param( params, &params_len, TAG_RESULT, result_value, sizeof(result_value) );
+
+  return message_v2_build( type, flags, params, params_len, msg_len );
+}
+
+/**
+ * Returns the corresponding string for a given result code
+ *
+ * @param result_code       result code
+ * @param buffer            buffer for copying the string
+ *
+ * @return                  result string
+ */
+char * message_result_code_to_string(int result_code, char * result_string) {
+
+  sprintf(result_string, "%s", STR_RESULT_UNDEFINED);
+
+  switch (result_code) {
+
+    case RESULT_SUCCESS:
+
+      sprintf(result_string, "%s", STR_RESULT_SUCCESS);
+      break;
+
+    case RESULT_INVALID_REQUEST:
+
+      sprintf(result_string, "%s", STR_RESULT_INVALID_REQUEST);
+      break;
+
+    case RESULT_INVALID_RESPONSE:
+
+      sprintf(result_string, "%s", STR_RESULT_INVALID_RESPONSE);
+      break;
+
+    case RESULT_CONFIG_ERROR:
+
+      sprintf(result_string, "%s", STR_RESULT_CONFIG_ERROR);
+      break;
+
+    case RESULT_FILE_ACCESS_ERROR:
+    
+      sprintf(result_string, "%s", STR_RESULT_FILE_ACCESS_ERROR);
+      break;
+
+    case RESULT_FILE_NOT_FOUND:
+    
+      sprintf(result_string, "%s", STR_RESULT_FILE_NOT_FOUND);
+      break;
+
+    case RESULT_FILE_WRITE_ERROR:
+    
+      sprintf(result_string, "%s", STR_RESULT_FILE_WRITE_ERROR);
+      break;
+
+    case RESULT_FILE_READ_ERROR:
+
+      sprintf(result_string, "%s", STR_RESULT_FILE_READ_ERROR);
+      break;
+
+    case RESULT_FILE_COMPRESS_ERROR:
+    
+      sprintf(result_string, "%s", STR_RESULT_FILE_COMPRESS_ERROR);
+      break;
+
+    case RESULT_FILE_DECOMPRESS_ERROR:
+    
+      sprintf(result_string, "%s", STR_RESULT_FILE_DECOMPRESS_ERROR);
+      break;
+
+    case RESULT_FILE_ENCODE_ERROR:
+    
+      sprintf(result_string, "%s", STR_RESULT_FILE_ENCODE_ERROR);
+      break;
+
+    case RESULT_FILE_DECODE_ERROR:
+
+      sprintf(result_string, "%s", STR_RESULT_FILE_DECODE_ERROR);
+      break;
+
+    case RESULT_FILE_DELETE_ERROR:
+
+      sprintf(result_string, "%s", STR_RESULT_FILE_DELETE_ERROR);
+      break;
+
+    case RESULT_INVALID_DESTINATION_DIRECTORY:
+    
+      sprintf(result_string, "%s", STR_RESULT_INVALID_DESTINATION_DIRECTORY);
+      break;
+
+    case RESULT_COULD_NOT_CREATE_DESTINATION_DIRECTORY:
+
+      sprintf(result_string, "%s", STR_RESULT_COULD_NOT_CREATE_DESTINATION_DIRECTORY);
+      break;
+
+    case RESULT_SERVER_BUSY:
+
+      sprintf(result_string, "%s", STR_RESULT_SERVER_BUSY);
+      break;
+
+    case RESULT_VERSION_NOT_SUPPORTED:
+
+      sprintf(result_string, "%s", STR_RESULT_VERSION_NOT_SUPPORTED);
+      break;
+
+  }
+
+  return result_string;
+}
+
+/**
+ * Returns the corresponding result code from a result string
+ *
+ * @param                   result string
+ * @return                  result code
+ */
+int message_result_string_to_code(char * result_string) {
+
+  int code = RESULT_UNDEFINED;
+
+  if (strcmp(result_string, STR_RESULT_SUCCESS) == 0) {
+
+    code = RESULT_SUCCESS;
+  }
+  else if (strcmp(result_string, STR_RESULT_CONNECTION_ERROR) == 0) {
+
+    code = RESULT_CONNECTION_ERROR;
+  }
+  else if (strcmp(result_string, STR_RESULT_INVALID_REQUEST) == 0) {
+
+    code = RESULT_INVALID_REQUEST;
+  }
+  else if (strcmp(result_string, STR_RESULT_INVALID_RESPONSE) == 0) {
+
+    code = RESULT_INVALID_RESPONSE;
   }
   else if (strcmp(result_string, STR_RESULT_CONFIG_ERROR) == 0) {
 
@@ -714,6 +1844,14 @@ int message_result_string_to_code(char * result_string) {
 
     code = RESULT_COULD_NOT_CREATE_DESTINATION_DIRECTORY;
   }
+  else if (strcmp(result_string, STR_RESULT_SERVER_BUSY) == 0) {
+
+    code = RESULT_SERVER_BUSY;
+  }
+  else if (strcmp(result_string, STR_RESULT_VERSION_NOT_SUPPORTED) == 0) {
+
+    code = RESULT_VERSION_NOT_SUPPORTED;
+  }
   
   return code;
 }
\ No newline at end of file
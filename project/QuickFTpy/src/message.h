@@ -25,6 +25,10 @@ extern "C" {
 // Defines protocol version
 #define VERSION               "V1.0"
 
+// Defines version 2 of the protocol, with a binary header, parameters
+// and content, negotiated by the client with the version field
+#define VERSION_2             "V2.0"
+
 // Defines message codes for headers
 #define FILE_SEND             "FILE_SND"
 #define FILE_RECEIVE          "FILE_RCV"
@@ -56,24 +60,163 @@ extern "C" {
 #define PARAM_CONTENT   "=content:"
 #define PARAM_FILENAME  "=filename:"
 #define PARAM_RESULT    "=result:"
+#define PARAM_SIZE      "=size:"
+#define PARAM_CHUNKED   "=chunked:"
+
+// Defines the largest variable part that fits the header size field
+#define VAR_PART_MAXIMUM_LEN  0xFFFFFFFFUL
+
+// Defines the frame that ends a chunked content
+#define CHUNK_END             "00000000"
 
 // Defines message separator between fixed-part and variable-part
 #define MSG_SEPARATOR ":"
 
+//
+// Version 2 headers keep the length of the V1 header and the protocol name
+// and version fields, so that V1 peers reject them, followed by:
+//
+//   type         1 byte, binary value of the message code
+//   flags        1 byte
+//   request id   4 bytes, big endian, 0 outside of a pipeline
+//   reserved     7 bytes, zeroed
+//   params len   4 bytes, big endian
+//
+// Parameters are TLV fields made of a tag byte, the length of the value in
+// 2 bytes big endian and the value. Content is raw compressed data sent as
+// frames made of their length in 4 bytes big endian and their data, the last
+// frame being empty, or the file itself when it is sent uncompressed.
+//
+// The client asks for a codec with the codec parameter of its request, the
+// server answers with the one it uses in the File Receive response or in
+// the File Send ACK. Without it the content is gzip data.
+//
+// A client that sets the keep alive flag on its request asks for the
+// connection to stay open for its next request. The server repeats the flag
+// on the messages it answers with while it agrees to it, the last of them
+// telling whether the connection stays open once the exchange ends.
+//
+// A client that sets the pipelined flag sends its requests one after the
+// other without waiting for their answers, each with its own request ID.
+// The server sends no ACK for them, so File Send content follows its request
+// right away, and answers each request with its response tagged with the same
+// request ID as soon as it is done, in any order, the content of a File
+// Receive following its response. File Send and File Delete requests are
+// only performed once the requests before them were answered, so that they
+// never overtake a File Receive of the same file. The server sets the flag on
+// the messages it answers any V2 request with to tell the client it accepts
+// pipelines.
+//
+// A File Send request with a transfer parameter is resumable. The server
+// writes its content into a partial file named after the transfer and the
+// content hash parameter, which it keeps when the connection is lost, and
+// its ACK gives the offset up to which the file is already there, the client
+// sending the rest of the file from it. A File Receive request with an offset
+// parameter asks for the file from that offset, along with the content hash
+// of what the client has before it, the response repeating the offset the
+// content actually starts at, which is 0 when the file changed meanwhile.
+// Within a pipeline the offset of a File Send is always 0.
+//
+// A File Receive request with a length parameter asks for a byte range of the
+// file instead, starting at its offset parameter, or at 0 without one. A
+// negative offset counts from the end of the file and a negative length
+// reaches it. The range is clipped to the file and no hash is checked, the
+// response giving the offset the content starts at, and for an uncompressed
+// one its length with the size parameter.
+//
+// A File Send request with a stripe parameter carries one byte range of a
+// file sent over several connections at once, given by its offset and length
+// parameters, the size parameter being the one of the whole file. The server
+// writes each range at its offset into a file named after the stripe, which
+// only replaces the target once the client sends the same request without
+// content flags, offset or length to commit it after every range succeeded.
+// The server records the ranges written, and refuses the commit unless they
+// cover the whole file. The stripe is named after the content, so a client
+// sending the file again after a failure writes into the same file.
+//
+// A File Receive request with a block parameter asks for the signature of the
+// file instead of its content, the block size being chosen by the server when
+// it is 0. The response gives the block size it used and the length of the
+// signature that follows it uncompressed, made of the weak rolling checksum in
+// 4 bytes and the strong hash in 8 bytes, both big endian, of each whole block
+// of the file. A File Send request with a block parameter carries a delta
+// against the current file instead of the file, made of instructions that
+// copy runs of its blocks or insert literal data, along with the size and the
+// SHA-256 digest parameter of the new file the server rebuilds and checks
+// before it replaces the current one.
+//
+// A File Send request with a digest parameter gives the SHA-256 digest of
+// the file along with its size. A server with a content store that already
+// holds that content makes the file from it and sends its response in place
+// of the ACK, so the client sends no content at all, otherwise it goes on as
+// usual. A server without a store ignores the parameter.
+//
+#define V2_TYPE_OFFSET        15
+#define V2_FLAGS_OFFSET       16
+#define V2_REQUEST_ID_OFFSET  17
+#define V2_PARAMS_LEN_OFFSET  28
+
+// Defines binary value for ACK messages, only used by V2
+#define ACK_B         0x08
+
+// Defines V2 header flags
+#define V2_FLAG_CHUNKED       0x01    // content frames follow the parameters
+#define V2_FLAG_RAW           0x02    // the file follows uncompressed, its
+                                      // length given by the size parameter
+#define V2_FLAG_KEEP_ALIVE    0x04    // the connection is kept open for
+                                      // further requests once this one ends
+#define V2_FLAG_PIPELINED     0x08    // the request is part of a pipeline,
+                                      // the answer carries its request ID
+
+// Defines V2 parameter tags
+#define TAG_PATH              0x01
+#define TAG_FILENAME          0x02
+#define TAG_RESULT            0x03    // 4 bytes big endian, signed
+#define TAG_SIZE              0x04    // 8 bytes big endian
+#define TAG_MODE              0x05    // 1 byte, compression mode of the content
+#define TAG_CODEC             0x06    // 1 byte, codec of the content
+#define TAG_TRANSFER          0x07    // ID of a resumable transfer
+#define TAG_HASH              0x08    // 8 bytes big endian, content hash
+#define TAG_OFFSET            0x09    // 8 bytes big endian, offset the content starts at
+#define TAG_LENGTH            0x0A    // 8 bytes big endian, signed, length of a byte range
+#define TAG_STRIPE            0x0B    // ID of a striped transfer
+#define TAG_BLOCK             0x0C    // 4 bytes big endian, block size of a signature or a delta
+#define TAG_DIGEST            0x0D    // SHA-256 digest of the content
+
+// Length of the digest parameter
+#define V2_DIGEST_LEN         32
+
+// Defines the longest ID of a resumable transfer
+#define TRANSFER_ID_MAXIMUM_LEN 64
+
+// Defines length of fields of V2 messages
+#define TLV_HEADER_LEN        3
+#define TLV_VALUE_MAXIMUM_LEN 0xFFFF
+#define V2_FRAME_LEN_SIZE     4
+
+// Reads and writes big endian integers of V2 messages
+#define GET_UINT16(p)   ( ( (unsigned int)(unsigned char)(p)[0] << 8 ) | (unsigned char)(p)[1] )
+#define GET_UINT32(p)   ( ( (unsigned long)GET_UINT16(p) << 16 ) | GET_UINT16(&(p)[2]) )
+#define PUT_UINT16(p,v) do { (p)[0] = (char)( (v) >> 8 ); (p)[1] = (char)(v); } while(0)
+#define PUT_UINT32(p,v) do { PUT_UINT16(p, (v) >> 16); PUT_UINT16(&(p)[2], (v) & 0xFFFF); } while(0)
+
 // Macro for accesing function
 #define IS_VALID_HEADER       message_is_valid_header
+#define IS_VALID_HEADER_V2    message_is_valid_header_v2
+#define HEADER_VERSION        message_header_version
 
 /**
  * Generates a File Receive request message
  *
  * @param len                 filename length
  * @param filename            message content
+ * @param chunked             TRUE to ask for a chunked response
  * @param msg_len             output parameter returns generated message length
  *
  * @return                    generated message, NOT terminated with NULL,
  *                            must be free()d after usage
  */
-char * message_file_receive_request( int len, char * filename, unsigned long * msg_len ) ;
+char * message_file_receive_request( int len, char * filename, int chunked, unsigned long * msg_len ) ;
 
 /**
  * Generates a File Receive response message
@@ -88,6 +231,25 @@ char * message_file_receive_request( int len, char * filename, unsigned long * m
  */
 char * message_file_receive_response( int result_code, unsigned long len, char * content, unsigned long * msg_len );
 
+/**
+ * Generates the header and parameters of a successful File Receive
+ * response, the content is sent separately right after them.
+ *
+ * If the response is not chunked the header accounts for 'len' bytes of
+ * content. Otherwise it only covers the parameters, and the content follows
+ * as frames made of its length in SIZE_LEN hex digits and its data, the
+ * last frame being CHUNK_END.
+ *
+ * @param len                 content length, ignored when chunked
+ * @param chunked             TRUE for a chunked content
+ * @param msg_len             output parameter returns generated message length
+ *
+ * @return                    generated message, NOT terminated with NULL,
+ *                            must be free()d after usage, or NULL if the
+ *                            content does not fit a single message
+ */
+char * message_file_receive_response_prefix( unsigned long long len, int chunked, unsigned long * msg_len );
+
 /**
  * Generates a File Send request message
  * 
@@ -101,6 +263,26 @@ char * message_file_receive_response( int result_code, unsigned long len, char *
  */
 char * message_file_send_request( char * path, unsigned long len, char * content, unsigned long * msg_len );
 
+/**
+ * Generates the header and parameters of a File Send request message,
+ * the content is sent separately right after them.
+ *
+ * If the request is not chunked the header accounts for 'len' bytes of
+ * content. Otherwise it only covers the parameters, and the content follows
+ * as the frames of a chunked File Receive response do.
+ * 
+ * @param path                filepath in destination
+ * @param len                 content length, ignored when chunked
+ * @param size                original file size
+ * @param chunked             TRUE for a chunked content
+ * @param msg_len             output parameter returns generated message length
+ *
+ * @return                    generated message, NOT terminated with NULL,
+ *                            must be free()d after usage, or NULL if the
+ *                            content does not fit a single message
+ */
+char * message_file_send_request_prefix( char * path, unsigned long long len, long long size, int chunked, unsigned long * msg_len );
+
 /**
  * Generates a File Send response message
  *
@@ -149,6 +331,373 @@ char * message_file_delete_response( int result_code, unsigned long * msg_len );
  */
 int message_is_valid_header ( char * header, long * var_part_size, unsigned long type );
 
+/**
+ * Gets the version of the protocol a header belongs to
+ *
+ * @param header            header to evaluate, HEADER_LEN bytes
+ *
+ * @return                  1 or 2, or 0 if the header is not a valid one
+ */
+int message_header_version ( char * header );
+
+/**
+ * Evaluates if a V2 header is valid, and if it is returns
+ * the length of the parameters and the flags of the message
+ * 
+ * @param header            header to evaluate
+ * @param params_len        returns the length of the parameters
+ *                          if the header is valid, otherwise returns 0.
+ * @param flags             returns the flags of the message
+ * @param type              defines a value or binary addition of values for
+ *                          message codes, ACK_B included
+ *   
+ * @return                  message code if header is valid, otherwise FALSE
+ */
+int message_is_valid_header_v2 ( char * header, unsigned long * params_len, int * flags, unsigned long type );
+
+/**
+ * Generates a V2 header
+ *
+ * @param header            buffer of HEADER_LEN bytes for the header
+ * @param type              binary value of the message code
+ * @param flags             message flags
+ * @param params_len        length of the parameters that follow
+ */
+void message_v2_header ( char * header, int type, int flags, unsigned long params_len );
+
+/**
+ * Sets the request ID of a V2 message
+ *
+ * @param header            header of the message
+ * @param request_id        request ID
+ */
+void message_v2_set_request_id ( char * header, unsigned long request_id );
+
+/**
+ * Gets the request ID of a V2 message
+ *
+ * @param header            header of the message
+ *
+ * @return                  request ID, 0 outside of a pipeline
+ */
+unsigned long message_v2_get_request_id ( const char * header );
+
+/**
+ * Finds a parameter of a V2 message
+ *
+ * @param params            parameters of the message
+ * @param params_len        length of the parameters
+ * @param tag               tag of the parameter
+ * @param value             returns a pointer to the value within the parameters
+ *
+ * @return                  length of the value, or -1 if the parameter
+ *                          is not found or the parameters are malformed
+ */
+int message_v2_get_param ( const char * params, unsigned long params_len, int tag, const char ** value );
+
+/**
+ * Gets the size parameter of a V2 message
+ *
+ * @param params            parameters of the message
+ * @param params_len        length of the parameters
+ * @param size              returns the size
+ *
+ * @return                  TRUE, or FALSE if the parameter is not found
+ */
+int message_v2_get_size ( const char * params, unsigned long params_len, long long * size );
+
+/**
+ * Gets the offset parameter of a V2 message
+ *
+ * @param params            parameters of the message
+ * @param params_len        length of the parameters
+ * @param offset            returns the offset
+ *
+ * @return                  TRUE, or FALSE if the parameter is not found
+ */
+int message_v2_get_offset ( const char * params, unsigned long params_len, long long * offset );
+
+/**
+ * Gets the byte range length parameter of a V2 message
+ *
+ * @param params            parameters of the message
+ * @param params_len        length of the parameters
+ * @param length            returns the length
+ *
+ * @return                  TRUE, or FALSE if the parameter is not found
+ */
+int message_v2_get_length ( const char * params, unsigned long params_len, long long * length );
+
+/**
+ * Gets the content hash parameter of a V2 message
+ *
+ * @param params            parameters of the message
+ * @param params_len        length of the parameters
+ * @param hash              returns the hash
+ *
+ * @return                  TRUE, or FALSE if the parameter is not found
+ */
+int message_v2_get_hash ( const char * params, unsigned long params_len, unsigned long long * hash );
+
+/**
+ * Gets the content digest parameter of a V2 message
+ *
+ * @param params            parameters of the message
+ * @param params_len        length of the parameters
+ *
+ * @return                  digest of V2_DIGEST_LEN bytes within the
+ *                          parameters, or NULL if the parameter is not found
+ */
+const unsigned char * message_v2_get_digest ( const char * params, unsigned long params_len );
+
+/**
+ * Gets the block size parameter of a V2 message
+ *
+ * @param params            parameters of the message
+ * @param params_len        length of the parameters
+ *
+ * @return                  block size, or -1 if the parameter is not found
+ */
+long message_v2_get_block ( const char * params, unsigned long params_len );
+
+/**
+ * Gets the compression mode parameter of a V2 message
+ *
+ * @param params            parameters of the message
+ * @param params_len        length of the parameters
+ *
+ * @return                  compression mode, or -1 if the parameter is not found
+ */
+int message_v2_get_mode ( const char * params, unsigned long params_len );
+
+/**
+ * Gets the codec parameter of a V2 message
+ *
+ * @param params            parameters of the message
+ * @param params_len        length of the parameters
+ *
+ * @return                  codec, or 0 (gzip) if the parameter is not found
+ */
+int message_v2_get_codec ( const char * params, unsigned long params_len );
+
+/**
+ * Generates a V2 ACK message
+ *
+ * @param codec             codec of the content that follows it, or 0 (gzip)
+ * @param offset            offset the content of a resumable transfer
+ *                          starts at, or -1 to leave it out
+ * @param flags             V2_FLAG_KEEP_ALIVE if the connection is kept open
+ * @param msg_len           output parameter returns generated message length
+ *
+ * @return                  generated message, NOT terminated with NULL,
+ *                          must be free()d after usage
+ */
+char * message_v2_ack ( int codec, long long offset, int flags, unsigned long * msg_len );
+
+/**
+ * Generates a V2 File Receive request message
+ *
+ * @param filename            name of the file to receive
+ * @param flags               V2_FLAG_RAW to ask for the file uncompressed,
+ *                            V2_FLAG_KEEP_ALIVE to keep the connection open
+ * @param codec               codec asked for the content, or 0 (gzip)
+ * @param offset              offset to receive the file from, or -1
+ *                            to leave it out
+ * @param hash                hash of the content the client already
+ *                            has before the offset
+ * @param msg_len             output parameter returns generated message length
+ *
+ * @return                    generated message, NOT terminated with NULL,
+ *                            must be free()d after usage, or NULL if the
+ *                            filename is too long
+ */
+char * message_v2_file_receive_request( char * filename, int flags, int codec, long long offset, unsigned long long hash, unsigned long * msg_len );
+
+/**
+ * Generates a V2 File Receive request message for a byte range of a file
+ *
+ * @param filename            name of the file to receive
+ * @param flags               V2_FLAG_RAW to ask for the range uncompressed,
+ *                            V2_FLAG_KEEP_ALIVE to keep the connection open
+ * @param codec               codec asked for the content, or 0 (gzip)
+ * @param offset              offset the range starts at, counted from the
+ *                            end of the file when negative
+ * @param length              length of the range, or -1 up to the end
+ * @param msg_len             output parameter returns generated message length
+ *
+ * @return                    generated message, NOT terminated with NULL,
+ *                            must be free()d after usage, or NULL if the
+ *                            filename is too long
+ */
+char * message_v2_file_range_request( char * filename, int flags, int codec, long long offset, long long length, unsigned long * msg_len );
+
+/**
+ * Generates the response to a V2 File Receive request when the file
+ * is sent uncompressed, the file is sent right after it
+ *
+ * @param size                length of the content that follows
+ * @param offset              offset the content starts at, or -1
+ *                            to leave it out
+ * @param flags               V2_FLAG_KEEP_ALIVE if the connection is kept open
+ * @param msg_len             output parameter returns generated message length
+ *
+ * @return                    generated message, NOT terminated with NULL,
+ *                            must be free()d after usage
+ */
+char * message_v2_file_receive_response_raw( long long size, long long offset, int flags, unsigned long * msg_len );
+
+/**
+ * Generates a V2 File Receive request message for the signature of a file
+ *
+ * @param filename            name of the file
+ * @param flags               V2_FLAG_KEEP_ALIVE to keep the connection open
+ * @param block_size          block size asked for, or 0 for the server to choose it
+ * @param msg_len             output parameter returns generated message length
+ *
+ * @return                    generated message, NOT terminated with NULL,
+ *                            must be free()d after usage, or NULL if the
+ *                            filename is too long
+ */
+char * message_v2_file_signature_request( char * filename, int flags, long block_size, unsigned long * msg_len );
+
+/**
+ * Generates the response to a V2 File Receive request for the signature
+ * of a file, the signature is sent uncompressed right after it
+ *
+ * @param size                length of the signature
+ * @param block_size          block size of the signature
+ * @param flags               V2_FLAG_KEEP_ALIVE if the connection is kept open
+ * @param msg_len             output parameter returns generated message length
+ *
+ * @return                    generated message, NOT terminated with NULL,
+ *                            must be free()d after usage
+ */
+char * message_v2_file_signature_response( long long size, long block_size, int flags, unsigned long * msg_len );
+
+/**
+ * Generates the response to a V2 File Receive request when the file
+ * is packed, the content frames are sent right after it
+ *
+ * @param codec               codec of the content
+ * @param mode                compression mode of the content
+ * @param offset              offset the content starts at, or -1
+ *                            to leave it out
+ * @param flags               V2_FLAG_KEEP_ALIVE if the connection is kept open
+ * @param msg_len             output parameter returns generated message length
+ *
+ * @return                    generated message, NOT terminated with NULL,
+ *                            must be free()d after usage
+ */
+char * message_v2_file_receive_response_packed( int codec, int mode, long long offset, int flags, unsigned long * msg_len );
+
+/**
+ * Generates a V2 File Send request message, the content is
+ * sent once the server acknowledges the request
+ *
+ * @param path                filepath in destination
+ * @param size                original file size
+ * @param flags               V2_FLAG_CHUNKED to send the content as frames,
+ *                            or V2_FLAG_RAW to send the file uncompressed,
+ *                            V2_FLAG_KEEP_ALIVE to keep the connection open
+ * @param codec               codec asked for the content frames, or 0 (gzip)
+ * @param mode                compression mode of the content frames, or -1
+ * @param transfer            ID of a resumable transfer, or NULL
+ * @param hash                hash of the content of a resumable transfer
+ * @param digest              SHA-256 digest of the content, V2_DIGEST_LEN
+ *                            bytes, or NULL
+ * @param msg_len             output parameter returns generated message length
+ *
+ * @return                    generated message, NOT terminated with NULL,
+ *                            must be free()d after usage, or NULL if the
+ *                            path or the transfer ID is too long
+ */
+char * message_v2_file_send_request( char * path, long long size, int flags, int codec, int mode, char * transfer, unsigned long long hash, const unsigned char * digest, unsigned long * msg_len );
+
+/**
+ * Generates a V2 File Send request message whose content frames are a delta
+ * against the current file, sent once the server acknowledged the request
+ *
+ * @param path                filepath in destination
+ * @param size                size of the new file
+ * @param flags               V2_FLAG_KEEP_ALIVE to keep the connection open
+ * @param codec               codec asked for the content frames, or 0 (gzip)
+ * @param mode                compression mode of the content frames
+ * @param block_size          block size of the signature the delta refers to
+ * @param digest              SHA-256 digest of the new file, V2_DIGEST_LEN bytes
+ * @param msg_len             output parameter returns generated message length
+ *
+ * @return                    generated message, NOT terminated with NULL,
+ *                            must be free()d after usage, or NULL if the
+ *                            path is too long
+ */
+char * message_v2_file_delta_request( char * path, long long size, int flags, int codec, int mode, long block_size, const unsigned char * digest, unsigned long * msg_len );
+
+/**
+ * Generates a V2 File Send request message for a byte range of a striped
+ * transfer, the content is sent once the server acknowledged it
+ *
+ * @param path                filepath in destination
+ * @param size                size of the whole file
+ * @param flags               V2_FLAG_CHUNKED for content frames, V2_FLAG_RAW
+ *                            for the range uncompressed, V2_FLAG_KEEP_ALIVE
+ *                            to keep the connection open
+ * @param codec               codec asked for the content frames, or 0 (gzip)
+ * @param mode                compression mode of the content frames, or -1
+ * @param stripe              ID of the striped transfer
+ * @param offset              offset of the range
+ * @param length              length of the range
+ * @param msg_len             output parameter returns generated message length
+ *
+ * @return                    generated message, NOT terminated with NULL,
+ *                            must be free()d after usage, or NULL if the
+ *                            path or the stripe ID is too long
+ */
+char * message_v2_file_stripe_request( char * path, long long size, int flags, int codec, int mode, char * stripe, long long offset, long long length, unsigned long * msg_len );
+
+/**
+ * Generates a V2 File Send request message that commits a striped
+ * transfer once all its ranges were sent, no content follows it
+ *
+ * @param path                filepath in destination
+ * @param size                size of the whole file
+ * @param flags               V2_FLAG_KEEP_ALIVE to keep the connection open
+ * @param stripe              ID of the striped transfer
+ * @param msg_len             output parameter returns generated message length
+ *
+ * @return                    generated message, NOT terminated with NULL,
+ *                            must be free()d after usage, or NULL if the
+ *                            path or the stripe ID is too long
+ */
+char * message_v2_file_stripe_commit_request( char * path, long long size, int flags, char * stripe, unsigned long * msg_len );
+
+/**
+ * Generates a V2 File Delete request message
+ *
+ * @param filename            name of the file to delete
+ * @param flags               V2_FLAG_KEEP_ALIVE to ask for the connection
+ *                            to be kept open after the operation
+ * @param msg_len             output parameter returns generated message length
+ *
+ * @return                    generated message, NOT terminated with NULL,
+ *                            must be free()d after usage, or NULL if the
+ *                            filename is too long
+ */
+char * message_v2_file_delete_request( char * filename, int flags, unsigned long * msg_len );
+
+/**
+ * Generates a V2 response message for any of the operations
+ *
+ * @param type                binary value of the message code
+ * @param result_code         operation result code
+ * @param flags               message flags, V2_FLAG_CHUNKED when
+ *                            content frames follow the response
+ * @param msg_len             output parameter returns generated message length
+ *
+ * @return                    generated message, NOT terminated with NULL,
+ *                            must be free()d after usage
+ */
+char * message_v2_response( int type, int result_code, int flags, unsigned long * msg_len );
+
 /**
  * Returns the corresponding string for a given result code
  *
@@ -206,17 +206,11 @@ int mutex_is_locked(MUTEX_T* mutex) {
  */
 int mutex_condition_signal(MUTEX_T* mutex) {
 
-  char buffer[_BUFFER_SIZE_S];
-  pthread_t id = pthread_self();
-
   // If mutex was properly created
   if ( mutex->created ) {
 
-    sprintf(buffer, "the thread condition (%ld) is signaled by the thread (%ld)", (long int)mutex->owner, (long int)id);
-    LOGGER(__FUNCTION__, buffer);
-
-    // Signals condition
-    pthread_cond_init(mutex->condition, NULL);
+    // Wakes one of the threads waiting on the condition
+    pthread_cond_signal(mutex->condition);
 
     return TRUE;
 
@@ -254,12 +248,37 @@ int mutex_condition_wait(MUTEX_T* mutex) {
 
     }
 
-    sprintf(buffer, "thread condition (%ld) set on wait by thread (%ld)", (long int)mutex->owner, (long int)id);
-    LOGGER(__FUNCTION__, buffer);
+    // The lock is released while waiting and taken back before
+    // returning, the owner is cleared for the threads that take it
+    mutex->owner = 0;
+    pthread_cond_wait(mutex->condition, mutex->mutex);
+    mutex->owner = id;
+
+    return TRUE;
+
+  } else {
+
+    LOGGER(__FUNCTION__, "mutex has not been created");
+    return FALSE;
+
+  }
+
+}
+
+/**
+ * Signals the condition on a mutex to every thread waiting on it
+ *
+ * @param mutex     mutex data structure
+ *
+ * @return          TRUE or FALSE
+ */
+int mutex_condition_broadcast(MUTEX_T* mutex) {
+
+  // If mutex was properly created
+  if ( mutex->created ) {
 
-    mutex_unlock(mutex);
-    pthread_cond_wait(mutex->condition, mutex->mutex);    
-    mutex_lock(mutex);
+    // Wakes all the threads waiting on the condition
+    pthread_cond_broadcast(mutex->condition);
 
     return TRUE;
 
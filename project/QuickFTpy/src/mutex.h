@@ -33,6 +33,7 @@ extern "C" {
   #define MUTEX_IS_LOCKED(t)    mutex_is_locked(t)
   #define MUTEX_COND_SIGNAL(t)  if(!mutex_condition_signal(t))LOGGER("MUTEX_DBG","condition signal fail");
   #define MUTEX_COND_WAIT(t)    if(!mutex_condition_wait(t))LOGGER("MUTEX_DBG","condition wait fail");
+  #define MUTEX_COND_BROADCAST(t) if(!mutex_condition_broadcast(t))LOGGER("MUTEX_DBG","condition broadcast fail");
 #else
   #define MUTEX_CREATE(t)       mutex_create(t);
   #define MUTEX_DESTROY(t)      mutex_destroy(t);
@@ -41,6 +42,7 @@ extern "C" {
   #define MUTEX_IS_LOCKED(t)    mutex_is_locked(t)
   #define MUTEX_COND_SIGNAL(t)  mutex_condition_signal(t);
   #define MUTEX_COND_WAIT(t)    mutex_condition_wait(t);
+  #define MUTEX_COND_BROADCAST(t) mutex_condition_broadcast(t);
 #endif
 
 //
@@ -118,6 +120,15 @@ int mutex_condition_signal(MUTEX_T* mutex);
  */
 int mutex_condition_wait(MUTEX_T* mutex);
 
+/**
+ * Signals the condition on a mutex to every thread waiting on it
+ *
+ * @param mutex     mutex data structure
+ *
+ * @return          TRUE or FALSE
+ */
+int mutex_condition_broadcast(MUTEX_T* mutex);
+
 #ifdef __cplusplus
 }
 #endif
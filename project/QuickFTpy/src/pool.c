@@ -0,0 +1,266 @@
+/*
+ * pool.c
+ *
+ * $Id: $
+ * $HeadURL: $
+ * $LastChangedRevision: $
+ * $LastChangedDate: $
+ * $LastChangedBy: $
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "pool.h"
+#include "logger.h"
+#include "time.h"
+
+/**
+ * Worker loop, takes tasks from the queue until
+ * the pool is stopped and the queue is empty
+ *
+ * @param pool_arg        pool the worker belongs to
+ */
+static void * pool_worker_function( void * pool_arg ) {
+
+  POOL_T * pool = (POOL_T *) pool_arg;
+  POOL_TASK_T * task;
+  unsigned long long waited;
+
+  MUTEX_LOCK(pool->mutex);
+
+  while ( TRUE ) {
+
+    while ( pool->first == NULL && pool->keep_going == TRUE ) {
+      MUTEX_COND_WAIT(pool->mutex);
+    }
+
+    // Pending tasks are still run after the pool is stopped
+    // so that they can release their resources
+    task = pool->first;
+    if ( task == NULL ) {
+      break;
+    }
+
+    pool->first = task->next;
+    if ( pool->first == NULL ) {
+      pool->last = NULL;
+    }
+
+    waited = time_microseconds() - task->queued_at;
+
+    pool->stats.queue_depth--;
+    pool->stats.busy_workers++;
+    pool->stats.total_wait_usec += waited;
+    if ( waited > pool->stats.max_wait_usec ) {
+      pool->stats.max_wait_usec = waited;
+    }
+
+    MUTEX_UNLOCK(pool->mutex);
+
+    task->function(task->arg);
+    free(task);
+
+    MUTEX_LOCK(pool->mutex);
+
+    pool->stats.busy_workers--;
+    pool->stats.tasks_completed++;
+  }
+
+  MUTEX_UNLOCK(pool->mutex);
+
+  return NULL;
+}
+
+/**
+ * Creates a pool and starts its workers
+ *
+ * @param size            number of worker threads
+ *
+ * @return                new pool, or NULL on error
+ */
+POOL_T * pool_create( int size ) {
+
+  POOL_T * pool;
+  int iter;
+
+  if ( size <= 0 ) {
+    size = POOL_DEFAULT_SIZE;
+  }
+  if ( size > POOL_MAX_SIZE ) {
+    size = POOL_MAX_SIZE;
+  }
+
+  pool = (POOL_T *)malloc(sizeof(POOL_T));
+  memset(pool, 0x00, sizeof(POOL_T));
+
+  pool->workers = (thread_t *)malloc(sizeof(thread_t) * size);
+  pool->keep_going = TRUE;
+
+  pool->mutex = (MUTEX_T *)malloc(sizeof(MUTEX_T));
+  memset(pool->mutex, 0x00, sizeof(MUTEX_T));
+  MUTEX_CREATE(&pool->mutex);
+
+  for (iter = 0; iter < size; iter++) {
+
+    thread_t * worker = &pool->workers[iter];
+
+    if ( THREAD_CREATE_EX(&worker, &pool_worker_function, (void *)pool, POOL_STACK_SIZE) != 0 ) {
+
+      LOGGER(__FUNCTION__, "ERROR: could not create worker thread.");
+      break;
+    }
+
+    pool->size++;
+  }
+
+  pool->stats.workers = pool->size;
+
+  if ( pool->size == 0 ) {
+
+    pool_destroy(&pool);
+    return NULL;
+  }
+
+  return pool;
+}
+
+/**
+ * Stops the pool once its queue is drained, waits for
+ * the workers to end and frees the pool
+ *
+ * @param pool            pool to destroy
+ *
+ * @return                TRUE or FALSE
+ */
+int pool_destroy( POOL_T ** pool ) {
+
+  int iter;
+
+  if ( pool == NULL || *pool == NULL ) {
+    return FALSE;
+  }
+
+  MUTEX_LOCK((*pool)->mutex);
+  (*pool)->keep_going = FALSE;
+  MUTEX_COND_BROADCAST((*pool)->mutex);
+  MUTEX_UNLOCK((*pool)->mutex);
+
+  for (iter = 0; iter < (*pool)->size; iter++) {
+
+    THREAD_JOIN(&(*pool)->workers[iter], FALSE);
+  }
+
+  MUTEX_DESTROY(&(*pool)->mutex);
+  free((*pool)->mutex);
+
+  free((*pool)->workers);
+  free(*pool);
+  *pool = NULL;
+
+  return TRUE;
+}
+
+/**
+ * Queues a task
+ *
+ * @param pool            pool that runs the task
+ * @param function        function to run
+ * @param arg             argument for the function
+ * @param idle_only       TRUE to only queue it if a worker is free to run it right away
+ *
+ * @return                TRUE or FALSE
+ */
+static int pool_enqueue( POOL_T * pool, POOL_FUNCTION_T function, void * arg, int idle_only ) {
+
+  POOL_TASK_T * task;
+
+  if ( pool == NULL || function == NULL ) {
+    return FALSE;
+  }
+
+  task = (POOL_TASK_T *)malloc(sizeof(POOL_TASK_T));
+  task->function = function;
+  task->arg = arg;
+  task->next = NULL;
+  task->queued_at = time_microseconds();
+
+  MUTEX_LOCK(pool->mutex);
+
+  // Every queued task already has a free worker waiting for it
+  // when the number of them does not reach the idle workers
+  if ( pool->keep_going == FALSE ||
+       ( idle_only && pool->stats.busy_workers + pool->stats.queue_depth >= pool->size ) ) {
+
+    MUTEX_UNLOCK(pool->mutex);
+    free(task);
+    return FALSE;
+  }
+
+  if ( pool->last != NULL ) {
+    pool->last->next = task;
+  }
+  else {
+    pool->first = task;
+  }
+  pool->last = task;
+
+  pool->stats.queue_depth++;
+  if ( pool->stats.queue_depth > pool->stats.max_queue_depth ) {
+    pool->stats.max_queue_depth = pool->stats.queue_depth;
+  }
+
+  MUTEX_COND_SIGNAL(pool->mutex);
+  MUTEX_UNLOCK(pool->mutex);
+
+  return TRUE;
+}
+
+/**
+ * Queues a task to be run by the first available worker
+ *
+ * @param pool            pool that runs the task
+ * @param function        function to run
+ * @param arg             argument for the function
+ *
+ * @return                TRUE or FALSE
+ */
+int pool_submit( POOL_T * pool, POOL_FUNCTION_T function, void * arg ) {
+
+  return pool_enqueue(pool, function, arg, FALSE);
+}
+
+/**
+ * Queues a task only if a worker is free to run it right away, so that
+ * a task that waits for it never waits behind busy workers
+ *
+ * @param pool            pool that runs the task
+ * @param function        function to run
+ * @param arg             argument for the function
+ *
+ * @return                TRUE, or FALSE if every worker is busy
+ */
+int pool_submit_idle( POOL_T * pool, POOL_FUNCTION_T function, void * arg ) {
+
+  return pool_enqueue(pool, function, arg, TRUE);
+}
+
+/**
+ * Copies the pool's current counters
+ *
+ * @param pool            pool to inspect
+ * @param stats           structure that receives the counters
+ */
+void pool_get_stats( POOL_T * pool, POOL_STATS_T * stats ) {
+
+  if ( pool == NULL ) {
+
+    memset(stats, 0x00, sizeof(POOL_STATS_T));
+    return;
+  }
+
+  MUTEX_LOCK(pool->mutex);
+  memcpy(stats, &pool->stats, sizeof(POOL_STATS_T));
+  MUTEX_UNLOCK(pool->mutex);
+}
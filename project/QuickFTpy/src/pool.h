@@ -0,0 +1,137 @@
+/*
+ * pool.h
+ *
+ * $Id: $
+ * $HeadURL: $
+ * $LastChangedRevision: $
+ * $LastChangedDate: $
+ * $LastChangedBy: $
+ *
+ */
+
+#ifndef POOL_H
+#define POOL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "macros.h"
+#include "mutex.h"
+#include "thread.h"
+
+//
+// Macros
+//
+#define POOL_CREATE               pool_create
+#define POOL_DESTROY              pool_destroy
+#define POOL_SUBMIT               pool_submit
+#define POOL_SUBMIT_IDLE          pool_submit_idle
+#define POOL_STATS                pool_get_stats
+
+#define POOL_DEFAULT_SIZE         32
+#define POOL_MAX_SIZE             512
+#define POOL_STACK_SIZE           (512 * 1024)
+
+// Function executed by a worker for each queued task
+typedef void (*POOL_FUNCTION_T)( void * arg );
+
+// Queued unit of work
+typedef struct _pool_task_t {
+
+  POOL_FUNCTION_T function;
+  void * arg;
+  unsigned long long queued_at;
+
+  struct _pool_task_t * next;
+
+} POOL_TASK_T;
+
+// Snapshot of the pool's counters
+typedef struct _pool_stats_t {
+
+  int workers;
+  int busy_workers;
+  int queue_depth;
+  int max_queue_depth;
+
+  unsigned long long tasks_completed;
+  unsigned long long total_wait_usec;
+  unsigned long long max_wait_usec;
+
+} POOL_STATS_T;
+
+// Fixed-size pool of long-lived worker threads
+// fed from a FIFO work queue
+typedef struct _pool_t {
+
+  int size;
+  int keep_going;
+  thread_t * workers;
+
+  // Guards the queue and the counters, its condition
+  // wakes the workers when a task is queued
+  MUTEX_T * mutex;
+
+  POOL_TASK_T * first;
+  POOL_TASK_T * last;
+
+  POOL_STATS_T stats;
+
+} POOL_T;
+
+/**
+ * Creates a pool and starts its workers
+ *
+ * @param size            number of worker threads
+ *
+ * @return                new pool, or NULL on error
+ */
+POOL_T * pool_create( int size );
+
+/**
+ * Stops the pool once its queue is drained, waits for
+ * the workers to end and frees the pool
+ *
+ * @param pool            pool to destroy
+ *
+ * @return                TRUE or FALSE
+ */
+int pool_destroy( POOL_T ** pool );
+
+/**
+ * Queues a task to be run by the first available worker
+ *
+ * @param pool            pool that runs the task
+ * @param function        function to run
+ * @param arg             argument for the function
+ *
+ * @return                TRUE or FALSE
+ */
+int pool_submit( POOL_T * pool, POOL_FUNCTION_T function, void * arg );
+
+/**
+ * Queues a task only if a worker is free to run it right away, so that
+ * a task that waits for it never waits behind busy workers
+ *
+ * @param pool            pool that runs the task
+ * @param function        function to run
+ * @param arg             argument for the function
+ *
+ * @return                TRUE, or FALSE if every worker is busy
+ */
+int pool_submit_idle( POOL_T * pool, POOL_FUNCTION_T function, void * arg );
+
+/**
+ * Copies the pool's current counters
+ *
+ * @param pool            pool to inspect
+ * @param stats           structure that receives the counters
+ */
+void pool_get_stats( POOL_T * pool, POOL_STATS_T * stats );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // POOL_H
@@ -10,8 +10,16 @@
  */
 
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE 1
+#endif
+
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stddef.h>
+#include <unistd.h>
 
 #include "process.h"
 #include "message.h"
@@ -24,857 +32,3896 @@
 #include "socket.h"
 #include "time.h"
 #include "file.h"
+#include "pool.h"
+#include "delta.h"
+#include "store.h"
+#include "cache.h"
 
 static PROCESS_T processes[MAX_PROCESSES];
 static int abort_processes;
+static POOL_T * workers = NULL;
+
+// Stack of free slots, the low half holds the index of the top
+// slot plus one (0 when empty) and the high half a tag that changes
+// on every update so that a stale compare-and-swap always fails
+static volatile unsigned long long free_slots;
+
+// Connections waiting for a free slot when the policy is OVERFLOW_QUEUE
+static SOCKET_T * pending[MAX_PROCESSES];
+static int pending_first;
+static volatile int pending_count;
+static MUTEX_T * pending_mutex = NULL;
+
+// Guards the connections of the slots, so that process_deinit
+// never reaches one that its worker is closing
+static MUTEX_T * slots_mutex = NULL;
+
+static int overflow_policy;
+static int keep_alive_enabled;
+static PROCESS_STATS_T counters;
 
 /**
  * @NOTE:
  *   the functions on this unit are exclusively used by the server, with
- *   the sole exception of the function 'process_outgoing_message' which
- *   is also used by the client.
+ *   the exception of the function 'process_outgoing_message' and the
+ *   functions that follow it, which send and receive file content and
+ *   are also used by the client.
  *   For the rest of the operations, client implements its own functions
  *   located on the 'client.c' unit.
  */
 
 /**
- * Initializes processes structures for threads
+ * Takes a slot from the free stack
+ *
+ * @return                        slot index, or -1 if the table is full
  */
-void process_init() {
+static int process_slot_acquire() {
 
-  memset(processes, 0x00, ( sizeof(PROCESS_T) * MAX_PROCESSES ) );
-  abort_processes = FALSE;
+  unsigned long long old_head, new_head;
+  int index;
+
+  do {
+
+    old_head = free_slots;
+    index = (int)(old_head & 0xFFFFFFFFULL) - 1;
+    if ( index < 0 ) {
+      return -1;
+    }
 
+    new_head = ( ( ( old_head >> 32 ) + 1 ) << 32 ) | (unsigned int)( processes[index].next_free + 1 );
+
+  } while ( ! ATOMIC_CAS(&free_slots, old_head, new_head) );
+
+  ATOMIC_ADD(&counters.active_requests, 1);
+  return index;
 }
 
 /**
- * Finalizes processes structures for threads
+ * Returns a slot to the free stack
+ *
+ * @param index                   slot index
  */
-void process_deinit() {
+static void process_slot_release( int index ) {
 
-  int iter;
-  abort_processes = TRUE;
-  
-  for (iter = 0; iter < MAX_PROCESSES; iter++) {
-   
-    if (processes[iter].is_active == TRUE) {
+  unsigned long long old_head, new_head;
 
-      SOCKET_SHUTDOWN(&(processes[iter].proc_data->connection));
-            
-      // Waits for the thread to end and then destroys it
-      THREAD_JOIN(processes[iter].work, TRUE);
-      free(processes[iter].work);
+  processes[index].is_active = FALSE;
+  ATOMIC_SUB(&counters.active_requests, 1);
 
-      processes[iter].is_active = FALSE;
+  do {
 
-      SOCKET_CLOSE(&(processes[iter].proc_data->connection));
+    old_head = free_slots;
+    processes[index].next_free = (int)(old_head & 0xFFFFFFFFULL) - 1;
+    new_head = ( ( ( old_head >> 32 ) + 1 ) << 32 ) | (unsigned int)( index + 1 );
 
-      free(processes[iter].proc_data);
+  } while ( ! ATOMIC_CAS(&free_slots, old_head, new_head) );
 
-    }
-    
+}
+
+/**
+ * Detaches the connection from a slot and closes it, or hands it
+ * back to the server to wait for the next request of the client
+ *
+ * @param proc_data               data of the slot
+ * @param keep_alive              TRUE to hand the connection back to the server
+ */
+static void process_slot_close( PROCESS_DATA_T * proc_data, int keep_alive ) {
+
+  SOCKET_T * connection;
+
+  MUTEX_LOCK(slots_mutex);
+  connection = proc_data->connection;
+  proc_data->connection = NULL;
+  MUTEX_UNLOCK(slots_mutex);
+
+  if ( keep_alive ) {
+    server_keep_alive(&connection);
   }
 
+  // Left to close unless the server took it
+  SOCKET_CLOSE(&connection);
 }
 
 /**
- * Processes a request message through a socket
+ * Binds a connection to a slot and queues it for the next available worker
  *
+ * @param index                   slot index
  * @param connection              socket that holds the conexion
  */
-void process_incoming_request(SOCKET_T** connection) {
+static void process_slot_start( int index, SOCKET_T * connection ) {
 
-  int iter;
+  PROCESS_DATA_T * proc_data = &processes[index].proc_data;
 
-  // Finds the first available node
-  for (iter = 0; iter < MAX_PROCESSES; iter++) {
+  MUTEX_LOCK(slots_mutex);
 
-    if ( processes[iter].is_active == FALSE ) {
+  memset(proc_data, 0x00, sizeof(PROCESS_DATA_T));
+  proc_data->process_id = index;
+  proc_data->connection = connection;
 
-      processes[iter].is_active = TRUE;
-      processes[iter].proc_data = (PROCESS_DATA_T*)malloc(sizeof(PROCESS_DATA_T));
-      processes[iter].proc_data->process_id = iter;
-      processes[iter].proc_data->connection = *connection;
-      
-      processes[iter].work = (thread_t*)malloc(sizeof(thread_t));
-      THREAD_CREATE(&processes[iter].work, (void *)&process_incoming_request_worker, (void *)processes[iter].proc_data );
+  processes[index].is_active = TRUE;
 
-      break;
+  MUTEX_UNLOCK(slots_mutex);
 
-    }
+  if ( ! POOL_SUBMIT(workers, &process_incoming_request_worker, (void *)proc_data) ) {
+
+    LOGGER(__FUNCTION__, "ERROR: request could not be queued.");
 
+    process_slot_close(proc_data, FALSE);
+    process_slot_release(index);
   }
 
 }
 
 /**
- * Thread function for processing an incoming message
+ * Adds a connection to the queue of connections waiting for a slot
  *
- * @param proc_data_arg           data structure with the thread parameters
+ * @param connection              socket that holds the conexion
+ *
+ * @return                        TRUE or FALSE if the queue is full
  */
-void process_incoming_request_worker( void * proc_data_arg ) {
+static int process_pending_push( SOCKET_T * connection ) {
 
-  int brecv = 0;
-
-  int selectval = 0;
+  int res = FALSE;
 
-  char * recbuf = NULL;
-  char * incoming_message = NULL;
+  MUTEX_LOCK(pending_mutex);
 
-  int message_complete = FALSE;
-  unsigned long message_type = 0;
+  if ( pending_count < MAX_PROCESSES ) {
 
-  long total_bytes_received = 0;
-  long incoming_msg_len = 0;
-  long var_part_size = 0;
-  
-  int header_complete = FALSE;
+    pending[ ( pending_first + pending_count ) % MAX_PROCESSES ] = connection;
+    pending_count++;
+    res = TRUE;
+  }
 
-  unsigned long exec_timeout = 0;
-  
-  PROCESS_DATA_T * proc_data = ( PROCESS_DATA_T * ) proc_data_arg;
+  MUTEX_UNLOCK(pending_mutex);
 
-  incoming_message = malloc(HEADER_LEN);
-  brecv = incoming_msg_len = HEADER_LEN;
+  return res;
+}
 
-  // Allocates initial space for message
-  recbuf = malloc(sizeof(char) * HEADER_LEN + VAR_PART_MINIMUM_LEN);
+/**
+ * Takes the oldest connection waiting for a slot
+ *
+ * @return                        connection, or NULL if none is waiting
+ */
+static SOCKET_T * process_pending_pop() {
 
-  // Update moment of next timeout
-  exec_timeout = (GetTickCount() + gl_timeout);
-  
-  while (message_complete != TRUE && abort_processes == FALSE) {
+  SOCKET_T * connection = NULL;
 
-    // Evaluates if operation timed out and cancels
-    if (GetTickCount() > exec_timeout) {
+  MUTEX_LOCK(pending_mutex);
 
-      LOGGER(__FUNCTION__, "ERROR: Message transfer operation timed out.");
-      goto END_PROCESS_INCOMING_REQUEST;
-    }
+  if ( pending_count > 0 ) {
 
-    selectval = SOCKET_SELECT(S_TIMEOUT, proc_data->connection, S_READ);
-    if ( selectval == S_READ ) {
+    connection = pending[pending_first];
+    pending_first = ( pending_first + 1 ) % MAX_PROCESSES;
+    pending_count--;
+  }
 
-      // Attempts to receive the message
-      if ( ! SOCKET_RECV(proc_data->connection, &recbuf, &brecv) ) {
-    
-        // Produces error on fail
-        LOGGER(__FUNCTION__, "ERROR: A connection problem occurred while attemting to receive message." );
-        break;        
-      }
+  MUTEX_UNLOCK(pending_mutex);
 
-      if ( brecv > 0) {
-     
-        total_bytes_received += brecv;
+  return connection;
+}
 
-        // Updates moment of next timeout
-        exec_timeout = GetTickCount() + gl_timeout;
+/**
+ * Starts the waiting connections while there are free slots.
+ * Called after every push to the queue and every slot release
+ * so that no connection is left waiting with a free slot.
+ */
+static void process_pending_start() {
 
-        // Checks if header was previously completed
-        if ( header_complete == TRUE ) {
-      
-          // Copies the new message fragment
-          memcpy( &incoming_message[total_bytes_received-brecv], recbuf, brecv );
-
-          // If received message size has reached the total message size
-          if ( total_bytes_received == ( HEADER_LEN + var_part_size ) ) {
-          
-            // Message completed
-            message_complete = TRUE;
-            break;
-          }
-          else {
-
-            int bytes_left = incoming_msg_len - total_bytes_received;
-            if ( bytes_left < CHUNK_SIZE ) {
-              brecv = bytes_left;
-            }
-            else {
-              brecv = CHUNK_SIZE;
-            }
-          }
-        }
-        // Checks if header is complete
-        else if ( total_bytes_received == HEADER_LEN ) {
-      
-          // Copies the new fragment of message
-          memcpy( &incoming_message[0], recbuf, total_bytes_received );
+  SOCKET_T * connection;
+  int index;
 
-          // Validates header and gets message type
-          message_type = IS_VALID_HEADER( incoming_message, &var_part_size, ( FILE_SND_B + FILE_RCV_B + FILE_DEL_B ) );          
-          if ( message_type > 0x00 ) {
-        
-            header_complete = TRUE;
+  while ( pending_count > 0 && abort_processes == FALSE ) {
 
-            if ( var_part_size == 0 ) {
-                            
-              // If var part size is 0 fails
-              LOGGER(__FUNCTION__, "ERROR: Length of variable part cannot be 0." );
-              break;
-            }
-          
-            if (var_part_size > CHUNK_SIZE) {
-              brecv = CHUNK_SIZE;
-            }
-            else {
-              brecv = var_part_size;
-            }
-
-            incoming_msg_len = HEADER_LEN + var_part_size;
-            incoming_message = realloc( incoming_message, incoming_msg_len );
-            recbuf = realloc( recbuf, incoming_msg_len );
-          }
-          else {
-        
-            // If header is not valid fails
-            LOGGER(__FUNCTION__, "ERROR: The message does not have a valid header." );
-            break;
-          }
-      
-        }
+    index = process_slot_acquire();
+    if ( index < 0 ) {
+      break;
+    }
 
-      }
+    connection = process_pending_pop();
+    if ( connection == NULL ) {
 
+      process_slot_release(index);
+      break;
     }
 
+    process_slot_start(index, connection);
   }
 
-  proc_data->received_message = incoming_message;
-  proc_data->received_msg_len = incoming_msg_len;
+}
 
-  // Sends an ACK message to client
-  if ( ! process_outgoing_message(proc_data->connection, MESSAGE_ACK, strlen(MESSAGE_ACK)) ) {
+/**
+ * Answers a request with RESULT_SERVER_BUSY without
+ * blocking, using only the data already received
+ *
+ * @param connection              socket that holds the conexion
+ */
+static void process_reject( SOCKET_T ** connection ) {
 
-    LOGGER(__FUNCTION__, "ERROR: Acknowledgment message could not be sent.");
-    goto END_PROCESS_INCOMING_REQUEST;
+  char header[HEADER_LEN];
+  char * response = NULL;
+  char * reply = NULL;
+  unsigned long response_len = 0;
+  int ack_len = strlen(MESSAGE_ACK);
+  int bsent;
+  unsigned long message_type = 0;
+  unsigned long params_len = 0;
+  long var_part_size = 0;
+  int version = 0;
+  int flags = 0;
+
+  // Gets the message type from the header to build a matching response
+  if ( SOCKET_PEEK(*connection, header, HEADER_LEN) == HEADER_LEN ) {
+
+    version = HEADER_VERSION( header );
+    if ( version == 2 ) {
+      message_type = IS_VALID_HEADER_V2( header, &params_len, &flags, ( FILE_SND_B + FILE_RCV_B + FILE_DEL_B ) );
+    }
+    else {
+      message_type = IS_VALID_HEADER( header, &var_part_size, ( FILE_SND_B + FILE_RCV_B + FILE_DEL_B ) );
+    }
+  }
+
+  // V2 requests get the response in place of the ACK
+  if ( version == 2 && message_type != 0 ) {
+
+    response = message_v2_response( message_type, RESULT_SERVER_BUSY, 0, &response_len );
+
+    // The listen loop runs this, a client that does not read is not
+    // waited for, a fresh connection takes a response this short at once
+    SOCKET_DISCARD(*connection);
+    SOCKET_SEND_NOWAIT(*connection, response, response_len, &bsent);
+    free(response);
+
+    SOCKET_CLOSE(connection);
+    return;
   }
 
-  // If it is a File Receive message
   if ( message_type == FILE_RCV_B ) {
-      
-    // Process the message
-    process_file_receive( proc_data );    
+    response = message_file_receive_response( RESULT_SERVER_BUSY, 0, NULL, &response_len );
   }
-      
-  // If it is a File Send message
-  if ( message_type == FILE_SND_B ) {
-      
-    // Process the message
-    process_file_send( proc_data );      
+  else if ( message_type == FILE_SND_B ) {
+    response = message_file_send_response( RESULT_SERVER_BUSY, &response_len );
   }
-      
-  // If it is a File Delete message
-  if ( message_type == FILE_DEL_B ) {
-      
-    // Process the message
-    process_file_delete( proc_data );      
+  else if ( message_type == FILE_DEL_B ) {
+    response = message_file_delete_response( RESULT_SERVER_BUSY, &response_len );
   }
 
-END_PROCESS_INCOMING_REQUEST:
+  // Discards the request so closing the socket does not reset the connection
+  SOCKET_DISCARD(*connection);
 
-  // Cleanup
-  if (incoming_message != NULL) {
-    free(incoming_message);
-  }
-  if (recbuf != NULL) {
-    free(recbuf);
-  }
+  // The ACK and the response leave in a single send that never blocks
+  if ( response != NULL ) {
 
-  {
-    int proc_id = proc_data->process_id;
+    reply = (char *)malloc(ack_len + response_len);
+    if ( reply != NULL ) {
 
-    SOCKET_CLOSE(&(proc_data->connection));
-    
-    free(processes[proc_id].proc_data);
-    processes[proc_id].proc_data = NULL;
+      memcpy(reply, MESSAGE_ACK, ack_len);
+      memcpy(&reply[ack_len], response, response_len);
 
-    processes[proc_id].is_active = FALSE;
-    
+      SOCKET_SEND_NOWAIT(*connection, reply, ack_len + response_len, &bsent);
+      free(reply);
+    }
+
+    free(response);
   }
 
-  return;
+  SOCKET_CLOSE(connection);
 }
 
 /**
- * Processes a File Receive message from the client, 
- * performs and finalizes the operation
+ * Initializes processes structures for threads
  *
- * @param proc_data_arg           data structure with connection parameters 
- *                                and received message
+ * @param pool_size               number of worker threads
+ * @param policy                  what to do with requests when all slots
+ *                                are taken, OVERFLOW_QUEUE, OVERFLOW_REJECT
+ *                                or OVERFLOW_CLOSE
+ * @param keep_alive              TRUE to keep connections open for
+ *                                further requests when clients ask for it
+ *
+ * @return                        TRUE or FALSE
  */
-void process_file_receive( PROCESS_DATA_T * proc_data ) {
+int process_init( int pool_size, int policy, int keep_alive ) {
 
-  const int NOT_FOUND = -1;
+  int iter;
 
-  char * filename   = NULL;
-  char l_msg[4096];
+  memset(processes, 0x00, ( sizeof(PROCESS_T) * MAX_PROCESSES ) );
+  memset(&counters, 0x00, sizeof(PROCESS_STATS_T));
+  abort_processes = FALSE;
+  overflow_policy = policy;
+  keep_alive_enabled = keep_alive;
 
-  char * request    = NULL;
-  char * response   = NULL;
+  // Every slot starts on the free stack, lowest index on top
+  for (iter = 0; iter < MAX_PROCESSES; iter++) {
+    processes[iter].next_free = ( iter + 1 < MAX_PROCESSES ) ? iter + 1 : -1;
+  }
+  free_slots = 1;
 
-  int search_filename_res    = 0;
-  unsigned long response_len = 0;
+  pending_first = 0;
+  pending_count = 0;
 
-  int result = RESULT_UNDEFINED;
-  const int param_len = (proc_data->received_msg_len - HEADER_LEN - strlen(PARAM_FILENAME));
+  pending_mutex = (MUTEX_T *)malloc(sizeof(MUTEX_T));
+  memset(pending_mutex, 0x00, sizeof(MUTEX_T));
+  MUTEX_CREATE(&pending_mutex);
 
-  // Copies the request to a safe buffer for searching
-  request = (char*)malloc(sizeof(char) * proc_data->received_msg_len + 1);
-  memcpy(request, proc_data->received_message, proc_data->received_msg_len);
-  request[proc_data->received_msg_len] = '\0';
+  slots_mutex = (MUTEX_T *)malloc(sizeof(MUTEX_T));
+  memset(slots_mutex, 0x00, sizeof(MUTEX_T));
+  MUTEX_CREATE(&slots_mutex);
 
-  search_filename_res = STR_SEARCH( request, PARAM_FILENAME, HEADER_LEN);
-  if ( search_filename_res == NOT_FOUND ) {
+  // Starts the workers that serve the incoming requests
+  workers = POOL_CREATE(pool_size);
+  if ( workers == NULL ) {
 
-    result = RESULT_INVALID_REQUEST;
-    goto END_PROCESS_FILE_RECEIVE;
+    LOGGER(__FUNCTION__, "ERROR: worker pool could not be created.");
+    return FALSE;
   }
+
+  return TRUE;
+}
+
+/**
+ * Finalizes processes structures for threads
+ */
+void process_deinit() {
+
+  SOCKET_T * connection;
+  int iter;
+  abort_processes = TRUE;
   
-  // Gets name of file to send
-  filename = (char*)malloc(sizeof(char) * proc_data->received_msg_len);
-  memcpy( filename, &(request[ ( search_filename_res + strlen(PARAM_FILENAME) ) ]), param_len );
-  filename[param_len] = '\0';
+  // Unblocks the requests in progress so that workers finish quickly,
+  // the lock keeps the workers from closing the connections meanwhile
+  MUTEX_LOCK(slots_mutex);
 
-  sprintf(l_msg, "A request has been received to send the following file: %s", filename);
-  LOGGER(__FUNCTION__, l_msg);
+  for (iter = 0; iter < MAX_PROCESSES; iter++) {
+   
+    if (processes[iter].is_active == TRUE && processes[iter].proc_data.connection != NULL) {
 
-  //
-  // Find, pack, and encode file
-  //
-  {
-    long long filesize = file_size(filename);
+      SOCKET_SHUTDOWN(&(processes[iter].proc_data.connection));
+    }
+    
+  }
 
-    if ( ! file_exists(filename) || filesize <= 0 ) {
+  MUTEX_UNLOCK(slots_mutex);
 
-      LOGGER(__FUNCTION__, "No files have been found for the specified mask.");
-      result = RESULT_FILE_NOT_FOUND;
-    } else {
+  // Waits for the queued and running requests to end, each
+  // of them closes its connection and releases its slot
+  POOL_DESTROY(&workers);
+
+  // Closes the connections that never got a slot
+  while ( ( connection = process_pending_pop() ) != NULL ) {
+    SOCKET_CLOSE(&connection);
+  }
 
-      char gzip_output[256];
-      char b64_output[256];
+  MUTEX_DESTROY(&pending_mutex);
+  free(pending_mutex);
+  pending_mutex = NULL;
 
-      sprintf(gzip_output, ".\\%d-%lu.gz", proc_data->process_id, GetTickCount() );
-      sprintf(b64_output, ".\\%d-%lu.b64", proc_data->process_id, GetTickCount() );
+  MUTEX_DESTROY(&slots_mutex);
+  free(slots_mutex);
+  slots_mutex = NULL;
 
-      if ( gz_pack_file(filename, gzip_output) == TRUE )
-      {
+}
 
-        if ( base64_process_file('e', gzip_output, b64_output, filesize) == TRUE )
-        {
-          unsigned long bytes_read;
-          char * buffer = NULL;
-          FILE * f = NULL;
+/**
+ * Gets the counters of the processes table and the worker pool
+ *
+ * @param stats                   structure that receives the counters
+ */
+void process_get_stats( PROCESS_STATS_T * stats ) {
 
-          filesize = file_size(b64_output);
-          buffer = (char*)malloc(sizeof(char) * filesize + 1);
-          memset(buffer, 0x00, filesize + 1);
+  memcpy(stats, &counters, sizeof(PROCESS_STATS_T));
+  stats->pending_connections = pending_count;
 
-          f = fopen(b64_output, "r");
-          if (f != NULL)
-          {
-            bytes_read = fread(buffer, 1, filesize, f);
+  POOL_STATS(workers, &stats->pool);
+}
 
-            sprintf(l_msg, "%lu bytes read from file %s to process and send.", bytes_read, b64_output);
-            LOGGER(__FUNCTION__, l_msg);
+/**
+ * Processes a request message through a socket
+ *
+ * @param connection              socket that holds the conexion
+ */
+void process_incoming_request(SOCKET_T** connection) {
 
-            fclose(f);
+  int index;
 
-            result = RESULT_SUCCESS;
+  // Takes a free slot, unless connections are already waiting for one
+  index = ( pending_count > 0 ) ? -1 : process_slot_acquire();
+  if ( index >= 0 ) {
 
-            // Generates response message with file content
-            response = message_file_receive_response( result, strlen(buffer), buffer, &response_len );
+    process_slot_start(index, *connection);
+    *connection = NULL;
+    return;
+  }
 
-            // Sends a File Receive response message
-            if ( !process_outgoing_message( proc_data->connection, response, response_len ) ) {
-    
-              LOGGER(__FUNCTION__, "File Receive message could not be sent.");
-            }
-            
-            // Deletes generated temporary files
-            remove(gzip_output);
-            remove(b64_output);
+  // No slots left, applies the overflow policy
+  if ( overflow_policy == OVERFLOW_QUEUE && process_pending_push(*connection) ) {
 
-            // Frees response
-            free(response);
+    ATOMIC_ADD(&counters.overflow_queued, 1);
+    *connection = NULL;
 
-          } else {
+    // A slot may have been released before the push
+    process_pending_start();
+    return;
+  }
 
-            sprintf(l_msg, "Error opening file (%s)", b64_output);
-            LOGGER(__FUNCTION__, l_msg);
+  if ( overflow_policy == OVERFLOW_CLOSE ) {
 
-            result = RESULT_FILE_READ_ERROR;
-          }
+    ATOMIC_ADD(&counters.overflow_closed, 1);
+    SOCKET_CLOSE(connection);
+    return;
+  }
 
-          // Frees buffer
-          free(buffer);
-          
-        } else {
+  ATOMIC_ADD(&counters.overflow_rejected, 1);
+  process_reject(connection);
 
-          sprintf(l_msg, "Error encoding file (%s)", gzip_output);
-          LOGGER(__FUNCTION__, l_msg);
+}
 
-          result = RESULT_FILE_ENCODE_ERROR;
-        }
+/**
+ * Receives part of the request, waiting for data until the operation times out
+ *
+ * @param proc_data               data structure with connection parameters
+ * @param buffer                  buffer for the received data
+ * @param len                     maximum number of bytes to receive
+ *
+ * @return                        number of bytes received, or -1 if the
+ *                                connection failed, timed out or was aborted
+ */
+static int process_recv( PROCESS_DATA_T * proc_data, char * buffer, int len ) {
 
-      } else {
+  int brecv;
 
-        sprintf(l_msg, "Error packing file (%s)", filename);
-        LOGGER(__FUNCTION__, l_msg);
+  while ( abort_processes == FALSE ) {
 
-        result = RESULT_FILE_COMPRESS_ERROR;
-      }
+    // Evaluates if operation timed out and cancels
+    if ( GetTickCount() > proc_data->exec_timeout ) {
 
+      LOGGER(__FUNCTION__, "ERROR: Message transfer operation timed out.");
+      return -1;
     }
 
-  }
-
-END_PROCESS_FILE_RECEIVE:
+    if ( SOCKET_SELECT(S_TIMEOUT, proc_data->connection, S_READ) == S_READ ) {
 
-  // Cleanup
-  if (request != NULL) {
-    free(request);
-  }
-  if (filename != NULL) {
-    free(filename);
-  }
+      brecv = len;
 
-  if (result == RESULT_SUCCESS) {
+      // Attempts to receive the message
+      if ( ! SOCKET_RECV(proc_data->connection, &buffer, &brecv) ) {
 
-    return;
-  }
-  else {
+        LOGGER(__FUNCTION__, "ERROR: A connection problem occurred while attemting to receive message." );
+        return -1;
+      }
 
-    // Generates response
-    response = message_file_receive_response( result, 0, NULL, &response_len );
+      if ( brecv > 0 ) {
 
-    // Sends a File Receive response message
-    if ( !process_outgoing_message( proc_data->connection, response, response_len ) ) {
-    
-      LOGGER(__FUNCTION__, "File Receive response message could not be sent.");
+        // Updates moment of next timeout
+        proc_data->exec_timeout = GetTickCount() + gl_timeout;
+        return brecv;
+      }
     }
 
-    // Libera la respuesta
-    free(response);
   }
 
-  return;
+  return -1;
 }
 
 /**
- * Processes a File Send message from the client, 
- * performs and finalizes the operation
+ * Receives an exact number of bytes of the request
  *
- * @param proc_data_arg           data structure with connection parameters 
- *                                and received message
+ * @param proc_data               data structure with connection parameters
+ * @param buffer                  buffer for the received data
+ * @param len                     number of bytes to receive
+ *
+ * @return                        TRUE or FALSE
  */
-void process_file_send( PROCESS_DATA_T * proc_data ) {
+static int process_recv_all( PROCESS_DATA_T * proc_data, char * buffer, long len ) {
 
-  const int NOT_FOUND = -1;
+  long total = 0;
+  int brecv;
+
+  while ( total < len ) {
+
+    brecv = process_recv(proc_data, &buffer[total], ( len - total > CHUNK_SIZE ) ? CHUNK_SIZE : (int)( len - total ) );
+    if ( brecv < 0 ) {
+      return FALSE;
+    }
+
+    total += brecv;
+  }
+
+  return TRUE;
+}
+
+/**
+ * Reads and discards the rest of the request so that it can still be answered
+ *
+ * @param proc_data               data structure with connection parameters
+ *
+ * @return                        TRUE or FALSE
+ */
+static int process_recv_discard( PROCESS_DATA_T * proc_data ) {
+
+  char buffer[INGEST_CHUNK_SIZE];
+  int brecv;
+
+  while ( proc_data->pending_len > 0 ) {
+
+    brecv = process_recv(proc_data, buffer, ( proc_data->pending_len > INGEST_CHUNK_SIZE ) ? INGEST_CHUNK_SIZE : (int)proc_data->pending_len );
+    if ( brecv < 0 ) {
+      return FALSE;
+    }
+
+    proc_data->pending_len -= brecv;
+  }
+
+  return TRUE;
+}
+
+/**
+ * Receives the length of the next frame of a chunked V1 content, made of
+ * SIZE_LEN hex digits, as the pending length of the request
+ *
+ * @param proc_data               data structure with connection parameters
+ *
+ * @return                        TRUE, or FALSE if the length could not
+ *                                be received or is not valid
+ */
+static int process_recv_frame_len( PROCESS_DATA_T * proc_data ) {
+
+  char frame_len[SIZE_LEN + 1];
+  char * end;
+
+  if ( ! process_recv_all(proc_data, frame_len, SIZE_LEN) ) {
+    return FALSE;
+  }
+
+  frame_len[SIZE_LEN] = '\0';
+  proc_data->pending_len = strtol(frame_len, &end, 16);
+
+  if ( end != &frame_len[SIZE_LEN] || proc_data->pending_len < 0 ) {
+
+    proc_data->pending_len = 0;
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+/**
+ * Gets the flags of the messages that answer a V2 request, which tell the
+ * client whether the connection is kept open and that pipelines are accepted
+ *
+ * @param proc_data               data structure with connection parameters
+ *
+ * @return                        V2_FLAG_PIPELINED, along with V2_FLAG_KEEP_ALIVE
+ *                                if the connection is kept open
+ */
+static int process_response_flags( PROCESS_DATA_T * proc_data ) {
+
+  int keep_alive = proc_data->keep_alive;
+
+  if ( proc_data->pipeline != NULL ) {
+    keep_alive = keep_alive && proc_data->pipeline->keep_alive;
+  }
+
+  return ( ( keep_alive ) ? V2_FLAG_KEEP_ALIVE : 0 ) | V2_FLAG_PIPELINED;
+}
+
+/**
+ * Begins the response to a request of a pipeline, which holds the connection
+ * until the response and its content were sent, and tags it with the request ID
+ *
+ * @param proc_data               data structure with connection parameters
+ * @param response                response message
+ */
+static void process_response_begin( PROCESS_DATA_T * proc_data, char * response ) {
+
+  if ( proc_data->pipeline == NULL ) {
+    return;
+  }
+
+  if ( ! proc_data->responding ) {
+
+    pthread_mutex_lock(&proc_data->pipeline->write_mutex);
+    proc_data->responding = TRUE;
+  }
+
+  message_v2_set_request_id(response, proc_data->request_id);
+}
+
+/**
+ * Ends the response to a request of a pipeline, releasing the connection
+ *
+ * @param proc_data               data structure with connection parameters
+ */
+static void process_response_end( PROCESS_DATA_T * proc_data ) {
+
+  if ( proc_data->responding ) {
+
+    proc_data->responding = FALSE;
+    pthread_mutex_unlock(&proc_data->pipeline->write_mutex);
+  }
+}
+
+/**
+ * Reads and discards the content that follows a refused File Send
+ * request of a pipeline, as frames or uncompressed with its size
+ *
+ * @param proc_data               data structure with connection parameters
+ * @param flags                   flags of the request
+ * @param size                    size of the uncompressed content, -1 if not given
+ *
+ * @return                        TRUE, or FALSE if the content could not be read
+ */
+static int process_recv_content_discard( PROCESS_DATA_T * proc_data, int flags, long long size ) {
+
+  char frame_len_value[V2_FRAME_LEN_SIZE];
+
+  if ( flags & V2_FLAG_RAW ) {
+
+    proc_data->pending_len = (long)size;
+    return ( size >= 0 && process_recv_discard(proc_data) );
+  }
+
+  if ( ! ( flags & V2_FLAG_CHUNKED ) ) {
+    return FALSE;
+  }
+
+  while ( TRUE ) {
+
+    if ( ! process_recv_all(proc_data, frame_len_value, V2_FRAME_LEN_SIZE) ) {
+      return FALSE;
+    }
+
+    proc_data->pending_len = (long)GET_UINT32(frame_len_value);
+    if ( proc_data->pending_len == 0 ) {
+      return TRUE;
+    }
+
+    if ( ! process_recv_discard(proc_data) ) {
+      return FALSE;
+    }
+  }
+}
+
+/**
+ * Receives the parameters of a V2 request whose header was already received
+ *
+ * @param proc_data               data structure with connection parameters
+ *                                and received header
+ * @param message_type            returns the message code
+ * @param flags                   returns the flags of the request
+ *
+ * @return                        TRUE or FALSE
+ */
+static int process_request_params_v2( PROCESS_DATA_T * proc_data, unsigned long * message_type, int * flags ) {
+
+  unsigned long params_len = 0;
+
+  *message_type = IS_VALID_HEADER_V2( proc_data->received_message, &params_len, flags, ( FILE_SND_B + FILE_RCV_B + FILE_DEL_B ) );
+  if ( *message_type == 0x00 ) {
+
+    LOGGER(__FUNCTION__, "ERROR: The message does not have a valid header." );
+    return FALSE;
+  }
+
+  // Every request carries parameters, which are received whole
+  if ( params_len == 0 || params_len > REQUEST_MAX_LEN ) {
+
+    LOGGER(__FUNCTION__, "ERROR: Length of parameters is not valid." );
+    return FALSE;
+  }
+
+  proc_data->received_message = realloc( proc_data->received_message, HEADER_LEN + params_len );
+
+  if ( ! process_recv_all(proc_data, &proc_data->received_message[HEADER_LEN], params_len) ) {
+    return FALSE;
+  }
+
+  proc_data->received_msg_len = HEADER_LEN + params_len;
+
+  return TRUE;
+}
+
+/**
+ * Performs a File Receive request of a pipeline
+ *
+ * @param task                    copy of the data structure of the pipeline
+ *                                with the request
+ */
+static void process_pipeline_perform( PROCESS_DATA_T * task ) {
+
+  PROCESS_PIPELINE_T * pipeline = task->pipeline;
+
+  process_file_receive_v2( task );
+
+  ATOMIC_ADD(&counters.pipelined, 1);
+
+  pthread_mutex_lock(&pipeline->mutex);
+
+  if ( ! task->keep_alive ) {
+    pipeline->broken = TRUE;
+  }
+  pipeline->outstanding--;
+  pthread_cond_signal(&pipeline->done);
+
+  pthread_mutex_unlock(&pipeline->mutex);
+}
+
+/**
+ * Performs a File Receive request of a pipeline on a worker
+ *
+ * @param task_arg                copy of the data structure of the pipeline
+ *                                with the request, free()d once it ends
+ */
+static void process_pipeline_task( void * task_arg ) {
+
+  PROCESS_DATA_T * task = (PROCESS_DATA_T *)task_arg;
+
+  process_pipeline_perform( task );
+
+  free(task->received_message);
+  free(task);
+}
+
+/**
+ * Hands a File Receive request of a pipeline to a free worker,
+ * or performs it right away when every worker is busy or there
+ * is no memory to copy it for a worker
+ *
+ * @param proc_data               data structure of the pipeline with the request
+ */
+static void process_pipeline_submit( PROCESS_DATA_T * proc_data ) {
+
+  PROCESS_DATA_T * task;
+  PROCESS_DATA_T request;
+
+  task = (PROCESS_DATA_T *)malloc(sizeof(PROCESS_DATA_T));
+  if ( task != NULL ) {
+
+    memcpy(task, proc_data, sizeof(PROCESS_DATA_T));
+
+    task->received_message = (char *)malloc(proc_data->received_msg_len);
+    if ( task->received_message == NULL ) {
+
+      free(task);
+      task = NULL;
+    }
+  }
+
+  pthread_mutex_lock(&proc_data->pipeline->mutex);
+  proc_data->pipeline->outstanding++;
+  pthread_mutex_unlock(&proc_data->pipeline->mutex);
+
+  if ( task == NULL ) {
+
+    LOGGER(__FUNCTION__, "Not enough memory to hand the request to a worker, it is performed right away.");
+
+    memcpy(&request, proc_data, sizeof(PROCESS_DATA_T));
+    request.connection = proc_data->pipeline->writer;
+    request.keep_alive = TRUE;
+    request.responding = FALSE;
+
+    process_pipeline_perform( &request );
+
+    proc_data->received_message = request.received_message;
+    return;
+  }
+
+  memcpy(task->received_message, proc_data->received_message, proc_data->received_msg_len);
+
+  task->connection = proc_data->pipeline->writer;
+  task->keep_alive = TRUE;
+  task->responding = FALSE;
+
+  if ( ! POOL_SUBMIT_IDLE(workers, &process_pipeline_task, task) ) {
+    process_pipeline_task(task);
+  }
+}
+
+/**
+ * Waits until every request of a pipeline handed to the workers was answered
+ *
+ * @param pipeline                pipeline's data structure
+ */
+static void process_pipeline_drain( PROCESS_PIPELINE_T * pipeline ) {
+
+  pthread_mutex_lock(&pipeline->mutex);
+  while ( pipeline->outstanding > 0 ) {
+    pthread_cond_wait(&pipeline->done, &pipeline->mutex);
+  }
+  pthread_mutex_unlock(&pipeline->mutex);
+}
+
+/**
+ * Receives the next request of a pipeline, as soon as the client sends it
+ * while requests of the pipeline are still running
+ *
+ * @param proc_data               data structure of the pipeline
+ * @param message_type            returns the message code
+ * @param flags                   returns the flags of the request
+ *
+ * @return                        TRUE if a request was received, FALSE when
+ *                                the pipeline ended or the connection failed
+ */
+static int process_pipeline_next( PROCESS_DATA_T * proc_data, unsigned long * message_type, int * flags ) {
+
+  int outstanding;
+  int broken;
+
+  while ( abort_processes == FALSE ) {
+
+    pthread_mutex_lock(&proc_data->pipeline->mutex);
+    outstanding = proc_data->pipeline->outstanding;
+    broken = proc_data->pipeline->broken;
+    pthread_mutex_unlock(&proc_data->pipeline->mutex);
+
+    // A response that could not be sent leaves the connection unusable
+    if ( broken ) {
+      return FALSE;
+    }
+
+    if ( SOCKET_SELECT(0, proc_data->connection, S_READ) == S_READ ) {
+
+      proc_data->exec_timeout = GetTickCount() + gl_timeout;
+
+      if ( ! process_recv_all(proc_data, proc_data->received_message, HEADER_LEN) ||
+           ! process_request_params_v2(proc_data, message_type, flags) ) {
+
+        proc_data->keep_alive = FALSE;
+        return FALSE;
+      }
+
+      return TRUE;
+    }
+
+    // Ends once every request was answered and no other one arrived
+    if ( outstanding == 0 ) {
+      return FALSE;
+    }
+
+    SOCKET_SELECT(S_TIMEOUT, proc_data->connection, S_READ);
+  }
+
+  return FALSE;
+}
+
+/**
+ * Serves the requests of a pipeline, the first of them already received.
+ * File Receive requests run on free workers while the next requests are
+ * received, File Send and File Delete ones are performed as they arrive
+ * once the requests before them were answered
+ *
+ * @param proc_data               data structure with connection parameters
+ *                                and the first request
+ * @param message_type            message code of the first request, returns
+ *                                the one of a request out of the pipeline
+ * @param flags                   flags of the first request, returns the
+ *                                ones of a request out of the pipeline
+ *
+ * @return                        TRUE if a request out of the pipeline follows
+ *                                it, already received, otherwise FALSE
+ */
+static int process_pipeline( PROCESS_DATA_T * proc_data, unsigned long * message_type, int * flags ) {
+
+  PROCESS_PIPELINE_T pipeline;
+  int follows = FALSE;
+
+  memset(&pipeline, 0x00, sizeof(PROCESS_PIPELINE_T));
+  pthread_mutex_init(&pipeline.write_mutex, NULL);
+  pthread_mutex_init(&pipeline.mutex, NULL);
+  pthread_cond_init(&pipeline.done, NULL);
+
+  pipeline.writer = SOCKET_SHARE(proc_data->connection);
+
+  // While the pipeline lasts the flag tells whether the connection can still be used
+  proc_data->pipeline = &pipeline;
+  proc_data->keep_alive = TRUE;
+
+  while ( abort_processes == FALSE ) {
+
+    // Requests out of the pipeline are served once the pipeline ends
+    if ( ! ( *flags & V2_FLAG_PIPELINED ) ) {
+
+      follows = TRUE;
+      break;
+    }
+
+    pipeline.keep_alive = ( ( *flags & V2_FLAG_KEEP_ALIVE ) && keep_alive_enabled );
+    proc_data->request_id = message_v2_get_request_id(proc_data->received_message);
+
+    if ( *message_type == FILE_RCV_B ) {
+      process_pipeline_submit( proc_data );
+    }
+    else {
+
+      // Changes to files wait for the File Receive requests before them
+      process_pipeline_drain( &pipeline );
+
+      if ( *message_type == FILE_SND_B ) {
+        process_file_send_v2( proc_data );
+      }
+      else {
+        process_file_delete_v2( proc_data );
+      }
+
+      ATOMIC_ADD(&counters.pipelined, 1);
+    }
+
+    if ( ! proc_data->keep_alive || ! process_pipeline_next(proc_data, message_type, flags) ) {
+      break;
+    }
+  }
+
+  // Waits for the requests still running on other workers
+  process_pipeline_drain( &pipeline );
+
+  proc_data->keep_alive = ( proc_data->keep_alive && ! pipeline.broken && abort_processes == FALSE );
+  if ( ! follows ) {
+    proc_data->keep_alive = ( proc_data->keep_alive && pipeline.keep_alive );
+  }
+
+  proc_data->pipeline = NULL;
+  proc_data->request_id = 0;
+
+  SOCKET_UNSHARE(&pipeline.writer);
+  pthread_cond_destroy(&pipeline.done);
+  pthread_mutex_destroy(&pipeline.mutex);
+  pthread_mutex_destroy(&pipeline.write_mutex);
+
+  return ( follows && proc_data->keep_alive );
+}
+
+/**
+ * Receives the parameters of a V2 request, whose header was
+ * already received, and performs the operation
+ *
+ * @param proc_data               data structure with connection parameters
+ *                                and received header
+ */
+static void process_incoming_request_v2( PROCESS_DATA_T * proc_data ) {
+
+  unsigned long message_type = 0;
+  int flags = 0;
+
+  char ack[HEADER_LEN];
+
+  if ( ! process_request_params_v2(proc_data, &message_type, &flags) ) {
+    return;
+  }
+
+  // The requests of a pipeline are served until it ends, followed
+  // by a request out of it when the client already sent one
+  if ( ( flags & V2_FLAG_PIPELINED ) && ! process_pipeline(proc_data, &message_type, &flags) ) {
+    return;
+  }
+
+  // The connection is kept open for the next request if the
+  // client asks for it, as long as this one ends cleanly
+  proc_data->keep_alive = ( ( flags & V2_FLAG_KEEP_ALIVE ) && keep_alive_enabled );
+
+  // A File Send message is acknowledged once the destination is ready
+  if ( message_type == FILE_SND_B ) {
+
+    process_file_send_v2( proc_data );
+    return;
+  }
+
+  // Sends an ACK message to client
+  message_v2_header( ack, ACK_B, process_response_flags(proc_data), 0 );
+
+  if ( ! process_outgoing_message(proc_data->connection, ack, HEADER_LEN) ) {
+
+    LOGGER(__FUNCTION__, "ERROR: Acknowledgment message could not be sent.");
+    proc_data->keep_alive = FALSE;
+    return;
+  }
+
+  if ( message_type == FILE_RCV_B ) {
+    process_file_receive_v2( proc_data );
+  }
+
+  if ( message_type == FILE_DEL_B ) {
+    process_file_delete_v2( proc_data );
+  }
+
+}
+
+/**
+ * Worker function for processing an incoming message
+ *
+ * @param proc_data_arg           data structure with the thread parameters
+ */
+void process_incoming_request_worker( void * proc_data_arg ) {
+
+  char * incoming_message = NULL;
+
+  unsigned long message_type = 0;
+  long var_part_size = 0;
+  
+  PROCESS_DATA_T * proc_data = ( PROCESS_DATA_T * ) proc_data_arg;
+
+  incoming_message = malloc(HEADER_LEN);
+
+  // Update moment of next timeout
+  proc_data->exec_timeout = (GetTickCount() + gl_timeout);
+
+  // Receives and validates the header
+  if ( ! process_recv_all(proc_data, incoming_message, HEADER_LEN) ) {
+    goto END_PROCESS_INCOMING_REQUEST;
+  }
+
+  // Requests of the second version of the protocol are served apart
+  if ( HEADER_VERSION( incoming_message ) == 2 ) {
+
+    proc_data->received_message = incoming_message;
+    proc_data->received_msg_len = HEADER_LEN;
+
+    process_incoming_request_v2( proc_data );
+
+    incoming_message = proc_data->received_message;
+    goto END_PROCESS_INCOMING_REQUEST;
+  }
+
+  message_type = IS_VALID_HEADER( incoming_message, &var_part_size, ( FILE_SND_B + FILE_RCV_B + FILE_DEL_B ) );          
+  if ( message_type == 0x00 ) {
+
+    // If header is not valid fails
+    LOGGER(__FUNCTION__, "ERROR: The message does not have a valid header." );
+    goto END_PROCESS_INCOMING_REQUEST;
+  }
+
+  if ( var_part_size == 0 ) {
+                            
+    // If var part size is 0 fails
+    LOGGER(__FUNCTION__, "ERROR: Length of variable part cannot be 0." );
+    goto END_PROCESS_INCOMING_REQUEST;
+  }
+
+  proc_data->received_message = incoming_message;
+  proc_data->received_msg_len = HEADER_LEN;
+  proc_data->pending_len = var_part_size;
+
+  // A File Send message carries the file content, it is processed
+  // as it arrives and acknowledged once it was fully received
+  if ( message_type == FILE_SND_B ) {
+      
+    process_file_send( proc_data );
+    goto END_PROCESS_INCOMING_REQUEST;
+  }
+
+  // Other messages only carry parameters and are received whole
+  if ( var_part_size > REQUEST_MAX_LEN ) {
+
+    LOGGER(__FUNCTION__, "ERROR: Length of variable part exceeds the maximum allowed." );
+    goto END_PROCESS_INCOMING_REQUEST;
+  }
+
+  incoming_message = realloc( incoming_message, HEADER_LEN + var_part_size );
+  proc_data->received_message = incoming_message;
+
+  if ( ! process_recv_all(proc_data, &incoming_message[HEADER_LEN], var_part_size) ) {
+    goto END_PROCESS_INCOMING_REQUEST;
+  }
+
+  proc_data->received_msg_len = HEADER_LEN + var_part_size;
+  proc_data->pending_len = 0;
+
+  // Sends an ACK message to client
+  if ( ! process_outgoing_message(proc_data->connection, MESSAGE_ACK, strlen(MESSAGE_ACK)) ) {
+
+    LOGGER(__FUNCTION__, "ERROR: Acknowledgment message could not be sent.");
+    goto END_PROCESS_INCOMING_REQUEST;
+  }
+
+  // If it is a File Receive message
+  if ( message_type == FILE_RCV_B ) {
+      
+    // Process the message
+    process_file_receive( proc_data );    
+  }
+      
+  // If it is a File Delete message
+  if ( message_type == FILE_DEL_B ) {
+      
+    // Process the message
+    process_file_delete( proc_data );      
+  }
+
+END_PROCESS_INCOMING_REQUEST:
+
+  // Cleanup
+  if (incoming_message != NULL) {
+    free(incoming_message);
+  }
+
+  // Hands the connection back to the server to wait for the next
+  // request of the client, otherwise the connection is closed
+  if ( proc_data->keep_alive == TRUE && abort_processes == FALSE ) {
+
+    ATOMIC_ADD(&counters.kept_alive, 1);
+    process_slot_close(proc_data, TRUE);
+  }
+  else {
+    process_slot_close(proc_data, FALSE);
+  }
+
+  // Frees the slot and hands it to a waiting connection, if any
+  process_slot_release(proc_data->process_id);
+  process_pending_start();
+
+  return;
+}
+
+/**
+ * Creates the directories a received file is written to
+ *
+ * @param filename                path of the file
+ *
+ * @return                        RESULT_SUCCESS,
+ *                                RESULT_COULD_NOT_CREATE_DESTINATION_DIRECTORY
+ *                                or RESULT_INVALID_DESTINATION_DIRECTORY
+ */
+static int process_prepare_destination( char * filename ) {
+
+  char destination_dir[2048];
+  char l_msg[4096];
+
+  file_get_base_path(filename, destination_dir);
+  if (destination_dir != NULL)
+  {
+    // If destination directory is not root
+    if (strcmp(destination_dir, ROOT_DIR) != 0 ) {
+
+      if ( ! file_directory_exists(destination_dir)) {
+
+        if ( ! file_mkdir_parent(destination_dir) ) {
+          return RESULT_COULD_NOT_CREATE_DESTINATION_DIRECTORY;
+        }
+      }
+    }
+  }
+  else {
+      
+    sprintf(l_msg, "ERROR: The directory specified for the file %s is not valid.", filename);
+    LOGGER(__FUNCTION__, l_msg);
+
+    return RESULT_INVALID_DESTINATION_DIRECTORY;
+  }
+
+  return RESULT_SUCCESS;
+}
+
+/**
+ * Processes a File Receive message from the client, 
+ * performs and finalizes the operation.
+ *
+ * The file is deflated, encoded and sent in fragments as it is read. The
+ * length of the content goes in the header, so unless the client asked for
+ * a chunked response the file is deflated into a spool, sent from it once
+ * its length is known.
+ *
+ * @param proc_data_arg           data structure with connection parameters 
+ *                                and received message
+ */
+void process_file_receive( PROCESS_DATA_T * proc_data ) {
+
+  const int NOT_FOUND = -1;
+
+  char * filename   = NULL;
+  char l_msg[4096];
+
+  char * request    = NULL;
+  char * response   = NULL;
+
+  int search_filename_res    = 0;
+  int search_chunked_res     = 0;
+  unsigned long response_len = 0;
+
+  int result = RESULT_UNDEFINED;
+  int param_len = 0;
+  int fd = -1;
+  int mode;
+  int format;
+  struct stat info;
+  CACHE_ENTRY_T * cached = NULL;
+  FLIGHT_T * flight = NULL;
+  int leader = FALSE;
+  FILE * spool = NULL;
+
+  int chunked = FALSE;
+  unsigned long long content_len = 0;
+  unsigned long long sent_len = 0;
+
+  // Copies the request to a safe buffer for searching
+  request = (char*)malloc(sizeof(char) * proc_data->received_msg_len + 1);
+  memcpy(request, proc_data->received_message, proc_data->received_msg_len);
+  request[proc_data->received_msg_len] = '\0';
+
+  search_filename_res = STR_SEARCH( request, PARAM_FILENAME, HEADER_LEN);
+  if ( search_filename_res == NOT_FOUND ) {
+
+    result = RESULT_INVALID_REQUEST;
+    goto END_PROCESS_FILE_RECEIVE;
+  }
+  
+  // Gets name of file to send, it takes the rest of the message
+  param_len = proc_data->received_msg_len - ( search_filename_res + strlen(PARAM_FILENAME) );
+  filename = (char*)malloc(sizeof(char) * param_len + 1);
+  memcpy( filename, &(request[ ( search_filename_res + strlen(PARAM_FILENAME) ) ]), param_len );
+  filename[param_len] = '\0';
+
+  // The client may ask for a chunked response before the filename
+  search_chunked_res = STR_SEARCH( request, PARAM_CHUNKED, HEADER_LEN);
+  chunked = ( search_chunked_res != NOT_FOUND && search_chunked_res < search_filename_res
+              && request[search_chunked_res + strlen(PARAM_CHUNKED)] == '1' );
+
+  sprintf(l_msg, "A request has been received to send the following file: %s", filename);
+  LOGGER(__FUNCTION__, l_msg);
+
+  //
+  // Finds the file and measures its content
+  //
+  if ( ! file_exists(filename) || file_size(filename) <= 0 ) {
+
+    LOGGER(__FUNCTION__, "No files have been found for the specified mask.");
+    result = RESULT_FILE_NOT_FOUND;
+    goto END_PROCESS_FILE_RECEIVE;
+  }
+
+  fd = open(filename, O_RDONLY);
+  if ( fd == -1 || fstat(fd, &info) != 0 ) {
+
+    sprintf(l_msg, "Error opening file (%s)", filename);
+    LOGGER(__FUNCTION__, l_msg);
+
+    result = RESULT_FILE_READ_ERROR;
+    goto END_PROCESS_FILE_RECEIVE;
+  }
+
+  // The content sent for the same version of the file is sent again as it was
+  format = ( chunked ) ? CONTENT_ENCODED_CHUNKED : CONTENT_ENCODED;
+  cached = cache_lookup(filename, &info, format, CODEC_GZIP);
+
+  if ( cached != NULL ) {
+
+    mode = cached->mode;
+    content_len = cached->len;
+
+    sprintf(l_msg, "Content of file %s is sent from the cache.", filename);
+    LOGGER(__FUNCTION__, l_msg);
+  }
+  else {
+
+    // Concurrent requests for the same content share the one that produces it
+    flight = flight_join(filename, &info, format, CODEC_GZIP, &leader);
+    if ( flight != NULL && ! leader && ! flight_wait(flight, gl_timeout, &mode, &content_len) ) {
+
+      flight_leave(flight);
+      flight = NULL;
+    }
+  }
+
+  if ( flight != NULL && ! leader ) {
+
+    sprintf(l_msg, "Content of file %s is shared with a request in flight.", filename);
+    LOGGER(__FUNCTION__, l_msg);
+  }
+  else if ( cached == NULL ) {
+
+    mode = gz_choose_mode(fd, filename);
+
+    sprintf(l_msg, "File is packed with the %s compression mode.", gz_mode_name(mode));
+    LOGGER(__FUNCTION__, l_msg);
+
+    if ( ! chunked ) {
+
+      result = process_spool_file(fd, mode, &spool, &content_len);
+      if ( result != RESULT_SUCCESS ) {
+
+        sprintf(l_msg, "Error packing file (%s)", filename);
+        LOGGER(__FUNCTION__, l_msg);
+        goto END_PROCESS_FILE_RECEIVE;
+      }
+    }
+
+    if ( leader ) {
+      flight_begin(flight, mode, content_len);
+    }
+  }
+
+  // Generates the response message without content
+  response = message_file_receive_response_prefix( content_len, chunked, &response_len );
+  if ( response == NULL ) {
+
+    sprintf(l_msg, "File is too large to be sent in a single message (%s)", filename);
+    LOGGER(__FUNCTION__, l_msg);
+
+    result = RESULT_FILE_READ_ERROR;
+    goto END_PROCESS_FILE_RECEIVE;
+  }
+
+  result = RESULT_SUCCESS;
+
+  //
+  // Packs, encodes and sends the file
+  //
+  if ( cached != NULL ) {
+
+    if ( process_outgoing_cached( proc_data->connection, response, response_len, cached ) != RESULT_SUCCESS ) {
+
+      sprintf(l_msg, "ERROR: File Receive message could not be completed (%s)", filename);
+      LOGGER(__FUNCTION__, l_msg);
+      goto END_PROCESS_FILE_RECEIVE;
+    }
+
+    sprintf(l_msg, "%llu bytes of cached content sent for file %s.", cached->len, filename);
+    LOGGER(__FUNCTION__, l_msg);
+    goto END_PROCESS_FILE_RECEIVE;
+  }
+
+  if ( flight != NULL && ! leader ) {
+
+    if ( ! process_outgoing_data( proc_data->connection, response, response_len ) ||
+         process_outgoing_flight( proc_data->connection, flight, &sent_len ) != RESULT_SUCCESS ) {
+
+      sprintf(l_msg, "ERROR: File Receive message could not be completed (%s)", filename);
+      LOGGER(__FUNCTION__, l_msg);
+      goto END_PROCESS_FILE_RECEIVE;
+    }
+  }
+  else if ( ! process_outgoing_data( proc_data->connection, response, response_len ) ||
+            process_outgoing_file_capture( proc_data->connection, ( spool != NULL ) ? fileno(spool) : fd, -1, format,
+                                           ( spool != NULL ) ? EGRESS_STORED : CODEC_GZIP, mode, flight, &sent_len ) != RESULT_SUCCESS ) {
+
+    sprintf(l_msg, "ERROR: File Receive message could not be completed (%s)", filename);
+    LOGGER(__FUNCTION__, l_msg);
+    goto END_PROCESS_FILE_RECEIVE;
+  }
+
+  sprintf(l_msg, "%llu bytes of encoded content sent for file %s.", sent_len, filename);
+  LOGGER(__FUNCTION__, l_msg);
+
+END_PROCESS_FILE_RECEIVE:
+
+  // Cleanup
+  if (flight != NULL && leader) {
+    flight_end(flight, fd);
+  }
+  else if (flight != NULL) {
+    flight_leave(flight);
+  }
+  if (cached != NULL) {
+    cache_release(cached);
+  }
+  if (spool != NULL) {
+    fclose(spool);
+  }
+  if (fd != -1) {
+    close(fd);
+  }
+  if (request != NULL) {
+    free(request);
+  }
+  if (filename != NULL) {
+    free(filename);
+  }
+  if (response != NULL) {
+    free(response);
+    response = NULL;
+  }
+
+  // Once the response was started any failure can only close the connection
+  if (result != RESULT_SUCCESS) {
+
+    // Generates response
+    response = message_file_receive_response( result, 0, NULL, &response_len );
+
+    // Sends a File Receive response message
+    if ( !process_outgoing_message( proc_data->connection, response, response_len ) ) {
+    
+      LOGGER(__FUNCTION__, "File Receive response message could not be sent.");
+    }
+
+    // Libera la respuesta
+    free(response);
+  }
+
+  return;
+}
+
+/**
+ * Processes a File Send message from the client, 
+ * performs and finalizes the operation.
+ *
+ * The content, whose length is given in the header or which follows it
+ * as frames when chunked, is base64-decoded and inflated as it is received
+ * and written to a temporary file next to the destination, which replaces
+ * the destination once the whole message was processed.
+ *
+ * @param proc_data_arg           data structure with connection parameters,
+ *                                received header and pending var part length
+ */
+void process_file_send( PROCESS_DATA_T * proc_data ) {
+
+  const int NOT_FOUND = -1;
+
+  char * filename = NULL;
+  char * response = NULL;
+
+  char request[REQUEST_PREFIX_MAX + 1];
+  char buffer[INGEST_CHUNK_SIZE];
+
+  int request_len             = 0;
+  int search_path_res         = NOT_FOUND;
+  int search_length_res       = NOT_FOUND;
+  int search_size_res         = NOT_FOUND;
+  int search_chunked_res      = NOT_FOUND;
+  int search_content_res      = NOT_FOUND;
+
+  unsigned long response_len  = 0;
+
+  char temp_filename[2048];
+  char l_msg[4096];
+
+  int result = RESULT_UNDEFINED;  
+  int fd = -1;
+  int temp_created = FALSE;
+  int chunked = FALSE;
+  int brecv = 0;
+    
+  unsigned long content_len = 0;
+  long long file_len = 0;
+  int param_path_len = 0;
+
+  PROCESS_INGEST_T ingest;
+
+  memset(&ingest, 0x00, sizeof(PROCESS_INGEST_T));
+
+  //
+  // Receives the parameters that precede the content, together
+  // with the first fragment of the content
+  //
+  while ( search_content_res == NOT_FOUND && proc_data->pending_len > 0 && request_len < REQUEST_PREFIX_MAX ) {
+
+    brecv = REQUEST_PREFIX_MAX - request_len;
+    if ( brecv > proc_data->pending_len ) {
+      brecv = proc_data->pending_len;
+    }
+
+    brecv = process_recv(proc_data, &request[request_len], brecv);
+    if ( brecv < 0 ) {
+      goto END_PROCESS_FILE_SEND_CONNECTION;
+    }
+
+    proc_data->pending_len -= brecv;
+    request_len += brecv;
+    request[request_len] = '\0';
+
+    search_content_res = STR_SEARCH( request, PARAM_CONTENT, 0);
+  }
+
+  // Finds parameters positions
+  search_path_res         = STR_SEARCH( request, PARAM_PATH, 0);
+  search_length_res       = STR_SEARCH( request, PARAM_LENGTH, 0);
+
+  // A chunked content follows the parameters as frames, in place of its length
+  search_chunked_res = STR_SEARCH( request, PARAM_CHUNKED, 0);
+  chunked = ( search_chunked_res != NOT_FOUND && search_chunked_res < search_content_res
+              && request[search_chunked_res + strlen(PARAM_CHUNKED)] == '1' );
+  if ( chunked ) {
+    search_length_res = search_chunked_res;
+  }
+
+  if (search_path_res == NOT_FOUND || search_length_res == NOT_FOUND || search_content_res == NOT_FOUND) {
+    
+    result = RESULT_INVALID_REQUEST;
+    goto END_PROCESS_FILE_SEND;
+  }
+
+  param_path_len = ( search_length_res - ( search_path_res + strlen(PARAM_PATH) ) );
+  if ( param_path_len <= 0 ) {
+
+    result = RESULT_INVALID_REQUEST;
+    goto END_PROCESS_FILE_SEND;
+  }
+
+  // Gets name of file to receive
+  filename = (char*)malloc(sizeof(char) * param_path_len + 1);  
+  memcpy(filename, &request[search_path_res + strlen(PARAM_PATH)], param_path_len);
+  filename[param_path_len] = '\0';
+
+  sprintf(l_msg, "A request has been received to receive the file: %s", filename);
+  LOGGER(__FUNCTION__, l_msg);
+  
+  //
+  // Gets content length, and the original file size if the client sent it
+  //
+  content_len = ( chunked ) ? 0 : atoi( &( request[ ( search_length_res + strlen(PARAM_LENGTH) ) ] ) );
+  if (content_len == 0 && ! chunked) {
+
+    result = RESULT_INVALID_REQUEST;
+    goto END_PROCESS_FILE_SEND;
+  }
+
+  search_size_res = STR_SEARCH( request, PARAM_SIZE, search_length_res );
+  if ( search_size_res != NOT_FOUND && search_size_res < search_content_res ) {
+    file_len = atoll( &( request[ ( search_size_res + strlen(PARAM_SIZE) ) ] ) );
+  }
+
+  // Prepares directories
+  result = process_prepare_destination(filename);
+  if ( result != RESULT_SUCCESS ) {
+    goto END_PROCESS_FILE_SEND;
+  }
+
+  //
+  // Decodes and unpacks the content as it arrives
+  //
+  fd = file_create_temp(filename, temp_filename, file_len);
+  if ( fd == -1 ) {
+
+    result = RESULT_FILE_WRITE_ERROR;
+    goto END_PROCESS_FILE_SEND;
+  }
+  temp_created = TRUE;
+
+  if ( ! process_ingest_init(&ingest, fd, TRUE, CODEC_GZIP) ) {
+
+    result = RESULT_FILE_DECOMPRESS_ERROR;
+    goto END_PROCESS_FILE_SEND;
+  }
+
+  result = RESULT_SUCCESS;
+
+  // Content already received with the parameters
+  brecv = request_len - ( search_content_res + strlen(PARAM_CONTENT) );
+  memcpy(buffer, &request[search_content_res + strlen(PARAM_CONTENT)], brecv);
+
+  while ( TRUE ) {
+
+    if ( ! process_ingest(&ingest, buffer, brecv) ) {
+
+      sprintf(l_msg, "ERROR: could not unpack file (%s).", filename);
+      LOGGER( __FUNCTION__, l_msg );
+
+      result = RESULT_FILE_DECOMPRESS_ERROR;
+      goto END_PROCESS_FILE_SEND;
+    }
+
+    // Gets the length of the next frame, the last one being CHUNK_END
+    if ( chunked && proc_data->pending_len == 0 ) {
+
+      if ( ! process_recv_frame_len(proc_data) ) {
+        goto END_PROCESS_FILE_SEND_CONNECTION;
+      }
+      chunked = ( proc_data->pending_len > 0 );
+    }
+
+    if ( proc_data->pending_len == 0 ) {
+      break;
+    }
+
+    brecv = process_recv(proc_data, buffer, ( proc_data->pending_len > INGEST_CHUNK_SIZE ) ? INGEST_CHUNK_SIZE : (int)proc_data->pending_len );
+    if ( brecv < 0 ) {
+      goto END_PROCESS_FILE_SEND_CONNECTION;
+    }
+
+    proc_data->pending_len -= brecv;
+  }
+
+  if ( ! process_ingest_end(&ingest) ) {
+
+    sprintf(l_msg, "ERROR: could not unpack file (%s).", filename);
+    LOGGER( __FUNCTION__, l_msg );
+
+    result = RESULT_FILE_DECOMPRESS_ERROR;
+    goto END_PROCESS_FILE_SEND;
+  }
+
+  // Releases the space reserved beyond the actual content
+  if ( ftruncate(fd, lseek(fd, 0, SEEK_CUR)) != 0 || close(fd) != 0 ) {
+
+    fd = -1;
+    result = RESULT_FILE_WRITE_ERROR;
+    goto END_PROCESS_FILE_SEND;
+  }
+  fd = -1;
+
+  // Moves the file into place, keeping a backup of the previous one
+  if ( ! file_replace(temp_filename, filename, TRUE) ) {
+
+    result = RESULT_FILE_WRITE_ERROR;
+    goto END_PROCESS_FILE_SEND;
+  }
+  temp_created = FALSE;
+
+  sprintf(l_msg, "file was succesfully unpacked (%s).", filename);
+  LOGGER( __FUNCTION__, l_msg );
+
+  store_add(filename, NULL);
+  cache_invalidate(filename);
+
+END_PROCESS_FILE_SEND:
+
+  // The temporary file is gone by the time the client gets its response
+  process_ingest_end(&ingest);
+
+  if (fd != -1) {
+    close(fd);
+    fd = -1;
+  }
+  if (temp_created == TRUE) {
+    remove(temp_filename);
+    temp_created = FALSE;
+  }
+
+  // Receives whatever is left of a request that failed, up to
+  // the last frame of a chunked content
+  while ( TRUE ) {
+
+    if ( ! process_recv_discard(proc_data) ) {
+      goto END_PROCESS_FILE_SEND_CONNECTION;
+    }
+
+    if ( ! chunked ) {
+      break;
+    }
+
+    if ( ! process_recv_frame_len(proc_data) ) {
+      goto END_PROCESS_FILE_SEND_CONNECTION;
+    }
+    chunked = ( proc_data->pending_len > 0 );
+  }
+
+  // Sends an ACK message to client
+  if ( ! process_outgoing_message(proc_data->connection, MESSAGE_ACK, strlen(MESSAGE_ACK)) ) {
+
+    LOGGER(__FUNCTION__, "ERROR: Acknowledgment message could not be sent.");
+    goto END_PROCESS_FILE_SEND_CONNECTION;
+  }
+
+  // Generates a response message
+  response = message_file_send_response( result, &response_len );  
+
+  // Sends the response
+  if ( !process_outgoing_message( proc_data->connection, response, response_len ) ) {
+    
+    LOGGER(__FUNCTION__, "File Receive operation response message could not be sent.");
+  }
+
+END_PROCESS_FILE_SEND_CONNECTION:
+
+  // Cleanup
+  process_ingest_end(&ingest);
+
+  if (fd != -1) {
+    close(fd);
+  }
+  if (temp_created == TRUE) {
+    remove(temp_filename);
+  }
+  if (response != NULL) {
+    free(response);
+  }
+  if (filename != NULL) {
+    free(filename);
+  }
+
+  return;
+}
+
+/**
+ * Processes a File Delete message from the client, 
+ * performs and finalizes the operation
+ *
+ * @param proc_data_arg           data structure with connection parameters 
+ *                                and received message
+ */
+void process_file_delete( PROCESS_DATA_T * proc_data ) {
+
+  const int NOT_FOUND = -1;
+
+  char * filename   = NULL;
+  char l_msg[4096];
+
+  char * request    = NULL;
+  char * response   = NULL;
+
+  unsigned long response_len  = 0;
+  int search_filename_res     = 0;
+
+  int result = RESULT_UNDEFINED;
+  const int param_len = (proc_data->received_msg_len - HEADER_LEN - strlen(PARAM_FILENAME));
+
+  // Copies the request to a safe buffer for searching
+  request = (char*)malloc(sizeof(char) * proc_data->received_msg_len + 1);
+  memcpy(request, proc_data->received_message, proc_data->received_msg_len);
+  request[proc_data->received_msg_len] = '\0';
+
+  // Gets name of file to delete
+  search_filename_res = STR_SEARCH( proc_data->received_message, PARAM_FILENAME, HEADER_LEN);
+  if ( search_filename_res == NOT_FOUND ) {
+
+    result = RESULT_INVALID_REQUEST;
+    goto END_PROCESS_FILE_DELETE;
+  }
+
+  filename = (char*)malloc(sizeof(char) * proc_data->received_msg_len);
+  memcpy( filename, &(request[ ( search_filename_res + strlen(PARAM_FILENAME) ) ]), param_len );
+  filename[param_len] = '\0';
+  
+  sprintf(l_msg, "A request has been received to delete the file: %s", filename);
+  LOGGER(__FUNCTION__, l_msg);
+  
+  if (file_exists(filename) == TRUE) {
+  
+    if (file_delete(filename) == TRUE) {
+    
+      cache_invalidate(filename);
+      result = RESULT_SUCCESS;
+    }
+    else {
+      result = RESULT_FILE_DELETE_ERROR;
+    }    
+  }
+  else {
+    result = RESULT_FILE_NOT_FOUND;
+  }
+    
+  // Generates response message
+  response = message_file_delete_response( result, &response_len );  
+
+  // Sends response message
+  if ( !process_outgoing_message( proc_data->connection, response, response_len ) ) {
+    
+    LOGGER(__FUNCTION__, "File Receive response message could not be sent.");
+  }
+
+END_PROCESS_FILE_DELETE:
+
+  // Cleanup
+  if (request != NULL) {
+    free(request);
+  }
+  if (response != NULL) {
+    free(response);
+  }
+  if (filename != NULL) {
+    free(filename);
+  }
+
+  return;
+}
+
+/**
+ * Gets a text parameter of a received V2 request
+ *
+ * @param proc_data               data structure with connection parameters 
+ *                                and received message
+ * @param tag                     tag of the parameter
+ *
+ * @return                        value terminated with NULL, must be free()d
+ *                                after usage, or NULL if it is missing or empty
+ */
+static char * process_get_param_v2( PROCESS_DATA_T * proc_data, int tag ) {
+
+  const char * value;
+  char * param;
+  int len;
+
+  len = message_v2_get_param( &proc_data->received_message[HEADER_LEN], proc_data->received_msg_len - HEADER_LEN, tag, &value );
+  if ( len <= 0 ) {
+    return NULL;
+  }
+
+  param = (char*)malloc(sizeof(char) * len + 1);
+  memcpy(param, value, len);
+  param[len] = '\0';
+
+  return param;
+}
+
+/**
+ * Processes a V2 File Receive message from the client,
+ * performs and finalizes the operation.
+ *
+ * The file is compressed with the codec asked for, if it is allowed, or
+ * with gzip, and sent as raw frames as it is read, or sent as it is when
+ * the client asked for it uncompressed or when it would not shrink. It is
+ * sent from the offset asked for by a client resuming its transfer, or only
+ * the byte range asked for is read and sent. A client that sends a delta of
+ * the file asks for its signature, which is sent in its place.
+ *
+ * @param proc_data_arg           data structure with connection parameters 
+ *                                and received message
+ */
+void process_file_receive_v2( PROCESS_DATA_T * proc_data ) {
+
+  char * filename   = NULL;
+  char * response   = NULL;
+  unsigned char * signature = NULL;
+  char l_msg[4096];
+
+  unsigned long response_len = 0;
+  unsigned long signature_len = 0;
+  unsigned long long sent_len = 0;
+  long long offset = -1;
+  long long length;
+  long block_size;
+  unsigned long long hash = 0;
+  unsigned long long file_hash = 0;
+  struct stat info;
+
+  int result = RESULT_UNDEFINED;
+  int raw = proc_data->received_message[V2_FLAGS_OFFSET] & V2_FLAG_RAW;
+  int whole;
+  int mode;
+  int codec;
+  int fd = -1;
+  CACHE_ENTRY_T * cached = NULL;
+  FLIGHT_T * flight = NULL;
+  int leader = FALSE;
+  unsigned long long content_len;
+
+  filename = process_get_param_v2( proc_data, TAG_FILENAME );
+  if ( filename == NULL ) {
+
+    result = RESULT_INVALID_REQUEST;
+    goto END_PROCESS_FILE_RECEIVE_V2;
+  }
+
+  sprintf(l_msg, "A request has been received to send the following file: %s", filename);
+  LOGGER(__FUNCTION__, l_msg);
+
+  if ( ! file_exists(filename) || file_size(filename) <= 0 ) {
+
+    LOGGER(__FUNCTION__, "No files have been found for the specified mask.");
+    result = RESULT_FILE_NOT_FOUND;
+    goto END_PROCESS_FILE_RECEIVE_V2;
+  }
+
+  fd = open(filename, O_RDONLY);
+  if ( fd == -1 || fstat(fd, &info) != 0 ) {
+
+    sprintf(l_msg, "Error opening file (%s)", filename);
+    LOGGER(__FUNCTION__, l_msg);
+
+    result = RESULT_FILE_READ_ERROR;
+    goto END_PROCESS_FILE_RECEIVE_V2;
+  }
+
+  result = RESULT_SUCCESS;
+
+  // The signature of the file is sent in its place, with
+  // the block size asked for or one that suits the file
+  block_size = message_v2_get_block( &proc_data->received_message[HEADER_LEN], proc_data->received_msg_len - HEADER_LEN );
+  if ( block_size >= 0 ) {
+
+    if ( block_size == 0 ) {
+      block_size = delta_block_size( (long long)info.st_size );
+    }
+
+    if ( block_size < DELTA_BLOCK_MINIMUM_SIZE || block_size > DELTA_BLOCK_MAXIMUM_SIZE ) {
+
+      result = RESULT_INVALID_REQUEST;
+      goto END_PROCESS_FILE_RECEIVE_V2;
+    }
+
+    if ( ! delta_signature( fd, (long long)info.st_size, block_size, &signature, &signature_len ) ) {
+
+      sprintf(l_msg, "ERROR: Signature of file %s could not be computed.", filename);
+      LOGGER(__FUNCTION__, l_msg);
+
+      result = RESULT_FILE_READ_ERROR;
+      goto END_PROCESS_FILE_RECEIVE_V2;
+    }
+
+    response = message_v2_file_signature_response( signature_len, block_size, process_response_flags(proc_data), &response_len );
+    process_response_begin( proc_data, response );
+
+    if ( ! process_outgoing_data( proc_data->connection, response, response_len ) ||
+         ! process_outgoing_data( proc_data->connection, (char *)signature, (int)signature_len ) ) {
+
+      sprintf(l_msg, "ERROR: Signature of file %s could not be sent.", filename);
+      LOGGER(__FUNCTION__, l_msg);
+
+      proc_data->keep_alive = FALSE;
+      goto END_PROCESS_FILE_RECEIVE_V2;
+    }
+
+    sprintf(l_msg, "Signature of %lu blocks of %ld bytes sent for file %s.", signature_len / DELTA_SIGNATURE_ENTRY_LEN, block_size, filename);
+    LOGGER(__FUNCTION__, l_msg);
+    goto END_PROCESS_FILE_RECEIVE_V2;
+  }
+
+  // A byte range is read from its offset, counted from the end of the file
+  // when negative, and clipped to the file
+  if ( message_v2_get_length( &proc_data->received_message[HEADER_LEN], proc_data->received_msg_len - HEADER_LEN, &length ) ) {
+
+    if ( ! message_v2_get_offset( &proc_data->received_message[HEADER_LEN], proc_data->received_msg_len - HEADER_LEN, &offset ) ) {
+      offset = 0;
+    }
+    if ( offset < 0 ) {
+      offset = ( offset < -(long long)info.st_size ) ? 0 : (long long)info.st_size + offset;
+    }
+    if ( offset > (long long)info.st_size ) {
+      offset = (long long)info.st_size;
+    }
+    if ( length < 0 || length > (long long)info.st_size - offset ) {
+      length = (long long)info.st_size - offset;
+    }
+
+    if ( lseek(fd, offset, SEEK_SET) != offset ) {
+
+      result = RESULT_FILE_READ_ERROR;
+      goto END_PROCESS_FILE_RECEIVE_V2;
+    }
+
+    sprintf(l_msg, "Range of %lld bytes is sent from offset %lld.", length, offset);
+    LOGGER(__FUNCTION__, l_msg);
+  }
+
+  // The file is sent from the offset asked for, or from its beginning if it
+  // is no longer that long or its content before the offset is not the one
+  // the client has, the response telling which one
+  else if ( ! message_v2_get_offset( &proc_data->received_message[HEADER_LEN], proc_data->received_msg_len - HEADER_LEN, &offset ) ) {
+
+    offset = -1;
+    length = (long long)info.st_size;
+  }
+  else {
+
+    if ( offset > 0 && ( ! message_v2_get_hash( &proc_data->received_message[HEADER_LEN], proc_data->received_msg_len - HEADER_LEN, &hash ) ||
+                         offset > (long long)info.st_size ||
+                         ! file_content_hash( fd, offset, &file_hash ) || file_hash != hash ) ) {
+      offset = 0;
+    }
+    if ( offset < 0 || lseek(fd, offset, SEEK_SET) != offset ) {
+      offset = 0;
+    }
+
+    sprintf(l_msg, "File is sent from offset %lld.", offset);
+    LOGGER(__FUNCTION__, l_msg);
+
+    length = (long long)info.st_size - offset;
+  }
+
+  codec = codec_negotiate( message_v2_get_codec( &proc_data->received_message[HEADER_LEN], proc_data->received_msg_len - HEADER_LEN ) );
+
+  // The content packed for the same version of a whole file is sent again as it was
+  whole = ( ! raw && length > 0 && offset <= 0 && length == (long long)info.st_size );
+  if ( whole ) {
+    cached = cache_lookup(filename, &info, CONTENT_BINARY_CHUNKED, codec);
+  }
+
+  if ( cached != NULL ) {
+
+    mode = cached->mode;
+
+    sprintf(l_msg, "Content of file %s is sent from the cache.", filename);
+    LOGGER(__FUNCTION__, l_msg);
+  }
+  else if ( whole ) {
+
+    // Concurrent requests for the same content share the one that produces it
+    flight = flight_join(filename, &info, CONTENT_BINARY_CHUNKED, codec, &leader);
+    if ( flight != NULL && ! leader && ! flight_wait(flight, gl_timeout, &mode, &content_len) ) {
+
+      flight_leave(flight);
+      flight = NULL;
+    }
+  }
+
+  if ( flight != NULL && ! leader ) {
+
+    sprintf(l_msg, "Content of file %s is shared with a request in flight.", filename);
+    LOGGER(__FUNCTION__, l_msg);
+  }
+  else if ( cached == NULL ) {
+
+    // Files that would not shrink are sent as they are
+    mode = ( raw || length == 0 ) ? GZ_MODE_STORE : gz_choose_mode(fd, filename);
+
+    sprintf(l_msg, "File is packed with the %s compression mode.", gz_mode_name(mode));
+    LOGGER(__FUNCTION__, l_msg);
+
+    if ( leader && mode != GZ_MODE_STORE ) {
+      flight_begin(flight, mode, 0);
+    }
+  }
+
+  //
+  // Sends the response followed by the file as it is
+  //
+  if ( mode == GZ_MODE_STORE ) {
+
+    response = message_v2_file_receive_response_raw( length, offset, process_response_flags(proc_data), &response_len );
+    process_response_begin( proc_data, response );
+
+    if ( ! process_outgoing_data( proc_data->connection, response, response_len ) ||
+         process_outgoing_file_raw( proc_data->connection, fd, length ) != RESULT_SUCCESS ) {
+
+      sprintf(l_msg, "ERROR: File Receive message could not be completed (%s)", filename);
+      LOGGER(__FUNCTION__, l_msg);
+
+      proc_data->keep_alive = FALSE;
+      goto END_PROCESS_FILE_RECEIVE_V2;
+    }
+
+    sprintf(l_msg, "%lld bytes of uncompressed content sent for file %s.", length, filename);
+    LOGGER(__FUNCTION__, l_msg);
+    goto END_PROCESS_FILE_RECEIVE_V2;
+  }
+
+  //
+  // Sends the response followed by the packed file
+  //
+  sprintf(l_msg, "File is packed with the %s codec.", codec_name(codec));
+  LOGGER(__FUNCTION__, l_msg);
+
+  response = message_v2_file_receive_response_packed( codec, mode, offset, process_response_flags(proc_data), &response_len );
+  process_response_begin( proc_data, response );
+
+  if ( cached != NULL ) {
+
+    if ( process_outgoing_cached( proc_data->connection, response, response_len, cached ) != RESULT_SUCCESS ) {
+
+      sprintf(l_msg, "ERROR: File Receive message could not be completed (%s)", filename);
+      LOGGER(__FUNCTION__, l_msg);
+
+      proc_data->keep_alive = FALSE;
+      goto END_PROCESS_FILE_RECEIVE_V2;
+    }
+
+    sprintf(l_msg, "%llu bytes of cached content sent for file %s.", cached->len, filename);
+    LOGGER(__FUNCTION__, l_msg);
+    goto END_PROCESS_FILE_RECEIVE_V2;
+  }
+
+  if ( flight != NULL && ! leader ) {
+
+    if ( ! process_outgoing_data( proc_data->connection, response, response_len ) ||
+         process_outgoing_flight( proc_data->connection, flight, &sent_len ) != RESULT_SUCCESS ) {
+
+      sprintf(l_msg, "ERROR: File Receive message could not be completed (%s)", filename);
+      LOGGER(__FUNCTION__, l_msg);
+
+      proc_data->keep_alive = FALSE;
+      goto END_PROCESS_FILE_RECEIVE_V2;
+    }
+
+    sprintf(l_msg, "%llu bytes of shared content sent for file %s.", sent_len, filename);
+    LOGGER(__FUNCTION__, l_msg);
+    goto END_PROCESS_FILE_RECEIVE_V2;
+  }
+
+  if ( ! process_outgoing_data( proc_data->connection, response, response_len ) ||
+       process_outgoing_file_capture( proc_data->connection, fd, length, CONTENT_BINARY_CHUNKED, codec, mode, flight, &sent_len ) != RESULT_SUCCESS ) {
+
+    sprintf(l_msg, "ERROR: File Receive message could not be completed (%s)", filename);
+    LOGGER(__FUNCTION__, l_msg);
+
+    proc_data->keep_alive = FALSE;
+    goto END_PROCESS_FILE_RECEIVE_V2;
+  }
+
+  sprintf(l_msg, "%llu bytes of packed content sent for file %s.", sent_len, filename);
+  LOGGER(__FUNCTION__, l_msg);
+
+END_PROCESS_FILE_RECEIVE_V2:
+
+  // Cleanup
+  if (flight != NULL && leader) {
+    flight_end(flight, fd);
+  }
+  else if (flight != NULL) {
+    flight_leave(flight);
+  }
+  if (cached != NULL) {
+    cache_release(cached);
+  }
+  if (fd != -1) {
+    close(fd);
+  }
+  if (filename != NULL) {
+    free(filename);
+  }
+  if (signature != NULL) {
+    free(signature);
+  }
+  if (response != NULL) {
+    free(response);
+    response = NULL;
+  }
+
+  // Once the response was started any failure can only close the connection
+  if (result != RESULT_SUCCESS) {
+
+    response = message_v2_response( FILE_RCV_B, result, process_response_flags(proc_data), &response_len );
+    process_response_begin( proc_data, response );
+
+    if ( !process_outgoing_message( proc_data->connection, response, response_len ) ) {
+    
+      LOGGER(__FUNCTION__, "File Receive response message could not be sent.");
+      proc_data->keep_alive = FALSE;
+    }
+
+    free(response);
+  }
+
+  process_response_end( proc_data );
+
+  return;
+}
+
+/**
+ * Commits a striped transfer, its file replacing the target
+ * once the ranges written cover all of it
+ *
+ * @param filename                path of the target file
+ * @param stripe                  ID of the striped transfer
+ * @param file_len                size of the whole file
+ *
+ * @return                        result code
+ */
+static int process_stripe_commit( char * filename, char * stripe, long long file_len ) {
+
+  char stripe_filename[2048];
+  char l_msg[4096];
+  struct stat info;
+  int fd;
+
+  if ( strlen(stripe) > TRANSFER_ID_MAXIMUM_LEN ) {
+    return RESULT_INVALID_REQUEST;
+  }
+
+  fd = file_open_stripe(filename, stripe, stripe_filename, -1);
+  if ( fd == -1 ) {
+    return RESULT_FILE_NOT_FOUND;
+  }
+
+  // The size is set by the first range, the ranges written
+  // must cover the whole file by the time the client commits
+  if ( fstat(fd, &info) != 0 || (long long)info.st_size != file_len ) {
+
+    sprintf(l_msg, "ERROR: Striped transfer %s does not have the size of file %s.", stripe, filename);
+    LOGGER(__FUNCTION__, l_msg);
+
+    close(fd);
+    return RESULT_FILE_WRITE_ERROR;
+  }
+
+  if ( ! file_stripe_covered(stripe_filename, file_len) ) {
+
+    sprintf(l_msg, "ERROR: Ranges of striped transfer %s do not cover file %s.", stripe, filename);
+    LOGGER(__FUNCTION__, l_msg);
+
+    close(fd);
+    return RESULT_FILE_WRITE_ERROR;
+  }
+
+  if ( fdatasync(fd) != 0 || close(fd) != 0 || ! file_replace(stripe_filename, filename, TRUE) ) {
+    return RESULT_FILE_WRITE_ERROR;
+  }
+  file_stripe_end(stripe_filename);
+
+  sprintf(l_msg, "Striped transfer %s was committed (%s).", stripe, filename);
+  LOGGER(__FUNCTION__, l_msg);
+
+  store_add(filename, NULL);
+  cache_invalidate(filename);
+
+  return RESULT_SUCCESS;
+}
+
+/**
+ * Rebuilds a file from a delta against its current content, the file
+ * rebuilt replacing it once it has the size and digest of the new file
+ *
+ * @param filename                path of the target file
+ * @param delta_filename          path of the file with the delta
+ * @param block_size              block size of the signature the delta refers to
+ * @param file_len                size of the new file
+ * @param digest                  SHA-256 digest of the new file
+ *
+ * @return                        result code
+ */
+static int process_delta_apply( char * filename, char * delta_filename, long block_size, long long file_len, const unsigned char * digest ) {
+
+  char out_filename[2048];
+  char l_msg[4096];
+  unsigned char out_digest[SHA256_DIGEST_LEN];
+  long long out_len = 0;
+  struct stat info;
+  FILE * delta = NULL;
+  int basis_fd;
+  int out_fd = -1;
+  int result = RESULT_FILE_WRITE_ERROR;
+
+  basis_fd = open(filename, O_RDONLY);
+  if ( basis_fd == -1 || fstat(basis_fd, &info) != 0 ) {
+
+    if ( basis_fd != -1 ) {
+      close(basis_fd);
+    }
+    return RESULT_FILE_NOT_FOUND;
+  }
+
+  out_filename[0] = '\0';
+
+  delta = fopen(delta_filename, "rb");
+  out_fd = file_create_temp(filename, out_filename, file_len);
+
+  if ( delta == NULL || out_fd == -1 ) {
+    goto END_PROCESS_DELTA_APPLY;
+  }
+
+  // A file that changed since its signature was sent, or a delta that does
+  // not match it, rebuilds some other file, which is left aside
+  if ( ! delta_apply(basis_fd, (long long)info.st_size, delta, block_size, out_fd, &out_len) ) {
+
+    sprintf(l_msg, "ERROR: Delta could not be applied to file %s.", filename);
+    LOGGER(__FUNCTION__, l_msg);
+
+    result = RESULT_FILE_DECODE_ERROR;
+    goto END_PROCESS_DELTA_APPLY;
+  }
+
+  if ( out_len != file_len || ! sha256_file(out_fd, out_digest) || memcmp(out_digest, digest, SHA256_DIGEST_LEN) != 0 ) {
+
+    sprintf(l_msg, "ERROR: File %s rebuilt from a delta does not have the expected content.", filename);
+    LOGGER(__FUNCTION__, l_msg);
+
+    result = RESULT_FILE_DECODE_ERROR;
+    goto END_PROCESS_DELTA_APPLY;
+  }
+
+  if ( ftruncate(out_fd, out_len) != 0 || close(out_fd) != 0 ) {
+
+    out_fd = -1;
+    goto END_PROCESS_DELTA_APPLY;
+  }
+  out_fd = -1;
+
+  // Moves the file into place, keeping a backup of the previous one
+  if ( ! file_replace(out_filename, filename, TRUE) ) {
+    goto END_PROCESS_DELTA_APPLY;
+  }
+
+  sprintf(l_msg, "File %s was rebuilt from a delta.", filename);
+  LOGGER(__FUNCTION__, l_msg);
+
+  store_add(filename, NULL);
+  cache_invalidate(filename);
+
+  result = RESULT_SUCCESS;
+
+END_PROCESS_DELTA_APPLY:
+
+  close(basis_fd);
+
+  if ( delta != NULL ) {
+    fclose(delta);
+  }
+  if ( out_fd != -1 ) {
+    close(out_fd);
+  }
+  if ( result != RESULT_SUCCESS && out_filename[0] != '\0' ) {
+    remove(out_filename);
+  }
+
+  return result;
+}
+
+/**
+ * Processes a V2 File Send message from the client, acknowledges it
+ * once the destination is ready, then receives the content frames or
+ * the uncompressed file, performs and finalizes the operation.
+ *
+ * The ACK tells the client the codec for the content frames, the one it
+ * asked for if it is allowed, otherwise gzip. Requests of a pipeline are
+ * not acknowledged, their content follows them with the codec asked for,
+ * and is read and discarded when the request is refused.
+ *
+ * The content of a resumable transfer goes into its partial file, which is
+ * kept when the connection is lost, the ACK telling the client the offset
+ * it sends the rest of the file from.
+ *
+ * The range of a striped transfer is written at its offset into the file
+ * shared by all the ranges, which replaces the target once the client
+ * commits the transfer with a request that has no content.
+ *
+ * The content of a request with a block size is a delta against the
+ * current file, which is unpacked into a temporary file of its own and
+ * then applied to the current file.
+ *
+ * A request with the digest of content the store of the server holds is
+ * answered right away with the file made from the store, the response taking
+ * the place of the ACK, and the content of every file received is indexed
+ * into the store.
+ *
+ * @param proc_data_arg           data structure with connection parameters 
+ *                                and received message
+ */
+void process_file_send_v2( PROCESS_DATA_T * proc_data ) {
 
   char * filename = NULL;
-  char * content  = NULL;
+  char * transfer = NULL;
+  char * stripe   = NULL;
+  char * response = NULL;
+  char * ack      = NULL;
+
+  const unsigned char * digest = NULL;
+
+  char frame_len_value[V2_FRAME_LEN_SIZE];
+  char buffer[INGEST_CHUNK_SIZE];
+  char temp_filename[2048];
+  char transfer_key[TRANSFER_ID_MAXIMUM_LEN + 18];
+  char l_msg[4096];
+
+  unsigned long response_len = 0;
+  unsigned long ack_len = 0;
+  unsigned long frame_len = 0;
+  long long file_len = 0;
+  long long offset = 0;
+  long long length = -1;
+  long block_size = -1;
+  unsigned long long hash = 0;
+
+  int result = RESULT_UNDEFINED;
+  int acknowledged = FALSE;
+  int flags = (unsigned char)proc_data->received_message[V2_FLAGS_OFFSET];
+  int raw = flags & V2_FLAG_RAW;
+  int pipelined = ( proc_data->pipeline != NULL );
+  int has_size;
+  int codec = CODEC_GZIP;
+  int fd = -1;
+  int temp_created = FALSE;
+  int resumable = FALSE;
+  int striped = FALSE;
+  int committing = FALSE;
+  int brecv = 0;
+
+  PROCESS_INGEST_T ingest;
+
+  memset(&ingest, 0x00, sizeof(PROCESS_INGEST_T));
+
+  // The content can only follow as frames, or uncompressed with its size
+  has_size = message_v2_get_size( &proc_data->received_message[HEADER_LEN], proc_data->received_msg_len - HEADER_LEN, &file_len );
+
+  filename = process_get_param_v2( proc_data, TAG_PATH );
+  stripe = process_get_param_v2( proc_data, TAG_STRIPE );
+
+  // The content of a range of a striped transfer is as long as the range
+  if ( stripe != NULL && ! message_v2_get_length( &proc_data->received_message[HEADER_LEN], proc_data->received_msg_len - HEADER_LEN, &length ) ) {
+    length = -1;
+  }
+
+  // A striped transfer is committed by a request with no content
+  if ( filename != NULL && stripe != NULL && ! ( flags & ( V2_FLAG_CHUNKED | V2_FLAG_RAW ) ) ) {
+
+    committing = TRUE;
+    result = ( has_size ) ? process_stripe_commit( filename, stripe, file_len ) : RESULT_INVALID_REQUEST;
+    goto END_PROCESS_FILE_SEND_V2;
+  }
+
+  if ( filename == NULL || ! ( flags & ( V2_FLAG_CHUNKED | V2_FLAG_RAW ) ) ) {
+
+    result = RESULT_INVALID_REQUEST;
+    goto END_PROCESS_FILE_SEND_V2;
+  }
+
+  if ( ! raw ) {
+
+    codec = message_v2_get_codec( &proc_data->received_message[HEADER_LEN], proc_data->received_msg_len - HEADER_LEN );
+
+    // The content of a pipeline is already packed with the codec asked for
+    if ( pipelined && codec_negotiate(codec) != codec ) {
+
+      sprintf(l_msg, "ERROR: The %s codec is not accepted.", codec_name(codec));
+      LOGGER(__FUNCTION__, l_msg);
+
+      result = RESULT_INVALID_REQUEST;
+      goto END_PROCESS_FILE_SEND_V2;
+    }
+
+    codec = codec_negotiate(codec);
+  }
+
+  sprintf(l_msg, "A request has been received to receive the file: %s (%s, %s)", filename, codec_name(codec),
+          gz_mode_name( ( raw ) ? GZ_MODE_STORE : message_v2_get_mode( &proc_data->received_message[HEADER_LEN], proc_data->received_msg_len - HEADER_LEN ) ));
+  LOGGER(__FUNCTION__, l_msg);
+
+  // Gets the original file size if the client sent it,
+  // the uncompressed content cannot be received without it
+  if ( ! has_size && raw ) {
+
+    result = RESULT_INVALID_REQUEST;
+    goto END_PROCESS_FILE_SEND_V2;
+  }
+
+  // Prepares directories and the temporary file
+  result = process_prepare_destination(filename);
+  if ( result != RESULT_SUCCESS ) {
+    goto END_PROCESS_FILE_SEND_V2;
+  }
+
+  // A delta is rebuilt into the file it was computed against, and is
+  // checked against the size and digest of the new file once applied
+  digest = message_v2_get_digest( &proc_data->received_message[HEADER_LEN], proc_data->received_msg_len - HEADER_LEN );
+  block_size = message_v2_get_block( &proc_data->received_message[HEADER_LEN], proc_data->received_msg_len - HEADER_LEN );
+  if ( block_size >= 0 && ( raw || ! has_size || stripe != NULL || digest == NULL ) ) {
+
+    result = RESULT_INVALID_REQUEST;
+    goto END_PROCESS_FILE_SEND_V2;
+  }
+  if ( block_size >= 0 && ! file_exists(filename) ) {
+
+    result = RESULT_FILE_NOT_FOUND;
+    goto END_PROCESS_FILE_SEND_V2;
+  }
+
+  // Content the store already holds is not sent again
+  if ( digest != NULL && has_size && block_size < 0 && stripe == NULL && store_materialize(digest, file_len, filename, TRUE) ) {
+
+    sprintf(l_msg, "File %s was made from the content store.", filename);
+    LOGGER(__FUNCTION__, l_msg);
+
+    cache_invalidate(filename);
+    goto END_PROCESS_FILE_SEND_V2;
+  }
+
+  // The content of a resumable transfer goes into a partial file named after
+  // it and kept if the connection is lost, its content is sent from what it
+  // already has, except within a pipeline where the content follows at once
+  transfer = process_get_param_v2( proc_data, TAG_TRANSFER );
+  if ( transfer != NULL && block_size < 0 ) {
+
+    if ( strlen(transfer) > TRANSFER_ID_MAXIMUM_LEN ||
+         ! message_v2_get_hash( &proc_data->received_message[HEADER_LEN], proc_data->received_msg_len - HEADER_LEN, &hash ) ) {
+
+      result = RESULT_INVALID_REQUEST;
+      goto END_PROCESS_FILE_SEND_V2;
+    }
+
+    sprintf(transfer_key, "%s-%016llx", transfer, hash);
+
+    fd = file_open_part(filename, transfer_key, temp_filename, ( has_size ) ? file_len : -1, &offset);
+    if ( fd == -1 ) {
+
+      result = RESULT_FILE_WRITE_ERROR;
+      goto END_PROCESS_FILE_SEND_V2;
+    }
+    temp_created = TRUE;
+    resumable = TRUE;
+
+    if ( pipelined && ( ftruncate(fd, 0) != 0 || lseek(fd, 0, SEEK_SET) != 0 ) ) {
+
+      result = RESULT_FILE_WRITE_ERROR;
+      goto END_PROCESS_FILE_SEND_V2;
+    }
+    if ( pipelined ) {
+      offset = 0;
+    }
+
+    sprintf(l_msg, "Resumable transfer %s continues at offset %lld.", transfer_key, offset);
+    LOGGER(__FUNCTION__, l_msg);
+  }
+
+  // The range of a striped transfer is written at its offset
+  // into the file that all the ranges of the transfer share
+  else if ( stripe != NULL ) {
+
+    if ( ! has_size || strlen(stripe) > TRANSFER_ID_MAXIMUM_LEN ||
+         ! message_v2_get_offset( &proc_data->received_message[HEADER_LEN], proc_data->received_msg_len - HEADER_LEN, &offset ) ||
+         offset < 0 || length < 0 || offset > file_len || length > file_len - offset ) {
+
+      result = RESULT_INVALID_REQUEST;
+      goto END_PROCESS_FILE_SEND_V2;
+    }
+
+    fd = file_open_stripe(filename, stripe, temp_filename, file_len);
+    if ( fd == -1 || lseek(fd, offset, SEEK_SET) != offset ) {
+
+      result = RESULT_FILE_WRITE_ERROR;
+      goto END_PROCESS_FILE_SEND_V2;
+    }
+    striped = TRUE;
+
+    sprintf(l_msg, "Range of %lld bytes of striped transfer %s is written at offset %lld.", length, stripe, offset);
+    LOGGER(__FUNCTION__, l_msg);
+  }
+  else {
+
+    fd = file_create_temp(filename, temp_filename, ( block_size >= 0 ) ? 0 : file_len);
+    if ( fd == -1 ) {
+
+      result = RESULT_FILE_WRITE_ERROR;
+      goto END_PROCESS_FILE_SEND_V2;
+    }
+    temp_created = TRUE;
+  }
+
+  if ( ! process_ingest_init(&ingest, fd, FALSE, codec) ) {
+
+    result = RESULT_FILE_DECOMPRESS_ERROR;
+    goto END_PROCESS_FILE_SEND_V2;
+  }
+
+  // Sends an ACK message to client so that it starts sending the content
+  if ( ! pipelined ) {
+
+    ack = message_v2_ack( codec, ( resumable ) ? offset : -1, process_response_flags(proc_data), &ack_len );
+
+    if ( ! process_outgoing_message(proc_data->connection, ack, ack_len) ) {
+
+      LOGGER(__FUNCTION__, "ERROR: Acknowledgment message could not be sent.");
+
+      proc_data->keep_alive = FALSE;
+      goto END_PROCESS_FILE_SEND_V2_CONNECTION;
+    }
+  }
+  acknowledged = TRUE;
+
+  //
+  // Moves the uncompressed content straight into the file
+  //
+  if ( raw ) {
+
+    result = process_incoming_file_raw( proc_data->connection, fd, ( striped ) ? length : file_len - offset );
+
+    // The rest of the file may still be on its way, so
+    // the connection cannot be used for another request
+    if ( result != RESULT_SUCCESS ) {
+      proc_data->keep_alive = FALSE;
+    }
+    if ( result == RESULT_CONNECTION_ERROR ) {
+      goto END_PROCESS_FILE_SEND_V2_CONNECTION;
+    }
+    if ( result != RESULT_SUCCESS ) {
+      goto END_PROCESS_FILE_SEND_V2;
+    }
+
+    if ( striped ) {
+      goto END_PROCESS_FILE_SEND_V2_STRIPE;
+    }
+
+    if ( ftruncate(fd, file_len) != 0 || close(fd) != 0 ) {
+
+      fd = -1;
+      result = RESULT_FILE_WRITE_ERROR;
+      goto END_PROCESS_FILE_SEND_V2;
+    }
+    fd = -1;
+
+    goto END_PROCESS_FILE_SEND_V2_REPLACE;
+  }
+
+  //
+  // Unpacks the frames as they arrive, the rest of them
+  // is still received if the content turns out to be invalid
+  //
+  while ( TRUE ) {
+
+    if ( ! process_recv_all(proc_data, frame_len_value, V2_FRAME_LEN_SIZE) ) {
+
+      proc_data->keep_alive = FALSE;
+      goto END_PROCESS_FILE_SEND_V2_CONNECTION;
+    }
+
+    frame_len = GET_UINT32(frame_len_value);
+    if ( frame_len == 0 ) {
+      break;
+    }
+
+    while ( frame_len > 0 ) {
+
+      brecv = process_recv(proc_data, buffer, ( frame_len > INGEST_CHUNK_SIZE ) ? INGEST_CHUNK_SIZE : (int)frame_len );
+      if ( brecv < 0 ) {
+
+        proc_data->keep_alive = FALSE;
+        goto END_PROCESS_FILE_SEND_V2_CONNECTION;
+      }
+
+      frame_len -= brecv;
+
+      if ( result == RESULT_SUCCESS && ! process_ingest(&ingest, buffer, brecv) ) {
+
+        sprintf(l_msg, "ERROR: could not unpack file (%s).", filename);
+        LOGGER( __FUNCTION__, l_msg );
+
+        result = RESULT_FILE_DECOMPRESS_ERROR;
+      }
+    }
+  }
+
+  if ( result != RESULT_SUCCESS ) {
+    goto END_PROCESS_FILE_SEND_V2;
+  }
+
+  if ( ! process_ingest_end(&ingest) ) {
+
+    sprintf(l_msg, "ERROR: could not unpack file (%s).", filename);
+    LOGGER( __FUNCTION__, l_msg );
+
+    result = RESULT_FILE_DECOMPRESS_ERROR;
+    goto END_PROCESS_FILE_SEND_V2;
+  }
+
+  // The range must have unpacked to its length exactly
+  if ( striped ) {
+
+    if ( lseek(fd, 0, SEEK_CUR) != offset + length ) {
+
+      sprintf(l_msg, "ERROR: range of file %s does not have the expected length.", filename);
+      LOGGER( __FUNCTION__, l_msg );
+
+      result = RESULT_FILE_DECOMPRESS_ERROR;
+      goto END_PROCESS_FILE_SEND_V2;
+    }
+
+    goto END_PROCESS_FILE_SEND_V2_STRIPE;
+  }
+
+  // Releases the space reserved beyond the actual content
+  if ( ftruncate(fd, lseek(fd, 0, SEEK_CUR)) != 0 || close(fd) != 0 ) {
+
+    fd = -1;
+    result = RESULT_FILE_WRITE_ERROR;
+    goto END_PROCESS_FILE_SEND_V2;
+  }
+  fd = -1;
+
+  // The delta is applied to the current file, then removed
+  if ( block_size >= 0 ) {
+
+    result = process_delta_apply(filename, temp_filename, block_size, file_len, digest);
+    goto END_PROCESS_FILE_SEND_V2;
+  }
+
+END_PROCESS_FILE_SEND_V2_REPLACE:
+
+  // Moves the file into place, keeping a backup of the previous one
+  if ( ! file_replace(temp_filename, filename, TRUE) ) {
+
+    result = RESULT_FILE_WRITE_ERROR;
+    goto END_PROCESS_FILE_SEND_V2;
+  }
+  temp_created = FALSE;
+
+  sprintf(l_msg, "file was succesfully unpacked (%s).", filename);
+  LOGGER( __FUNCTION__, l_msg );
+
+  store_add(filename, digest);
+  cache_invalidate(filename);
+  goto END_PROCESS_FILE_SEND_V2;
+
+END_PROCESS_FILE_SEND_V2_STRIPE:
+
+  // The file of a striped transfer is kept for its other ranges,
+  // the range is recorded once it was written
+  if ( close(fd) != 0 || ! file_stripe_written(temp_filename, offset, length) ) {
+    result = RESULT_FILE_WRITE_ERROR;
+  }
+  fd = -1;
+
+END_PROCESS_FILE_SEND_V2:
+
+  // The temporary file is gone by the time the client gets its response,
+  // only the partial file of a transfer that lost its connection is kept
+  process_ingest_end(&ingest);
+
+  if ( fd != -1 ) {
+    close(fd);
+    fd = -1;
+  }
+  if ( temp_created == TRUE ) {
+    remove(temp_filename);
+    temp_created = FALSE;
+  }
+
+  // The content of a refused request of a pipeline is already on its way
+  if ( pipelined && ! acknowledged && ! committing &&
+       ! process_recv_content_discard(proc_data, flags, ( stripe != NULL ) ? length : ( has_size ) ? file_len : -1) ) {
+    proc_data->keep_alive = FALSE;
+  }
+
+  // Sends the response, in place of the ACK if the request was refused
+  response = message_v2_response( FILE_SND_B, result, process_response_flags(proc_data), &response_len );
+  process_response_begin( proc_data, response );
+
+  if ( !process_outgoing_message( proc_data->connection, response, response_len ) ) {
+    
+    LOGGER(__FUNCTION__, ( acknowledged ) ? "File Send response message could not be sent." : "File Send refusal could not be sent.");
+    proc_data->keep_alive = FALSE;
+  }
+
+  process_response_end( proc_data );
+
+END_PROCESS_FILE_SEND_V2_CONNECTION:
+
+  // Cleanup
+  process_ingest_end(&ingest);
+
+  if (fd != -1) {
+
+    // What reached the partial file is made durable for the next attempt
+    if (temp_created == TRUE && resumable == TRUE) {
+      fdatasync(fd);
+    }
+    close(fd);
+  }
+  if (temp_created == TRUE && resumable == TRUE) {
+
+    sprintf(l_msg, "Partial content of the transfer is kept in %s.", temp_filename);
+    LOGGER(__FUNCTION__, l_msg);
+  }
+  else if (temp_created == TRUE) {
+    remove(temp_filename);
+  }
+  if (response != NULL) {
+    free(response);
+  }
+  if (ack != NULL) {
+    free(ack);
+  }
+  if (filename != NULL) {
+    free(filename);
+  }
+  if (transfer != NULL) {
+    free(transfer);
+  }
+  if (stripe != NULL) {
+    free(stripe);
+  }
+
+  return;
+}
+
+/**
+ * Processes a V2 File Delete message from the client, 
+ * performs and finalizes the operation
+ *
+ * @param proc_data_arg           data structure with connection parameters 
+ *                                and received message
+ */
+void process_file_delete_v2( PROCESS_DATA_T * proc_data ) {
+
+  char * filename   = NULL;
+  char * response   = NULL;
+  char l_msg[4096];
+
+  unsigned long response_len  = 0;
+  int result = RESULT_UNDEFINED;
+
+  filename = process_get_param_v2( proc_data, TAG_FILENAME );
+  if ( filename == NULL ) {
+    result = RESULT_INVALID_REQUEST;
+  }
+  else {
+
+    sprintf(l_msg, "A request has been received to delete the file: %s", filename);
+    LOGGER(__FUNCTION__, l_msg);
+
+    if (file_exists(filename) == TRUE) {
+
+      result = ( file_delete(filename) == TRUE ) ? RESULT_SUCCESS : RESULT_FILE_DELETE_ERROR;
+      cache_invalidate(filename);
+    }
+    else {
+      result = RESULT_FILE_NOT_FOUND;
+    }
+
+    free(filename);
+  }
+
+  // Generates and sends response message
+  response = message_v2_response( FILE_DEL_B, result, process_response_flags(proc_data), &response_len );
+  process_response_begin( proc_data, response );
+
+  if ( !process_outgoing_message( proc_data->connection, response, response_len ) ) {
+    
+    LOGGER(__FUNCTION__, "File Delete response message could not be sent.");
+    proc_data->keep_alive = FALSE;
+  }
+
+  process_response_end( proc_data );
+
+  free(response);
+
+  return;
+}
+
+/**
+ * Sends a synchronous message through a connected node
+ * 
+ * @param connection            conexion on which the message will be sent
+ * @param outgoing_message      outgoing message
+ * @param outgoing_message_len  outgoing message length
+ *
+ * @return                      TRUE if message could be sent, otherwise FALSE
+ */ 
+int process_outgoing_message( SOCKET_T * connection, char * outgoing_message, int outgoing_message_len ) {
+
+  struct iovec iov;
+  long total_bytes_sent = 0;
+  int message_send_success;
+
+  iov.iov_base = outgoing_message;
+  iov.iov_len = outgoing_message_len;
+
+  // The header and the rest of the message leave together
+  message_send_success = process_outgoing_vector(connection, &iov, 1);
+
+  // If an error occurred or operation timed out
+  if ( ! message_send_success ) {
+  
+    char log[_BUFFER_SIZE_L];
+    memset(log, 0x00, _BUFFER_SIZE_L);
+
+    total_bytes_sent = outgoing_message_len - (long)iov.iov_len;
+
+    strcpy( log, "Failed while attempting to send the following message: ");
+    if (outgoing_message_len >= _BUFFER_SIZE_L) {
+      memcpy(log, outgoing_message, _BUFFER_SIZE_L - 1);
+    }
+    else {
+      memcpy(log, outgoing_message, outgoing_message_len);
+    }
+    LOGGER(__FUNCTION__, log);
+    
+    sprintf( log, "[Number of bytes sent:%ld]", total_bytes_sent );
+    LOGGER(__FUNCTION__, log);
+  }
+
+  return message_send_success;
+    
+}
+
+/**
+ * State of the content of a message while it is sent
+ */
+typedef struct _process_egress_t {
+
+  SOCKET_T * connection;
+  BASE64_STREAM_T b64_stream;
+
+  int format;
+  int send_error;
+  unsigned long long sent;
+
+  // Flight the content is produced for, or NULL
+  FLIGHT_T * flight;
+
+  // Content waiting to be sent, preceded by room
+  // for the frame length when the content is chunked
+  int frame_len;
+  char frame[SIZE_LEN + EGRESS_FRAME_SIZE];
+
+} PROCESS_EGRESS_T;
+
+/**
+ * Sends data through a connection, waiting for the socket to accept
+ * more while the connection keeps making progress
+ *
+ * @param connection            conexion on which the data will be sent
+ * @param data                  data to send
+ * @param len                   data length
+ *
+ * @return                      TRUE if data could be sent, otherwise FALSE
+ */
+int process_outgoing_data( SOCKET_T * connection, const char * data, int len ) {
+
+  struct iovec iov;
+
+  iov.iov_base = (char *)data;
+  iov.iov_len = len;
+
+  return process_outgoing_vector(connection, &iov, 1);
+}
+
+/**
+ * Sends several buffers through a connection, as many bytes as the socket
+ * takes in each call. It waits for the socket to accept more only once it
+ * is full, while the connection keeps making progress. Large sends are made
+ * without copying the buffers where the system allows it, the function then
+ * returning once the kernel released them.
+ *
+ * @param connection            conexion on which the data will be sent
+ * @param iov                   buffers to send, updated to what is left
+ * @param iov_count             number of buffers
+ *
+ * @return                      TRUE if data could be sent, otherwise FALSE
+ */
+int process_outgoing_vector( SOCKET_T * connection, struct iovec * iov, int iov_count ) {
+
+  unsigned long exec_timeout = GetTickCount() + gl_timeout;
+  unsigned long long len = 0;
+  int zerocopy;
+  int bsent;
+  int i;
+
+  for ( i = 0; i < iov_count; i++ ) {
+    len += iov[i].iov_len;
+  }
 
-  char * request  = NULL;
-  char * response = NULL;
+  zerocopy = ( len >= S_ZEROCOPY_MIN );
 
-  int search_path_res         = 0;
-  int search_length_res       = 0;
-  int search_content_res      = 0;
+  while ( len > 0 && abort_processes == FALSE ) {
 
-  unsigned long response_len  = 0;
+    // If operation timed out cancel
+    if ( GetTickCount() > exec_timeout ) {
 
-  char destination_dir[2048];
-  char l_msg[4096];
+      LOGGER(__FUNCTION__, "ERROR: Message transfer operation timed out.");
+      return FALSE;
+    }
 
-  int result = RESULT_UNDEFINED;  
-    
-  unsigned long content_len = 0;
-  int param_path_len = 0;//= (proc_data->received_msg_len - HEADER_LEN - strlen(PARAM_PATH));
- 
-  // Copies the request to a safe buffer for searching
-  request = (char*)malloc(sizeof(char) * proc_data->received_msg_len + 1);
-  memcpy(request, proc_data->received_message, proc_data->received_msg_len);
-  request[proc_data->received_msg_len] = '\0';
+    if ( ! SOCKET_SENDV(connection, iov, iov_count, zerocopy, &bsent) ) {
 
-  // Finds parameters positions
-  search_path_res         = STR_SEARCH( request, PARAM_PATH, HEADER_LEN);
-  search_length_res       = STR_SEARCH( request, PARAM_LENGTH, HEADER_LEN);
-  search_content_res      = STR_SEARCH( proc_data->received_message, PARAM_CONTENT, HEADER_LEN);
+      LOGGER(__FUNCTION__, "ERROR: A connection problem occurred while attempting to send message." );
+      return FALSE;
+    }
+
+    if ( bsent > 0 ) {
+
+      // Updates moment of next timeout
+      exec_timeout = GetTickCount() + gl_timeout;
+      len -= bsent;
+
+      // Skips the buffers sent and the part sent of the next one
+      while ( iov_count > 0 && (size_t)bsent >= iov->iov_len ) {
+
+        bsent -= iov->iov_len;
+        iov->iov_len = 0;
+        iov++;
+        iov_count--;
+      }
+
+      if ( iov_count > 0 ) {
+
+        iov->iov_base = (char *)iov->iov_base + bsent;
+        iov->iov_len -= bsent;
+      }
+
+    } else {
+
+      // The socket is full, the releases of the buffers sent without
+      // copying are reported as errors that would end the wait at once
+      if ( zerocopy ) {
+        SOCKET_ZEROCOPY_WAIT(connection, 0);
+      }
+
+      SOCKET_SELECT(S_TIMEOUT, connection, S_WRITE);
+    }
 
-  if (search_path_res == NOT_FOUND || search_length_res == NOT_FOUND || search_content_res == NOT_FOUND) {
-    
-    result = RESULT_INVALID_REQUEST;
-    goto END_PROCESS_FILE_SEND;
   }
 
-  param_path_len = ( search_length_res - ( HEADER_LEN + strlen(MSG_SEPARATOR) + strlen(PARAM_PATH) ) );
+  if ( len > 0 ) {
+    return FALSE;
+  }
 
-  // Gets name of file to receive
-  filename = (char*)malloc(sizeof(char) * param_path_len + 1);  
-  memcpy(filename, &request[search_path_res + strlen(PARAM_PATH)], param_path_len);
-  filename[param_path_len] = '\0';
+  // The buffers belong to the caller again once the kernel released them
+  if ( zerocopy && ! SOCKET_ZEROCOPY_WAIT(connection, gl_timeout) ) {
 
-  sprintf(l_msg, "A request has been received to receive the file: %s", filename);
-  LOGGER(__FUNCTION__, l_msg);
-  
-  //
-  // Gets content length
-  //
-  content_len = atoi( &( proc_data->received_message[ ( search_length_res + strlen(PARAM_LENGTH) ) ] ) );
-  if (content_len == 0) {
+    LOGGER(__FUNCTION__, "ERROR: Buffers sent without copying were not released in time." );
+    return FALSE;
+  }
 
-    result = RESULT_INVALID_REQUEST;
-    goto END_PROCESS_FILE_SEND;
+  return TRUE;
+}
+
+/**
+ * Sends the encoded content accumulated in the frame
+ *
+ * @param egress                  state of the content being sent
+ *
+ * @return                        TRUE or FALSE
+ */
+static int process_egress_flush( PROCESS_EGRESS_T * egress ) {
+
+  char frame_len[SIZE_LEN + 1];
+  char * data = &egress->frame[SIZE_LEN];
+  int len = egress->frame_len;
+
+  if ( len == 0 ) {
+    return TRUE;
   }
 
-  //
-  // Gets content
-  //
-  content = (char*)malloc(sizeof(char) * content_len + 1);
-  memcpy(content, &(proc_data->received_message[ ( search_content_res + strlen(PARAM_CONTENT) ) ]), content_len);
-  content[content_len] = '\0';
-  
-  // Makes a backup copy if file exists
-  if (file_exists(filename) == TRUE) {
-  
-    char new_name[2048];    
-    sprintf(new_name, "%s.bkp", filename);
-  
-    if ( ! file_copy(filename, new_name, TRUE) ) {
-    
-      sprintf(l_msg, "ERROR: Could not make backup copy of file (%s).", filename);
-      LOGGER(__FUNCTION__, l_msg);
-    
+  // Prepends the frame length
+  if ( egress->format == CONTENT_ENCODED_CHUNKED ) {
+
+    sprintf(frame_len, "%08x", (unsigned int)len);
+    memcpy(egress->frame, frame_len, SIZE_LEN);
+
+    data = egress->frame;
+    len += SIZE_LEN;
+  }
+  else if ( egress->format == CONTENT_BINARY_CHUNKED ) {
+
+    data = &egress->frame[SIZE_LEN - V2_FRAME_LEN_SIZE];
+    PUT_UINT32(data, (unsigned long)len);
+
+    len += V2_FRAME_LEN_SIZE;
+  }
+
+  if ( ! egress->send_error && ! process_outgoing_data(egress->connection, data, len) ) {
+    egress->send_error = TRUE;
+  }
+
+  // The content is still produced for the requests following the flight
+  if ( egress->send_error && ( egress->flight == NULL || ! flight_shared(egress->flight) ) ) {
+    return FALSE;
+  }
+
+  if ( egress->flight != NULL ) {
+    flight_write(egress->flight, data, (unsigned long)len);
+  }
+
+  egress->sent += egress->frame_len;
+  egress->frame_len = 0;
+
+  return TRUE;
+}
+
+/**
+ * Writer for deflated content being sent, encodes it
+ * if needed and sends it every time a frame is filled
+ *
+ * @param arg                     state of the content being sent
+ * @param data                    deflated data
+ * @param len                     data length
+ *
+ * @return                        TRUE or FALSE
+ */
+static int process_egress_write( void * arg, const unsigned char * data, size_t len ) {
+
+  PROCESS_EGRESS_T * egress = (PROCESS_EGRESS_T *)arg;
+  int part;
+
+  while ( len > 0 ) {
+
+    // Takes as much as fits the space left in the frame once encoded
+    if ( egress->format == CONTENT_BINARY_CHUNKED ) {
+      part = EGRESS_FRAME_SIZE - egress->frame_len;
     }
-    
+    else {
+      part = ( EGRESS_FRAME_SIZE - egress->frame_len ) / 4 * 3 - 2;
+    }
+    if ( part <= 0 ) {
+
+      if ( ! process_egress_flush(egress) ) {
+        return FALSE;
+      }
+      continue;
+    }
+    if ( (size_t)part > len ) {
+      part = (int)len;
+    }
+
+    if ( egress->format == CONTENT_BINARY_CHUNKED ) {
+
+      memcpy(&egress->frame[SIZE_LEN + egress->frame_len], data, part);
+      egress->frame_len += part;
+    }
+    else {
+      egress->frame_len += BASE64_ENCODE_STREAM(&egress->b64_stream, data, part, &egress->frame[SIZE_LEN + egress->frame_len]);
+    }
+
+    data += part;
+    len -= part;
   }
-  
-  // Prepares directories
-  file_get_base_path(filename, destination_dir);
-  if (destination_dir != NULL)
-  {
-    // If destination directory is not root
-    if (strcmp(destination_dir, ROOT_DIR) != 0 ) {
 
-      if ( ! file_directory_exists(destination_dir)) {
+  return TRUE;
+}
+
+/**
+ * Writer that stores compressed content in a spool file
+ *
+ * @param arg                     spool file
+ * @param data                    compressed data
+ * @param len                     data length
+ *
+ * @return                        TRUE or FALSE
+ */
+static int process_egress_spool( void * arg, const unsigned char * data, size_t len ) {
+
+  return ( fwrite(data, 1, len, (FILE *)arg) == len );
+}
+
+/**
+ * Compresses a file from its current position, passing the output to the writer
+ *
+ * @param fd                      file descriptor
+ * @param len                     number of bytes to compress, or -1 up to
+ *                                the end of the file
+ * @param codec                   codec, or EGRESS_STORED for content
+ *                                already compressed
+ * @param mode                    compression mode, GZ_MODE_*
+ * @param writer                  function that receives the output
+ * @param writer_arg              argument for the writer
+ *
+ * @return                        RESULT_SUCCESS, RESULT_FILE_READ_ERROR
+ *                                or RESULT_FILE_COMPRESS_ERROR
+ */
+static int process_egress_compress( int fd, long long len, int codec, int mode, CODEC_WRITER_T writer, void * writer_arg ) {
+
+  unsigned char buffer[EGRESS_CHUNK_SIZE];
+  CODEC_STREAM_T codec_stream;
+  struct stat info;
+  unsigned long long remaining = (unsigned long long)len;
+  size_t chunk;
+  ssize_t bread;
+  int result = RESULT_SUCCESS;
+
+  // Large gzip content is deflated in blocks by the cores in parallel
+  if ( codec == CODEC_GZIP ) {
+
+    if ( len < 0 && fstat(fd, &info) == 0 ) {
+      remaining = (unsigned long long)( info.st_size - lseek(fd, 0, SEEK_CUR) );
+    }
+
+    if ( gz_parallel_available(remaining, codec_level(codec, mode)) ) {
+
+      return ( gz_deflate_parallel(fd, len, codec_level(codec, mode), writer, writer_arg) ) ?
+             RESULT_SUCCESS : RESULT_FILE_COMPRESS_ERROR;
+    }
+  }
+
+  if ( codec != EGRESS_STORED && ! codec_compress_init(&codec_stream, codec, mode) ) {
+    return RESULT_FILE_COMPRESS_ERROR;
+  }
+
+  do {
+
+    // A range ends as the end of the file would
+    chunk = ( len >= 0 && len < EGRESS_CHUNK_SIZE ) ? (size_t)len : EGRESS_CHUNK_SIZE;
+
+    // A read interrupted by a signal is tried again, only the end of
+    // the file or an actual error ends the content
+    do {
+      bread = ( chunk > 0 ) ? read(fd, buffer, chunk) : 0;
+    } while ( bread < 0 && errno == EINTR );
+
+    if ( bread < 0 ) {
+
+      result = RESULT_FILE_READ_ERROR;
+      break;
+    }
+
+    if ( len > 0 ) {
+      len -= bread;
+    }
+
+    if ( codec == EGRESS_STORED ) {
+
+      if ( bread > 0 && ! writer(writer_arg, buffer, (size_t)bread) ) {
+
+        result = RESULT_FILE_COMPRESS_ERROR;
+        break;
+      }
+    }
+    else if ( ! codec_compress(&codec_stream, buffer, bread, ( bread == 0 ), writer, writer_arg) ) {
+
+      result = RESULT_FILE_COMPRESS_ERROR;
+      break;
+    }
+
+  } while ( bread > 0 && abort_processes == FALSE );
+
+  if ( codec != EGRESS_STORED && ! codec_end(&codec_stream) && result == RESULT_SUCCESS ) {
+    result = RESULT_FILE_COMPRESS_ERROR;
+  }
+
+  return result;
+}
+
+/**
+ * Deflates a file once into an anonymous spool file, for the V1 messages
+ * whose header gives the length of the content, which is then sent from
+ * the spool with EGRESS_STORED instead of deflating the file again
+ *
+ * @param fd                      file descriptor
+ * @param mode                    compression mode, GZ_MODE_*
+ * @param spool                   returns the spool, rewound, to be closed
+ *                                by the caller
+ * @param content_len             returns the content length once encoded
+ *
+ * @return                        RESULT_SUCCESS, RESULT_FILE_READ_ERROR,
+ *                                RESULT_FILE_WRITE_ERROR or
+ *                                RESULT_FILE_COMPRESS_ERROR
+ */
+int process_spool_file( int fd, int mode, FILE ** spool, unsigned long long * content_len ) {
+
+  long deflated_len;
+  int result;
+
+  *content_len = 0;
+
+  *spool = tmpfile();
+  if ( *spool == NULL ) {
+    return RESULT_FILE_WRITE_ERROR;
+  }
+
+  result = process_egress_compress(fd, -1, CODEC_GZIP, mode, &process_egress_spool, *spool);
+  if ( result == RESULT_SUCCESS && fflush(*spool) != 0 ) {
+    result = RESULT_FILE_WRITE_ERROR;
+  }
+
+  if ( result == RESULT_SUCCESS ) {
+
+    deflated_len = ftell(*spool);
+    if ( deflated_len < 0 || lseek(fileno(*spool), 0, SEEK_SET) != 0 ) {
+      result = RESULT_FILE_READ_ERROR;
+    }
+    else {
+      *content_len = BASE64_ENCODE_STREAM_SIZE((unsigned long long)deflated_len);
+    }
+  }
+
+  if ( result != RESULT_SUCCESS ) {
+
+    fclose(*spool);
+    *spool = NULL;
+  }
+
+  return result;
+}
+
+/**
+ * Sends a file as the content of a message, compressed and, for V1, encoded
+ * in fragments as it is read. The parameters preceding it must be already sent.
+ *
+ * @param connection              conexion on which the content will be sent
+ * @param fd                      file descriptor
+ * @param format                  CONTENT_ENCODED, CONTENT_ENCODED_CHUNKED
+ *                                or CONTENT_BINARY_CHUNKED
+ * @param codec                   codec, CODEC_GZIP for V1
+ * @param mode                    compression mode, GZ_MODE_*
+ * @param content_len             returns the length of the content sent,
+ *                                frame lengths not included
+ *
+ * @return                        RESULT_SUCCESS, RESULT_FILE_READ_ERROR,
+ *                                RESULT_FILE_COMPRESS_ERROR or
+ *                                RESULT_CONNECTION_ERROR
+ */
+int process_outgoing_file( SOCKET_T * connection, int fd, int format, int codec, int mode, unsigned long long * content_len ) {
+
+  return process_outgoing_file_range( connection, fd, -1, format, codec, mode, content_len );
+}
+
+/**
+ * Sends a byte range of a file as the content of a message, as
+ * process_outgoing_file_range() does, capturing what is sent for
+ * the requests following it. The content is still produced for them
+ * if the connection is lost.
+ *
+ * @param connection              conexion on which the content will be sent
+ * @param fd                      file descriptor
+ * @param len                     number of bytes to send, or -1 up to the
+ *                                end of the file
+ * @param format                  CONTENT_ENCODED, CONTENT_ENCODED_CHUNKED
+ *                                or CONTENT_BINARY_CHUNKED
+ * @param codec                   codec, CODEC_GZIP for V1
+ * @param mode                    compression mode, GZ_MODE_*
+ * @param flight                  flight the request leads, or NULL
+ * @param content_len             returns the length of the content sent,
+ *                                frame lengths not included
+ *
+ * @return                        RESULT_SUCCESS, RESULT_FILE_READ_ERROR,
+ *                                RESULT_FILE_COMPRESS_ERROR or
+ *                                RESULT_CONNECTION_ERROR
+ */
+int process_outgoing_file_capture( SOCKET_T * connection, int fd, long long len, int format, int codec, int mode, FLIGHT_T * flight, unsigned long long * content_len ) {
+
+  static const char frame_end[V2_FRAME_LEN_SIZE] = { 0, 0, 0, 0 };
+
+  PROCESS_EGRESS_T * egress;
+  const char * trailer = NULL;
+  int trailer_len = 0;
+  int result;
+
+  egress = (PROCESS_EGRESS_T *)malloc(sizeof(PROCESS_EGRESS_T));
+  memset(egress, 0x00, offsetof(PROCESS_EGRESS_T, frame));
+  egress->connection = connection;
+  egress->format = format;
+  egress->flight = flight;
+
+  BASE64_ENCODE_STREAM_INIT(&egress->b64_stream);
+
+  result = process_egress_compress(fd, len, codec, mode, &process_egress_write, egress);
+  if ( result == RESULT_SUCCESS ) {
+
+    if ( format != CONTENT_BINARY_CHUNKED ) {
+      egress->frame_len += BASE64_ENCODE_STREAM_END(&egress->b64_stream, &egress->frame[SIZE_LEN + egress->frame_len]);
+    }
+
+    if ( format == CONTENT_ENCODED_CHUNKED ) {
+
+      trailer = CHUNK_END;
+      trailer_len = SIZE_LEN;
+    }
+    else if ( format == CONTENT_BINARY_CHUNKED ) {
+
+      trailer = frame_end;
+      trailer_len = V2_FRAME_LEN_SIZE;
+    }
+
+    // Sends what is left and the frame that ends a chunked content
+    if ( ! process_egress_flush(egress) ) {
+
+      result = RESULT_CONNECTION_ERROR;
+    }
+    else {
+
+      if ( flight != NULL ) {
+
+        if ( trailer != NULL ) {
+          flight_write(flight, trailer, (unsigned long)trailer_len);
+        }
+        flight_complete(flight);
+      }
+
+      if ( egress->send_error || ( trailer != NULL && ! process_outgoing_data(connection, trailer, trailer_len) ) ) {
+        result = RESULT_CONNECTION_ERROR;
+      }
+    }
+  }
+  else if ( egress->send_error ) {
+
+    result = RESULT_CONNECTION_ERROR;
+  }
+
+  *content_len = egress->sent;
+  free(egress);
+
+  return result;
+}
+
+/**
+ * Sends a byte range of a file as the content of a message, starting at
+ * the current position, compressed and, for V1, encoded in fragments as
+ * it is read. The parameters preceding it must be already sent.
+ *
+ * @param connection              conexion on which the content will be sent
+ * @param fd                      file descriptor
+ * @param len                     number of bytes to send, or -1 up to the
+ *                                end of the file
+ * @param format                  CONTENT_ENCODED, CONTENT_ENCODED_CHUNKED
+ *                                or CONTENT_BINARY_CHUNKED
+ * @param codec                   codec, CODEC_GZIP for V1
+ * @param mode                    compression mode, GZ_MODE_*
+ * @param content_len             returns the length of the content sent,
+ *                                frame lengths not included
+ *
+ * @return                        RESULT_SUCCESS, RESULT_FILE_READ_ERROR,
+ *                                RESULT_FILE_COMPRESS_ERROR or
+ *                                RESULT_CONNECTION_ERROR
+ */
+int process_outgoing_file_range( SOCKET_T * connection, int fd, long long len, int format, int codec, int mode, unsigned long long * content_len ) {
+
+  return process_outgoing_file_capture( connection, fd, len, format, codec, mode, NULL, content_len );
+}
+
+// V2 content packed in memory before being sent
+typedef struct _process_packed_t {
+
+  char * data;
+  unsigned long len;
+  unsigned long size;
+
+  // Offset of the length of the frame being filled, and its length
+  unsigned long frame;
+  int frame_len;
+  int framed;
+
+} PROCESS_PACKED_T;
+
+/**
+ * Makes room in packed content
+ *
+ * @param packed                  packed content
+ * @param len                     number of bytes to append
+ *
+ * @return                        TRUE or FALSE
+ */
+static int process_packed_reserve( PROCESS_PACKED_T * packed, unsigned long len ) {
+
+  char * data;
+  unsigned long size = ( packed->size > 0 ) ? packed->size : EGRESS_CHUNK_SIZE;
+
+  while ( packed->len + len > size ) {
+    size *= 2;
+  }
+
+  if ( size != packed->size ) {
+
+    data = (char *)realloc(packed->data, size);
+    if ( data == NULL ) {
+      return FALSE;
+    }
+
+    packed->data = data;
+    packed->size = size;
+  }
+
+  return TRUE;
+}
+
+/**
+ * Writer for compressed content packed in memory,
+ * which it splits in frames as the egress does
+ *
+ * @param arg                     packed content
+ * @param data                    compressed data
+ * @param len                     data length
+ *
+ * @return                        TRUE or FALSE
+ */
+static int process_packed_write( void * arg, const unsigned char * data, size_t len ) {
+
+  PROCESS_PACKED_T * packed = (PROCESS_PACKED_T *)arg;
+  int part;
+
+  while ( len > 0 ) {
+
+    // Begins a frame, ending the one filled
+    if ( ! packed->framed || packed->frame_len == EGRESS_FRAME_SIZE ) {
+
+      if ( packed->framed ) {
+        PUT_UINT32(&packed->data[packed->frame], (unsigned long)packed->frame_len);
+      }
+      if ( ! process_packed_reserve(packed, V2_FRAME_LEN_SIZE) ) {
+        return FALSE;
+      }
+
+      packed->frame = packed->len;
+      packed->frame_len = 0;
+      packed->framed = TRUE;
+      packed->len += V2_FRAME_LEN_SIZE;
+    }
 
-        if ( ! file_mkdir_parent(destination_dir) ) {
+    part = EGRESS_FRAME_SIZE - packed->frame_len;
+    if ( (size_t)part > len ) {
+      part = (int)len;
+    }
 
-          result = RESULT_COULD_NOT_CREATE_DESTINATION_DIRECTORY;
-          goto END_PROCESS_FILE_SEND;
-        }
-      }
+    if ( ! process_packed_reserve(packed, part) ) {
+      return FALSE;
     }
-  }
-  else {
-      
-    sprintf(l_msg, "ERROR: The directory specified for the file %s is not valid.", filename);
-    LOGGER(__FUNCTION__, l_msg);
 
-    result = RESULT_INVALID_DESTINATION_DIRECTORY;
-    goto END_PROCESS_FILE_SEND;
+    memcpy(&packed->data[packed->len], data, part);
+    packed->len += part;
+    packed->frame_len += part;
+
+    data += part;
+    len -= part;
   }
 
-  //
-  // Writes base64 to a file, then decodes and unpacks file
-  //
-  {    
-    char b64_filename[2048];
-    char gz_filename[2048];
-    FILE * f = NULL; 
-    
-    sprintf(b64_filename, "%s.b64", filename);
-    sprintf(gz_filename, "%s.gz", filename);
+  return TRUE;
+}
 
-    f = fopen(b64_filename, "w");
-    if (f != NULL) {
-      fwrite( content, sizeof(char), content_len, f );
-      fclose(f);
+/**
+ * Packs a file in memory as the V2 content frames that process_outgoing_file
+ * would send, so that it can be compressed ahead of being sent
+ *
+ * @param fd                      file descriptor
+ * @param codec                   codec
+ * @param mode                    compression mode, GZ_MODE_*
+ * @param content                 returns the content, must be free()'d after usage
+ * @param content_len             returns the content length
+ *
+ * @return                        RESULT_SUCCESS, RESULT_FILE_READ_ERROR
+ *                                or RESULT_FILE_COMPRESS_ERROR
+ */
+int process_pack_file( int fd, int codec, int mode, char ** content, unsigned long * content_len ) {
 
-      if ( base64_process_file( 'd', b64_filename, gz_filename, content_len ) ) {
-    
-        if ( gz_unpack_file(gz_filename, filename) ) {
-      
-          sprintf(l_msg, "file was succesfully unpacked (%s).", gz_filename);
-          LOGGER( __FUNCTION__, l_msg );
+  PROCESS_PACKED_T packed;
+  int result;
 
-          result = RESULT_SUCCESS;
+  memset(&packed, 0x00, sizeof(PROCESS_PACKED_T));
 
-        }
-        else {
+  result = process_egress_compress(fd, -1, codec, mode, &process_packed_write, &packed);
 
-          sprintf(l_msg, "ERROR: could not unpack file (%s).", gz_filename);
-          LOGGER( __FUNCTION__, l_msg );
+  // Ends the last frame and the content
+  if ( result == RESULT_SUCCESS ) {
 
-          result = RESULT_FILE_DECOMPRESS_ERROR;
-        }      
-      
-      }
-      else {
-    
-        sprintf(l_msg, "ERROR: could not decode file (%s).", b64_filename);
-        LOGGER( __FUNCTION__, l_msg );
+    if ( packed.framed ) {
+      PUT_UINT32(&packed.data[packed.frame], (unsigned long)packed.frame_len);
+    }
 
-        result = RESULT_FILE_DECODE_ERROR;
-      }
-    
-      // Delete generated temporary files
-      if ( file_exists(b64_filename) ) {
-        remove(b64_filename);
-      }
-    
-      if ( file_exists(gz_filename) ) {
-        remove(gz_filename);
-      }
+    if ( process_packed_reserve(&packed, V2_FRAME_LEN_SIZE) ) {
 
+      memset(&packed.data[packed.len], 0x00, V2_FRAME_LEN_SIZE);
+      packed.len += V2_FRAME_LEN_SIZE;
+    }
+    else {
+      result = RESULT_FILE_COMPRESS_ERROR;
     }
-    
   }
-  
-END_PROCESS_FILE_SEND:
 
-  // Generates a response message
-  response = message_file_send_response( result, &response_len );  
+  if ( result != RESULT_SUCCESS ) {
 
-  // Sends the response
-  if ( !process_outgoing_message( proc_data->connection, response, response_len ) ) {
-    
-    LOGGER(__FUNCTION__, "File Receive operation response message could not be sent.");
+    free(packed.data);
+    packed.data = NULL;
+    packed.len = 0;
   }
 
-  // Cleanup
-  if (request != NULL) {
-    free(request);
-  }
-  if (response != NULL) {
-    free(response);
-  }
-  if (filename != NULL) {
-    free(filename);
-  }
-  if (content != NULL) {
-    free(content);
-  }
+  *content = packed.data;
+  *content_len = packed.len;
 
-  return;
+  return result;
 }
 
 /**
- * Processes a File Delete message from the client, 
- * performs and finalizes the operation
+ * Sends a file uncompressed as the content of a message, straight from
+ * the page cache to the socket. The parameters preceding it must be
+ * already sent.
  *
- * @param proc_data_arg           data structure with connection parameters 
- *                                and received message
+ * @param connection              conexion on which the content will be sent
+ * @param fd                      file descriptor
+ * @param len                     number of bytes to send from the current position
+ *
+ * @return                        RESULT_SUCCESS, RESULT_FILE_READ_ERROR if
+ *                                the file turned out to be shorter, or
+ *                                RESULT_CONNECTION_ERROR
  */
-void process_file_delete( PROCESS_DATA_T * proc_data ) {
+int process_outgoing_file_raw( SOCKET_T * connection, int fd, long long len ) {
 
-  const int NOT_FOUND = -1;
+  unsigned long exec_timeout = GetTickCount() + gl_timeout;
+  long long offset;
+  long long total = 0;
+  struct stat info;
+  int bsent;
 
-  char * filename   = NULL;
-  char l_msg[4096];
+  offset = lseek(fd, 0, SEEK_CUR);
+  if ( offset < 0 ) {
+    return RESULT_FILE_READ_ERROR;
+  }
 
-  char * request    = NULL;
-  char * response   = NULL;
+  while ( total < len && abort_processes == FALSE ) {
 
-  unsigned long response_len  = 0;
-  int search_filename_res     = 0;
+    // If operation timed out cancel
+    if ( GetTickCount() > exec_timeout ) {
 
-  int result = RESULT_UNDEFINED;
-  const int param_len = (proc_data->received_msg_len - HEADER_LEN - strlen(PARAM_FILENAME));
+      LOGGER(__FUNCTION__, "ERROR: Message transfer operation timed out.");
+      return RESULT_CONNECTION_ERROR;
+    }
 
-  // Copies the request to a safe buffer for searching
-  request = (char*)malloc(sizeof(char) * proc_data->received_msg_len + 1);
-  memcpy(request, proc_data->received_message, proc_data->received_msg_len);
-  request[proc_data->received_msg_len] = '\0';
+    if ( SOCKET_SELECT(S_TIMEOUT, connection, S_WRITE) == S_WRITE ) {
 
-  // Gets name of file to delete
-  search_filename_res = STR_SEARCH( proc_data->received_message, PARAM_FILENAME, HEADER_LEN);
-  if ( search_filename_res == NOT_FOUND ) {
+      if ( ! SOCKET_SENDFILE(connection, fd, &offset, ( len - total > EGRESS_RAW_SIZE ) ? EGRESS_RAW_SIZE : (int)( len - total ), &bsent) ) {
 
-    result = RESULT_INVALID_REQUEST;
-    goto END_PROCESS_FILE_DELETE;
-  }
+        LOGGER(__FUNCTION__, "ERROR: A connection problem occurred while attempting to send message." );
+        return RESULT_CONNECTION_ERROR;
+      }
 
-  filename = (char*)malloc(sizeof(char) * proc_data->received_msg_len);
-  memcpy( filename, &(request[ ( search_filename_res + strlen(PARAM_FILENAME) ) ]), param_len );
-  filename[param_len] = '\0';
-  
-  sprintf(l_msg, "A request has been received to delete the file: %s", filename);
-  LOGGER(__FUNCTION__, l_msg);
-  
-  if (file_exists(filename) == TRUE) {
-  
-    if (file_delete(filename) == TRUE) {
-    
-      result = RESULT_SUCCESS;
+      if ( bsent > 0 ) {
+
+        // Updates moment of next timeout
+        exec_timeout = GetTickCount() + gl_timeout;
+        total += bsent;
+      }
+      else if ( fstat(fd, &info) != 0 || info.st_size <= offset ) {
+
+        LOGGER(__FUNCTION__, "ERROR: file ended before the expected length.");
+        return RESULT_FILE_READ_ERROR;
+      }
     }
-    else {
-      result = RESULT_FILE_DELETE_ERROR;
-    }    
-  }
-  else {
-    result = RESULT_FILE_NOT_FOUND;
-  }
-    
-  // Generates response message
-  response = message_file_delete_response( result, &response_len );  
 
-  // Sends response message
-  if ( !process_outgoing_message( proc_data->connection, response, response_len ) ) {
-    
-    LOGGER(__FUNCTION__, "File Receive response message could not be sent.");
   }
 
-END_PROCESS_FILE_DELETE:
+  return ( total == len ) ? RESULT_SUCCESS : RESULT_CONNECTION_ERROR;
+}
 
-  // Cleanup
-  if (request != NULL) {
-    free(request);
+/**
+ * Sends the content of a file kept in the cache, from memory or
+ * from the file of the disk tier, after the parameters preceding it.
+ * Content kept in memory leaves in the same calls as the parameters.
+ *
+ * @param connection              conexion on which the content will be sent
+ * @param response                parameters preceding the content
+ * @param response_len            parameters length
+ * @param entry                   entry of the cache
+ *
+ * @return                        RESULT_SUCCESS, RESULT_FILE_READ_ERROR
+ *                                or RESULT_CONNECTION_ERROR
+ */
+int process_outgoing_cached( SOCKET_T * connection, const char * response, int response_len, CACHE_ENTRY_T * entry ) {
+
+  struct iovec iov[2];
+  int result;
+  int fd;
+
+  if ( entry->tier == CACHE_TIER_MEMORY ) {
+
+    iov[0].iov_base = (char *)response;
+    iov[0].iov_len = response_len;
+    iov[1].iov_base = entry->data;
+    iov[1].iov_len = entry->len;
+
+    return process_outgoing_vector(connection, iov, 2) ? RESULT_SUCCESS : RESULT_CONNECTION_ERROR;
   }
-  if (response != NULL) {
-    free(response);
+
+  fd = open(entry->disk_path, O_RDONLY);
+  if ( fd == -1 ) {
+    return RESULT_FILE_READ_ERROR;
   }
-  if (filename != NULL) {
-    free(filename);
+
+  if ( ! process_outgoing_data(connection, response, response_len) ) {
+    result = RESULT_CONNECTION_ERROR;
+  } else {
+    result = process_outgoing_file_raw(connection, fd, (long long)entry->len);
   }
 
-  return;
+  close(fd);
+
+  return result;
 }
 
 /**
- * Sends a synchronous message through a connected node
- * 
- * @param connection            conexion on which the message will be sent
- * @param outgoing_message      outgoing message
- * @param outgoing_message_len  outgoing message length
+ * Sends the content of a file produced by the leader of a flight, as it is
+ * produced. The parameters preceding it must be already sent.
  *
- * @return                      TRUE if message could be sent, otherwise FALSE
- */ 
-int process_outgoing_message( SOCKET_T * connection, char * outgoing_message, int outgoing_message_len ) {
+ * @param connection              conexion on which the content will be sent
+ * @param flight                  flight the request follows
+ * @param content_len             returns the length of the content sent
+ *
+ * @return                        RESULT_SUCCESS, RESULT_FILE_COMPRESS_ERROR
+ *                                if the leader could not produce it,
+ *                                or RESULT_CONNECTION_ERROR
+ */
+int process_outgoing_flight( SOCKET_T * connection, FLIGHT_T * flight, unsigned long long * content_len ) {
 
-  int bsent = 0;
-  int selectval = 0;  
-  
-  long total_bytes_sent = 0;
-  long total_bytes_left = 0;
-  long chunk_size = HEADER_LEN;
-  
-  int send_error = FALSE;
-  int timed_out = FALSE;
-  int message_send_success = FALSE;    
-  unsigned long exec_timeout = 0;
-  char * progress;
-  
-  // Updates moment for next timeout
-  exec_timeout = GetTickCount() + gl_timeout;
+  char * buffer;
+  long bread;
+  int result = RESULT_SUCCESS;
 
-  // Send message loop
-  while ( selectval != S_WRITE && abort_processes == FALSE ) {
+  *content_len = 0;
+  buffer = (char *)malloc(EGRESS_FLIGHT_SIZE);
 
-    // If operation timed out cancel
-    if (GetTickCount() > exec_timeout) {
-      timed_out = TRUE;
-      goto END_PROCESS_OUTGOING_MESSAGE;
-    }
+  while ( abort_processes == FALSE ) {
+
+    bread = flight_read(flight, *content_len, buffer, EGRESS_FLIGHT_SIZE, gl_timeout);
+    if ( bread <= 0 ) {
 
-    // Once the header was sent sends the rest of the message...
-    while (total_bytes_sent < outgoing_message_len && abort_processes == FALSE) {
+      if ( bread < 0 ) {
 
-      // If operation timed out cancel
-      if (GetTickCount() > exec_timeout) {
-        timed_out = TRUE;
-        goto END_PROCESS_OUTGOING_MESSAGE;
+        LOGGER(__FUNCTION__, "ERROR: The request in flight could not produce the content.");
+        result = RESULT_FILE_COMPRESS_ERROR;
       }
+      break;
+    }
 
-      // ...but first it sends only the header
-      while (total_bytes_sent < HEADER_LEN && abort_processes == FALSE) {
+    if ( ! process_outgoing_data(connection, buffer, (int)bread) ) {
 
-        // If operation timed out cancel
-        if (GetTickCount() > exec_timeout) {
-          timed_out = TRUE;
-          goto END_PROCESS_OUTGOING_MESSAGE;
-        }
+      result = RESULT_CONNECTION_ERROR;
+      break;
+    }
 
-        selectval = SOCKET_SELECT(S_TIMEOUT, connection, S_WRITE);
-          
-        if ( selectval == S_WRITE ) {
+    *content_len += bread;
+  }
 
-          // Attempts to send the message
-          if ( ! SOCKET_SEND(connection, outgoing_message, chunk_size, &bsent) ) {
+  if ( abort_processes != FALSE && result == RESULT_SUCCESS ) {
+    result = RESULT_CONNECTION_ERROR;
+  }
 
-            // Produces error on fail
-            send_error = TRUE;
-            break; 
-          }
+  free(buffer);
 
-          total_bytes_sent += bsent;
-        }
+  return result;
+}
 
-      }
+/**
+ * Receives an uncompressed file as the content of a message, moving it
+ * from the socket to the file through a pipe without copying it to user
+ * space. If the file cannot be written the content is still received.
+ *
+ * @param connection              conexion on which the content is received
+ * @param fd                      descriptor of the output file
+ * @param len                     content length
+ *
+ * @return                        RESULT_SUCCESS, RESULT_FILE_WRITE_ERROR
+ *                                or RESULT_CONNECTION_ERROR
+ */
+int process_incoming_file_raw( SOCKET_T * connection, int fd, long long len ) {
+
+  char buffer[INGEST_CHUNK_SIZE];
+  unsigned long exec_timeout = GetTickCount() + gl_timeout;
+  long long received = 0;
+  long long written = 0;
+  int result = RESULT_SUCCESS;
+  int pipe_handles[2];
+  int brecv;
+  ssize_t res;
+
+  if ( pipe(pipe_handles) != 0 ) {
+    return RESULT_FILE_WRITE_ERROR;
+  }
+
+  while ( written < len && abort_processes == FALSE ) {
+
+    // If operation timed out cancel
+    if ( GetTickCount() > exec_timeout ) {
+
+      LOGGER(__FUNCTION__, "ERROR: Message transfer operation timed out.");
+      result = RESULT_CONNECTION_ERROR;
+      break;
+    }
+
+    // Moves the data queued on the socket into the empty pipe
+    if ( SOCKET_SELECT(S_TIMEOUT, connection, S_READ) == S_READ ) {
 
-      // If message is only a header then it is complete
-      if (total_bytes_sent == outgoing_message_len) {
+      if ( ! SOCKET_SPLICE(connection, pipe_handles[1], ( len - received > INGEST_RAW_SIZE ) ? INGEST_RAW_SIZE : (int)( len - received ), &brecv) ) {
+
+        LOGGER(__FUNCTION__, "ERROR: A connection problem occurred while attemting to receive message." );
+        result = RESULT_CONNECTION_ERROR;
         break;
       }
 
-      progress = &outgoing_message[total_bytes_sent];
+      if ( brecv > 0 ) {
 
-      // Updates bytes left to send count
-      total_bytes_left = outgoing_message_len - total_bytes_sent;
-      if (total_bytes_left > CHUNK_SIZE) {
-        chunk_size = CHUNK_SIZE;
+        // Updates moment of next timeout
+        exec_timeout = GetTickCount() + gl_timeout;
+        received += brecv;
+      }
+    }
+
+    // Empties the pipe into the file, or discards
+    // the data once the file could not be written
+    while ( written < received ) {
+
+      if ( result == RESULT_SUCCESS ) {
+        res = splice(pipe_handles[0], NULL, fd, NULL, received - written, SPLICE_F_MOVE);
       }
       else {
-        chunk_size = total_bytes_left;
+        res = read(pipe_handles[0], buffer, ( received - written > INGEST_CHUNK_SIZE ) ? INGEST_CHUNK_SIZE : (size_t)( received - written ));
       }
 
-      selectval = SOCKET_SELECT(S_TIMEOUT, connection, S_WRITE);
-          
-      if ( selectval == S_WRITE ) {
+      if ( res <= 0 ) {
 
-        // Attempts to send the message following the header
-        if ( ! SOCKET_SEND(connection, progress, chunk_size, &bsent) ) {
+        if ( res < 0 && errno == EINTR ) {
+          continue;
+        }
+        if ( result == RESULT_SUCCESS ) {
 
-          // Produces error on fail
-          send_error = TRUE;
-          break; 
+          result = RESULT_FILE_WRITE_ERROR;
+          continue;
         }
 
-        total_bytes_sent += bsent;
+        // The pipe itself failed
+        written = len;
+        break;
       }
 
+      written += res;
     }
 
-    // If bytes sent has reached total message size
-    if ( total_bytes_sent == outgoing_message_len ) {
-        
-      message_send_success = TRUE;
-      break;
-    }
+  }
 
+  if ( written < len && result == RESULT_SUCCESS ) {
+    result = RESULT_CONNECTION_ERROR;
   }
-  
-END_PROCESS_OUTGOING_MESSAGE:
 
-  // If an error occurred or operation timed out
-  if ( send_error == TRUE || timed_out) {
-  
-    char log[_BUFFER_SIZE_L];
-    memset(log, 0x00, _BUFFER_SIZE_L);
+  close(pipe_handles[0]);
+  close(pipe_handles[1]);
 
-    strcpy( log, "Failed while attempting to send the following message: ");
-    if (outgoing_message_len >= _BUFFER_SIZE_L) {
-      memcpy(log, outgoing_message, _BUFFER_SIZE_L - 1);
-    }
-    else {
-      memcpy(log, outgoing_message, outgoing_message_len);
+  return result;
+}
+
+/**
+ * Writer for the decompressed content being received, appends it to the output file
+ *
+ * @param arg                     pointer to the output file descriptor
+ * @param data                    decompressed data
+ * @param len                     data length
+ *
+ * @return                        TRUE or FALSE
+ */
+static int process_ingest_write( void * arg, const unsigned char * data, size_t len ) {
+
+  int fd = *(int *)arg;
+  ssize_t res;
+
+  while ( len > 0 ) {
+
+    res = write(fd, data, len);
+    if ( res < 0 ) {
+
+      if ( errno == EINTR ) {
+        continue;
+      }
+      return FALSE;
     }
-    LOGGER(__FUNCTION__, log);
-    
-    sprintf( log, "[Number of bytes sent:%ld]", total_bytes_sent );
-    LOGGER(__FUNCTION__, log);
+
+    data += res;
+    len -= res;
   }
 
-  return message_send_success;
-    
+  return TRUE;
+}
+
+/**
+ * Initializes the processing of the content of a message as it is received
+ *
+ * @param ingest                  state of the content being received
+ * @param fd                      descriptor of the output file
+ * @param encoded                 TRUE if the content is base64 encoded (V1)
+ * @param codec                   codec of the content, CODEC_GZIP for V1
+ *
+ * @return                        TRUE or FALSE
+ */
+int process_ingest_init( PROCESS_INGEST_T * ingest, int fd, int encoded, int codec ) {
+
+  memset(ingest, 0x00, sizeof(PROCESS_INGEST_T));
+  ingest->fd = fd;
+  ingest->encoded = encoded;
+
+  BASE64_DECODE_STREAM_INIT(&ingest->b64_stream);
+
+  return codec_decompress_init(&ingest->codec_stream, codec);
+}
+
+/**
+ * Decodes if needed and decompresses a fragment of received
+ * content, writing the output to the file
+ *
+ * @param ingest                  state of the content being received
+ * @param data                    content fragment
+ * @param len                     fragment length, at most INGEST_CHUNK_SIZE
+ *
+ * @return                        TRUE or FALSE
+ */
+int process_ingest( PROCESS_INGEST_T * ingest, const char * data, int len ) {
+
+  int decoded_len;
+
+  if ( ! ingest->encoded ) {
+    return codec_decompress(&ingest->codec_stream, (const unsigned char *)data, len, &process_ingest_write, &ingest->fd);
+  }
+
+  decoded_len = BASE64_DECODE_STREAM(&ingest->b64_stream, data, len, ingest->decoded);
+
+  return codec_decompress(&ingest->codec_stream, ingest->decoded, decoded_len, &process_ingest_write, &ingest->fd);
+}
+
+/**
+ * Finalizes the processing of received content and releases its
+ * resources, can be called more than once
+ *
+ * @param ingest                  state of the content being received
+ *
+ * @return                        TRUE if the content was complete, otherwise FALSE
+ */
+int process_ingest_end( PROCESS_INGEST_T * ingest ) {
+
+  int decoded_len;
+  int res;
+
+  if ( ! ingest->codec_stream.initialized ) {
+    return FALSE;
+  }
+
+  // Flushes the last incomplete block
+  decoded_len = ( ingest->encoded ) ? BASE64_DECODE_STREAM_END(&ingest->b64_stream, ingest->decoded) : 0;
+
+  res = codec_decompress(&ingest->codec_stream, ingest->decoded, decoded_len, &process_ingest_write, &ingest->fd);
+
+  return codec_end(&ingest->codec_stream) && res;
 }
@@ -18,39 +18,161 @@ extern "C" {
 
 #include "server.h"
 #include "thread.h"
+#include "pool.h"
+#include "base64.h"
+#include "gz.h"
+#include "codec.h"
+#include "cache.h"
+#include "flight.h"
 
 #define ROOT_DIR      "/"
 #define MAX_PROCESSES 512
+
+// Maximum length of requests that are received whole
+#define REQUEST_MAX_LEN     (64 * 1024)
+
+// Maximum length of the parameters that precede the content of a File Send
+#define REQUEST_PREFIX_MAX  4096
+
+// Size of the fragments in which file content is received and processed
+#define INGEST_CHUNK_SIZE   16384
+
+// Size of the fragments in which file content is read and processed for
+// sending, and of the encoded frames in which it is sent
+#define EGRESS_CHUNK_SIZE   16384
+#define EGRESS_FRAME_SIZE   65536
+
+// Largest part of an uncompressed file moved by a single system call,
+// a pipe holds 64 KB by default
+#define EGRESS_RAW_SIZE     (1024 * 1024)
+#define INGEST_RAW_SIZE     65536
+
+// Largest part of the content of a request in flight sent at once by its followers
+#define EGRESS_FLIGHT_SIZE  (256 * 1024)
+
+// Codec of content sent as it was spooled, already compressed
+#define EGRESS_STORED       -1
+
+// Formats in which file content is sent and received
+#define CONTENT_ENCODED           0   // V1, encoded, length given by the header
+#define CONTENT_ENCODED_CHUNKED   1   // V1, encoded, frames ended by CHUNK_END
+#define CONTENT_BINARY_CHUNKED    2   // V2, raw, frames ended by an empty one
+#define CONTENT_RAW               3   // V2, uncompressed, length given by the size
+
+// Policies for requests arriving when every slot is taken
+#define OVERFLOW_QUEUE  0     // waits for a free slot
+#define OVERFLOW_REJECT 1     // answers with RESULT_SERVER_BUSY
+#define OVERFLOW_CLOSE  2     // closes the connection
   
+// Requests of a pipeline being served on a connection, the ones
+// that do not read from it run on free workers at the same time
+typedef struct _process_pipeline_t {
+
+  // Responses are sent through a second structure of the connection,
+  // one at a time along with their content, while requests are received
+  SOCKET_T * writer;
+  pthread_mutex_t write_mutex;
+
+  pthread_mutex_t mutex;
+  pthread_cond_t done;
+  int outstanding;          // requests running on other workers
+  int broken;               // a response could not be completed
+  int keep_alive;           // the client asked for the connection to be kept
+
+} PROCESS_PIPELINE_T;
+
 typedef struct _process_data_t {
 
   SOCKET_T * connection; 
   char * received_message;
   int received_msg_len;
 
+  // Bytes of the request still waiting on the socket
+  long pending_len;
+  unsigned long exec_timeout;
+
   int keep_going;
   int process_id;
+
+  // Set while the connection can be kept open for another
+  // request, cleared when the exchange does not end cleanly
+  int keep_alive;
+
+  // Pipeline the request belongs to and its request ID, set
+  // while its response holds the connection of the pipeline
+  PROCESS_PIPELINE_T * pipeline;
+  unsigned long request_id;
+  int responding;
   
 } PROCESS_DATA_T;
 
+// Entries are aligned to a cache line so that workers
+// updating neighbouring slots do not share lines
 typedef struct _process_t {
 
   int is_active;
-  thread_t* work;
-  PROCESS_DATA_T * proc_data;
+  int next_free;
+  PROCESS_DATA_T proc_data;
   
-} PROCESS_T;
+} __attribute__((aligned(CACHE_LINE_SIZE))) PROCESS_T;
+
+// State of the content of a message while it is received
+typedef struct _process_ingest_t {
+
+  int fd;
+  int encoded;
+  BASE64_STREAM_T b64_stream;
+  CODEC_STREAM_T codec_stream;
+  unsigned char decoded[BASE64_DECODE_STREAM_SIZE(INGEST_CHUNK_SIZE)];
+
+} PROCESS_INGEST_T;
+
+// Counters of the processes table
+typedef struct _process_stats_t {
+
+  POOL_STATS_T pool;
+
+  int active_requests;
+  int pending_connections;
+
+  unsigned long long overflow_queued;
+  unsigned long long overflow_rejected;
+  unsigned long long overflow_closed;
+
+  // Connections kept open for another request once theirs ended
+  unsigned long long kept_alive;
+
+  // Requests served as part of a pipeline
+  unsigned long long pipelined;
+
+} PROCESS_STATS_T;
 
 /**
  * Initializes processes structures for threads
+ *
+ * @param pool_size               number of worker threads
+ * @param policy                  what to do with requests when all slots
+ *                                are taken, OVERFLOW_QUEUE, OVERFLOW_REJECT
+ *                                or OVERFLOW_CLOSE
+ * @param keep_alive              TRUE to keep connections open for
+ *                                further requests when clients ask for it
+ *
+ * @return                        TRUE or FALSE
  */
-void process_init();
+int process_init( int pool_size, int policy, int keep_alive );
 
 /**
  * Finalizes processes structures for threads
  */
 void process_deinit();
 
+/**
+ * Gets the counters of the processes table and the worker pool
+ *
+ * @param stats                   structure that receives the counters
+ */
+void process_get_stats( PROCESS_STATS_T * stats );
+
 /**
  * Processes a request message through a socket
  *
@@ -59,7 +181,7 @@ void process_deinit();
 void process_incoming_request( SOCKET_T ** connection );
 
 /**
- * Thread function for processing an incoming message
+ * Worker function for processing an incoming message
  *
  * @param proc_data_arg           data structure with the thread parameters
  */
@@ -67,7 +189,9 @@ void process_incoming_request_worker( void * proc_data_arg );
 
 /**
  * Processes a File Receive message from the client, 
- * performs and finalizes the operation
+ * performs and finalizes the operation.
+ *
+ * The file is deflated, encoded and sent in fragments as it is read.
  *
  * @param proc_data_arg           data structure with connection parameters 
  *                                and received message
@@ -92,6 +216,36 @@ void process_file_send( PROCESS_DATA_T * proc_data );
  */
 void process_file_delete( PROCESS_DATA_T * proc_data );
 
+/**
+ * Processes a V2 File Receive message from the client,
+ * performs and finalizes the operation.
+ *
+ * The file is deflated and sent as raw frames as it is read.
+ *
+ * @param proc_data_arg           data structure with connection parameters 
+ *                                and received message
+ */
+void process_file_receive_v2( PROCESS_DATA_T * proc_data );
+
+/**
+ * Processes a V2 File Send message from the client, acknowledges it
+ * once the destination is ready, then receives the content frames,
+ * performs and finalizes the operation
+ *
+ * @param proc_data_arg           data structure with connection parameters 
+ *                                and received message
+ */
+void process_file_send_v2( PROCESS_DATA_T * proc_data );
+
+/**
+ * Processes a V2 File Delete message from the client, 
+ * performs and finalizes the operation
+ *
+ * @param proc_data_arg           data structure with connection parameters 
+ *                                and received message
+ */
+void process_file_delete_v2( PROCESS_DATA_T * proc_data );
+
 /**
  * Sends a synchronous message through a connected node
  * 
@@ -103,4 +257,220 @@ void process_file_delete( PROCESS_DATA_T * proc_data );
  */ 
 int process_outgoing_message( SOCKET_T * connection, char * outgoing_message, int outgoing_message_len );
 
+/**
+ * Sends data through a connection, waiting for the socket to accept
+ * more while the connection keeps making progress
+ *
+ * @param connection            conexion on which the data will be sent
+ * @param data                  data to send
+ * @param len                   data length
+ *
+ * @return                      TRUE if data could be sent, otherwise FALSE
+ */
+int process_outgoing_data( SOCKET_T * connection, const char * data, int len );
+
+/**
+ * Sends several buffers through a connection, as many bytes as the socket
+ * takes in each call. It waits for the socket to accept more only once it
+ * is full, while the connection keeps making progress. Large sends are made
+ * without copying the buffers where the system allows it, the function then
+ * returning once the kernel released them.
+ *
+ * @param connection            conexion on which the data will be sent
+ * @param iov                   buffers to send, updated to what is left
+ * @param iov_count             number of buffers
+ *
+ * @return                      TRUE if data could be sent, otherwise FALSE
+ */
+int process_outgoing_vector( SOCKET_T * connection, struct iovec * iov, int iov_count );
+
+/**
+ * Deflates a file once into an anonymous spool file, for the V1 messages
+ * whose header gives the length of the content, which is then sent from
+ * the spool with EGRESS_STORED instead of deflating the file again
+ *
+ * @param fd                      file descriptor
+ * @param mode                    compression mode, GZ_MODE_*
+ * @param spool                   returns the spool, rewound, to be closed
+ *                                by the caller
+ * @param content_len             returns the content length once encoded
+ *
+ * @return                        RESULT_SUCCESS, RESULT_FILE_READ_ERROR,
+ *                                RESULT_FILE_WRITE_ERROR or
+ *                                RESULT_FILE_COMPRESS_ERROR
+ */
+int process_spool_file( int fd, int mode, FILE ** spool, unsigned long long * content_len );
+
+/**
+ * Sends a file as the content of a message, compressed and, for V1, encoded
+ * in fragments as it is read. The parameters preceding it must be already sent.
+ *
+ * @param connection              conexion on which the content will be sent
+ * @param fd                      file descriptor
+ * @param format                  CONTENT_ENCODED, CONTENT_ENCODED_CHUNKED
+ *                                or CONTENT_BINARY_CHUNKED
+ * @param codec                   codec, CODEC_GZIP for V1
+ * @param mode                    compression mode, GZ_MODE_*
+ * @param content_len             returns the length of the content sent,
+ *                                frame lengths not included
+ *
+ * @return                        RESULT_SUCCESS, RESULT_FILE_READ_ERROR,
+ *                                RESULT_FILE_COMPRESS_ERROR or
+ *                                RESULT_CONNECTION_ERROR
+ */
+int process_outgoing_file( SOCKET_T * connection, int fd, int format, int codec, int mode, unsigned long long * content_len );
+
+/**
+ * Sends a byte range of a file as the content of a message, starting at
+ * the current position, compressed and, for V1, encoded in fragments as
+ * it is read. The parameters preceding it must be already sent.
+ *
+ * @param connection              conexion on which the content will be sent
+ * @param fd                      file descriptor
+ * @param len                     number of bytes to send, or -1 up to the
+ *                                end of the file
+ * @param format                  CONTENT_ENCODED, CONTENT_ENCODED_CHUNKED
+ *                                or CONTENT_BINARY_CHUNKED
+ * @param codec                   codec, CODEC_GZIP for V1
+ * @param mode                    compression mode, GZ_MODE_*
+ * @param content_len             returns the length of the content sent,
+ *                                frame lengths not included
+ *
+ * @return                        RESULT_SUCCESS, RESULT_FILE_READ_ERROR,
+ *                                RESULT_FILE_COMPRESS_ERROR or
+ *                                RESULT_CONNECTION_ERROR
+ */
+int process_outgoing_file_range( SOCKET_T * connection, int fd, long long len, int format, int codec, int mode, unsigned long long * content_len );
+
+/**
+ * Sends a byte range of a file as the content of a message, as
+ * process_outgoing_file_range() does, capturing what is sent for
+ * the requests following it. The content is still produced for them
+ * if the connection is lost.
+ *
+ * @param connection              conexion on which the content will be sent
+ * @param fd                      file descriptor
+ * @param len                     number of bytes to send, or -1 up to the
+ *                                end of the file
+ * @param format                  CONTENT_ENCODED, CONTENT_ENCODED_CHUNKED
+ *                                or CONTENT_BINARY_CHUNKED
+ * @param codec                   codec, CODEC_GZIP for V1
+ * @param mode                    compression mode, GZ_MODE_*
+ * @param flight                  flight the request leads, or NULL
+ * @param content_len             returns the length of the content sent,
+ *                                frame lengths not included
+ *
+ * @return                        RESULT_SUCCESS, RESULT_FILE_READ_ERROR,
+ *                                RESULT_FILE_COMPRESS_ERROR or
+ *                                RESULT_CONNECTION_ERROR
+ */
+int process_outgoing_file_capture( SOCKET_T * connection, int fd, long long len, int format, int codec, int mode, FLIGHT_T * flight, unsigned long long * content_len );
+
+/**
+ * Packs a file in memory as the V2 content frames that process_outgoing_file
+ * would send, so that it can be compressed ahead of being sent
+ *
+ * @param fd                      file descriptor
+ * @param codec                   codec
+ * @param mode                    compression mode, GZ_MODE_*
+ * @param content                 returns the content, must be free()'d after usage
+ * @param content_len             returns the content length
+ *
+ * @return                        RESULT_SUCCESS, RESULT_FILE_READ_ERROR
+ *                                or RESULT_FILE_COMPRESS_ERROR
+ */
+int process_pack_file( int fd, int codec, int mode, char ** content, unsigned long * content_len );
+
+/**
+ * Sends a file uncompressed as the content of a message, straight from
+ * the page cache to the socket. The parameters preceding it must be
+ * already sent.
+ *
+ * @param connection              conexion on which the content will be sent
+ * @param fd                      file descriptor
+ * @param len                     number of bytes to send from the current position
+ *
+ * @return                        RESULT_SUCCESS, RESULT_FILE_READ_ERROR if
+ *                                the file turned out to be shorter, or
+ *                                RESULT_CONNECTION_ERROR
+ */
+int process_outgoing_file_raw( SOCKET_T * connection, int fd, long long len );
+
+/**
+ * Sends the content of a file kept in the cache, from memory or
+ * from the file of the disk tier, after the parameters preceding it.
+ * Content kept in memory leaves in the same calls as the parameters.
+ *
+ * @param connection              conexion on which the content will be sent
+ * @param response                parameters preceding the content
+ * @param response_len            parameters length
+ * @param entry                   entry of the cache
+ *
+ * @return                        RESULT_SUCCESS, RESULT_FILE_READ_ERROR
+ *                                or RESULT_CONNECTION_ERROR
+ */
+int process_outgoing_cached( SOCKET_T * connection, const char * response, int response_len, CACHE_ENTRY_T * entry );
+
+/**
+ * Sends the content of a file produced by the leader of a flight, as it is
+ * produced. The parameters preceding it must be already sent.
+ *
+ * @param connection              conexion on which the content will be sent
+ * @param flight                  flight the request follows
+ * @param content_len             returns the length of the content sent
+ *
+ * @return                        RESULT_SUCCESS, RESULT_FILE_COMPRESS_ERROR
+ *                                if the leader could not produce it,
+ *                                or RESULT_CONNECTION_ERROR
+ */
+int process_outgoing_flight( SOCKET_T * connection, FLIGHT_T * flight, unsigned long long * content_len );
+
+/**
+ * Receives an uncompressed file as the content of a message, moving it
+ * from the socket to the file through a pipe without copying it to user
+ * space. If the file cannot be written the content is still received.
+ *
+ * @param connection              conexion on which the content is received
+ * @param fd                      descriptor of the output file
+ * @param len                     content length
+ *
+ * @return                        RESULT_SUCCESS, RESULT_FILE_WRITE_ERROR
+ *                                or RESULT_CONNECTION_ERROR
+ */
+int process_incoming_file_raw( SOCKET_T * connection, int fd, long long len );
+
+/**
+ * Initializes the processing of the content of a message as it is received
+ *
+ * @param ingest                  state of the content being received
+ * @param fd                      descriptor of the output file
+ * @param encoded                 TRUE if the content is base64 encoded (V1)
+ * @param codec                   codec of the content, CODEC_GZIP for V1
+ *
+ * @return                        TRUE or FALSE
+ */
+int process_ingest_init( PROCESS_INGEST_T * ingest, int fd, int encoded, int codec );
+
+/**
+ * Decodes if needed and decompresses a fragment of received
+ * content, writing the output to the file
+ *
+ * @param ingest                  state of the content being received
+ * @param data                    content fragment
+ * @param len                     fragment length, at most INGEST_CHUNK_SIZE
+ *
+ * @return                        TRUE or FALSE
+ */
+int process_ingest( PROCESS_INGEST_T * ingest, const char * data, int len );
+
+/**
+ * Finalizes the processing of received content and releases its
+ * resources, can be called more than once
+ *
+ * @param ingest                  state of the content being received
+ *
+ * @return                        TRUE if the content was complete, otherwise FALSE
+ */
+int process_ingest_end( PROCESS_INGEST_T * ingest );
+
 #endif // PROCESS_H
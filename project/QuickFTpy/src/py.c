@@ -12,6 +12,10 @@
 #include "py.h"
 #include "server.h"
 #include "client.h"
+#include "gz.h"
+#include "codec.h"
+#include "session.h"
+#include "cache.h"
 
 /**
  * Python module server initialization function
@@ -31,6 +35,15 @@ static PyObject * py_server_finalize (PyObject * self) {
   return server_finalize(self);
 }
 
+/**
+ * Python module server statistics function
+ *
+ */
+static PyObject * py_server_stats (PyObject * self) {
+  
+  return server_stats(self);
+}
+
 /**
  * Python module 'File Receive' operation for the client
  *
@@ -40,6 +53,33 @@ static PyObject * py_client_file_receive( PyObject * self, PyObject * args ) {
   return client_file_receive(self, args);
 }
 
+/**
+ * Python module 'File Receive' operation for a byte range for the client
+ *
+ */
+static PyObject * py_client_file_receive_range( PyObject * self, PyObject * args ) {
+  
+  return client_file_receive_range(self, args);
+}
+
+/**
+ * Python module 'File Send' operation of a delta for the client
+ *
+ */
+static PyObject * py_client_file_send_delta( PyObject * self, PyObject * args ) {
+  
+  return client_file_send_delta(self, args);
+}
+
+/**
+ * Python module 'File Send' operation over parallel stripes for the client
+ *
+ */
+static PyObject * py_client_file_send_striped( PyObject * self, PyObject * args ) {
+  
+  return client_file_send_striped(self, args);
+}
+
 /**
  * Python module 'File Send' operation for the client
  *
@@ -58,18 +98,149 @@ static PyObject * py_client_file_delete( PyObject * self, PyObject * args ) {
   return client_file_delete(self, args);
 }
 
+/**
+ * Python module operations performed as a pipeline for the client
+ *
+ */
+static PyObject * py_client_file_pipeline( PyObject * self, PyObject * args ) {
+  
+  return client_file_pipeline(self, args);
+}
+
+/**
+ * Python module batch of 'File Send' operations for the client
+ *
+ */
+static PyObject * py_client_file_send_many( PyObject * self, PyObject * args ) {
+  
+  return client_file_send_many(self, args);
+}
+
+/**
+ * Python module batch of 'File Receive' operations for the client
+ *
+ */
+static PyObject * py_client_file_receive_many( PyObject * self, PyObject * args ) {
+  
+  return client_file_receive_many(self, args);
+}
+
+/**
+ * Python module function that opens a connection handle, which the
+ * client operations take as their last argument
+ *
+ */
+static PyObject * py_client_connection_open( PyObject * self, PyObject * args ) {
+  
+  return client_connection_open(self, args);
+}
+
+/**
+ * Python module function that closes the connection of a connection handle
+ *
+ */
+static PyObject * py_client_connection_close( PyObject * self, PyObject * args ) {
+  
+  return client_connection_close(self, args);
+}
+
+/**
+ * Python module compression settings function, takes the mode (-1 to
+ * choose it per file), and optionally the store, fast and best ratios
+ * (0 for default), the 'ext:mode' overrides and the number of threads
+ * that deflate large files in parallel (0 for one per core)
+ *
+ */
+static PyObject * py_compression_configure( PyObject * self, PyObject * args ) {
+
+  int mode = GZ_MODE_AUTO;
+  double store_ratio = 0;
+  double fast_ratio = 0;
+  double best_ratio = 0;
+  char * overrides = NULL;
+  int threads = 0;
+
+  if (!PyArg_ParseTuple(args, "i|dddzi", &mode, &store_ratio, &fast_ratio, &best_ratio, &overrides, &threads)) {
+    return Py_BuildValue("i", FALSE);
+  }
+
+  gz_adaptive_configure(mode, store_ratio, fast_ratio, best_ratio, overrides);
+  gz_parallel_configure(threads);
+
+  return Py_BuildValue("i", TRUE);
+}
+
+/**
+ * Python module codec settings function, takes the codec name and
+ * optionally the level of every file (0 to derive it from the mode)
+ * and whether zstd uses its long range mode
+ *
+ */
+static PyObject * py_codec_configure( PyObject * self, PyObject * args ) {
+
+  char * name = NULL;
+  int level = 0;
+  int long_range = FALSE;
+  int codec;
+
+  if (!PyArg_ParseTuple(args, "s|ii", &name, &level, &long_range)) {
+    return Py_BuildValue("i", FALSE);
+  }
+
+  codec = codec_by_name(name);
+  if ( codec < 0 ) {
+    return Py_BuildValue("i", FALSE);
+  }
+
+  return Py_BuildValue("i", codec_configure(codec, level, long_range));
+}
+
+/**
+ * Python module cache settings function, takes the bytes of encoded
+ * content the server keeps in memory (0 to disable the cache), and
+ * optionally the directory and bytes of its disk tier
+ *
+ */
+static PyObject * py_cache_configure( PyObject * self, PyObject * args ) {
+
+  unsigned long long memory_bytes = 0;
+  unsigned long long disk_bytes = 0;
+  char * directory = NULL;
+
+  if (!PyArg_ParseTuple(args, "K|zK", &memory_bytes, &directory, &disk_bytes)) {
+    return Py_BuildValue("i", FALSE);
+  }
+
+  return Py_BuildValue("i", cache_configure(memory_bytes, directory, disk_bytes));
+}
 
 // Python method definitions
 static PyMethodDef quickFTpyMethods[] = {
     { "servstart",  (PyCFunction)py_server_initialize,    METH_VARARGS, NULL },
     { "servend",    (PyCFunction)py_server_finalize,      METH_NOARGS,  NULL },
+    { "servstats",  (PyCFunction)py_server_stats,         METH_NOARGS,  NULL },
     { "clsend",     (PyCFunction)py_client_file_send,     METH_VARARGS, NULL },
     { "clrecv",     (PyCFunction)py_client_file_receive,  METH_VARARGS, NULL },
+    { "clrecv_range",(PyCFunction)py_client_file_receive_range,METH_VARARGS, NULL },
+    { "clsend_delta",(PyCFunction)py_client_file_send_delta,METH_VARARGS, NULL },
+    { "clsend_striped",(PyCFunction)py_client_file_send_striped,METH_VARARGS, NULL },
     { "cldel",      (PyCFunction)py_client_file_delete,   METH_VARARGS, NULL },
+    { "clpipeline", (PyCFunction)py_client_file_pipeline, METH_VARARGS, NULL },
+    { "clsend_many",(PyCFunction)py_client_file_send_many,METH_VARARGS, NULL },
+    { "clrecv_many",(PyCFunction)py_client_file_receive_many,METH_VARARGS, NULL },
+    { "clconnect",  (PyCFunction)py_client_connection_open, METH_VARARGS, NULL },
+    { "clclose",    (PyCFunction)py_client_connection_close,METH_VARARGS, NULL },
+    { "setcompress",(PyCFunction)py_compression_configure,METH_VARARGS, NULL },
+    { "setcodec",   (PyCFunction)py_codec_configure,      METH_VARARGS, NULL },
+    { "setcache",   (PyCFunction)py_cache_configure,      METH_VARARGS, NULL },
     { NULL,         NULL,                                 0,            NULL }
 };
 
 void initquickftpy(void)
 {
-    Py_InitModule("quickftpy", quickFTpyMethods);
+    PyObject * module = Py_InitModule("quickftpy", quickFTpyMethods);
+
+    if (module != NULL) {
+        session_register(module);
+    }
 }
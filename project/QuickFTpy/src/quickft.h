@@ -26,6 +26,7 @@ extern "C" {
 
 #define DEFAULT_TIMEOUT           30     // timeout in seconds
 #define DEFAULT_TIMEOUT_ACK       8      // timeout in seconds
+#define DEFAULT_KEEP_ALIVE        15     // idle timeout of kept connections in seconds
 
 unsigned long gl_timeout;
 
@@ -38,6 +38,9 @@ extern "C" {
 #define RESULT_INVALID_DESTINATION_DIRECTORY              -114
 #define RESULT_COULD_NOT_CREATE_DESTINATION_DIRECTORY     -115
 
+#define RESULT_SERVER_BUSY                                -116
+#define RESULT_VERSION_NOT_SUPPORTED                      -117
+
 // Define los mensajes de resultados
 #define STR_RESULT_SUCCESS                                "SUCCESS____________"
 #define STR_RESULT_CONNECTION_ERROR                       "CONNECTION_ERROR___"
@@ -60,6 +63,9 @@ extern "C" {
 #define STR_RESULT_INVALID_DESTINATION_DIRECTORY          "DEST_DIR_INVALID___"
 #define STR_RESULT_COULD_NOT_CREATE_DESTINATION_DIRECTORY "DEST_DIR_CREATE_ERR"
 
+#define STR_RESULT_SERVER_BUSY                            "SERVER_BUSY________"
+#define STR_RESULT_VERSION_NOT_SUPPORTED                  "VERSION_UNSUPPORTED"
+
 #ifdef	__cplusplus
 }
 #endif
@@ -10,7 +10,6 @@
  */
 
 #include <unistd.h>
-#define Sleep(ms) usleep(ms*1000)
 
 #include "macros.h"
 
@@ -18,6 +17,10 @@
 #include "message.h"
 #include "process.h"
 #include "quickft.h"
+#include "time.h"
+#include "store.h"
+#include "cache.h"
+#include "flight.h"
 
 
 // Server handle
@@ -35,15 +38,22 @@ PyObject * server_initialize( PyObject * self, PyObject * args ) {
   int port = 0;
   int max_connections = 0;
   int timeout = 0;
+  int pool_size = POOL_DEFAULT_SIZE;
+  int overflow_policy = OVERFLOW_QUEUE;
+  char * codecs = NULL;
+  int keep_alive = 0;
+  char * store = NULL;
   
   PyObject * py_log_writer;
   
-  // Initializes python threading
+  // Initializes python threading, the calling thread keeps the GIL
+  // and server threads acquire it through the logger when needed
   PyEval_InitThreads();
-  PyEval_ReleaseLock();
   
-  // Parses arguments
-  if (!PyArg_ParseTuple(args, "iiiO", &port, &max_connections, &timeout, &py_log_writer)) {
+  // Parses arguments, the codecs allowed are a comma separated list of names
+  // and connections are kept open between requests unless keep alive is negative,
+  // the content received is deduplicated into the store directory if one is given
+  if (!PyArg_ParseTuple(args, "iiiO|iiziz", &port, &max_connections, &timeout, &py_log_writer, &pool_size, &overflow_policy, &codecs, &keep_alive, &store)) {
     return Py_BuildValue("i", FALSE);
   }
   
@@ -64,30 +74,55 @@ PyObject * server_initialize( PyObject * self, PyObject * args ) {
   if (timeout != 0) {
     gl_timeout = timeout;
   }
+
+  if ( ! codec_allow(codecs) ) {
+
+    sprintf(l_msg, "Unknown codec in the allowed ones (%s)", codecs);
+    LOGGER(__FUNCTION__, l_msg);
+    LOGGER_DEINIT;
+    return Py_BuildValue("i", FALSE);
+  }
+
+  if ( ! store_init(store) ) {
+    LOGGER_DEINIT;
+    return Py_BuildValue("i", FALSE);
+  }
   
   // Initializes the library's socket functionalities
   if ( ! SOCKET_INIT() ) {
+    store_deinit();
+    LOGGER_DEINIT;
     return Py_BuildValue("i", FALSE);
   }
 
   // Allocates and sets server structure
   new_server = malloc( sizeof(SERVER_T) );
   memset(new_server, 0x00, sizeof(SERVER_T));
+  new_server->pool_size = pool_size;
+  new_server->overflow_policy = overflow_policy;
+  new_server->keep_alive = ( keep_alive < 0 ) ? 0 : ( keep_alive == 0 ) ? DEFAULT_KEEP_ALIVE : keep_alive;
 
   // Creates a connection
   new_server->connection = SOCKET_NEW_SRVR(NULL, port, max_connections);
   if ( new_server->connection != NULL ) {
 
+    // Begins thread for listening
+    if ( ! server_listen_begin( new_server ) ) {
+
+      SOCKET_CLOSE( &new_server->connection );
+      free(new_server);
+      store_deinit();
+      LOGGER_DEINIT;
+      return Py_BuildValue("i", FALSE);
+    }
+
     // Sets initialization variable
     new_server->initialized = TRUE;
-    
-    // Begins thread for listening
-    server_listen_begin( new_server );
 
     // Saves server instance
     gl_server_handle = new_server;
     
-    sprintf(l_msg, "Server running on port %d", port);
+    sprintf(l_msg, "Server running on port %d with %d workers, codecs %s, keep alive %lu", port, pool_size, ( codecs != NULL ) ? codecs : "all", new_server->keep_alive);
     LOGGER(__FUNCTION__, l_msg);
     
     return Py_BuildValue("i", TRUE);
@@ -95,6 +130,8 @@ PyObject * server_initialize( PyObject * self, PyObject * args ) {
   } 
   
   free(new_server);
+  store_deinit();
+  LOGGER_DEINIT;
   return Py_BuildValue("i", FALSE);
   
 }
@@ -110,8 +147,11 @@ PyObject * server_finalize ( PyObject * self ) {
     // Sets initialized variable to false
     gl_server_handle->initialized = FALSE;
 
-    // Finalizes listen thread
+    // Finalizes listen thread, releasing the GIL while waiting
+    // since server threads acquire it to log before ending
+    Py_BEGIN_ALLOW_THREADS
     server_listen_finalize( gl_server_handle );
+    Py_END_ALLOW_THREADS
     
     // Ends connection and closes socket
     SOCKET_CLOSE( &(gl_server_handle)->connection );
@@ -122,46 +162,262 @@ PyObject * server_finalize ( PyObject * self ) {
 
     // Finalizes library's socket functionalities
     SOCKET_DEINIT();
+
+    store_deinit();
     
     // Finalizes log
     LOGGER_DEINIT;
     
     return Py_BuildValue("i", TRUE);
   }
-
-  // Finalizes log
-  LOGGER_DEINIT;
   
   //PyGILState_Release(gl_py_gstate);
   
   return Py_BuildValue("i", FALSE);
 }
 
+/**
+ * Returns the processes, worker pool, cache and shared request counters as a dictionary
+ *
+ */
+PyObject * server_stats ( PyObject * self ) {
+
+  PROCESS_STATS_T stats;
+  CACHE_STATS_T cache_stats;
+  FLIGHT_STATS_T flight_stats;
+  memset(&stats, 0x00, sizeof(PROCESS_STATS_T));
+
+  if ( gl_server_handle != NULL ) {
+    process_get_stats(&stats);
+  }
+  cache_get_stats(&cache_stats);
+  flight_get_stats(&flight_stats);
+
+  return Py_BuildValue("{s:i,s:i,s:i,s:i,s:K,s:K,s:K,s:i,s:i,s:K,s:K,s:K,s:K,s:K,s:K,s:K,s:K,s:K,s:K,s:K,s:K,s:K,s:i,s:K,s:K,s:K}",
+                       "workers",             stats.pool.workers,
+                       "busy_workers",        stats.pool.busy_workers,
+                       "queue_depth",         stats.pool.queue_depth,
+                       "max_queue_depth",     stats.pool.max_queue_depth,
+                       "tasks_completed",     stats.pool.tasks_completed,
+                       "total_wait_usec",     stats.pool.total_wait_usec,
+                       "max_wait_usec",       stats.pool.max_wait_usec,
+                       "active_requests",     stats.active_requests,
+                       "pending_connections", stats.pending_connections,
+                       "overflow_queued",     stats.overflow_queued,
+                       "overflow_rejected",   stats.overflow_rejected,
+                       "overflow_closed",     stats.overflow_closed,
+                       "kept_alive",          stats.kept_alive,
+                       "pipelined",           stats.pipelined,
+                       "cache_hits",          cache_stats.hits,
+                       "cache_disk_hits",     cache_stats.disk_hits,
+                       "cache_misses",        cache_stats.misses,
+                       "cache_insertions",    cache_stats.insertions,
+                       "cache_evictions",     cache_stats.evictions,
+                       "cache_invalidations", cache_stats.invalidations,
+                       "cache_memory_bytes",  cache_stats.memory_bytes,
+                       "cache_disk_bytes",    cache_stats.disk_bytes,
+                       "cache_entries",       cache_stats.entries,
+                       "flight_leaders",      flight_stats.leaders,
+                       "flight_followers",    flight_stats.followers,
+                       "flight_fallbacks",    flight_stats.fallbacks);
+}
+
+/**
+ * Adds a connection to the idle list, in the place given by its timeout.
+ * Connections mostly arrive with the latest timeout, so the place is
+ * looked for from the end of the list
+ *
+ * @param server                        server data structure
+ * @param conn                          idle connection
+ */
+static void server_idle_link( SERVER_T * server, SERVER_CONN_T * conn ) {
+
+  SERVER_CONN_T * prev = server->idle_last;
+
+  while ( prev != NULL && prev->idle_timeout > conn->idle_timeout ) {
+    prev = prev->prev;
+  }
+
+  conn->prev = prev;
+  conn->next = ( prev != NULL ) ? prev->next : server->idle_first;
+
+  if ( conn->next != NULL ) {
+    conn->next->prev = conn;
+  }
+  else {
+    server->idle_last = conn;
+  }
+
+  if ( prev != NULL ) {
+    prev->next = conn;
+  }
+  else {
+    server->idle_first = conn;
+  }
+}
+
+/**
+ * Removes a connection from the idle list
+ *
+ * @param server                        server data structure
+ * @param conn                          idle connection
+ */
+static void server_idle_unlink( SERVER_T * server, SERVER_CONN_T * conn ) {
+
+  if ( conn->prev != NULL ) {
+    conn->prev->next = conn->next;
+  }
+  else {
+    server->idle_first = conn->next;
+  }
+
+  if ( conn->next != NULL ) {
+    conn->next->prev = conn->prev;
+  }
+  else {
+    server->idle_last = conn->prev;
+  }
+
+  conn->prev = conn->next = NULL;
+}
+
+/**
+ * Accepts every pending connection on the listen socket and
+ * registers them to wait for their request
+ *
+ * @param server                        server data structure
+ */
+static void server_accept_pending( SERVER_T * server ) {
+
+  SOCKET_T * accepted_socket;
+  SERVER_CONN_T * conn;
+
+  // The listen socket is edge-triggered, so the backlog
+  // must be drained until no connections are left
+  while ( TRUE == SOCKET_ACCEPT(server->connection, &accepted_socket) ) {
+
+    conn = (SERVER_CONN_T*)malloc(sizeof(SERVER_CONN_T));
+    if ( conn == NULL ) {
+
+      LOGGER(__FUNCTION__, "ERROR: not enough memory to register the connection.");
+      SOCKET_CLOSE(&accepted_socket);
+      continue;
+    }
+    memset(conn, 0x00, sizeof(SERVER_CONN_T));
+
+    conn->connection = accepted_socket;
+    conn->idle_timeout = GetTickCount() + gl_timeout;
+
+    if ( ! SOCKET_POLL_ADD(server->poll, accepted_socket, S_READ, TRUE, conn) ) {
+
+      SOCKET_CLOSE(&accepted_socket);
+      free(conn);
+      continue;
+    }
+
+    server_idle_link(server, conn);
+  }
+
+}
+
+/**
+ * Hands a connection whose request has begun to arrive to a worker
+ *
+ * @param server                        server data structure
+ * @param conn                          idle connection
+ * @param operation_type                readiness reported for the connection
+ */
+static void server_dispatch_connection( SERVER_T * server, SERVER_CONN_T * conn, int operation_type ) {
+
+  SOCKET_T * connection = conn->connection;
+
+  server_idle_unlink(server, conn);
+  free(conn);
+
+  // Peer went away without sending anything
+  if ( ( operation_type & S_HANGUP ) && !( operation_type & S_READ ) ) {
+
+    SOCKET_CLOSE(&connection);
+    return;
+  }
+
+  process_incoming_request(&connection);
+}
+
+/**
+ * Closes idle connections that reached their timeout,
+ * or all of them if 'all' is TRUE
+ *
+ * @param server                        server data structure
+ * @param all                           TRUE to close every idle connection
+ */
+static void server_close_idle_connections( SERVER_T * server, int all ) {
+
+  SERVER_CONN_T * conn;
+  unsigned long now = GetTickCount();
+
+  // List is ordered by timeout, stops on the first one still valid
+  while ( (conn = server->idle_first) != NULL ) {
+
+    if ( all == FALSE && conn->idle_timeout >= now ) {
+      break;
+    }
+
+    server_idle_unlink(server, conn);
+
+    SOCKET_POLL_REMOVE(server->poll, conn->connection);
+    SOCKET_CLOSE(&conn->connection);
+    free(conn);
+  }
+
+}
+
 /**
  * Performs the server listen loop
  *
  */
 void * server_listen_function ( void * server_l ) {
   
-  SOCKET_T * accepted_socket;
+  SOCKET_POLL_EVENT_T events[S_POLL_MAX_EVENTS];
   SERVER_T * server = (SERVER_T * ) server_l;
+  int count, iter;
 
   while ( server->udata.keep_going == TRUE ) {
 
+    // Waits for new connections or requests, wakes up
+    // periodically to expire idle connections
+    count = SOCKET_POLL_WAIT(server->poll, S_TIMEOUT * 1000, events, S_POLL_MAX_EVENTS);
+    if ( count < 0 ) {
+
+      LOGGER(__FUNCTION__, "ERROR: waiting for connection events failed");
+      break;
+    }
+
     // Locks mutex on the thread
     MUTEX_LOCK(server->udata.mutex);
 
-    if ( TRUE == SOCKET_ACCEPT(server->connection, &accepted_socket) ) 
-    {
-      process_incoming_request(&accepted_socket);
+    for (iter = 0; iter < count && server->udata.keep_going == TRUE; iter++) {
+
+      if ( events[iter].context == (void *)server ) {
+        server_accept_pending(server);
+      }
+      else {
+        server_dispatch_connection(server, (SERVER_CONN_T *)events[iter].context, events[iter].operation_type);
+      }
     }
-    
+
+    server_close_idle_connections(server, FALSE);
+
     // Removes lock from mutex
     MUTEX_UNLOCK(server->udata.mutex);
 
-    Sleep(100);
-
   }
+
+  // Closes connections that never sent a request, or whose next request
+  // never came, workers that end later close their connections themselves
+  MUTEX_LOCK(server->udata.mutex);
+  server_close_idle_connections(server, TRUE);
+  MUTEX_UNLOCK(server->udata.mutex);
   
   // Sets the thread state
   server->udata.is_running=FALSE;
@@ -174,11 +430,28 @@ void * server_listen_function ( void * server_l ) {
  *
  * @param server                        server data structure
  *
+ * @return                              TRUE or FALSE
  */
-void server_listen_begin (  SERVER_T * server  ) {
+int server_listen_begin (  SERVER_T * server  ) {
+
+  // Creates the notification set for the listen socket
+  server->poll = SOCKET_POLL_CREATE();
+  if ( server->poll == NULL ) {
+    return FALSE;
+  }
+
+  if ( ! SOCKET_POLL_ADD(server->poll, server->connection, S_READ, FALSE, (void *)server) ) {
 
-  // Initializes processes structures
-  process_init();
+    SOCKET_POLL_DESTROY(&server->poll);
+    return FALSE;
+  }
+
+  // Initializes processes structures and the worker pool
+  if ( ! process_init(server->pool_size, server->overflow_policy, ( server->keep_alive > 0 )) ) {
+
+    SOCKET_POLL_DESTROY(&server->poll);
+    return FALSE;
+  }
 
   // Creates a thread for the server_listen
   server->udata.keep_going = TRUE;
@@ -195,6 +468,7 @@ void server_listen_begin (  SERVER_T * server  ) {
   server->listen_thread = (thread_t*) malloc(sizeof(thread_t));
   THREAD_CREATE(&server->listen_thread, &server_listen_function, (void *)server);
 
+  return TRUE;
 }
 
 /**
@@ -204,17 +478,72 @@ void server_listen_begin (  SERVER_T * server  ) {
  */
 void server_listen_finalize (  SERVER_T * server ) {
 
-  // Sets flag to stop the thread
+  // Sets flag to stop the thread and wakes it up
   server->udata.keep_going = FALSE;
+  SOCKET_POLL_WAKEUP(server->poll);
   
   //  Waits for the thread to end and destroys it
-  THREAD_JOIN(server->listen_thread, TRUE);
+  THREAD_JOIN(server->listen_thread, FALSE);
   free(server->listen_thread);
 
+  // Finalizes the processes structures, before the mutex and
+  // the notification set that workers use to keep connections
+  process_deinit();
+
   // Destroys the thread's mutex
   MUTEX_DESTROY(&server->udata.mutex);
   free(server->udata.mutex);
 
-  // Finalizes the processes structures
-  process_deinit();
+  // Destroys the notification set
+  SOCKET_POLL_DESTROY(&server->poll);
+}
+
+/**
+ * Hands a connection whose request ended back to the listen loop,
+ * to wait there for the next request of the client
+ *
+ * @param connection                    socket that holds the conexion, set
+ *                                      to NULL if the server took it
+ */
+void server_keep_alive ( SOCKET_T ** connection ) {
+
+  SERVER_T * server = gl_server_handle;
+  SERVER_CONN_T * conn;
+
+  if ( server == NULL || server->keep_alive == 0 ) {
+    return;
+  }
+
+  MUTEX_LOCK(server->udata.mutex);
+
+  // Once the listen loop ends nothing would close the connection
+  if ( server->udata.keep_going == TRUE ) {
+
+    conn = (SERVER_CONN_T*)malloc(sizeof(SERVER_CONN_T));
+    if ( conn == NULL ) {
+
+      // The connection is left to the caller, which closes it
+      LOGGER(__FUNCTION__, "ERROR: not enough memory to keep the connection alive.");
+      MUTEX_UNLOCK(server->udata.mutex);
+      return;
+    }
+    memset(conn, 0x00, sizeof(SERVER_CONN_T));
+
+    conn->connection = *connection;
+    conn->idle_timeout = GetTickCount() + server->keep_alive;
+
+    // The socket is still on the notification set, disabled since
+    // its last request arrived, a request already waiting on it
+    // is reported as soon as it is enabled again
+    if ( SOCKET_POLL_REARM(server->poll, conn->connection, S_READ, conn) ) {
+
+      server_idle_link(server, conn);
+      *connection = NULL;
+    }
+    else {
+      free(conn);
+    }
+  }
+
+  MUTEX_UNLOCK(server->udata.mutex);
 }
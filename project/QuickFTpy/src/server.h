@@ -29,18 +29,45 @@ typedef struct _user_data_t {
   MUTEX_T* mutex;
 } USER_DATA_T;
 
+// Accepted connection waiting on the server's event loop
+// for its request to arrive
+typedef struct _server_conn_t {
+
+  SOCKET_T * connection;
+  unsigned long idle_timeout;
+
+  struct _server_conn_t * prev;
+  struct _server_conn_t * next;
+
+} SERVER_CONN_T;
+
 // Definition for server data structure type
 typedef struct _server_t {
 
   // Connection information structure
   SOCKET_T * connection;
   int initialized;
+
+  // Number of workers that serve the requests and
+  // policy for requests arriving when all slots are taken
+  int pool_size;
+  int overflow_policy;
+
+  // Time a connection kept open after a request waits
+  // for the next one, 0 if connections are not kept
+  unsigned long keep_alive;
   
   // Information on the thread's context
   // for the node's listen process
   thread_t * listen_thread;
   USER_DATA_T udata;
 
+  // Readiness notification set for the listen socket and
+  // the idle connections, ordered by idle timeout
+  SOCKET_POLL_T * poll;
+  SERVER_CONN_T * idle_first;
+  SERVER_CONN_T * idle_last;
+
 } SERVER_T;
 
 /**
@@ -55,13 +82,20 @@ PyObject * server_initialize(PyObject * self, PyObject * args);
  */
 PyObject * server_finalize (PyObject * self);
 
+/**
+ * Returns the processes and worker pool counters as a dictionary
+ *
+ */
+PyObject * server_stats (PyObject * self);
+
 /**
  * Starts the thread for the server's listen loop
  *
  * @param server                        server data structure
  *
+ * @return                              TRUE or FALSE
  */
-void server_listen_begin ( SERVER_T * server_context );
+int server_listen_begin ( SERVER_T * server_context );
 
 /**
  * Finalizes the thread's listen loop
@@ -70,4 +104,13 @@ void server_listen_begin ( SERVER_T * server_context );
  */
 void server_listen_finalize ( SERVER_T * server );
 
+/**
+ * Hands a connection whose request ended back to the listen loop,
+ * to wait there for the next request of the client
+ *
+ * @param connection                    socket that holds the conexion, set
+ *                                      to NULL if the server took it
+ */
+void server_keep_alive ( SOCKET_T ** connection );
+
 #endif // SERVER_H
\ No newline at end of file
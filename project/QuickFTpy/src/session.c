@@ -0,0 +1,852 @@
+/*
+ * session.c
+ *
+ * $Id: $
+ * $HeadURL: $
+ * $LastChangedRevision: $
+ * $LastChangedDate: $
+ * $LastChangedBy: $
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "session.h"
+#include "message.h"
+#include "results.h"
+#include "quickft.h"
+#include "logger.h"
+#include "socket.h"
+
+/**
+ * Borrows a client of the session for an operation. An idle client is
+ * preferred, a new one is created while there are less than pool_size,
+ * otherwise it waits for one to be returned. The connection of an idle
+ * client is checked and opened again if the server closed it meanwhile
+ *
+ * @param session               session
+ *
+ * @return                      client, or NULL if the session is closed
+ *                              or the server could not be reached
+ */
+static quickft_client_t * session_borrow( SESSION_T * session ) {
+
+  quickft_client_t * client = NULL;
+  int waited = FALSE;
+
+  pthread_mutex_lock(&session->mutex);
+
+  while ( session->closed == FALSE && session->idle_count == 0 && session->open_count >= session->pool_size ) {
+
+    if ( ! waited ) {
+      session->stats.waits++;
+      waited = TRUE;
+    }
+    pthread_cond_wait(&session->available, &session->mutex);
+  }
+
+  if ( session->closed ) {
+
+    pthread_mutex_unlock(&session->mutex);
+    return NULL;
+  }
+
+  // Takes an idle client, or reserves the place of a new one
+  if ( session->idle_count > 0 ) {
+    client = session->idle[--session->idle_count];
+  }
+  else {
+    session->open_count++;
+  }
+
+  session->stats.operations++;
+
+  pthread_mutex_unlock(&session->mutex);
+
+  if ( client == NULL ) {
+
+    client = client_connect(session->addr, session->port, session->timeout, session->timeout_ack);
+    if ( client == NULL ) {
+
+      LOGGER(__FUNCTION__, "Error on client initialization.");
+
+      pthread_mutex_lock(&session->mutex);
+      session->open_count--;
+      pthread_cond_signal(&session->available);
+      pthread_mutex_unlock(&session->mutex);
+      return NULL;
+    }
+
+    client->persistent = TRUE;
+    ATOMIC_ADD(&session->stats.connects, 1);
+    return client;
+  }
+
+  // A connection kept open is only used if the server did not close it
+  if ( client->connection != NULL && ! SOCKET_IS_IDLE(client->connection) ) {
+
+    LOGGER(__FUNCTION__, "Connection kept open was closed by the server, connects again.");
+    ATOMIC_ADD(&session->stats.health_failures, 1);
+    SOCKET_CLOSE( &client->connection );
+  }
+
+  if ( client->connection == NULL ) {
+    ATOMIC_ADD(&session->stats.reconnects, 1);
+  }
+
+  if ( ! client_resume(client, session->addr, session->port) ) {
+
+    // Stays in the pool without connection, the next operation tries again
+    pthread_mutex_lock(&session->mutex);
+    session->idle[session->idle_count++] = client;
+    pthread_cond_signal(&session->available);
+    pthread_mutex_unlock(&session->mutex);
+    return NULL;
+  }
+
+  return client;
+}
+
+/**
+ * Returns a client to the session once its operation ends, its
+ * connection is kept open if the server agreed to it
+ *
+ * @param session               session
+ * @param client                client borrowed from the session
+ */
+static void session_return( SESSION_T * session, quickft_client_t * client ) {
+
+  client_release(client);
+
+  pthread_mutex_lock(&session->mutex);
+
+  if ( session->closed ) {
+
+    session->open_count--;
+    pthread_mutex_unlock(&session->mutex);
+
+    client_finalize(&client);
+    return;
+  }
+
+  session->idle[session->idle_count++] = client;
+  pthread_cond_signal(&session->available);
+
+  pthread_mutex_unlock(&session->mutex);
+}
+
+/**
+ * Closes the session, finalizing its idle clients now and
+ * the ones in use as their operations end
+ *
+ * @param session               session
+ */
+static void session_shutdown( SESSION_T * session ) {
+
+  quickft_client_t ** idle;
+  int idle_count;
+  int iter;
+
+  pthread_mutex_lock(&session->mutex);
+
+  session->closed = TRUE;
+
+  idle_count = session->idle_count;
+  idle = (quickft_client_t **)malloc(sizeof(quickft_client_t *) * ( idle_count + 1 ));
+  memcpy(idle, session->idle, sizeof(quickft_client_t *) * idle_count);
+
+  session->open_count -= idle_count;
+  session->idle_count = 0;
+
+  // Wakes the operations waiting for a client so that they fail
+  pthread_cond_broadcast(&session->available);
+
+  pthread_mutex_unlock(&session->mutex);
+
+  for (iter = 0; iter < idle_count; iter++) {
+    client_finalize(&idle[iter]);
+  }
+
+  free(idle);
+}
+
+/**
+ * Prepares the globals of the client operations for an operation
+ * of the session, called with the GIL held
+ *
+ * @param session               session
+ *
+ * @return                      TRUE, or FALSE if the session was not initialized
+ */
+static int session_begin( SESSION_T * session ) {
+
+  if ( session->idle == NULL ) {
+
+    PyErr_SetString(PyExc_RuntimeError, "Session is not initialized.");
+    return FALSE;
+  }
+
+  gl_py_log_writer = session->py_log_writer;
+  client_timeouts(session->timeout, session->timeout_ack);
+
+  return TRUE;
+}
+
+/**
+ * Initializes a session, Session(addr, port, pool_size=4,
+ * timeout=0, timeout_ack=0, logger=None). No connection is
+ * opened until the first operation
+ *
+ */
+static int session_init( SESSION_T * self, PyObject * args, PyObject * kwds ) {
+
+  static char * kwlist[] = { "addr", "port", "pool_size", "timeout", "timeout_ack", "logger", NULL };
+
+  char * addr;
+  PyObject * py_port;
+  PyObject * py_port_str;
+  int pool_size = SESSION_DEFAULT_POOL_SIZE;
+  int timeout = 0;
+  int timeout_ack = 0;
+  PyObject * py_log_writer = NULL;
+
+  if ( self->idle != NULL ) {
+
+    PyErr_SetString(PyExc_RuntimeError, "Session is already initialized.");
+    return -1;
+  }
+
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "sO|iiiO", kwlist, &addr,
+                                                                  &py_port,
+                                                                  &pool_size,
+                                                                  &timeout,
+                                                                  &timeout_ack,
+                                                                  &py_log_writer)) {
+    return -1;
+  }
+
+  if ( py_log_writer == Py_None ) {
+    py_log_writer = NULL;
+  }
+
+  if ( py_log_writer != NULL && !PyCallable_Check(py_log_writer) ) {
+
+    PyErr_SetString(PyExc_TypeError, "Logger is not a function.");
+    return -1;
+  }
+
+  if ( pool_size <= 0 ) {
+    pool_size = SESSION_DEFAULT_POOL_SIZE;
+  }
+  if ( pool_size > SESSION_MAX_POOL_SIZE ) {
+    pool_size = SESSION_MAX_POOL_SIZE;
+  }
+
+  // The port is taken as a number or as a string
+  if ( py_port == Py_None ) {
+    snprintf(self->port, _BUFFER_SIZE_XS, "%s", DEFAULT_PORT_STR);
+  }
+  else {
+
+    py_port_str = PyObject_Str(py_port);
+    if ( py_port_str == NULL ) {
+      return -1;
+    }
+    snprintf(self->port, _BUFFER_SIZE_XS, "%s", PyString_AsString(py_port_str));
+    Py_DECREF(py_port_str);
+  }
+
+  snprintf(self->addr, _BUFFER_SIZE_XS, "%s", addr);
+  self->timeout = timeout;
+  self->timeout_ack = timeout_ack;
+  self->pool_size = pool_size;
+
+  Py_XINCREF(py_log_writer);
+  self->py_log_writer = py_log_writer;
+
+  self->idle = (quickft_client_t **)malloc(sizeof(quickft_client_t *) * pool_size);
+  memset(self->idle, 0x00, sizeof(quickft_client_t *) * pool_size);
+
+  pthread_mutex_init(&self->mutex, NULL);
+  pthread_cond_init(&self->available, NULL);
+
+  // Operations run without the GIL, the log takes it back when writing
+  PyEval_InitThreads();
+
+  // The log is kept for the lifetime of the session
+  gl_py_log_writer = self->py_log_writer;
+  LOGGER_INIT;
+
+  return 0;
+}
+
+/**
+ * Closes the session and frees it
+ *
+ */
+static void session_dealloc( SESSION_T * self ) {
+
+  if ( self->idle != NULL ) {
+
+    if ( ! self->closed ) {
+      session_shutdown(self);
+    }
+
+    pthread_cond_destroy(&self->available);
+    pthread_mutex_destroy(&self->mutex);
+
+    free(self->idle);
+    self->idle = NULL;
+
+    LOGGER_DEINIT;
+  }
+
+  if ( self->py_log_writer != NULL ) {
+
+    if ( gl_py_log_writer == self->py_log_writer ) {
+      gl_py_log_writer = NULL;
+    }
+    Py_DECREF(self->py_log_writer);
+  }
+
+  self->ob_type->tp_free((PyObject *)self);
+}
+
+/**
+ * Performs a 'File Send' operation on a client of the session,
+ * clsend(remote, local, raw=0, codec=None, transfer_id=None, dedup=0)
+ *
+ */
+static PyObject * session_file_send( SESSION_T * self, PyObject * args, PyObject * kwds ) {
+
+  static char * kwlist[] = { "remote", "local", "raw", "codec", "transfer_id", "dedup", NULL };
+
+  char * remote_filename;
+  char * local_filename;
+  int raw = FALSE;
+  char * requested_codec = NULL;
+  char * transfer_id = NULL;
+  int dedup = FALSE;
+  quickft_client_t * client;
+  int result = RESULT_CONNECTION_ERROR;
+
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "ss|izzi", kwlist, &remote_filename,
+                                                                  &local_filename,
+                                                                  &raw,
+                                                                  &requested_codec,
+                                                                  &transfer_id,
+                                                                  &dedup)) {
+    return NULL;
+  }
+
+  if ( ! session_begin(self) ) {
+    return NULL;
+  }
+
+  Py_BEGIN_ALLOW_THREADS
+
+  client = session_borrow(self);
+  if ( client != NULL ) {
+
+    result = client_send(client, self->addr, self->port, remote_filename, local_filename, raw, client_codec(requested_codec), transfer_id, dedup);
+    session_return(self, client);
+  }
+
+  Py_END_ALLOW_THREADS
+
+  return Py_BuildValue("i", result);
+}
+
+/**
+ * Performs a 'File Receive' operation on a client of the session,
+ * clrecv(remote, local, chunked=0, raw=0, codec=None, transfer_id=None)
+ *
+ */
+static PyObject * session_file_receive( SESSION_T * self, PyObject * args, PyObject * kwds ) {
+
+  static char * kwlist[] = { "remote", "local", "chunked", "raw", "codec", "transfer_id", NULL };
+
+  char * remote_filename;
+  char * local_filename;
+  int chunked = FALSE;
+  int raw = FALSE;
+  char * requested_codec = NULL;
+  char * transfer_id = NULL;
+  quickft_client_t * client;
+  int result = RESULT_CONNECTION_ERROR;
+
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "ss|iizz", kwlist, &remote_filename,
+                                                                  &local_filename,
+                                                                  &chunked,
+                                                                  &raw,
+                                                                  &requested_codec,
+                                                                  &transfer_id)) {
+    return NULL;
+  }
+
+  if ( ! session_begin(self) ) {
+    return NULL;
+  }
+
+  Py_BEGIN_ALLOW_THREADS
+
+  client = session_borrow(self);
+  if ( client != NULL ) {
+
+    result = client_receive(client, self->addr, self->port, remote_filename, local_filename, chunked, raw, client_codec(requested_codec), transfer_id);
+    session_return(self, client);
+  }
+
+  Py_END_ALLOW_THREADS
+
+  return Py_BuildValue("i", result);
+}
+
+/**
+ * Performs a 'File Receive' operation for a byte range of a file on a
+ * client of the session, clrecv_range(remote, local, offset, length=-1,
+ * raw=0, codec=None)
+ *
+ */
+static PyObject * session_file_receive_range( SESSION_T * self, PyObject * args, PyObject * kwds ) {
+
+  static char * kwlist[] = { "remote", "local", "offset", "length", "raw", "codec", NULL };
+
+  char * remote_filename;
+  char * local_filename;
+  PY_LONG_LONG offset;
+  PY_LONG_LONG length = -1;
+  int raw = FALSE;
+  char * requested_codec = NULL;
+  quickft_client_t * client;
+  int result = RESULT_CONNECTION_ERROR;
+
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "ssL|Liz", kwlist, &remote_filename,
+                                                                  &local_filename,
+                                                                  &offset,
+                                                                  &length,
+                                                                  &raw,
+                                                                  &requested_codec)) {
+    return NULL;
+  }
+
+  if ( ! session_begin(self) ) {
+    return NULL;
+  }
+
+  Py_BEGIN_ALLOW_THREADS
+
+  client = session_borrow(self);
+  if ( client != NULL ) {
+
+    result = client_receive_range(client, self->addr, self->port, remote_filename, local_filename, (long long)offset, (long long)length, raw, client_codec(requested_codec));
+    session_return(self, client);
+  }
+
+  Py_END_ALLOW_THREADS
+
+  return Py_BuildValue("i", result);
+}
+
+/**
+ * Performs a 'File Send' operation on a client of the session that only
+ * sends a delta against the file in the server, clsend_delta(remote, local,
+ * codec=None)
+ *
+ */
+static PyObject * session_file_send_delta( SESSION_T * self, PyObject * args, PyObject * kwds ) {
+
+  static char * kwlist[] = { "remote", "local", "codec", NULL };
+
+  char * remote_filename;
+  char * local_filename;
+  char * requested_codec = NULL;
+  quickft_client_t * client;
+  int result = RESULT_CONNECTION_ERROR;
+
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "ss|z", kwlist, &remote_filename,
+                                                             &local_filename,
+                                                             &requested_codec)) {
+    return NULL;
+  }
+
+  if ( ! session_begin(self) ) {
+    return NULL;
+  }
+
+  Py_BEGIN_ALLOW_THREADS
+
+  client = session_borrow(self);
+  if ( client != NULL ) {
+
+    result = client_send_delta(client, self->addr, self->port, remote_filename, local_filename, client_codec(requested_codec));
+    session_return(self, client);
+  }
+
+  Py_END_ALLOW_THREADS
+
+  return Py_BuildValue("i", result);
+}
+
+/**
+ * Performs a 'File Send' operation on a client of the session splitting
+ * the file into ranges sent over parallel connections,
+ * clsend_striped(remote, local, stripes=4, stripe_size=0, raw=0, codec=None)
+ *
+ */
+static PyObject * session_file_send_striped( SESSION_T * self, PyObject * args, PyObject * kwds ) {
+
+  static char * kwlist[] = { "remote", "local", "stripes", "stripe_size", "raw", "codec", NULL };
+
+  char * remote_filename;
+  char * local_filename;
+  int stripes = 4;
+  PY_LONG_LONG stripe_size = 0;
+  int raw = FALSE;
+  char * requested_codec = NULL;
+  quickft_client_t * client;
+  int result = RESULT_CONNECTION_ERROR;
+
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "ss|iLiz", kwlist, &remote_filename,
+                                                                  &local_filename,
+                                                                  &stripes,
+                                                                  &stripe_size,
+                                                                  &raw,
+                                                                  &requested_codec)) {
+    return NULL;
+  }
+
+  if ( ! session_begin(self) ) {
+    return NULL;
+  }
+
+  Py_BEGIN_ALLOW_THREADS
+
+  // The ranges go over connections of their own, the commit over the borrowed one
+  client = session_borrow(self);
+  if ( client != NULL ) {
+
+    result = client_send_striped(client, self->addr, self->port, remote_filename, local_filename, raw, client_codec(requested_codec), stripes, (long long)stripe_size);
+    session_return(self, client);
+  }
+
+  Py_END_ALLOW_THREADS
+
+  return Py_BuildValue("i", result);
+}
+
+/**
+ * Performs a 'File Delete' operation on a client of the session,
+ * cldel(remote)
+ *
+ */
+static PyObject * session_file_delete( SESSION_T * self, PyObject * args, PyObject * kwds ) {
+
+  static char * kwlist[] = { "remote", NULL };
+
+  char * remote_filename;
+  quickft_client_t * client;
+  int result = RESULT_CONNECTION_ERROR;
+
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "s", kwlist, &remote_filename)) {
+    return NULL;
+  }
+
+  if ( ! session_begin(self) ) {
+    return NULL;
+  }
+
+  Py_BEGIN_ALLOW_THREADS
+
+  client = session_borrow(self);
+  if ( client != NULL ) {
+
+    result = client_delete(client, self->addr, self->port, remote_filename);
+    session_return(self, client);
+  }
+
+  Py_END_ALLOW_THREADS
+
+  return Py_BuildValue("i", result);
+}
+
+/**
+ * Performs operations as a pipeline on a client of the session, with the GIL released
+ *
+ * @param session               session
+ * @param ops                   operations, that receive their results
+ * @param count                 number of operations
+ */
+static void session_perform( SESSION_T * session, CLIENT_OP_T * ops, int count ) {
+
+  quickft_client_t * client;
+  int index;
+
+  Py_BEGIN_ALLOW_THREADS
+
+  client = session_borrow(session);
+  if ( client != NULL ) {
+
+    client_pipeline(client, session->addr, session->port, ops, count);
+    session_return(session, client);
+  }
+  else {
+
+    for ( index = 0; index < count; index++ ) {
+      ops[index].result = RESULT_CONNECTION_ERROR;
+    }
+  }
+
+  Py_END_ALLOW_THREADS
+}
+
+/**
+ * Performs operations as a pipeline on a client of the session,
+ * pipeline(ops), where each operation is a tuple ('send', remote, local
+ * [, raw, codec]), ('recv', remote, local[, raw, codec]) or ('del', remote)
+ *
+ */
+static PyObject * session_file_pipeline( SESSION_T * self, PyObject * args, PyObject * kwds ) {
+
+  static char * kwlist[] = { "ops", NULL };
+
+  PyObject * py_sequence;
+  PyObject * py_ops;
+  PyObject * py_results;
+  CLIENT_OP_T * ops;
+  int count;
+
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "O", kwlist, &py_sequence)) {
+    return NULL;
+  }
+
+  if ( ! session_begin(self) ) {
+    return NULL;
+  }
+
+  py_ops = PySequence_Fast(py_sequence, "Operations must be a sequence.");
+  if ( py_ops == NULL ) {
+    return NULL;
+  }
+
+  ops = client_pipeline_ops(py_ops, &count);
+  if ( ops == NULL ) {
+
+    Py_DECREF(py_ops);
+    return NULL;
+  }
+
+  session_perform(self, ops, count);
+
+  py_results = client_pipeline_results(ops, count);
+
+  free(ops);
+  Py_DECREF(py_ops);
+
+  return py_results;
+}
+
+/**
+ * Performs a batch of File Send or File Receive operations on a client of
+ * the session, getting the result of each file and the time it took
+ *
+ * @param session               session
+ * @param args                  python arguments
+ * @param kwds                  python keyword arguments
+ * @param type                  FILE_SND_B or FILE_RCV_B
+ *
+ * @return                      python list
+ */
+static PyObject * session_file_batch( SESSION_T * session, PyObject * args, PyObject * kwds, int type ) {
+
+  static char * kwlist[] = { "files", "raw", "codec", NULL };
+
+  PyObject * py_sequence;
+  PyObject * py_files;
+  PyObject * py_results;
+  CLIENT_OP_T * ops;
+  int raw = FALSE;
+  char * requested_codec = NULL;
+  int count;
+
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|iz", kwlist, &py_sequence,
+                                                               &raw,
+                                                               &requested_codec)) {
+    return NULL;
+  }
+
+  if ( ! session_begin(session) ) {
+    return NULL;
+  }
+
+  py_files = PySequence_Fast(py_sequence, "Files must be a sequence.");
+  if ( py_files == NULL ) {
+    return NULL;
+  }
+
+  ops = client_batch_ops(py_files, type, raw, client_codec(requested_codec), &count);
+  if ( ops == NULL ) {
+
+    Py_DECREF(py_files);
+    return NULL;
+  }
+
+  session_perform(session, ops, count);
+
+  py_results = client_batch_results(ops, count);
+
+  free(ops);
+  Py_DECREF(py_files);
+
+  return py_results;
+}
+
+/**
+ * Sends files on a client of the session,
+ * clsend_many([(local, remote), ...], raw=0, codec=None)
+ *
+ */
+static PyObject * session_file_send_many( SESSION_T * self, PyObject * args, PyObject * kwds ) {
+
+  return session_file_batch(self, args, kwds, FILE_SND_B);
+}
+
+/**
+ * Receives files on a client of the session,
+ * clrecv_many([(remote, local), ...], raw=0, codec=None)
+ *
+ */
+static PyObject * session_file_receive_many( SESSION_T * self, PyObject * args, PyObject * kwds ) {
+
+  return session_file_batch(self, args, kwds, FILE_RCV_B);
+}
+
+/**
+ * Closes the session, operations performed afterwards fail
+ *
+ */
+static PyObject * session_close( SESSION_T * self ) {
+
+  if ( self->idle == NULL || self->closed ) {
+    return Py_BuildValue("i", FALSE);
+  }
+
+  Py_BEGIN_ALLOW_THREADS
+  session_shutdown(self);
+  Py_END_ALLOW_THREADS
+
+  return Py_BuildValue("i", TRUE);
+}
+
+/**
+ * Gets the counters of the session
+ *
+ */
+static PyObject * session_stats( SESSION_T * self ) {
+
+  SESSION_STATS_T stats;
+  int open_count;
+  int idle_count;
+
+  if ( self->idle == NULL ) {
+    Py_RETURN_NONE;
+  }
+
+  pthread_mutex_lock(&self->mutex);
+  stats = self->stats;
+  open_count = self->open_count;
+  idle_count = self->idle_count;
+  pthread_mutex_unlock(&self->mutex);
+
+  return Py_BuildValue("{s:i,s:i,s:i,s:i,s:K,s:K,s:K,s:K,s:K}",
+                       "pool_size",       self->pool_size,
+                       "open",            open_count,
+                       "idle",            idle_count,
+                       "closed",          self->closed,
+                       "operations",      stats.operations,
+                       "connects",        stats.connects,
+                       "reconnects",      stats.reconnects,
+                       "health_failures", stats.health_failures,
+                       "waits",           stats.waits);
+}
+
+// Python method definitions
+static PyMethodDef session_methods[] = {
+    { "clsend",     (PyCFunction)session_file_send,     METH_VARARGS | METH_KEYWORDS, NULL },
+    { "clrecv",     (PyCFunction)session_file_receive,  METH_VARARGS | METH_KEYWORDS, NULL },
+    { "clrecv_range",(PyCFunction)session_file_receive_range,METH_VARARGS | METH_KEYWORDS, NULL },
+    { "clsend_delta",(PyCFunction)session_file_send_delta,METH_VARARGS | METH_KEYWORDS, NULL },
+    { "clsend_striped",(PyCFunction)session_file_send_striped,METH_VARARGS | METH_KEYWORDS, NULL },
+    { "cldel",      (PyCFunction)session_file_delete,   METH_VARARGS | METH_KEYWORDS, NULL },
+    { "pipeline",   (PyCFunction)session_file_pipeline, METH_VARARGS | METH_KEYWORDS, NULL },
+    { "clsend_many",(PyCFunction)session_file_send_many,METH_VARARGS | METH_KEYWORDS, NULL },
+    { "clrecv_many",(PyCFunction)session_file_receive_many,METH_VARARGS | METH_KEYWORDS, NULL },
+    { "close",      (PyCFunction)session_close,         METH_NOARGS,                  NULL },
+    { "stats",      (PyCFunction)session_stats,         METH_NOARGS,                  NULL },
+    { NULL,         NULL,                               0,                            NULL }
+};
+
+// Python type definition
+static PyTypeObject session_type = {
+    PyObject_HEAD_INIT(NULL)
+    0,                                          // ob_size
+    SESSION_TYPE_NAME,                          // tp_name
+    sizeof(SESSION_T),                          // tp_basicsize
+    0,                                          // tp_itemsize
+    (destructor)session_dealloc,                // tp_dealloc
+    0,                                          // tp_print
+    0,                                          // tp_getattr
+    0,                                          // tp_setattr
+    0,                                          // tp_compare
+    0,                                          // tp_repr
+    0,                                          // tp_as_number
+    0,                                          // tp_as_sequence
+    0,                                          // tp_as_mapping
+    0,                                          // tp_hash
+    0,                                          // tp_call
+    0,                                          // tp_str
+    0,                                          // tp_getattro
+    0,                                          // tp_setattro
+    0,                                          // tp_as_buffer
+    Py_TPFLAGS_DEFAULT,                         // tp_flags
+    "Pool of connections to a QuickFT server",  // tp_doc
+    0,                                          // tp_traverse
+    0,                                          // tp_clear
+    0,                                          // tp_richcompare
+    0,                                          // tp_weaklistoffset
+    0,                                          // tp_iter
+    0,                                          // tp_iternext
+    session_methods,                            // tp_methods
+    0,                                          // tp_members
+    0,                                          // tp_getset
+    0,                                          // tp_base
+    0,                                          // tp_dict
+    0,                                          // tp_descr_get
+    0,                                          // tp_descr_set
+    0,                                          // tp_dictoffset
+    (initproc)session_init,                     // tp_init
+    0,                                          // tp_alloc
+    PyType_GenericNew,                          // tp_new
+};
+
+/**
+ * Adds the Session type to the module
+ *
+ * @param module          python module
+ *
+ * @return                TRUE or FALSE
+ */
+int session_register( PyObject * module ) {
+
+  PyObject * type = (PyObject *)&session_type;
+
+  if ( PyType_Ready(&session_type) < 0 ) {
+    return FALSE;
+  }
+
+  Py_INCREF(type);
+  PyModule_AddObject(module, "Session", type);
+
+  return TRUE;
+}
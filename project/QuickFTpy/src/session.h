@@ -0,0 +1,80 @@
+/*
+ * session.h
+ *
+ * $Id: $
+ * $HeadURL: $
+ * $LastChangedRevision: $
+ * $LastChangedDate: $
+ * $LastChangedBy: $
+ *
+ */
+
+#ifndef SESSION_H
+#define SESSION_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <python2.7/Python.h>
+#include <pthread.h>
+
+#include "macros.h"
+#include "client.h"
+
+#define SESSION_TYPE_NAME         "quickftpy.Session"
+#define SESSION_DEFAULT_POOL_SIZE 4
+#define SESSION_MAX_POOL_SIZE     64
+
+// Counters of a session
+typedef struct _session_stats_t {
+
+  unsigned long long operations;
+  unsigned long long connects;          // connections opened for new clients
+  unsigned long long reconnects;        // connections opened again for pooled clients
+  unsigned long long health_failures;   // kept connections found closed before being used
+  unsigned long long waits;             // operations that waited for a free client
+
+} SESSION_STATS_T;
+
+// Python object that performs operations on a server through
+// a pool of clients whose connections are kept open between them
+typedef struct _session_t {
+
+  PyObject_HEAD
+
+  char addr[_BUFFER_SIZE_XS];
+  char port[_BUFFER_SIZE_XS];
+  long timeout;
+  long timeout_ack;
+  PyObject * py_log_writer;
+
+  // Clients not in use, up to pool_size of them are created
+  // on demand and each one connects again when it needs to
+  int pool_size;
+  int open_count;
+  int idle_count;
+  quickft_client_t ** idle;
+  int closed;
+
+  pthread_mutex_t mutex;
+  pthread_cond_t available;
+
+  SESSION_STATS_T stats;
+
+} SESSION_T;
+
+/**
+ * Adds the Session type to the module
+ *
+ * @param module          python module
+ *
+ * @return                TRUE or FALSE
+ */
+int session_register( PyObject * module );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SESSION_H
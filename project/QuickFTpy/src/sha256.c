@@ -0,0 +1,241 @@
+/*
+ * sha256.c
+ *
+ * $Id: $
+ * $HeadURL: $
+ * $LastChangedRevision: $
+ * $LastChangedDate: $
+ * $LastChangedBy: $
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "sha256.h"
+#include "macros.h"
+
+#define ROTR(x,n)   ( ( (x) >> (n) ) | ( (x) << ( 32 - (n) ) ) )
+
+// Round constants, the first 32 bits of the fractional parts
+// of the cube roots of the first 64 primes
+static const uint32_t sha256_k[64] = {
+  0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+  0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+  0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+  0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+  0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+  0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+  0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+  0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+/**
+ * Hashes a block of 64 bytes
+ *
+ * @param sha             state of the computation
+ * @param block           block
+ */
+static void sha256_transform( SHA256_T* sha, const unsigned char* block ) {
+
+  uint32_t w[64];
+  uint32_t a, b, c, d, e, f, g, h;
+  uint32_t t1, t2;
+  int i;
+
+  for ( i = 0; i < 16; i++ ) {
+    w[i] = ( (uint32_t)block[i * 4] << 24 ) | ( (uint32_t)block[i * 4 + 1] << 16 ) | ( (uint32_t)block[i * 4 + 2] << 8 ) | block[i * 4 + 3];
+  }
+  for ( i = 16; i < 64; i++ ) {
+    w[i] = ( ROTR(w[i - 2], 17) ^ ROTR(w[i - 2], 19) ^ ( w[i - 2] >> 10 ) ) + w[i - 7] +
+           ( ROTR(w[i - 15], 7) ^ ROTR(w[i - 15], 18) ^ ( w[i - 15] >> 3 ) ) + w[i - 16];
+  }
+
+  a = sha->state[0];
+  b = sha->state[1];
+  c = sha->state[2];
+  d = sha->state[3];
+  e = sha->state[4];
+  f = sha->state[5];
+  g = sha->state[6];
+  h = sha->state[7];
+
+  for ( i = 0; i < 64; i++ ) {
+
+    t1 = h + ( ROTR(e, 6) ^ ROTR(e, 11) ^ ROTR(e, 25) ) + ( ( e & f ) ^ ( ~e & g ) ) + sha256_k[i] + w[i];
+    t2 = ( ROTR(a, 2) ^ ROTR(a, 13) ^ ROTR(a, 22) ) + ( ( a & b ) ^ ( a & c ) ^ ( b & c ) );
+
+    h = g;
+    g = f;
+    f = e;
+    e = d + t1;
+    d = c;
+    c = b;
+    b = a;
+    a = t1 + t2;
+  }
+
+  sha->state[0] += a;
+  sha->state[1] += b;
+  sha->state[2] += c;
+  sha->state[3] += d;
+  sha->state[4] += e;
+  sha->state[5] += f;
+  sha->state[6] += g;
+  sha->state[7] += h;
+}
+
+/**
+ * Initializes a SHA-256 computation
+ *
+ * @param sha             state of the computation
+ */
+void sha256_init( SHA256_T* sha ) {
+
+  sha->state[0] = 0x6a09e667;
+  sha->state[1] = 0xbb67ae85;
+  sha->state[2] = 0x3c6ef372;
+  sha->state[3] = 0xa54ff53a;
+  sha->state[4] = 0x510e527f;
+  sha->state[5] = 0x9b05688c;
+  sha->state[6] = 0x1f83d9ab;
+  sha->state[7] = 0x5be0cd19;
+  sha->len = 0;
+  sha->block_len = 0;
+}
+
+/**
+ * Hashes a fragment of data
+ *
+ * @param sha             state of the computation
+ * @param data            data fragment
+ * @param len             fragment length
+ */
+void sha256_update( SHA256_T* sha, const unsigned char* data, size_t len ) {
+
+  size_t chunk;
+
+  sha->len += len;
+
+  // Completes the block left from the previous fragment
+  if ( sha->block_len > 0 ) {
+
+    chunk = ( len < 64 - sha->block_len ) ? len : 64 - sha->block_len;
+    memcpy(&sha->block[sha->block_len], data, chunk);
+    sha->block_len += chunk;
+    data += chunk;
+    len -= chunk;
+
+    if ( sha->block_len < 64 ) {
+      return;
+    }
+
+    sha256_transform(sha, sha->block);
+    sha->block_len = 0;
+  }
+
+  for ( ; len >= 64; data += 64, len -= 64 ) {
+    sha256_transform(sha, data);
+  }
+
+  memcpy(sha->block, data, len);
+  sha->block_len = len;
+}
+
+/**
+ * Completes a SHA-256 computation
+ *
+ * @param sha             state of the computation
+ * @param digest          returns the digest, SHA256_DIGEST_LEN bytes
+ */
+void sha256_final( SHA256_T* sha, unsigned char* digest ) {
+
+  uint64_t bits = sha->len * 8;
+  int i;
+
+  // Pads with a bit set, zeros and the length in bits
+  sha->block[sha->block_len++] = 0x80;
+
+  if ( sha->block_len > 56 ) {
+
+    memset(&sha->block[sha->block_len], 0x00, 64 - sha->block_len);
+    sha256_transform(sha, sha->block);
+    sha->block_len = 0;
+  }
+
+  memset(&sha->block[sha->block_len], 0x00, 56 - sha->block_len);
+
+  for ( i = 0; i < 8; i++ ) {
+    sha->block[56 + i] = (unsigned char)( bits >> ( 56 - i * 8 ) );
+  }
+
+  sha256_transform(sha, sha->block);
+
+  for ( i = 0; i < 8; i++ ) {
+
+    digest[i * 4]     = (unsigned char)( sha->state[i] >> 24 );
+    digest[i * 4 + 1] = (unsigned char)( sha->state[i] >> 16 );
+    digest[i * 4 + 2] = (unsigned char)( sha->state[i] >> 8 );
+    digest[i * 4 + 3] = (unsigned char)( sha->state[i] );
+  }
+}
+
+/**
+ * Computes the SHA-256 digest of the whole content of a file
+ *
+ * @param fd              descriptor of the file, read from its beginning
+ * @param digest          returns the digest, SHA256_DIGEST_LEN bytes
+ *
+ * @return                TRUE or FALSE
+ */
+int sha256_file( int fd, unsigned char* digest ) {
+
+  unsigned char * buffer;
+  SHA256_T sha;
+  off_t offset = 0;
+  ssize_t bread;
+
+  buffer = (unsigned char*)malloc(SHA256_FILE_BUFFER_SIZE);
+
+  if ( buffer == NULL ) {
+    return FALSE;
+  }
+
+  sha256_init(&sha);
+
+  while ( ( bread = pread(fd, buffer, SHA256_FILE_BUFFER_SIZE, offset) ) > 0 ) {
+
+    sha256_update(&sha, buffer, (size_t)bread);
+    offset += bread;
+  }
+
+  free(buffer);
+
+  sha256_final(&sha, digest);
+
+  return ( bread == 0 );
+}
+
+/**
+ * Writes a digest in hexadecimal
+ *
+ * @param digest          digest, SHA256_DIGEST_LEN bytes
+ * @param hex             buffer of SHA256_HEX_LEN + 1 bytes
+ *
+ * @return                hex
+ */
+char* sha256_hex( const unsigned char* digest, char* hex ) {
+
+  static const char digits[] = "0123456789abcdef";
+  int i;
+
+  for ( i = 0; i < SHA256_DIGEST_LEN; i++ ) {
+
+    hex[i * 2]     = digits[digest[i] >> 4];
+    hex[i * 2 + 1] = digits[digest[i] & 0x0F];
+  }
+  hex[SHA256_HEX_LEN] = '\0';
+
+  return hex;
+}
@@ -0,0 +1,90 @@
+/*
+ * sha256.h
+ *
+ * $Id: $
+ * $HeadURL: $
+ * $LastChangedRevision: $
+ * $LastChangedDate: $
+ * $LastChangedBy: $
+ *
+ */
+
+#ifndef _SHA256_H
+#define _SHA256_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdlib.h>
+#include <stdint.h>
+
+// Length of a digest, and of its hexadecimal form without the terminator
+#define SHA256_DIGEST_LEN     32
+#define SHA256_HEX_LEN        64
+
+// Size of the buffer a file is read through, allocated on the heap as
+// digests are computed on the workers of the pool
+#define SHA256_FILE_BUFFER_SIZE ( 256 * 1024 )
+
+/**
+ * State of an incremental SHA-256 computation
+ */
+typedef struct _sha256_t {
+
+  uint32_t state[8];
+  uint64_t len;             // bytes hashed so far
+  unsigned char block[64];  // data not yet hashed
+  size_t block_len;
+
+} SHA256_T;
+
+/**
+ * Initializes a SHA-256 computation
+ *
+ * @param sha             state of the computation
+ */
+void sha256_init( SHA256_T* sha );
+
+/**
+ * Hashes a fragment of data
+ *
+ * @param sha             state of the computation
+ * @param data            data fragment
+ * @param len             fragment length
+ */
+void sha256_update( SHA256_T* sha, const unsigned char* data, size_t len );
+
+/**
+ * Completes a SHA-256 computation
+ *
+ * @param sha             state of the computation
+ * @param digest          returns the digest, SHA256_DIGEST_LEN bytes
+ */
+void sha256_final( SHA256_T* sha, unsigned char* digest );
+
+/**
+ * Computes the SHA-256 digest of the whole content of a file
+ *
+ * @param fd              descriptor of the file, read from its beginning
+ * @param digest          returns the digest, SHA256_DIGEST_LEN bytes
+ *
+ * @return                TRUE or FALSE
+ */
+int sha256_file( int fd, unsigned char* digest );
+
+/**
+ * Writes a digest in hexadecimal
+ *
+ * @param digest          digest, SHA256_DIGEST_LEN bytes
+ * @param hex             buffer of SHA256_HEX_LEN + 1 bytes
+ *
+ * @return                hex
+ */
+char* sha256_hex( const unsigned char* digest, char* hex );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // _SHA256_H
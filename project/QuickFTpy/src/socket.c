@@ -9,15 +9,27 @@
  *
  */
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE 1
+#endif
+
 #include <stdlib.h>
 #include <stdio.h>
 #include <errno.h>
 #include <string.h>
 
+#include <fcntl.h>
 #include <unistd.h>
 #include <sys/socket.h>
+#include <sys/sendfile.h>
+#include <sys/uio.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <arpa/inet.h>
+#include <linux/errqueue.h>
 
 #include "mutex.h"
 #include "socket.h"
@@ -171,6 +183,15 @@ SOCKET_T* socket_create(int side, char* addr, int port, int max_connections, int
   
   }
 
+  // Sends small messages right away, without waiting for the previous one
+  // to be acknowledged, which on a connection kept open between requests
+  // adds the delay of the peer's acknowledgment to every exchange
+  if ( side == 0 ) {
+
+    res = 1;
+    setsockopt(socket_handle, IPPROTO_TCP, TCP_NODELAY, (char *)&res, sizeof(res));
+  }
+
   // Configures timeouts for read/write
   {
     struct timeval timeout;      
@@ -224,65 +245,175 @@ int socket_accept(SOCKET_T * listen_socket, SOCKET_T ** accept_socket) {
   struct sockaddr sa_client;
   unsigned int sa_client_size = sizeof(sa_client);
   char buffer[1024];
-
-  MUTEX_LOCK(listen_socket->mutex);
+  int nodelay;
 
   if ( listen_socket != NULL ) {
 
-    // Allocates space for the socket structure
-    new_acc_socket = malloc(sizeof( SOCKET_T ));
-    memset(new_acc_socket, 0x00, sizeof( SOCKET_T ));
+    MUTEX_LOCK(listen_socket->mutex);
 
     // Accepts connection
     socket_handle = accept(listen_socket->handle, (struct sockaddr *) &sa_client, &sa_client_size);
     if (socket_handle == -1) {
 
-      if ( errno == EAGAIN || errno == EWOULDBLOCK ) {
-
-        // Returns invalid, no connections pending
-        free(new_acc_socket);
-        MUTEX_UNLOCK(listen_socket->mutex);
-        return FALSE;
-
-      } else {
+      // If errno is EAGAIN or EWOULDBLOCK there are no connections pending
+      if ( errno != EAGAIN && errno != EWOULDBLOCK ) {
         
         sprintf(buffer, "accept failed with error: %d\n", errno);
         LOGGER(__FUNCTION__, buffer);
-
-        free(new_acc_socket);
-        MUTEX_UNLOCK(listen_socket->mutex);
-        return FALSE;
       }
 
-    } else {
+      MUTEX_UNLOCK(listen_socket->mutex);
+      return FALSE;
 
-      // Stores the new socket handle in the structure
-      new_acc_socket->handle = socket_handle;
+    }
 
-      // Copies the structure to the output parameter
-      *accept_socket = new_acc_socket;
+    MUTEX_UNLOCK(listen_socket->mutex);
 
-      // Creates mutex for the new socket
-      (*accept_socket)->mutex = (MUTEX_T*)malloc(sizeof(struct _mutex_t) );
-      memset( (*accept_socket)->mutex, 0x00, sizeof(struct _mutex_t));
-      MUTEX_CREATE( &((*accept_socket)->mutex) );
+    // Sends small messages right away, as clients do
+    nodelay = 1;
+    setsockopt(socket_handle, IPPROTO_TCP, TCP_NODELAY, (char *)&nodelay, sizeof(nodelay));
 
-      MUTEX_UNLOCK(listen_socket->mutex);
+    // Allocates space for the socket structure
+    new_acc_socket = malloc(sizeof( SOCKET_T ));
+    memset(new_acc_socket, 0x00, sizeof( SOCKET_T ));
 
-      return TRUE;
-    }
-  }
+    // Stores the new socket handle in the structure
+    new_acc_socket->handle = socket_handle;
+
+    // Creates mutex for the new socket
+    new_acc_socket->mutex = (MUTEX_T*)malloc(sizeof(struct _mutex_t) );
+    memset( new_acc_socket->mutex, 0x00, sizeof(struct _mutex_t));
+    MUTEX_CREATE( &(new_acc_socket->mutex) );
+
+    // Copies the structure to the output parameter
+    *accept_socket = new_acc_socket;
 
-  MUTEX_UNLOCK(listen_socket->mutex);
+    return TRUE;
+  }
 
   return FALSE;
 
 }
 
+// Number of descriptors polled from a buffer on the stack, larger groups
+// being polled from one allocated for the time of the check
+#define SOCKET_SELECT_STACK_FDS   64
+
+/**
+ * Gets room for the descriptors polled by a check
+ *
+ * @param stack_fds             buffer on the stack of the caller, for
+ *                              SOCKET_SELECT_STACK_FDS descriptors
+ * @param count                 number of descriptors
+ *
+ * @return                      the descriptors, to be released with
+ *                              socket_select_fds_release(), or NULL
+ *                              if memory ran out
+ */
+static struct pollfd * socket_select_fds(struct pollfd * stack_fds, int count) {
+
+  if ( count <= SOCKET_SELECT_STACK_FDS ) {
+    return stack_fds;
+  }
+
+  return (struct pollfd *)malloc(count * sizeof(struct pollfd));
+}
+
+/**
+ * Releases the descriptors polled by a check
+ *
+ * @param stack_fds             buffer on the stack of the caller
+ * @param fds                   descriptors got with socket_select_fds()
+ */
+static void socket_select_fds_release(struct pollfd * stack_fds, struct pollfd * fds) {
+
+  if ( fds != stack_fds ) {
+    free(fds);
+  }
+}
+
+/**
+ * Gets the poll events of the operations checked on a socket
+ *
+ * @param operation_type        operation type: S_READ, S_WRITE, S_RW
+ *
+ * @return                      poll events
+ */
+static short socket_select_events(int operation_type) {
+
+  short events = 0;
+
+  if (operation_type & S_READ) {
+    events |= POLLIN;
+  }
+
+  if (operation_type & S_WRITE) {
+    events |= POLLOUT;
+  }
+
+  return events;
+}
+
+/**
+ * Gets the operations a socket is available for from the events polled,
+ * an error or a hangup making it available for those checked, as the
+ * operation that follows reports it
+ *
+ * @param operation_type        operation type checked: S_READ, S_WRITE, S_RW
+ * @param revents               events polled
+ *
+ * @return                      S_READ, S_WRITE, S_RW or 0
+ */
+static int socket_select_result(int operation_type, short revents) {
+
+  int retval = 0;
+
+  if ( (operation_type & S_READ) && (revents & (POLLIN | POLLHUP | POLLERR)) ) {
+    retval |= S_READ;
+  }
+
+  if ( (operation_type & S_WRITE) && (revents & (POLLOUT | POLLHUP | POLLERR)) ) {
+    retval |= S_WRITE;
+  }
+
+  return retval;
+}
+
+/**
+ * Polls descriptors
+ *
+ * @param fds                   descriptors
+ * @param count                 number of descriptors
+ * @param timeout               timeout in seconds, 0 to return at once
+ *                              or -1 for blocking
+ *
+ * @return                      number of descriptors with events, 0 on
+ *                              timeout or signal, or -1 if an error occurred
+ */
+static int socket_select_poll(struct pollfd * fds, int count, int timeout) {
+
+  char buffer[_BUFFER_SIZE_S];
+  int res;
+
+  res = poll(fds, count, ( timeout < 0 ) ? -1 : timeout * 1000);
+  if ( res == -1 ) {
+
+    if ( errno == EINTR ) {
+      return 0;
+    }
+
+    sprintf(buffer, "poll failed with error: %d\n", errno);
+    LOGGER(__FUNCTION__, buffer);
+  }
+
+  return res;
+}
+
 /**
  * Checks if a socket is available for reading and/or writing
  *
- * @param timeout               timeout, or 0 for blocking
+ * @param timeout               timeout in seconds, 0 to return at once
+ *                              or -1 for blocking
  * @param socket                socket to check state on
  * @param operation_type        operation type: S_READ, S_WRITE, S_RW
  *
@@ -292,11 +423,8 @@ int socket_accept(SOCKET_T * listen_socket, SOCKET_T ** accept_socket) {
  */
 int socket_select(int timeout, SOCKET_T * select_socket, int operation_type) {
 
-  fd_set* readfds = NULL;
-  fd_set* writefds = NULL;
-  struct timeval tval_timeout;
+  struct pollfd fd;
   char buffer[1024];
-  int retval = 0;
   int res;
 
   // Validates parameters
@@ -308,68 +436,87 @@ int socket_select(int timeout, SOCKET_T * select_socket, int operation_type) {
 
   }
 
-  // Configures timeout
-  tval_timeout.tv_sec = timeout;
-  tval_timeout.tv_usec = 0;
+  fd.fd = select_socket->handle;
+  fd.events = socket_select_events(operation_type);
+  fd.revents = 0;
+
+  res = socket_select_poll(&fd, 1, timeout);
+  if ( res <= 0 ) {
+    return res;
+  }
+
+  // The socket was closed under the check
+  if ( fd.revents & POLLNVAL ) {
+    return -1;
+  }
 
-  // Allocates memory for sets
-  readfds = (fd_set*)malloc(sizeof(fd_set));
-  writefds = (fd_set*)malloc(sizeof(fd_set));
+  return socket_select_result(operation_type, fd.revents);
+
+}
 
-  // Initializes sets
-  FD_ZERO(readfds);
-  FD_ZERO(writefds);
+/**
+ * Checks which sockets of a group are available for reading and/or writing
+ *
+ * @param timeout               timeout in seconds, 0 to return at once
+ *                              or -1 for blocking
+ * @param sockets               sockets to check, with the operations to check on each
+ * @param count                 number of sockets
+ * @param ready                 array to store the sockets available, with the
+ *                              operations they are available for. It may be
+ *                              the sockets array itself.
+ *
+ * @return                      number of sockets stored, 0 on timeout,
+ *                              or -1 if an error occurred
+ */
+int socket_select_batch(int timeout, SOCKET_READY_T * sockets, int count, SOCKET_READY_T * ready) {
 
-  // Locks the socket's mutex
-  MUTEX_LOCK(select_socket->mutex);
+  struct pollfd stack_fds[SOCKET_SELECT_STACK_FDS];
+  struct pollfd * fds;
+  int operation_type;
+  int stored = 0;
+  int iter;
+  int res;
 
-  // If has to check for reading
-  if (operation_type & S_READ) {
-    
-    // Adds socket to the read set
-    FD_SET( select_socket->handle, readfds );
+  if ( count <= 0 ) {
+    return 0;
   }
 
-  // If has to check for writing
-  if (operation_type & S_WRITE) {
+  fds = socket_select_fds(stack_fds, count);
+  if ( fds == NULL ) {
 
-    // Adds socket to the write set
-    FD_SET(select_socket->handle, writefds);
+    LOGGER(__FUNCTION__, "socket_select_batch fail: out of memory");
+    return -1;
   }
 
-  // Calls select function
-  res = select( (select_socket->handle)+1, readfds, writefds, NULL, &tval_timeout );
-  if (res == -1) {
+  for ( iter = 0; iter < count; iter++ ) {
 
-    sprintf(buffer, "select failed with error: %d\n", errno);
-    LOGGER(__FUNCTION__, buffer);
-    
-    retval = -1;
-    goto end_select;
+    fds[iter].fd = sockets[iter].socket->handle;
+    fds[iter].events = socket_select_events(sockets[iter].operation_type);
+    fds[iter].revents = 0;
   }
 
-  // If socket is on the read result set
-  // adds to return value
-  if ( FD_ISSET(select_socket->handle, readfds ) ) {
-    retval += S_READ;
-  }
+  res = socket_select_poll(fds, count, timeout);
+  if ( res <= 0 ) {
 
-  // If socket is on the write result set
-  // adds to return value
-  if ( FD_ISSET(select_socket->handle, writefds ) ) {
-    retval += S_WRITE;
+    socket_select_fds_release(stack_fds, fds);
+    return res;
   }
 
-end_select:
+  // Stores the available sockets in order, never past the one read
+  for ( iter = 0; iter < count && stored < res; iter++ ) {
 
-  // Unlocks the socket's mutex
-  MUTEX_UNLOCK(select_socket->mutex);
+    operation_type = socket_select_result(sockets[iter].operation_type, fds[iter].revents);
+    if ( operation_type != 0 ) {
 
-  // Frees allocated memory
-  free(readfds);
-  free(writefds);
+      ready[stored].socket = sockets[iter].socket;
+      ready[stored].operation_type = operation_type;
+      stored++;
+    }
+  }
 
-  return retval;
+  socket_select_fds_release(stack_fds, fds);
+
+  return stored;
 
 }
 
@@ -379,7 +526,8 @@ end_select:
  * Upon return the lists will be already updated, having removed de nodes correponding
  * to sockets that were not available for the requested operations (read/write)
  * 
- * @param timeout               timeout, or 0 for blocking
+ * @param timeout               timeout in seconds, 0 to return at once
+ *                              or -1 for blocking
  * @param read_s                pointer to a socket list to check for read availability, or NULL if does not apply
  * @param write_s               pointer to a socket list to check for write availability, or NULL if does not apply
  *
@@ -387,179 +535,105 @@ end_select:
  */
 int socket_select_multiple(int timeout, list_t* read_s, list_t* write_s ) {
 
+  list_t * lists[2];
+  short events[2] = { POLLIN, POLLOUT };
+  int operations[2] = { S_READ, S_WRITE };
   list_node_t * seeker = NULL;
   list_node_t * remover = NULL;
-  SOCKET_T * ptr_socket = NULL;
-  fd_set* readfds = NULL;
-  fd_set* writefds = NULL;
-  struct timeval tval_timeout;
-  int lockstate;
-  char buffer[1024];
+  struct pollfd stack_fds[SOCKET_SELECT_STACK_FDS];
+  struct pollfd * fds;
+  int count = 0;
+  int iter;
   int res;
 
-  // configures timeout
-  tval_timeout.tv_sec = timeout;
-  tval_timeout.tv_usec = 0;
-
-  // Reserva memoria para los sets
-  readfds = (fd_set*)malloc(sizeof(fd_set));
-  writefds = (fd_set*)malloc(sizeof(fd_set));
-
-  // Initializes sets
-  FD_ZERO(readfds);
-  FD_ZERO(writefds);
+  lists[0] = read_s;
+  lists[1] = write_s;
 
-  // Iterates through the read sockets list
-  seeker = read_s->first;
-  while ( seeker != NULL) {
-
-    ptr_socket = seeker->content;
-    if (ptr_socket != NULL) {
-
-      // Puts a lock on the socket's mutex
-      MUTEX_LOCK(ptr_socket->mutex);
-
-      // Adds socket to the read set
-      FD_SET( ptr_socket->handle, readfds);
+  // Counts the sockets to check
+  for ( iter = 0; iter < 2; iter++ ) {
 
+    if ( lists[iter] == NULL ) {
+      continue;
     }
 
-    seeker = seeker->next;
-  
-  }
-
-  // Iterates through the write sockets list
-  seeker = write_s->first;
-  while ( seeker != NULL) {
-
-    ptr_socket = seeker->content;
-    if (ptr_socket != NULL) {
-
-      // If it is not locked
-      lockstate = MUTEX_IS_LOCKED(ptr_socket->mutex); 
-      if ( lockstate == FALSE ) {
-
-        // Puts a lock on the socket's mutex
-        MUTEX_LOCK(ptr_socket->mutex);
+    for ( seeker = lists[iter]->first; seeker != NULL; seeker = seeker->next ) {
 
+      if ( seeker->content != NULL ) {
+        count++;
       }
-
-      // Adds socket to the write set
-      FD_SET( ptr_socket->handle, writefds );
-    
     }
-
-    seeker = seeker->next;
-  
   }
 
-  // Calls the select function with the generated sets
-  res = select(0, readfds, writefds, NULL, &tval_timeout);
-  if (res == -1) {
-
-    sprintf(buffer, "select failed with error: %d\n", errno);
-    LOGGER(__FUNCTION__, buffer);
-    
-    // Frees memory
-    free(readfds);
-    free(writefds);
+  fds = socket_select_fds(stack_fds, count);
+  if ( count > 0 && fds == NULL ) {
 
+    LOGGER(__FUNCTION__, "socket_select_multiple fail: out of memory");
     return FALSE;
-
   }
-  
-  //
-  // Goes through the socket lists checking for the available ones and
-  // removing the ones that are not available
-  //
-
-  //
-  // Goes through the read list
-  //
-  seeker = read_s->first;
-  while ( seeker != NULL) {
-
-    ptr_socket = seeker->content;
-    if (ptr_socket != NULL) {
 
-      // If a socket is not available for reading
-      if ( !FD_ISSET( ptr_socket->handle, readfds) ) {
-        
-        // Removes the socket from the list
-        remover = seeker;
-        seeker = seeker->next;
-
-        LIST_REMOVE(read_s, remover, NULL);
+  // Adds the sockets of both lists, those of the read list first
+  count = 0;
+  for ( iter = 0; iter < 2; iter++ ) {
 
-        // Removes the lock on the mutex
-        MUTEX_UNLOCK(ptr_socket->mutex);
+    if ( lists[iter] == NULL ) {
+      continue;
+    }
 
-        // Moves to the next
-        continue;
+    for ( seeker = lists[iter]->first; seeker != NULL; seeker = seeker->next ) {
 
-      } else {
+      if ( seeker->content != NULL ) {
 
-        // Removes the lock on the mutex
-        MUTEX_UNLOCK(ptr_socket->mutex);
-      
+        fds[count].fd = ((SOCKET_T *)seeker->content)->handle;
+        fds[count].events = events[iter];
+        fds[count].revents = 0;
+        count++;
       }
-    
     }
+  }
+
+  res = socket_select_poll(fds, count, timeout);
+  if ( res == -1 ) {
 
-    // Moves to the next
-    seeker = seeker->next;
+    socket_select_fds_release(stack_fds, fds);
+    return FALSE;
   }
 
   //
-  // Goes through the write list
+  // Goes through the socket lists, in the order they were added,
+  // removing the sockets that are not available
   //
-  seeker = write_s->first;
-  while ( seeker != NULL) {
+  count = 0;
+  for ( iter = 0; iter < 2; iter++ ) {
 
-    ptr_socket = seeker->content;
-    if (ptr_socket != NULL) {
+    if ( lists[iter] == NULL ) {
+      continue;
+    }
 
-      // If it is not locked
-      lockstate = MUTEX_IS_LOCKED(ptr_socket->mutex); 
-      if ( lockstate == FALSE ) {
+    seeker = lists[iter]->first;
+    while ( seeker != NULL ) {
 
-        // Puts a lock on the socket's mutex
-        MUTEX_LOCK(ptr_socket->mutex);
-      
-      }
+      if ( seeker->content != NULL ) {
 
-      // If socket is not available for writing
-      if ( !FD_ISSET( ptr_socket->handle, writefds) ) {
+        // If a socket is not available for the operation
+        if ( socket_select_result(operations[iter], fds[count++].revents) == 0 ) {
 
-        // Removes the socket from the list
-        remover = seeker;
-        seeker = seeker->next;
+          // Removes the socket from the list
+          remover = seeker;
+          seeker = seeker->next;
 
-        LIST_REMOVE(write_s, remover, NULL);
+          LIST_REMOVE(lists[iter], remover, NULL);
 
-        // Removes the lock on the socket's mutex
-        MUTEX_UNLOCK(ptr_socket->mutex);
-        
-        // Moves to the next
-        continue;
-      
-      } else {
-        
-        // Removes the lock on the socket's mutex      
-        MUTEX_UNLOCK(ptr_socket->mutex);        
-      
+          // Moves to the next
+          continue;
+        }
       }
 
+      // Moves to the next
+      seeker = seeker->next;
     }
-
-    // Moves to the next
-    seeker = seeker->next;
-  
   }
 
-  // Frees memory
-  free(readfds);
-  free(writefds);
+  socket_select_fds_release(stack_fds, fds);
 
   return TRUE;
 
@@ -624,6 +698,12 @@ int socket_recv(SOCKET_T* recv_socket, char** data_buffer, int* len) {
     // Removes the lock
     MUTEX_UNLOCK(recv_socket->mutex);
 
+    // Nothing read on a socket reported as readable means
+    // the connection was closed by the peer
+    if ( res == 0 ) {
+      return FALSE;
+    }
+
     return TRUE;
 
   }
@@ -691,48 +771,126 @@ int socket_send(SOCKET_T* send_socket, char* send_buffer, int len, int * bytes_s
 }
 
 /**
- * Finalizes, closes, and destroys a socket previously created with SOCKET_CRATE
+ * Sends data through a connected socket without ever blocking, even if
+ * the socket is a blocking one. What the socket cannot take at once is
+ * not sent.
  *
- * @param close_socket          pointer by reference to the socket data structure
+ * @param send_socket           connected socket for sending data
+ * @param send_buffer           buffer containing the data to be sent
+ * @param len                   number of bytes to send
+ * @param bytes_sent            output parameter, returns number of bytes sent
  *
  * @return                      TRUE or FALSE
  */
-int socket_close(SOCKET_T** close_socket) {
+int socket_send_nowait(SOCKET_T* send_socket, const char* send_buffer, int len, int * bytes_sent) {
+
+  int res;
+
+  *bytes_sent = 0;
+
+  if ( (send_socket == NULL) || (send_buffer == NULL) ) {
+    return FALSE;
+  }
+
+  res = send(send_socket->handle, send_buffer, len, MSG_NOSIGNAL | MSG_DONTWAIT);
+  if ( res == -1 ) {
+    return ( errno == EAGAIN || errno == EWOULDBLOCK );
+  }
+
+  *bytes_sent = res;
+
+  return TRUE;
+
+}
+
+/**
+ * Sends several buffers through a connected socket in a single call.
+ *
+ * If the socket is non-blocking and the operation turns out to be blocking
+ * the function returns immediatly with a TRUE return value.
+ *
+ * @param send_socket           connected socket for sending data
+ * @param iov                   buffers to send
+ * @param iov_count             number of buffers
+ * @param zerocopy              TRUE to send with MSG_ZEROCOPY where available,
+ *                              the buffers then must not be modified until
+ *                              socket_zerocopy_wait() succeeds
+ * @param bytes_sent            output parameter, returns number of bytes sent
+ *
+ * @return                      TRUE or FALSE
+ */
+int socket_sendv(SOCKET_T* send_socket, const struct iovec* iov, int iov_count, int zerocopy, int * bytes_sent) {
 
   char buffer[1024];
+  struct msghdr msg;
+  int flags = MSG_NOSIGNAL;
   int res;
 
-  if ( close_socket && *close_socket ) {
+  if ( (send_socket != NULL) && (iov != NULL) ) {
 
-    // Puts a lock on the mutex
-    MUTEX_LOCK( (*(close_socket))->mutex );
+    memset(&msg, 0x00, sizeof(struct msghdr));
+    msg.msg_iov = (struct iovec*)iov;
+    msg.msg_iovlen = iov_count;
 
-    // Shuts down the socket for send and receive
-    shutdown( (*(close_socket))->handle, SHUT_RDWR );
-    
-    // Closes the socket
-    res = close( (*(close_socket))->handle );
-    if (res == -1) {
+    MUTEX_LOCK(send_socket->mutex);
 
-      // Removes the lock on the mutex
-      MUTEX_UNLOCK( (*(close_socket))->mutex );
+#if defined(MSG_ZEROCOPY) && defined(SO_ZEROCOPY)
+    if ( zerocopy ) {
 
-      sprintf(buffer, "shutdown failed with error: %d\n", errno);
-      LOGGER(__FUNCTION__, buffer);
-  
-      return FALSE;
+      // Enables zero copy sends the first time they are asked for
+      if ( send_socket->zerocopy == 0 ) {
+
+        res = 1;
+        send_socket->zerocopy = ( setsockopt(send_socket->handle, SOL_SOCKET, SO_ZEROCOPY, &res, sizeof(res)) == 0 ) ? 1 : -1;
+      }
 
+      if ( send_socket->zerocopy == 1 ) {
+        flags |= MSG_ZEROCOPY;
+      }
     }
+#endif
 
-    // Removes the lock on the mutex and destroys it
-    MUTEX_UNLOCK( (*(close_socket))->mutex );
-    MUTEX_DESTROY( &( (*(close_socket))->mutex) );
-    
-    // Frees previously allocated memory
-    free( (*(close_socket))->mutex );
+    // Attempts to send data
+    res = sendmsg(send_socket->handle, &msg, flags);
 
-    // Frees memory from the socket structure
-    free( *close_socket );
+#if defined(MSG_ZEROCOPY) && defined(SO_ZEROCOPY)
+    if ( flags & MSG_ZEROCOPY ) {
+
+      // The pages could not be pinned, copies them instead
+      if ( res == -1 && errno == ENOBUFS ) {
+
+        flags &= ~MSG_ZEROCOPY;
+        res = sendmsg(send_socket->handle, &msg, flags);
+
+      } else if ( res >= 0 ) {
+        send_socket->zerocopy_sent++;
+      }
+    }
+#endif
+
+    if ( res == -1 ) {
+
+      // Updates value of result
+      *bytes_sent = 0;
+
+      // Removes the lock
+      MUTEX_UNLOCK(send_socket->mutex);
+
+      if ( errno == EAGAIN || errno == EWOULDBLOCK ) {
+        return TRUE;
+      } else {
+        sprintf(buffer, "sendmsg failed with error: %d\n", errno);
+        LOGGER(__FUNCTION__, buffer);
+        return FALSE;
+      }
+
+    }
+
+    // Updates value of result
+    *bytes_sent = res;
+
+    // Removes the lock
+    MUTEX_UNLOCK(send_socket->mutex);
 
     return TRUE;
 
@@ -743,12 +901,269 @@ int socket_close(SOCKET_T** close_socket) {
 }
 
 /**
- * Disables both send and receive operations in a socket
- * without checking if the socket is being used.
+ * Waits for the kernel to release the buffers of the sends made with
+ * MSG_ZEROCOPY through a socket
  *
- * @param socket                pointer by reference to the socket structure to shut down
+ * @param zerocopy_socket       connected socket
+ * @param timeout               timeout in milliseconds, 0 to only collect
+ *                              the releases already notified
  *
- * @return                      TRUE or FALSE
+ * @return                      TRUE if every buffer was released, otherwise FALSE
+ */
+int socket_zerocopy_wait(SOCKET_T* zerocopy_socket, int timeout) {
+
+#if defined(MSG_ZEROCOPY) && defined(SO_ZEROCOPY)
+  char buffer[1024];
+  char control[128];
+  struct msghdr msg;
+  struct cmsghdr * cmsg;
+  struct sock_extended_err * serr;
+  struct pollfd pfd;
+  int res;
+
+  if ( zerocopy_socket == NULL ) {
+    return FALSE;
+  }
+
+  while ( zerocopy_socket->zerocopy_done != zerocopy_socket->zerocopy_sent ) {
+
+    memset(&msg, 0x00, sizeof(struct msghdr));
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    MUTEX_LOCK(zerocopy_socket->mutex);
+
+    // Each notification covers a range of sends
+    res = recvmsg(zerocopy_socket->handle, &msg, MSG_ERRQUEUE | MSG_DONTWAIT);
+    if ( res != -1 ) {
+
+      for ( cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg) ) {
+
+        if ( !( (cmsg->cmsg_level == SOL_IP && cmsg->cmsg_type == IP_RECVERR) ||
+                (cmsg->cmsg_level == SOL_IPV6 && cmsg->cmsg_type == IPV6_RECVERR) ) ) {
+          continue;
+        }
+
+        serr = (struct sock_extended_err *)CMSG_DATA(cmsg);
+        if ( serr->ee_origin != SO_EE_ORIGIN_ZEROCOPY || serr->ee_errno != 0 ) {
+          continue;
+        }
+
+        zerocopy_socket->zerocopy_done += serr->ee_data - serr->ee_info + 1;
+
+        // The kernel copied the data anyway, as it does on loopback,
+        // pinning the pages is not worth it on this connection
+        if ( serr->ee_code & SO_EE_CODE_ZEROCOPY_COPIED ) {
+          zerocopy_socket->zerocopy = -1;
+        }
+      }
+    }
+
+    MUTEX_UNLOCK(zerocopy_socket->mutex);
+
+    if ( res != -1 ) {
+      continue;
+    }
+
+    if ( errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR ) {
+
+      sprintf(buffer, "recvmsg failed with error: %d\n", errno);
+      LOGGER(__FUNCTION__, buffer);
+      return FALSE;
+    }
+
+    if ( timeout <= 0 ) {
+      return FALSE;
+    }
+
+    // Notifications are reported as errors
+    pfd.fd = zerocopy_socket->handle;
+    pfd.events = 0;
+    pfd.revents = 0;
+
+    res = poll(&pfd, 1, timeout);
+    if ( res == 0 ) {
+      return FALSE;
+    }
+    if ( res == -1 && errno != EINTR ) {
+      return FALSE;
+    }
+  }
+#endif
+
+  return TRUE;
+
+}
+
+/**
+ * Sends part of a file through a connected socket, straight from the
+ * page cache without copying it to user space.
+ *
+ * If the socket is non-blocking and the operation turns out to be blocking
+ * the function returns immediatly with a TRUE return value.
+ *
+ * @param send_socket           connected socket for sending data
+ * @param fd                    descriptor of the file
+ * @param offset                offset of the data in the file, updated
+ *                              after the operation
+ * @param len                   number of bytes to send
+ * @param bytes_sent            output parameter, returns number of bytes sent
+ *
+ * @return                      TRUE or FALSE
+ */
+int socket_sendfile(SOCKET_T* send_socket, int fd, long long* offset, int len, int * bytes_sent) {
+
+  char buffer[1024];
+  off_t file_offset;
+  ssize_t res;
+
+  *bytes_sent = 0;
+
+  if ( send_socket == NULL ) {
+    return FALSE;
+  }
+
+  MUTEX_LOCK(send_socket->mutex);
+
+  // Attempts to send data
+  file_offset = (off_t)*offset;
+  res = sendfile(send_socket->handle, fd, &file_offset, len);
+
+  MUTEX_UNLOCK(send_socket->mutex);
+
+  if ( res == -1 ) {
+
+    if ( errno == EAGAIN || errno == EWOULDBLOCK ) {
+      return TRUE;
+    }
+
+    sprintf(buffer, "sendfile failed with error: %d\n", errno);
+    LOGGER(__FUNCTION__, buffer);
+    return FALSE;
+  }
+
+  // Updates values of results
+  *offset = (long long)file_offset;
+  *bytes_sent = (int)res;
+
+  return TRUE;
+}
+
+/**
+ * Moves data received on a connected socket into a pipe without
+ * copying it to user space.
+ *
+ * If the socket is non-blocking and the operation turns out to be blocking
+ * the function returns immediatly with a TRUE return value.
+ *
+ * @param recv_socket           connected socket for receiving data
+ * @param pipe_handle           write end of the pipe
+ * @param len                   maximum number of bytes to move
+ * @param bytes_received        output parameter, returns number of bytes moved
+ *
+ * @return                      TRUE or FALSE, also if the connection
+ *                              was closed by the peer
+ */
+int socket_splice(SOCKET_T* recv_socket, int pipe_handle, int len, int * bytes_received) {
+
+  char buffer[1024];
+  ssize_t res;
+
+  *bytes_received = 0;
+
+  if ( recv_socket == NULL ) {
+    return FALSE;
+  }
+
+  MUTEX_LOCK(recv_socket->mutex);
+
+  // Attempts to move the data
+  res = splice(recv_socket->handle, NULL, pipe_handle, NULL, len, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+
+  MUTEX_UNLOCK(recv_socket->mutex);
+
+  if ( res == -1 ) {
+
+    if ( errno == EAGAIN || errno == EWOULDBLOCK ) {
+      return TRUE;
+    }
+
+    sprintf(buffer, "splice failed with error: %d\n", errno);
+    LOGGER(__FUNCTION__, buffer);
+    return FALSE;
+  }
+
+  // Nothing moved from a socket reported as readable means
+  // the connection was closed by the peer
+  if ( res == 0 ) {
+    return FALSE;
+  }
+
+  *bytes_received = (int)res;
+
+  return TRUE;
+}
+
+/**
+ * Finalizes, closes, and destroys a socket previously created with SOCKET_CRATE
+ *
+ * @param close_socket          pointer by reference to the socket data structure
+ *
+ * @return                      TRUE or FALSE
+ */
+int socket_close(SOCKET_T** close_socket) {
+
+  char buffer[1024];
+  int res;
+
+  if ( close_socket && *close_socket ) {
+
+    // Puts a lock on the mutex
+    MUTEX_LOCK( (*(close_socket))->mutex );
+
+    // Shuts down the socket for send and receive
+    shutdown( (*(close_socket))->handle, SHUT_RDWR );
+    
+    // Closes the socket
+    res = close( (*(close_socket))->handle );
+    if (res == -1) {
+
+      // Removes the lock on the mutex
+      MUTEX_UNLOCK( (*(close_socket))->mutex );
+
+      sprintf(buffer, "shutdown failed with error: %d\n", errno);
+      LOGGER(__FUNCTION__, buffer);
+  
+      return FALSE;
+
+    }
+
+    // Removes the lock on the mutex and destroys it
+    MUTEX_UNLOCK( (*(close_socket))->mutex );
+    MUTEX_DESTROY( &( (*(close_socket))->mutex) );
+    
+    // Frees previously allocated memory
+    free( (*(close_socket))->mutex );
+
+    // Frees memory from the socket structure
+    free( *close_socket );
+    *close_socket = NULL;
+
+    return TRUE;
+
+  }
+
+  return FALSE;
+
+}
+
+/**
+ * Disables both send and receive operations in a socket
+ * without checking if the socket is being used.
+ *
+ * @param socket                pointer by reference to the socket structure to shut down
+ *
+ * @return                      TRUE or FALSE
  */
 int socket_shutdown(SOCKET_T** socket) {
 
@@ -762,4 +1177,413 @@ int socket_shutdown(SOCKET_T** socket) {
   
   return FALSE;
 
-}
\ No newline at end of file
+}
+
+/**
+ * Copies the data already queued on a socket without removing
+ * it from the queue and without blocking
+ *
+ * @param peek_socket           connected socket
+ * @param data_buffer           buffer to store the data
+ * @param len                   maximum number of bytes to copy
+ *
+ * @return                      number of bytes copied, or -1 if an error occurred
+ */
+int socket_peek(SOCKET_T* peek_socket, char* data_buffer, int len) {
+
+  int res;
+
+  if ( peek_socket == NULL ) {
+    return -1;
+  }
+
+  res = recv(peek_socket->handle, data_buffer, len, MSG_PEEK | MSG_DONTWAIT);
+  if ( res < 0 && ( errno == EAGAIN || errno == EWOULDBLOCK ) ) {
+    return 0;
+  }
+
+  return res;
+}
+
+/**
+ * Discards the data already queued on a socket without blocking
+ *
+ * @param discard_socket        connected socket
+ *
+ * @return                      number of bytes discarded
+ */
+int socket_discard(SOCKET_T* discard_socket) {
+
+  char buffer[_BUFFER_SIZE_L];
+  int total = 0;
+  int res;
+
+  if ( discard_socket == NULL ) {
+    return 0;
+  }
+
+  while ( ( res = recv(discard_socket->handle, buffer, sizeof(buffer), MSG_DONTWAIT) ) > 0 ) {
+    total += res;
+  }
+
+  return total;
+}
+
+/**
+ * Evaluates if a connection kept open between requests can still be
+ * used, the peer has not closed it and sent nothing unrequested on it
+ *
+ * @param idle_socket           connected socket
+ *
+ * @return                      TRUE or FALSE
+ */
+int socket_is_idle(SOCKET_T* idle_socket) {
+
+  char byte;
+
+  if ( idle_socket == NULL ) {
+    return FALSE;
+  }
+
+  // Nothing to read yet is the only state of a healthy idle connection
+  if ( recv(idle_socket->handle, &byte, 1, MSG_PEEK | MSG_DONTWAIT) < 0 ) {
+    return ( errno == EAGAIN || errno == EWOULDBLOCK );
+  }
+
+  return FALSE;
+}
+
+/**
+ * Creates a second structure for the connection of a socket, with a lock
+ * of its own, so that a thread sends through it while another receives
+ *
+ * @param shared_socket         connected socket
+ *
+ * @return                      new socket structure, or NULL if an error occurred
+ */
+SOCKET_T* socket_share(SOCKET_T* shared_socket) {
+
+  SOCKET_T* new_socket;
+
+  if ( shared_socket == NULL ) {
+    return NULL;
+  }
+
+  new_socket = malloc(sizeof( SOCKET_T ));
+  memset(new_socket, 0x00, sizeof( SOCKET_T ));
+
+  new_socket->handle = shared_socket->handle;
+
+  new_socket->mutex = (MUTEX_T*)malloc(sizeof(struct _mutex_t) );
+  memset( new_socket->mutex, 0x00, sizeof(struct _mutex_t));
+  MUTEX_CREATE( &(new_socket->mutex) );
+
+  return new_socket;
+}
+
+/**
+ * Destroys a structure created with socket_share, leaving the connection open
+ *
+ * @param share_socket          pointer by reference to the socket structure
+ */
+void socket_unshare(SOCKET_T** share_socket) {
+
+  if ( share_socket && *share_socket ) {
+
+    MUTEX_DESTROY( &( (*share_socket)->mutex) );
+    free( (*share_socket)->mutex );
+
+    free( *share_socket );
+    *share_socket = NULL;
+  }
+}
+
+/**
+ * Translates S_ operation types to epoll events
+ */
+static unsigned int socket_poll_events(int operation_type, int oneshot) {
+
+  unsigned int events = EPOLLET | EPOLLRDHUP;
+
+  if (operation_type & S_READ) {
+    events |= EPOLLIN;
+  }
+  if (operation_type & S_WRITE) {
+    events |= EPOLLOUT;
+  }
+  if (oneshot == TRUE) {
+    events |= EPOLLONESHOT;
+  }
+
+  return events;
+
+}
+
+/**
+ * Creates a new readiness notification set
+ *
+ * @return                      pointer to the new set, or NULL on error
+ */
+SOCKET_POLL_T* socket_poll_create() {
+
+  SOCKET_POLL_T* new_poll = NULL;
+  struct epoll_event event;
+  char buffer[_BUFFER_SIZE_S];
+
+  new_poll = malloc(sizeof( SOCKET_POLL_T ));
+  memset(new_poll, 0x00, sizeof( SOCKET_POLL_T ));
+
+  new_poll->handle = epoll_create1(EPOLL_CLOEXEC);
+  if (new_poll->handle == -1) {
+
+    sprintf(buffer, "epoll_create1 failed with error: %d\n", errno);
+    LOGGER(__FUNCTION__, buffer);
+
+    free(new_poll);
+    return NULL;
+  }
+
+  // Creates the descriptor used to interrupt waits
+  new_poll->wakeup_handle = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (new_poll->wakeup_handle == -1) {
+
+    sprintf(buffer, "eventfd failed with error: %d\n", errno);
+    LOGGER(__FUNCTION__, buffer);
+
+    close(new_poll->handle);
+    free(new_poll);
+    return NULL;
+  }
+
+  memset(&event, 0x00, sizeof(event));
+  event.events = EPOLLIN | EPOLLET;
+  event.data.ptr = NULL;
+
+  if ( epoll_ctl(new_poll->handle, EPOLL_CTL_ADD, new_poll->wakeup_handle, &event) == -1 ) {
+
+    sprintf(buffer, "epoll_ctl failed with error: %d\n", errno);
+    LOGGER(__FUNCTION__, buffer);
+
+    close(new_poll->wakeup_handle);
+    close(new_poll->handle);
+    free(new_poll);
+    return NULL;
+  }
+
+  return new_poll;
+
+}
+
+/**
+ * Closes and frees a readiness notification set. Sockets that
+ * are still registered are not closed.
+ *
+ * @param poll                  pointer by reference to the set
+ *
+ * @return                      TRUE or FALSE
+ */
+int socket_poll_destroy(SOCKET_POLL_T** poll) {
+
+  if ( poll && *poll ) {
+
+    close( (*poll)->wakeup_handle );
+    close( (*poll)->handle );
+
+    free( *poll );
+    *poll = NULL;
+
+    return TRUE;
+
+  }
+
+  return FALSE;
+
+}
+
+/**
+ * Registers a socket on a notification set as edge-triggered
+ *
+ * @param poll                  notification set
+ * @param poll_socket           socket to register
+ * @param operation_type        operations to watch: S_READ, S_WRITE, S_RW
+ * @param oneshot               TRUE to disable the socket after its first event
+ *                              until it is rearmed with socket_poll_rearm
+ * @param context               pointer returned with the socket's events
+ *
+ * @return                      TRUE or FALSE
+ */
+int socket_poll_add(SOCKET_POLL_T* poll, SOCKET_T* poll_socket, int operation_type, int oneshot, void* context) {
+
+  struct epoll_event event;
+  char buffer[_BUFFER_SIZE_S];
+
+  if ( poll == NULL || poll_socket == NULL ) {
+    return FALSE;
+  }
+
+  memset(&event, 0x00, sizeof(event));
+  event.events = socket_poll_events(operation_type, oneshot);
+  event.data.ptr = context;
+
+  if ( epoll_ctl(poll->handle, EPOLL_CTL_ADD, poll_socket->handle, &event) == -1 ) {
+
+    sprintf(buffer, "epoll_ctl failed with error: %d\n", errno);
+    LOGGER(__FUNCTION__, buffer);
+    return FALSE;
+  }
+
+  return TRUE;
+
+}
+
+/**
+ * Enables again a oneshot socket on a notification set
+ *
+ * @param poll                  notification set
+ * @param poll_socket           registered socket
+ * @param operation_type        operations to watch: S_READ, S_WRITE, S_RW
+ * @param context               pointer returned with the socket's events
+ *
+ * @return                      TRUE or FALSE
+ */
+int socket_poll_rearm(SOCKET_POLL_T* poll, SOCKET_T* poll_socket, int operation_type, void* context) {
+
+  struct epoll_event event;
+  char buffer[_BUFFER_SIZE_S];
+
+  if ( poll == NULL || poll_socket == NULL ) {
+    return FALSE;
+  }
+
+  memset(&event, 0x00, sizeof(event));
+  event.events = socket_poll_events(operation_type, TRUE);
+  event.data.ptr = context;
+
+  if ( epoll_ctl(poll->handle, EPOLL_CTL_MOD, poll_socket->handle, &event) == -1 ) {
+
+    sprintf(buffer, "epoll_ctl failed with error: %d\n", errno);
+    LOGGER(__FUNCTION__, buffer);
+    return FALSE;
+  }
+
+  return TRUE;
+
+}
+
+/**
+ * Removes a socket from a notification set
+ *
+ * @param poll                  notification set
+ * @param poll_socket           registered socket
+ *
+ * @return                      TRUE or FALSE
+ */
+int socket_poll_remove(SOCKET_POLL_T* poll, SOCKET_T* poll_socket) {
+
+  struct epoll_event event;
+
+  if ( poll == NULL || poll_socket == NULL ) {
+    return FALSE;
+  }
+
+  // Kernels before 2.6.9 require a non-null event
+  memset(&event, 0x00, sizeof(event));
+
+  if ( epoll_ctl(poll->handle, EPOLL_CTL_DEL, poll_socket->handle, &event) == -1 ) {
+    return FALSE;
+  }
+
+  return TRUE;
+
+}
+
+/**
+ * Waits for readiness events on a notification set
+ *
+ * @param poll                  notification set
+ * @param timeout               timeout in milliseconds, or -1 for blocking
+ * @param events                array to store the events
+ * @param max_events            size of the events array
+ *
+ * @return                      number of events stored, 0 on timeout or wakeup,
+ *                              or -1 if an error occurred
+ */
+int socket_poll_wait(SOCKET_POLL_T* poll, int timeout, SOCKET_POLL_EVENT_T* events, int max_events) {
+
+  struct epoll_event ready[S_POLL_MAX_EVENTS];
+  char buffer[_BUFFER_SIZE_S];
+  int count, iter;
+  int stored = 0;
+
+  if ( poll == NULL || events == NULL || max_events <= 0 ) {
+    return -1;
+  }
+
+  if ( max_events > S_POLL_MAX_EVENTS ) {
+    max_events = S_POLL_MAX_EVENTS;
+  }
+
+  count = epoll_wait(poll->handle, ready, max_events, timeout);
+  if (count == -1) {
+
+    if (errno == EINTR) {
+      return 0;
+    }
+
+    sprintf(buffer, "epoll_wait failed with error: %d\n", errno);
+    LOGGER(__FUNCTION__, buffer);
+    return -1;
+  }
+
+  for (iter = 0; iter < count; iter++) {
+
+    // Consumes wakeup notifications
+    if (ready[iter].data.ptr == NULL) {
+
+      uint64_t value;
+      while ( read(poll->wakeup_handle, &value, sizeof(value)) > 0 );
+      continue;
+    }
+
+    events[stored].context = ready[iter].data.ptr;
+    events[stored].operation_type = 0;
+
+    if ( ready[iter].events & EPOLLIN ) {
+      events[stored].operation_type |= S_READ;
+    }
+    if ( ready[iter].events & EPOLLOUT ) {
+      events[stored].operation_type |= S_WRITE;
+    }
+    if ( ready[iter].events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR) ) {
+      events[stored].operation_type |= S_HANGUP;
+    }
+
+    stored++;
+  }
+
+  return stored;
+
+}
+
+/**
+ * Interrupts a thread waiting on a notification set
+ *
+ * @param poll                  notification set
+ *
+ * @return                      TRUE or FALSE
+ */
+int socket_poll_wakeup(SOCKET_POLL_T* poll) {
+
+  uint64_t value = 1;
+
+  if ( poll == NULL ) {
+    return FALSE;
+  }
+
+  if ( write(poll->wakeup_handle, &value, sizeof(value)) != sizeof(value) ) {
+    return FALSE;
+  }
+
+  return TRUE;
+
+}
@@ -16,6 +16,8 @@
 extern "C" {
 #endif
 
+#include <sys/uio.h>
+
 #include "macros.h"
 #include "list.h"
 
@@ -25,10 +27,29 @@ extern "C" {
 #define SOCKET_CREATE           socket_create
 #define SOCKET_ACCEPT           socket_accept
 #define SOCKET_SELECT           socket_select
+#define SOCKET_SELECT_BATCH     socket_select_batch
 #define SOCKET_RECV             socket_recv
 #define SOCKET_SEND             socket_send
+#define SOCKET_SENDV            socket_sendv
+#define SOCKET_SEND_NOWAIT      socket_send_nowait
+#define SOCKET_ZEROCOPY_WAIT    socket_zerocopy_wait
 #define SOCKET_CLOSE            socket_close
 #define SOCKET_SHUTDOWN         socket_shutdown
+#define SOCKET_PEEK             socket_peek
+#define SOCKET_DISCARD          socket_discard
+#define SOCKET_IS_IDLE          socket_is_idle
+#define SOCKET_SHARE            socket_share
+#define SOCKET_UNSHARE          socket_unshare
+#define SOCKET_SENDFILE         socket_sendfile
+#define SOCKET_SPLICE           socket_splice
+
+#define SOCKET_POLL_CREATE      socket_poll_create
+#define SOCKET_POLL_DESTROY     socket_poll_destroy
+#define SOCKET_POLL_ADD         socket_poll_add
+#define SOCKET_POLL_REARM       socket_poll_rearm
+#define SOCKET_POLL_REMOVE      socket_poll_remove
+#define SOCKET_POLL_WAIT        socket_poll_wait
+#define SOCKET_POLL_WAKEUP      socket_poll_wakeup
 
 #define SOCKET_NEW_SRVR(a,p,m)  SOCKET_CREATE(1, a, p, m, TRUE)
 #define SOCKET_NEW_CLNT(a,p)    SOCKET_CREATE(0, a, p, 0, TRUE)
@@ -36,6 +57,7 @@ extern "C" {
 #define S_READ                  0x01
 #define S_WRITE                 0x02
 #define S_RW                    0x03
+#define S_HANGUP                0x04
 
 // Defines timeout for the sockets select operations
 #define S_TIMEOUT 2
@@ -43,6 +65,13 @@ extern "C" {
 // Defines timeout for read/write operations
 #define RW_TIMEOUT (10 * 1000)
 
+// Defines max number of events returned by a single poll wait
+#define S_POLL_MAX_EVENTS 256
+
+// Defines the smallest send made with MSG_ZEROCOPY, below it pinning the
+// pages and reaping the completion costs more than copying them
+#define S_ZEROCOPY_MIN (1024 * 1024)
+
 /**
  * Socket information structure
  */
@@ -51,8 +80,44 @@ typedef struct _socket_t {
   int handle;
   struct _mutex_t* mutex;
 
+  // MSG_ZEROCOPY: 0 not tried yet, 1 enabled, -1 unavailable, and
+  // sends made with it and those whose buffers the kernel released
+  int zerocopy;
+  unsigned int zerocopy_sent;
+  unsigned int zerocopy_done;
+
 } SOCKET_T;
 
+/**
+ * Socket checked for readiness, and the operations it is available for
+ */
+typedef struct _socket_ready_t {
+
+  SOCKET_T * socket;
+  int operation_type;
+
+} SOCKET_READY_T;
+
+/**
+ * Readiness notification set (epoll), edge-triggered
+ */
+typedef struct _socket_poll_t {
+
+  int handle;
+  int wakeup_handle;
+
+} SOCKET_POLL_T;
+
+/**
+ * Readiness event returned by a poll wait
+ */
+typedef struct _socket_poll_event_t {
+
+  void * context;
+  int operation_type;
+
+} SOCKET_POLL_EVENT_T;
+
 /**
  * Initializes the library's socket functionalities
  *
@@ -99,7 +164,8 @@ int socket_accept(SOCKET_T * listen_socket, SOCKET_T ** accept_socket);
 /**
  * Checks if a socket is available for reading and/or writing
  *
- * @param timeout               timeout, or 0 for blocking
+ * @param timeout               timeout in seconds, 0 to return at once
+ *                              or -1 for blocking
  * @param socket                socket to check state on
  * @param operation_type        operation type: S_READ, S_WRITE, S_RW
  *
@@ -109,13 +175,30 @@ int socket_accept(SOCKET_T * listen_socket, SOCKET_T ** accept_socket);
  */
 int socket_select(int timeout, SOCKET_T * select_socket, int operation_type);
 
+/**
+ * Checks which sockets of a group are available for reading and/or writing
+ *
+ * @param timeout               timeout in seconds, 0 to return at once
+ *                              or -1 for blocking
+ * @param sockets               sockets to check, with the operations to check on each
+ * @param count                 number of sockets
+ * @param ready                 array to store the sockets available, with the
+ *                              operations they are available for. It may be
+ *                              the sockets array itself.
+ *
+ * @return                      number of sockets stored, 0 on timeout,
+ *                              or -1 if an error occurred
+ */
+int socket_select_batch(int timeout, SOCKET_READY_T * sockets, int count, SOCKET_READY_T * ready);
+
 /**
  * Checks if a group of sockets is available for read/write
  * 
  * Upon return the lists will be already updated, having removed de nodes correponding
  * to sockets that were not available for the requested operations (read/write)
  * 
- * @param timeout               timeout, or 0 for blocking
+ * @param timeout               timeout in seconds, 0 to return at once
+ *                              or -1 for blocking
  * @param read_s                pointer to a socket list to check for read availability, or NULL if does not apply
  * @param write_s               pointer to a socket list to check for write availability, or NULL if does not apply
  *
@@ -160,6 +243,85 @@ int socket_recv(SOCKET_T* recv_socket, char** data_buffer, int* len);
  */
 int socket_send(SOCKET_T* send_socket, char* send_buffer, int len, int * bytes_sent);
 
+/**
+ * Sends data through a connected socket without ever blocking, even if
+ * the socket is a blocking one. What the socket cannot take at once is
+ * not sent.
+ *
+ * @param send_socket           connected socket for sending data
+ * @param send_buffer           buffer containing the data to be sent
+ * @param len                   number of bytes to send
+ * @param bytes_sent            output parameter, returns number of bytes sent
+ *
+ * @return                      TRUE or FALSE
+ */
+int socket_send_nowait(SOCKET_T* send_socket, const char* send_buffer, int len, int * bytes_sent);
+
+/**
+ * Sends several buffers through a connected socket in a single call.
+ *
+ * If the socket is non-blocking and the operation turns out to be blocking
+ * the function returns immediatly with a TRUE return value.
+ *
+ * @param send_socket           connected socket for sending data
+ * @param iov                   buffers to send
+ * @param iov_count             number of buffers
+ * @param zerocopy              TRUE to send with MSG_ZEROCOPY where available,
+ *                              the buffers then must not be modified until
+ *                              socket_zerocopy_wait() succeeds
+ * @param bytes_sent            output parameter, returns number of bytes sent
+ *
+ * @return                      TRUE or FALSE
+ */
+int socket_sendv(SOCKET_T* send_socket, const struct iovec* iov, int iov_count, int zerocopy, int * bytes_sent);
+
+/**
+ * Waits for the kernel to release the buffers of the sends made with
+ * MSG_ZEROCOPY through a socket
+ *
+ * @param zerocopy_socket       connected socket
+ * @param timeout               timeout in milliseconds, 0 to only collect
+ *                              the releases already notified
+ *
+ * @return                      TRUE if every buffer was released, otherwise FALSE
+ */
+int socket_zerocopy_wait(SOCKET_T* zerocopy_socket, int timeout);
+
+/**
+ * Sends part of a file through a connected socket, straight from the
+ * page cache without copying it to user space.
+ *
+ * If the socket is non-blocking and the operation turns out to be blocking
+ * the function returns immediatly with a TRUE return value.
+ *
+ * @param send_socket           connected socket for sending data
+ * @param fd                    descriptor of the file
+ * @param offset                offset of the data in the file, updated
+ *                              after the operation
+ * @param len                   number of bytes to send
+ * @param bytes_sent            output parameter, returns number of bytes sent
+ *
+ * @return                      TRUE or FALSE
+ */
+int socket_sendfile(SOCKET_T* send_socket, int fd, long long* offset, int len, int * bytes_sent);
+
+/**
+ * Moves data received on a connected socket into a pipe without
+ * copying it to user space.
+ *
+ * If the socket is non-blocking and the operation turns out to be blocking
+ * the function returns immediatly with a TRUE return value.
+ *
+ * @param recv_socket           connected socket for receiving data
+ * @param pipe_handle           write end of the pipe
+ * @param len                   maximum number of bytes to move
+ * @param bytes_received        output parameter, returns number of bytes moved
+ *
+ * @return                      TRUE or FALSE, also if the connection
+ *                              was closed by the peer
+ */
+int socket_splice(SOCKET_T* recv_socket, int pipe_handle, int len, int * bytes_received);
+
 /**
  * Finalizes, closes, and destroys a socket previously created with SOCKET_CRATE
  *
@@ -179,4 +341,127 @@ int socket_close(SOCKET_T** close_socket);
  */
 int socket_shutdown(SOCKET_T** socket);
 
+/**
+ * Copies the data already queued on a socket without removing
+ * it from the queue and without blocking
+ *
+ * @param peek_socket           connected socket
+ * @param data_buffer           buffer to store the data
+ * @param len                   maximum number of bytes to copy
+ *
+ * @return                      number of bytes copied, or -1 if an error occurred
+ */
+int socket_peek(SOCKET_T* peek_socket, char* data_buffer, int len);
+
+/**
+ * Discards the data already queued on a socket without blocking
+ *
+ * @param discard_socket        connected socket
+ *
+ * @return                      number of bytes discarded
+ */
+int socket_discard(SOCKET_T* discard_socket);
+
+/**
+ * Evaluates if a connection kept open between requests can still be
+ * used, the peer has not closed it and sent nothing unrequested on it
+ *
+ * @param idle_socket           connected socket
+ *
+ * @return                      TRUE or FALSE
+ */
+int socket_is_idle(SOCKET_T* idle_socket);
+
+/**
+ * Creates a second structure for the connection of a socket, with a lock
+ * of its own, so that a thread sends through it while another receives
+ *
+ * @param shared_socket         connected socket
+ *
+ * @return                      new socket structure, or NULL if an error occurred
+ */
+SOCKET_T* socket_share(SOCKET_T* shared_socket);
+
+/**
+ * Destroys a structure created with socket_share, leaving the connection open
+ *
+ * @param share_socket          pointer by reference to the socket structure
+ */
+void socket_unshare(SOCKET_T** share_socket);
+
+/**
+ * Creates a new readiness notification set
+ *
+ * @return                      pointer to the new set, or NULL on error
+ */
+SOCKET_POLL_T* socket_poll_create();
+
+/**
+ * Closes and frees a readiness notification set. Sockets that
+ * are still registered are not closed.
+ *
+ * @param poll                  pointer by reference to the set
+ *
+ * @return                      TRUE or FALSE
+ */
+int socket_poll_destroy(SOCKET_POLL_T** poll);
+
+/**
+ * Registers a socket on a notification set as edge-triggered
+ *
+ * @param poll                  notification set
+ * @param poll_socket           socket to register
+ * @param operation_type        operations to watch: S_READ, S_WRITE, S_RW
+ * @param oneshot               TRUE to disable the socket after its first event
+ *                              until it is rearmed with socket_poll_rearm
+ * @param context               pointer returned with the socket's events
+ *
+ * @return                      TRUE or FALSE
+ */
+int socket_poll_add(SOCKET_POLL_T* poll, SOCKET_T* poll_socket, int operation_type, int oneshot, void* context);
+
+/**
+ * Enables again a oneshot socket on a notification set
+ *
+ * @param poll                  notification set
+ * @param poll_socket           registered socket
+ * @param operation_type        operations to watch: S_READ, S_WRITE, S_RW
+ * @param context               pointer returned with the socket's events
+ *
+ * @return                      TRUE or FALSE
+ */
+int socket_poll_rearm(SOCKET_POLL_T* poll, SOCKET_T* poll_socket, int operation_type, void* context);
+
+/**
+ * Removes a socket from a notification set
+ *
+ * @param poll                  notification set
+ * @param poll_socket           registered socket
+ *
+ * @return                      TRUE or FALSE
+ */
+int socket_poll_remove(SOCKET_POLL_T* poll, SOCKET_T* poll_socket);
+
+/**
+ * Waits for readiness events on a notification set
+ *
+ * @param poll                  notification set
+ * @param timeout               timeout in milliseconds, or -1 for blocking
+ * @param events                array to store the events
+ * @param max_events            size of the events array
+ *
+ * @return                      number of events stored, 0 on timeout or wakeup,
+ *                              or -1 if an error occurred
+ */
+int socket_poll_wait(SOCKET_POLL_T* poll, int timeout, SOCKET_POLL_EVENT_T* events, int max_events);
+
+/**
+ * Interrupts a thread waiting on a notification set
+ *
+ * @param poll                  notification set
+ *
+ * @return                      TRUE or FALSE
+ */
+int socket_poll_wakeup(SOCKET_POLL_T* poll);
+
 #endif // WIN32
@@ -0,0 +1,331 @@
+/*
+ * store.c
+ *
+ * $Id: $
+ * $HeadURL: $
+ * $LastChangedRevision: $
+ * $LastChangedDate: $
+ * $LastChangedBy: $
+ *
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE 1
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
+#include <linux/fs.h>
+
+#include "store.h"
+#include "file.h"
+#include "macros.h"
+#include "logger.h"
+
+// Directory of the store, empty when it is disabled. It is only
+// set while the server starts, before any request is processed
+static char store_directory[1024];
+
+/**
+ * Builds the path of the blob of a content
+ *
+ * @param digest          digest of the content
+ * @param blob_path       buffer for the path of the blob
+ * @param parent_path     buffer for the path of its directory, or NULL
+ */
+static void store_blob_path( const unsigned char* digest, char* blob_path, char* parent_path ) {
+
+  char hex[SHA256_HEX_LEN + 1];
+
+  sha256_hex(digest, hex);
+
+  sprintf(blob_path, "%s/%.2s/%s", store_directory, hex, hex);
+
+  if ( parent_path != NULL ) {
+    sprintf(parent_path, "%s/%.2s", store_directory, hex);
+  }
+}
+
+/**
+ * Creates a temporary file next to a file with the content of another one,
+ * cloning its extents if the file system supports it, otherwise as a hard
+ * link of it if both are on the same file system, otherwise as a copy
+ *
+ * @param source_path     path of the file with the content
+ * @param filepath        path of the file the temporary one will replace
+ * @param temp_path       buffer for the temporary file path
+ *
+ * @return                TRUE or FALSE
+ */
+static int store_clone( char* source_path, char* filepath, char* temp_path ) {
+
+  struct stat info;
+  off_t offset = 0;
+  ssize_t bsent;
+  int source_fd;
+  int fd;
+  int success = FALSE;
+
+  source_fd = open(source_path, O_RDONLY);
+  if ( source_fd == -1 || fstat(source_fd, &info) != 0 ) {
+
+    if ( source_fd != -1 ) {
+      close(source_fd);
+    }
+    return FALSE;
+  }
+
+  fd = file_create_temp(filepath, temp_path, 0);
+  if ( fd == -1 ) {
+
+    close(source_fd);
+    return FALSE;
+  }
+
+#ifdef FICLONE
+  if ( ioctl(fd, FICLONE, source_fd) == 0 ) {
+
+    success = ( close(fd) == 0 );
+    fd = -1;
+    goto END_STORE_CLONE;
+  }
+#endif
+
+  // The temporary file only reserved a unique name for the link
+  if ( unlink(temp_path) == 0 && link(source_path, temp_path) == 0 ) {
+
+    close(fd);
+    fd = -1;
+    success = TRUE;
+    goto END_STORE_CLONE;
+  }
+
+  close(fd);
+  fd = open(temp_path, O_WRONLY | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+  if ( fd == -1 ) {
+    goto END_STORE_CLONE;
+  }
+
+  while ( offset < info.st_size ) {
+
+    bsent = sendfile(fd, source_fd, &offset, (size_t)( info.st_size - offset ));
+    if ( bsent <= 0 ) {
+      break;
+    }
+  }
+
+  success = ( offset == info.st_size );
+  success = ( close(fd) == 0 ) && success;
+  fd = -1;
+
+END_STORE_CLONE:
+
+  close(source_fd);
+
+  if ( ! success ) {
+    unlink(temp_path);
+  }
+
+  return success;
+}
+
+/**
+ * Sets the directory of the content store of the server
+ *
+ * @param directory       directory of the store, created if needed,
+ *                        or NULL to disable the store
+ *
+ * @return                TRUE or FALSE
+ */
+int store_init( const char* directory ) {
+
+  char l_msg[2048];
+
+  store_directory[0] = '\0';
+
+  if ( directory == NULL || directory[0] == '\0' ) {
+    return TRUE;
+  }
+
+  if ( strlen(directory) >= sizeof(store_directory) - 2 * SHA256_HEX_LEN ) {
+
+    LOGGER(__FUNCTION__, "ERROR: The path of the content store is too long.");
+    return FALSE;
+  }
+
+  if ( mkdir(directory, S_IRWXU) == -1 && errno != EEXIST ) {
+
+    sprintf(l_msg, "ERROR: Content store %s could not be created, code [%d].", directory, errno);
+    LOGGER(__FUNCTION__, l_msg);
+    return FALSE;
+  }
+
+  strcpy(store_directory, directory);
+
+  // Blob paths append their own separator
+  if ( strlen(store_directory) > 1 && store_directory[strlen(store_directory) - 1] == '/' ) {
+    store_directory[strlen(store_directory) - 1] = '\0';
+  }
+
+  sprintf(l_msg, "Content store is kept in %s.", store_directory);
+  LOGGER(__FUNCTION__, l_msg);
+
+  return TRUE;
+}
+
+/**
+ * Disables the content store
+ */
+void store_deinit() {
+
+  store_directory[0] = '\0';
+}
+
+/**
+ * Evaluates if the content store is enabled
+ *
+ * @return                TRUE or FALSE
+ */
+int store_enabled() {
+
+  return ( store_directory[0] != '\0' );
+}
+
+/**
+ * Replaces a file with the content of a blob of the store
+ *
+ * @param digest          digest of the content, STORE_DIGEST_LEN bytes
+ * @param size            size of the content
+ * @param filepath        path of the file
+ * @param backup          TRUE to keep a backup of an existing file
+ *
+ * @return                TRUE if the store holds the content and the file
+ *                        was materialized from it, otherwise FALSE
+ */
+int store_materialize( const unsigned char* digest, long long size, char* filepath, int backup ) {
+
+  char blob_path[2048];
+  char temp_path[2048];
+  char l_msg[4096];
+  struct stat info;
+
+  if ( ! store_enabled() ) {
+    return FALSE;
+  }
+
+  store_blob_path(digest, blob_path, NULL);
+
+  if ( stat(blob_path, &info) != 0 || (long long)info.st_size != size ) {
+    return FALSE;
+  }
+
+  if ( ! store_clone(blob_path, filepath, temp_path) ) {
+
+    sprintf(l_msg, "ERROR: File %s could not be materialized from the content store.", filepath);
+    LOGGER(__FUNCTION__, l_msg);
+    return FALSE;
+  }
+
+  if ( ! file_replace(temp_path, filepath, backup) ) {
+
+    unlink(temp_path);
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+/**
+ * Indexes the content of a file received into the store
+ *
+ * @param filepath        path of the file
+ * @param digest          digest the client announced for the content, or NULL,
+ *                        the server always computes it from the file itself
+ *
+ * @return                TRUE or FALSE
+ */
+int store_add( char* filepath, const unsigned char* digest ) {
+
+  unsigned char actual[STORE_DIGEST_LEN];
+  char blob_path[2048];
+  char parent_path[2048];
+  char temp_path[2048];
+  char l_msg[4096];
+  struct stat info;
+  struct stat blob_info;
+  int fd;
+
+  if ( ! store_enabled() ) {
+    return FALSE;
+  }
+
+  fd = open(filepath, O_RDONLY);
+  if ( fd == -1 ) {
+    return FALSE;
+  }
+
+  if ( fstat(fd, &info) != 0 || ! sha256_file(fd, actual) ) {
+
+    close(fd);
+    return FALSE;
+  }
+  close(fd);
+
+  // The file is indexed under the digest of what was actually received
+  if ( digest != NULL && memcmp(digest, actual, STORE_DIGEST_LEN) != 0 ) {
+
+    sprintf(l_msg, "ERROR: File %s does not have the digest the client announced.", filepath);
+    LOGGER(__FUNCTION__, l_msg);
+  }
+
+  store_blob_path(actual, blob_path, parent_path);
+
+  // Content already stored is shared with the blob, the copy just received
+  // being dropped, its backup was already made when it replaced the file
+  if ( stat(blob_path, &blob_info) == 0 ) {
+
+    if ( blob_info.st_ino == info.st_ino && blob_info.st_dev == info.st_dev ) {
+      return TRUE;
+    }
+
+    if ( (long long)blob_info.st_size == (long long)info.st_size && store_clone(blob_path, filepath, temp_path) ) {
+
+      if ( ! file_replace(temp_path, filepath, FALSE) ) {
+        unlink(temp_path);
+      }
+    }
+
+    return TRUE;
+  }
+
+  if ( mkdir(parent_path, S_IRWXU) == -1 && errno != EEXIST ) {
+    return FALSE;
+  }
+
+  // The blob appears at once, whole, another thread
+  // may have stored the same content in the meantime
+  if ( ! store_clone(filepath, blob_path, temp_path) ) {
+    return FALSE;
+  }
+
+  if ( rename(temp_path, blob_path) == -1 ) {
+
+    unlink(temp_path);
+    return FALSE;
+  }
+
+  // Nothing is renamed when the blob already is the same file
+  unlink(temp_path);
+
+  sprintf(l_msg, "Content of file %s was added to the content store.", filepath);
+  LOGGER(__FUNCTION__, l_msg);
+
+  return TRUE;
+}
@@ -0,0 +1,82 @@
+/*
+ * store.h
+ *
+ * $Id: $
+ * $HeadURL: $
+ * $LastChangedRevision: $
+ * $LastChangedDate: $
+ * $LastChangedBy: $
+ *
+ */
+
+#ifndef _STORE_H
+#define _STORE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "sha256.h"
+
+// Length of the digest that identifies the content of a blob
+#define STORE_DIGEST_LEN      SHA256_DIGEST_LEN
+
+/**
+ * Sets the directory of the content store of the server, where the content
+ * of the files received is kept once as blobs named after its SHA-256
+ * digest, <directory>/<first 2 hex digits>/<64 hex digits>.
+ *
+ * Files are materialized from a blob as a reflink when the file system
+ * supports it, otherwise as a hard link or a copy. A hard link shares its
+ * inode with the blob, so the files of the server must not be modified in
+ * place by other programs, as the server itself always replaces them.
+ *
+ * @param directory       directory of the store, created if needed,
+ *                        or NULL to disable the store
+ *
+ * @return                TRUE or FALSE
+ */
+int store_init( const char* directory );
+
+/**
+ * Disables the content store
+ */
+void store_deinit();
+
+/**
+ * Evaluates if the content store is enabled
+ *
+ * @return                TRUE or FALSE
+ */
+int store_enabled();
+
+/**
+ * Replaces a file with the content of a blob of the store
+ *
+ * @param digest          digest of the content, STORE_DIGEST_LEN bytes
+ * @param size            size of the content
+ * @param filepath        path of the file
+ * @param backup          TRUE to keep a backup of an existing file
+ *
+ * @return                TRUE if the store holds the content and the file
+ *                        was materialized from it, otherwise FALSE
+ */
+int store_materialize( const unsigned char* digest, long long size, char* filepath, int backup );
+
+/**
+ * Indexes the content of a file received into the store. Content the store
+ * already holds is not kept twice, the file is linked to its blob instead.
+ *
+ * @param filepath        path of the file
+ * @param digest          digest the client announced for the content, or NULL,
+ *                        the server always computes it from the file itself
+ *
+ * @return                TRUE or FALSE
+ */
+int store_add( char* filepath, const unsigned char* digest );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // _STORE_H
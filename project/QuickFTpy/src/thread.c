@@ -10,3 +10,37 @@
  */
 
 #include "thread.h"
+
+#ifndef _WIN32
+
+/**
+ * Creates a thread with a specific stack size
+ *
+ * @param thread          thread handle
+ * @param func            thread function
+ * @param arg             argument for the thread function
+ * @param stack_size      stack size in bytes, or 0 for the system default
+ *
+ * @return                0 on success, otherwise an error number
+ */
+int thread_create_ex(thread_t * thread, void * (*func)(void *), void * arg, size_t stack_size) {
+
+  pthread_attr_t attr;
+  int res;
+
+  if ( stack_size == 0 ) {
+    return pthread_create(thread, NULL, func, arg);
+  }
+
+  pthread_attr_init(&attr);
+  pthread_attr_setstacksize(&attr, stack_size);
+
+  res = pthread_create(thread, &attr, func, arg);
+
+  pthread_attr_destroy(&attr);
+
+  return res;
+
+}
+
+#endif
@@ -36,6 +36,7 @@ extern "C" {
 #define thread_t                              HANDLE
 #define THREAD_FUNCTION                       unsigned (__stdcall *) (void *)
 #define THREAD_CREATE(thread,func,arg)        (int)((*thread=(HANDLE)_beginthreadex(NULL,0,(THREAD_FUNCTION)func,arg,0,NULL))==NULL)
+#define THREAD_CREATE_EX(thread,func,arg,stk) (int)((*thread=(HANDLE)_beginthreadex(NULL,stk,(THREAD_FUNCTION)func,arg,0,NULL))==NULL)
 #define THREAD_JOIN(thread, result)           while (WaitForSingleObject((thread),INFINITE)!=WAIT_OBJECT_0) Sleep(10); if (result) CloseHandle(thread);
 #define THREAD_DETACH(thread)                 if(thread!=NULL)CloseHandle(thread)
 #define THREAD_CANCEL(thread)                 TerminateThread(thread,0)
@@ -46,6 +47,7 @@ extern "C" {
 
 #define thread_t                              pthread_t
 #define THREAD_CREATE(thread,func,arg)        pthread_create((*thread), NULL, func, arg)
+#define THREAD_CREATE_EX(thread,func,arg,stk) thread_create_ex((*thread), func, arg, stk)
 #define THREAD_JOIN(thread, result)           if (result) pthread_cancel(*(thread)); pthread_join(*(thread), NULL);
 #define THREAD_DETACH(thread)                 if(thread!=NULL)pthread_detach(thread)
 #define THREAD_CANCEL(thread)                 pthread_cancel(thread)
@@ -53,6 +55,22 @@ extern "C" {
 
 #endif
 
+#ifndef _WIN32
+
+/**
+ * Creates a thread with a specific stack size
+ *
+ * @param thread          thread handle
+ * @param func            thread function
+ * @param arg             argument for the thread function
+ * @param stack_size      stack size in bytes, or 0 for the system default
+ *
+ * @return                0 on success, otherwise an error number
+ */
+int thread_create_ex(thread_t * thread, void * (*func)(void *), void * arg, size_t stack_size);
+
+#endif
+
 #ifdef __cplusplus
 }
 #endif
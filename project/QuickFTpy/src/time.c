@@ -26,4 +26,15 @@ unsigned long GetTickCount() {
   time_t now;
   time(&now);
   return (unsigned long) now;
-}
\ No newline at end of file
+}
+
+/**
+ * Returns a monotonic timestamp in microseconds,
+ * for measuring intervals
+ */
+unsigned long long time_microseconds() {
+
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return ( (unsigned long long) now.tv_sec * 1000000ULL ) + ( now.tv_nsec / 1000 );
+}
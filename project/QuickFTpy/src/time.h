@@ -22,4 +22,10 @@ extern "C" {
 */
 unsigned long GetTickCount();
 
+/**
+ * Returns a monotonic timestamp in microseconds,
+ * for measuring intervals
+ */
+unsigned long long time_microseconds();
+
 #endif // TIME_H
@@ -22,23 +22,42 @@ def main(argv):
   port="2332"
   timeout=20000
   timeout_ack=15000
+  chunked=0
+  uncompressed=0
+  codec="gzip"
+  transfer_id=None
+  stripes=1
+  delta=0
+  dedup=0
 
   result = -1
   usage="qftclient.py -o <operation type: receive, send, delete> -r " +
         "<remote filename> -l <local filename> -a <server address> -p " +
-        "<server port> -t <messages timeout> -k <ack timeout>"
+        "<server port> -t <messages timeout> -k <ack timeout> [-c (chunked receive from V1 servers)] " +
+        "[-u (uncompressed transfer with V2 servers)] [-z <codec with V2 servers: gzip, zstd, lz4>] " +
+        "[-i <transfer id to resume the transfer with V2 servers>] " +
+        "[-s <number of parallel connections to send with V2 servers>] " +
+        "[-d (only send what changed in the remote file with V2 servers)] " +
+        "[-x (skip the content when the store of V2 servers already has it)]"
   print ""
 
   # Parses parameters
   try:
-    opts, args = getopt.getopt(argv,"ho:r:l:a:p:t:k:",[
+    opts, args = getopt.getopt(argv,"ho:r:l:a:p:t:k:cuz:i:s:dx",[
                                                "operation="
                                                "remotefile=",
                                                "localfile=",
                                                "addr=",
                                                "port=",
                                                "timout=",
-                                               "tack="])
+                                               "tack=",
+                                               "chunked",
+                                               "uncompressed",
+                                               "codec=",
+                                               "transfer=",
+                                               "stripes=",
+                                               "delta",
+                                               "dedup"])
   except getopt.GetoptError:
     print "%s" % usage
     sys.exit(2)
@@ -61,6 +80,20 @@ def main(argv):
       timeout = int(arg)
     elif opt in ("-k", "--tack"):
       timeout_ack = int(arg)
+    elif opt in ("-c", "--chunked"):
+      chunked = 1
+    elif opt in ("-u", "--uncompressed"):
+      uncompressed = 1
+    elif opt in ("-z", "--codec"):
+      codec = arg
+    elif opt in ("-i", "--transfer"):
+      transfer_id = arg
+    elif opt in ("-s", "--stripes"):
+      stripes = int(arg)
+    elif opt in ("-d", "--delta"):
+      delta = 1
+    elif opt in ("-x", "--dedup"):
+      dedup = 1
 
   # Checks for required parameters and performs operations
   if op_type == "send":
@@ -69,8 +102,13 @@ def main(argv):
       print "%s" % usage
       sys.exit()
 
-    # Performs File Send operation
-    result = quickftpy.clsend(remote_filename, local_filename, addr, port, timeout, timeout_ack, logger)
+    # Performs File Send operation, of a delta or over parallel connections if asked for
+    if delta:
+      result = quickftpy.clsend_delta(remote_filename, local_filename, addr, port, timeout, timeout_ack, logger, codec)
+    elif stripes > 1:
+      result = quickftpy.clsend_striped(remote_filename, local_filename, addr, port, timeout, timeout_ack, logger, stripes, 0, uncompressed, codec)
+    else:
+      result = quickftpy.clsend(remote_filename, local_filename, addr, port, timeout, timeout_ack, logger, uncompressed, codec, None, transfer_id, dedup)
 
   elif op_type == "receive":
 
@@ -79,7 +117,7 @@ def main(argv):
       sys.exit()
     
     # Performs File Receive operation
-    result = quickftpy.clrecv(remote_filename, local_filename, addr, port, timeout, timeout_ack, logger)
+    result = quickftpy.clrecv(remote_filename, local_filename, addr, port, timeout, timeout_ack, logger, chunked, uncompressed, codec, None, transfer_id)
 
   elif op_type == "delete":
 
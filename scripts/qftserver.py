@@ -18,18 +18,25 @@ def main(argv):
   port=2332
   max_conn=128
   timeout=60000
+  workers=32
+  codecs=None
+  keep_alive=0
+  store=None
+  cache_mb=0
+  cache_dir=None
+  cache_disk_mb=0
   print ""
 
   # Parses parameters
   try:
-    opts, args = getopt.getopt(argv,"hp:m:t:",["port=","max_conn=","timeout="])
+    opts, args = getopt.getopt(argv,"hp:m:t:w:z:k:s:c:d:D:",["port=","max_conn=","timeout=","workers=","codecs=","keepalive=","store=","cache=","cache_dir=","cache_disk="])
   except getopt.GetoptError:
-    print 'qftserver.py -p <port> -m <maxconnections> -t <timeout>'
+    print 'qftserver.py -p <port> -m <maxconnections> -t <timeout> -w <workers> -z <allowed codecs, e.g. gzip,zstd,lz4> -k <keep alive, -1 to disable> -s <content store directory> -c <cache megabytes> -d <cache disk directory> -D <cache disk megabytes>'
     sys.exit(2)
 
   for opt, arg in opts:
     if opt == '-h':
-      print 'qftserver.py -p <port> -m <maxconnections> -t <timeout>'
+      print 'qftserver.py -p <port> -m <maxconnections> -t <timeout> -w <workers> -z <allowed codecs, e.g. gzip,zstd,lz4> -k <keep alive, -1 to disable> -s <content store directory> -c <cache megabytes> -d <cache disk directory> -D <cache disk megabytes>'
       sys.exit()
     elif opt in ("-p", "--port"):
       port = int(arg)
@@ -37,13 +44,33 @@ def main(argv):
       max_conn = int(arg)
     elif opt in ("-m", "--max_conn"):
       max_conn = int(arg)
+    elif opt in ("-w", "--workers"):
+      workers = int(arg)
+    elif opt in ("-z", "--codecs"):
+      codecs = arg
+    elif opt in ("-k", "--keepalive"):
+      keep_alive = int(arg)
+    elif opt in ("-s", "--store"):
+      store = arg
+    elif opt in ("-c", "--cache"):
+      cache_mb = int(arg)
+    elif opt in ("-d", "--cache_dir"):
+      cache_dir = arg
+    elif opt in ("-D", "--cache_disk"):
+      cache_disk_mb = int(arg)
+
+  # Keeps the encoded content of the files sent most often
+  quickftpy.setcache(cache_mb * 1024 * 1024, cache_dir, cache_disk_mb * 1024 * 1024)
 
   # Initializes server
-  quickftpy.servstart(port, max_conn, timeout, logger)
+  quickftpy.servstart(port, max_conn, timeout, logger, workers, 0, codecs, keep_alive, store)
 
   print ""
   raw_input("Press Enter key at any moment to end execution...\n")
 
+  # Shows the worker pool counters
+  print quickftpy.servstats()
+
   # Finalizes server
   quickftpy.servend()
 
@@ -0,0 +1,288 @@
+/*
+ * base64_check.c
+ *
+ * Checks that the vector kernels of base64.c encode and decode exactly
+ * as the translation tables do, and measures their throughput.
+ *
+ *   gcc -O2 -o base64_check base64_check.c
+ *   ./base64_check [seed N]   bit-exact check, exits with 1 on a mismatch
+ *   ./base64_check bench [MB] throughput of each kernel
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// The kernels are static, the module is built in to choose them. It is
+// not found through -I, as src/string.h would hide the system one
+#include "../../project/QuickFTpy/src/base64.c"
+
+#define CHECK_MAX_LEN     4096
+#define CHECK_ROUNDS      200
+
+typedef struct _check_kernel_t {
+
+  const char * name;
+  BASE64_ENCODE_KERNEL_T encode;
+  BASE64_DECODE_KERNEL_T decode;
+
+} CHECK_KERNEL_T;
+
+static CHECK_KERNEL_T kernels[3];
+static int kernel_count = 0;
+
+/**
+ * Lists the scalar code and the kernels the CPU supports,
+ * the scalar code comes first as the reference
+ */
+static void check_kernels() {
+
+  kernels[kernel_count].name = "scalar";
+  kernels[kernel_count].encode = base64_encode_kernel_none;
+  kernels[kernel_count++].decode = base64_decode_kernel_none;
+
+#ifdef BASE64_SIMD
+  __builtin_cpu_init();
+
+  if (__builtin_cpu_supports("ssse3")) {
+
+    kernels[kernel_count].name = "ssse3";
+    kernels[kernel_count].encode = base64_encode_ssse3;
+    kernels[kernel_count++].decode = base64_decode_ssse3;
+  }
+  if (__builtin_cpu_supports("avx2")) {
+
+    kernels[kernel_count].name = "avx2";
+    kernels[kernel_count].encode = base64_encode_avx2;
+    kernels[kernel_count++].decode = base64_decode_avx2;
+  }
+#endif
+}
+
+static void check_use(CHECK_KERNEL_T *kernel) {
+
+  base64_encode_kernel = kernel->encode;
+  base64_decode_kernel = kernel->decode;
+}
+
+/**
+ * Encodes in fragments of random length
+ *
+ * @return                       number of characters written to out
+ */
+static int check_encode(const unsigned char *in, int in_len, char *out, int fragmented) {
+
+  BASE64_STREAM_T stream;
+  int i = 0;
+  int part;
+  int written = 0;
+
+  base64_encode_stream_init(&stream);
+
+  while (i < in_len) {
+
+    part = ( fragmented ) ? 1 + rand() % 97 : in_len;
+    if (part > in_len - i) {
+      part = in_len - i;
+    }
+
+    written += base64_encode_stream(&stream, &in[i], part, &out[written]);
+    i += part;
+  }
+
+  return written + base64_encode_stream_end(&stream, &out[written]);
+}
+
+/**
+ * Decodes in fragments of random length
+ *
+ * @return                       number of bytes written to out
+ */
+static int check_decode(const char *in, int in_len, unsigned char *out, int fragmented) {
+
+  BASE64_STREAM_T stream;
+  int i = 0;
+  int part;
+  int written = 0;
+
+  base64_decode_stream_init(&stream);
+
+  while (i < in_len) {
+
+    part = ( fragmented ) ? 1 + rand() % 131 : in_len;
+    if (part > in_len - i) {
+      part = in_len - i;
+    }
+
+    written += base64_decode_stream(&stream, &in[i], part, &out[written]);
+    i += part;
+  }
+
+  return written + base64_decode_stream_end(&stream, &out[written]);
+}
+
+/**
+ * Copies an encoding adding line breaks, and now and then a character
+ * out of the alphabet, which the decoder must skip
+ *
+ * @return                       length of the copy
+ */
+static int check_dirty(const char *in, int in_len, char *out) {
+
+  static const char noise[] = "\r\n =\t*";
+  int len = 0;
+  int i;
+
+  for (i = 0; i < in_len; i++) {
+
+    if (i > 0 && i % 76 == 0) {
+      out[len++] = '\n';
+    }
+    if (rand() % 509 == 0) {
+      out[len++] = noise[rand() % ( sizeof(noise) - 1 )];
+    }
+    out[len++] = in[i];
+  }
+
+  return len;
+}
+
+static int check_exact() {
+
+  static unsigned char data[CHECK_MAX_LEN];
+  static char reference[BASE64_ENCODE_STREAM_SIZE(CHECK_MAX_LEN) + 4];
+  static char encoded[BASE64_ENCODE_STREAM_SIZE(CHECK_MAX_LEN) + 4];
+  static char dirty[2 * BASE64_ENCODE_STREAM_SIZE(CHECK_MAX_LEN)];
+  static unsigned char decoded[CHECK_MAX_LEN + 4];
+
+  int round;
+  int len;
+  int ref_len;
+  int dirty_len;
+  int out_len;
+  int fragmented;
+  int k;
+  int i;
+  int failures = 0;
+
+  for (round = 0; round < CHECK_ROUNDS; round++) {
+
+    // Every short length, then random ones up to the maximum
+    len = ( round < 100 ) ? round : rand() % CHECK_MAX_LEN;
+    for (i = 0; i < len; i++) {
+      data[i] = (unsigned char)rand();
+    }
+
+    check_use(&kernels[0]);
+    ref_len = check_encode(data, len, reference, FALSE);
+    dirty_len = check_dirty(reference, ref_len, dirty);
+
+    for (k = 0; k < kernel_count; k++) {
+
+      check_use(&kernels[k]);
+
+      for (fragmented = FALSE; fragmented <= TRUE; fragmented++) {
+
+        out_len = check_encode(data, len, encoded, fragmented);
+        if (out_len != ref_len || memcmp(encoded, reference, ref_len) != 0) {
+
+          printf("FAIL %s encode, %d bytes%s\n", kernels[k].name, len, ( fragmented ) ? " in fragments" : "");
+          failures++;
+        }
+
+        out_len = check_decode(reference, ref_len, decoded, fragmented);
+        if (out_len != len || memcmp(decoded, data, len) != 0) {
+
+          printf("FAIL %s decode, %d bytes%s\n", kernels[k].name, len, ( fragmented ) ? " in fragments" : "");
+          failures++;
+        }
+
+        out_len = check_decode(dirty, dirty_len, decoded, fragmented);
+        if (out_len != len || memcmp(decoded, data, len) != 0) {
+
+          printf("FAIL %s decode with breaks, %d bytes%s\n", kernels[k].name, len, ( fragmented ) ? " in fragments" : "");
+          failures++;
+        }
+      }
+    }
+  }
+
+  // An empty string decodes to no buffer at all
+  if (base64_decode("", 0) != NULL) {
+
+    printf("FAIL base64_decode of size 0 is not NULL\n");
+    failures++;
+  }
+
+  for (k = 0; k < kernel_count; k++) {
+    printf("%s kernel checked\n", kernels[k].name);
+  }
+
+  return failures;
+}
+
+static double check_seconds() {
+
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+static void check_bench(int megabytes) {
+
+  int len = megabytes * 1024 * 1024;
+  unsigned char * data = (unsigned char *)malloc(len);
+  char * encoded = (char *)malloc(BASE64_ENCODE_STREAM_SIZE(len) + 4);
+  unsigned char * decoded = (unsigned char *)malloc(len + 4);
+  double start;
+  double encode_time;
+  double decode_time;
+  int encoded_len;
+  int k;
+  int i;
+
+  for (i = 0; i < len; i++) {
+    data[i] = (unsigned char)rand();
+  }
+
+  for (k = 0; k < kernel_count; k++) {
+
+    check_use(&kernels[k]);
+
+    start = check_seconds();
+    encoded_len = check_encode(data, len, encoded, FALSE);
+    encode_time = check_seconds() - start;
+
+    start = check_seconds();
+    check_decode(encoded, encoded_len, decoded, FALSE);
+    decode_time = check_seconds() - start;
+
+    printf("%-8s encode %8.1f MB/s   decode %8.1f MB/s\n", kernels[k].name,
+           megabytes / encode_time, megabytes / decode_time);
+  }
+
+  free(data);
+  free(encoded);
+  free(decoded);
+}
+
+int main(int argc, char *argv[]) {
+
+  int failures;
+
+  srand(( argc > 2 && strcmp(argv[1], "seed") == 0 ) ? atoi(argv[2]) : (unsigned)time(NULL));
+  check_kernels();
+
+  if (argc > 1 && strcmp(argv[1], "bench") == 0) {
+
+    check_bench(( argc > 2 ) ? atoi(argv[2]) : 64);
+    return 0;
+  }
+
+  failures = check_exact();
+  printf("%s\n", ( failures == 0 ) ? "OK" : "FAILED");
+
+  return ( failures == 0 ) ? 0 : 1;
+}
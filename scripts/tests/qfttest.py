@@ -0,0 +1,405 @@
+#
+# Helpers shared by the scripted checks of the library.
+#
+# The server runs in a child process, as servstart keeps the interpreter
+# busy while it listens, and is driven through its standard input:
+#
+#   stats       prints the counters of servstats as a single line
+#   end         finalizes the server and exits
+#
+# The module is looked for in QFT_MODULE_DIR, then in the Release output
+# of the project. Setting QFT_VERBOSE prints the log of the client and
+# the server.
+#
+
+import os
+import sys
+import zlib
+import time
+import base64
+import random
+import shutil
+import socket
+import struct
+import tempfile
+import subprocess
+
+ROOT = os.path.abspath(os.path.join(os.path.dirname(__file__), "..", ".."))
+MODULE_DIR = os.environ.get("QFT_MODULE_DIR", os.path.join(ROOT, "project", "QuickFTpy", "dist", "Release", "GNU-Linux"))
+
+sys.path.insert(0, MODULE_DIR)
+import quickftpy
+
+ADDR = "127.0.0.1"
+TIMEOUT = 20000
+TIMEOUT_ACK = 15000
+
+# Message codes, flags and parameter tags of V2 messages, see message.h
+FILE_SND_B = 0x01
+FILE_RCV_B = 0x02
+FILE_DEL_B = 0x04
+ACK_B = 0x08
+
+V2_FLAG_CHUNKED = 0x01
+V2_FLAG_RAW = 0x02
+V2_FLAG_KEEP_ALIVE = 0x04
+V2_FLAG_PIPELINED = 0x08
+
+TAG_PATH = 0x01
+TAG_FILENAME = 0x02
+TAG_RESULT = 0x03
+TAG_SIZE = 0x04
+TAG_MODE = 0x05
+TAG_CODEC = 0x06
+TAG_TRANSFER = 0x07
+TAG_HASH = 0x08
+TAG_OFFSET = 0x09
+TAG_LENGTH = 0x0A
+TAG_STRIPE = 0x0B
+TAG_BLOCK = 0x0C
+TAG_DIGEST = 0x0D
+
+SERVER_CODE = r'''
+import sys
+sys.path.insert(0, %(module_dir)r)
+import quickftpy
+
+def logger (f,m):
+  if %(verbose)r:
+    sys.stderr.write("[server][" + f + "] - " + m + "\n")
+
+%(setup)s
+
+if not quickftpy.servstart(%(port)d, %(max_conn)d, %(timeout)d, logger, %(workers)d, %(overflow)d, %(codecs)r, %(keep_alive)d, %(store)r):
+  sys.exit(1)
+
+print "started"
+sys.stdout.flush()
+
+while True:
+  line = sys.stdin.readline().strip()
+  if line == "stats":
+    print repr(quickftpy.servstats())
+    sys.stdout.flush()
+  else:
+    break
+
+quickftpy.servend()
+'''
+
+CLIENT_CODE = r'''
+import sys
+sys.path.insert(0, %r)
+import quickftpy
+
+def logger (f,m):
+  return
+'''
+
+failures = []
+verbose = os.environ.get("QFT_VERBOSE", "") != ""
+
+#
+# Callback logger function of the client, silent unless QFT_VERBOSE is set
+#
+def logger (f,m):
+  if verbose:
+    print "[client][" + f + "] - " + m
+  return
+
+#
+# Records the result of a check
+#
+def check(condition, what):
+  if condition:
+    print "  ok      %s" % what
+  else:
+    print "  FAILED  %s" % what
+    failures.append(what)
+  return condition
+
+#
+# Prints the outcome of the script and exits with 1 if a check failed
+#
+def finish():
+  if failures:
+    print "FAILED (%d)" % len(failures)
+    sys.exit(1)
+  print "OK"
+  sys.exit(0)
+
+#
+# Temporary directory of a script, removed by its remove method
+#
+class WorkDir(object):
+
+  def __init__(self):
+    self.path = tempfile.mkdtemp(prefix="qfttest-")
+
+  def join(self, *names):
+    return os.path.join(self.path, *names)
+
+  def write(self, name, content):
+    path = self.join(name)
+    if not os.path.isdir(os.path.dirname(path)):
+      os.makedirs(os.path.dirname(path))
+    f = open(path, "wb")
+    f.write(content)
+    f.close()
+    return path
+
+  def read(self, name):
+    path = self.join(name)
+    if not os.path.exists(path):
+      return None
+    f = open(path, "rb")
+    content = f.read()
+    f.close()
+    return content
+
+  def remove(self):
+    shutil.rmtree(self.path, True)
+
+#
+# Server started in a child process on a random port
+#
+class Server(object):
+
+  def __init__(self, max_conn=16, timeout=20000, workers=4, overflow=0, codecs=None, keep_alive=0, store=None, setup="", module_dir=None):
+    self.process = None
+    for attempt in range(5):
+      self.port = random.randint(20000, 60000)
+      code = SERVER_CODE % { "module_dir": module_dir or MODULE_DIR, "verbose": verbose, "setup": setup,
+                             "port": self.port, "max_conn": max_conn, "timeout": timeout, "workers": workers,
+                             "overflow": overflow, "codecs": codecs, "keep_alive": keep_alive, "store": store }
+      self.process = subprocess.Popen([sys.executable, "-c", code], stdin=subprocess.PIPE, stdout=subprocess.PIPE, close_fds=True)
+      if self.process.stdout.readline().strip() == "started":
+        break
+      self.process.wait()
+      self.process = None
+    if self.process is None:
+      raise RuntimeError("server could not be started")
+    self.sport = str(self.port)
+
+  def stats(self):
+    self.process.stdin.write("stats\n")
+    self.process.stdin.flush()
+    return eval(self.process.stdout.readline())
+
+  #
+  # Gets the statistics once they meet a condition, as the server updates
+  # some of them only after the client got its response, or the last ones
+  # when they do not within the given seconds
+  #
+  def settle(self, condition, wait=5):
+    deadline = time.time() + wait
+    stats = self.stats()
+    while not condition(stats) and time.time() < deadline:
+      time.sleep(0.05)
+      stats = self.stats()
+    return stats
+
+  def end(self):
+    if self.process is not None:
+      try:
+        self.process.stdin.write("end\n")
+        self.process.stdin.flush()
+      except IOError:
+        pass
+      for i in range(100):
+        if self.process.poll() is not None:
+          break
+        time.sleep(0.1)
+      if self.process.poll() is None:
+        self.process.kill()
+        self.process.wait()
+      self.process = None
+
+#
+# Runs client code in another process, as the calls of the module keep
+# the interpreter busy. The code finds quickftpy and logger defined, and
+# the sockets of the caller are not inherited.
+#
+def spawn(code):
+  return subprocess.Popen([sys.executable, "-c", CLIENT_CODE % MODULE_DIR + code], close_fds=True)
+
+#
+# Receives exactly len bytes from a socket
+#
+def recv_exact(s, length):
+  data = []
+  while length > 0:
+    part = s.recv(min(length, 65536))
+    if not part:
+      raise IOError("connection closed")
+    data.append(part)
+    length -= len(part)
+  return "".join(data)
+
+#
+# Builds a V1 message from its code and its parameters, which start
+# with the separator, e.g. ":=filename:/tmp/file"
+#
+def v1_message(code, var_part):
+  return "QUIFT_MSG=V1.0=%s=%08x" % (code, len(var_part)) + var_part
+
+#
+# Sends a V1 request, in pieces of the given length if any, and returns
+# the ACK, and the header and the parameters of the response, the frames
+# of a chunked content being joined after them
+#
+def v1_exchange(port, message, piece=0):
+  s = socket.create_connection((ADDR, port))
+  s.settimeout(TIMEOUT / 1000)
+  try:
+    if piece:
+      for i in range(0, len(message), piece):
+        s.sendall(message[i:i + piece])
+    else:
+      s.sendall(message)
+    ack = recv_exact(s, 32)
+    header = recv_exact(s, 32)
+    var_part = recv_exact(s, int(header[24:32], 16))
+    if "=chunked:1" in var_part:
+      frames = []
+      length = int(recv_exact(s, 8), 16)
+      while length > 0:
+        frames.append(recv_exact(s, length))
+        length = int(recv_exact(s, 8), 16)
+      var_part += "".join(frames)
+    return ack, header, var_part
+  finally:
+    s.close()
+
+#
+# Gets a parameter of a V1 message, content being the last one
+#
+def v1_param(var_part, name):
+  if ("=" + name + ":") not in var_part:
+    return None
+  value = var_part.split("=" + name + ":", 1)[1]
+  return ( name == "content" ) and value or value.split("=", 1)[0]
+
+#
+# Packs content as V1 messages carry it, gzip data encoded in base64
+#
+def v1_pack(content):
+  packer = zlib.compressobj(6, zlib.DEFLATED, 31)
+  return base64.b64encode(packer.compress(content) + packer.flush())
+
+#
+# Unpacks V1 content, gzip data encoded in base64
+#
+def v1_unpack(content):
+  return gunzip(base64.b64decode(content))
+
+#
+# Unpacks gzip data, which may be made of several members
+#
+def gunzip(data):
+  parts = []
+  while data:
+    unpacker = zlib.decompressobj(31)
+    parts.append(unpacker.decompress(data))
+    data = unpacker.unused_data
+  return "".join(parts)
+
+#
+# Opens a connection to the server for raw messages
+#
+def connect(port):
+  s = socket.create_connection((ADDR, port))
+  s.settimeout(TIMEOUT / 1000)
+  return s
+
+#
+# Builds a V2 parameter, of an 8 bytes value when given a number
+#
+def v2_param(tag, value):
+  if isinstance(value, (int, long)):
+    value = struct.pack(">q", value)
+  return chr(tag) + struct.pack(">H", len(value)) + value
+
+#
+# Builds a V2 message, the length of the parameters in the header can be
+# given to make it disagree with them
+#
+def v2_message(message_type, flags, params, request_id=0, params_len=None):
+  if params_len is None:
+    params_len = len(params)
+  return "QUIFT_MSG=V2.0=" + chr(message_type) + chr(flags) + struct.pack(">I", request_id) + "\0" * 7 + struct.pack(">I", params_len) + params
+
+#
+# Receives a V2 message, and returns its code, its flags and its
+# parameters by tag, the result being decoded
+#
+def v2_read(s):
+  return v2_read_pipelined(s)[1:]
+
+#
+# Receives a V2 message as v2_read does, its request ID coming first
+#
+def v2_read_pipelined(s):
+  header = recv_exact(s, 32)
+  data = recv_exact(s, struct.unpack(">I", header[28:32])[0])
+  params = {}
+  index = 0
+  while index + 3 <= len(data):
+    length = struct.unpack(">H", data[index + 1:index + 3])[0]
+    params[ord(data[index])] = data[index + 3:index + 3 + length]
+    index += 3 + length
+  if TAG_RESULT in params:
+    params[TAG_RESULT] = struct.unpack(">i", params[TAG_RESULT])[0]
+  return struct.unpack(">I", header[17:21])[0], ord(header[15]), ord(header[16]), params
+
+#
+# Gets an 8 bytes parameter of a V2 message
+#
+def v2_number(params, tag):
+  return struct.unpack(">q", params[tag])[0]
+
+#
+# Receives V2 content frames up to the empty one
+#
+def v2_frames(s):
+  frames = []
+  length = struct.unpack(">I", recv_exact(s, 4))[0]
+  while length > 0:
+    frames.append(recv_exact(s, length))
+    length = struct.unpack(">I", recv_exact(s, 4))[0]
+  return "".join(frames)
+
+#
+# Tells whether the server closes a connection within the given seconds,
+# reading what is left of it
+#
+def closed(s, wait=5):
+  s.settimeout(wait)
+  try:
+    while s.recv(65536):
+      pass
+    return True
+  except socket.timeout:
+    return False
+  except socket.error:
+    return True
+
+#
+# Content that compresses, of about the given length
+#
+def text(length, seed=0):
+  line = 0
+  parts = []
+  size = 0
+  while size < length:
+    part = "line %d of content %d, some words to compress\n" % (line, seed)
+    parts.append(part)
+    size += len(part)
+    line += 1
+  return "".join(parts)[:length]
+
+#
+# Content that does not compress
+#
+def noise(length):
+  return os.urandom(length)
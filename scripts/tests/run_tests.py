@@ -0,0 +1,42 @@
+#
+# Runs the scripted checks of the library, every test_*.py next to this
+# script or the ones given, and exits with 1 if any of them failed.
+#
+#   python run_tests.py [test_name.py ...]
+#
+# The module is built beforehand, see qfttest.py for where it is found.
+#
+
+import os
+import sys
+import glob
+import time
+import subprocess
+
+def main(argv):
+
+  here = os.path.dirname(os.path.abspath(__file__))
+  tests = argv or sorted(os.path.basename(t) for t in glob.glob(os.path.join(here, "test_*.py")))
+  failed = []
+
+  for test in tests:
+
+    print "== %s" % test
+    sys.stdout.flush()
+
+    start = time.time()
+    result = subprocess.call([sys.executable, os.path.join(here, test)], cwd=here)
+    print "   %s in %.1fs" % (( result == 0 ) and "passed" or "FAILED", time.time() - start)
+
+    if result != 0:
+      failed.append(test)
+
+  print ""
+  print "%d of %d passed" % (len(tests) - len(failed), len(tests))
+  for test in failed:
+    print "  failed: %s" % test
+
+  sys.exit(( failed ) and 1 or 0)
+
+if __name__ == "__main__":
+  main(sys.argv[1:])
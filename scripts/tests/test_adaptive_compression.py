@@ -0,0 +1,105 @@
+#
+# Checks the compression mode the server chooses per file, by sampling
+# its content or by its extension, and the settings that force a mode or
+# override the one of an extension.
+#
+
+import qfttest
+from qfttest import quickftpy, check, logger, v2_message, v2_param, v2_read, ADDR, TIMEOUT, TIMEOUT_ACK
+from qfttest import FILE_RCV_B, ACK_B, V2_FLAG_RAW, TAG_FILENAME, TAG_MODE, TAG_RESULT, TAG_SIZE
+
+MODES = { 0: "store", 1: "fast", 2: "default", 3: "best" }
+
+# Striped sends run without the interpreter lock, while the settings change
+CLIENT_CODE = r'''
+import threading
+done = []
+def configure():
+  i = 0
+  while not done:
+    quickftpy.setcompress(( -1, 1, 3 )[i %% 3], 0, 0, 0, ( i %% 2 ) and "txt:store" or None)
+    i += 1
+configurer = threading.Thread(target=configure)
+configurer.start()
+failed = 0
+for i in range(4):
+  if quickftpy.clsend_striped(%(remote)r + str(i), %(local)r, %(addr)r, %(port)r, %(timeout)d, %(timeout_ack)d, logger, 4) != 0:
+    failed += 1
+done.append(True)
+configurer.join()
+sys.exit(failed)
+'''
+
+#
+# Gets the mode of the content the server answers a File Receive with
+#
+def mode_of(server, path):
+  s = qfttest.connect(server.port)
+  try:
+    s.sendall(v2_message(FILE_RCV_B, 0, v2_param(TAG_FILENAME, path)))
+    message_type, flags, params = v2_read(s)
+    if message_type == ACK_B:
+      message_type, flags, params = v2_read(s)
+    if params[TAG_RESULT] != 0:
+      return None
+    # Stored content is sent as the file itself
+    if flags & V2_FLAG_RAW:
+      qfttest.recv_exact(s, qfttest.v2_number(params, TAG_SIZE))
+      return "store"
+    qfttest.v2_frames(s)
+    return MODES[ord(params[TAG_MODE])]
+  finally:
+    s.close()
+
+def main():
+
+  work = qfttest.WorkDir()
+
+  # Half of it does not compress at all
+  mixed = "".join(qfttest.noise(4096) + qfttest.text(4096, i) for i in range(64))
+
+  files = { "text.txt": qfttest.text(1 << 20), "noise.bin": qfttest.noise(1 << 20),
+            "text.jpg": qfttest.text(1 << 20), "mixed.dat": mixed }
+  for name, content in files.items():
+    work.write(name, content)
+
+  settings = ( ( "quickftpy.setcompress(-1)", { "text.txt": "best", "noise.bin": "store", "text.jpg": "store", "mixed.dat": "default" } ),
+               ( "quickftpy.setcompress(1)", { "text.txt": "fast", "noise.bin": "fast" } ),
+               ( "quickftpy.setcompress(-1, 0, 0, 0, 'txt:fast,bin:best')", { "text.txt": "fast", "noise.bin": "best", "text.jpg": "best" } ) )
+
+  try:
+
+    for setup, expected in settings:
+
+      server = qfttest.Server(setup=setup)
+      try:
+
+        for name, mode in sorted(expected.items()):
+          chosen = mode_of(server, work.join(name))
+          check(chosen == mode, "%s: %s packed with %s mode, %s expected" % (setup, name, chosen, mode))
+
+          copy = work.join(name + ".copy")
+          result = quickftpy.clrecv(work.join(name), copy, ADDR, server.sport, TIMEOUT, TIMEOUT_ACK, logger)
+          check(result == 0 and work.read(name + ".copy") == files[name], "%s: %s received whole" % (setup, name))
+
+      finally:
+        server.end()
+
+    server = qfttest.Server()
+    try:
+
+      code = CLIENT_CODE % { "remote": work.join("striped.txt."), "local": work.join("text.txt"), "addr": ADDR, "port": server.sport,
+                             "timeout": TIMEOUT, "timeout_ack": TIMEOUT_ACK }
+      check(qfttest.spawn(code).wait() == 0 and all(work.read("striped.txt.%d" % i) == files["text.txt"] for i in range(4)),
+            "settings changed while transfers run")
+
+    finally:
+      server.end()
+
+  finally:
+    work.remove()
+
+  qfttest.finish()
+
+if __name__ == "__main__":
+  main()
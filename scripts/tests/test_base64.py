@@ -0,0 +1,35 @@
+#
+# Builds base64_check.c and runs it, which checks the vector kernels of
+# the base64 codec against the scalar code, with a fixed seed and a
+# random one.
+#
+
+import os
+import random
+import subprocess
+
+import qfttest
+from qfttest import check
+
+def main():
+
+  here = os.path.dirname(os.path.abspath(__file__))
+  work = qfttest.WorkDir()
+  binary = work.join("base64_check")
+
+  try:
+
+    built = subprocess.call([os.environ.get("CC", "cc"), "-O2", "-o", binary, os.path.join(here, "base64_check.c")]) == 0
+    check(built, "base64_check builds")
+
+    if built:
+      for seed in (1, random.randint(2, 1 << 30)):
+        check(subprocess.call([binary, "seed", str(seed)]) == 0, "kernels match the scalar code with seed %d" % seed)
+
+  finally:
+    work.remove()
+
+  qfttest.finish()
+
+if __name__ == "__main__":
+  main()
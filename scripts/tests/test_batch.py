@@ -0,0 +1,60 @@
+#
+# Checks batches of File Send and File Receive operations, the result and
+# time of each file, failures kept to their own file, and the arguments
+# the batch functions refuse.
+#
+
+import qfttest
+from qfttest import quickftpy, check, logger, ADDR, TIMEOUT, TIMEOUT_ACK
+
+RESULT_FILE_NOT_FOUND = -106
+
+def main():
+
+  work = qfttest.WorkDir()
+  contents = dict(("f%02d" % i, qfttest.text(1000 + 997 * i, i)) for i in range(50))
+  for name, content in contents.items():
+    work.write("local-" + name, content)
+  names = sorted(contents)
+
+  server = qfttest.Server()
+
+  try:
+
+    files = [(work.join("local-" + name), work.join("remote-" + name)) for name in names] + [(work.join("local-missing"), work.join("remote-missing"))]
+    results = quickftpy.clsend_many(files, ADDR, server.sport, TIMEOUT, TIMEOUT_ACK, logger)
+    check([result for result, elapsed in results[:-1]] == [0] * 50 and all(work.read("remote-" + name) == contents[name] for name in names),
+          "batch of 50 sends")
+    check(results[-1][0] != 0 and work.read("remote-missing") is None, "missing local file fails on its own")
+    check(all(isinstance(elapsed, float) and elapsed >= 0 for result, elapsed in results), "time of each file reported")
+
+    files = [(work.join("remote-" + name), work.join("back-" + name)) for name in names] + [(work.join("remote-missing"), work.join("back-missing"))]
+    results = quickftpy.clrecv_many(files, ADDR, server.sport, TIMEOUT, TIMEOUT_ACK, logger, 1, "zstd")
+    check([result for result, elapsed in results[:-1]] == [0] * 50 and all(work.read("back-" + name) == contents[name] for name in names),
+          "batch of 50 raw receives")
+    check(results[-1][0] == RESULT_FILE_NOT_FOUND, "missing remote file fails on its own")
+
+    session = quickftpy.Session(ADDR, server.sport, 2, TIMEOUT, TIMEOUT_ACK, logger)
+    results = session.clrecv_many([(work.join("remote-" + name), work.join("session-" + name)) for name in names], codec="lz4")
+    check([result for result, elapsed in results] == [0] * 50 and all(work.read("session-" + name) == contents[name] for name in names),
+          "batch of 50 receives through a session")
+    session.close()
+
+    check(quickftpy.clsend_many([], ADDR, server.sport, TIMEOUT, TIMEOUT_ACK, logger) == [], "empty batch")
+
+    for files in ([("only one",)], ["not a tuple"], 42):
+      try:
+        quickftpy.clrecv_many(files, ADDR, server.sport, TIMEOUT, TIMEOUT_ACK, logger)
+        refused = False
+      except (TypeError, ValueError):
+        refused = True
+      check(refused, "batch of %r refused" % (files,))
+
+  finally:
+    server.end()
+    work.remove()
+
+  qfttest.finish()
+
+if __name__ == "__main__":
+  main()
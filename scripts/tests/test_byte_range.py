@@ -0,0 +1,73 @@
+#
+# Checks byte ranges of a file: offsets and lengths counted from its end
+# when negative, ranges clipped to it, offsets past its end, and the
+# offset and length the server answers with.
+#
+
+import qfttest
+from qfttest import quickftpy, check, logger, v2_message, v2_param, v2_read, ADDR, TIMEOUT, TIMEOUT_ACK
+from qfttest import FILE_RCV_B, ACK_B, V2_FLAG_RAW, TAG_FILENAME, TAG_OFFSET, TAG_LENGTH, TAG_SIZE, TAG_RESULT
+
+RESULT_FILE_NOT_FOUND = -106
+
+#
+# Asks for a range uncompressed over a raw connection, returns the offset
+# the server answers from and the content that follows
+#
+def range_of(server, path, offset, length):
+  s = qfttest.connect(server.port)
+  try:
+    s.sendall(v2_message(FILE_RCV_B, V2_FLAG_RAW, v2_param(TAG_FILENAME, path) + v2_param(TAG_OFFSET, offset) + v2_param(TAG_LENGTH, length)))
+    message_type, flags, params = v2_read(s)
+    if message_type == ACK_B:
+      message_type, flags, params = v2_read(s)
+    if params[TAG_RESULT] != 0:
+      return params[TAG_RESULT], None
+    return qfttest.v2_number(params, TAG_OFFSET), qfttest.recv_exact(s, qfttest.v2_number(params, TAG_SIZE))
+  finally:
+    s.close()
+
+def main():
+
+  work = qfttest.WorkDir()
+  content = qfttest.text(1 << 20)
+  size = len(content)
+  remote = work.write("remote", content)
+
+  # Offset and length asked for, then the offset and content expected
+  ranges = [(0, 100, 0, content[:100]),
+            (5000, 70000, 5000, content[5000:75000]),
+            (-100, 40, size - 100, content[-100:-60]),
+            (-100, -1, size - 100, content[-100:]),
+            (1000, -1, 1000, content[1000:]),
+            (size - 10, 1000, size - 10, content[-10:]),
+            (-10 * size, 10, 0, content[:10]),
+            (-2 ** 63, 10, 0, content[:10]),
+            (size + 5, 10, size, ""),
+            (size, -1, size, "")]
+
+  server = qfttest.Server()
+
+  try:
+
+    for offset, length, start, expected in ranges:
+      check(range_of(server, remote, offset, length) == (start, expected), "raw range of %d bytes at %d" % (length, offset))
+
+    for raw, codec in ((1, "gzip"), (0, "gzip"), (0, "zstd"), (0, "lz4")):
+      for offset, length, start, expected in ranges:
+        local = work.join("local")
+        result = quickftpy.clrecv_range(remote, local, ADDR, server.sport, TIMEOUT, TIMEOUT_ACK, logger, offset, length, raw, codec)
+        check(result == 0 and work.read("local") == expected, "clrecv_range of %d bytes at %d, %s %s" % (length, offset, ( "packed", "raw" )[raw], codec))
+
+    check(range_of(server, work.join("missing"), 0, 10)[0] == RESULT_FILE_NOT_FOUND, "range of a missing file")
+    check(quickftpy.clrecv_range(work.join("missing"), work.join("local"), ADDR, server.sport, TIMEOUT, TIMEOUT_ACK, logger, 0, 10) == RESULT_FILE_NOT_FOUND,
+          "clrecv_range of a missing file")
+
+  finally:
+    server.end()
+    work.remove()
+
+  qfttest.finish()
+
+if __name__ == "__main__":
+  main()
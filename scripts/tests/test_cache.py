@@ -0,0 +1,129 @@
+#
+# Checks the cache of encoded content: repeated receives served from it,
+# entries of each codec and format kept apart, ranges and raw receives
+# going around it, every change of a file dropping its entries, and the
+# disk tier taking what the memory one evicts.
+#
+
+import os
+import time
+
+import qfttest
+from qfttest import quickftpy, check, logger, ADDR, TIMEOUT, TIMEOUT_ACK
+
+#
+# Receives a file and tells whether its content is the one expected
+#
+def receive(server, work, remote, expected, raw=0, codec="gzip", chunked=0):
+  result = quickftpy.clrecv(work.join(remote), work.join("local"), ADDR, server.sport, TIMEOUT, TIMEOUT_ACK, logger, chunked, raw, codec)
+  return result == 0 and work.read("local") == expected
+
+#
+# Receives a file the cache has no entry for, then waits until the entry
+# made as the response was sent is inserted
+#
+def fill(server, work, remote, expected, codec="gzip"):
+  insertions = server.stats()["cache_insertions"]
+  if not receive(server, work, remote, expected, codec=codec):
+    return False
+  for i in range(50):
+    if server.stats()["cache_insertions"] > insertions:
+      return True
+    time.sleep(0.1)
+  return False
+
+#
+# Runs some operations and gives the change of the cache counters they made
+#
+def counted(server, operations):
+  before = server.stats()
+  done = operations()
+  after = server.stats()
+  return done, dict((key[6:], after[key] - before[key]) for key in after if key.startswith("cache_"))
+
+def main():
+
+  work = qfttest.WorkDir()
+  content = qfttest.text(1 << 20)
+  changed = qfttest.text(1 << 20, 1)
+  work.write("hot", content)
+
+  try:
+
+    server = qfttest.Server(setup="quickftpy.setcache(64 << 20)")
+    try:
+
+      done, delta = counted(server, lambda: fill(server, work, "hot", content))
+      check(done and delta["misses"] == 1 and delta["insertions"] == 1 and delta["entries"] == 1, "first receive fills the cache")
+      done, delta = counted(server, lambda: all(receive(server, work, "hot", content) for i in range(5)))
+      check(done and delta["hits"] == 5 and delta["misses"] == 0, "5 receives served from the cache")
+      check(server.stats()["cache_memory_bytes"] > 0, "memory taken by the entry counted")
+
+      done, delta = counted(server, lambda: fill(server, work, "hot", content, codec="zstd") and receive(server, work, "hot", content, codec="zstd"))
+      check(done and delta["misses"] == 1 and delta["hits"] == 1 and delta["entries"] == 1, "another codec gets an entry of its own")
+
+      request = qfttest.v1_message("FILE_RCV", ":=filename:%s" % work.join("hot"))
+      def v1_receives():
+        received = []
+        for i in range(2):
+          insertions = server.stats()["cache_insertions"]
+          received.append(qfttest.v1_unpack(qfttest.v1_param(qfttest.v1_exchange(server.port, request)[2], "content")))
+          while i == 0 and server.stats()["cache_insertions"] == insertions:
+            time.sleep(0.1)
+        return received == [content, content]
+      done, delta = counted(server, v1_receives)
+      check(done and delta["misses"] == 1 and delta["hits"] == 1, "V1 receives cached")
+
+      def around():
+        local = work.join("local")
+        return ( receive(server, work, "hot", content, raw=1) and
+                 quickftpy.clrecv_range(work.join("hot"), local, ADDR, server.sport, TIMEOUT, TIMEOUT_ACK, logger, 10, 100) == 0 and
+                 work.read("local") == content[10:110] )
+      done, delta = counted(server, around)
+      check(done and delta["hits"] == 0 and delta["misses"] == 0 and delta["insertions"] == 0, "raw receives and ranges go around the cache")
+
+      # A file changed behind the server is noticed by its next lookup
+      time.sleep(0.01)
+      work.write("hot", changed)
+      done, delta = counted(server, lambda: fill(server, work, "hot", changed))
+      check(done and delta["invalidations"] >= 1 and delta["hits"] == 0, "file changed on disk served again, stale entry dropped")
+
+      # A File Send of the file drops its entries at once
+      fill(server, work, "hot", changed, codec="zstd")
+      work.write("new", content)
+      done, delta = counted(server, lambda: quickftpy.clsend(work.join("hot"), work.join("new"), ADDR, server.sport, TIMEOUT, TIMEOUT_ACK, logger) == 0)
+      check(done and delta["invalidations"] == 2 and delta["entries"] == -2, "File Send drops the entries of the file")
+      check(fill(server, work, "hot", content), "content sent afterwards served")
+
+      done, delta = counted(server, lambda: quickftpy.cldel(work.join("hot"), ADDR, server.sport, TIMEOUT, TIMEOUT_ACK, logger) == 0)
+      check(done and delta["invalidations"] == 1 and server.stats()["cache_entries"] == 0, "File Delete drops the entries of the file")
+      check(quickftpy.clrecv(work.join("hot"), work.join("local"), ADDR, server.sport, TIMEOUT, TIMEOUT_ACK, logger) == -106,
+            "deleted file not served from the cache")
+
+    finally:
+      server.end()
+
+    # Entries the memory tier evicts go to the disk tier
+    for i in range(12):
+      work.write("warm-%d" % i, qfttest.text(2 << 20, i))
+    os.mkdir(work.join("cache"))
+    server = qfttest.Server(setup="quickftpy.setcache(1 << 20, %r, 64 << 20)" % work.join("cache"))
+    try:
+
+      done, delta = counted(server, lambda: all(fill(server, work, "warm-%d" % i, work.read("warm-%d" % i)) for i in range(12)))
+      check(done and delta["misses"] == 12 and delta["evictions"] >= 2, "memory tier evicts the older entries")
+      check(server.stats()["cache_disk_bytes"] > 0 and os.listdir(work.join("cache")), "evicted entries written to the disk tier")
+
+      done, delta = counted(server, lambda: receive(server, work, "warm-0", work.read("warm-0")))
+      check(done and delta["disk_hits"] == 1, "entry served from the disk tier")
+
+    finally:
+      server.end()
+
+  finally:
+    work.remove()
+
+  qfttest.finish()
+
+if __name__ == "__main__":
+  main()
@@ -0,0 +1,56 @@
+#
+# Checks that the client sends and receives a file much larger than the
+# memory it takes, packed and raw, measuring its peak resident size in a
+# process of its own.
+#
+
+import qfttest
+from qfttest import check, ADDR, TIMEOUT, TIMEOUT_ACK
+
+FILE_MB = 96
+LIMIT_MB = 32
+
+CLIENT_CODE = r'''
+import resource
+before = resource.getrusage(resource.RUSAGE_SELF).ru_maxrss
+if %(send)r:
+  result = quickftpy.clsend(%(remote)r, %(local)r, %(addr)r, %(port)r, %(timeout)d, %(timeout_ack)d, logger, %(raw)d)
+else:
+  result = quickftpy.clrecv(%(remote)r, %(local)r, %(addr)r, %(port)r, %(timeout)d, %(timeout_ack)d, logger, 0, %(raw)d)
+grown = ( resource.getrusage(resource.RUSAGE_SELF).ru_maxrss - before ) / 1024
+print "  client grew %%d MB" %% grown
+sys.exit(( result != 0 ) and 1 or ( grown >= %(limit)d ) and 2 or 0)
+'''
+
+def main():
+
+  work = qfttest.WorkDir()
+  server = qfttest.Server()
+
+  contents = { "text": qfttest.text(FILE_MB << 20), "noise": qfttest.noise(FILE_MB << 20) }
+  for name, content in contents.items():
+    work.write(name, content)
+
+  try:
+
+    for name, content in sorted(contents.items()):
+      for raw in (0, 1):
+        for send in (True, False):
+
+          copy = "%s-%d-%s" % (name, raw, ( send ) and "sent" or "received")
+          remote, local = ( send ) and ( work.join(copy), work.join(name) ) or ( work.join(name), work.join(copy) )
+          code = CLIENT_CODE % { "send": send, "remote": remote, "local": local, "addr": ADDR, "port": server.sport,
+                                 "timeout": TIMEOUT, "timeout_ack": TIMEOUT_ACK, "raw": raw, "limit": LIMIT_MB }
+          status = qfttest.spawn(code).wait()
+
+          what = "%s %s of %d MB of %s" % (( raw ) and "raw" or "packed", ( send ) and "send" or "receive", FILE_MB, name)
+          check(status == 0 and work.read(copy) == content, "%s within %d MB" % (what, LIMIT_MB))
+
+  finally:
+    server.end()
+    work.remove()
+
+  qfttest.finish()
+
+if __name__ == "__main__":
+  main()
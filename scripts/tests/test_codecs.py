@@ -0,0 +1,87 @@
+#
+# Checks transfers with each codec in both directions, the codec the
+# server answers with when it does not allow the one asked for, and the
+# codec settings of the module.
+#
+
+import qfttest
+from qfttest import quickftpy, check, logger, v2_message, v2_param, v2_read, ADDR, TIMEOUT, TIMEOUT_ACK
+from qfttest import FILE_RCV_B, ACK_B, TAG_FILENAME, TAG_CODEC, TAG_RESULT
+
+CODECS = { "gzip": 0, "zstd": 1, "lz4": 2 }
+
+#
+# Gets the codec the server answers a File Receive asking for one with
+#
+def codec_of(server, path, codec):
+  s = qfttest.connect(server.port)
+  try:
+    s.sendall(v2_message(FILE_RCV_B, 0, v2_param(TAG_FILENAME, path) + v2_param(TAG_CODEC, chr(CODECS[codec]))))
+    message_type, flags, params = v2_read(s)
+    if message_type == ACK_B:
+      message_type, flags, params = v2_read(s)
+    if params[TAG_RESULT] != 0:
+      return None
+    qfttest.v2_frames(s)
+    return ord(params.get(TAG_CODEC, "\0"))
+  finally:
+    s.close()
+
+def main():
+
+  work = qfttest.WorkDir()
+  contents = { "text": qfttest.text(3 << 20), "noise": qfttest.noise(1 << 20), "one": "x" }
+  for name, content in contents.items():
+    work.write(name, content)
+
+  try:
+
+    server = qfttest.Server()
+    try:
+
+      for codec in sorted(CODECS):
+        for name, content in sorted(contents.items()):
+
+          result = quickftpy.clsend(work.join("%s.%s.sent" % (name, codec)), work.join(name), ADDR, server.sport, TIMEOUT, TIMEOUT_ACK, logger, 0, codec)
+          check(result == 0 and work.read("%s.%s.sent" % (name, codec)) == content, "send of %s with %s" % (name, codec))
+
+          result = quickftpy.clrecv(work.join(name), work.join("%s.%s.received" % (name, codec)), ADDR, server.sport, TIMEOUT, TIMEOUT_ACK, logger, 0, 0, codec)
+          check(result == 0 and work.read("%s.%s.received" % (name, codec)) == content, "receive of %s with %s" % (name, codec))
+
+        check(codec_of(server, work.join("text"), codec) == CODECS[codec], "server answers with %s when asked for it" % codec)
+
+    finally:
+      server.end()
+
+    # A server that only allows gzip answers with it
+    server = qfttest.Server(codecs="gzip")
+    try:
+
+      check(codec_of(server, work.join("text"), "zstd") == CODECS["gzip"], "server that only allows gzip answers with it")
+
+      result = quickftpy.clrecv(work.join("text"), work.join("text.fallback"), ADDR, server.sport, TIMEOUT, TIMEOUT_ACK, logger, 0, 0, "zstd")
+      check(result == 0 and work.read("text.fallback") == contents["text"], "receive asking for zstd from a gzip only server")
+
+      result = quickftpy.clsend(work.join("text.fallback.sent"), work.join("text"), ADDR, server.sport, TIMEOUT, TIMEOUT_ACK, logger, 0, "lz4")
+      check(result == 0 and work.read("text.fallback.sent") == contents["text"], "send asking for lz4 to a gzip only server")
+
+    finally:
+      server.end()
+
+    try:
+      qfttest.Server(codecs="gzip,brotli").end()
+      refused = False
+    except RuntimeError:
+      refused = True
+    check(refused, "server does not start with an unknown codec allowed")
+
+    check(quickftpy.setcodec("zstd", 19, 1) and quickftpy.setcodec("lz4", 1) and quickftpy.setcodec("gzip"), "codec settings are taken")
+    check(not quickftpy.setcodec("brotli"), "unknown codec is refused")
+
+  finally:
+    work.remove()
+
+  qfttest.finish()
+
+if __name__ == "__main__":
+  main()
@@ -0,0 +1,100 @@
+#
+# Checks the content store: every file received kept once as a blob named
+# after its digest, identical uploads sharing it, and a File Send with a
+# digest the store holds answered at once, without its content.
+#
+
+import hashlib
+import os
+
+import qfttest
+from qfttest import quickftpy, check, logger, v2_message, v2_param, v2_read, ADDR, TIMEOUT, TIMEOUT_ACK
+from qfttest import FILE_SND_B, ACK_B, V2_FLAG_RAW, TAG_PATH, TAG_SIZE, TAG_DIGEST, TAG_RESULT
+
+#
+# Sends a file uncompressed with the digest of a content, returns whether
+# the server asked for the content and the result of the request
+#
+def send_with_digest(server, path, digest, content):
+  s = qfttest.connect(server.port)
+  try:
+    s.sendall(v2_message(FILE_SND_B, V2_FLAG_RAW, v2_param(TAG_PATH, path) + v2_param(TAG_SIZE, len(content)) + v2_param(TAG_DIGEST, digest)))
+    message_type, flags, params = v2_read(s)
+    asked = ( message_type == ACK_B )
+    if asked:
+      s.sendall(content)
+      message_type, flags, params = v2_read(s)
+    return asked, params[TAG_RESULT]
+  finally:
+    s.close()
+
+#
+# Tells whether two files share their content, hard linked, or
+# cloned on a file system with reflinks
+#
+def shared(a, b):
+  info_a, info_b = os.stat(a), os.stat(b)
+  if ( info_a.st_dev, info_a.st_ino ) == ( info_b.st_dev, info_b.st_ino ):
+    return True
+  return info_a.st_nlink == 1 and info_b.st_nlink == 1 and open(a, "rb").read() == open(b, "rb").read()
+
+def main():
+
+  work = qfttest.WorkDir()
+  content = qfttest.text(2 << 20)
+  other = qfttest.text(2 << 20, 1)
+  digest = hashlib.sha256(content).digest()
+  work.write("local-a", content)
+  work.write("local-b", content)
+  work.write("local-other", other)
+  store = work.join("store")
+  blob = os.path.join(store, digest.encode("hex")[:2], digest.encode("hex"))
+
+  server = qfttest.Server(store=store)
+
+  try:
+
+    result = quickftpy.clsend(work.join("target-1"), work.join("local-a"), ADDR, server.sport, TIMEOUT, TIMEOUT_ACK, logger)
+    check(result == 0 and work.read("target-1") == content, "first upload")
+    check(os.path.exists(blob) and open(blob, "rb").read() == content, "blob named after the SHA-256 digest")
+    check(shared(blob, work.join("target-1")), "file shares the blob")
+
+    for raw, codec in ((0, "gzip"), (1, "gzip"), (0, "zstd")):
+      target = work.join("target-%d-%s" % (raw, codec))
+      result = quickftpy.clsend(target, work.join("local-b"), ADDR, server.sport, TIMEOUT, TIMEOUT_ACK, logger, raw, codec)
+      check(result == 0 and open(target, "rb").read() == content and shared(work.join("target-1"), target),
+            "identical upload (%s %s) linked to the same blob" % (( "packed", "raw" )[raw], codec))
+
+    result = quickftpy.clsend(work.join("target-other"), work.join("local-other"), ADDR, server.sport, TIMEOUT, TIMEOUT_ACK, logger)
+    check(result == 0 and work.read("target-other") == other and not shared(work.join("target-1"), work.join("target-other")),
+          "another content kept apart")
+    check(sum(len(files) for path, dirs, files in os.walk(store)) == 2, "two blobs stored")
+
+    # Content the store holds is not asked for
+    check(send_with_digest(server, work.join("target-digest"), digest, content) == (False, 0) and work.read("target-digest") == content,
+          "known digest answered without the content")
+    check(send_with_digest(server, work.join("target-size"), digest, content + "x") == (True, 0) and work.read("target-size") == content + "x",
+          "known digest with another size asks for the content")
+    check(send_with_digest(server, work.join("target-unknown"), hashlib.sha256("unknown").digest(), other) == (True, 0) and
+          work.read("target-unknown") == other and shared(work.join("target-unknown"), work.join("target-other")),
+          "unknown digest asks for the content, indexed by what was received")
+
+    # Uploads asking for deduplication
+    result = quickftpy.clsend(work.join("target-dedup"), work.join("local-a"), ADDR, server.sport, TIMEOUT, TIMEOUT_ACK, logger, 0, "gzip", None, None, 1)
+    check(result == 0 and work.read("target-dedup") == content and shared(work.join("target-1"), work.join("target-dedup")), "clsend with dedup")
+    work.write("local-new", qfttest.text(100000, 2))
+    result = quickftpy.clsend(work.join("target-new"), work.join("local-new"), ADDR, server.sport, TIMEOUT, TIMEOUT_ACK, logger, 0, "gzip", None, None, 1)
+    check(result == 0 and work.read("target-new") == work.read("local-new"), "clsend with dedup of a new content")
+
+    # A file made from a blob is replaced, never written through, by the next upload
+    result = quickftpy.clsend(work.join("target-digest"), work.join("local-other"), ADDR, server.sport, TIMEOUT, TIMEOUT_ACK, logger)
+    check(result == 0 and open(blob, "rb").read() == content and work.read("target-1") == content, "blob untouched when a file sharing it is replaced")
+
+  finally:
+    server.end()
+    work.remove()
+
+  qfttest.finish()
+
+if __name__ == "__main__":
+  main()
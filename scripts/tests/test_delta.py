@@ -0,0 +1,141 @@
+#
+# Checks delta updates: the signature of a file, a changed file rebuilt
+# from a delta far smaller than it, and the whole file sent instead when
+# the server does not have it or when nothing of it is left.
+#
+
+import socket
+import struct
+import threading
+
+import qfttest
+from qfttest import check, v2_message, v2_param, v2_read, ADDR, TIMEOUT, TIMEOUT_ACK
+from qfttest import FILE_SND_B, FILE_RCV_B, ACK_B, V2_FLAG_CHUNKED, TAG_PATH, TAG_FILENAME, TAG_BLOCK, TAG_SIZE, TAG_HASH, TAG_RESULT
+
+SIGNATURE_ENTRY_LEN = 12
+RESULT_INVALID_REQUEST = -103
+
+CLIENT_CODE = r'''
+result = quickftpy.clsend_delta(%(remote)r, %(local)r, %(addr)r, %(port)r, %(timeout)d, %(timeout_ack)d, logger, %(codec)r)
+sys.exit(0 if result == 0 else 1)
+'''
+
+#
+# Forwards connections to the server, counting the bytes the clients send
+#
+class Proxy:
+
+  def __init__(self, port):
+    self.target = port
+    self.sent = 0
+    self.lock = threading.Lock()
+    self.listener = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    self.listener.bind((ADDR, 0))
+    self.listener.listen(16)
+    self.port = self.listener.getsockname()[1]
+    thread = threading.Thread(target=self.accept)
+    thread.daemon = True
+    thread.start()
+
+  def accept(self):
+    while True:
+      try:
+        client, address = self.listener.accept()
+      except socket.error:
+        return
+      server = socket.create_connection((ADDR, self.target))
+      for source, destination, counted in ((client, server, True), (server, client, False)):
+        thread = threading.Thread(target=self.forward, args=(source, destination, counted))
+        thread.daemon = True
+        thread.start()
+
+  def forward(self, source, destination, counted):
+    try:
+      while True:
+        data = source.recv(65536)
+        if not data:
+          break
+        if counted:
+          with self.lock:
+            self.sent += len(data)
+        destination.sendall(data)
+    except socket.error:
+      pass
+    try:
+      destination.shutdown(socket.SHUT_WR)
+    except socket.error:
+      pass
+
+  def close(self):
+    self.listener.close()
+
+#
+# Updates a remote file through the proxy, returns whether
+# it succeeded and the bytes the client sent for it
+#
+def delta(proxy, work, remote, local, codec="gzip"):
+  proxy.sent = 0
+  code = CLIENT_CODE % { "remote": work.join(remote), "local": work.join(local), "addr": ADDR, "port": str(proxy.port),
+                         "timeout": TIMEOUT, "timeout_ack": TIMEOUT_ACK, "codec": codec }
+  return qfttest.spawn(code).wait() == 0, proxy.sent
+
+def main():
+
+  work = qfttest.WorkDir()
+  size = 4 << 20
+  old = qfttest.noise(size)
+  # Bytes changed near the start, some inserted in the middle, the end cut
+  new = old[:1000] + "changed" + old[1007:size // 2] + qfttest.noise(3000) + old[size // 2:size - 5000]
+  other = qfttest.noise(size)
+  work.write("new", new)
+  work.write("other", other)
+
+  server = qfttest.Server()
+  proxy = Proxy(server.port)
+
+  try:
+
+    # The signature holds an entry of each whole block
+    work.write("remote", old)
+    s = qfttest.connect(server.port)
+    s.sendall(v2_message(FILE_RCV_B, 0, v2_param(TAG_FILENAME, work.join("remote")) + v2_param(TAG_BLOCK, struct.pack(">I", 0))))
+    message_type, flags, params = v2_read(s)
+    if message_type == ACK_B:
+      message_type, flags, params = v2_read(s)
+    block = struct.unpack(">I", params[TAG_BLOCK])[0]
+    signature = qfttest.recv_exact(s, qfttest.v2_number(params, TAG_SIZE))
+    s.close()
+    check(params[TAG_RESULT] == 0 and 2048 <= block <= 65536 and len(signature) == size // block * SIGNATURE_ENTRY_LEN,
+          "signature of %d entries of blocks of %d bytes" % (len(signature) // SIGNATURE_ENTRY_LEN, block))
+
+    # The rebuilt file is checked against the SHA-256 digest of the new one
+    s = qfttest.connect(server.port)
+    s.sendall(v2_message(FILE_SND_B, V2_FLAG_CHUNKED, v2_param(TAG_PATH, work.join("remote")) + v2_param(TAG_SIZE, len(new)) +
+                                                      v2_param(TAG_BLOCK, struct.pack(">I", block)) + v2_param(TAG_HASH, 0)))
+    message_type, flags, params = v2_read(s)
+    s.close()
+    check(params[TAG_RESULT] == RESULT_INVALID_REQUEST and work.read("remote") == old, "delta without a digest refused")
+
+    for codec in ("gzip", "zstd", "lz4"):
+      work.write("remote", old)
+      done, sent = delta(proxy, work, "remote", "new", codec)
+      check(done and work.read("remote") == new, "file rebuilt from a delta with %s" % codec)
+      check(sent < size // 20, "delta of %d bytes for a file of %d" % (sent, size))
+      check(work.read("remote.bkp") == old, "previous content kept as backup")
+
+    done, sent = delta(proxy, work, "missing", "new")
+    check(done and work.read("missing") == new and sent >= len(new), "whole file sent when the server does not have it")
+
+    work.write("remote", old)
+    done, sent = delta(proxy, work, "remote", "other")
+    check(done and work.read("remote") == other and sent >= len(other), "whole file sent when nothing of the remote one is left")
+
+  finally:
+    proxy.close()
+    server.end()
+    work.remove()
+
+  qfttest.finish()
+
+if __name__ == "__main__":
+  main()
@@ -0,0 +1,65 @@
+#
+# Checks that File Receive content is packed and sent as the file is read,
+# over V1 with and without chunks and over V2, leaving no temporary file
+# next to the file served.
+#
+
+import os
+
+import qfttest
+from qfttest import quickftpy, check, logger, ADDR, TIMEOUT, TIMEOUT_ACK
+
+def main():
+
+  work = qfttest.WorkDir()
+  server = qfttest.Server()
+  os.mkdir(work.join("out"))
+
+  contents = { "one": "x", "odd": qfttest.text(1000003, 1),
+               "noise": qfttest.noise(2 << 20), "large": qfttest.text(6 << 20, 2) }
+  for name, content in contents.items():
+    work.write("out/" + name, content)
+
+  try:
+
+    for name, content in sorted(contents.items()):
+
+      remote = work.join("out", name)
+
+      # V1, the length in the response is the one of the content that follows
+      request = qfttest.v1_message("FILE_RCV", ":=filename:%s" % remote)
+      ack, header, var_part = qfttest.v1_exchange(server.port, request)
+      packed = qfttest.v1_param(var_part, "content")
+      check(qfttest.v1_param(var_part, "result").startswith("SUCCESS") and int(qfttest.v1_param(var_part, "length")) == len(packed) and
+            qfttest.v1_unpack(packed) == content, "V1 receive of %s" % name)
+
+      request = qfttest.v1_message("FILE_RCV", ":=chunked:1=filename:%s" % remote)
+      ack, header, var_part = qfttest.v1_exchange(server.port, request)
+      check(qfttest.v1_unpack(qfttest.v1_param(var_part, "content")) == content, "V1 chunked receive of %s" % name)
+
+      # V2, packed and uncompressed
+      local = work.join(name + ".gz")
+      result = quickftpy.clrecv(remote, local, ADDR, server.sport, TIMEOUT, TIMEOUT_ACK, logger)
+      check(result == 0 and work.read(local) == content, "V2 receive of %s" % name)
+
+      local = work.join(name + ".raw")
+      result = quickftpy.clrecv(remote, local, ADDR, server.sport, TIMEOUT, TIMEOUT_ACK, logger, 0, 1)
+      check(result == 0 and work.read(local) == content, "V2 raw receive of %s" % name)
+
+    request = qfttest.v1_message("FILE_RCV", ":=filename:%s" % work.join("out", "missing"))
+    ack, header, var_part = qfttest.v1_exchange(server.port, request)
+    check(qfttest.v1_param(var_part, "result").startswith("FILE_NOT_FOUND"), "V1 receive of a missing file")
+
+    result = quickftpy.clrecv(work.join("out", "missing"), work.join("missing"), ADDR, server.sport, TIMEOUT, TIMEOUT_ACK, logger)
+    check(result == -106 and not os.path.exists(work.join("missing")), "V2 receive of a missing file")
+
+    check(sorted(os.listdir(work.join("out"))) == sorted(contents), "no temporary file next to the files served")
+
+  finally:
+    server.end()
+    work.remove()
+
+  qfttest.finish()
+
+if __name__ == "__main__":
+  main()
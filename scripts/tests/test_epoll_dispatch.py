@@ -0,0 +1,71 @@
+#
+# Checks that the event loop of the server keeps serving requests while
+# many connections stay idle or go away, and under concurrent clients.
+#
+
+import socket
+import time
+
+import qfttest
+from qfttest import quickftpy, check, logger, ADDR, TIMEOUT, TIMEOUT_ACK
+
+CLIENT_CODE = r'''
+failed = 0
+for i in range(%(rounds)d):
+  result = quickftpy.clrecv(%(remote)r, %(local)r + str(i), %(addr)r, %(port)r, %(timeout)d, %(timeout_ack)d, logger)
+  if result != 0 or open(%(local)r + str(i), "rb").read() != open(%(remote)r, "rb").read():
+    failed += 1
+sys.exit(failed)
+'''
+
+def main():
+
+  work = qfttest.WorkDir()
+  server = qfttest.Server(max_conn=256, workers=4)
+  content = qfttest.text(200000)
+  remote = work.write("remote.txt", content)
+
+  try:
+
+    # Idle connections are only watched, they do not hold the workers
+    idle = []
+    for i in range(64):
+      s = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+      s.connect((ADDR, server.port))
+      idle.append(s)
+
+    start = time.time()
+    result = quickftpy.clrecv(remote, work.join("idle.txt"), ADDR, server.sport, TIMEOUT, TIMEOUT_ACK, logger)
+    check(result == 0 and work.read("idle.txt") == content, "transfer with 64 idle connections open")
+    check(time.time() - start < 5, "transfer is not held back by the idle connections")
+
+    # Connections closed without a request, or in the middle of one, are dropped
+    for s in idle[:32]:
+      s.close()
+    for s in idle[32:]:
+      s.send("FILE_RCV")
+      s.close()
+
+    result = quickftpy.clrecv(remote, work.join("closed.txt"), ADDR, server.sport, TIMEOUT, TIMEOUT_ACK, logger)
+    check(result == 0 and work.read("closed.txt") == content, "transfer after connections went away")
+
+    # Clients in other processes at once
+    clients = []
+    for i in range(8):
+      code = CLIENT_CODE % { "rounds": 4, "remote": remote, "local": work.join("c%d-" % i),
+                             "addr": ADDR, "port": server.sport, "timeout": TIMEOUT, "timeout_ack": TIMEOUT_ACK }
+      clients.append(qfttest.spawn(code))
+    failed = sum(c.wait() for c in clients)
+    check(failed == 0, "8 concurrent clients of 4 transfers each")
+
+    stats = server.settle(lambda stats: stats["pending_connections"] == 0 and stats["active_requests"] == 0)
+    check(stats["pending_connections"] == 0 and stats["active_requests"] == 0, "no connection left pending or active")
+
+  finally:
+    server.end()
+    work.remove()
+
+  qfttest.finish()
+
+if __name__ == "__main__":
+  main()
@@ -0,0 +1,153 @@
+#
+# Checks that File Send content is written to the target as it arrives,
+# over V1 and V2, whole, chunked or in small pieces, and that a broken
+# upload leaves neither a partial target nor a temporary file behind.
+#
+
+import os
+import socket
+import threading
+
+import qfttest
+from qfttest import quickftpy, check, logger, ADDR, TIMEOUT, TIMEOUT_ACK
+
+CLIENT_CODE = r'''
+result = quickftpy.clsend(%(remote)r, %(local)r, %(addr)r, %(port)r, %(timeout)d, %(timeout_ack)d, logger)
+sys.exit(0 if result == 0 else 1)
+'''
+
+#
+# Forwards connections to the server, answering V2 requests with the V1
+# ACK a server that only supports V1 would send
+#
+class V1Proxy:
+
+  def __init__(self, port):
+    self.target = port
+    self.listener = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    self.listener.bind((ADDR, 0))
+    self.listener.listen(16)
+    self.port = self.listener.getsockname()[1]
+    thread = threading.Thread(target=self.accept)
+    thread.daemon = True
+    thread.start()
+
+  def accept(self):
+    while True:
+      try:
+        client, address = self.listener.accept()
+      except socket.error:
+        return
+      header = qfttest.recv_exact(client, 32)
+      if header[10:14] != "V1.0":
+        client.sendall("QUIFT_MSG=V1.0=ACK_____=00000000")
+        client.close()
+        continue
+      server = socket.create_connection((ADDR, self.target))
+      server.sendall(header)
+      for source, destination in ((client, server), (server, client)):
+        thread = threading.Thread(target=self.forward, args=(source, destination))
+        thread.daemon = True
+        thread.start()
+
+  def forward(self, source, destination):
+    try:
+      while True:
+        data = source.recv(65536)
+        if not data:
+          break
+        destination.sendall(data)
+    except socket.error:
+      pass
+    try:
+      destination.shutdown(socket.SHUT_WR)
+    except socket.error:
+      pass
+
+  def close(self):
+    self.listener.close()
+
+#
+# Splits V1 content into the frames of a chunked content
+#
+def v1_frames(packed, size):
+  return "".join("%08x" % len(packed[i:i + size]) + packed[i:i + size] for i in range(0, len(packed), size)) + "00000000"
+
+def main():
+
+  work = qfttest.WorkDir()
+  server = qfttest.Server()
+  os.mkdir(work.join("in"))
+
+  contents = { "one": "x", "odd": qfttest.text(1000003, 1),
+               "noise": qfttest.noise(3 << 20), "large": qfttest.text(5 << 20, 2) }
+
+  try:
+
+    # V2, packed and raw
+    for name, content in sorted(contents.items()):
+      local = work.write(name, content)
+      for raw in (0, 1):
+        target = work.join("in", "%s-%d" % (name, raw))
+        result = quickftpy.clsend(target, local, ADDR, server.sport, TIMEOUT, TIMEOUT_ACK, logger, raw)
+        check(result == 0 and work.read(target) == content, "V2 send of %s, %s" % (name, ( raw ) and "raw" or "packed"))
+
+    # V1, whole and in pieces of a few bytes
+    for name in ("one", "odd"):
+      for piece in (0, 7):
+        target = work.join("in", "%s-v1-%d" % (name, piece))
+        packed = qfttest.v1_pack(contents[name])
+        request = qfttest.v1_message("FILE_SND", ":=path:%s=length:%d=size:%d=content:%s" % (target, len(packed), len(contents[name]), packed))
+        ack, header, var_part = qfttest.v1_exchange(server.port, request, piece)
+        check(qfttest.v1_param(var_part, "result").startswith("SUCCESS") and work.read(target) == contents[name],
+              "V1 send of %s%s" % (name, ( piece ) and " in pieces" or ""))
+
+    # V1 chunked, whole and in pieces of a few bytes
+    for name in ("one", "odd"):
+      for piece in (0, 7):
+        target = work.join("in", "%s-chunked-%d" % (name, piece))
+        request = qfttest.v1_message("FILE_SND", ":=path:%s=chunked:1=size:%d=content:" % (target, len(contents[name])))
+        ack, header, var_part = qfttest.v1_exchange(server.port, request + v1_frames(qfttest.v1_pack(contents[name]), 1000), piece)
+        check(qfttest.v1_param(var_part, "result").startswith("SUCCESS") and work.read(target) == contents[name],
+              "V1 chunked send of %s%s" % (name, ( piece ) and " in pieces" or ""))
+
+    # The client falls back to V1 and sends the content chunked, in a
+    # process of its own while this one forwards it
+    proxy = V1Proxy(server.port)
+    try:
+      for name, content in sorted(contents.items()):
+        target = work.join("in", "%s-client-v1" % name)
+        code = CLIENT_CODE % { "remote": target, "local": work.join(name), "addr": ADDR, "port": str(proxy.port),
+                               "timeout": TIMEOUT, "timeout_ack": TIMEOUT_ACK }
+        check(qfttest.spawn(code).wait() == 0 and work.read(target) == content, "client V1 send of %s" % name)
+    finally:
+      proxy.close()
+
+    # Content that does not inflate fails, the current target is kept
+    target = work.write("in/kept", "current content")
+    packed = qfttest.v1_pack(contents["odd"])
+    packed = packed[:1000] + "AAAAAAAAAAAAAAAA" + packed[1016:]
+    request = qfttest.v1_message("FILE_SND", ":=path:%s=length:%d=size:%d=content:%s" % (target, len(packed), len(contents["odd"]), packed))
+    ack, header, var_part = qfttest.v1_exchange(server.port, request)
+    check(not qfttest.v1_param(var_part, "result").startswith("SUCCESS"), "corrupted content is refused")
+    check(work.read("in/kept") == "current content", "target is kept after a corrupted upload")
+
+    # The frames left of a chunked content that fails are received before it is answered
+    request = qfttest.v1_message("FILE_SND", ":=path:%s=chunked:1=size:%d=content:" % (target, len(contents["odd"])))
+    ack, header, var_part = qfttest.v1_exchange(server.port, request + v1_frames(packed, 1000))
+    check(not qfttest.v1_param(var_part, "result").startswith("SUCCESS"), "corrupted chunked content is refused")
+    check(work.read("in/kept") == "current content", "target is kept after a corrupted chunked upload")
+
+    expected = sorted(["%s-%d" % (name, raw) for name in contents for raw in (0, 1)] +
+                      ["%s-%s-%d" % (name, kind, piece) for name in ("one", "odd") for kind in ("v1", "chunked") for piece in (0, 7)] +
+                      ["%s-client-v1" % name for name in contents] + ["kept"])
+    check(sorted(os.listdir(work.join("in"))) == expected, "no temporary file left in the target directory")
+
+  finally:
+    server.end()
+    work.remove()
+
+  qfttest.finish()
+
+if __name__ == "__main__":
+  main()
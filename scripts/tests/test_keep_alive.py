@@ -0,0 +1,93 @@
+#
+# Checks that a connection kept open serves many requests, that it is
+# closed once idle for the keep alive of the server, the client opening
+# it again, and that a server with keep alive disabled closes each one.
+#
+
+import time
+
+import qfttest
+from qfttest import quickftpy, check, logger, v2_message, v2_param, v2_read, ADDR, TIMEOUT, TIMEOUT_ACK
+from qfttest import FILE_RCV_B, ACK_B, V2_FLAG_RAW, V2_FLAG_KEEP_ALIVE, TAG_FILENAME, TAG_RESULT, TAG_SIZE
+
+#
+# Receives a file uncompressed over a raw connection asking for it to be
+# kept open, returns the result and whether the server agreed to it
+#
+def receive(s, path):
+  s.sendall(v2_message(FILE_RCV_B, V2_FLAG_RAW | V2_FLAG_KEEP_ALIVE, v2_param(TAG_FILENAME, path)))
+  message_type, flags, params = v2_read(s)
+  if message_type == ACK_B:
+    message_type, flags, params = v2_read(s)
+  if params[TAG_RESULT] == 0:
+    qfttest.recv_exact(s, qfttest.v2_number(params, TAG_SIZE))
+  return params[TAG_RESULT], ( flags & V2_FLAG_KEEP_ALIVE ) != 0
+
+#
+# Performs a round of operations over a connection of the module
+#
+def operations(server, work, connection, rounds):
+  failed = 0
+  for i in range(rounds):
+    sent = work.join("sent-%d" % i)
+    if quickftpy.clsend(sent, work.join("local"), ADDR, server.sport, TIMEOUT, TIMEOUT_ACK, logger, 0, "gzip", connection) != 0:
+      failed += 1
+    if quickftpy.clrecv(sent, work.join("received-%d" % i), ADDR, server.sport, TIMEOUT, TIMEOUT_ACK, logger, 0, 0, "gzip", connection) != 0:
+      failed += 1
+    if work.read("received-%d" % i) != work.read("local"):
+      failed += 1
+    if quickftpy.cldel(sent, ADDR, server.sport, TIMEOUT, TIMEOUT_ACK, logger, connection) != 0:
+      failed += 1
+  return failed
+
+def main():
+
+  work = qfttest.WorkDir()
+  work.write("local", qfttest.text(200000))
+
+  try:
+
+    server = qfttest.Server(keep_alive=2)
+    try:
+
+      connection = quickftpy.clconnect(ADDR, server.sport, TIMEOUT, TIMEOUT_ACK, logger)
+      check(connection is not None, "connection opened")
+      check(operations(server, work, connection, 10) == 0, "30 operations over a single connection")
+      check(server.stats()["kept_alive"] >= 29, "server kept the connection open between them")
+
+      # Idle past the keep alive, the server closed it and the client opens it again
+      time.sleep(4)
+      check(operations(server, work, connection, 1) == 0, "operations once the server closed the idle connection")
+      check(quickftpy.clclose(connection), "connection closed")
+
+      s = qfttest.connect(server.port)
+      answers = [receive(s, work.join("local")) for i in range(5)]
+      check(answers == [(0, True)] * 5, "5 raw requests over a single connection")
+      check(qfttest.closed(s, 6), "idle raw connection is closed after the keep alive")
+      s.close()
+
+    finally:
+      server.end()
+
+    server = qfttest.Server(keep_alive=-1)
+    try:
+
+      s = qfttest.connect(server.port)
+      check(receive(s, work.join("local")) == (0, False) and qfttest.closed(s), "server without keep alive closes the connection")
+      s.close()
+
+      connection = quickftpy.clconnect(ADDR, server.sport, TIMEOUT, TIMEOUT_ACK, logger)
+      check(operations(server, work, connection, 3) == 0, "operations over a connection the server does not keep")
+      check(server.stats()["kept_alive"] == 0, "nothing kept alive")
+      quickftpy.clclose(connection)
+
+    finally:
+      server.end()
+
+  finally:
+    work.remove()
+
+  qfttest.finish()
+
+if __name__ == "__main__":
+  main()
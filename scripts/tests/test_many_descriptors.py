@@ -0,0 +1,92 @@
+#
+# Checks sockets whose descriptors are above FD_SETSIZE, which select could
+# not wait on: a server holding more than 1024 connections still serves
+# the ones opened last, and a client with as many files open still sends
+# and receives.
+#
+
+import os
+import resource
+import time
+
+import qfttest
+from qfttest import quickftpy, check, logger, v2_message, v2_param, v2_read, ADDR, TIMEOUT, TIMEOUT_ACK
+from qfttest import FILE_RCV_B, ACK_B, V2_FLAG_RAW, TAG_FILENAME, TAG_RESULT, TAG_SIZE
+
+FD_SETSIZE = 1024
+HELD = 1200
+
+def receive_raw(s, path):
+  s.sendall(v2_message(FILE_RCV_B, V2_FLAG_RAW, v2_param(TAG_FILENAME, path)))
+  message_type, flags, params = v2_read(s)
+  if message_type == ACK_B:
+    message_type, flags, params = v2_read(s)
+  if params[TAG_RESULT] != 0:
+    return None
+  return qfttest.recv_exact(s, qfttest.v2_number(params, TAG_SIZE))
+
+#
+# Highest descriptor a process has open
+#
+def highest_descriptor(pid):
+  return max(int(fd) for fd in os.listdir("/proc/%d/fd" % pid))
+
+def main():
+
+  soft, hard = resource.getrlimit(resource.RLIMIT_NOFILE)
+  if hard != resource.RLIM_INFINITY and hard < 3 * HELD:
+    print "  skipped, %d descriptors at most" % hard
+    return
+  resource.setrlimit(resource.RLIMIT_NOFILE, (max(soft, 3 * HELD), hard))
+
+  work = qfttest.WorkDir()
+  content = qfttest.text(2 << 20)
+  remote = work.write("remote", content)
+
+  server = qfttest.Server(max_conn=2048, workers=4)
+  held = []
+  files = []
+
+  try:
+
+    # The server gets a descriptor above FD_SETSIZE for the connections opened last
+    for i in range(HELD):
+      held.append(qfttest.connect(server.port))
+    for i in range(50):
+      if highest_descriptor(server.process.pid) > FD_SETSIZE:
+        break
+      time.sleep(0.1)
+    check(held[-1].fileno() > FD_SETSIZE and highest_descriptor(server.process.pid) > FD_SETSIZE, "%d connections held open" % len(held))
+
+    check(all(receive_raw(s, remote) == content for s in held[-5:]), "server serves the connections opened last")
+    check(receive_raw(held[0], remote) == content, "and the first ones")
+
+    # The client gets one above FD_SETSIZE as well
+    while len(files) < HELD:
+      files.append(os.open(os.devnull, os.O_RDONLY))
+    for raw, codec in ((0, "gzip"), (1, "gzip"), (0, "lz4")):
+      result = quickftpy.clrecv(remote, work.join("received"), ADDR, server.sport, TIMEOUT, TIMEOUT_ACK, logger, 0, raw, codec)
+      check(result == 0 and work.read("received") == content, "client receives with %d descriptors open (%s %s)" % (len(held) + len(files), ( "packed", "raw" )[raw], codec))
+      result = quickftpy.clsend(work.join("sent"), remote, ADDR, server.sport, TIMEOUT, TIMEOUT_ACK, logger, raw, codec)
+      check(result == 0 and work.read("sent") == content, "client sends with %d descriptors open (%s %s)" % (len(held) + len(files), ( "packed", "raw" )[raw], codec))
+
+    connection = quickftpy.clconnect(ADDR, server.sport, TIMEOUT, TIMEOUT_ACK, logger)
+    codes = quickftpy.clpipeline([("recv", remote, work.join("pipelined-%d" % i)) for i in range(6)], ADDR, server.sport, TIMEOUT, TIMEOUT_ACK, logger, connection)
+    check(codes == [0] * 6 and all(work.read("pipelined-%d" % i) == content for i in range(6)), "pipeline over a connection above FD_SETSIZE")
+    quickftpy.clclose(connection)
+
+    # The connections served were closed, as they did not ask to be kept open
+    check(len(os.listdir("/proc/%d/fd" % server.process.pid)) >= HELD - 6, "idle connections still held by the server")
+
+  finally:
+    for s in held:
+      s.close()
+    for fd in files:
+      os.close(fd)
+    server.end()
+    work.remove()
+
+  qfttest.finish()
+
+if __name__ == "__main__":
+  main()
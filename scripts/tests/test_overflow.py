@@ -0,0 +1,93 @@
+#
+# Checks each policy of the server once every request slot is taken, and
+# that the slots are given back once the requests holding them end.
+#
+
+import socket
+import time
+
+import qfttest
+from qfttest import quickftpy, check, logger, ADDR
+
+# Every slot, and a few connections more
+HELD = 520
+
+OVERFLOW_QUEUE = 0
+OVERFLOW_REJECT = 1
+OVERFLOW_CLOSE = 2
+
+RESULT_CONNECTION_ERROR = -100
+RESULT_SERVER_BUSY = -116
+
+CLIENT_CODE = r'''
+sys.exit(-quickftpy.clrecv(%(remote)r, %(local)r, %(addr)r, %(port)r, 10000, 10000, logger))
+'''
+
+#
+# Opens connections that start a request and never complete it
+#
+def hold(server):
+  held = []
+  for i in range(HELD):
+    s = socket.create_connection((ADDR, server.port))
+    s.send("Q")
+    held.append(s)
+  time.sleep(1)
+  return held
+
+def release(held):
+  for s in held:
+    s.close()
+  time.sleep(1)
+
+def main():
+
+  work = qfttest.WorkDir()
+  remote = work.write("remote.txt", qfttest.text(10000))
+
+  for policy, name, expected, counter in ((OVERFLOW_REJECT, "reject", RESULT_SERVER_BUSY, "overflow_rejected"),
+                                          (OVERFLOW_CLOSE, "close", RESULT_CONNECTION_ERROR, "overflow_closed")):
+
+    server = qfttest.Server(max_conn=600, overflow=policy)
+    try:
+
+      held = hold(server)
+      start = time.time()
+      result = quickftpy.clrecv(remote, work.join(name + ".txt"), ADDR, server.sport, 5000, 5000, logger)
+      check(result == expected and time.time() - start < 4, "%s policy answers %d at once with every slot taken" % (name, result))
+
+      stats = server.stats()
+      check(stats[counter] >= 1, "%s policy is counted" % name)
+
+      release(held)
+      result = quickftpy.clrecv(remote, work.join(name + ".txt"), ADDR, server.sport, 5000, 5000, logger)
+      check(result == 0, "slots are given back after the %s policy" % name)
+
+    finally:
+      server.end()
+
+  # A queued request is served as soon as a slot is free
+  server = qfttest.Server(max_conn=600, overflow=OVERFLOW_QUEUE)
+  try:
+
+    held = hold(server)
+    code = CLIENT_CODE % { "remote": remote, "local": work.join("queue.txt"), "addr": ADDR, "port": server.sport }
+    client = qfttest.spawn(code)
+    time.sleep(1)
+    check(client.poll() is None, "queue policy holds the request while every slot is taken")
+
+    stats = server.stats()
+    check(stats["overflow_queued"] >= 1 and stats["pending_connections"] >= 1, "queued connection is counted")
+
+    for s in held:
+      s.close()
+    check(client.wait() == 0 and work.read("queue.txt") == work.read("remote.txt"), "queued request is served once slots are free")
+
+  finally:
+    server.end()
+    work.remove()
+
+  qfttest.finish()
+
+if __name__ == "__main__":
+  main()
@@ -0,0 +1,60 @@
+#
+# Checks that large files are deflated by the shared compression pool,
+# which the server only starts for files large enough, and that the
+# content it makes inflates back to the file over V1 and V2.
+#
+
+import os
+
+import qfttest
+from qfttest import quickftpy, check, logger, ADDR, TIMEOUT, TIMEOUT_ACK
+
+CLIENT_CODE = r'''
+quickftpy.setcompress(-1, 0, 0, 0, None, %(threads)d)
+sys.exit(-quickftpy.clsend(%(remote)r, %(local)r, %(addr)r, %(port)r, %(timeout)d, %(timeout_ack)d, logger))
+'''
+
+def threads(server):
+  return len(os.listdir("/proc/%d/task" % server.process.pid))
+
+def main():
+
+  work = qfttest.WorkDir()
+  small = qfttest.text(100000, 1)
+  large = qfttest.text(24 << 20, 2)
+  work.write("small", small)
+  work.write("large", large)
+
+  for pool in (4, 1):
+
+    server = qfttest.Server(setup="quickftpy.setcompress(-1, 0, 0, 0, None, %d)" % pool)
+    try:
+
+      started = threads(server)
+      result = quickftpy.clrecv(work.join("small"), work.join("small.%d" % pool), ADDR, server.sport, TIMEOUT, TIMEOUT_ACK, logger)
+      check(result == 0 and work.read("small.%d" % pool) == small and threads(server) == started,
+            "small file is deflated on the worker (pool of %d)" % pool)
+
+      result = quickftpy.clrecv(work.join("large"), work.join("large.%d" % pool), ADDR, server.sport, TIMEOUT, TIMEOUT_ACK, logger)
+      check(result == 0 and work.read("large.%d" % pool) == large, "V2 receive of a large file (pool of %d)" % pool)
+      if pool > 1:
+        check(threads(server) == started + pool, "pool of %d threads started by the large file" % pool)
+      else:
+        check(threads(server) == started, "no pool started for a single thread")
+
+      request = qfttest.v1_message("FILE_RCV", ":=filename:%s" % work.join("large"))
+      ack, header, var_part = qfttest.v1_exchange(server.port, request)
+      check(qfttest.v1_unpack(qfttest.v1_param(var_part, "content")) == large, "V1 receive of a large file (pool of %d)" % pool)
+
+      code = CLIENT_CODE % { "threads": pool, "remote": work.join("sent.%d" % pool), "local": work.join("large"), "addr": ADDR,
+                             "port": server.sport, "timeout": TIMEOUT, "timeout_ack": TIMEOUT_ACK }
+      check(qfttest.spawn(code).wait() == 0 and work.read("sent.%d" % pool) == large, "client deflates a large file (pool of %d)" % pool)
+
+    finally:
+      server.end()
+
+  work.remove()
+  qfttest.finish()
+
+if __name__ == "__main__":
+  main()
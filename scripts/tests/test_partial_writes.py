@@ -0,0 +1,119 @@
+#
+# Checks that messages far larger than the socket buffers reach a reader
+# that takes them slowly through a small receive buffer, whole and in
+# order, the server writing them in as many pieces as the socket takes:
+# V1 responses, V2 responses served from the cache along with their
+# parameters, uncompressed content and pipelined answers.
+#
+
+import os
+import socket
+import time
+
+import qfttest
+from qfttest import check, v2_message, v2_param, v2_read, v2_read_pipelined
+from qfttest import FILE_RCV_B, ACK_B, V2_FLAG_RAW, V2_FLAG_KEEP_ALIVE, V2_FLAG_PIPELINED, TAG_FILENAME, TAG_RESULT, TAG_SIZE
+
+#
+# Connection that receives in small pieces, pausing before each
+# of them, through a receive buffer of a few kilobytes
+#
+class SlowReader:
+
+  def __init__(self, port, piece=16384, pause=0.0002):
+    self.s = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    self.s.setsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF, 16384)
+    self.s.settimeout(qfttest.TIMEOUT / 1000)
+    self.s.connect((qfttest.ADDR, port))
+    self.piece = piece
+    self.pause = pause
+    self.reads = 0
+
+  def sendall(self, data):
+    self.s.sendall(data)
+
+  def recv(self, length):
+    time.sleep(self.pause)
+    self.reads += 1
+    return self.s.recv(min(length, self.piece))
+
+  def close(self):
+    self.s.close()
+
+#
+# Receives a file packed with gzip over a slow connection
+#
+def receive_packed(server, path):
+  s = SlowReader(server.port)
+  try:
+    s.sendall(v2_message(FILE_RCV_B, 0, v2_param(TAG_FILENAME, path)))
+    message_type, flags, params = v2_read(s)
+    if message_type == ACK_B:
+      message_type, flags, params = v2_read(s)
+    if params[TAG_RESULT] != 0:
+      return None
+    if flags & V2_FLAG_RAW:
+      return qfttest.recv_exact(s, qfttest.v2_number(params, TAG_SIZE))
+    return qfttest.gunzip(qfttest.v2_frames(s))
+  finally:
+    s.close()
+
+def main():
+
+  work = qfttest.WorkDir()
+  # Content that compresses to about half of it, neither stored nor tiny
+  content = os.urandom(2 << 20).encode("hex")
+  noise = qfttest.noise(6 << 20)
+  path = work.write("half", content)
+  raw_path = work.write("noise", noise)
+
+  server = qfttest.Server(setup="quickftpy.setcache(256 << 20)")
+
+  try:
+
+    # A V1 response is a single message of the whole content
+    s = SlowReader(server.port)
+    try:
+      s.sendall(qfttest.v1_message("FILE_RCV", ":=filename:%s" % raw_path))
+      ack = qfttest.recv_exact(s, 32)
+      header = qfttest.recv_exact(s, 32)
+      var_part = qfttest.recv_exact(s, int(header[24:32], 16))
+      check(len(var_part) > 6 << 20 and qfttest.v1_unpack(qfttest.v1_param(var_part, "content")) == noise,
+            "V1 message of %d MB read slowly" % ( len(var_part) >> 20 ))
+    finally:
+      s.close()
+
+    # The first receive fills the cache after the V1 one, the next ones send the entry along with the parameters
+    check(receive_packed(server, path) == content, "packed receive read slowly")
+    for i in range(50):
+      if server.stats()["cache_entries"] >= 2:
+        break
+      time.sleep(0.1)
+    hits = server.stats()["cache_hits"]
+    check(all(receive_packed(server, path) == content for i in range(3)) and server.stats()["cache_hits"] == hits + 3,
+          "3 cached responses read slowly")
+
+    check(receive_packed(server, raw_path) == noise, "uncompressed content of 6 MB read slowly")
+
+    # Pipelined answers share the connection, each whole before the next one
+    s = SlowReader(server.port)
+    try:
+      for request_id, name in enumerate([path, raw_path, path, raw_path], 1):
+        s.sendall(v2_message(FILE_RCV_B, V2_FLAG_RAW | V2_FLAG_KEEP_ALIVE | V2_FLAG_PIPELINED, v2_param(TAG_FILENAME, name), request_id))
+      answers = {}
+      while len(answers) < 4:
+        request_id, message_type, flags, params = v2_read_pipelined(s)
+        answers[request_id] = qfttest.recv_exact(s, qfttest.v2_number(params, TAG_SIZE))
+      check(answers == { 1: content, 2: noise, 3: content, 4: noise }, "4 pipelined answers read slowly")
+      check(s.reads > 1000, "%d reads of at most 16 KB" % s.reads)
+    finally:
+      s.close()
+
+  finally:
+    server.end()
+    work.remove()
+
+  qfttest.finish()
+
+if __name__ == "__main__":
+  main()
@@ -0,0 +1,70 @@
+#
+# Checks pipelined requests, through clpipeline and over a raw connection:
+# answers matched to their request IDs, results kept per operation, and a
+# File Send never overtaking a File Receive of the same file before it.
+#
+
+import qfttest
+from qfttest import quickftpy, check, logger, v2_message, v2_param, ADDR, TIMEOUT, TIMEOUT_ACK
+from qfttest import FILE_RCV_B, V2_FLAG_RAW, V2_FLAG_KEEP_ALIVE, V2_FLAG_PIPELINED, TAG_FILENAME, TAG_RESULT, TAG_SIZE
+
+RESULT_FILE_NOT_FOUND = -106
+
+def main():
+
+  work = qfttest.WorkDir()
+  contents = [qfttest.text(50000 * (i + 1), i) for i in range(8)]
+  for i, content in enumerate(contents):
+    work.write("remote-%d" % i, content)
+  work.write("update", qfttest.text(70000, 99))
+
+  server = qfttest.Server()
+
+  try:
+
+    ops = [("recv", work.join("remote-%d" % i), work.join("local-%d" % i)) for i in range(8)]
+    ops += [("recv", work.join("missing"), work.join("local-missing")),
+            ("recv", work.join("remote-0"), work.join("before-update")),
+            ("send", work.join("remote-0"), work.join("update")),
+            ("recv", work.join("remote-1"), work.join("local-raw"), 1, "lz4"),
+            ("del", work.join("remote-2"))]
+
+    codes = quickftpy.clpipeline(ops, ADDR, server.sport, TIMEOUT, TIMEOUT_ACK, logger)
+
+    check(codes[:8] == [0] * 8 and all(work.read("local-%d" % i) == contents[i] for i in range(8)), "8 pipelined receives")
+    check(codes[8] == RESULT_FILE_NOT_FOUND, "failed operation keeps its own result")
+    check(codes[9] == 0 and work.read("before-update") == contents[0], "receive before a send of the same file gets the old content")
+    check(codes[10] == 0 and work.read("remote-0") == work.read("update"), "send after it")
+    check(codes[11] == 0 and work.read("local-raw") == contents[1], "raw receive with another codec")
+    check(codes[12] == 0 and work.read("remote-2") is None, "delete")
+    check(server.stats()["pipelined"] >= 8, "server counted the pipelined requests")
+
+    # Raw requests sent at once, the answers carrying their request IDs
+    s = qfttest.connect(server.port)
+    try:
+      names = ["remote-%d" % i for i in (1, 3, 4, 5, 6, 7)] + ["missing"]
+      for request_id, name in enumerate(names, 100):
+        s.sendall(v2_message(FILE_RCV_B, V2_FLAG_RAW | V2_FLAG_KEEP_ALIVE | V2_FLAG_PIPELINED, v2_param(TAG_FILENAME, work.join(name)), request_id))
+
+      answers = {}
+      while len(answers) < len(names):
+        request_id, message_type, flags, params = qfttest.v2_read_pipelined(s)
+        content = None
+        if params[TAG_RESULT] == 0:
+          content = qfttest.recv_exact(s, qfttest.v2_number(params, TAG_SIZE))
+        answers[request_id] = (params[TAG_RESULT], content)
+
+      check(sorted(answers) == range(100, 100 + len(names)), "every request ID answered once")
+      check(all(answers[100 + i] == (0, work.read(name)) for i, name in enumerate(names[:-1])), "answers match their requests")
+      check(answers[100 + len(names) - 1][0] == RESULT_FILE_NOT_FOUND, "failed request answered with its ID")
+    finally:
+      s.close()
+
+  finally:
+    server.end()
+    work.remove()
+
+  qfttest.finish()
+
+if __name__ == "__main__":
+  main()
@@ -0,0 +1,138 @@
+#
+# Checks resumable transfers: the partial file the server keeps when an
+# upload is cut, the offset its ACK resumes from, a changed file starting
+# again from 0, and downloads resumed only when the prefix hash matches.
+#
+
+import os
+import struct
+import time
+import zlib
+
+import qfttest
+from qfttest import quickftpy, check, logger, v2_message, v2_param, v2_read, ADDR, TIMEOUT, TIMEOUT_ACK
+from qfttest import FILE_SND_B, FILE_RCV_B, ACK_B, V2_FLAG_RAW, TAG_PATH, TAG_FILENAME, TAG_TRANSFER, TAG_HASH, TAG_SIZE, TAG_OFFSET, TAG_RESULT
+
+#
+# Hash of a content as the module computes it, CRC-32 then Adler-32
+#
+def content_hash(content):
+  return ( ( zlib.crc32(content) & 0xFFFFFFFF ) << 32 ) | ( zlib.adler32(content) & 0xFFFFFFFF )
+
+#
+# Starts a raw resumable File Send and returns the connection
+# along with the offset the ACK asks the content from
+#
+def start_send(server, path, transfer, content):
+  s = qfttest.connect(server.port)
+  s.sendall(v2_message(FILE_SND_B, V2_FLAG_RAW, v2_param(TAG_PATH, path) + v2_param(TAG_TRANSFER, transfer) +
+                                                v2_param(TAG_HASH, struct.pack(">Q", content_hash(content))) + v2_param(TAG_SIZE, len(content))))
+  message_type, flags, params = v2_read(s)
+  if message_type != ACK_B:
+    s.close()
+    return None, params.get(TAG_RESULT)
+  return s, qfttest.v2_number(params, TAG_OFFSET)
+
+#
+# Receives a file uncompressed from an offset, with the hash of what
+# comes before it, returns the offset the server answers from and the
+# content that follows
+#
+def receive_from(server, path, offset, prefix_hash):
+  s = qfttest.connect(server.port)
+  try:
+    s.sendall(v2_message(FILE_RCV_B, V2_FLAG_RAW, v2_param(TAG_FILENAME, path) + v2_param(TAG_OFFSET, offset) + v2_param(TAG_HASH, struct.pack(">Q", prefix_hash))))
+    message_type, flags, params = v2_read(s)
+    if message_type == ACK_B:
+      message_type, flags, params = v2_read(s)
+    if params[TAG_RESULT] != 0:
+      return None, None
+    return qfttest.v2_number(params, TAG_OFFSET), qfttest.recv_exact(s, qfttest.v2_number(params, TAG_SIZE))
+  finally:
+    s.close()
+
+def part_of(path, transfer, content):
+  return "%s.%s-%016x.part" % (path, transfer, content_hash(content))
+
+def main():
+
+  work = qfttest.WorkDir()
+  content = qfttest.text(3 << 20)
+  changed = qfttest.text(3 << 20, 1)
+  local = work.write("local", content)
+  target = work.join("target")
+
+  server = qfttest.Server()
+
+  try:
+
+    # An upload cut halfway leaves its partial file on the server
+    s, offset = start_send(server, target, "t1", content)
+    check(s is not None and offset == 0, "new resumable upload starts at 0")
+    s.sendall(content[:1 << 20])
+    time.sleep(0.5)
+    s.close()
+
+    part = part_of(target, "t1", content)
+    for i in range(50):
+      if os.path.exists(part) and os.path.getsize(part) == 1 << 20:
+        break
+      time.sleep(0.1)
+    check(os.path.exists(part) and os.path.getsize(part) == 1 << 20 and not os.path.exists(target), "partial file kept after the upload was cut")
+
+    # The next attempt resumes from it
+    s, offset = start_send(server, target, "t1", content)
+    check(offset == 1 << 20, "ACK resumes from the partial file (%r)" % offset)
+    if s is not None:
+      s.sendall(content[offset:])
+      message_type, flags, params = v2_read(s)
+      s.close()
+      check(params[TAG_RESULT] == 0 and work.read("target") == content, "resumed upload completes the file")
+    check(not os.path.exists(part), "partial file replaced the target")
+
+    # Another content under the same ID does not reuse its partial file
+    s, offset = start_send(server, target, "t2", content)
+    s.sendall(content[:1 << 19])
+    time.sleep(0.5)
+    s.close()
+    time.sleep(0.5)
+    s, offset = start_send(server, target, "t2", changed)
+    check(offset == 0, "changed file starts again from 0")
+    s.close()
+
+    # The module resumes from the partial file a cut upload left
+    check(os.path.exists(part_of(target, "t2", content)), "partial file of the first content still there")
+    result = quickftpy.clsend(target, local, ADDR, server.sport, TIMEOUT, TIMEOUT_ACK, logger, 0, "gzip", None, "t2")
+    check(result == 0 and work.read("target") == content and not os.path.exists(part_of(target, "t2", content)), "clsend resumes the cut upload")
+
+    # Downloads resume only when the prefix the client has is the one of the file
+    offset, rest = receive_from(server, target, 1000, content_hash(content[:1000]))
+    check(offset == 1000 and rest == content[1000:], "download resumed from the offset")
+    offset, rest = receive_from(server, target, 1000, content_hash(changed[:1000]))
+    check(offset == 0 and rest == content, "prefix hash mismatch starts again from 0")
+    offset, rest = receive_from(server, target, len(content) + 1, content_hash(content))
+    check(offset == 0 and rest == content, "offset past the end starts again from 0")
+
+    received = work.join("received")
+    work.write("received.r1.part", content[:777777])
+    result = quickftpy.clrecv(target, received, ADDR, server.sport, TIMEOUT, TIMEOUT_ACK, logger, 0, 0, "gzip", None, "r1")
+    check(result == 0 and work.read("received") == content and work.read("received.r1.part") is None, "clrecv completes its partial file")
+
+    work.write("received.r2.part", changed[:777777])
+    result = quickftpy.clrecv(target, received, ADDR, server.sport, TIMEOUT, TIMEOUT_ACK, logger, 0, 1, "gzip", None, "r2")
+    check(result == 0 and work.read("received") == content, "clrecv with a stale partial file gets the whole file again")
+
+    try:
+      result = quickftpy.clsend(work.join("bad"), local, ADDR, server.sport, TIMEOUT, TIMEOUT_ACK, logger, 0, "gzip", None, "../bad")
+    except (TypeError, ValueError):
+      result = -1
+    check(result != 0 and work.read("bad") is None, "transfer ID outside letters, digits, '-' and '_' refused")
+
+  finally:
+    server.end()
+    work.remove()
+
+  qfttest.finish()
+
+if __name__ == "__main__":
+  main()
@@ -0,0 +1,68 @@
+#
+# Checks that a session shares at most pool_size connections between the
+# threads using it, reuses them between calls, opens again the ones the
+# server closed meanwhile, and refuses calls once closed.
+#
+
+import time
+import threading
+
+import qfttest
+from qfttest import quickftpy, check, logger, ADDR, TIMEOUT, TIMEOUT_ACK
+
+def main():
+
+  work = qfttest.WorkDir()
+  content = qfttest.text(300000)
+  remote = work.write("remote.txt", content)
+  server = qfttest.Server(keep_alive=2)
+
+  try:
+
+    session = quickftpy.Session(ADDR, server.sport, 3, TIMEOUT, TIMEOUT_ACK, logger)
+
+    for i in range(10):
+      session.clrecv(remote, work.join("sequential.txt"))
+    stats = session.stats()
+    check(stats["connects"] == 1 and stats["operations"] == 10, "sequential calls share a single connection")
+
+    # Threads of the caller run the calls at once
+    failures = []
+    def transfers(index):
+      for i in range(5):
+        local = work.join("t%d-%d.txt" % (index, i))
+        if session.clrecv(remote, local) != 0 or work.read("t%d-%d.txt" % (index, i)) != content:
+          failures.append(local)
+    threads = [threading.Thread(target=transfers, args=(i,)) for i in range(12)]
+    for t in threads:
+      t.start()
+    for t in threads:
+      t.join()
+
+    stats = session.stats()
+    check(not failures, "12 threads of 5 transfers each")
+    check(stats["connects"] <= 3 and stats["open"] <= 3, "no more than 3 connections opened (%d)" % stats["connects"])
+    check(stats["operations"] == 70 and stats["waits"] > 0, "calls waited for a connection of the pool")
+
+    # The server closes idle connections after its keep alive
+    time.sleep(4)
+    check(session.clsend(work.join("after-idle.txt"), remote) == 0 and work.read("after-idle.txt") == content,
+          "call after the server closed the idle connections")
+    check(session.stats()["reconnects"] + session.stats()["health_failures"] >= 1, "closed connection was noticed and opened again")
+
+    session.close()
+    check(session.stats()["closed"], "session closed")
+    try:
+      refused = session.clrecv(remote, work.join("closed.txt")) != 0
+    except Exception:
+      refused = True
+    check(refused, "calls are refused once the session is closed")
+
+  finally:
+    server.end()
+    work.remove()
+
+  qfttest.finish()
+
+if __name__ == "__main__":
+  main()
@@ -0,0 +1,94 @@
+#
+# Checks that concurrent File Receive requests for the same content share
+# a single compression, each getting the whole file, that another codec or
+# another version of the file leads a flight of its own, and that a file
+# sent uncompressed is still served to every request.
+#
+
+import time
+
+import qfttest
+from qfttest import check, v2_message, v2_param, v2_read
+from qfttest import FILE_RCV_B, ACK_B, V2_FLAG_RAW, TAG_FILENAME, TAG_CODEC, TAG_RESULT, TAG_SIZE
+
+CODECS = { "gzip": 0, "zstd": 1 }
+
+#
+# Sends File Receive requests for a file over as many connections at
+# once, then reads every answer, returning the gzip content of each, the
+# uncompressed content when the server sent it that way, or None
+#
+def receive_at_once(server, path, codecs):
+  connections = []
+  for codec in codecs:
+    s = qfttest.connect(server.port)
+    s.sendall(v2_message(FILE_RCV_B, 0, v2_param(TAG_FILENAME, path) + v2_param(TAG_CODEC, chr(CODECS[codec]))))
+    connections.append(s)
+
+  contents = []
+  for s in connections:
+    try:
+      message_type, flags, params = v2_read(s)
+      if message_type == ACK_B:
+        message_type, flags, params = v2_read(s)
+      if params[TAG_RESULT] != 0:
+        contents.append(None)
+      elif flags & V2_FLAG_RAW:
+        contents.append(qfttest.recv_exact(s, qfttest.v2_number(params, TAG_SIZE)))
+      else:
+        frames = qfttest.v2_frames(s)
+        contents.append(qfttest.gunzip(frames) if ord(params.get(TAG_CODEC, "\0")) == 0 else frames)
+    finally:
+      s.close()
+  return contents
+
+def flights(server, before):
+  after = server.stats()
+  return dict((key[7:], after[key] - before[key]) for key in after if key.startswith("flight_"))
+
+def main():
+
+  work = qfttest.WorkDir()
+  content = qfttest.text(48 << 20)
+  changed = qfttest.text(48 << 20, 1)
+  noise = qfttest.noise(8 << 20)
+  hot = work.write("hot", content)
+  cold = work.write("noise", noise)
+
+  # The best compression gives the followers time to join the leader
+  server = qfttest.Server(max_conn=32, workers=8, setup="quickftpy.setcompress(3)")
+
+  try:
+
+    before = server.stats()
+    contents = receive_at_once(server, hot, ["gzip"] * 8)
+    counted = flights(server, before)
+    check(contents == [content] * 8, "8 concurrent receives of the same file")
+    check(counted["leaders"] + counted["fallbacks"] < 8 and counted["followers"] >= 1,
+          "requests followed a single compression (%d leaders, %d followers)" % (counted["leaders"], counted["followers"]))
+
+    before = server.stats()
+    contents = receive_at_once(server, hot, ["gzip", "zstd"] * 3)
+    counted = flights(server, before)
+    check(contents[0::2] == [content] * 3 and contents[1] and len(set(contents[1::2])) == 1, "concurrent receives with two codecs")
+    check(counted["leaders"] >= 2, "each codec leads a flight of its own")
+
+    # The followers of a file sent uncompressed serve it themselves
+    contents = receive_at_once(server, cold, ["gzip"] * 6)
+    check(contents == [noise] * 6, "concurrent receives of a file sent uncompressed")
+
+    # Another version of the file does not join the flight of the previous one
+    time.sleep(0.01)
+    work.write("hot", changed)
+    before = server.stats()
+    contents = receive_at_once(server, hot, ["gzip"] * 4)
+    check(contents == [changed] * 4 and flights(server, before)["leaders"] >= 1, "changed file leads a new flight")
+
+  finally:
+    server.end()
+    work.remove()
+
+  qfttest.finish()
+
+if __name__ == "__main__":
+  main()
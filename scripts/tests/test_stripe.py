@@ -0,0 +1,113 @@
+#
+# Checks striped transfers: the commit refused unless the ranges written
+# cover the whole file, overlapping ranges, ranges outside the file, and
+# clsend_striped leaving nothing behind, a retry reusing the same stripe.
+#
+
+import os
+import zlib
+
+import qfttest
+from qfttest import quickftpy, check, logger, v2_message, v2_param, v2_read, ADDR, TIMEOUT, TIMEOUT_ACK
+from qfttest import FILE_SND_B, ACK_B, V2_FLAG_RAW, TAG_PATH, TAG_STRIPE, TAG_SIZE, TAG_OFFSET, TAG_LENGTH, TAG_RESULT
+
+RESULT_INVALID_REQUEST = -103
+RESULT_FILE_NOT_FOUND = -106
+RESULT_FILE_WRITE_ERROR = -107
+
+#
+# Sends a range of a striped transfer uncompressed, returns its result
+#
+def send_range(server, path, stripe, content, offset, length):
+  s = qfttest.connect(server.port)
+  try:
+    s.sendall(v2_message(FILE_SND_B, V2_FLAG_RAW, v2_param(TAG_PATH, path) + v2_param(TAG_STRIPE, stripe) + v2_param(TAG_SIZE, len(content)) +
+                                                  v2_param(TAG_OFFSET, offset) + v2_param(TAG_LENGTH, length)))
+    message_type, flags, params = v2_read(s)
+    if message_type == ACK_B:
+      s.sendall(content[offset:offset + length])
+      message_type, flags, params = v2_read(s)
+    return params[TAG_RESULT]
+  finally:
+    s.close()
+
+#
+# Commits a striped transfer, returns its result
+#
+def commit(server, path, stripe, size):
+  s = qfttest.connect(server.port)
+  try:
+    s.sendall(v2_message(FILE_SND_B, 0, v2_param(TAG_PATH, path) + v2_param(TAG_STRIPE, stripe) + v2_param(TAG_SIZE, size)))
+    message_type, flags, params = v2_read(s)
+    return params[TAG_RESULT]
+  finally:
+    s.close()
+
+#
+# Key the module names the stripe of a content after
+#
+def stripe_of(content):
+  content_hash = ( ( zlib.crc32(content) & 0xFFFFFFFF ) << 32 ) | ( zlib.adler32(content) & 0xFFFFFFFF )
+  return "%x-%x" % (len(content), content_hash)
+
+def leftovers(work):
+  return [name for name in os.listdir(work.path) if name.endswith(".stripe") or name.endswith(".ranges")]
+
+def main():
+
+  work = qfttest.WorkDir()
+  content = qfttest.text(1 << 20)
+  half = len(content) // 2
+  target = work.join("target")
+
+  server = qfttest.Server()
+
+  try:
+
+    # Half the ranges written, the commit is refused and the target left alone
+    check(send_range(server, target, "s1", content, 0, half) == 0, "first range written")
+    check(commit(server, target, "s1", len(content)) == RESULT_FILE_WRITE_ERROR, "commit with a range missing refused")
+    check(work.read("target") is None and len(leftovers(work)) == 2, "target untouched, stripe and its ranges kept")
+
+    check(send_range(server, target, "s1", content, half, len(content) - half) == 0, "second range written")
+    check(commit(server, target, "s1", len(content) + 1) == RESULT_FILE_WRITE_ERROR, "commit with another size refused")
+    check(commit(server, target, "s1", len(content)) == 0 and work.read("target") == content, "commit once the ranges cover the file")
+    check(leftovers(work) == [], "stripe and its ranges removed by the commit")
+
+    # Overlapping ranges, as a retry writes, still cover the file
+    check(send_range(server, target, "s2", content, 0, 600000) == 0 and send_range(server, target, "s2", content, 400000, len(content) - 400000) == 0 and
+          send_range(server, target, "s2", content, 100, 1000) == 0, "overlapping ranges written")
+    check(commit(server, target, "s2", len(content)) == 0 and work.read("target") == content, "commit of overlapping ranges")
+
+    # A gap between the ranges is noticed whatever the order they came in
+    check(send_range(server, target, "s3", content, half + 10, len(content) - half - 10) == 0 and send_range(server, target, "s3", content, 0, half) == 0,
+          "ranges with a gap written")
+    check(commit(server, target, "s3", len(content)) == RESULT_FILE_WRITE_ERROR, "commit with a gap of 10 bytes refused")
+
+    check(send_range(server, target, "s4", content, half, len(content)) == RESULT_INVALID_REQUEST, "range past the end of the file refused")
+    check(send_range(server, target, "s4", content, -1, 10) == RESULT_INVALID_REQUEST, "range at a negative offset refused")
+    check(commit(server, target, "unknown", len(content)) == RESULT_FILE_NOT_FOUND, "commit of an unknown stripe")
+
+    # clsend_striped leaves nothing behind
+    for name in os.listdir(work.path):
+      os.unlink(work.join(name))
+    big = qfttest.text(5 << 20, 1)
+    local = work.write("local", big)
+    for raw, codec in ((1, "gzip"), (0, "zstd")):
+      result = quickftpy.clsend_striped(target, local, ADDR, server.sport, TIMEOUT, TIMEOUT_ACK, logger, 4, 1 << 20, raw, codec)
+      check(result == 0 and work.read("target") == big and leftovers(work) == [], "clsend_striped of 4 stripes, %s" % codec)
+
+    # A retry writes into the stripe a failed attempt left, named after the content
+    os.unlink(target)
+    check(send_range(server, target, stripe_of(big), big, 0, 1 << 20) == 0 and len(leftovers(work)) == 2, "failed attempt left its stripe")
+    result = quickftpy.clsend_striped(target, local, ADDR, server.sport, TIMEOUT, TIMEOUT_ACK, logger, 3)
+    check(result == 0 and work.read("target") == big and leftovers(work) == [], "retry completes the same stripe")
+
+  finally:
+    server.end()
+    work.remove()
+
+  qfttest.finish()
+
+if __name__ == "__main__":
+  main()
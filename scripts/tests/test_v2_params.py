@@ -0,0 +1,106 @@
+#
+# Checks how the server parses the header and the TLV parameters of V2
+# requests, well formed or not, and that it goes on serving afterwards.
+#
+
+import socket
+import struct
+
+import qfttest
+from qfttest import check, v2_message, v2_param, v2_read
+from qfttest import FILE_RCV_B, FILE_DEL_B, ACK_B, V2_FLAG_RAW, TAG_FILENAME, TAG_RESULT, TAG_SIZE
+
+RESULT_INVALID_REQUEST = -103
+RESULT_FILE_NOT_FOUND = -106
+
+#
+# Sends a request and tells whether the server closed the connection
+# without answering it
+#
+def dropped(server, message):
+  s = qfttest.connect(server.port)
+  s.settimeout(5)
+  try:
+    s.sendall(message)
+    return s.recv(65536) == ""
+  except socket.timeout:
+    return False
+  except socket.error:
+    return True
+  finally:
+    s.close()
+
+#
+# Receives a file uncompressed, returning the result and the content,
+# the response following the ACK unless the request failed at once
+#
+def receive(server, params):
+  s = qfttest.connect(server.port)
+  try:
+    s.sendall(v2_message(FILE_RCV_B, V2_FLAG_RAW, params))
+    message_type, flags, answer = v2_read(s)
+    if message_type == ACK_B:
+      message_type, flags, answer = v2_read(s)
+    content = None
+    if answer[TAG_RESULT] == 0:
+      content = qfttest.recv_exact(s, qfttest.v2_number(answer, TAG_SIZE))
+    return answer[TAG_RESULT], content
+  finally:
+    s.close()
+
+def main():
+
+  work = qfttest.WorkDir()
+  server = qfttest.Server()
+  content = qfttest.text(100000)
+  remote = work.write("remote.txt", content)
+
+  try:
+
+    result, received = receive(server, v2_param(TAG_FILENAME, remote))
+    check(result == 0 and received == content, "well formed request")
+
+    result, received = receive(server, v2_param(0x7F, "unknown") + v2_param(TAG_FILENAME, remote) + v2_param(0x7E, ""))
+    check(result == 0 and received == content, "unknown parameters are skipped")
+
+    result, received = receive(server, v2_param(TAG_FILENAME, remote + ".missing"))
+    check(result == RESULT_FILE_NOT_FOUND, "missing file is answered with its result")
+
+    # Parameters the server cannot find its filename in
+    result, received = receive(server, v2_param(0x7F, "no filename"))
+    check(result == RESULT_INVALID_REQUEST, "request without a filename is invalid")
+
+    params = v2_param(0x7F, "x") + chr(TAG_FILENAME) + struct.pack(">H", len(remote) + 10) + remote
+    result, received = receive(server, params)
+    check(result == RESULT_INVALID_REQUEST, "value running past the parameters is invalid")
+
+    result, received = receive(server, v2_param(0x7F, "x") + chr(TAG_FILENAME) + "\x00")
+    check(result == RESULT_INVALID_REQUEST, "truncated parameter header is invalid")
+
+    # Headers the server cannot trust are dropped without an answer
+    check(dropped(server, v2_message(FILE_RCV_B, V2_FLAG_RAW, "", params_len=0)), "request without parameters is dropped")
+    check(dropped(server, v2_message(FILE_RCV_B, V2_FLAG_RAW, "", params_len=0xFFFFFFFF)), "parameters of 4 GB are dropped")
+    check(dropped(server, v2_message(FILE_RCV_B | FILE_DEL_B, 0, v2_param(TAG_FILENAME, remote))), "two message codes are dropped")
+    check(dropped(server, v2_message(0x10, 0, v2_param(TAG_FILENAME, remote))), "unknown message code is dropped")
+    check(dropped(server, "QUIFT_MSG=V3.0=" + "\0" * 17), "unknown version is dropped")
+
+    # Parameters cut short by the client going away
+    s = qfttest.connect(server.port)
+    s.sendall(v2_message(FILE_DEL_B, 0, v2_param(TAG_FILENAME, remote))[:40])
+    s.close()
+    check(work.read("remote.txt") == content, "cut request does nothing")
+
+    result, received = receive(server, v2_param(TAG_FILENAME, remote))
+    check(result == 0 and received == content, "server still serves afterwards")
+
+    stats = server.settle(lambda stats: stats["active_requests"] == 0)
+    check(stats["active_requests"] == 0, "no request left active")
+
+  finally:
+    server.end()
+    work.remove()
+
+  qfttest.finish()
+
+if __name__ == "__main__":
+  main()
@@ -0,0 +1,61 @@
+#
+# Checks that requests are served by the fixed pool of workers, the server
+# starting no thread per connection, and that its counters add up.
+#
+
+import os
+import time
+
+import qfttest
+from qfttest import check, ADDR, TIMEOUT, TIMEOUT_ACK
+
+CLIENT_CODE = r'''
+failed = 0
+for i in range(%(rounds)d):
+  if quickftpy.clrecv(%(remote)r, %(local)r, %(addr)r, %(port)r, %(timeout)d, %(timeout_ack)d, logger) != 0:
+    failed += 1
+sys.exit(failed)
+'''
+
+def threads(pid):
+  return len(os.listdir("/proc/%d/task" % pid))
+
+def main():
+
+  work = qfttest.WorkDir()
+  server = qfttest.Server(workers=3)
+  remote = work.write("remote.txt", qfttest.text(300000))
+
+  try:
+
+    stats = server.stats()
+    check(stats["workers"] == 3, "pool has the 3 workers asked for")
+
+    idle_threads = threads(server.process.pid)
+
+    clients = []
+    for i in range(6):
+      code = CLIENT_CODE % { "rounds": 5, "remote": remote, "local": work.join("c%d.txt" % i),
+                             "addr": ADDR, "port": server.sport, "timeout": TIMEOUT, "timeout_ack": TIMEOUT_ACK }
+      clients.append(qfttest.spawn(code))
+
+    busy_threads = idle_threads
+    while [c for c in clients if c.poll() is None]:
+      busy_threads = max(busy_threads, threads(server.process.pid))
+      time.sleep(0.01)
+
+    check(sum(c.returncode for c in clients) == 0, "6 concurrent clients of 5 transfers each")
+    check(busy_threads == idle_threads, "no thread started per connection (%d threads idle, %d busy)" % (idle_threads, busy_threads))
+
+    stats = server.settle(lambda stats: stats["tasks_completed"] >= 30 and stats["busy_workers"] == 0 and stats["queue_depth"] == 0)
+    check(stats["tasks_completed"] >= 30, "pool completed the 30 requests")
+    check(stats["busy_workers"] == 0 and stats["queue_depth"] == 0, "pool is idle afterwards")
+
+  finally:
+    server.end()
+    work.remove()
+
+  qfttest.finish()
+
+if __name__ == "__main__":
+  main()
@@ -0,0 +1,57 @@
+#
+# Checks uncompressed transfers, which the server sends with sendfile and
+# receives with splice, at lengths around the page and pipe sizes and
+# with several clients at once.
+#
+
+import qfttest
+from qfttest import quickftpy, check, logger, ADDR, TIMEOUT, TIMEOUT_ACK
+
+LENGTHS = (1, 4095, 4096, 4097, 65535, 65536, 65537, ( 1 << 20 ) + 1, 17 << 20)
+
+CLIENT_CODE = r'''
+failed = 0
+for i in range(3):
+  if quickftpy.clrecv(%(remote)r, %(local)r, %(addr)r, %(port)r, %(timeout)d, %(timeout_ack)d, logger, 0, 1) != 0:
+    failed += 1
+  elif open(%(local)r, "rb").read() != open(%(remote)r, "rb").read():
+    failed += 1
+sys.exit(failed)
+'''
+
+def main():
+
+  work = qfttest.WorkDir()
+  server = qfttest.Server()
+
+  try:
+
+    for length in LENGTHS:
+
+      content = qfttest.noise(length)
+      local = work.write("local-%d" % length, content)
+
+      remote = work.join("sent-%d" % length)
+      result = quickftpy.clsend(remote, local, ADDR, server.sport, TIMEOUT, TIMEOUT_ACK, logger, 1)
+      check(result == 0 and work.read("sent-%d" % length) == content, "raw send of %d bytes" % length)
+
+      copy = work.join("received-%d" % length)
+      result = quickftpy.clrecv(remote, copy, ADDR, server.sport, TIMEOUT, TIMEOUT_ACK, logger, 0, 1)
+      check(result == 0 and work.read("received-%d" % length) == content, "raw receive of %d bytes" % length)
+
+    remote = work.join("sent-%d" % LENGTHS[-1])
+    clients = []
+    for i in range(6):
+      code = CLIENT_CODE % { "remote": remote, "local": work.join("c%d" % i), "addr": ADDR, "port": server.sport,
+                             "timeout": TIMEOUT, "timeout_ack": TIMEOUT_ACK }
+      clients.append(qfttest.spawn(code))
+    check(sum(c.wait() for c in clients) == 0, "6 concurrent clients of 3 raw receives each")
+
+  finally:
+    server.end()
+    work.remove()
+
+  qfttest.finish()
+
+if __name__ == "__main__":
+  main()